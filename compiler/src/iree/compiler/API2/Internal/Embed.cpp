@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <atomic>
 
 #include "iree/compiler/Dialect/VM/Target/init_targets.h"
@@ -22,6 +23,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "mlir/IR/AsmState.h"
 #include "mlir/IR/Diagnostics.h"
@@ -104,7 +107,18 @@ GlobalInit::GlobalInit(bool initializeCommandLine)
 struct Session {
   Session(GlobalInit &globalInit);
 
+  // Applies halTargetOptions.executableCompilationThreads to the context
+  // thread pool. Called by each invocation before running so that changes to
+  // the options made after the session was created take effect.
+  void updateThreadPool();
+
   GlobalInit &globalInit;
+  // Thread pool used by the context when bounded by
+  // executableCompilationThreads; must outlive the context.
+  std::unique_ptr<llvm::ThreadPool> threadPool;
+  // Thread count threadPool was created with or 0 if the context is using its
+  // own default pool.
+  int threadPoolSize = 0;
   MLIRContext context;
   BindingOptions bindingOptions;
   InputDialectOptions inputOptions;
@@ -138,6 +152,28 @@ Session::Session(GlobalInit &globalInit) : globalInit(globalInit) {
   }
 }
 
+void Session::updateThreadPool() {
+  int threadCount = std::max(0, halTargetOptions.executableCompilationThreads);
+  if (threadCount == threadPoolSize) return;
+  // Leave the context alone if threading was disabled with
+  // --mlir-disable-threading.
+  if (!context.isMultithreadingEnabled()) return;
+
+  // Executables are translated and serialized in parallel on the context
+  // thread pool, which defaults to one thread per hardware thread. Swap in a
+  // bounded pool when requested so that large models don't oversubscribe the
+  // host (each executable holds its own LLVMContext and target machine). Once
+  // a pool has been provided the context will not recreate its own, so going
+  // back to unbounded also requires a new pool.
+  auto newThreadPool = std::make_unique<llvm::ThreadPool>(
+      threadCount > 0 ? llvm::hardware_concurrency(threadCount)
+                      : llvm::hardware_concurrency());
+  context.disableMultithreading();
+  context.setThreadPool(*newThreadPool);
+  threadPool = std::move(newThreadPool);
+  threadPoolSize = threadCount;
+}
+
 struct Source {
   Source(Session &session) : session(session) {}
 
@@ -299,6 +335,7 @@ bool Invocation::parseSource(Source &source) {
 }
 
 bool Invocation::runPipeline(enum iree_compiler_pipeline_t pipeline) {
+  session.updateThreadPool();
   switch (pipeline) {
     case IREE_COMPILER_PIPELINE_STD: {
       // Parse the compile to phase name.
@@ -7,12 +7,19 @@
 #include "iree/compiler/Bindings/Native/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Affine/Utils.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OperationSupport.h"
 #include "mlir/IR/SymbolTable.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassRegistry.h"
@@ -295,6 +302,165 @@ static void populateReflectionAttrs(IREE::ABI::InvocationModel invocationModel,
   }
 }
 
+// Returns true if |exportOp| has been marked as a pure function whose results
+// may be memoized based on the contents of its arguments.
+static bool isMemoizedExport(func::FuncOp exportOp) {
+  return exportOp->hasAttr("iree.abi.memoize");
+}
+
+// Verifies that |exportOp| can have its results memoized by the runtime.
+// The runtime result cache hashes the contents of buffer views and retains
+// buffer views as results so only tensors are supported today.
+static LogicalResult verifyMemoizedExport(
+    IREE::ABI::InvocationModel invocationModel, func::FuncOp exportOp) {
+  if (invocationModel != IREE::ABI::InvocationModel::Sync) {
+    return exportOp.emitError()
+           << "memoized functions must use the synchronous invocation model";
+  }
+  auto exportType = exportOp.getFunctionType();
+  if (exportType.getNumResults() == 0) {
+    return exportOp.emitError() << "memoized functions must return results";
+  }
+  auto isTensor = [](Type type) { return type.isa<TensorType>(); };
+  if (!llvm::all_of(exportType.getInputs(), isTensor) ||
+      !llvm::all_of(exportType.getResults(), isTensor)) {
+    return exportOp.emitError()
+           << "memoized functions must only take and return tensors";
+  }
+  return success();
+}
+
+// Computes a 64-bit FNV-1a hash and sends the data into the void.
+class null_fnv1a_ostream : public llvm::raw_ostream {
+ public:
+  explicit null_fnv1a_ostream(uint64_t &hash) : hash(hash) {
+    SetUnbuffered();
+  }
+
+ private:
+  void write_impl(const char *Ptr, size_t Size) override {
+    for (size_t i = 0; i < Size; ++i) {
+      hash = (hash ^ static_cast<uint8_t>(Ptr[i])) * 0x100000001B3ull;
+    }
+    pos += Size;
+  }
+  uint64_t current_pos() const override { return pos; }
+  uint64_t &hash;
+  uint64_t pos = 0;
+};
+
+// Returns a fingerprint of the program computing the results of |exportOp|.
+// This covers the function and all symbols it transitively references (callees,
+// globals, executables, etc) so that a runtime result cache shared across
+// compilations never returns results computed by a different program.
+static uint64_t computeProgramFingerprint(func::FuncOp exportOp) {
+  llvm::SetVector<Operation *> symbolOps;
+  symbolOps.insert(exportOp);
+  for (size_t i = 0; i < symbolOps.size(); ++i) {
+    auto symbolUses = SymbolTable::getSymbolUses(symbolOps[i]);
+    if (!symbolUses) continue;
+    for (auto &symbolUse : *symbolUses) {
+      auto rootRef = FlatSymbolRefAttr::get(
+          symbolUse.getSymbolRef().getRootReference());
+      if (auto *symbolOp =
+              SymbolTable::lookupNearestSymbolFrom(exportOp, rootRef)) {
+        symbolOps.insert(symbolOp);
+      }
+    }
+  }
+  uint64_t hash = 0xCBF29CE484222325ull;
+  null_fnv1a_ostream os(hash);
+  for (auto *symbolOp : symbolOps) {
+    symbolOp->print(os, OpPrintingFlags().useLocalScope());
+  }
+  return hash;
+}
+
+// Returns the key used to identify the memoized |exportOp| exported as
+// |publicName| in the runtime result cache. The cache is shared by all modules
+// using the same HAL module so the key is qualified by the parent module name
+// when available and by a fingerprint of the program computing the results.
+static StringAttr getResultCacheKey(func::FuncOp exportOp,
+                                    StringRef publicName) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  auto moduleOp = exportOp->getParentOfType<mlir::ModuleOp>();
+  if (moduleOp && moduleOp.getName()) {
+    os << moduleOp.getName().value() << ".";
+  }
+  os << publicName << "@"
+     << llvm::format_hex_no_prefix(computeProgramFingerprint(exportOp), 16);
+  return StringAttr::get(exportOp.getContext(), os.str());
+}
+
+// State carried from a result cache lookup to the insertion on a miss.
+struct ResultCacheLookup {
+  // Empty list that the computed results should be inserted into.
+  Value resultList;
+  // Token holding the hashed operand key, or null if not cacheable.
+  Value keyToken;
+};
+
+// Looks up the results of the memoized |wrapperOp| in the runtime result cache
+// and returns them directly on a hit. |builder| will be positioned in the
+// block that computes the results on a miss.
+static ResultCacheLookup buildResultCacheLookup(func::FuncOp wrapperOp,
+                                                StringAttr key,
+                                                OpBuilder &builder) {
+  auto loc = wrapperOp.getLoc();
+  auto *entryBlock = &wrapperOp.front();
+  auto bufferViewType = builder.getType<IREE::HAL::BufferViewType>();
+  auto listType = IREE::Util::ListType::get(bufferViewType);
+  auto lookupOp = builder.create<IREE::HAL::ExResultCacheLookupOp>(
+      loc, listType, builder.getType<IREE::Util::BufferType>(), key,
+      entryBlock->getArguments());
+  auto resultList = lookupOp.getResultList();
+  auto listSize = builder.create<IREE::Util::ListSizeOp>(
+      loc, builder.getIndexType(), resultList);
+  // Entries with a different result count can only come from a different
+  // program sharing the key and are treated as misses.
+  unsigned resultCount = wrapperOp.getFunctionType().getNumResults();
+  auto expectedSize = builder.create<arith::ConstantIndexOp>(loc, resultCount);
+  auto isHit = builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                             listSize, expectedSize);
+
+  auto *hitBlock = wrapperOp.addBlock();
+  auto *missBlock = wrapperOp.addBlock();
+  builder.create<cf::CondBranchOp>(loc, isHit, hitBlock, ValueRange{},
+                                   missBlock, ValueRange{});
+
+  // Hit: return the cached results as-is.
+  builder.setInsertionPointToStart(hitBlock);
+  SmallVector<Value> cachedResults;
+  for (unsigned i = 0; i < resultCount; ++i) {
+    auto index = builder.create<arith::ConstantIndexOp>(loc, i);
+    cachedResults.push_back(builder.create<IREE::Util::ListGetOp>(
+        loc, bufferViewType, resultList, index));
+  }
+  builder.create<func::ReturnOp>(loc, cachedResults);
+
+  builder.setInsertionPointToStart(missBlock);
+  return {resultList, lookupOp.getKeyToken()};
+}
+
+// Inserts the computed |results| of the memoized |wrapperOp| into the runtime
+// result cache using the state returned from the |lookup| that missed.
+static void buildResultCacheInsert(func::FuncOp wrapperOp,
+                                   const ResultCacheLookup &lookup,
+                                   ValueRange results, OpBuilder &builder) {
+  auto loc = wrapperOp.getLoc();
+  auto resultList = lookup.resultList;
+  auto resultCount =
+      builder.create<arith::ConstantIndexOp>(loc, results.size());
+  builder.create<IREE::Util::ListResizeOp>(loc, resultList, resultCount);
+  for (auto [i, result] : llvm::enumerate(results)) {
+    auto index = builder.create<arith::ConstantIndexOp>(loc, i);
+    builder.create<IREE::Util::ListSetOp>(loc, resultList, index, result);
+  }
+  builder.create<IREE::HAL::ExResultCacheInsertOp>(loc, lookup.keyToken,
+                                                  resultList);
+}
+
 // Creates the corresponding wrapper function for the given export function.
 static func::FuncOp createExportWrapperFunc(
     IREE::ABI::InvocationModel invocationModel, func::FuncOp exportOp,
@@ -350,6 +516,15 @@ static func::FuncOp createExportWrapperFunc(
   auto *entryBlock = wrapperOp.addEntryBlock();
   auto entryBuilder = OpBuilder::atBlockBegin(entryBlock);
 
+  // Memoized functions first check the runtime result cache and only compute
+  // their results on a miss.
+  ResultCacheLookup resultCacheLookup;
+  if (isMemoizedExport(exportOp)) {
+    if (failed(verifyMemoizedExport(invocationModel, exportOp))) return {};
+    resultCacheLookup = buildResultCacheLookup(
+        wrapperOp, getResultCacheKey(exportOp, publicName), entryBuilder);
+  }
+
   // Build a map of result value to the argument that has its backing storage.
   SmallVector<Value> resultStorages;
   resultStorages.resize(resultTypes.size());
@@ -441,6 +616,10 @@ static func::FuncOp createExportWrapperFunc(
     }
   }
 
+  if (resultCacheLookup.resultList) {
+    buildResultCacheInsert(wrapperOp, resultCacheLookup, results, entryBuilder);
+  }
+
   entryBuilder.create<func::ReturnOp>(exportOp.getLoc(), results);
   return wrapperOp;
 }
@@ -491,7 +670,8 @@ class WrapEntryPointsPass
 
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<func::FuncDialect, mlir::arith::ArithDialect,
-                    mlir::tensor::TensorDialect, IREE::HAL::HALDialect>();
+                    mlir::cf::ControlFlowDialect, mlir::tensor::TensorDialect,
+                    IREE::HAL::HALDialect, IREE::Util::UtilDialect>();
   }
 
   StringRef getArgument() const override {
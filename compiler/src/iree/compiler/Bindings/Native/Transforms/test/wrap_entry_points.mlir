@@ -110,3 +110,70 @@ func.func private @caller(%arg0: tensor<?x2xi32>) -> tensor<2x?xi32> {
   %0 = call @import(%arg0) : (tensor<?x2xi32>) -> tensor<2x?xi32>
   return %0 : tensor<2x?xi32>
 }
+
+// -----
+
+// Functions marked as memoized consult the runtime result cache and only
+// compute (and insert) their results on a miss.
+
+// CHECK-LABEL: func.func @memoizedEntry(
+//  CHECK-SAME:   %[[ARG0:.+]]: !hal.buffer_view
+//  CHECK-SAME: -> !hal.buffer_view
+//       CHECK:   %[[LIST:.+]], %[[TOKEN:.+]] = hal.ex.result_cache.lookup key("memoizedEntry@{{[0-9a-f]{16}}}") operands(%[[ARG0]] : !hal.buffer_view) : !util.list<!hal.buffer_view>, !util.buffer
+//  CHECK-NEXT:   %[[SIZE:.+]] = util.list.size %[[LIST]]
+//       CHECK:   %[[COUNT:.+]] = arith.constant 1 : index
+//  CHECK-NEXT:   %[[HIT:.+]] = arith.cmpi eq, %[[SIZE]], %[[COUNT]]
+//  CHECK-NEXT:   cf.cond_br %[[HIT]], ^bb1, ^bb2
+//  CHECK-NEXT: ^bb1:
+//       CHECK:   %[[CACHED:.+]] = util.list.get %[[LIST]]
+//  CHECK-NEXT:   return %[[CACHED]] : !hal.buffer_view
+//  CHECK-NEXT: ^bb2:
+//  CHECK-NEXT:   %[[ARG0_TENSOR:.+]] = hal.tensor.import %[[ARG0]] : !hal.buffer_view -> tensor<4xf32>
+//  CHECK-NEXT:   %[[RET_TENSOR:.+]] = call @_memoizedEntry(%[[ARG0_TENSOR]])
+//  CHECK-NEXT:   %[[RET_VIEW:.+]] = hal.tensor.export %[[RET_TENSOR]] : tensor<4xf32> -> !hal.buffer_view
+//       CHECK:   util.list.resize %[[LIST]]
+//       CHECK:   util.list.set %[[LIST]][%{{.+}}], %[[RET_VIEW]]
+//  CHECK-NEXT:   hal.ex.result_cache.insert token(%[[TOKEN]] : !util.buffer) results(%[[LIST]] : !util.list<!hal.buffer_view>)
+//  CHECK-NEXT:   return %[[RET_VIEW]] : !hal.buffer_view
+
+// CHECK-LABEL: func.func private @_memoizedEntry(
+func.func @memoizedEntry(%arg0: tensor<4xf32>) -> tensor<4xf32> attributes {
+  iree.abi.memoize
+} {
+  %0 = arith.mulf %arg0, %arg0 : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+
+// -----
+
+// Result cache keys include a fingerprint of the program computing the results
+// so that changing a callee changes the key.
+
+// CHECK-LABEL: func.func @memoizedCaller(
+//       CHECK:   hal.ex.result_cache.lookup key("memoizedCaller@[[FINGERPRINT:[0-9a-f]{16}]]")
+func.func @memoizedCaller(%arg0: tensor<4xf32>) -> tensor<4xf32> attributes {
+  iree.abi.memoize
+} {
+  %0 = call @callee(%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+func.func private @callee(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = arith.mulf %arg0, %arg0 : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @memoizedCaller(
+//   CHECK-NOT:   key("memoizedCaller@[[FINGERPRINT]]")
+//       CHECK:   hal.ex.result_cache.lookup key("memoizedCaller@{{[0-9a-f]{16}}}")
+func.func @memoizedCaller(%arg0: tensor<4xf32>) -> tensor<4xf32> attributes {
+  iree.abi.memoize
+} {
+  %0 = call @callee(%arg0) : (tensor<4xf32>) -> tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
+func.func private @callee(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  %0 = arith.addf %arg0, %arg0 : tensor<4xf32>
+  return %0 : tensor<4xf32>
+}
@@ -16,6 +16,10 @@ namespace iree_compiler {
 
 namespace {
 
+static bool isLLVMCPUTarget(IREE::HAL::ExecutableTargetAttr targetAttr) {
+  return targetAttr.getBackend().getValue() == "llvm-cpu";
+}
+
 struct LLVMCPULinkExecutablesPass
     : public LLVMCPULinkExecutablesBase<LLVMCPULinkExecutablesPass> {
   LLVMCPULinkExecutablesPass() = default;
@@ -23,8 +27,18 @@ struct LLVMCPULinkExecutablesPass
     auto moduleOp = getOperation();
     auto moduleBuilder = OpBuilder::atBlockBegin(moduleOp.getBody());
 
-    auto sourceExecutableOps =
-        llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
+    // Only executables with llvm-cpu variants are linked here; other backends
+    // link their own variants.
+    SmallVector<IREE::HAL::ExecutableOp> sourceExecutableOps;
+    for (auto executableOp : moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+      if (llvm::any_of(
+              executableOp.getOps<IREE::HAL::ExecutableVariantOp>(),
+              [](IREE::HAL::ExecutableVariantOp variantOp) {
+                return isLLVMCPUTarget(variantOp.getTarget());
+              })) {
+        sourceExecutableOps.push_back(executableOp);
+      }
+    }
     if (sourceExecutableOps.size() <= 1) return;
 
     // Guess a module name, if needed, to make the output files readable.
@@ -43,6 +57,8 @@ struct LLVMCPULinkExecutablesPass
     // Gather all unique executable targets - we may have multiple.
     auto executableTargetAttrs = gatherExecutableTargets(sourceExecutableOps);
     for (auto executableTargetAttr : executableTargetAttrs) {
+      if (!isLLVMCPUTarget(executableTargetAttr)) continue;
+
       // Add our hal.executable.variant with an empty module.
       auto linkedTargetOp =
           executableBuilder.create<IREE::HAL::ExecutableVariantOp>(
@@ -0,0 +1,115 @@
+// RUN: iree-opt --split-input-file --iree-llvmcpu-link-executables %s | FileCheck %s
+
+#executable_target = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64">
+#pipeline_layout = #hal.pipeline.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+
+hal.executable private @dispatch_0 {
+  hal.executable.variant @x86_64, target = #executable_target {
+    hal.executable.export @dispatch_0 ordinal(0) layout(#pipeline_layout)
+    builtin.module {
+      llvm.mlir.global private constant @__constant_a(dense<[1, 2]> : tensor<2xi32>) : !llvm.array<2 x i32>
+      llvm.mlir.global private constant @__constant_b(dense<[3, 4]> : tensor<2xi32>) : !llvm.array<2 x i32>
+      llvm.func @expf(f32) -> f32
+      llvm.func @dispatch_0() {
+        %0 = llvm.mlir.addressof @__constant_a : !llvm.ptr<array<2 x i32>>
+        %1 = llvm.mlir.addressof @__constant_b : !llvm.ptr<array<2 x i32>>
+        llvm.return
+      }
+    }
+  }
+}
+hal.executable private @dispatch_1 {
+  hal.executable.variant @x86_64, target = #executable_target {
+    hal.executable.export @dispatch_1 ordinal(0) layout(#pipeline_layout)
+    builtin.module {
+      // Same contents as @__constant_a but a different name: folded.
+      llvm.mlir.global private constant @__constant_c(dense<[1, 2]> : tensor<2xi32>) : !llvm.array<2 x i32>
+      // Same name as @__constant_b but different contents: renamed.
+      llvm.mlir.global private constant @__constant_b(dense<[5, 6]> : tensor<2xi32>) : !llvm.array<2 x i32>
+      // Identical external declaration: shared.
+      llvm.func @expf(f32) -> f32
+      llvm.func @dispatch_1() {
+        %0 = llvm.mlir.addressof @__constant_c : !llvm.ptr<array<2 x i32>>
+        %1 = llvm.mlir.addressof @__constant_b : !llvm.ptr<array<2 x i32>>
+        llvm.return
+      }
+    }
+  }
+}
+func.func @basic_linking() -> () {
+  %device = hal.ex.shared_device : !hal.device
+  %cmd = hal.command_buffer.create device(%device : !hal.device) mode("OneShot") categories("Transfer|Dispatch") : !hal.command_buffer
+  %c1 = arith.constant 1 : index
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_0::@x86_64::@dispatch_0) workgroups([%c1, %c1, %c1])
+  hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@dispatch_1::@x86_64::@dispatch_1) workgroups([%c1, %c1, %c1])
+  return
+}
+
+// All executables should be linked into a single executable with one export
+// table. Duplicate constants and declarations are shared.
+//
+// CHECK-NOT: hal.executable private @dispatch_0
+// CHECK-NOT: hal.executable private @dispatch_1
+// CHECK:       hal.executable private @link_executables_linked_llvm_cpu {
+// CHECK:         hal.executable.variant public @embedded_elf_x86_64
+// CHECK:           hal.executable.export public @dispatch_0 ordinal(0)
+// CHECK:           hal.executable.export public @dispatch_1 ordinal(1)
+// CHECK:           module {
+// CHECK-NEXT:        llvm.mlir.global private constant @__constant_a(dense<[1, 2]>
+// CHECK-NEXT:        llvm.mlir.global private constant @__constant_b(dense<[3, 4]>
+// CHECK-NEXT:        llvm.func @expf(f32) -> f32
+// CHECK-NEXT:        llvm.func @dispatch_0()
+// CHECK-NEXT:          llvm.mlir.addressof @__constant_a
+// CHECK-NEXT:          llvm.mlir.addressof @__constant_b
+// CHECK:             llvm.mlir.global private constant @__constant_b_0(dense<[5, 6]>
+// CHECK-NEXT:        llvm.func @dispatch_1()
+// CHECK-NEXT:          llvm.mlir.addressof @__constant_a
+// CHECK-NEXT:          llvm.mlir.addressof @__constant_b_0
+//
+// CHECK:       func.func @basic_linking()
+// CHECK:         hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@link_executables_linked_llvm_cpu::@embedded_elf_x86_64::@dispatch_0)
+// CHECK-NEXT:    hal.command_buffer.dispatch.symbol<%cmd : !hal.command_buffer> target(@link_executables_linked_llvm_cpu::@embedded_elf_x86_64::@dispatch_1)
+
+// -----
+
+#vmvx_target = #hal.executable.target<"vmvx", "vmvx-bytecode-fb">
+#pipeline_layout = #hal.pipeline.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+// Executables for other backends are left for their own linking pipelines.
+// CHECK: hal.executable private @dispatch_0
+// CHECK: hal.executable private @dispatch_1
+hal.executable private @dispatch_0 {
+  hal.executable.variant @vmvx, target = #vmvx_target {
+    hal.executable.export @dispatch_0 ordinal(0) layout(#pipeline_layout)
+    builtin.module {
+      vm.module @module {
+        vm.func @dispatch_0() {
+          vm.return
+        }
+        vm.export @dispatch_0
+      }
+    }
+  }
+}
+hal.executable private @dispatch_1 {
+  hal.executable.variant @vmvx, target = #vmvx_target {
+    hal.executable.export @dispatch_1 ordinal(0) layout(#pipeline_layout)
+    builtin.module {
+      vm.module @module {
+        vm.func @dispatch_1() {
+          vm.return
+        }
+        vm.export @dispatch_1
+      }
+    }
+  }
+}
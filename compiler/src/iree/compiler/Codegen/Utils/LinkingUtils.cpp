@@ -8,6 +8,7 @@
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/IR/SymbolTable.h"
 
 namespace mlir {
@@ -26,6 +27,43 @@ SetVector<IREE::HAL::ExecutableTargetAttr> gatherExecutableTargets(
   return result;
 }
 
+// Returns the visibility of |op| as it pertains to linking.
+// LLVM dialect symbols are public as far as MLIR is concerned and use their
+// LLVM linkage to scope them instead: private and internal symbols are local to
+// the module they are defined in and can be renamed or folded like any other
+// private symbol.
+static SymbolTable::Visibility getLinkageVisibility(Operation *op) {
+  Optional<LLVM::Linkage> linkage;
+  if (auto globalOp = dyn_cast<LLVM::GlobalOp>(op)) {
+    linkage = globalOp.getLinkage();
+  } else if (auto funcOp = dyn_cast<LLVM::LLVMFuncOp>(op)) {
+    linkage = funcOp.getLinkage();
+  }
+  if (!linkage) return SymbolTable::getSymbolVisibility(op);
+  switch (*linkage) {
+    case LLVM::Linkage::Private:
+    case LLVM::Linkage::Internal:
+      return SymbolTable::Visibility::Private;
+    default:
+      return SymbolTable::Visibility::Public;
+  }
+}
+
+// Returns a key uniquely identifying the contents of |op| if it is a module-
+// local constant that can be shared with all other constants of the same key
+// regardless of its name. Returns nullptr if the op cannot be shared.
+static Attribute getSharedConstantKey(Operation *op) {
+  auto globalOp = dyn_cast<LLVM::GlobalOp>(op);
+  if (!globalOp || !globalOp.getConstant() ||
+      !globalOp.getInitializerRegion().empty() ||
+      getLinkageVisibility(op) != SymbolTable::Visibility::Private) {
+    return {};
+  }
+  NamedAttrList attrs(op->getAttrDictionary());
+  attrs.erase(SymbolTable::getSymbolAttrName());
+  return attrs.getDictionary(op->getContext());
+}
+
 // Renames |op| within |moduleOp| with a new name that is unique within both
 // |moduleOp| and |optionalSymbolTable| (if one is provided).
 static void renameWithDisambiguatedName(
@@ -58,6 +96,11 @@ static void renameWithDisambiguatedName(
 // Destructively merges |sourceModuleOp| into |targetModuleOp|.
 // |targetSymbolMap| is updated with the new symbols.
 //
+// Symbols that are identical to the symbol of the same name already in
+// |targetSymbolMap| (such as shared external declarations) are dropped.
+// Private constants with the same contents as one tracked in
+// |targetConstantMap| are replaced with that constant.
+//
 // If a private symbol in |sourceModuleOp| conflicts with another symbol
 // (public or private) tracked in |targetSymbolMap|, it will be renamed.
 //
@@ -65,7 +108,8 @@ static void renameWithDisambiguatedName(
 // symbol tracked in |targetSymbolMap|.
 static LogicalResult mergeModuleInto(
     Operation *sourceModuleOp, Operation *targetModuleOp,
-    DenseMap<StringRef, Operation *> &targetSymbolMap) {
+    DenseMap<StringRef, Operation *> &targetSymbolMap,
+    DenseMap<Attribute, Operation *> &targetConstantMap) {
   auto &sourceBlock = sourceModuleOp->getRegion(0).front();
   auto &targetBlock = targetModuleOp->getRegion(0).front();
   SymbolTable sourceSymbolTable(sourceModuleOp);
@@ -77,25 +121,40 @@ static LogicalResult mergeModuleInto(
     if (auto symbolOp = dyn_cast<SymbolOpInterface>(op)) {
       auto symbolName = symbolOp.getName();
 
-      // Resolve symbol name conflicts.
-      if (auto targetOp = targetSymbolMap[symbolName]) {
-        if (symbolOp.getVisibility() == SymbolTable::Visibility::Private) {
-          // Private symbols can be safely folded into duplicates or renamed.
-          if (OperationEquivalence::isEquivalentTo(
-                  targetOp, op, OperationEquivalence::exactValueMatch,
-                  OperationEquivalence::exactValueMatch,
-                  OperationEquivalence::Flags::IgnoreLocations)) {
-            // Optimization: skip over duplicate private symbols.
-            // We could let CSE do this later, but we may as well check here.
+      // Fold constants with the same contents as one we've already linked.
+      // Uses are only redirected if the existing name doesn't refer to some
+      // other symbol in the source module.
+      auto constantKey = getSharedConstantKey(op);
+      if (constantKey) {
+        if (auto targetOp = targetConstantMap.lookup(constantKey)) {
+          auto targetName = SymbolTable::getSymbolName(targetOp);
+          if (targetName.getValue() == symbolName ||
+              (!sourceSymbolTable.lookup(targetName) &&
+               succeeded(SymbolTable::replaceAllSymbolUses(
+                   op, targetName, sourceModuleOp)))) {
             continue;
-          } else {
-            // Preserve the op but give it a unique name.
-            renameWithDisambiguatedName(op, sourceModuleOp, targetSymbolMap,
-                                        &sourceSymbolTable);
           }
+        }
+      }
+
+      // Resolve symbol name conflicts.
+      if (auto targetOp = targetSymbolMap[symbolName]) {
+        if (OperationEquivalence::isEquivalentTo(
+                targetOp, op, OperationEquivalence::exactValueMatch,
+                OperationEquivalence::exactValueMatch,
+                OperationEquivalence::Flags::IgnoreLocations)) {
+          // Optimization: skip over duplicate symbols. This covers private
+          // symbols that we could let CSE clean up later as well as external
+          // declarations (ukernels, libm, etc) shared by many executables.
+          continue;
+        } else if (getLinkageVisibility(op) ==
+                   SymbolTable::Visibility::Private) {
+          // Private symbols can be safely renamed.
+          renameWithDisambiguatedName(op, sourceModuleOp, targetSymbolMap,
+                                      &sourceSymbolTable);
         } else {
           // The source symbol has 'nested' or 'public' visibility.
-          if (SymbolTable::getSymbolVisibility(targetOp) !=
+          if (getLinkageVisibility(targetOp) !=
               SymbolTable::Visibility::Private) {
             // Oops! Both symbols are public and we can't safely rename either.
             // If you hit this with ops that you think are safe to rename, mark
@@ -116,6 +175,7 @@ static LogicalResult mergeModuleInto(
         }
       }
       targetSymbolMap[SymbolTable::getSymbolName(op).getValue()] = op;
+      if (constantKey) targetConstantMap.try_emplace(constantKey, op);
     }
     if (!targetBlock.empty() &&
         targetBlock.back().hasTrait<OpTrait::IsTerminator>()) {
@@ -190,6 +250,7 @@ LogicalResult linkExecutablesInto(
     OpBuilder &builder) {
   int nextEntryPointOrdinal = 0;
   DenseMap<StringRef, Operation *> targetSymbolMap;
+  DenseMap<Attribute, Operation *> targetConstantMap;
   SymbolReplacements symbolReplacements;
 
   auto linkedTargetBuilder =
@@ -263,7 +324,7 @@ LogicalResult linkExecutablesInto(
       // Merge the existing module into the new linked module op.
       auto sourceModuleOp = getInnerModuleFn(variantOp.getInnerModule());
       if (failed(mergeModuleInto(sourceModuleOp, linkedModuleOp,
-                                 targetSymbolMap))) {
+                                 targetSymbolMap, targetConstantMap))) {
         return failure();
       }
 
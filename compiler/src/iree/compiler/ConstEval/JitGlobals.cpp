@@ -4,29 +4,85 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <chrono>
+#include <limits>
+
 #include "iree/compiler/ConstEval/PassDetail.h"
 #include "iree/compiler/ConstEval/Passes.h"
 #include "iree/compiler/ConstEval/Runtime.h"
+#include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Pipelines/Pipelines.h"
 #include "iree/compiler/Utils/PassUtils.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/raw_sha1_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/Parser/Parser.h"
 
 #define DEBUG_TYPE "iree-const-eval"
+
+// Revision of the compiler embedded by the build. Cache entries are keyed by
+// it so that entries produced by other compiler revisions are not reused.
+#if !defined(IREE_RELEASE_REVISION)
+#define IREE_RELEASE_REVISION "HEAD"
+#endif  // !IREE_RELEASE_REVISION
 using llvm::dbgs;
 
+static llvm::cl::opt<std::string> clJitTargetBackend(
+    "iree-consteval-jit-target-backend",
+    llvm::cl::desc("Target backend used to compile and evaluate global "
+                   "initializers. `llvm-cpu` evaluates natively with the "
+                   "multi-threaded local-task driver and falls back to `vmvx` "
+                   "if it is not compiled in."),
+    llvm::cl::init("vmvx"));
+
+static llvm::cl::opt<std::string> clJitCacheDir(
+    "iree-consteval-jit-cache-dir",
+    llvm::cl::desc("Directory used to cache evaluated globals across compiler "
+                   "invocations keyed by a hash of the evaluated program, the "
+                   "target options, and the compiler revision. Builds without "
+                   "an IREE_RELEASE_REVISION share entries across revisions "
+                   "and should use a fresh directory after rebuilding."),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clJitDebug(
+    "iree-consteval-jit-debug",
+    llvm::cl::desc("Prints compilation and per-global evaluation timing to "
+                   "stderr."),
+    llvm::cl::init(false));
+
 namespace mlir {
 namespace iree_compiler {
 namespace ConstEval {
 
 namespace {
 
+using Clock = std::chrono::steady_clock;
+
+static double getMillisecondsSince(Clock::time_point startTime) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - startTime)
+      .count();
+}
+
+// Returns printing flags that never elide constants regardless of command line
+// flags as printed programs are hashed and printed values are parsed back.
+static OpPrintingFlags getLosslessPrintingFlags() {
+  return OpPrintingFlags()
+      .elideLargeElementsAttrs(std::numeric_limits<int64_t>::max())
+      .useLocalScope();
+}
+
 struct ProgramExtractor {
  public:
   ProgramExtractor(Operation *sourceModuleOp, Operation *targetModuleOp)
@@ -53,12 +109,23 @@ struct ProgramExtractor {
     return funcSymbolName;
   }
 
-  // Imports an op from the source module into the target. Cannot be used to
-  // import symbols.
-  void importOperation(Operation *sourceOp) {
-    Operation *targetOp = sourceOp->clone();
-    builder.insert(targetOp);
-    scanDependentSymbols(targetOp);
+  // Imports an initializer from the source module into the target as a public
+  // function with the given |name| so that it can be invoked (and timed)
+  // independently of the other initializers. Returns the created function.
+  func::FuncOp importInitializerAsFunc(IREE::Util::InitializerOp initializerOp,
+                                       StringRef name) {
+    auto clonedOp = cast<IREE::Util::InitializerOp>(initializerOp->clone());
+    auto funcOp = func::FuncOp::create(clonedOp.getLoc(), name,
+                                       builder.getFunctionType({}, {}));
+    funcOp.getBody().takeBody(clonedOp.getBody());
+    clonedOp->erase();
+    funcOp.walk([&](IREE::Util::InitializerReturnOp returnOp) {
+      OpBuilder(returnOp).create<func::ReturnOp>(returnOp.getLoc());
+      returnOp.erase();
+    });
+    targetSymbolTable.insert(funcOp);
+    scanDependentSymbols(funcOp);
+    return funcOp;
   }
 
   // Imports any dependencies. Should be called after all user-required imports
@@ -129,12 +196,122 @@ struct CompileOptions {
   IREEVMPipelineHooks hooks;
 };
 
+// Cache of evaluated globals stored in a directory across compiler
+// invocations. Each entry is a module of util.global ops with their evaluated
+// initial values named by the hash of the program that produced them.
+class GlobalCache {
+ public:
+  GlobalCache(StringRef cacheDir, StringRef targetBackend,
+              const CompileOptions &options, ModuleOp programOp) {
+    if (cacheDir.empty()) return;
+    // The program is printed without locations so that only changes to its
+    // semantics, the compiler, or the target configuration produce a new key.
+    // The default device target carries the backend configuration derived
+    // from flags (such as the llvm-cpu triple, CPU, and CPU features).
+    llvm::raw_sha1_ostream hashStream;
+    hashStream << "iree-consteval-v2:" << IREE_RELEASE_REVISION << ":"
+               << targetBackend << ":";
+    if (auto backend = IREE::HAL::getTargetBackend(targetBackend)) {
+      hashStream << backend->getDefaultDeviceTarget(programOp.getContext())
+                 << ":";
+    }
+    const auto &vmOptions = options.targetOptions;
+    hashStream << "index=" << vmOptions.indexBits
+               << ",f32=" << vmOptions.f32Extension
+               << ",f64=" << vmOptions.f64Extension
+               << ",truncate=" << vmOptions.truncateUnsupportedFloats
+               << ",numeric-precision-reduction="
+               << options.highLevelOptimizationOptions
+                      .numericPrecisionReduction
+               << ":";
+    programOp.print(hashStream, getLosslessPrintingFlags());
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(
+        path, llvm::toHex(hashStream.sha1(), /*LowerCase=*/true) + ".mlir");
+    entryPath = std::string(path);
+  }
+
+  bool isEnabled() const { return !entryPath.empty(); }
+
+  // Looks up the evaluated values of all |globalSymbols|. Returns false and
+  // leaves |values| unmodified if the entry is missing or incomplete.
+  bool lookup(MLIRContext *context, ArrayRef<StringAttr> globalSymbols,
+              DenseMap<StringAttr, Attribute> &values) {
+    if (!isEnabled()) return false;
+    auto fileOr = llvm::MemoryBuffer::getFile(entryPath);
+    if (!fileOr) return false;
+    auto entryOp =
+        mlir::parseSourceString<ModuleOp>((*fileOr)->getBuffer(), context);
+    if (!entryOp) return false;
+    SymbolTable entrySymbolTable(*entryOp);
+    DenseMap<StringAttr, Attribute> entryValues;
+    for (StringAttr globalSymbol : globalSymbols) {
+      auto globalOp =
+          entrySymbolTable.lookup<IREE::Util::GlobalOp>(globalSymbol);
+      if (!globalOp || !globalOp.getInitialValueAttr()) return false;
+      entryValues[globalSymbol] = globalOp.getInitialValueAttr();
+    }
+    values = std::move(entryValues);
+    return true;
+  }
+
+  // Stores the evaluated |values| keyed by global symbol. Failures are
+  // reported as warnings as the cache is only an optimization.
+  void store(Location loc, ArrayRef<std::pair<StringAttr, Attribute>> values) {
+    if (!isEnabled()) return;
+    OpBuilder builder(loc.getContext());
+    OwningOpRef<ModuleOp> entryOp = builder.create<ModuleOp>(loc);
+    builder.setInsertionPointToStart(entryOp->getBody());
+    for (auto &it : values) {
+      auto value = it.second.cast<TypedAttr>();
+      auto globalOp = builder.create<IREE::Util::GlobalOp>(
+          loc, it.first.getValue(), /*isMutable=*/false, value.getType(),
+          value);
+      globalOp.setPrivate();
+    }
+
+    // Write to a temporary file and rename so that concurrent compilers never
+    // observe a partial entry.
+    StringRef cacheDir = llvm::sys::path::parent_path(entryPath);
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (llvm::sys::fs::create_directories(cacheDir) ||
+        llvm::sys::fs::createUniqueFile(entryPath + ".%%%%%%.tmp", fd,
+                                        tempPath)) {
+      mlir::emitWarning(loc) << "unable to create const-eval cache entry in '"
+                             << cacheDir << "'";
+      return;
+    }
+    {
+      llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+      entryOp->print(os, getLosslessPrintingFlags());
+    }
+    if (llvm::sys::fs::rename(tempPath, entryPath)) {
+      llvm::sys::fs::remove(tempPath);
+      mlir::emitWarning(loc) << "unable to write const-eval cache entry '"
+                             << entryPath << "'";
+    }
+  }
+
+ private:
+  std::string entryPath;
+};
+
 struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
   JitGlobalsPass()
       : options(std::make_shared<CompileOptions>()),
         compilePipeline("builtin.module") {
+    // Use the requested backend if it was compiled in. The fallback is
+    // reported when the pass runs as there is no diagnostic handler here.
+    targetBackend = clJitTargetBackend;
+    if (!llvm::is_contained(IREE::HAL::getRegisteredTargetBackends(),
+                            targetBackend)) {
+      unavailableTargetBackend = targetBackend;
+      targetBackend = "vmvx";
+    }
+
     // Invoke IREE compilation flow.
-    options->executableOptions.targets.push_back("vmvx");
+    options->executableOptions.targets.push_back(targetBackend);
     options->targetOptions.f32Extension = true;
     options->targetOptions.f64Extension = false;  // not yet implemented
 
@@ -157,10 +334,19 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
     ProgramExtractor extractor(outerModule, innerModule);
     SmallVector<Operation *> pruneOps;
 
-    // Import initializers.
-    for (auto childOp : outerModule.getOps<IREE::Util::InitializerOp>()) {
-      extractor.importOperation(childOp);
-      pruneOps.push_back(childOp);
+    // Import initializers as functions that are invoked in order. This is
+    // equivalent to running them during module initialization but lets us
+    // attribute evaluation time to the globals they store.
+    SmallVector<func::FuncOp> initializerFuncs;
+    SmallVector<std::string> initializerNames;
+    for (auto initializerOp :
+         outerModule.getOps<IREE::Util::InitializerOp>()) {
+      initializerNames.push_back(
+          (llvm::Twine("jit_initializer$") + llvm::Twine(pruneOps.size()))
+              .str());
+      initializerFuncs.push_back(extractor.importInitializerAsFunc(
+          initializerOp, initializerNames.back()));
+      pruneOps.push_back(initializerOp);
     }
 
     // Transitively import any dependencies.
@@ -168,6 +354,25 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
       signalPassFailure();
     }
 
+    // Stores from the initializer functions now happen outside of
+    // initializers and require the globals to be mutable in the program.
+    // Track which initializers store each global so they can be blamed.
+    SymbolTable innerSymbolTable(innerModule);
+    DenseMap<StringAttr, SmallVector<unsigned>> globalInitializers;
+    for (auto it : llvm::enumerate(initializerFuncs)) {
+      it.value().walk([&](IREE::Util::GlobalStoreOpInterface storeOp) {
+        StringAttr globalSymbol = storeOp.getGlobalAttr().getAttr();
+        auto globalOp =
+            innerSymbolTable.lookup<IREE::Util::GlobalOpInterface>(
+                globalSymbol);
+        if (globalOp) globalOp.setGlobalMutable(true);
+        auto &initializers = globalInitializers[globalSymbol];
+        if (initializers.empty() || initializers.back() != it.index()) {
+          initializers.push_back(it.index());
+        }
+      });
+    }
+
     // Find any globals that we pulled in which lack an initializer. These
     // are the ones we will try to eval. Stash {func_symbol, global_symbol}
     // pairs for later.
@@ -196,10 +401,32 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
       innerModule.erase();
       return;
     }
+    if (!unavailableTargetBackend.empty()) {
+      mlir::emitWarning(outerModule.getLoc())
+          << "const-eval target backend '" << unavailableTargetBackend
+          << "' is not available; falling back to '" << targetBackend << "'";
+    }
+
+    // Reuse values evaluated by a prior compiler invocation of the same
+    // program, if any.
+    SmallVector<StringAttr> globalSymbols;
+    for (auto &it : uninitializedGlobals) globalSymbols.push_back(it.second);
+    GlobalCache cache(clJitCacheDir, targetBackend, *options, innerModule);
+    DenseMap<StringAttr, Attribute> cachedValues;
+    if (cache.lookup(&getContext(), globalSymbols, cachedValues)) {
+      innerModule.erase();
+      if (clJitDebug) {
+        llvm::errs() << "[iree-consteval] reusing " << cachedValues.size()
+                     << " cached globals\n";
+      }
+      setInitialValues(outerSymbolTable, cachedValues, pruneOps);
+      return;
+    }
 
     // Run the IREE compiler, transforming the inner module into a vm.module.
     LLVM_DEBUG(dbgs() << "JIT'ing " << uninitializedGlobals.size()
                       << " uninitialized globals\n");
+    auto compileStartTime = Clock::now();
     if (failed(runPipeline(compilePipeline, innerModule))) {
       return signalPassFailure();
     }
@@ -209,26 +436,77 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
     if (failed(binary.translateFromModule(innerModule))) {
       return signalPassFailure();
     }
+    if (clJitDebug) {
+      llvm::errs() << "[iree-consteval] compiled " << initializerNames.size()
+                   << " initializers for " << uninitializedGlobals.size()
+                   << " globals with " << targetBackend << " in "
+                   << llvm::format("%.1f",
+                                   getMillisecondsSince(compileStartTime))
+                   << "ms\n";
+    }
 
     // Kill the temporary program we constructed.
     innerModule.erase();
 
-    bool modified = false;
+    // Run the initializers in their original order.
+    SmallVector<double> initializerTimes;
+    for (auto it : llvm::enumerate(initializerNames)) {
+      auto startTime = Clock::now();
+      if (failed(binary.invokeNullary(
+              pruneOps[it.index()]->getLoc(), it.value(),
+              [](iree_vm_list_t *outputs) { return success(); }))) {
+        return signalPassFailure();
+      }
+      initializerTimes.push_back(getMillisecondsSince(startTime));
+    }
+
+    DenseMap<StringAttr, Attribute> values;
+    SmallVector<std::pair<StringAttr, Attribute>> orderedValues;
     for (auto &it : uninitializedGlobals) {
       StringAttr funcSymbol = it.first;
       StringAttr globalSymbol = it.second;
-      auto targetGlobal = llvm::cast<IREE::Util::GlobalOp>(
-          outerSymbolTable.lookup(globalSymbol));
-      Location loc = targetGlobal->getLoc();
+      Location loc = outerSymbolTable.lookup(globalSymbol)->getLoc();
 
+      auto startTime = Clock::now();
       Attribute value =
           binary.invokeNullaryAsAttribute(loc, funcSymbol.strref());
       if (!value) {
         return signalPassFailure();
       }
+      values[globalSymbol] = value;
+      orderedValues.emplace_back(globalSymbol, value);
+
+      if (clJitDebug) {
+        // Initializers may store multiple globals in which case each global
+        // reports the full time of the initializers that store it.
+        double evalTime = 0.0;
+        for (unsigned i : globalInitializers.lookup(globalSymbol)) {
+          evalTime += initializerTimes[i];
+        }
+        llvm::errs() << "[iree-consteval]   @" << globalSymbol.getValue()
+                     << ": " << llvm::format("%.1f", evalTime)
+                     << "ms evaluating, "
+                     << llvm::format("%.1f", getMillisecondsSince(startTime))
+                     << "ms converting (" << value.cast<TypedAttr>().getType()
+                     << ")\n";
+      }
+    }
+
+    cache.store(outerModule.getLoc(), orderedValues);
+    setInitialValues(outerSymbolTable, values, pruneOps);
+  }
 
+  // Sets the evaluated |values| as the initial values of their globals and
+  // removes the initializers that were evaluated.
+  void setInitialValues(SymbolTable &outerSymbolTable,
+                        const DenseMap<StringAttr, Attribute> &values,
+                        ArrayRef<Operation *> pruneOps) {
+    bool modified = false;
+    for (auto &it : values) {
+      auto targetGlobal = llvm::cast<IREE::Util::GlobalOp>(
+          outerSymbolTable.lookup(it.first));
+      targetGlobal.setInitialValueAttr(it.second);
       modified = true;
-      targetGlobal.setInitialValueAttr(value);
     }
 
     // Delete any ops noted for pruning.
@@ -239,12 +517,14 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
     // Signal any outer fixed point iterator that we have modified
     // globals and need another pass.
     if (modified) {
-      signalFixedPointModified(outerModule);
+      signalFixedPointModified(getOperation());
     }
   }
 
   std::shared_ptr<CompileOptions> options;
   OpPassManager compilePipeline;
+  std::string targetBackend;
+  std::string unavailableTargetBackend;
 };
 
 }  // namespace
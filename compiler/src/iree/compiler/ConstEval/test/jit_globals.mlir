@@ -1,4 +1,5 @@
 // RUN: iree-opt --split-input-file --iree-consteval-jit-globals %s | FileCheck %s
+// RUN: iree-opt --split-input-file --iree-consteval-jit-globals --iree-consteval-jit-target-backend=llvm-cpu %s | FileCheck %s
 
 // TODO(laurenzo): Full type matrix for tests.
 
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t
+// RUN: iree-opt --iree-consteval-jit-globals --iree-consteval-jit-cache-dir=%t --iree-consteval-jit-debug %s 2>&1 >/dev/null | FileCheck %s --check-prefix=COMPILE
+// RUN: iree-opt --iree-consteval-jit-globals --iree-consteval-jit-cache-dir=%t --iree-consteval-jit-debug %s 2>&1 >/dev/null | FileCheck %s --check-prefix=CACHED
+// RUN: iree-opt --iree-consteval-jit-globals --iree-consteval-jit-cache-dir=%t %s | FileCheck %s
+
+// The first run compiles and times each global and the second reuses them.
+// COMPILE: [iree-consteval] compiled 2 initializers for 2 globals
+// COMPILE-DAG: @hoisted_a: {{.*}}ms evaluating
+// COMPILE-DAG: @hoisted_b: {{.*}}ms evaluating
+// CACHED: [iree-consteval] reusing 2 cached globals
+
+// CHECK: util.global private @hoisted_a = dense<4> : tensor<4xi32>
+// CHECK: util.global private @hoisted_b = dense<6> : tensor<4xi32>
+// CHECK-NOT: util.initializer
+module @cached {
+  util.global private @hoisted_a : tensor<4xi32>
+  util.global private @hoisted_b : tensor<4xi32>
+  func.func @main() -> (tensor<4xi32>, tensor<4xi32>) {
+    %a = util.global.load @hoisted_a : tensor<4xi32>
+    %b = util.global.load @hoisted_b : tensor<4xi32>
+    return %a, %b : tensor<4xi32>, tensor<4xi32>
+  }
+  util.initializer {
+    %cst = arith.constant dense<2> : tensor<4xi32>
+    %0 = arith.addi %cst, %cst : tensor<4xi32>
+    util.global.store %0, @hoisted_a : tensor<4xi32>
+    util.initializer.return
+  }
+  util.initializer {
+    %cst = arith.constant dense<2> : tensor<4xi32>
+    %a = util.global.load @hoisted_a : tensor<4xi32>
+    %0 = arith.addi %a, %cst : tensor<4xi32>
+    util.global.store %0, @hoisted_b : tensor<4xi32>
+    util.initializer.return
+  }
+}
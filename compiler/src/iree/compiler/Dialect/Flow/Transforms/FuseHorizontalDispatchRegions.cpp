@@ -0,0 +1,302 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--------------- FuseHorizontalDispatchRegions.cpp -------------------===//
+// Merges independent sibling `flow.dispatch.region` ops that each compute a
+// single elementwise `linalg.generic` over the same static iteration space
+// into one dispatch region computing a multi-result `linalg.generic`. This
+// removes the per-dispatch scheduling, barrier, and binding setup overhead of
+// the many tiny dispatches produced by models with lots of parallel branches
+// (such as multi-head attention).
+//===---------------------------------------------------------------------===//
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/PatternMatch.h"
+
+#define DEBUG_TYPE "iree-flow-fuse-horizontal-dispatch-regions"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+// Maximum number of tensor operands of a merged `linalg.generic`. Each operand
+// becomes a binding of the resulting dispatch and backends limit the number of
+// bindings a single dispatch can use.
+static constexpr unsigned kMaxFusedOperandCount = 16;
+
+/// Returns the single elementwise `linalg.generic` computed by `regionOp` if
+/// the region is a candidate for horizontal fusion. Candidates have static
+/// result shapes, a static workload, contain only the generic and constant or
+/// `tensor.empty` ops, and return exactly the results of the generic.
+static linalg::GenericOp getHorizontalFusionCandidate(
+    DispatchRegionOp regionOp) {
+  if (!regionOp.getResultDims().empty()) return {};
+  for (Value workload : regionOp.getWorkload()) {
+    if (!getConstantIntValue(workload)) return {};
+  }
+
+  linalg::GenericOp genericOp;
+  Block &body = regionOp.getBody().front();
+  for (Operation &op : body.without_terminator()) {
+    if (auto candidateOp = dyn_cast<linalg::GenericOp>(op)) {
+      if (genericOp) return {};
+      genericOp = candidateOp;
+      continue;
+    }
+    if (!isa<arith::ConstantOp, tensor::EmptyOp>(op)) return {};
+  }
+  if (!genericOp || !genericOp.hasTensorSemantics() ||
+      genericOp.getNumParallelLoops() != genericOp.getNumLoops() ||
+      genericOp.hasDynamicShape()) {
+    return {};
+  }
+  if (!llvm::equal(body.getTerminator()->getOperands(),
+                   genericOp->getResults())) {
+    return {};
+  }
+  return genericOp;
+}
+
+/// Returns true if `a` and `b` iterate over the same static iteration space.
+static bool haveSameIterationSpace(linalg::GenericOp a, linalg::GenericOp b) {
+  return a.getStaticLoopRanges() == b.getStaticLoopRanges();
+}
+
+/// Returns true if `a` and `b` have the same constant workload and attributes
+/// (such as the affinity they execute with).
+static bool haveSameWorkload(DispatchRegionOp a, DispatchRegionOp b) {
+  if (a->getAttrDictionary() != b->getAttrDictionary()) return false;
+  if (a.getWorkload().size() != b.getWorkload().size()) return false;
+  for (auto it : llvm::zip(a.getWorkload(), b.getWorkload())) {
+    if (getConstantIntValue(std::get<0>(it)) !=
+        getConstantIntValue(std::get<1>(it))) {
+      return false;
+    }
+  }
+  return a.getWorkgroupCount().empty() == b.getWorkgroupCount().empty();
+}
+
+/// Returns true if `earlier` and `later` (which follows `earlier` in the same
+/// block) can be replaced by a single op at the position of `later`. This
+/// requires all users of `earlier` to follow `later`, which also guarantees
+/// that `later` does not (transitively) depend on `earlier`.
+static bool canMergeInto(DispatchRegionOp earlier, DispatchRegionOp later) {
+  Block *block = earlier->getBlock();
+  return llvm::none_of(earlier->getUsers(), [&](Operation *user) {
+    Operation *ancestor = block->findAncestorOpInBlock(*user);
+    return ancestor && (ancestor == later || ancestor->isBeforeInBlock(later));
+  });
+}
+
+/// Creates a `linalg.generic` computing the results of both `a` and `b` which
+/// iterate over the same iteration space.
+static linalg::GenericOp mergeGenericOps(RewriterBase &rewriter,
+                                         linalg::GenericOp a,
+                                         linalg::GenericOp b) {
+  SmallVector<Value> inputs = llvm::to_vector(a.getInputs());
+  llvm::append_range(inputs, b.getInputs());
+  SmallVector<Value> outputs = llvm::to_vector(a.getOutputs());
+  llvm::append_range(outputs, b.getOutputs());
+  SmallVector<Type> resultTypes(a->getResultTypes());
+  llvm::append_range(resultTypes, b->getResultTypes());
+
+  SmallVector<AffineMap> indexingMaps;
+  for (OpOperand *operand : a.getDpsInputOperands()) {
+    indexingMaps.push_back(a.getMatchingIndexingMap(operand));
+  }
+  for (OpOperand *operand : b.getDpsInputOperands()) {
+    indexingMaps.push_back(b.getMatchingIndexingMap(operand));
+  }
+  for (OpOperand *operand : a.getDpsInitOperands()) {
+    indexingMaps.push_back(a.getMatchingIndexingMap(operand));
+  }
+  for (OpOperand *operand : b.getDpsInitOperands()) {
+    indexingMaps.push_back(b.getMatchingIndexingMap(operand));
+  }
+
+  auto mergedOp = rewriter.create<linalg::GenericOp>(
+      b.getLoc(), resultTypes, inputs, outputs, indexingMaps,
+      a.getIteratorTypesArray());
+
+  // Block arguments are ordered as [a ins, b ins, a outs, b outs].
+  SmallVector<Type> argTypes;
+  SmallVector<Location> argLocs;
+  SmallVector<BlockArgument> aArgs(a.getBody()->getArguments());
+  SmallVector<BlockArgument> bArgs(b.getBody()->getArguments());
+  int64_t aInputCount = a.getNumDpsInputs();
+  int64_t bInputCount = b.getNumDpsInputs();
+  auto appendArgs = [&](ArrayRef<BlockArgument> args) {
+    for (BlockArgument arg : args) {
+      argTypes.push_back(arg.getType());
+      argLocs.push_back(arg.getLoc());
+    }
+  };
+  appendArgs(ArrayRef<BlockArgument>(aArgs).take_front(aInputCount));
+  appendArgs(ArrayRef<BlockArgument>(bArgs).take_front(bInputCount));
+  appendArgs(ArrayRef<BlockArgument>(aArgs).drop_front(aInputCount));
+  appendArgs(ArrayRef<BlockArgument>(bArgs).drop_front(bInputCount));
+  Block *block = rewriter.createBlock(&mergedOp.getRegion(), {}, argTypes,
+                                      argLocs);
+
+  BlockAndValueMapping mapping;
+  int64_t aOutputCount = a.getNumDpsInits();
+  for (int64_t i = 0; i < aInputCount; ++i) {
+    mapping.map(aArgs[i], block->getArgument(i));
+  }
+  for (int64_t i = 0; i < bInputCount; ++i) {
+    mapping.map(bArgs[i], block->getArgument(aInputCount + i));
+  }
+  for (int64_t i = 0; i < aOutputCount; ++i) {
+    mapping.map(aArgs[aInputCount + i],
+                block->getArgument(aInputCount + bInputCount + i));
+  }
+  for (int64_t i = 0, e = b.getNumDpsInits(); i < e; ++i) {
+    mapping.map(bArgs[bInputCount + i],
+                block->getArgument(aInputCount + bInputCount + aOutputCount +
+                                   i));
+  }
+
+  SmallVector<Value> yieldedValues;
+  for (linalg::GenericOp op : {a, b}) {
+    for (Operation &bodyOp : op.getBody()->without_terminator()) {
+      rewriter.clone(bodyOp, mapping);
+    }
+    for (Value value : op.getBody()->getTerminator()->getOperands()) {
+      yieldedValues.push_back(mapping.lookupOrDefault(value));
+    }
+  }
+  rewriter.create<linalg::YieldOp>(b.getLoc(), yieldedValues);
+  return mergedOp;
+}
+
+/// Replaces `a` and `b` with a single dispatch region placed at `b`.
+static DispatchRegionOp mergeDispatchRegions(RewriterBase &rewriter,
+                                             DispatchRegionOp a,
+                                             DispatchRegionOp b) {
+  OpBuilder::InsertionGuard guard(rewriter);
+  rewriter.setInsertionPoint(b);
+  SmallVector<Type> resultTypes(a->getResultTypes());
+  llvm::append_range(resultTypes, b->getResultTypes());
+  auto mergedOp = rewriter.create<DispatchRegionOp>(
+      b.getLoc(), resultTypes, /*dynamicDims=*/ValueRange{}, b.getWorkload());
+  for (NamedAttribute attr : b->getAttrs()) {
+    if (!mergedOp->hasAttr(attr.getName())) {
+      mergedOp->setAttr(attr.getName(), attr.getValue());
+    }
+  }
+  if (!b.getWorkgroupCount().empty()) {
+    rewriter.cloneRegionBefore(b.getWorkgroupCount(),
+                               mergedOp.getWorkgroupCount(),
+                               mergedOp.getWorkgroupCount().end());
+  }
+
+  // Clone the bodies of both regions and merge their generics.
+  Block &body = mergedOp.getBody().emplaceBlock();
+  rewriter.setInsertionPointToStart(&body);
+  BlockAndValueMapping mapping;
+  SmallVector<linalg::GenericOp> clonedGenericOps;
+  for (DispatchRegionOp regionOp : {a, b}) {
+    for (Operation &op : regionOp.getBody().front().without_terminator()) {
+      Operation *clonedOp = rewriter.clone(op, mapping);
+      if (auto genericOp = dyn_cast<linalg::GenericOp>(clonedOp)) {
+        clonedGenericOps.push_back(genericOp);
+      }
+    }
+  }
+  linalg::GenericOp mergedGenericOp =
+      mergeGenericOps(rewriter, clonedGenericOps[0], clonedGenericOps[1]);
+  for (linalg::GenericOp genericOp : clonedGenericOps) {
+    rewriter.eraseOp(genericOp);
+  }
+  rewriter.setInsertionPointToEnd(&body);
+  rewriter.create<ReturnOp>(b.getLoc(), mergedGenericOp->getResults());
+
+  rewriter.replaceOp(a, mergedOp.getResults().take_front(a->getNumResults()));
+  rewriter.replaceOp(b, mergedOp.getResults().drop_front(a->getNumResults()));
+  return mergedOp;
+}
+
+namespace {
+struct FuseHorizontalDispatchRegionsPass
+    : public FuseHorizontalDispatchRegionsBase<
+          FuseHorizontalDispatchRegionsPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Flow::FlowDialect, linalg::LinalgDialect>();
+  }
+
+  void runOnOperation() override;
+
+ private:
+  Statistic numDispatchRegionsMerged{
+      this, "dispatch region(s) merged",
+      "Number of flow.dispatch.region ops removed by horizontal fusion"};
+};
+}  // namespace
+
+void FuseHorizontalDispatchRegionsPass::runOnOperation() {
+  IRRewriter rewriter(&getContext());
+  SmallVector<Block *> blocks;
+  getOperation()->walk([&](Block *block) {
+    if (!isa<DispatchRegionOp>(block->getParentOp())) blocks.push_back(block);
+  });
+  for (Block *block : blocks) {
+    // Candidates seen so far in this block that later candidates may merge
+    // into. Merging replaces the earlier candidate with the merged region.
+    SmallVector<DispatchRegionOp> openRegionOps;
+    for (Operation &op : llvm::make_early_inc_range(*block)) {
+      auto regionOp = dyn_cast<DispatchRegionOp>(op);
+      if (!regionOp) continue;
+      linalg::GenericOp genericOp = getHorizontalFusionCandidate(regionOp);
+      if (!genericOp) continue;
+
+      bool merged = false;
+      for (DispatchRegionOp &openRegionOp : openRegionOps) {
+        linalg::GenericOp openGenericOp =
+            getHorizontalFusionCandidate(openRegionOp);
+        if (!openGenericOp ||
+            openGenericOp->getNumOperands() + genericOp->getNumOperands() >
+                kMaxFusedOperandCount ||
+            !haveSameIterationSpace(openGenericOp, genericOp) ||
+            !haveSameWorkload(openRegionOp, regionOp) ||
+            !canMergeInto(openRegionOp, regionOp)) {
+          continue;
+        }
+        LLVM_DEBUG({
+          llvm::dbgs() << "merging dispatch regions:\n  ";
+          openRegionOp.print(llvm::dbgs(), OpPrintingFlags().useLocalScope());
+          llvm::dbgs() << "\n  ";
+          regionOp.print(llvm::dbgs(), OpPrintingFlags().useLocalScope());
+          llvm::dbgs() << "\n";
+        });
+        openRegionOp = mergeDispatchRegions(rewriter, openRegionOp, regionOp);
+        ++numDispatchRegionsMerged;
+        merged = true;
+        break;
+      }
+      if (!merged) openRegionOps.push_back(regionOp);
+    }
+  }
+}
+
+std::unique_ptr<InterfacePass<mlir::FunctionOpInterface>>
+createFuseHorizontalDispatchRegionsPass() {
+  return std::make_unique<FuseHorizontalDispatchRegionsPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
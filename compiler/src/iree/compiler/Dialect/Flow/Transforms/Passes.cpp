@@ -101,6 +101,12 @@ static llvm::cl::opt<bool> clDispatchGenerateWorkloadRegion(
     "iree-flow-dispatch-generate-workload-region",
     llvm::cl::desc("Generate the workload region"), llvm::cl::init(true));
 
+static llvm::cl::opt<bool> clEnableHorizontalFusion(
+    "iree-flow-enable-horizontal-fusion",
+    llvm::cl::desc("Enable merging independent elementwise dispatch regions "
+                   "with the same iteration space into a single dispatch"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> clEnableDataTiling(
     "iree-flow-enable-data-tiling", llvm::cl::desc("Enable data tiling path"),
     llvm::cl::init(false));
@@ -281,6 +287,7 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
                          createInterchangeTransposeGenericOpsPass)
       // Enable data tiling after all linalg level transformations.
       .addPredicatedPass(clEnableDataTiling, createSetEncodingPass)
+      .addPredicatedPass(clEnableDataTiling, createPropagateEncodingPass)
       ////////////////////////////////////////////////////////////////////////
       // Dispatch region formation.
       .addPredicatedPass(!clDispatchTransformFileName.empty(),
@@ -294,6 +301,8 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
         return createFormDispatchRegionsPass(clEnableAggressiveFusion,
                                              clDispatchGenerateWorkloadRegion);
       })
+      .addPredicatedPass(clEnableHorizontalFusion,
+                         createFuseHorizontalDispatchRegionsPass)
       // Form dispatch region into dispatch workgroups
       .addPass([&]() {
         return createFormDispatchWorkgroupsPass(
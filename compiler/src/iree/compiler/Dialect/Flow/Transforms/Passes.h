@@ -130,6 +130,10 @@ std::unique_ptr<Pass> createOptimizeNumericsPass();
 // Sets encoding for tensors to allow tiled execution of operations.
 std::unique_ptr<Pass> createSetEncodingPass();
 
+// Propagates tensor encodings across elementwise operations and chained
+// contractions to remove unset_encoding -> set_encoding round trips.
+std::unique_ptr<Pass> createPropagateEncodingPass();
+
 // Strips the signed/unsigned portion off of tensors.
 std::unique_ptr<InterfacePass<mlir::FunctionOpInterface>>
 createStripSignednessPass();
@@ -149,6 +153,11 @@ std::unique_ptr<InterfacePass<mlir::FunctionOpInterface>>
 createFormDispatchRegionsPass(bool aggressiveFusion = false,
                               bool generateWorkloadRegion = true);
 
+// Pass to merge independent dispatch.region ops computing elementwise
+// operations over the same iteration space into a single dispatch.region.
+std::unique_ptr<InterfacePass<mlir::FunctionOpInterface>>
+createFuseHorizontalDispatchRegionsPass();
+
 //===----------------------------------------------------------------------===//
 // Dispatches (flow.dispatch.workgroups)
 //===----------------------------------------------------------------------===//
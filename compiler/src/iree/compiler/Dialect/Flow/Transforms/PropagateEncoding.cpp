@@ -0,0 +1,311 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--------------- PropagateEncoding.cpp -------------------------------===//
+// Keeps tensors in their encoded (tiled) layout across elementwise operations
+// and chained contractions so that unset_encoding -> set_encoding round trips
+// between them can be removed. Only real layout consumers see the tensor in
+// its original layout.
+//===---------------------------------------------------------------------===//
+
+#include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtDialect.h"
+#include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Arith/Utils/Utils.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/Transforms/Passes.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+using IREE::LinalgExt::EncodingAttr;
+using IREE::LinalgExt::SetEncodingOp;
+using IREE::LinalgExt::TensorEncoding;
+using IREE::LinalgExt::UnsetEncodingOp;
+
+//===---------------------------------------------------------------------===//
+// Utility functions
+//===---------------------------------------------------------------------===//
+
+/// Returns true if `encoding` is the encoding of a matmul result. The padded
+/// region of a result operand only ever contributes to the padded region of
+/// the result, so (unlike the LHS/RHS operands whose padding must be zero) the
+/// value of its padding does not matter.
+static bool isResultEncoding(RankedTensorType type) {
+  auto encodingAttr = type.getEncoding().dyn_cast_or_null<EncodingAttr>();
+  if (!encodingAttr) return false;
+  switch (encodingAttr.getEncoding().getValue()) {
+    case TensorEncoding::MATMUL_F32F32F32_RESULT:
+    case TensorEncoding::MATMUL_I8I8I32_RESULT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Returns true if all of the values in `ofrs` are the constant `value`.
+static bool areAllConstantIntValue(ArrayRef<OpFoldResult> ofrs,
+                                   int64_t value) {
+  return llvm::all_of(
+      ofrs, [&](OpFoldResult ofr) { return isConstantIntValue(ofr, value); });
+}
+
+/// Returns true if `sliceOp` extracts a leading (zero offset, unit stride,
+/// same rank) slice of its source as created when unpadding the result of an
+/// encoded operation.
+static bool isLeadingSlice(tensor::ExtractSliceOp sliceOp) {
+  return sliceOp.getSourceType().getRank() == sliceOp.getType().getRank() &&
+         areAllConstantIntValue(sliceOp.getMixedOffsets(), 0) &&
+         areAllConstantIntValue(sliceOp.getMixedStrides(), 1);
+}
+
+/// Returns true if `a` and `b` extract the same slice.
+static bool isSameSlice(tensor::ExtractSliceOp a, tensor::ExtractSliceOp b) {
+  auto isSame = [](ArrayRef<OpFoldResult> lhs, ArrayRef<OpFoldResult> rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for (auto it : llvm::zip(lhs, rhs)) {
+      if (!isEqualConstantIntOrValue(std::get<0>(it), std::get<1>(it))) {
+        return false;
+      }
+    }
+    return true;
+  };
+  return isSame(a.getMixedOffsets(), b.getMixedOffsets()) &&
+         isSame(a.getMixedSizes(), b.getMixedSizes()) &&
+         isSame(a.getMixedStrides(), b.getMixedStrides());
+}
+
+/// Returns true if all uses of `value` are in `user`.
+static bool isOnlyUsedBy(Value value, Operation *user) {
+  return llvm::all_of(value.getUsers(),
+                      [&](Operation *op) { return op == user; });
+}
+
+namespace {
+
+/// Folds an `unset_encoding` -> `set_encoding` round trip back to the encoded
+/// value when both use the same encoding:
+///
+/// ```mlir
+/// %0 = iree_linalg_ext.unset_encoding %src : tensor<..., #enc> -> tensor<...>
+/// %1 = iree_linalg_ext.set_encoding %0 : tensor<...> -> tensor<..., #enc>
+/// ```
+///
+/// For result encodings the `tensor.extract_slice` + `tensor.pad` pair used to
+/// unpad and repad the value is also looked through as long as the pad
+/// restores the exact shape the slice was taken from.
+struct FoldSetEncodingOfUnsetEncoding : public OpRewritePattern<SetEncodingOp> {
+  using OpRewritePattern<SetEncodingOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(SetEncodingOp setEncodingOp,
+                                PatternRewriter &rewriter) const override {
+    Value source = setEncodingOp.getSource();
+    if (auto padOp = source.getDefiningOp<tensor::PadOp>()) {
+      if (!isResultEncoding(setEncodingOp.getResultType())) {
+        return rewriter.notifyMatchFailure(
+            setEncodingOp, "padding of non-result operands must be zero");
+      }
+      auto sliceOp = padOp.getSource().getDefiningOp<tensor::ExtractSliceOp>();
+      if (!sliceOp || !isLeadingSlice(sliceOp) ||
+          !areAllConstantIntValue(padOp.getMixedLowPad(), 0) ||
+          !padOp.getResultType().hasStaticShape() ||
+          padOp.getResultType() != sliceOp.getSourceType()) {
+        return rewriter.notifyMatchFailure(
+            setEncodingOp, "pad does not restore the unpadded shape");
+      }
+      source = sliceOp.getSource();
+    }
+
+    auto unsetEncodingOp = source.getDefiningOp<UnsetEncodingOp>();
+    if (!unsetEncodingOp) {
+      return rewriter.notifyMatchFailure(setEncodingOp,
+                                         "source is not an unset_encoding");
+    }
+    if (unsetEncodingOp.getSourceType() != setEncodingOp.getResultType()) {
+      return rewriter.notifyMatchFailure(setEncodingOp, "encoding mismatch");
+    }
+    rewriter.replaceOp(setEncodingOp, unsetEncodingOp.getSource());
+    return success();
+  }
+};
+
+/// Sinks `unset_encoding` ops (and the `tensor.extract_slice` removing any
+/// padding) below elementwise `linalg.generic` ops whose tensor operands all
+/// come from values with the same encoding:
+///
+/// ```mlir
+/// %0 = iree_linalg_ext.unset_encoding %a : tensor<..., #enc> -> tensor<...>
+/// %1 = iree_linalg_ext.unset_encoding %b : tensor<..., #enc> -> tensor<...>
+/// %2 = linalg.generic ins(%0, %1 ...) outs(...)
+/// ```
+///
+/// becomes
+///
+/// ```mlir
+/// %e = tensor.empty(...) : tensor<..., #enc>
+/// %0 = linalg.generic ins(%a, %b ...) outs(%e ...) -> tensor<..., #enc>
+/// %2 = iree_linalg_ext.unset_encoding %0 : tensor<..., #enc> -> tensor<...>
+/// ```
+///
+/// This never increases the number of unset_encoding ops and moves the
+/// remaining one closer to whatever consumes the value, where it can fold
+/// with a `set_encoding` or is required by a real layout consumer.
+struct SinkUnsetEncodingThroughElementwise
+    : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (!genericOp.hasTensorSemantics() || genericOp.hasIndexSemantics() ||
+        genericOp.getNumParallelLoops() != genericOp.getNumLoops() ||
+        genericOp.getNumDpsInits() != 1) {
+      return rewriter.notifyMatchFailure(genericOp, "not elementwise");
+    }
+    OpOperand *init = genericOp.getDpsInitOperand(0);
+    if (genericOp.payloadUsesValueFromOperand(init) ||
+        !genericOp.getMatchingIndexingMap(init).isIdentity()) {
+      return rewriter.notifyMatchFailure(genericOp, "init is used");
+    }
+
+    RankedTensorType encodedType;
+    Value encodedSource;
+    tensor::ExtractSliceOp leadingSliceOp;
+    SmallVector<Value> newInputs;
+    for (OpOperand *input : genericOp.getDpsInputOperands()) {
+      Value value = input->get();
+      AffineMap map = genericOp.getMatchingIndexingMap(input);
+      auto tensorType = value.getType().dyn_cast<RankedTensorType>();
+      if (!tensorType || tensorType.getRank() == 0) {
+        // Scalars are broadcast and are layout independent.
+        if (map.getNumResults() != 0) return failure();
+        newInputs.push_back(value);
+        continue;
+      }
+      if (!map.isIdentity()) {
+        return rewriter.notifyMatchFailure(genericOp, "non-identity input");
+      }
+
+      // Look through the slice removing the padding. Every encoded input must
+      // be sliced the same way so that the padded shapes line up.
+      auto sliceOp = value.getDefiningOp<tensor::ExtractSliceOp>();
+      if (encodedType && (bool)sliceOp != (bool)leadingSliceOp) {
+        return rewriter.notifyMatchFailure(genericOp, "mismatched padding");
+      }
+      if (sliceOp) {
+        if (!isLeadingSlice(sliceOp) || !isOnlyUsedBy(value, genericOp) ||
+            (leadingSliceOp && !isSameSlice(leadingSliceOp, sliceOp))) {
+          return rewriter.notifyMatchFailure(genericOp, "unhandled slice");
+        }
+        leadingSliceOp = sliceOp;
+        value = sliceOp.getSource();
+      }
+
+      auto unsetEncodingOp = value.getDefiningOp<UnsetEncodingOp>();
+      if (!unsetEncodingOp ||
+          !isOnlyUsedBy(value, sliceOp ? sliceOp.getOperation()
+                                       : genericOp.getOperation())) {
+        return rewriter.notifyMatchFailure(
+            genericOp, "input is not an unset_encoding with a single user");
+      }
+      if (encodedType && encodedType != unsetEncodingOp.getSourceType()) {
+        return rewriter.notifyMatchFailure(genericOp, "mismatched encodings");
+      }
+      encodedType = unsetEncodingOp.getSourceType();
+      encodedSource = unsetEncodingOp.getSource();
+      newInputs.push_back(encodedSource);
+    }
+    if (!encodedType) {
+      return rewriter.notifyMatchFailure(genericOp, "no encoded inputs");
+    }
+    // Encodings are specific to the element type they were set on.
+    auto resultType = genericOp.getResult(0).getType().cast<RankedTensorType>();
+    if (resultType.getElementType() != encodedType.getElementType()) {
+      return rewriter.notifyMatchFailure(genericOp, "element type changes");
+    }
+
+    Location loc = genericOp.getLoc();
+    SmallVector<OpFoldResult> dimValues =
+        tensor::createDimValues(rewriter, loc, encodedSource);
+    auto emptyOp = rewriter.create<tensor::EmptyOp>(
+        loc, dimValues, encodedType.getElementType(),
+        encodedType.getEncoding());
+    auto newGenericOp = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange{encodedType}, newInputs, ValueRange{emptyOp},
+        genericOp.getIndexingMapsArray(), genericOp.getIteratorTypesArray());
+    rewriter.cloneRegionBefore(genericOp.getRegion(), newGenericOp.getRegion(),
+                               newGenericOp.getRegion().begin());
+
+    Value replacement =
+        rewriter.create<UnsetEncodingOp>(loc, newGenericOp.getResult(0));
+    if (leadingSliceOp) {
+      replacement = rewriter.create<tensor::ExtractSliceOp>(
+          loc, replacement, leadingSliceOp.getMixedOffsets(),
+          leadingSliceOp.getMixedSizes(), leadingSliceOp.getMixedStrides());
+    }
+    rewriter.replaceOp(genericOp, replacement);
+    return success();
+  }
+};
+
+struct PropagateEncodingPass
+    : public PropagateEncodingBase<PropagateEncodingPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::LinalgExt::IREELinalgExtDialect>();
+  }
+
+  void runOnOperation() override;
+
+ private:
+  Statistic numPackUnpackOpsEliminated{
+      this, "pack/unpack op(s) eliminated",
+      "Number of set_encoding/unset_encoding ops removed by propagation"};
+};
+}  // namespace
+
+/// Returns the number of `OpTy` ops nested under `op`.
+template <typename OpTy>
+static int64_t countOps(Operation *op) {
+  int64_t count = 0;
+  op->walk([&](OpTy) { ++count; });
+  return count;
+}
+
+void PropagateEncodingPass::runOnOperation() {
+  MLIRContext *context = &getContext();
+  Operation *operation = getOperation();
+  int64_t originalCount = countOps<SetEncodingOp>(operation) +
+                          countOps<UnsetEncodingOp>(operation);
+  {
+    RewritePatternSet patterns(context);
+    patterns.insert<FoldSetEncodingOfUnsetEncoding,
+                    SinkUnsetEncodingThroughElementwise>(context);
+    memref::populateResolveRankedShapeTypeResultDimsPatterns(patterns);
+    if (failed(applyPatternsAndFoldGreedily(operation, std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+  // Each set_encoding/unset_encoding would otherwise have been materialized
+  // as a pack/unpack dispatch (or fused into one).
+  numPackUnpackOpsEliminated +=
+      originalCount - countOps<SetEncodingOp>(operation) -
+      countOps<UnsetEncodingOp>(operation);
+}
+
+std::unique_ptr<Pass> createPropagateEncodingPass() {
+  return std::make_unique<PropagateEncodingPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,99 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="builtin.module(func.func(iree-flow-fuse-horizontal-dispatch-regions))" %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func.func @merge_independent(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>) -> (tensor<4x8xf32>, tensor<4x8xf32>) {
+  %0 = flow.dispatch.region -> (tensor<4x8xf32>) {
+    %empty = tensor.empty() : tensor<4x8xf32>
+    %1 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%arg0 : tensor<4x8xf32>) outs(%empty : tensor<4x8xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %2 = arith.addf %in, %in : f32
+      linalg.yield %2 : f32
+    } -> tensor<4x8xf32>
+    flow.return %1 : tensor<4x8xf32>
+  }
+  %3 = flow.dispatch.region -> (tensor<4x8xf32>) {
+    %empty = tensor.empty() : tensor<4x8xf32>
+    %4 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%arg1 : tensor<4x8xf32>) outs(%empty : tensor<4x8xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %5 = arith.mulf %in, %in : f32
+      linalg.yield %5 : f32
+    } -> tensor<4x8xf32>
+    flow.return %4 : tensor<4x8xf32>
+  }
+  return %0, %3 : tensor<4x8xf32>, tensor<4x8xf32>
+}
+// CHECK-LABEL: func.func @merge_independent
+//  CHECK-SAME:     %[[ARG0:[a-zA-Z0-9]+]]: tensor<4x8xf32>
+//  CHECK-SAME:     %[[ARG1:[a-zA-Z0-9]+]]: tensor<4x8xf32>
+//       CHECK:   %[[REGION:.+]]:2 = flow.dispatch.region -> (tensor<4x8xf32>, tensor<4x8xf32>)
+//       CHECK:     %[[GENERIC:.+]]:2 = linalg.generic
+//  CHECK-SAME:         ins(%[[ARG0]], %[[ARG1]] :
+//       CHECK:       ^bb0(%[[IN0:.+]]: f32, %[[IN1:.+]]: f32, %{{.+}}: f32, %{{.+}}: f32):
+//   CHECK-DAG:         %[[ADD:.+]] = arith.addf %[[IN0]], %[[IN0]]
+//   CHECK-DAG:         %[[MUL:.+]] = arith.mulf %[[IN1]], %[[IN1]]
+//       CHECK:         linalg.yield %[[ADD]], %[[MUL]]
+//       CHECK:     flow.return %[[GENERIC]]#0, %[[GENERIC]]#1
+//   CHECK-NOT:   flow.dispatch.region
+//       CHECK:   return %[[REGION]]#0, %[[REGION]]#1
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func.func @no_merge_dependent(%arg0: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = flow.dispatch.region -> (tensor<4x8xf32>) {
+    %empty = tensor.empty() : tensor<4x8xf32>
+    %1 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%arg0 : tensor<4x8xf32>) outs(%empty : tensor<4x8xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %2 = arith.addf %in, %in : f32
+      linalg.yield %2 : f32
+    } -> tensor<4x8xf32>
+    flow.return %1 : tensor<4x8xf32>
+  }
+  %3 = flow.dispatch.region -> (tensor<4x8xf32>) {
+    %empty = tensor.empty() : tensor<4x8xf32>
+    %4 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%0 : tensor<4x8xf32>) outs(%empty : tensor<4x8xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %5 = arith.mulf %in, %in : f32
+      linalg.yield %5 : f32
+    } -> tensor<4x8xf32>
+    flow.return %4 : tensor<4x8xf32>
+  }
+  return %3 : tensor<4x8xf32>
+}
+// CHECK-LABEL: func.func @no_merge_dependent
+//       CHECK:   flow.dispatch.region -> (tensor<4x8xf32>)
+//       CHECK:   flow.dispatch.region -> (tensor<4x8xf32>)
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func.func @no_merge_different_shapes(%arg0: tensor<4x8xf32>, %arg1: tensor<8x4xf32>) -> (tensor<4x8xf32>, tensor<8x4xf32>) {
+  %0 = flow.dispatch.region -> (tensor<4x8xf32>) {
+    %empty = tensor.empty() : tensor<4x8xf32>
+    %1 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%arg0 : tensor<4x8xf32>) outs(%empty : tensor<4x8xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %2 = arith.addf %in, %in : f32
+      linalg.yield %2 : f32
+    } -> tensor<4x8xf32>
+    flow.return %1 : tensor<4x8xf32>
+  }
+  %3 = flow.dispatch.region -> (tensor<8x4xf32>) {
+    %empty = tensor.empty() : tensor<8x4xf32>
+    %4 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+        ins(%arg1 : tensor<8x4xf32>) outs(%empty : tensor<8x4xf32>) {
+    ^bb0(%in: f32, %out: f32):
+      %5 = arith.mulf %in, %in : f32
+      linalg.yield %5 : f32
+    } -> tensor<8x4xf32>
+    flow.return %4 : tensor<8x4xf32>
+  }
+  return %0, %3 : tensor<4x8xf32>, tensor<8x4xf32>
+}
+// CHECK-LABEL: func.func @no_merge_different_shapes
+//       CHECK:   flow.dispatch.region -> (tensor<4x8xf32>)
+//       CHECK:   flow.dispatch.region -> (tensor<8x4xf32>)
@@ -0,0 +1,101 @@
+// RUN: iree-opt --iree-flow-propagate-encoding --cse --split-input-file %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func.func @elementwise_into_accumulator(%lhs0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>,
+    %rhs0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>,
+    %acc0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>,
+    %lhs1 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>,
+    %rhs1 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>) -> tensor<128x128xf32> {
+  %cst = arith.constant 0.0 : f32
+  %0 = linalg.matmul ins(%lhs0, %rhs0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>, tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>)
+      outs(%acc0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %1 = iree_linalg_ext.unset_encoding %0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<128x128xf32>
+  %2 = tensor.empty() : tensor<128x128xf32>
+  %3 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%1 : tensor<128x128xf32>) outs(%2 : tensor<128x128xf32>) {
+    ^bb0(%b0 : f32, %b1 : f32):
+      %4 = arith.maxf %b0, %cst : f32
+      linalg.yield %4 : f32
+  } -> tensor<128x128xf32>
+  %5 = iree_linalg_ext.set_encoding %3 : tensor<128x128xf32> -> tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %6 = linalg.matmul ins(%lhs1, %rhs1 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>, tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>)
+      outs(%5 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %7 = iree_linalg_ext.unset_encoding %6 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<128x128xf32>
+  return %7 : tensor<128x128xf32>
+}
+//      CHECK: func @elementwise_into_accumulator(
+//      CHECK:   %[[MATMUL0:.+]] = linalg.matmul
+//      CHECK:   %[[EMPTY:.+]] = tensor.empty() : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+//      CHECK:   %[[RELU:.+]] = linalg.generic
+// CHECK-SAME:       ins(%[[MATMUL0]] :
+// CHECK-SAME:       outs(%[[EMPTY]] :
+//      CHECK:       arith.maxf
+//  CHECK-NOT:   iree_linalg_ext.set_encoding
+//      CHECK:   %[[MATMUL1:.+]] = linalg.matmul
+// CHECK-SAME:       outs(%[[RELU]] :
+//      CHECK:   %[[RESULT:.+]] = iree_linalg_ext.unset_encoding %[[MATMUL1]]
+//      CHECK:   return %[[RESULT]]
+
+// -----
+
+func.func @padded_accumulator(%lhs0 : tensor<112x256xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>,
+    %rhs0 : tensor<256x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>,
+    %acc0 : tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>,
+    %lhs1 : tensor<112x256xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>,
+    %rhs1 : tensor<256x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>) -> tensor<100x500xf32> {
+  %cst = arith.constant 0.0 : f32
+  %0 = linalg.matmul ins(%lhs0, %rhs0 : tensor<112x256xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>, tensor<256x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>)
+      outs(%acc0 : tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %1 = iree_linalg_ext.unset_encoding %0 : tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<112x512xf32>
+  %2 = tensor.extract_slice %1[0, 0] [100, 500] [1, 1] : tensor<112x512xf32> to tensor<100x500xf32>
+  %3 = tensor.pad %2 low[0, 0] high[12, 12] {
+    ^bb0(%i : index, %j : index):
+      tensor.yield %cst : f32
+  } : tensor<100x500xf32> to tensor<112x512xf32>
+  %4 = iree_linalg_ext.set_encoding %3 : tensor<112x512xf32> -> tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %5 = linalg.matmul ins(%lhs1, %rhs1 : tensor<112x256xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>, tensor<256x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RHS_TRANSPOSE>>)
+      outs(%4 : tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>
+  %6 = iree_linalg_ext.unset_encoding %5 : tensor<112x512xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<112x512xf32>
+  %7 = tensor.extract_slice %6[0, 0] [100, 500] [1, 1] : tensor<112x512xf32> to tensor<100x500xf32>
+  return %7 : tensor<100x500xf32>
+}
+//      CHECK: func @padded_accumulator(
+//      CHECK:   %[[MATMUL0:.+]] = linalg.matmul
+//      CHECK:   %[[MATMUL1:.+]] = linalg.matmul
+// CHECK-SAME:       outs(%[[MATMUL0]] :
+//      CHECK:   %[[UNSET:.+]] = iree_linalg_ext.unset_encoding %[[MATMUL1]]
+//      CHECK:   %[[RESULT:.+]] = tensor.extract_slice %[[UNSET]]
+//      CHECK:   return %[[RESULT]]
+
+// -----
+
+// Contraction results feeding the LHS of another contraction need a relayout
+// and must not be folded.
+func.func @result_into_lhs(%arg0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>> {
+  %0 = iree_linalg_ext.unset_encoding %arg0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<128x128xf32>
+  %1 = iree_linalg_ext.set_encoding %0 : tensor<128x128xf32> -> tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>
+  return %1 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_LHS>>
+}
+// CHECK-LABEL: func @result_into_lhs(
+//       CHECK:   iree_linalg_ext.unset_encoding
+//       CHECK:   iree_linalg_ext.set_encoding
+
+// -----
+
+// Layout-dependent consumers (here a transpose) keep the unset_encoding.
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d1, d0)>
+func.func @transpose_consumer(%arg0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>>) -> tensor<128x128xf32> {
+  %0 = iree_linalg_ext.unset_encoding %arg0 : tensor<128x128xf32, #iree_linalg_ext.encoding<MATMUL_F32F32F32_RESULT>> -> tensor<128x128xf32>
+  %1 = tensor.empty() : tensor<128x128xf32>
+  %2 = linalg.generic {indexing_maps = [#map1, #map0], iterator_types = ["parallel", "parallel"]}
+      ins(%0 : tensor<128x128xf32>) outs(%1 : tensor<128x128xf32>) {
+    ^bb0(%b0 : f32, %b1 : f32):
+      linalg.yield %b0 : f32
+  } -> tensor<128x128xf32>
+  return %2 : tensor<128x128xf32>
+}
+// CHECK-LABEL: func @transpose_consumer(
+//       CHECK:   %[[UNSET:.+]] = iree_linalg_ext.unset_encoding
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       ins(%[[UNSET]] :
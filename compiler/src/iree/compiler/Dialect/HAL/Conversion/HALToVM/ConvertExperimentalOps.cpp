@@ -17,6 +17,10 @@ void populateHALExperimentalToVMPatterns(MLIRContext *context,
                                          RewritePatternSet &patterns) {
   patterns.insert<VMImportOpConversion<IREE::HAL::ExSharedDeviceOp>>(
       context, importSymbols, typeConverter, "hal.ex.shared_device");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExResultCacheLookupOp>>(
+      context, importSymbols, typeConverter, "hal.ex.result_cache.lookup");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExResultCacheInsertOp>>(
+      context, importSymbols, typeConverter, "hal.ex.result_cache.insert");
 }
 
 }  // namespace iree_compiler
@@ -327,12 +327,40 @@ void ExecutableTargetAttr::print(AsmPrinter &p) const {
   os << ">";
 }
 
+// Returns the CPU features that must be supported by the host in order to use
+// |targetAttr| or nullptr if there are no requirements. Targets producing
+// multiversioned CPU executables use this to differentiate the variants of the
+// same format.
+static ArrayAttr getRequiredCPUFeatures(ExecutableTargetAttr targetAttr) {
+  auto configAttr = targetAttr.getConfiguration();
+  if (!configAttr) return {};
+  auto featuresAttr = configAttr.getAs<ArrayAttr>("required_cpu_features");
+  if (!featuresAttr || featuresAttr.empty()) return {};
+  return featuresAttr;
+}
+
 std::string ExecutableTargetAttr::getSymbolNameFragment() {
-  return sanitizeSymbolName(getFormat().getValue().lower());
+  std::string fragment = getFormat().getValue().lower();
+  if (auto featuresAttr = getRequiredCPUFeatures(*this)) {
+    for (auto featureAttr : featuresAttr.getAsValueRange<StringAttr>()) {
+      fragment += "_" + featureAttr.lower();
+    }
+  }
+  return sanitizeSymbolName(fragment);
 }
 
 Attribute ExecutableTargetAttr::getMatchExpression() {
-  return DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto formatAttr =
+      DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto featuresAttr = getRequiredCPUFeatures(*this);
+  if (!featuresAttr) return formatAttr;
+  SmallVector<Attribute> conditionAttrs;
+  conditionAttrs.push_back(formatAttr);
+  for (auto featureAttr : featuresAttr.getAsRange<StringAttr>()) {
+    conditionAttrs.push_back(
+        DeviceMatchCPUFeatureAttr::get(getContext(), featureAttr));
+  }
+  return MatchAllAttr::get(getContext(), conditionAttrs);
 }
 
 // For now this is very simple: if there are any specified fields that are
@@ -835,6 +863,33 @@ Value DeviceMatchArchitectureAttr::buildConditionExpression(
       .getValue();
 }
 
+// static
+Attribute DeviceMatchCPUFeatureAttr::parse(AsmParser &p, Type type) {
+  StringAttr patternAttr;
+  if (failed(p.parseLess()) || failed(p.parseAttribute(patternAttr)) ||
+      failed(p.parseGreater())) {
+    return {};
+  }
+  return get(p.getContext(), patternAttr);
+}
+
+void DeviceMatchCPUFeatureAttr::print(AsmPrinter &p) const {
+  auto &os = p.getStream();
+  os << "<";
+  p.printAttribute(getPattern());
+  os << ">";
+}
+
+Value DeviceMatchCPUFeatureAttr::buildConditionExpression(
+    Location loc, Value device, OpBuilder builder) const {
+  auto i1Type = builder.getI1Type();
+  return builder
+      .create<IREE::HAL::DeviceQueryOp>(
+          loc, i1Type, i1Type, device, builder.getStringAttr("hal.cpu"),
+          getPattern(), builder.getZeroAttr(i1Type))
+      .getValue();
+}
+
 // static
 Attribute DeviceMatchExecutableFormatAttr::parse(AsmParser &p, Type type) {
   StringAttr patternAttr;
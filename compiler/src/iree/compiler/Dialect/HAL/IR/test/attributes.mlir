@@ -68,3 +68,14 @@
   // CHECK: q123 = #hal.affinity.queue<[1, 2, 3]>
   q123 = #hal.affinity.queue<[1, 2, 3]>
 } : () -> ()
+
+// -----
+
+"device.match"() {
+  // CHECK: format = #hal.device.match.executable.format<"embedded-elf-x86_64">
+  format = #hal.device.match.executable.format<"embedded-elf-x86_64">,
+  // CHECK: cpu_feature = #hal.device.match.cpu.feature<"avx512f">
+  cpu_feature = #hal.device.match.cpu.feature<"avx512f">,
+  // CHECK: all = #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx2">]>
+  all = #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx2">]>
+} : () -> ()
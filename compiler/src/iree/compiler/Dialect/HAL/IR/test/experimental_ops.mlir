@@ -6,3 +6,15 @@ func.func @shared_device() -> !hal.device {
   %device = hal.ex.shared_device : !hal.device
   return %device : !hal.device
 }
+
+// -----
+
+// CHECK-LABEL: @result_cache
+// CHECK-SAME: (%[[ARG0:.+]]: !hal.buffer_view, %[[ARG1:.+]]: !hal.buffer_view)
+func.func @result_cache(%arg0: !hal.buffer_view, %arg1: !hal.buffer_view) -> !util.list<!hal.buffer_view> {
+  // CHECK: %[[LIST:.+]], %[[TOKEN:.+]] = hal.ex.result_cache.lookup key("fn") operands(%[[ARG0]], %[[ARG1]] : !hal.buffer_view, !hal.buffer_view) : !util.list<!hal.buffer_view>, !util.buffer
+  %list, %token = hal.ex.result_cache.lookup key("fn") operands(%arg0, %arg1 : !hal.buffer_view, !hal.buffer_view) : !util.list<!hal.buffer_view>, !util.buffer
+  // CHECK: hal.ex.result_cache.insert token(%[[TOKEN]] : !util.buffer) results(%[[LIST]] : !util.list<!hal.buffer_view>)
+  hal.ex.result_cache.insert token(%token : !util.buffer) results(%list : !util.list<!hal.buffer_view>)
+  return %list : !util.list<!hal.buffer_view>
+}
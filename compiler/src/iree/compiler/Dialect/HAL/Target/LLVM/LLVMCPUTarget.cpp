@@ -20,6 +20,7 @@
 #include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Utils/ModuleUtils.h"
+#include "iree/compiler/Utils/TracingUtils.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
@@ -117,7 +118,7 @@ class LLVMCPUTargetBackend final : public TargetBackend {
  public:
   explicit LLVMCPUTargetBackend(LLVMTargetOptions options)
       : options_(std::move(options)) {
-    initializeConfiguration(options_);
+    config_ = computeConfiguration(options_.target, options_);
   }
 
   std::string name() const override { return "llvm-cpu"; }
@@ -180,8 +181,12 @@ class LLVMCPUTargetBackend final : public TargetBackend {
   LogicalResult serializeExecutable(const SerializationOptions &options,
                                     IREE::HAL::ExecutableVariantOp variantOp,
                                     OpBuilder &executableBuilder) override {
+    IREE_COMPILER_TRACE_SCOPE("LLVMCPUTarget::serializeExecutable");
+
     // Perform the translation in a separate context to avoid any
-    // multi-threading issues.
+    // multi-threading issues. Executables are serialized concurrently and
+    // nothing LLVM-related (context, target machine, linker tool) may be
+    // shared across invocations.
     llvm::LLVMContext context;
 
     // We name our files after the executable name so that they are easy to
@@ -216,8 +221,12 @@ class LLVMCPUTargetBackend final : public TargetBackend {
 
     // At this moment we are leaving MLIR LLVM dialect land translating module
     // into target independent LLVMIR.
-    auto llvmModule = mlir::translateModuleToLLVMIR(variantOp.getInnerModule(),
-                                                    context, libraryName);
+    std::unique_ptr<llvm::Module> llvmModule;
+    {
+      IREE_COMPILER_TRACE_SCOPE("TranslateModuleToLLVMIR");
+      llvmModule = mlir::translateModuleToLLVMIR(variantOp.getInnerModule(),
+                                                 context, libraryName);
+    }
     if (!llvmModule) {
       return variantOp.emitError() << "failed to translate the MLIR LLVM "
                                       "dialect to the native llvm::Module";
@@ -388,12 +397,15 @@ class LLVMCPUTargetBackend final : public TargetBackend {
 
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do.
-    if (failed(
-            runLLVMIRPasses(options_, targetMachine.get(), llvmModule.get()))) {
-      return variantOp.emitError()
-             << "failed to run LLVM-IR opt passes for IREE::HAL::ExecutableOp "
-                "targeting '"
-             << targetTriple.str() << "'";
+    {
+      IREE_COMPILER_TRACE_SCOPE("RunLLVMIRPasses");
+      if (failed(runLLVMIRPasses(options_, targetMachine.get(),
+                                 llvmModule.get()))) {
+        return variantOp.emitError()
+               << "failed to run LLVM-IR opt passes for "
+                  "IREE::HAL::ExecutableOp targeting '"
+               << targetTriple.str() << "'";
+      }
     }
 
     // Fixup visibility from any symbols we may link in - we want to hide all
@@ -422,6 +434,7 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     // Emit the base object file containing the bulk of our code.
     // This must come first such that we have the proper library linking order.
     {
+      IREE_COMPILER_TRACE_SCOPE("EmitObjectFile");
       // NOTE: today we just use a single object file, however if we wanted to
       // scale code generation and linking we'd want to generate one per
       // function (or something like that). A single object file is also
@@ -541,8 +554,12 @@ class LLVMCPUTargetBackend final : public TargetBackend {
       const std::string &libraryName, const llvm::Triple &targetTriple,
       const SmallVector<Artifact> &objectFiles, LinkerTool *linkerTool) {
     // Link the generated object files into a dylib.
-    auto linkArtifactsOr =
-        linkerTool->linkDynamicLibrary(libraryName, objectFiles);
+    Optional<Artifacts> linkArtifactsOr;
+    {
+      IREE_COMPILER_TRACE_SCOPE("LinkDynamicLibrary");
+      linkArtifactsOr =
+          linkerTool->linkDynamicLibrary(libraryName, objectFiles);
+    }
     if (!linkArtifactsOr.has_value()) {
       return mlir::emitError(variantOp.getLoc())
              << "failed to link executable and generate target dylib (check "
@@ -644,15 +661,48 @@ class LLVMCPUTargetBackend final : public TargetBackend {
   }
 
  private:
+  // Additional target information besides that is contained in
+  // LLVMTargetOptions options_.
+  struct AdditionalConfigurationValues {
+    std::string dataLayoutStr;
+    int64_t vectorSize;
+  };
+
   ArrayAttr getExecutableTargets(MLIRContext *context) const {
     SmallVector<Attribute> targetAttrs;
-    // This is where we would multiversion.
-    targetAttrs.push_back(getExecutableTarget(context));
+    // Multiversioned variants are listed in priority order ahead of the
+    // baseline target. The runtime selects the first variant whose required
+    // CPU features are all supported by the host and otherwise falls back to
+    // the baseline.
+    for (auto &variantFeatures : options_.cpuFeatureVariants) {
+      targetAttrs.push_back(getExecutableTarget(context, variantFeatures));
+    }
+    targetAttrs.push_back(getExecutableTarget(context, /*variantFeatures=*/""));
     return ArrayAttr::get(context, targetAttrs);
   }
 
+  // Returns the executable target for the default target with the additional
+  // |variantFeatures| (LLVM `+feature` syntax) enabled. All enabled variant
+  // features are required to be present on the host at runtime.
   IREE::HAL::ExecutableTargetAttr getExecutableTarget(
-      MLIRContext *context) const {
+      MLIRContext *context, StringRef variantFeatures) const {
+    LLVMTarget target = options_.target;
+    AdditionalConfigurationValues config = config_;
+    SmallVector<Attribute> requiredFeatureAttrs;
+    if (!variantFeatures.empty()) {
+      if (!target.cpuFeatures.empty()) target.cpuFeatures += ",";
+      target.cpuFeatures += variantFeatures.str();
+      config = computeConfiguration(target, options_);
+      SmallVector<StringRef> features;
+      variantFeatures.split(features, ',', /*MaxSplit=*/-1,
+                            /*KeepEmpty=*/false);
+      for (auto feature : features) {
+        feature = feature.trim();
+        if (!feature.consume_front("+")) continue;
+        requiredFeatureAttrs.push_back(StringAttr::get(context, feature));
+      }
+    }
+
     std::string format;
     if (options_.linkStatic) {
       // Static libraries are just string references when serialized so we don't
@@ -660,7 +710,7 @@ class LLVMCPUTargetBackend final : public TargetBackend {
       format += "static";
     } else {
       // Construct the [loader]-[format]-[arch] triple.
-      llvm::Triple targetTriple(options_.target.triple);
+      llvm::Triple targetTriple(target.triple);
       if (options_.linkEmbedded) {
         // Using the IREE embedded ELF format/loader.
         format += "embedded-elf-";
@@ -723,31 +773,37 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     };
 
     // Set target attributes.
-    addConfig("target_triple",
-              StringAttr::get(context, options_.target.triple));
-    addConfig("cpu", StringAttr::get(context, options_.target.cpu));
-    addConfig("cpu_features",
-              StringAttr::get(context, options_.target.cpuFeatures));
+    addConfig("target_triple", StringAttr::get(context, target.triple));
+    addConfig("cpu", StringAttr::get(context, target.cpu));
+    addConfig("cpu_features", StringAttr::get(context, target.cpuFeatures));
+
+    // Set the features the runtime must check before selecting this variant.
+    if (!requiredFeatureAttrs.empty()) {
+      addConfig("required_cpu_features",
+                ArrayAttr::get(context, requiredFeatureAttrs));
+    }
 
     // Set data layout
-    addConfig("data_layout", StringAttr::get(context, config_.dataLayoutStr));
+    addConfig("data_layout", StringAttr::get(context, config.dataLayoutStr));
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
     addConfig("native_vector_size",
-              IntegerAttr::get(IndexType::get(context), config_.vectorSize));
+              IntegerAttr::get(IndexType::get(context), config.vectorSize));
 
     return IREE::HAL::ExecutableTargetAttr::get(
         context, StringAttr::get(context, "llvm-cpu"),
         StringAttr::get(context, format), DictionaryAttr::get(context, config));
   }
 
-  void initializeConfiguration(const LLVMTargetOptions &options) {
-    auto targetMachine = createTargetMachine(options.target, options);
+  static AdditionalConfigurationValues computeConfiguration(
+      const LLVMTarget &target, const LLVMTargetOptions &options) {
+    AdditionalConfigurationValues config;
+    auto targetMachine = createTargetMachine(target, options);
 
     // Data layout
     llvm::DataLayout DL = targetMachine->createDataLayout();
-    config_.dataLayoutStr = DL.getStringRepresentation();
+    config.dataLayoutStr = DL.getStringRepresentation();
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
@@ -761,28 +817,23 @@ class LLVMCPUTargetBackend final : public TargetBackend {
         llvm::GlobalValue::ExternalLinkage, "dummy_func", *llvmModule);
     llvm::TargetTransformInfo tti =
         targetMachine->getTargetTransformInfo(*dummyFunc);
-    config_.vectorSize = tti.getRegisterBitWidth(
-                             llvm::TargetTransformInfo::RGK_FixedWidthVector) /
-                         8;
+    config.vectorSize = tti.getRegisterBitWidth(
+                            llvm::TargetTransformInfo::RGK_FixedWidthVector) /
+                        8;
     LLVM_DEBUG({
       llvm::dbgs() << "CPU : " << targetMachine->getTargetCPU() << "\n";
       llvm::dbgs() << "Target Triple : "
                    << targetMachine->getTargetTriple().normalize() << "\n";
       llvm::dbgs() << "Target Feature string : "
                    << targetMachine->getTargetFeatureString() << "\n";
-      llvm::dbgs() << "Data Layout : " << config_.dataLayoutStr << "\n";
-      llvm::dbgs() << "Vector Width : " << config_.vectorSize << "\n";
+      llvm::dbgs() << "Data Layout : " << config.dataLayoutStr << "\n";
+      llvm::dbgs() << "Vector Width : " << config.vectorSize << "\n";
     });
+    return config;
   }
 
   LLVMTargetOptions options_;
-
-  // Additional target information besides that is contained in
-  // LLVMTargetOptions options_.
-  struct AdditionalConfigurationValues {
-    std::string dataLayoutStr;
-    int64_t vectorSize;
-  } config_;
+  AdditionalConfigurationValues config_;
 };
 
 void registerLLVMCPUTargetBackends(
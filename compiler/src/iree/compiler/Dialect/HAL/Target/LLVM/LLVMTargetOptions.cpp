@@ -100,6 +100,18 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
     targetOptions.target.cpuFeatures = clTargetCPUFeatures;
   }
 
+  static llvm::cl::list<std::string> clTargetCPUFeatureVariants(
+      "iree-llvm-target-cpu-feature-variant",
+      llvm::cl::desc(
+          "Additional LLVM target machine CPU features (e.g. "
+          "'+avx512f,+avx512vnni') to produce a multiversioned variant of each "
+          "executable for. May be specified multiple times in priority order; "
+          "at runtime the first variant supported by the host is used and "
+          "the --iree-llvm-target-cpu-features target is the fallback."),
+      llvm::cl::ZeroOrMore);
+  targetOptions.cpuFeatureVariants.assign(clTargetCPUFeatureVariants.begin(),
+                                          clTargetCPUFeatureVariants.end());
+
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
   targetOptions.pipelineTuningOptions.LoopVectorization = llvmLoopVectorization;
@@ -7,6 +7,9 @@
 #ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 
+#include <string>
+#include <vector>
+
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Target/TargetOptions.h"
 
@@ -33,6 +36,13 @@ struct LLVMTargetOptions {
   // Default target machine configuration.
   LLVMTarget target;
 
+  // Additional CPU feature sets (such as `+avx512f,+avx512vnni`) to produce
+  // multiversioned executable variants for in priority order. Each variant
+  // enables its features on top of the default target and is only selected at
+  // runtime if the host supports all of them, with the default target used as
+  // the fallback.
+  std::vector<std::string> cpuFeatureVariants;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   // Optimization level to be used by the LLVM optimizer (middle-end).
   llvm::OptimizationLevel optimizerOptLevel;
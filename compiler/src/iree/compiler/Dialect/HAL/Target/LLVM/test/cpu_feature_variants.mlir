@@ -0,0 +1,11 @@
+// Tests that CPU feature variants produce additional executable targets ahead
+// of the baseline target.
+// RUN: iree-opt --pass-pipeline='builtin.module(iree-hal-assign-target-devices{targets=llvm-cpu})' --iree-llvm-link-embedded=true --iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf --iree-llvm-target-cpu-feature-variant=+avx512f --iree-llvm-target-cpu-feature-variant=+avx2,+fma %s | FileCheck %s
+
+// CHECK-DAG: #executable_target_embedded_elf_x86_64_avx512f = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "generic", cpu_features = "+avx512f", {{.+}}, required_cpu_features = ["avx512f"], target_triple = "x86_64-unknown-unknown-eabi-elf"}>
+// CHECK-DAG: #executable_target_embedded_elf_x86_64_avx2_fma = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "generic", cpu_features = "+avx2,+fma", {{.+}}, required_cpu_features = ["avx2", "fma"], target_triple = "x86_64-unknown-unknown-eabi-elf"}>
+// CHECK-DAG: #executable_target_embedded_elf_x86_64 = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "generic", cpu_features = "", data_layout = "{{.+}}", native_vector_size = 16 : index, target_triple = "x86_64-unknown-unknown-eabi-elf"}>
+// CHECK-DAG: #device_target_llvm_cpu = #hal.device.target<"llvm-cpu", {executable_targets = [#executable_target_embedded_elf_x86_64_avx512f, #executable_target_embedded_elf_x86_64_avx2_fma, #executable_target_embedded_elf_x86_64]}>
+
+// CHECK: module @module attributes {hal.device.targets = [#device_target_llvm_cpu]}
+module @module {}
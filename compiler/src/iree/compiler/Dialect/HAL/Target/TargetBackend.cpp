@@ -61,6 +61,14 @@ void TargetOptions::bindOptions(OptionsBinder &binder) {
       llvm::cl::desc(
           "Path to write translated and serialized executable binaries into."),
       llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<int>(
+      "iree-hal-executable-compilation-threads", executableCompilationThreads,
+      llvm::cl::desc("Maximum number of threads used to compile executables "
+                     "in parallel (0 for all hardware threads). This bounds "
+                     "the compiler thread pool shared by all parallel passes "
+                     "and is ignored if --mlir-disable-threading is set."),
+      llvm::cl::init(0), llvm::cl::cat(halTargetOptionsCategory));
 }
 
 void dumpDataToPath(StringRef path, StringRef baseName, StringRef suffix,
@@ -52,6 +52,10 @@ struct TargetOptions {
   // A path to write translated and serialized executable binaries into.
   std::string executableBinariesPath;
 
+  // Maximum number of threads used to translate and serialize executables in
+  // parallel. 0 uses all available hardware threads.
+  int executableCompilationThreads = 0;
+
   void bindOptions(OptionsBinder &binder);
   using FromFlags = OptionsFromFlags<TargetOptions>;
 };
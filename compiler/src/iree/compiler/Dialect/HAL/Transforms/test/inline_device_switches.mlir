@@ -82,3 +82,32 @@ func.func @no_results(%device : !hal.device) {
   // CHECK-NEXT:  return
   return
 }
+
+// -----
+
+// CHECK-LABEL: @cpu_features
+// CHECK-SAME: %[[DEVICE:.+]]: !hal.device
+func.func @cpu_features(%device : !hal.device) {
+  hal.device.switch<%device : !hal.device>
+    // CHECK-NEXT:  %{{.+}}, %[[IS_FORMAT:.+]] = hal.device.query<%[[DEVICE]] : !hal.device> key("hal.executable.format" :: "embedded-elf-x86_64") : i1, i1 = false
+    // CHECK-NEXT:  %{{.+}}, %[[HAS_AVX512F:.+]] = hal.device.query<%[[DEVICE]] : !hal.device> key("hal.cpu" :: "avx512f") : i1, i1 = false
+    // CHECK-NEXT:  %[[MATCH:.+]] = arith.andi %[[IS_FORMAT]], %[[HAS_AVX512F]] : i1
+    // CHECK-NEXT:  cf.cond_br %[[MATCH]], ^bb1, ^bb2
+    // CHECK-NEXT: ^bb1:
+    // CHECK-NEXT:  "some.op_avx512f"()
+    // CHECK-NEXT:  cf.br ^bb3
+    #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx512f">]> {
+      "some.op_avx512f"() : () -> ()
+      hal.return
+    },
+    // CHECK-NEXT: ^bb2:
+    // CHECK-NEXT:  "some.op_baseline"()
+    // CHECK-NEXT:  cf.br ^bb3
+    #hal.match.always {
+      "some.op_baseline"() : () -> ()
+      hal.return
+    }
+  // CHECK-NEXT: ^bb3:
+  // CHECK-NEXT:  return
+  return
+}
@@ -208,3 +208,48 @@ func.func @exeLookup(%device : !hal.device) -> !hal.executable {
 }
 
 }
+
+// -----
+
+// Tests that CPU feature multiversioned variants are selected by their
+// required features ahead of the baseline variant.
+
+#pipeline_layout = #hal.pipeline.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+#executable_target_avx512f = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {
+  cpu_features = "+avx512f",
+  required_cpu_features = ["avx512f"]
+}>
+#executable_target_baseline = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {
+  cpu_features = ""
+}>
+
+module attributes {hal.device.targets = [#hal.device.target<"llvm-cpu">]} {
+
+hal.executable @exe {
+  hal.executable.variant @embedded_elf_x86_64_avx512f, target = #executable_target_avx512f {
+    hal.executable.export @entry ordinal(0) layout(#pipeline_layout)
+  }
+  hal.executable.variant @embedded_elf_x86_64, target = #executable_target_baseline {
+    hal.executable.export @entry ordinal(0) layout(#pipeline_layout)
+  }
+}
+
+// CHECK: util.global private @_executable_exe : !hal.executable
+// CHECK-NEXT: util.initializer {
+// CHECK:   %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+// CHECK:   hal.device.switch<%[[DEVICE]] : !hal.device> -> !hal.executable
+// CHECK:   #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx512f">]> {
+// CHECK:     hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64_avx512f)
+// CHECK:   },
+// CHECK:   #hal.device.match.executable.format<"embedded-elf-x86_64"> {
+// CHECK:     hal.executable.create
+// CHECK-SAME:  target(@exe::@embedded_elf_x86_64)
+// CHECK:   },
+// CHECK:   #hal.match.always {
+
+}
@@ -17,6 +17,21 @@ vm.import @ex.submit_and_wait(
 )
 attributes {vm.yield}
 
+// Returns the cached results of the function |key| applied to |operands| or an
+// empty list if the results are not cached. Misses with cacheable operands
+// also return a key token that can be passed to @ex.result_cache.insert.
+vm.import @ex.result_cache.lookup(
+  %key : !vm.buffer,
+  %operands : !vm.ref<!hal.buffer_view> ...
+) -> (!vm.list<!vm.ref<!hal.buffer_view>>, !vm.buffer)
+
+// Caches |result_list| under the |key_token| returned from a missed
+// @ex.result_cache.lookup. Null tokens are ignored.
+vm.import @ex.result_cache.insert(
+  %key_token : !vm.buffer,
+  %result_list : !vm.list<!vm.ref<!hal.buffer_view>>
+)
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
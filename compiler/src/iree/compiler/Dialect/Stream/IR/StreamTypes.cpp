@@ -251,10 +251,9 @@ Attribute PartitioningConfigAttr::parse(AsmParser &p, Type type) {
 }
 
 void PartitioningConfigAttr::print(AsmPrinter &p) const {
-  p << "<";
-  p << "favor-";
+  p << "<\"";
   p << stringifyFavor(getFavor().getValue());
-  p << ">";
+  p << "\">";
 }
 
 PartitioningConfigAttr PartitioningConfigAttr::lookup(Operation *op) {
@@ -0,0 +1,210 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-annotate-peak-memory"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+// Transient memory required at the peak of a program timeline.
+struct PeakMemory {
+  // Peak number of bytes of transient memory live at any point.
+  int64_t size = 0;
+  // True if some allocations were dynamically sized (or could not be
+  // analyzed) and |size| is only a lower bound.
+  bool dynamic = false;
+};
+
+// Computes the peak transient memory required by callables by walking their
+// timelines in program order. Each stream.resource.alloca is live until the
+// matching stream.resource.dealloca and calls contribute the peak of their
+// callee at the point they are made. Live allocations are propagated along
+// CFG edges and merged at joins by taking their union so that the peak is an
+// upper bound across all paths.
+class PeakMemoryAnalysis {
+ public:
+  PeakMemory lookupCallable(CallableOpInterface callableOp) {
+    auto it = callablePeaks.find(callableOp);
+    if (it != callablePeaks.end()) return it->second;
+    PeakMemory peak;
+    if (!callableOp.getCallableRegion() ||
+        callableOp.getCallableRegion()->empty()) {
+      return peak;
+    }
+    if (!activeCallables.insert(callableOp).second) {
+      // Recursion; the total depends on the recursion depth.
+      peak.dynamic = true;
+      return peak;
+    }
+    peak = computeRegionPeak(*callableOp.getCallableRegion(), LiveSet{});
+    activeCallables.erase(callableOp);
+    callablePeaks[callableOp] = peak;
+    return peak;
+  }
+
+ private:
+  // Allocations live at a program point mapped to their size in bytes.
+  using LiveSet = DenseMap<Value, int64_t>;
+
+  // Returns the peak memory of |region| including the |entryLive| allocations
+  // that are live on entry.
+  PeakMemory computeRegionPeak(Region &region, const LiveSet &entryLive) {
+    PeakMemory peak;
+    if (region.empty()) return peak;
+    DenseMap<Block *, LiveSet> blockLiveIns;
+    blockLiveIns[&region.front()] = entryLive;
+    SetVector<Block *> worklist;
+    worklist.insert(&region.front());
+    while (!worklist.empty()) {
+      Block *block = worklist.pop_back_val();
+      LiveSet live = blockLiveIns[block];
+      computeBlockPeak(*block, live, peak);
+      for (Block *successor : block->getSuccessors()) {
+        auto [it, changed] = blockLiveIns.try_emplace(successor);
+        for (auto [value, size] : live) {
+          changed |= it->second.try_emplace(value, size).second;
+        }
+        if (changed) worklist.insert(successor);
+      }
+    }
+    return peak;
+  }
+
+  // Accumulates the peak memory of |block| into |peak| and updates |live| to
+  // the allocations live on exit from the block.
+  void computeBlockPeak(Block &block, LiveSet &live, PeakMemory &peak) {
+    int64_t liveSize = 0;
+    for (auto [value, size] : live) liveSize += size;
+    peak.size = std::max(peak.size, liveSize);
+    for (auto &op : block) {
+      if (auto allocaOp = dyn_cast<IREE::Stream::ResourceAllocaOp>(op)) {
+        APInt size;
+        if (!matchPattern(allocaOp.getStorageSize(), m_ConstantInt(&size))) {
+          peak.dynamic = true;
+          continue;
+        }
+        if (!live.try_emplace(allocaOp.getResult(), size.getSExtValue())
+                 .second) {
+          // Allocated again around a loop while still live; the total depends
+          // on the trip count.
+          peak.dynamic = true;
+          continue;
+        }
+        liveSize += size.getSExtValue();
+      } else if (auto deallocaOp =
+                     dyn_cast<IREE::Stream::ResourceDeallocaOp>(op)) {
+        auto it = live.find(deallocaOp.getOperand());
+        if (it != live.end()) {
+          liveSize -= it->second;
+          live.erase(it);
+        }
+      } else if (auto callOp = dyn_cast<CallOpInterface>(op)) {
+        auto callableOp = dyn_cast_or_null<CallableOpInterface>(
+            callOp.resolveCallable(&symbolTables));
+        if (!callableOp) {
+          peak.dynamic = true;
+          continue;
+        }
+        auto calleePeak = lookupCallable(callableOp);
+        peak.size = std::max(peak.size, liveSize + calleePeak.size);
+        peak.dynamic |= calleePeak.dynamic;
+      } else if (op.getNumRegions() > 0 &&
+                 !isa<IREE::Stream::CmdExecuteOp>(op)) {
+        // Structured control flow: take the worst case of any region.
+        for (auto &nestedRegion : op.getRegions()) {
+          auto nestedPeak = computeRegionPeak(nestedRegion, live);
+          peak.size = std::max(peak.size, nestedPeak.size);
+          peak.dynamic |= nestedPeak.dynamic;
+        }
+      }
+      peak.size = std::max(peak.size, liveSize);
+    }
+  }
+
+  SymbolTableCollection symbolTables;
+  DenseMap<Operation *, PeakMemory> callablePeaks;
+  DenseSet<Operation *> activeCallables;
+};
+
+// Adds or overrides the |name| entry in the reflection dictionary of |op|.
+static void setReflectionAttr(Operation *op, StringRef name, Attribute value) {
+  NamedAttrList attrs;
+  if (auto existingAttr =
+          op->getAttrOfType<DictionaryAttr>("iree.reflection")) {
+    attrs.assign(existingAttr.getValue());
+  }
+  attrs.set(name, value);
+  op->setAttr("iree.reflection", attrs.getDictionary(op->getContext()));
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-annotate-peak-memory
+//===----------------------------------------------------------------------===//
+
+class AnnotatePeakMemoryPass
+    : public AnnotatePeakMemoryBase<AnnotatePeakMemoryPass> {
+ public:
+  AnnotatePeakMemoryPass() = default;
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    PeakMemoryAnalysis analysis;
+    for (auto callableOp : moduleOp.getOps<CallableOpInterface>()) {
+      auto symbolOp = dyn_cast<SymbolOpInterface>(callableOp.getOperation());
+      if (!symbolOp || !symbolOp.isPublic()) continue;
+      auto peak = analysis.lookupCallable(callableOp);
+      LLVM_DEBUG(llvm::dbgs()
+                 << "@" << symbolOp.getName() << " peak transient memory "
+                 << (peak.dynamic ? ">= " : "") << peak.size << " B\n");
+      if (peak.size == 0 && !peak.dynamic) continue;
+
+      // Reflection attributes must be strings.
+      Builder builder(moduleOp.getContext());
+      setReflectionAttr(callableOp, "iree.memory.peak_transient_size",
+                        builder.getStringAttr(std::to_string(peak.size)));
+      if (peak.dynamic) {
+        setReflectionAttr(callableOp,
+                          "iree.memory.peak_transient_size_dynamic",
+                          builder.getStringAttr("true"));
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createAnnotatePeakMemoryPass() {
+  return std::make_unique<AnnotatePeakMemoryPass>();
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <utility>
 
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
@@ -55,6 +56,9 @@ struct UsageInfo {
   // stream.timepoint.await ops indicating host/device synchronization.
   SmallVector<IREE::Stream::TimepointAwaitOp> awaitOps;
 
+  // Public functions that may carry peak memory reflection metadata.
+  SmallVector<FunctionOpInterface> publicFuncOps;
+
   void analyze(mlir::ModuleOp moduleOp) {
     SymbolTable symbolTable(moduleOp);
     for (auto globalOp : moduleOp.getOps<IREE::Util::GlobalOp>()) {
@@ -66,6 +70,10 @@ struct UsageInfo {
       executableOps[executableOp.getName()] = executableOp;
     }
     for (auto funcLikeOp : moduleOp.getOps<FunctionOpInterface>()) {
+      if (SymbolTable::getSymbolVisibility(funcLikeOp) ==
+          SymbolTable::Visibility::Public) {
+        publicFuncOps.push_back(funcLikeOp);
+      }
       funcLikeOp.walk([&](Operation *op) {
         TypeSwitch<Operation *>(op)
             .Case<IREE::Stream::ResourceAllocaOp>(
@@ -106,11 +114,14 @@ struct Statistics {
   size_t submissionCount = 0;
   int64_t transientSize = 0;
   bool transientSizeDynamic = false;
+  int64_t peakTransientSize = 0;
+  bool peakTransientSizeDynamic = false;
   // TODO(benvanik): add fill/copy sizes (when possible).
   size_t fillCount = 0;
   size_t copyCount = 0;
   size_t collectiveCount = 0;
   size_t dispatchCount = 0;
+  size_t maxDispatchesPerSubmission = 0;
 
   // Executables:
   size_t executableCount = 0;
@@ -147,7 +158,21 @@ struct Statistics {
         transientSizeDynamic = true;
       }
     }
+    for (auto funcOp : usageInfo.publicFuncOps) {
+      auto reflectionAttr =
+          funcOp->getAttrOfType<DictionaryAttr>("iree.reflection");
+      if (!reflectionAttr) continue;
+      auto sizeAttr = reflectionAttr.getAs<StringAttr>(
+          "iree.memory.peak_transient_size");
+      int64_t size = 0;
+      if (!sizeAttr || sizeAttr.getValue().getAsInteger(10, size)) continue;
+      peakTransientSize = std::max(peakTransientSize, size);
+      if (reflectionAttr.get("iree.memory.peak_transient_size_dynamic")) {
+        peakTransientSizeDynamic = true;
+      }
+    }
     for (auto executeOp : usageInfo.executeOps) {
+      size_t submissionDispatchCount = 0;
       executeOp.walk([&](Operation *op) {
         TypeSwitch<Operation *>(op)
             .Case<IREE::Stream::CmdFillOp>([&](auto op) { ++fillCount; })
@@ -155,8 +180,11 @@ struct Statistics {
             .Case<IREE::Stream::CmdCollectiveOp>(
                 [&](auto op) { ++collectiveCount; })
             .Case<IREE::Stream::CmdDispatchOp>(
-                [&](auto op) { ++dispatchCount; });
+                [&](auto op) { ++submissionDispatchCount; });
       });
+      dispatchCount += submissionDispatchCount;
+      maxDispatchesPerSubmission =
+          std::max(maxDispatchesPerSubmission, submissionDispatchCount);
     }
 
     // Executables:
@@ -226,11 +254,16 @@ static void prettyPrintStatistics(const UsageInfo &usageInfo,
   os << llvm::formatv(
       "{0}{1} B ({2:F2} MiB)\n", stats.transientSizeDynamic ? "minimum " : "",
       stats.transientSize, stats.transientSize / (1 * 1024 * 1024.0f));
+  os << llvm::formatv(
+      "// Peak Memory: {0}{1} B ({2:F2} MiB) transient\n",
+      stats.peakTransientSizeDynamic ? "minimum " : "",
+      stats.peakTransientSize, stats.peakTransientSize / (1 * 1024 * 1024.0f));
 
   os << llvm::formatv("//   DMA Fills: {0}\n", stats.fillCount);
   os << llvm::formatv("//  DMA Copies: {0}\n", stats.copyCount);
   os << llvm::formatv("// Collectives: {0}\n", stats.collectiveCount);
-  os << llvm::formatv("//  Dispatches: {0}\n", stats.dispatchCount);
+  os << llvm::formatv("//  Dispatches: {0}, at most {1} per submission\n",
+                      stats.dispatchCount, stats.maxDispatchesPerSubmission);
 
   os << llvm::formatv(
       "// Executables: {0}, {1}% reuse\n", stats.executableCount,
@@ -384,7 +417,7 @@ static void dumpAggregateCSVTable(const UsageInfo &usageInfo,
   Statistics stats;
   stats.analyze(usageInfo);
 
-  os << R"("Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables")";
+  os << R"("Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Peak Transient Size","Fills","Copies","Dispatches","Max Dispatches/Submission","Executables")";
   os << "\n";
 
   // Globals:
@@ -396,9 +429,10 @@ static void dumpAggregateCSVTable(const UsageInfo &usageInfo,
   os << llvm::formatv("{0},", stats.awaitCount);
 
   // Execution:
-  os << llvm::formatv("{0},{1},{2},{3},{4},", stats.submissionCount,
-                      stats.transientSize, stats.fillCount, stats.copyCount,
-                      stats.dispatchCount);
+  os << llvm::formatv("{0},{1},{2},{3},{4},{5},{6},", stats.submissionCount,
+                      stats.transientSize, stats.peakTransientSize,
+                      stats.fillCount, stats.copyCount, stats.dispatchCount,
+                      stats.maxDispatchesPerSubmission);
 
   // Executables:
   os << llvm::formatv("{0}", stats.executableCount);
@@ -516,9 +550,13 @@ static void dumpAggregateJSONStructure(const UsageInfo &usageInfo,
   os << "  \"execution\": {\n";
   os << llvm::formatv(kvPair, "submission-count", stats.submissionCount);
   os << llvm::formatv(kvPair, "transient-memory-size", stats.transientSize);
+  os << llvm::formatv(kvPair, "peak-transient-memory-size",
+                      stats.peakTransientSize);
   os << llvm::formatv(kvPair, "fill-count", stats.fillCount);
   os << llvm::formatv(kvPair, "copy-count", stats.copyCount);
-  os << llvm::formatv(kvPairNoComma, "dispatch-count", stats.dispatchCount);
+  os << llvm::formatv(kvPair, "dispatch-count", stats.dispatchCount);
+  os << llvm::formatv(kvPairNoComma, "max-dispatches-per-submission",
+                      stats.maxDispatchesPerSubmission);
   os << "  },\n";
 
   os << "  \"executable\": {\n";
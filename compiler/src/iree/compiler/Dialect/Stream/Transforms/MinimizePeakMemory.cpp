@@ -0,0 +1,377 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-minimize-peak-memory"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Execution region memory model
+//===----------------------------------------------------------------------===//
+
+// A resource allocated by an op within an execution region along with all
+// ops in the region that use it (or any value tied to it).
+struct RegionBuffer {
+  // Op producing the buffer.
+  Operation *definingOp = nullptr;
+  // Total size of the buffer in bytes.
+  int64_t size = 0;
+  // True if the buffer is yielded from the region and must remain live until
+  // the end of the region.
+  bool escapes = false;
+  // Ops within the region using the buffer.
+  SetVector<Operation *> users;
+};
+
+// Models the resources allocated within an execution region.
+// Only regions where all allocation sizes are constant can be modeled.
+struct RegionMemoryModel {
+  // All ops in the region in their original order (excluding the terminator).
+  SmallVector<Operation *> ops;
+  // All buffers allocated within the region.
+  SmallVector<RegionBuffer> buffers;
+  // Buffers allocated by each op.
+  DenseMap<Operation *, SmallVector<unsigned>> allocatedBuffers;
+  // Buffers used by each op.
+  DenseMap<Operation *, SmallVector<unsigned>> usedBuffers;
+
+  static Optional<RegionMemoryModel> build(Block *block);
+};
+
+Optional<RegionMemoryModel> RegionMemoryModel::build(Block *block) {
+  RegionMemoryModel model;
+  DenseMap<Value, unsigned> bufferIds;
+  for (auto &op : block->without_terminator()) {
+    model.ops.push_back(&op);
+    auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(op);
+    auto sizeAwareOp = dyn_cast<IREE::Util::SizeAwareOpInterface>(op);
+    for (auto result : op.getResults()) {
+      if (!result.getType().isa<IREE::Stream::ResourceType>()) continue;
+
+      // Results tied to operands reuse the operand storage. Operands captured
+      // from outside of the region are not counted.
+      if (auto tiedOperand =
+              tiedOp ? tiedOp.getTiedResultOperand(result) : Value{}) {
+        auto it = bufferIds.find(tiedOperand);
+        if (it != bufferIds.end()) bufferIds[result] = it->second;
+        continue;
+      }
+
+      APInt size;
+      if (!sizeAwareOp ||
+          !matchPattern(sizeAwareOp.getResultSize(result.getResultNumber()),
+                        m_ConstantInt(&size))) {
+        LLVM_DEBUG({
+          llvm::dbgs() << "Unable to model dynamically sized result of ";
+          op.print(llvm::dbgs(), OpPrintingFlags().skipRegions());
+          llvm::dbgs() << "\n";
+        });
+        return llvm::None;
+      }
+      unsigned bufferId = model.buffers.size();
+      bufferIds[result] = bufferId;
+      RegionBuffer buffer;
+      buffer.definingOp = &op;
+      buffer.size = size.getSExtValue();
+      model.buffers.push_back(std::move(buffer));
+      model.allocatedBuffers[&op].push_back(bufferId);
+    }
+  }
+
+  for (auto it : bufferIds) {
+    auto &buffer = model.buffers[it.second];
+    for (auto *user : it.first.getUsers()) {
+      auto *blockUser = block->findAncestorOpInBlock(*user);
+      if (!blockUser) continue;
+      if (blockUser->hasTrait<OpTrait::IsTerminator>()) {
+        buffer.escapes = true;
+      } else if (buffer.users.insert(blockUser)) {
+        model.usedBuffers[blockUser].push_back(it.second);
+      }
+    }
+  }
+  return model;
+}
+
+// Returns the peak number of bytes live when executing the ops of |model|
+// with the step assigned to them in |stepOf|. All ops within the same step are
+// assumed to execute concurrently and buffers are released only after all of
+// their users have completed.
+static int64_t computePeakLiveBytes(const RegionMemoryModel &model,
+                                    const DenseMap<Operation *, int> &stepOf,
+                                    int stepCount) {
+  SmallVector<int64_t> deltas(stepCount + 1, 0);
+  for (auto &buffer : model.buffers) {
+    int allocStep = stepOf.lookup(buffer.definingOp);
+    int freeStep = stepCount;
+    if (!buffer.escapes) {
+      freeStep = allocStep + 1;
+      for (auto *user : buffer.users) {
+        freeStep = std::max(freeStep, stepOf.lookup(user) + 1);
+      }
+    }
+    deltas[allocStep] += buffer.size;
+    deltas[freeStep] -= buffer.size;
+  }
+  int64_t liveBytes = 0;
+  int64_t peakBytes = 0;
+  for (int64_t delta : deltas) {
+    liveBytes += delta;
+    peakBytes = std::max(peakBytes, liveBytes);
+  }
+  return peakBytes;
+}
+
+// Returns the peak number of bytes live when executing |order| serially.
+static int64_t computeSerialPeakLiveBytes(const RegionMemoryModel &model,
+                                          ArrayRef<Operation *> order) {
+  DenseMap<Operation *, int> stepOf;
+  for (auto op : llvm::enumerate(order)) {
+    stepOf[op.value()] = op.index();
+  }
+  return computePeakLiveBytes(model, stepOf, order.size());
+}
+
+// Returns the peak number of bytes live when the waves in |waveSet| execute in
+// order with all ops within each wave executing concurrently.
+static int64_t computeConcurrentPeakLiveBytes(const RegionMemoryModel &model,
+                                              PartitionSet &waveSet) {
+  DenseMap<Operation *, int> stepOf;
+  for (auto wave : llvm::enumerate(waveSet.partitions)) {
+    for (auto *op : wave.value().ops) {
+      stepOf.try_emplace(op, wave.index());
+    }
+  }
+  int stepCount = std::max<int>(waveSet.size(), 1);
+  // Ops not assigned to a wave (constants, metadata, etc) are placed with
+  // their first user so that we don't extend the lifetime of what they
+  // allocate.
+  for (auto *op : llvm::reverse(model.ops)) {
+    if (stepOf.count(op)) continue;
+    int step = stepCount - 1;
+    for (auto *user : op->getUsers()) {
+      auto it = stepOf.find(user);
+      if (it != stepOf.end()) step = std::min(step, it->second);
+    }
+    stepOf[op] = step;
+  }
+  return computePeakLiveBytes(model, stepOf, stepCount);
+}
+
+// Returns a topological order of the ops in |model| that greedily minimizes
+// the bytes live at each step: of all ready ops the one that allocates the
+// least and releases the most is scheduled next, with ties broken by the
+// original program order.
+static SmallVector<Operation *> computeMinPeakMemoryOrder(
+    const RegionMemoryModel &model) {
+  DenseMap<Operation *, unsigned> originalIndex;
+  for (auto op : llvm::enumerate(model.ops)) {
+    originalIndex[op.value()] = op.index();
+  }
+
+  // Build the dependency graph. In addition to the SSA def-use edges any op
+  // updating a resource in-place must run after all other users of that
+  // resource.
+  DenseMap<Operation *, SetVector<Operation *>> successors;
+  DenseMap<Operation *, unsigned> pendingPredecessors;
+  auto addEdge = [&](Operation *from, Operation *to) {
+    if (from == to || !originalIndex.count(from)) return;
+    if (successors[from].insert(to)) ++pendingPredecessors[to];
+  };
+  Block *block = model.ops.front()->getBlock();
+  for (auto *op : model.ops) {
+    op->walk([&](Operation *nestedOp) {
+      for (auto operand : nestedOp->getOperands()) {
+        if (auto *definingOp = operand.getDefiningOp()) {
+          if (auto *blockOp = block->findAncestorOpInBlock(*definingOp)) {
+            addEdge(blockOp, op);
+          }
+        }
+      }
+    });
+    auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(op);
+    if (!tiedOp) continue;
+    for (auto result : op->getResults()) {
+      auto tiedOperand = tiedOp.getTiedResultOperand(result);
+      if (!tiedOperand) continue;
+      for (auto *user : tiedOperand.getUsers()) {
+        auto *blockUser = block->findAncestorOpInBlock(*user);
+        if (blockUser && blockUser->isBeforeInBlock(op)) {
+          addEdge(blockUser, op);
+        }
+      }
+    }
+  }
+
+  // Number of users of each buffer not yet scheduled.
+  SmallVector<unsigned> pendingUsers;
+  pendingUsers.reserve(model.buffers.size());
+  for (auto &buffer : model.buffers) {
+    pendingUsers.push_back(buffer.users.size());
+  }
+
+  auto computeDelta = [&](Operation *op) {
+    int64_t delta = 0;
+    for (unsigned bufferId : model.allocatedBuffers.lookup(op)) {
+      delta += model.buffers[bufferId].size;
+    }
+    for (unsigned bufferId : model.usedBuffers.lookup(op)) {
+      auto &buffer = model.buffers[bufferId];
+      if (!buffer.escapes && pendingUsers[bufferId] == 1) {
+        delta -= buffer.size;
+      }
+    }
+    return delta;
+  };
+
+  SmallVector<Operation *> readyOps;
+  for (auto *op : model.ops) {
+    if (!pendingPredecessors.lookup(op)) readyOps.push_back(op);
+  }
+  SmallVector<Operation *> order;
+  order.reserve(model.ops.size());
+  while (!readyOps.empty()) {
+    auto bestIt = readyOps.begin();
+    int64_t bestDelta = computeDelta(*bestIt);
+    for (auto it = std::next(readyOps.begin()); it != readyOps.end(); ++it) {
+      int64_t delta = computeDelta(*it);
+      if (delta < bestDelta ||
+          (delta == bestDelta &&
+           originalIndex[*it] < originalIndex[*bestIt])) {
+        bestIt = it;
+        bestDelta = delta;
+      }
+    }
+    auto *op = *bestIt;
+    readyOps.erase(bestIt);
+    order.push_back(op);
+    for (unsigned bufferId : model.usedBuffers.lookup(op)) {
+      --pendingUsers[bufferId];
+    }
+    auto it = successors.find(op);
+    if (it == successors.end()) continue;
+    for (auto *successor : it->second) {
+      if (--pendingPredecessors[successor] == 0) readyOps.push_back(successor);
+    }
+  }
+  assert(order.size() == model.ops.size() && "dependency cycle in region");
+  return order;
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-minimize-peak-memory
+//===----------------------------------------------------------------------===//
+
+class MinimizePeakMemoryPass
+    : public MinimizePeakMemoryBase<MinimizePeakMemoryPass> {
+ public:
+  MinimizePeakMemoryPass() = default;
+  MinimizePeakMemoryPass(int64_t budget) { this->budget = budget; }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto parentOp = getOperation();
+    if (!parentOp.getCallableRegion() ||
+        parentOp.getCallableRegion()->empty()) {
+      return;
+    }
+    parentOp.getCallableRegion()->walk(
+        [&](IREE::Stream::AsyncExecuteOp executeOp) {
+          runOnRegion(executeOp);
+        });
+  }
+
+ private:
+  void runOnRegion(IREE::Stream::AsyncExecuteOp executeOp) {
+    if (executeOp.getBody().empty()) return;
+    auto *block = &executeOp.getBody().front();
+    auto model = RegionMemoryModel::build(block);
+    if (!model || model->ops.empty()) return;
+
+    // Estimate the peak memory the region will need once partitioned for
+    // concurrency. If it is within the budget there's nothing to do.
+    auto configAttr = IREE::Stream::PartitioningConfigAttr::lookup(executeOp);
+    auto waveSet = partitionRegionConcurrency(configAttr, block);
+    int64_t originalPeak = computeSerialPeakLiveBytes(*model, model->ops);
+    int64_t concurrentPeak =
+        waveSet.empty() ? originalPeak
+                        : computeConcurrentPeakLiveBytes(*model, waveSet);
+    if (concurrentPeak <= budget) return;
+
+    // Reorder to reduce the peak serial usage, if possible.
+    auto order = computeMinPeakMemoryOrder(*model);
+    int64_t reorderedPeak = computeSerialPeakLiveBytes(*model, order);
+    LLVM_DEBUG(llvm::dbgs()
+               << "Execution region peak: " << concurrentPeak
+               << " B concurrent, " << originalPeak << " B serial, "
+               << reorderedPeak << " B reordered (budget " << budget
+               << " B)\n");
+    if (reorderedPeak < originalPeak) {
+      auto *terminatorOp = block->getTerminator();
+      for (auto *op : order) op->moveBefore(terminatorOp);
+      ++numRegionsReordered;
+    } else {
+      reorderedPeak = originalPeak;
+    }
+
+    // Only allow concurrency when it does not extend live ranges beyond the
+    // order we've chosen.
+    auto favorAttr = IREE::Stream::FavorAttr::get(
+        &getContext(), IREE::Stream::Favor::MinPeakMemory);
+    executeOp->setAttr("stream.partitioning",
+                       IREE::Stream::PartitioningConfigAttr::get(favorAttr));
+    ++numRegionsSerialized;
+
+    if (reorderedPeak > budget) {
+      executeOp.emitWarning()
+          << "execution region requires at least " << reorderedPeak
+          << " bytes of transient memory which exceeds the budget of "
+          << budget << " bytes";
+    }
+  }
+
+  Statistic numRegionsSerialized{
+      this, "execution region(s) serialized",
+      "Number of execution regions with concurrency limited to fit the budget"};
+  Statistic numRegionsReordered{
+      this, "execution region(s) reordered",
+      "Number of execution regions reordered to reduce peak memory"};
+};
+
+}  // namespace
+
+std::unique_ptr<InterfacePass<CallableOpInterface>>
+createMinimizePeakMemoryPass(int64_t budget) {
+  return std::make_unique<MinimizePeakMemoryPass>(budget);
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -152,6 +152,12 @@ void buildStreamAsyncPassPipeline(OpPassManager &passManager,
   FunctionLikeNest(passManager)
       // Combine async work into execution regions.
       .addPass(IREE::Stream::createScheduleExecutionPass)
+      // Reorder execution regions that would exceed the memory budget and
+      // limit their concurrency.
+      .addPredicatedPass(transformOptions.transientMemoryBudget > 0, [&]() {
+        return IREE::Stream::createMinimizePeakMemoryPass(
+            transformOptions.transientMemoryBudget);
+      })
       // Group concurrently executable work into waves.
       .addPass(IREE::Stream::createScheduleConcurrencyPass);
 
@@ -309,6 +315,10 @@ void buildStreamTransformPassPipeline(
   buildStreamAsyncPassPipeline(passManager, transformOptions);
   buildStreamCmdPassPipeline(passManager, transformOptions);
 
+  // Record the peak transient memory required by each exported function so
+  // that the runtime can reserve it ahead of time.
+  passManager.addPass(IREE::Stream::createAnnotatePeakMemoryPass());
+
   // Dump statistics before the deeper optimizations happen.
   // Optimizations such as dispatch operand fusion remove information we can use
   // to determine memory usage by dispatches.
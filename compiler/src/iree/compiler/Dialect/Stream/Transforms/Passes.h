@@ -35,6 +35,16 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
       llvm::cl::init(true),
   };
 
+  Option<int64_t> transientMemoryBudget{
+      *this,
+      "transient-memory-budget",
+      llvm::cl::desc(
+          "Peak number of bytes of transient memory an execution region may "
+          "use before concurrency is traded for lower memory usage; 0 to "
+          "always favor concurrency."),
+      llvm::cl::init(0),
+  };
+
   Option<DumpOutputFormat> dumpStatisticsFormat{
       *this,
       "dump-statistics-format",
@@ -123,6 +133,8 @@ std::unique_ptr<InterfacePass<CallableOpInterface>>
 createScheduleExecutionPass();
 std::unique_ptr<InterfacePass<CallableOpInterface>>
 createScheduleConcurrencyPass();
+std::unique_ptr<InterfacePass<CallableOpInterface>>
+createMinimizePeakMemoryPass(int64_t budget = 0);
 
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createPropagateTimepointsPass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createElideTimepointsPass();
@@ -137,6 +149,7 @@ createScheduleAllocationPass();
 std::unique_ptr<InterfacePass<CallableOpInterface>> createPackConstantsPass();
 std::unique_ptr<InterfacePass<CallableOpInterface>> createPackAllocationsPass();
 std::unique_ptr<InterfacePass<CallableOpInterface>> createLayoutSlicesPass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createAnnotatePeakMemoryPass();
 
 //===----------------------------------------------------------------------===//
 // Memoization
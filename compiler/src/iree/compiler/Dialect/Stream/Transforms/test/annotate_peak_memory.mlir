@@ -0,0 +1,111 @@
+// RUN: iree-opt --split-input-file --iree-stream-annotate-peak-memory %s | FileCheck %s
+
+// Tests that allocations freed before the next is made do not overlap.
+
+// CHECK-LABEL: @sequentialAllocations
+// CHECK-SAME: iree.reflection = {iree.abi = "abi", iree.memory.peak_transient_size = "200"}
+func.func @sequentialAllocations() -> !stream.timepoint attributes {iree.reflection = {iree.abi = "abi"}} {
+  %c100 = arith.constant 100 : index
+  %c200 = arith.constant 200 : index
+  %0:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c100} => !stream.timepoint
+  %1 = stream.resource.dealloca await(%0#1) => %0#0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  %2:2 = stream.resource.alloca uninitialized await(%1) => !stream.resource<transient>{%c200} => !stream.timepoint
+  %3 = stream.resource.dealloca await(%2#1) => %2#0 : !stream.resource<transient>{%c200} => !stream.timepoint
+  return %3 : !stream.timepoint
+}
+
+// -----
+
+// Tests that overlapping allocations and those made by callees accumulate.
+
+// CHECK-LABEL: @callee
+// CHECK-NOT: iree.reflection
+func.func private @callee() -> !stream.timepoint {
+  %c64 = arith.constant 64 : index
+  %0:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c64} => !stream.timepoint
+  %1 = stream.resource.dealloca await(%0#1) => %0#0 : !stream.resource<transient>{%c64} => !stream.timepoint
+  return %1 : !stream.timepoint
+}
+
+// CHECK-LABEL: @overlappingAllocations
+// CHECK-SAME: iree.reflection = {iree.memory.peak_transient_size = "364"}
+func.func @overlappingAllocations() -> !stream.timepoint {
+  %c100 = arith.constant 100 : index
+  %c200 = arith.constant 200 : index
+  %0:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c100} => !stream.timepoint
+  %1:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c200} => !stream.timepoint
+  %2 = call @callee() : () -> !stream.timepoint
+  %3 = stream.resource.dealloca await(%0#1) => %0#0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  %4 = stream.resource.dealloca await(%1#1) => %1#0 : !stream.resource<transient>{%c200} => !stream.timepoint
+  %5 = stream.timepoint.join max(%2, %3, %4) => !stream.timepoint
+  return %5 : !stream.timepoint
+}
+
+// -----
+
+// Tests that dynamically sized allocations are flagged.
+
+// CHECK-LABEL: @dynamicAllocation
+// CHECK-SAME: iree.reflection = {iree.memory.peak_transient_size = "16", iree.memory.peak_transient_size_dynamic = "true"}
+func.func @dynamicAllocation(%size: index) -> !stream.timepoint {
+  %c16 = arith.constant 16 : index
+  %0:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c16} => !stream.timepoint
+  %1:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  %2 = stream.resource.dealloca await(%1#1) => %1#0 : !stream.resource<transient>{%size} => !stream.timepoint
+  %3 = stream.resource.dealloca await(%0#1) => %0#0 : !stream.resource<transient>{%c16} => !stream.timepoint
+  %4 = stream.timepoint.join max(%2, %3) => !stream.timepoint
+  return %4 : !stream.timepoint
+}
+
+// -----
+
+// Tests that functions without transient allocations are not annotated.
+
+// CHECK-LABEL: @noAllocations
+// CHECK-NOT: iree.reflection
+func.func @noAllocations(%arg0: !stream.timepoint) -> !stream.timepoint {
+  return %arg0 : !stream.timepoint
+}
+
+// -----
+
+// Tests that allocations live across branches are counted in successors.
+
+// CHECK-LABEL: @branchingAllocations
+// CHECK-SAME: iree.reflection = {iree.memory.peak_transient_size = "300"}
+func.func @branchingAllocations(%cond: i1) -> !stream.timepoint {
+  %c50 = arith.constant 50 : index
+  %c100 = arith.constant 100 : index
+  %c200 = arith.constant 200 : index
+  %0:2 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c100} => !stream.timepoint
+  cf.cond_br %cond, ^bb1, ^bb2
+^bb1:
+  %1:2 = stream.resource.alloca uninitialized await(%0#1) => !stream.resource<transient>{%c200} => !stream.timepoint
+  %2 = stream.resource.dealloca await(%1#1) => %1#0 : !stream.resource<transient>{%c200} => !stream.timepoint
+  cf.br ^bb3(%2 : !stream.timepoint)
+^bb2:
+  %3:2 = stream.resource.alloca uninitialized await(%0#1) => !stream.resource<transient>{%c50} => !stream.timepoint
+  %4 = stream.resource.dealloca await(%3#1) => %3#0 : !stream.resource<transient>{%c50} => !stream.timepoint
+  cf.br ^bb3(%4 : !stream.timepoint)
+^bb3(%5: !stream.timepoint):
+  %6 = stream.resource.dealloca await(%5) => %0#0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  return %6 : !stream.timepoint
+}
+
+// -----
+
+// Tests that allocations made again around a loop while still live are
+// flagged as dynamic.
+
+// CHECK-LABEL: @loopAllocations
+// CHECK-SAME: iree.reflection = {iree.memory.peak_transient_size = "64", iree.memory.peak_transient_size_dynamic = "true"}
+func.func @loopAllocations(%cond: i1) -> !stream.timepoint {
+  %c64 = arith.constant 64 : index
+  %0 = stream.timepoint.immediate => !stream.timepoint
+  cf.br ^bb1(%0 : !stream.timepoint)
+^bb1(%1: !stream.timepoint):
+  %2:2 = stream.resource.alloca uninitialized await(%1) => !stream.resource<transient>{%c64} => !stream.timepoint
+  cf.cond_br %cond, ^bb1(%2#1 : !stream.timepoint), ^bb2
+^bb2:
+  return %2#1 : !stream.timepoint
+}
@@ -6,15 +6,16 @@
 // CHECK-PRETTY:   Variables: 0, 0 B
 // CHECK-PRETTY:  D->H Syncs: 2
 // CHECK-PRETTY: Submissions: 3, using cumulative 0 B
+// CHECK-PRETTY: Peak Memory: 0 B (0.00 MiB) transient
 // CHECK-PRETTY:   DMA Fills: 0
 // CHECK-PRETTY:  DMA Copies: 2
 // CHECK-PRETTY: Collectives: 0
-// CHECK-PRETTY:  Dispatches: 3
+// CHECK-PRETTY:  Dispatches: 3, at most 3 per submission
 // CHECK-PRETTY: Executables: 2, 33% reuse
 
 // CHECK-CSV: ; Aggregate Statistics
-// CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables"
-// CHECK-CSV: 1,0,0,0,2,3,0,0,2,3,2
+// CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Peak Transient Size","Fills","Copies","Dispatches","Max Dispatches/Submission","Executables"
+// CHECK-CSV: 1,0,0,0,2,3,0,0,0,2,3,3,2
 // CHECK-CSV: ; Execution
 // CHECK-CSV: "Depth","Command","Symbol","Length","Invocations","Workload","Operands","Resources"
 // CHECK-CSV: 0,"copy",,192,,,,
@@ -0,0 +1,59 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="builtin.module(func.func(iree-stream-minimize-peak-memory{budget=1500}))" %s | FileCheck %s
+
+// Tests that a region that would exceed the budget when run concurrently is
+// reordered such that each large transient is consumed before the next is
+// produced and that its concurrency is limited to that order.
+
+// CHECK-LABEL: @reorderOverBudget
+func.func @reorderOverBudget() -> !stream.resource<external> {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c1024 = arith.constant 1024 : index
+  %c1_i32 = arith.constant 1 : i32
+  %c2_i32 = arith.constant 2 : i32
+  // CHECK: stream.async.execute
+  %results, %result_timepoint = stream.async.execute with() -> !stream.resource<external>{%c4} {
+    // CHECK: %[[SPLAT0:.+]] = stream.async.splat %c1_i32
+    %0 = stream.async.splat %c1_i32 : i32 -> !stream.resource<transient>{%c1024}
+    %1 = stream.async.splat %c2_i32 : i32 -> !stream.resource<transient>{%c1024}
+    // CHECK-NEXT: %[[REDUCE0:.+]] = stream.async.dispatch @ex::@reduce[%c1, %c1, %c1](%[[SPLAT0]]
+    %2 = stream.async.dispatch @ex::@reduce[%c1, %c1, %c1](%0[%c0 to %c1024 for %c1024]) : (!stream.resource<transient>{%c1024}) -> !stream.resource<transient>{%c4}
+    // CHECK-NEXT: %[[SPLAT1:.+]] = stream.async.splat %c2_i32
+    // CHECK-NEXT: %[[REDUCE1:.+]] = stream.async.dispatch @ex::@reduce[%c1, %c1, %c1](%[[SPLAT1]]
+    %3 = stream.async.dispatch @ex::@reduce[%c1, %c1, %c1](%1[%c0 to %c1024 for %c1024]) : (!stream.resource<transient>{%c1024}) -> !stream.resource<transient>{%c4}
+    // CHECK-NEXT: %[[ADD:.+]] = stream.async.dispatch @ex::@add[%c1, %c1, %c1](%[[REDUCE0]]{{.+}}, %[[REDUCE1]]
+    %4 = stream.async.dispatch @ex::@add[%c1, %c1, %c1](%2[%c0 to %c4 for %c4], %3[%c0 to %c4 for %c4]) : (!stream.resource<transient>{%c4}, !stream.resource<transient>{%c4}) -> !stream.resource<external>{%c4}
+    // CHECK-NEXT: stream.yield %[[ADD]]
+    stream.yield %4 : !stream.resource<external>{%c4}
+  // CHECK-NEXT: } => !stream.timepoint attributes {stream.partitioning = #stream.partitioning_config<"min-peak-memory">}
+  } => !stream.timepoint
+  %5 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c4}
+  return %5 : !stream.resource<external>
+}
+
+// -----
+
+// Tests that regions within the budget are left unchanged.
+
+// CHECK-LABEL: @withinBudget
+func.func @withinBudget() -> !stream.resource<external> {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c128 = arith.constant 128 : index
+  %c1_i32 = arith.constant 1 : i32
+  %c2_i32 = arith.constant 2 : i32
+  %results, %result_timepoint = stream.async.execute with() -> !stream.resource<external>{%c4} {
+    // CHECK: stream.async.splat %c1_i32
+    // CHECK-NEXT: stream.async.splat %c2_i32
+    %0 = stream.async.splat %c1_i32 : i32 -> !stream.resource<transient>{%c128}
+    %1 = stream.async.splat %c2_i32 : i32 -> !stream.resource<transient>{%c128}
+    %2 = stream.async.dispatch @ex::@add[%c1, %c1, %c1](%0[%c0 to %c128 for %c128], %1[%c0 to %c128 for %c128]) : (!stream.resource<transient>{%c128}, !stream.resource<transient>{%c128}) -> !stream.resource<external>{%c4}
+    stream.yield %2 : !stream.resource<external>{%c4}
+  // CHECK: } => !stream.timepoint
+  // CHECK-NOT: stream.partitioning
+  } => !stream.timepoint
+  %3 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c4}
+  return %3 : !stream.resource<external>
+}
@@ -7,7 +7,10 @@
 #include "iree/compiler/Dialect/VM/Target/Bytecode/BytecodeModuleTarget.h"
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 
+#include "iree/base/internal/lz4.h"
 #include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
@@ -31,6 +34,7 @@
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Visitors.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
@@ -63,6 +67,17 @@ struct TypeDef {
   std::string full_name;
 };
 
+// Rodata compressed as a sequence of independent LZ4 blocks.
+// See LZ4BlockCompressedDataDef in bytecode_module_def.fbs.
+struct CompressedRodata {
+  // Uncompressed length of each block (except the last, which may be shorter).
+  uint32_t blockLength = 0;
+  // Compressed length of each block in |data|.
+  SmallVector<uint32_t> blockCompressedLengths;
+  // All compressed blocks concatenated.
+  std::vector<uint8_t> data;
+};
+
 // A rodata reference.
 // The archive file is empty if the data is to be embedded in the FlatBuffer.
 struct RodataRef {
@@ -74,6 +89,8 @@ struct RodataRef {
   uint64_t totalSize = 0;
   // Optional reference to the rodata in the file.
   Optional<ArchiveWriter::File> archiveFile;
+  // Optional compressed form of the rodata stored in the archive file.
+  std::shared_ptr<CompressedRodata> compressed;
 };
 
 }  // namespace
@@ -94,6 +111,56 @@ static StringRef mimeTypeToFileExtension(StringRef mimeType) {
       .Default(".bin");
 }
 
+// Compresses |value| as a sequence of independent LZ4 blocks of
+// |blockLength| uncompressed bytes each. Blocks are compressed in parallel.
+static FailureOr<std::shared_ptr<CompressedRodata>> compressRodata(
+    Location loc, IREE::Util::SerializableAttrInterface value,
+    int64_t blockLength) {
+  if (blockLength <= 0 || blockLength > IREE_LZ4_MAX_BLOCK_LENGTH) {
+    return mlir::emitError(loc)
+           << "invalid rodata compression block size " << blockLength
+           << "; must be in (0, " << IREE_LZ4_MAX_BLOCK_LENGTH << "]";
+  }
+  SmallVector<char> uncompressed;
+  if (failed(value.serializeToVector(llvm::support::endianness::little,
+                                     uncompressed))) {
+    return mlir::emitError(loc) << "failed to serialize rodata for compression";
+  }
+
+  size_t blockSize = static_cast<size_t>(blockLength);
+  size_t blockCount = (uncompressed.size() + blockSize - 1) / blockSize;
+  SmallVector<std::vector<uint8_t>> blocks(blockCount);
+  std::atomic<bool> anyFailed(false);
+  mlir::parallelFor(loc.getContext(), 0, blockCount, [&](size_t i) {
+    size_t offset = i * blockSize;
+    size_t length = std::min(blockSize, uncompressed.size() - offset);
+    auto &block = blocks[i];
+    block.resize(iree_lz4_block_compress_bound(length));
+    iree_host_size_t compressedLength = 0;
+    iree_status_t status = iree_lz4_block_compress(
+        iree_make_const_byte_span(uncompressed.data() + offset, length),
+        iree_make_byte_span(block.data(), block.size()), &compressedLength);
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      anyFailed = true;
+      return;
+    }
+    block.resize(compressedLength);
+  });
+  if (anyFailed) {
+    return mlir::emitError(loc) << "failed to compress rodata";
+  }
+
+  auto compressed = std::make_shared<CompressedRodata>();
+  compressed->blockLength = static_cast<uint32_t>(blockLength);
+  for (auto &block : blocks) {
+    compressed->blockCompressedLengths.push_back(
+        static_cast<uint32_t>(block.size()));
+    compressed->data.insert(compressed->data.end(), block.begin(), block.end());
+  }
+  return compressed;
+}
+
 // Serializes a constant attribute to the FlatBuffer as a binary blob.
 // Returns the size in bytes of the serialized value and the FlatBuffers offset
 // to the uint8 vec containing the data.
@@ -424,12 +491,32 @@ static LogicalResult buildFlatBufferModule(
   for (auto &rodataRef : llvm::reverse(rodataRefs)) {
     if (rodataRef.archiveFile.has_value()) {
       // Data is already in the file at a calculated offset.
+      iree_vm_LZ4BlockCompressedDataDef_ref_t compressionRef = 0;
+      if (rodataRef.compressed) {
+        auto &blockLengths = rodataRef.compressed->blockCompressedLengths;
+        auto blockLengthsRef = flatbuffers_uint32_vec_create(
+            fbb, blockLengths.data(), blockLengths.size());
+        iree_vm_LZ4BlockCompressedDataDef_start(fbb);
+        iree_vm_LZ4BlockCompressedDataDef_uncompressed_length_add(
+            fbb, rodataRef.totalSize);
+        iree_vm_LZ4BlockCompressedDataDef_block_length_add(
+            fbb, rodataRef.compressed->blockLength);
+        iree_vm_LZ4BlockCompressedDataDef_block_compressed_lengths_add(
+            fbb, blockLengthsRef);
+        compressionRef = iree_vm_LZ4BlockCompressedDataDef_end(fbb);
+      }
       iree_vm_RodataSegmentDef_start(fbb);
       iree_vm_RodataSegmentDef_external_data_offset_add(
           fbb, rodataRef.archiveFile->relativeOffset +
                    rodataRef.archiveFile->prefixLength);
       iree_vm_RodataSegmentDef_external_data_length_add(
           fbb, rodataRef.archiveFile->fileLength);
+      if (compressionRef) {
+        iree_vm_RodataSegmentDef_compression_type_add(
+            fbb,
+            iree_vm_CompressionTypeDef_as_LZ4BlockCompressedDataDef(
+                compressionRef));
+      }
       rodataSegmentRefs.push_back(iree_vm_RodataSegmentDef_end(fbb));
     } else {
       // Serialize the embedded data first so that we can reference it.
@@ -650,7 +737,33 @@ LogicalResult translateModuleToBytecode(IREE::VM::ModuleOp moduleOp,
     rodataRef.alignment =
         rodataOp.getAlignment().value_or(kDefaultRodataAlignment);
     rodataRef.totalSize = static_cast<uint64_t>(actualSize);
-    if (storeExternal) {
+    if (storeExternal && targetOptions.rodataCompression ==
+                             BytecodeRodataCompression::kLZ4) {
+      auto compressed = compressRodata(
+          rodataOp.getLoc(), rodataValue,
+          targetOptions.rodataCompressionBlockSize);
+      if (failed(compressed)) return failure();
+      // Only keep the compressed form if it's a win; incompressible data (like
+      // already-compressed executables) is stored as-is so it can be mapped.
+      if ((*compressed)->data.size() < actualSize) {
+        rodataRef.compressed = std::move(*compressed);
+      }
+    }
+    if (storeExternal && rodataRef.compressed) {
+      std::string fileName =
+          (rodataOp.getName() +
+           mimeTypeToFileExtension(rodataOp.getMimeType().value_or("")) +
+           ".lz4blocks")
+              .str();
+      auto compressed = rodataRef.compressed;
+      rodataRef.archiveFile = archiveWriter->declareFile(
+          fileName, rodataRef.alignment, compressed->data.size(),
+          [=](llvm::raw_ostream &os) {
+            os.write(reinterpret_cast<const char *>(compressed->data.data()),
+                     compressed->data.size());
+            return success();
+          });
+    } else if (storeExternal) {
       std::string fileName =
           (rodataOp.getName() +
            mimeTypeToFileExtension(rodataOp.getMimeType().value_or("")))
@@ -732,6 +845,21 @@ void BytecodeTargetOptions::bindOptions(OptionsBinder &binder) {
       llvm::cl::desc(
           "Enables output files to be viewed as zip files for debugging "
           "(only applies to binary targets)"));
+  binder.opt<BytecodeRodataCompression>(
+      "iree-vm-bytecode-rodata-compression", rodataCompression,
+      llvm::cl::cat(vmBytecodeOptionsCategory),
+      llvm::cl::desc("Compression applied to large rodata stored external to "
+                     "the FlatBuffer (only applies to binary targets)"),
+      llvm::cl::values(
+          clEnumValN(BytecodeRodataCompression::kNone, "none",
+                     "Store rodata uncompressed so that it can be mapped"),
+          clEnumValN(BytecodeRodataCompression::kLZ4, "lz4",
+                     "Compress rodata as independent LZ4 blocks")));
+  binder.opt<int64_t>(
+      "iree-vm-bytecode-rodata-compression-block-size",
+      rodataCompressionBlockSize, llvm::cl::cat(vmBytecodeOptionsCategory),
+      llvm::cl::desc("Uncompressed size in bytes of each independently "
+                     "decompressible rodata block"));
 }
 
 }  // namespace VM
@@ -32,6 +32,15 @@ enum class BytecodeOutputFormat {
   kAnnotatedMlirText,
 };
 
+// Defines the compression applied to rodata stored external to the FlatBuffer.
+enum class BytecodeRodataCompression {
+  // Rodata is stored as-is and can be mapped directly from the file.
+  kNone,
+  // Rodata is split into independent LZ4 blocks that are decompressed (in
+  // parallel) when the module is loaded.
+  kLZ4,
+};
+
 // Options that can be provided to bytecode translation.
 struct BytecodeTargetOptions {
   // Format of the module written to the output stream.
@@ -56,6 +65,16 @@ struct BytecodeTargetOptions {
   // should be disabled in release builds.
   bool emitPolyglotZip = true;
 
+  // Compression applied to rodata stored external to the FlatBuffer.
+  // Compressed rodata can no longer be mapped directly from the file and must
+  // be decompressed into host memory when the module is loaded; this trades
+  // load time and memory for smaller deployment artifacts.
+  BytecodeRodataCompression rodataCompression =
+      BytecodeRodataCompression::kNone;
+  // Uncompressed length of each independently compressed rodata block.
+  // Smaller blocks allow for more load-time parallelism at the cost of ratio.
+  int64_t rodataCompressionBlockSize = 1 * 1024 * 1024;
+
   void bindOptions(OptionsBinder &binder);
   using FromFlags = OptionsFromFlags<BytecodeTargetOptions>;
 };
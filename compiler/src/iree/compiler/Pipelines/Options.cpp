@@ -123,6 +123,13 @@ void SchedulingOptions::bindOptions(OptionsBinder &binder) {
                           llvm::cl::desc("File path to write statistics to; or "
                                          "`` for stderr or `-` for stdout."),
                           llvm::cl::cat(category));
+
+  binder.opt<int64_t>(
+      "iree-scheduling-transient-memory-budget", transientMemoryBudget,
+      llvm::cl::desc("Peak number of bytes of transient memory an execution "
+                     "region may use before concurrency is traded for lower "
+                     "memory usage; 0 to always favor concurrency."),
+      llvm::cl::cat(category));
 }
 
 }  // namespace iree_compiler
@@ -120,6 +120,11 @@ struct SchedulingOptions {
   // File path to write statistics to; or `` for stderr or `-` for stdout.
   std::string dumpStatisticsFile = "";
 
+  // Peak number of bytes of transient memory an execution region may use
+  // before concurrency is traded for lower memory usage; 0 to always favor
+  // concurrency.
+  int64_t transientMemoryBudget = 0;
+
   // TODO(benvanik): favor size/speed/etc for partitioning.
   // TODO(benvanik): execution model to optimize for (unified/discrete memory,
   //                 single/multiple processors, etc).
@@ -114,6 +114,7 @@ void buildIREEVMTransformPassPipeline(
   streamOptions.dumpStatisticsFormat =
       (IREE::Stream::DumpOutputFormat)schedulingOptions.dumpStatisticsFormat;
   streamOptions.dumpStatisticsFile = schedulingOptions.dumpStatisticsFile;
+  streamOptions.transientMemoryBudget = schedulingOptions.transientMemoryBudget;
 
   switch (schedulingOptions.executionModel) {
     case SchedulingOptions::ExecutionModel::HostOnly:
@@ -11,6 +11,16 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassInstrumentation.h"
 
+// Traces the enclosing scope as a zone named |name_literal| when compiler
+// tracing is enabled. Used to break down the time spent within long-running
+// passes (such as executable serialization) across threads.
+#if IREE_ENABLE_COMPILER_TRACING && \
+    IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#define IREE_COMPILER_TRACE_SCOPE(name_literal) IREE_TRACE_SCOPE0(name_literal)
+#else
+#define IREE_COMPILER_TRACE_SCOPE(name_literal)
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+
 namespace mlir {
 namespace iree_compiler {
 
@@ -237,6 +237,65 @@ lowerOpWithEncoding(RewriterBase &rewriter, linalg::FillOp fillOp,
   return materializedFillOp;
 }
 
+/// Utility method to convert an elementwise `linalg.generic` on tensors with
+/// encoding to an elementwise `linalg.generic` on the materialized types. All
+/// ranked operands must use identity indexing maps and the same encoding so
+/// that they share a single materialized layout; scalar operands are
+/// broadcast as before.
+static FailureOr<Operation *>
+lowerOpWithEncoding(RewriterBase &rewriter, linalg::GenericOp genericOp,
+                    ValueRange convertedInputOperands,
+                    ValueRange convertedOutputOperands,
+                    MaterializeEncodingFn materializeEncodingFn) {
+  if (!genericOp.hasTensorSemantics() || genericOp.hasIndexSemantics() ||
+      genericOp.getNumParallelLoops() != genericOp.getNumLoops())
+    return failure();
+
+  Attribute encoding;
+  for (OpOperand &operand : genericOp->getOpOperands()) {
+    auto tensorType = operand.get().getType().dyn_cast<RankedTensorType>();
+    AffineMap map = genericOp.getMatchingIndexingMap(&operand);
+    if (!tensorType || tensorType.getRank() == 0) {
+      if (map.getNumResults() != 0)
+        return failure();
+      continue;
+    }
+    if (!map.isIdentity() || !tensorType.getEncoding())
+      return failure();
+    if (!encoding)
+      encoding = tensorType.getEncoding();
+    else if (encoding != tensorType.getEncoding())
+      return failure();
+  }
+  if (!encoding)
+    return failure();
+
+  auto materializedType =
+      convertedOutputOperands[0].getType().cast<RankedTensorType>();
+  int64_t materializedRank = materializedType.getRank();
+  MLIRContext *context = rewriter.getContext();
+  SmallVector<AffineMap> indexingMaps;
+  for (OpOperand &operand : genericOp->getOpOperands()) {
+    AffineMap map = genericOp.getMatchingIndexingMap(&operand);
+    indexingMaps.push_back(
+        map.getNumResults() == 0
+            ? AffineMap::get(materializedRank, 0, {}, context)
+            : AffineMap::getMultiDimIdentityMap(materializedRank, context));
+  }
+  SmallVector<utils::IteratorType> iteratorTypes(materializedRank,
+                                                 utils::IteratorType::parallel);
+  SmallVector<Type> resultTypes;
+  for (Value output : convertedOutputOperands)
+    resultTypes.push_back(output.getType());
+  auto materializedGenericOp = rewriter.create<linalg::GenericOp>(
+      genericOp.getLoc(), resultTypes, convertedInputOperands,
+      convertedOutputOperands, indexingMaps, iteratorTypes);
+  rewriter.cloneRegionBefore(genericOp.getRegion(),
+                             materializedGenericOp.getRegion(),
+                             materializedGenericOp.getRegion().begin());
+  return materializedGenericOp.getOperation();
+}
+
 /// Utility method to convert `tensor.empty` with encoding to a `tensor.empty`
 /// of the materialized type.
 static FailureOr<Operation *>
@@ -439,6 +498,7 @@ void populateMaterializeEncodingPatterns(
   // Add all patterns for converting from encoded type to the materialized type
   patterns.insert<MaterializeDPSOperation<linalg::FillOp>,
                   MaterializeDPSOperation<linalg::MatmulOp>,
+                  MaterializeDPSOperation<linalg::GenericOp>,
                   MaterializeOperation<tensor::EmptyOp>,
                   SetEncodingOpToPackOpConversion,
                   UnsetEncodingOpToPackOpConversion>(typeConverter,
@@ -6,6 +6,8 @@
 
 #include "./hal.h"
 
+#include <memory>
+
 #include "./vm.h"
 #include "iree/base/internal/path.h"
 #include "iree/base/tracing.h"
@@ -43,6 +45,83 @@ static std::string ToHexString(uint32_t value) {
   return ToHexString((const uint8_t*)&value, sizeof(value));
 }
 
+// Returns the Python buffer protocol format code for the given element type or
+// nullptr if there is no direct mapping.
+// See: https://docs.python.org/3/library/struct.html#format-characters
+static const char* GetElementTypeBufferFormat(
+    iree_hal_element_type_t element_type) {
+  switch (element_type) {
+    case IREE_HAL_ELEMENT_TYPE_BOOL_8:
+      return "?";
+    case IREE_HAL_ELEMENT_TYPE_INT_8:
+    case IREE_HAL_ELEMENT_TYPE_SINT_8:
+      return "b";
+    case IREE_HAL_ELEMENT_TYPE_UINT_8:
+      return "B";
+    case IREE_HAL_ELEMENT_TYPE_INT_16:
+    case IREE_HAL_ELEMENT_TYPE_SINT_16:
+      return "h";
+    case IREE_HAL_ELEMENT_TYPE_UINT_16:
+      return "H";
+    case IREE_HAL_ELEMENT_TYPE_INT_32:
+    case IREE_HAL_ELEMENT_TYPE_SINT_32:
+      return "i";
+    case IREE_HAL_ELEMENT_TYPE_UINT_32:
+      return "I";
+    case IREE_HAL_ELEMENT_TYPE_INT_64:
+    case IREE_HAL_ELEMENT_TYPE_SINT_64:
+      return "q";
+    case IREE_HAL_ELEMENT_TYPE_UINT_64:
+      return "Q";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
+      return "e";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_32:
+      return "f";
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_64:
+      return "d";
+    default:
+      return nullptr;
+  }
+}
+
+// Returns an unsigned integer buffer format code matching the storage size of
+// |element_type| for types that have no native Python representation (bf16,
+// opaque types, etc). Returns nullptr if no integer type matches.
+static const char* GetElementTypeRawBufferFormat(
+    iree_hal_element_type_t element_type) {
+  switch (iree_hal_element_dense_byte_count(element_type)) {
+    case 1:
+      return "B";
+    case 2:
+      return "H";
+    case 4:
+      return "I";
+    case 8:
+      return "Q";
+    default:
+      return nullptr;
+  }
+}
+
+// A Python buffer view that has been imported into the HAL. Owned by the HAL
+// buffer wrapping it and released via the buffer release callback.
+struct ImportedPyBuffer {
+  Py_buffer py_view;
+
+  static void Release(void* user_data, iree_hal_buffer_t* buffer) {
+    auto* self = static_cast<ImportedPyBuffer*>(user_data);
+    // The final HAL buffer release may happen on any thread (such as a task
+    // executor worker) and the GIL must be held to touch the Python object.
+    // During interpreter shutdown there is nothing safe to release to so the
+    // view is leaked.
+    if (Py_IsInitialized()) {
+      py::gil_scoped_acquire acquire;
+      PyBuffer_Release(&self->py_view);
+    }
+    delete self;
+  }
+};
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -80,6 +159,39 @@ py::str HalAllocator::FormattedStatistics() {
   return result;
 }
 
+namespace {
+
+// Wraps |hal_buffer| in a buffer view matching the shape of |py_view| if an
+// |element_type| is specified and otherwise returns the buffer itself. Takes
+// ownership of |hal_buffer|.
+py::object WrapHalBufferForPython(
+    iree_hal_allocator_t* allocator, iree_hal_buffer_t* hal_buffer,
+    const Py_buffer& py_view,
+    std::optional<iree_hal_element_types_t> element_type) {
+  if (!element_type) {
+    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
+                    py::return_value_policy::move);
+  }
+
+  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
+  // copy).
+  iree_hal_encoding_type_t encoding_type =
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
+  std::vector<iree_hal_dim_t> dims(py_view.ndim);
+  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
+  iree_hal_buffer_view_t* hal_buffer_view = nullptr;
+  iree_status_t status = iree_hal_buffer_view_create(
+      hal_buffer, dims.size(), dims.data(), *element_type, encoding_type,
+      iree_hal_allocator_host_allocator(allocator), &hal_buffer_view);
+  iree_hal_buffer_release(hal_buffer);
+  CheckApiStatus(status, "Error allocating buffer_view");
+
+  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
+                  py::return_value_policy::move);
+}
+
+}  // namespace
+
 py::object HalAllocator::AllocateBufferCopy(
     int memory_type, int allowed_usage, py::object buffer,
     std::optional<iree_hal_element_types_t> element_type) {
@@ -115,27 +227,60 @@ py::object HalAllocator::AllocateBufferCopy(
   }
   CheckApiStatus(status, "Failed to allocate device visible buffer");
 
-  if (!element_type) {
-    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
-                    py::return_value_policy::move);
+  return WrapHalBufferForPython(raw_ptr(), hal_buffer, py_view, element_type);
+}
+
+py::object HalAllocator::ImportBuffer(
+    int memory_type, int allowed_usage, py::object buffer,
+    std::optional<iree_hal_element_types_t> element_type, bool allow_copy) {
+  IREE_TRACE_SCOPE0("HalAllocator::ImportBuffer");
+
+  // The view is owned by the HAL buffer once imported and must outlive this
+  // call. As with AllocateBufferCopy only C-Contiguous ND-arrays are
+  // supported.
+  auto imported = std::make_unique<ImportedPyBuffer>();
+  Py_buffer& py_view = imported->py_view;
+  int flags = PyBUF_FORMAT | PyBUF_ND;
+  if (PyObject_GetBuffer(buffer.ptr(), &py_view, flags) != 0) {
+    // The GetBuffer call is required to set an appropriate error.
+    throw py::error_already_set();
   }
 
-  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
-  // copy).
-  iree_hal_encoding_type_t encoding_type =
-      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
-  std::vector<iree_hal_dim_t> dims(py_view.ndim);
-  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
-  iree_hal_buffer_view_t* hal_buffer_view;
-  CheckApiStatus(
-      iree_hal_buffer_view_create(
-          hal_buffer, dims.size(), dims.data(), *element_type, encoding_type,
-          iree_hal_allocator_host_allocator(raw_ptr()), &hal_buffer_view),
-      "Error allocating buffer_view");
-  iree_hal_buffer_release(hal_buffer);
+  iree_hal_buffer_params_t params = {0};
+  params.type = memory_type | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  params.usage = allowed_usage;
+  params.access = py_view.readonly ? IREE_HAL_MEMORY_ACCESS_READ
+                                   : IREE_HAL_MEMORY_ACCESS_ALL;
+
+  iree_hal_external_buffer_t external_buffer;
+  memset(&external_buffer, 0, sizeof(external_buffer));
+  external_buffer.type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION;
+  external_buffer.flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE;
+  external_buffer.size = py_view.len;
+  external_buffer.handle.host_allocation.ptr = py_view.buf;
+  iree_hal_buffer_release_callback_t release_callback = {
+      &ImportedPyBuffer::Release, imported.get()};
 
-  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
-                  py::return_value_policy::move);
+  iree_hal_buffer_t* hal_buffer = nullptr;
+  iree_status_t status = iree_hal_allocator_import_buffer(
+      raw_ptr(), params, &external_buffer, release_callback, &hal_buffer);
+  if (iree_status_is_ok(status)) {
+    // Ownership of the view has transferred to the HAL buffer.
+    ImportedPyBuffer* imported_ptr = imported.release();
+    return WrapHalBufferForPython(raw_ptr(), hal_buffer, imported_ptr->py_view,
+                                  element_type);
+  }
+
+  // The release callback is not issued on failure so we release here.
+  PyBuffer_Release(&py_view);
+  if (allow_copy && (iree_status_is_unavailable(status) ||
+                     iree_status_is_out_of_range(status))) {
+    iree_status_ignore(status);
+    return AllocateBufferCopy(memory_type, allowed_usage, std::move(buffer),
+                              element_type);
+  }
+  CheckApiStatus(status, "Failed to import buffer");
+  return py::none();
 }
 
 //------------------------------------------------------------------------------
@@ -208,6 +353,40 @@ py::str HalBufferView::Repr() {
   return py::str(repr);
 }
 
+//------------------------------------------------------------------------------
+// HalMappedMemory
+//------------------------------------------------------------------------------
+
+py::buffer_info HalMappedMemory::ToBufferInfo() {
+  std::vector<iree_hal_dim_t> shape(iree_hal_buffer_view_shape_rank(bv_));
+  CheckApiStatus(
+      iree_hal_buffer_view_shape(bv_, shape.size(), shape.data(), nullptr),
+      "Error getting buffer view shape");
+  iree_hal_element_type_t element_type = iree_hal_buffer_view_element_type(bv_);
+  const char* format = GetElementTypeBufferFormat(element_type);
+  if (!format) format = GetElementTypeRawBufferFormat(element_type);
+  if (!format) {
+    throw RaiseValueError("Unsupported element type for the buffer protocol");
+  }
+  int32_t element_size = iree_hal_element_dense_byte_count(element_type);
+  std::vector<py::ssize_t> dims(shape.size());
+  for (int i = 0; i < shape.size(); ++i) {
+    dims[i] = shape[i];
+  }
+  std::vector<py::ssize_t> strides(shape.size());
+  if (!strides.empty()) {
+    strides[shape.size() - 1] = element_size;
+    for (int i = shape.size() - 2; i >= 0; --i) {
+      strides[i] = strides[i + 1] * shape[i + 1];
+    }
+  }
+
+  // Only scoped read mappings are made today and the memory must be treated
+  // as read-only by consumers.
+  return py::buffer_info(mapped_memory_.contents.data, element_size, format,
+                         shape.size(), dims, strides, /*readonly=*/true);
+}
+
 //------------------------------------------------------------------------------
 // HalDevice
 //------------------------------------------------------------------------------
@@ -367,52 +546,10 @@ HalDevice HalDriver::CreateDeviceByURI(std::string& device_uri) {
 namespace {
 
 py::object MapElementTypeToDType(iree_hal_element_type_t element_type) {
-  // See: https://docs.python.org/3/c-api/arg.html#numbers
-  // TODO: Handle dtypes that do not map to a code (i.e. fp16).
-  const char* dtype_code;
-  switch (element_type) {
-    case IREE_HAL_ELEMENT_TYPE_BOOL_8:
-      dtype_code = "?";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_INT_8:
-    case IREE_HAL_ELEMENT_TYPE_SINT_8:
-      dtype_code = "b";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_UINT_8:
-      dtype_code = "B";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_INT_16:
-    case IREE_HAL_ELEMENT_TYPE_SINT_16:
-      dtype_code = "h";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_UINT_16:
-      dtype_code = "H";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_INT_32:
-    case IREE_HAL_ELEMENT_TYPE_SINT_32:
-      dtype_code = "i";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_UINT_32:
-      dtype_code = "I";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_INT_64:
-    case IREE_HAL_ELEMENT_TYPE_SINT_64:
-      dtype_code = "l";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_UINT_64:
-      dtype_code = "L";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
-      dtype_code = "e";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_FLOAT_32:
-      dtype_code = "f";
-      break;
-    case IREE_HAL_ELEMENT_TYPE_FLOAT_64:
-      dtype_code = "d";
-      break;
-    default:
-      throw RaiseValueError("Unsupported VM Buffer -> numpy dtype mapping");
+  // TODO: Handle dtypes that do not map to a code (i.e. bf16).
+  const char* dtype_code = GetElementTypeBufferFormat(element_type);
+  if (!dtype_code) {
+    throw RaiseValueError("Unsupported VM Buffer -> numpy dtype mapping");
   }
   return py::dtype(dtype_code);
 }
@@ -653,7 +790,18 @@ void SetupHalBindings(pybind11::module m) {
            "object. If an element type is specified, wraps in a BufferView "
            "matching the characteristics of the Python buffer. The format is "
            "requested as ND/C-Contiguous, which may incur copies if not "
-           "already in that format.");
+           "already in that format.")
+      .def("import_buffer", &HalAllocator::ImportBuffer,
+           py::arg("memory_type"), py::arg("allowed_usage"), py::arg("buffer"),
+           py::arg("element_type") = py::none(), py::arg("allow_copy") = true,
+           py::keep_alive<0, 1>(),
+           "Imports the memory of a Python buffer object without copying. "
+           "The buffer object is kept alive until the HAL no longer uses it "
+           "and must not be resized while imported. Writes made to it after "
+           "the import are visible to the device. If the allocator cannot "
+           "import the memory (for example because it is not sufficiently "
+           "aligned) then a copy is made when allow_copy is true and an "
+           "error is raised otherwise.");
 
   py::class_<HalBuffer>(m, "HalBuffer")
       .def("fill_zero", &HalBuffer::FillZero, py::arg("byte_offset"),
@@ -110,6 +110,16 @@ class HalAllocator : public ApiRefCounted<HalAllocator, iree_hal_allocator_t> {
   py::object AllocateBufferCopy(
       int memory_type, int allowed_usage, py::object buffer,
       std::optional<iree_hal_element_types_t> element_type);
+
+  // Imports the memory backing a Python buffer object as a HAL buffer without
+  // copying. The Python object is retained until the HAL releases the buffer.
+  // If the allocator cannot import the memory (unsupported external buffer
+  // type, insufficient alignment, etc) and |allow_copy| is true then this
+  // falls back to AllocateBufferCopy.
+  py::object ImportBuffer(int memory_type, int allowed_usage,
+                          py::object buffer,
+                          std::optional<iree_hal_element_types_t> element_type,
+                          bool allow_copy);
 };
 
 struct HalShape {
@@ -191,30 +201,11 @@ class HalMappedMemory {
     return HalMappedMemory(mapped_memory, bv.raw_ptr());
   }
 
-  py::buffer_info ToBufferInfo() {
-    std::vector<iree_hal_dim_t> shape(iree_hal_buffer_view_shape_rank(bv_));
-    CheckApiStatus(
-        iree_hal_buffer_view_shape(bv_, shape.size(), shape.data(), nullptr),
-        "Error getting buffer view shape");
-    iree_hal_element_type_t element_type =
-        iree_hal_buffer_view_element_type(bv_);
-    int32_t element_size = iree_hal_element_dense_byte_count(element_type);
-    std::vector<py::ssize_t> dims(shape.size());
-    for (int i = 0; i < shape.size(); ++i) {
-      dims[i] = shape[i];
-    }
-    std::vector<py::ssize_t> strides(shape.size());
-    if (!strides.empty()) {
-      strides[shape.size() - 1] = element_size;
-      for (int i = shape.size() - 2; i >= 0; --i) {
-        strides[i] = strides[i + 1] * shape[i + 1];
-      }
-    }
-
-    return py::buffer_info(mapped_memory_.contents.data, element_size,
-                           py::format_descriptor<float>::format(), shape.size(),
-                           dims, strides);
-  }
+  // Returns a buffer_info exposing the mapped memory with the shape and
+  // element type of the buffer view. Element types that have no Python
+  // buffer format code (such as bf16) are exposed as unsigned integers of the
+  // same width.
+  py::buffer_info ToBufferInfo();
 
   iree_hal_buffer_mapping_t& mapped_memory() { return mapped_memory_; }
 
@@ -13,25 +13,28 @@
 #include "iree/hal/api.h"
 #include "iree/modules/hal/module.h"
 #include "iree/vm/api.h"
+#include "pybind11/numpy.h"
 
 namespace iree {
 namespace python {
 
 namespace {
 
+// Per-invoker state shared across calls. This is created once per function
+// invoker and reused so that no per-call Python objects are needed to get at
+// the device or its allocator.
 class InvokeContext {
  public:
-  InvokeContext(HalDevice &device) : device_(device) {}
+  InvokeContext(HalDevice &device)
+      : device_(device),
+        allocator_(HalAllocator::BorrowFromRawPtr(device_.allocator())) {}
 
   HalDevice &device() { return device_; }
-  HalAllocator allocator() {
-    // TODO: Unfortunate that we inc ref here but that is how our object model
-    // is set up.
-    return HalAllocator::BorrowFromRawPtr(device().allocator());
-  }
+  HalAllocator &allocator() { return allocator_; }
 
  private:
   HalDevice device_;
+  HalAllocator allocator_;
 };
 
 using PackCallback =
@@ -54,10 +57,12 @@ class InvokeStatics {
   py::int_ kOne = py::int_(1);
   py::int_ kTwo = py::int_(2);
   py::str kAsArray = py::str("asarray");
-  py::str kMapDtypeToElementTypeAttr = py::str("map_dtype_to_element_type");
   py::str kContiguousArg = py::str("C");
   py::str kArrayProtocolAttr = py::str("__array__");
   py::str kDtypeAttr = py::str("dtype");
+  py::str kIsNativeAttr = py::str("isnative");
+  py::str kNewByteOrderAttr = py::str("newbyteorder");
+  py::str kNativeByteOrder = py::str("=");
 
   // Primitive type names.
   py::str kF32 = py::str("f32");
@@ -84,13 +89,6 @@ class InvokeStatics {
     return *runtime_module_;
   }
 
-  py::module &array_interop_module() {
-    if (!array_interop_module_) {
-      array_interop_module_ = py::module::import("iree.runtime.array_interop");
-    }
-    return *array_interop_module_;
-  }
-
   py::object &device_array_type() {
     if (!device_array_type_) {
       device_array_type_ = runtime_module().attr("DeviceArray");
@@ -111,16 +109,23 @@ class InvokeStatics {
     }
   }
 
+  // Maps a numpy dtype (or anything convertible to one) to a HAL element type.
+  // This is on the critical path for dynamic dispatch and mirrors
+  // array_interop.map_dtype_to_element_type without calling into Python.
+  // HAL element types are always in host byte order so byte-swapped dtypes are
+  // rejected and must be converted by the caller.
   enum iree_hal_element_types_t MapDtypeToElementType(py::object dtype) {
-    // TODO: Consider porting this from a py func to C++ as it can be on
-    // the critical path.
     try {
-      py::object element_type =
-          array_interop_module().attr(kMapDtypeToElementTypeAttr)(dtype);
-      if (element_type.is_none()) {
+      py::dtype np_dtype = py::dtype::from_args(dtype);
+      if (!IsNativeByteOrder(np_dtype)) {
+        throw std::invalid_argument("non-native byte order");
+      }
+      auto element_type =
+          MapDtypeKindToElementType(np_dtype.kind(), np_dtype.itemsize());
+      if (element_type == IREE_HAL_ELEMENT_TYPE_NONE) {
         throw std::invalid_argument("mapping not found");
       }
-      return py::cast<enum iree_hal_element_types_t>(element_type);
+      return element_type;
     } catch (std::exception &e) {
       std::string msg("could not map dtype ");
       msg.append(py::cast<std::string>(py::repr(dtype)));
@@ -130,6 +135,63 @@ class InvokeStatics {
     }
   }
 
+  // Returns true if |dtype| is in host byte order (or has no byte order).
+  bool IsNativeByteOrder(const py::dtype &dtype) {
+    return py::cast<bool>(dtype.attr(kIsNativeAttr));
+  }
+
+  static enum iree_hal_element_types_t MapDtypeKindToElementType(
+      char kind, py::ssize_t itemsize) {
+    switch (kind) {
+      case 'b':
+        if (itemsize == 1) return IREE_HAL_ELEMENT_TYPE_BOOL_8;
+        break;
+      case 'i':
+        switch (itemsize) {
+          case 1:
+            return IREE_HAL_ELEMENT_TYPE_SINT_8;
+          case 2:
+            return IREE_HAL_ELEMENT_TYPE_SINT_16;
+          case 4:
+            return IREE_HAL_ELEMENT_TYPE_SINT_32;
+          case 8:
+            return IREE_HAL_ELEMENT_TYPE_SINT_64;
+        }
+        break;
+      case 'u':
+        switch (itemsize) {
+          case 1:
+            return IREE_HAL_ELEMENT_TYPE_UINT_8;
+          case 2:
+            return IREE_HAL_ELEMENT_TYPE_UINT_16;
+          case 4:
+            return IREE_HAL_ELEMENT_TYPE_UINT_32;
+          case 8:
+            return IREE_HAL_ELEMENT_TYPE_UINT_64;
+        }
+        break;
+      case 'f':
+        switch (itemsize) {
+          case 2:
+            return IREE_HAL_ELEMENT_TYPE_FLOAT_16;
+          case 4:
+            return IREE_HAL_ELEMENT_TYPE_FLOAT_32;
+          case 8:
+            return IREE_HAL_ELEMENT_TYPE_FLOAT_64;
+        }
+        break;
+      case 'c':
+        switch (itemsize) {
+          case 8:
+            return IREE_HAL_ELEMENT_TYPE_COMPLEX_FLOAT_64;
+          case 16:
+            return IREE_HAL_ELEMENT_TYPE_COMPLEX_FLOAT_128;
+        }
+        break;
+    }
+    return IREE_HAL_ELEMENT_TYPE_NONE;
+  }
+
   PackCallback AbiTypeToPackCallback(py::handle desc) {
     return AbiTypeToPackCallback(
         std::move(desc), /*desc_is_list=*/py::isinstance<py::list>(desc));
@@ -158,8 +220,10 @@ class InvokeStatics {
         py::object abi_type = desc[kOne];
         py::object target_dtype = MapElementAbiTypeToDtype(abi_type);
         auto hal_element_type = MapDtypeToElementType(target_dtype);
+        py::dtype target_np_dtype = py::dtype::from_args(target_dtype);
 
-        return [this, target_dtype = std::move(target_dtype), hal_element_type,
+        return [this, target_dtype = std::move(target_dtype),
+                target_np_dtype = std::move(target_np_dtype), hal_element_type,
                 abi_shape = std::move(abi_shape)](InvokeContext &c,
                                                   iree_vm_list_t *list,
                                                   py::handle py_value) {
@@ -175,6 +239,16 @@ class InvokeStatics {
             // Short-circuit: If a HalBufferView is provided directly.
             IREE_TRACE_SCOPE0("PackBufferView");
             bv = py::cast<HalBufferView *>(py_value);
+          } else if (IsCompatibleHostArray(py_value, target_np_dtype)) {
+            // Short-circuit: An ndarray that already has the target dtype and
+            // layout can be transferred directly without going through the
+            // array protocol.
+            IREE_TRACE_SCOPE0("PackCompatibleHostArray");
+            retained_bv = c.allocator().AllocateBufferCopy(
+                IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+                IREE_HAL_BUFFER_USAGE_DEFAULT | IREE_HAL_BUFFER_USAGE_MAPPING,
+                py::reinterpret_borrow<py::object>(py_value), hal_element_type);
+            bv = py::cast<HalBufferView *>(retained_bv);
           } else {
             // Fall back to the array protocol to generate a host side
             // array and then convert that.
@@ -378,20 +452,46 @@ class InvokeStatics {
   }
 
  private:
+  // Returns true if |py_value| is a C-contiguous ndarray of |dtype| that can be
+  // transferred as-is.
+  static bool IsCompatibleHostArray(py::handle py_value,
+                                    const py::dtype &dtype) {
+    if (!py::isinstance<py::array>(py_value)) return false;
+    auto array = py::reinterpret_borrow<py::array>(py_value);
+    return (array.flags() & py::array::c_style) &&
+           array.dtype().equal(dtype);
+  }
+
   PackCallback GetGenericPackCallbackForNdarray() {
     return [this](InvokeContext &c, iree_vm_list_t *list, py::handle py_value) {
       IREE_TRACE_SCOPE0("ArgumentPacker::GenericNdarray");
       py::object host_array;
-      try {
+      if (py::isinstance<py::array>(py_value) &&
+          (py::reinterpret_borrow<py::array>(py_value).flags() &
+           py::array::c_style)) {
+        host_array = py::reinterpret_borrow<py::object>(py_value);
+      } else {
+        try {
+          host_array = numpy_module().attr(kAsArray)(
+              py_value, /*dtype=*/py::none(), kContiguousArg);
+        } catch (std::exception &e) {
+          std::string msg("could not convert value to numpy array: ");
+          msg.append("error='");
+          msg.append(e.what());
+          msg.append("', value=");
+          msg.append(py::cast<std::string>(py::repr(py_value)));
+          throw std::invalid_argument(std::move(msg));
+        }
+      }
+
+      // Byte-swapped arrays are converted to host byte order as HAL element
+      // types have no byte order of their own.
+      py::dtype host_dtype = py::dtype::from_args(host_array.attr(kDtypeAttr));
+      if (!IsNativeByteOrder(host_dtype)) {
+        IREE_TRACE_SCOPE0("ConvertByteOrder");
         host_array = numpy_module().attr(kAsArray)(
-            py_value, /*dtype=*/py::none(), kContiguousArg);
-      } catch (std::exception &e) {
-        std::string msg("could not convert value to numpy array: ");
-        msg.append("error='");
-        msg.append(e.what());
-        msg.append("', value=");
-        msg.append(py::cast<std::string>(py::repr(py_value)));
-        throw std::invalid_argument(std::move(msg));
+            host_array, host_dtype.attr(kNewByteOrderAttr)(kNativeByteOrder),
+            kContiguousArg);
       }
 
       auto hal_element_type =
@@ -532,7 +632,6 @@ class InvokeStatics {
   // our top level module, we defer. Those outside, we cache at creation.
   py::module numpy_module_ = py::module::import("numpy");
   std::optional<py::object> runtime_module_;
-  std::optional<py::module> array_interop_module_;
   std::optional<py::object> device_array_type_;
   py::type hal_buffer_view_type_ = py::type::of<HalBufferView>();
 
@@ -187,7 +187,8 @@ def asdevicearray(device: HalDevice,
                   implicit_host_transfer: bool = False,
                   memory_type=MemoryType.DEVICE_LOCAL,
                   allowed_usage=(BufferUsage.DEFAULT | BufferUsage.MAPPING),
-                  element_type: Optional[HalElementType] = None) -> DeviceArray:
+                  element_type: Optional[HalElementType] = None,
+                  zero_copy: bool = False) -> DeviceArray:
   """Helper to create a DeviceArray from an arbitrary array like.
 
   This is similar in purpose and usage to np.asarray, except that it takes
@@ -200,6 +201,12 @@ def asdevicearray(device: HalDevice,
   Note that additional flags `memory_type`, `allowed_usage` and `element_type`
   are only hints if creating a new DeviceArray. If `a` is already a DeviceArray,
   they are ignored.
+
+  If `zero_copy` is set then the memory of the (C-contiguous) host array is
+  imported into the device allocator instead of being copied, if the allocator
+  supports it. The host array must not be modified while the DeviceArray or
+  any computation using it is live. Arrays that cannot be imported (such as
+  those not sufficiently aligned) are copied as usual.
   """
   if isinstance(a, DeviceArray):
     if dtype is None:
@@ -213,11 +220,18 @@ def asdevicearray(device: HalDevice,
   element_type = map_dtype_to_element_type(a.dtype)
   if element_type is None:
     raise ValueError(f"Could not map dtype {a.dtype} to IREE element type")
-  buffer_view = device.allocator.allocate_buffer_copy(
-      memory_type=memory_type,
-      allowed_usage=allowed_usage,
-      buffer=a,
-      element_type=element_type)
+  if zero_copy:
+    buffer_view = device.allocator.import_buffer(memory_type=memory_type,
+                                                 allowed_usage=allowed_usage,
+                                                 buffer=a,
+                                                 element_type=element_type,
+                                                 allow_copy=True)
+  else:
+    buffer_view = device.allocator.allocate_buffer_copy(
+        memory_type=memory_type,
+        allowed_usage=allowed_usage,
+        buffer=a,
+        element_type=element_type)
   return DeviceArray(device,
                      buffer_view,
                      implicit_host_transfer=implicit_host_transfer,
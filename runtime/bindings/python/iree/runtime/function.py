@@ -84,6 +84,7 @@ class FunctionInvoker:
       "_abi_dict",
       "_arg_descs",
       "_arg_packer",
+      "_invoke_context",
       "_ret_descs",
       "_has_inlined_results",
       "_tracer",
@@ -104,15 +105,17 @@ class FunctionInvoker:
     self._ret_descs = None
     self._has_inlined_results = False
     self._parse_abi_dict(vm_function)
+    # The packing plan is derived from reflection once and the invoke context
+    # is shared by all calls to keep per-call Python overhead minimal.
     self._arg_packer = ArgumentPacker(_invoke_statics, self._arg_descs)
+    self._invoke_context = InvokeContext(self._device)
 
   @property
   def vm_function(self) -> VmFunction:
     return self._vm_function
 
   def __call__(self, *args, **kwargs):
-    invoke_context = InvokeContext(self._device)
-    arg_list = self._arg_packer.pack(invoke_context, args, kwargs)
+    arg_list = self._arg_packer.pack(self._invoke_context, args, kwargs)
 
     call_trace = None  # type: Optional[tracing.CallTrace]
     if self._tracer:
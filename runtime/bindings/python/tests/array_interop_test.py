@@ -73,6 +73,14 @@ class DeviceHalTest(unittest.TestCase):
     np.testing.assert_array_equal(cp, init_ary.astype(np.float32))
     self.assertTrue(ary.is_host_accessible)
 
+  def testZeroCopy(self):
+    init_ary = np.zeros([3, 4], dtype=np.float32) + 2
+    ary = iree.runtime.asdevicearray(self.device,
+                                     init_ary,
+                                     implicit_host_transfer=True,
+                                     zero_copy=True)
+    np.testing.assert_array_equal(ary.to_host(), init_ary)
+
   def testIllegalImplicitHostTransfer(self):
     init_ary = np.zeros([3, 4], dtype=np.int32) + 2
     ary = iree.runtime.asdevicearray(self.device, init_ary)
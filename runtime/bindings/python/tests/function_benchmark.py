@@ -0,0 +1,130 @@
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Microbenchmark of FunctionInvoker call overhead.
+
+Invokes mock VM functions so that only the Python-side argument packing and
+result unpacking is measured. Reports calls per second for each argument
+style. Run directly for more iterations:
+  python function_benchmark.py --iterations=100000
+"""
+
+import argparse
+import json
+import sys
+import time
+import unittest
+
+import numpy as np
+
+from iree import runtime as rt
+from iree.runtime.function import FunctionInvoker
+
+_ITERATIONS = 1000
+
+
+class MockVmContext:
+
+  def __init__(self, invoke_callback):
+    self._invoke_callback = invoke_callback
+
+  def invoke(self, vm_function, arg_list, ret_list):
+    self._invoke_callback(arg_list, ret_list)
+
+
+class MockVmFunction:
+
+  def __init__(self, reflection):
+    self.reflection = reflection
+
+
+def _no_results(arg_list, ret_list):
+  pass
+
+
+class FunctionBenchmark(unittest.TestCase):
+
+  @classmethod
+  def setUpClass(cls):
+    config = rt.Config("local-task")
+    cls.device = config.device
+
+  def _measure(self, name, invoker, *args):
+    # Warmup.
+    for _ in range(min(_ITERATIONS, 100)):
+      invoker(*args)
+    start = time.perf_counter()
+    for _ in range(_ITERATIONS):
+      invoker(*args)
+    elapsed = time.perf_counter() - start
+    print(f"{name}: {_ITERATIONS / elapsed:.0f} calls/s "
+          f"({elapsed / _ITERATIONS * 1e6:.2f} us/call)")
+
+  def _make_invoker(self, reflection):
+    return FunctionInvoker(MockVmContext(_no_results),
+                           self.device,
+                           MockVmFunction(reflection=reflection),
+                           tracer=None)
+
+  def testDynamicScalars(self):
+    invoker = self._make_invoker({})
+    self._measure("dynamic_scalars", invoker, 1, 2, 3.0)
+
+  def testReflectionScalars(self):
+    invoker = self._make_invoker({
+        "iree.abi": json.dumps({
+            "a": ["i32", "i32", "f32"],
+            "r": [],
+        })
+    })
+    self._measure("reflection_scalars", invoker, 1, 2, 3.0)
+
+  def testDynamicNdarrays(self):
+    invoker = self._make_invoker({})
+    a = np.zeros([16], dtype=np.float32)
+    b = np.zeros([16], dtype=np.int32)
+    self._measure("dynamic_ndarrays", invoker, a, b)
+
+  def testReflectionNdarrays(self):
+    invoker = self._make_invoker({
+        "iree.abi":
+            json.dumps({
+                "a": [["ndarray", "f32", 1, 16], ["ndarray", "i32", 1, 16]],
+                "r": [],
+            })
+    })
+    a = np.zeros([16], dtype=np.float32)
+    b = np.zeros([16], dtype=np.int32)
+    self._measure("reflection_ndarrays", invoker, a, b)
+
+  def testReflectionNdarraysConverted(self):
+    invoker = self._make_invoker({
+        "iree.abi": json.dumps({
+            "a": [["ndarray", "f32", 1, 16]],
+            "r": [],
+        })
+    })
+    a = np.zeros([16], dtype=np.float64)
+    self._measure("reflection_ndarrays_converted", invoker, a)
+
+  def testReflectionDeviceArrays(self):
+    invoker = self._make_invoker({
+        "iree.abi":
+            json.dumps({
+                "a": [["ndarray", "f32", 1, 16], ["ndarray", "i32", 1, 16]],
+                "r": [],
+            })
+    })
+    a = rt.asdevicearray(self.device, np.zeros([16], dtype=np.float32))
+    b = rt.asdevicearray(self.device, np.zeros([16], dtype=np.int32))
+    self._measure("reflection_device_arrays", invoker, a, b)
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.add_argument("--iterations", type=int, default=_ITERATIONS)
+  args, unittest_args = parser.parse_known_args()
+  _ITERATIONS = args.iterations
+  unittest.main(argv=sys.argv[:1] + unittest_args)
@@ -465,6 +465,27 @@ class FunctionTest(unittest.TestCase):
     self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
                      repr(invoked_arg_list))
 
+  def testNdarrayArgNoReflectionByteSwapped(self):
+    arg_array = np.asarray([1, 0], dtype=np.int32)
+    arg_array = arg_array.astype(arg_array.dtype.newbyteorder("S"))
+
+    invoked_arg_list = None
+
+    def invoke(arg_list, ret_list):
+      nonlocal invoked_arg_list
+      invoked_arg_list = arg_list
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={})
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    result = invoker(arg_array)
+    self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
+                     repr(invoked_arg_list))
+    # Contents must be converted to host byte order.
+    arg_buffer_view = invoked_arg_list.get_as_object(0, rt.HalBufferView)
+    np.testing.assert_array_equal(
+        arg_buffer_view.map().asarray([2], np.int32), [1, 0])
+
   def testDeviceArrayArgNoReflection(self):
     # Note that since the device array is set up to disallow implicit host
     # transfers, this also verifies that no accidental/automatic transfers
@@ -142,6 +142,62 @@ class DeviceHalTest(unittest.TestCase):
         "<HalBufferView (3, 4), element_type=0x20000011, 48 bytes (at offset 0 into 48), memory_type=DEVICE_LOCAL|HOST_VISIBLE, allowed_access=ALL, allowed_usage=TRANSFER|DISPATCH_STORAGE|MAPPING>"
     )
 
+  def _make_aligned_array(self, shape, dtype, alignment=64):
+    dtype = np.dtype(dtype)
+    byte_length = int(np.prod(shape)) * dtype.itemsize
+    storage = np.empty(byte_length + alignment, dtype=np.uint8)
+    offset = -storage.ctypes.data % alignment
+    return storage[offset:offset + byte_length].view(dtype).reshape(shape)
+
+  def testImportBuffer(self):
+    ary = self._make_aligned_array([3, 4], np.int32)
+    ary[...] = 2
+    buffer_view = self.allocator.import_buffer(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.DEFAULT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.SINT_32,
+        allow_copy=False)
+    # Writes to the host array are visible through the imported buffer.
+    ary[1, 1] = 5
+    mapped = np.asarray(buffer_view.map())
+    self.assertEqual(mapped.dtype, np.int32)
+    self.assertEqual(mapped[1, 1], 5)
+    # The host array must remain live while the HAL references it.
+    del ary
+    gc.collect()
+    self.assertEqual(mapped[0, 0], 2)
+
+  def testImportBufferUnalignedFallsBackToCopy(self):
+    storage = self._make_aligned_array([17], np.int32)
+    ary = storage[1:]
+    ary[...] = 3
+    with self.assertRaises(IndexError):
+      self.allocator.import_buffer(
+          memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+          allowed_usage=iree.runtime.BufferUsage.DEFAULT,
+          buffer=ary,
+          element_type=iree.runtime.HalElementType.SINT_32,
+          allow_copy=False)
+    buffer_view = self.allocator.import_buffer(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.DEFAULT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.SINT_32)
+    np.testing.assert_array_equal(np.asarray(buffer_view.map()), ary)
+
+  def testMappedMemoryBufferProtocolFloat16(self):
+    ary = np.arange(6, dtype=np.float16).reshape([2, 3])
+    buffer_view = self.allocator.allocate_buffer_copy(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.DEFAULT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.FLOAT_16)
+    mapped = np.asarray(buffer_view.map())
+    self.assertEqual(mapped.dtype, np.float16)
+    self.assertFalse(mapped.flags.writeable)
+    np.testing.assert_array_equal(mapped, ary)
+
 
 if __name__ == "__main__":
   unittest.main()
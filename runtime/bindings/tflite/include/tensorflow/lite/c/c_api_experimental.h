@@ -126,6 +126,43 @@ TfLiteInterpreterCreateWithSelectedOps(const TfLiteModel* model,
 TFL_CAPI_EXPORT extern void TfLiteInterpreterOptionsSetUseNNAPI(
     TfLiteInterpreterOptions* options, bool enable);
 
+/// Binds caller-owned memory as the storage of the input tensor at
+/// |input_index|. The memory is used in-place by the interpreter without
+/// copies: data written to `allocation->data` is visible to the next
+/// `TfLiteInterpreterInvoke` and `TfLiteTensorData` returns
+/// `allocation->data`. `allocation->data` must be aligned to 64 bytes and
+/// `allocation->bytes` must be at least the byte size of the tensor. The
+/// memory must remain valid until the allocation is replaced, the tensor is
+/// resized, or the interpreter is deleted.
+///
+/// Must be called after `TfLiteInterpreterAllocateTensors`. The binding is
+/// retained by later calls to it unless the tensor size changes.
+///
+/// NOTE: this is an IREE extension; stock TFLite only exposes this via the C++
+/// `Interpreter::SetCustomAllocationForTensor` API.
+///
+/// WARNING: This is an experimental API and subject to change.
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForInputTensor(
+    TfLiteInterpreter* interpreter, int32_t input_index,
+    const TfLiteCustomAllocation* allocation);
+
+/// Binds caller-owned memory as the storage of the output tensor at
+/// |output_index|. Each `TfLiteInterpreterInvoke` writes the result directly
+/// into `allocation->data` and `TfLiteTensorData` returns `allocation->data`.
+/// The same requirements as with
+/// `TfLiteInterpreterSetCustomAllocationForInputTensor` apply and the output
+/// shape must not depend on the input data.
+///
+/// NOTE: this is an IREE extension; stock TFLite only exposes this via the C++
+/// `Interpreter::SetCustomAllocationForTensor` API.
+///
+/// WARNING: This is an experimental API and subject to change.
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForOutputTensor(
+    TfLiteInterpreter* interpreter, int32_t output_index,
+    const TfLiteCustomAllocation* allocation);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -429,21 +429,23 @@ typedef struct TfLiteSparsity {
   int dim_metadata_size;
 } TfLiteSparsity;
 
+#else
+
+typedef struct TfLiteTensor TfLiteTensor;
+
+#endif  // IREE_BINDINGS_TFLITE_INCLUDE_UNSUPPORTED_APIS
+
 // Defines a custom memory allocation not owned by the runtime.
 // `data` should be aligned to kDefaultTensorAlignment defined in
 // lite/util.h. (Currently 64 bytes)
 // NOTE: See Interpreter.SetCustomAllocationForTensor for details on usage.
+// NOTE: IREE exposes this through the
+// TfLiteInterpreterSetCustomAllocationFor*Tensor C API extensions.
 typedef struct TfLiteCustomAllocation {
   void* data;
   size_t bytes;
 } TfLiteCustomAllocation;
 
-#else
-
-typedef struct TfLiteTensor TfLiteTensor;
-
-#endif  // IREE_BINDINGS_TFLITE_INCLUDE_UNSUPPORTED_APIS
-
 // A tensor in the interpreter system which is a wrapper around a buffer of
 // data including a dimensionality (or NULL if not currently defined).
 #ifndef TF_LITE_STATIC_MEMORY
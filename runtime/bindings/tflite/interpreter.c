@@ -222,6 +222,21 @@ static iree_status_t _TfLiteInterpreterRefreshIOShapes(
   return status;
 }
 
+// Refreshes only the output tensor shapes by querying the module.
+// This is used after invocation to pick up data-dependent output shapes.
+static iree_status_t _TfLiteInterpreterRefreshOnlyOutputShapes(
+    TfLiteInterpreter* interpreter) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  _TfLiteInterpreterShapeFrame frame;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, _TfLiteInterpreterShapeFrameInitialize(&frame));
+  iree_status_t status =
+      _TfLiteInterpreterRefreshOutputShapes(interpreter, &frame);
+  _TfLiteInterpreterShapeFrameDeinitialize(&frame);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Creation and static initialization
 //===----------------------------------------------------------------------===//
@@ -542,11 +557,27 @@ static iree_status_t _TfLiteInterpreterAllocateTensors(
         iree_vm_list_push_ref_move(interpreter->input_list, &buffer_ref));
   }
 
-  // TODO(benvanik): preallocate outputs when we support using them.
-  // We could stash the buffer views in interpreter->output_list.
-  // For now we just drop them all.
+  // Preallocate outputs with static shapes. Like stock tflite the storage (and
+  // TfLiteTensorData pointer) remains stable across invocations until the next
+  // time tensors are allocated and results are copied into it after each
+  // invocation. Outputs with shapes that are only known after invocation are
+  // bound to the returned buffers directly.
   for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
-    _TfLiteTensorDiscardBuffer(&interpreter->output_tensors[i]);
+    TfLiteTensor* tensor = &interpreter->output_tensors[i];
+    if (_TfLiteTensorHasStaticShape(tensor)) {
+      IREE_RETURN_IF_ERROR(_TfLiteTensorReallocateIfNeeded(
+          tensor, iree_hal_device_allocator(interpreter->device),
+          interpreter->allocator));
+    } else {
+      _TfLiteTensorDiscardBuffer(tensor);
+    }
+  }
+  interpreter->has_dynamic_outputs = false;
+  for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
+    if (!interpreter->output_tensors[i].is_persistent) {
+      interpreter->has_dynamic_outputs = true;
+      break;
+    }
   }
 
   return iree_ok_status();
@@ -580,21 +611,38 @@ static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
                      /*policy=*/NULL, interpreter->input_list,
                      interpreter->output_list, interpreter->allocator));
 
-  // Refresh output shapes.
-  // TODO(#3975): just use buffer view results or at least just refresh outputs.
-  IREE_RETURN_IF_ERROR(_TfLiteInterpreterRefreshIOShapes(interpreter));
+  // Output shapes only change across invocations if they depend on the input
+  // data; all others were queried during TfLiteInterpreterAllocateTensors.
+  if (interpreter->has_dynamic_outputs) {
+    IREE_RETURN_IF_ERROR(
+        _TfLiteInterpreterRefreshOnlyOutputShapes(interpreter));
+  }
 
-  // Map the output buffers.
-  // NOTE: we could defer the mapping unless requested and ensure state buffers
-  // remain where they currently are for the next invocation.
+  // Copy results into the persistent output storage or, if the output had no
+  // known shape at allocation time, map the returned buffers directly.
+  // NOTE: the compiled function allocates its own results so this is one copy
+  // per output; custom allocations receive the results in the same single
+  // copy.
+  iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
     iree_hal_buffer_t* buffer = (iree_hal_buffer_t*)iree_vm_list_get_ref_deref(
         interpreter->output_list, i, iree_hal_buffer_get_descriptor());
     TfLiteTensor* tensor = &interpreter->output_tensors[i];
-    IREE_RETURN_IF_ERROR(_TfLiteTensorBind(tensor, buffer));
+    if (buffer && tensor->is_persistent &&
+        iree_hal_buffer_byte_length(buffer) ==
+            iree_hal_buffer_byte_length(tensor->buffer)) {
+      status = _TfLiteTensorCopyFrom(tensor, buffer);
+    } else {
+      status = _TfLiteTensorBind(tensor, buffer);
+    }
+    if (!iree_status_is_ok(status)) break;
   }
 
-  return iree_ok_status();
+  // Drop our references to the results so that their memory can be reused;
+  // any bound outputs retain their own.
+  IREE_IGNORE_ERROR(iree_vm_list_resize(interpreter->output_list, 0));
+
+  return status;
 }
 
 TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterInvoke(
@@ -628,3 +676,57 @@ TFL_CAPI_EXPORT extern const TfLiteTensor* TfLiteInterpreterGetOutputTensor(
   }
   return &interpreter->output_tensors[output_index];
 }
+
+static iree_status_t _TfLiteInterpreterSetCustomAllocation(
+    TfLiteInterpreter* interpreter, TfLiteTensor* tensor,
+    const TfLiteCustomAllocation* allocation) {
+  if (!allocation || !allocation->data) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "custom allocation must have data");
+  }
+  if (!tensor->is_persistent) {
+    return iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "tensor has no allocated storage; either the shape is data-dependent "
+        "or TfLiteInterpreterAllocateTensors has not been called");
+  }
+  return _TfLiteTensorImport(tensor,
+                             iree_hal_device_allocator(interpreter->device),
+                             allocation->data, allocation->bytes);
+}
+
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForInputTensor(
+    TfLiteInterpreter* interpreter, int32_t input_index,
+    const TfLiteCustomAllocation* allocation) {
+  if (input_index < 0 || input_index >= interpreter->model->input_count) {
+    return kTfLiteApplicationError;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  TfLiteTensor* tensor = &interpreter->input_tensors[input_index];
+  iree_status_t status =
+      _TfLiteInterpreterSetCustomAllocation(interpreter, tensor, allocation);
+  if (iree_status_is_ok(status)) {
+    // Replace the buffer passed to the model for this input.
+    iree_vm_ref_t buffer_ref = iree_hal_buffer_retain_ref(tensor->buffer);
+    status = iree_vm_list_set_ref_move(interpreter->input_list, input_index,
+                                       &buffer_ref);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return _TfLiteStatusFromIREEStatus(status);
+}
+
+TFL_CAPI_EXPORT extern TfLiteStatus
+TfLiteInterpreterSetCustomAllocationForOutputTensor(
+    TfLiteInterpreter* interpreter, int32_t output_index,
+    const TfLiteCustomAllocation* allocation) {
+  if (output_index < 0 || output_index >= interpreter->model->output_count) {
+    return kTfLiteApplicationError;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  TfLiteTensor* tensor = &interpreter->output_tensors[output_index];
+  iree_status_t status =
+      _TfLiteInterpreterSetCustomAllocation(interpreter, tensor, allocation);
+  IREE_TRACE_ZONE_END(z0);
+  return _TfLiteStatusFromIREEStatus(status);
+}
@@ -43,6 +43,10 @@ struct TfLiteInterpreter {
   iree_vm_list_t* output_list;
   TfLiteTensor* input_tensors;
   TfLiteTensor* output_tensors;
+
+  // True if any output had an unknown shape when tensors were allocated and
+  // output shapes must be queried after each invocation.
+  bool has_dynamic_outputs;
 };
 
 #endif  // IREE_BINDINGS_TFLITE_INTERPRETER_H_
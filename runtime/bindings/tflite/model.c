@@ -134,40 +134,35 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreateFromFile(
   iree_allocator_t allocator = iree_allocator_system();
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(#3909): use file mapping C API.
-  FILE* file = fopen(model_path, "r");
-  if (!file) {
-    IREE_TRACE_MESSAGE(ERROR, "failed to open model file");
+  // Map the model file instead of reading it into memory: pages are faulted in
+  // only as the module touches them and clean pages can be shared across
+  // processes loading the same model.
+  iree_file_contents_t* model_contents = NULL;
+  iree_status_t status =
+      iree_file_map_contents(model_path, allocator, &model_contents);
+  if (!iree_status_is_ok(iree_status_consume_code(status))) {
+    IREE_TRACE_MESSAGE(ERROR, "failed to map model file");
     IREE_TRACE_MESSAGE_DYNAMIC(ERROR, model_path, strlen(model_path));
     IREE_TRACE_ZONE_END(z0);
     return NULL;
   }
-  fseek(file, 0, SEEK_END);
-  size_t file_size = ftell(file);
-  fseek(file, 0, SEEK_SET);
+
   TfLiteModel* model = NULL;
-  iree_status_t status = iree_allocator_malloc(
-      allocator, sizeof(TfLiteModel) + file_size, (void**)&model);
+  status = iree_allocator_malloc(allocator, sizeof(*model), (void**)&model);
   if (!iree_status_is_ok(iree_status_consume_code(status))) {
-    IREE_TRACE_MESSAGE(ERROR, "failed model+data allocation");
+    iree_file_contents_free(model_contents);
+    IREE_TRACE_MESSAGE(ERROR, "failed model allocation");
     IREE_TRACE_ZONE_END(z0);
     return NULL;
   }
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
   model->allocator = allocator;
-  model->owned_model_data = (uint8_t*)model + file_size;
-  int ret = fread(model->owned_model_data, 1, file_size, file);
-  fclose(file);
-  if (ret != file_size) {
-    TfLiteModelDelete(model);
-    IREE_TRACE_MESSAGE(ERROR, "failed model+data read");
-    IREE_TRACE_ZONE_END(z0);
-    return NULL;
-  }
+  model->owned_model_contents = model_contents;
 
-  status = _TfLiteModelInitializeModule(model->owned_model_data, file_size,
-                                        allocator, model);
+  status = _TfLiteModelInitializeModule(
+      model_contents->const_buffer.data,
+      model_contents->const_buffer.data_length, allocator, model);
   if (!iree_status_is_ok(iree_status_consume_code(status))) {
     TfLiteModelDelete(model);
     IREE_TRACE_ZONE_END(z0);
@@ -189,6 +184,7 @@ void _TfLiteModelRelease(TfLiteModel* model) {
     IREE_TRACE_ZONE_BEGIN(z0);
     iree_vm_module_release(model->module);
     iree_vm_instance_release(model->instance);
+    iree_file_contents_free(model->owned_model_contents);
     iree_allocator_free(model->allocator, model);
     IREE_TRACE_ZONE_END(z0);
   }
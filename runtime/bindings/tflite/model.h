@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/file_io.h"
 #include "iree/vm/api.h"
 
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
@@ -27,7 +28,10 @@ typedef struct _TfLiteModelExports {
 struct TfLiteModel {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
-  void* owned_model_data;
+  // Read-only mapping of the model file when created from a file path.
+  // The bytecode module references the flatbuffer in-place so this must
+  // outlive the module.
+  iree_file_contents_t* owned_model_contents;
 
   // HACK: no public API that allows us to share this without spooky action
   // at a distance. Today it's ok for these to be unique as we don't check that
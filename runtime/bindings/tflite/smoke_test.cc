@@ -30,6 +30,7 @@ limitations under the License.
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
 #define TFL_COMPILE_LIBRARY 1
 #include "runtime/bindings/tflite/include/tensorflow/lite/c/c_api.h"
+#include "runtime/bindings/tflite/include/tensorflow/lite/c/c_api_experimental.h"
 
 // Test model is available both on the filesystem and here for embedding testing
 // embedding the module directly in a binary.
@@ -214,6 +215,66 @@ TEST(CApiSimple, StaticSmoke) {
   TfLiteInterpreterDelete(interpreter);
 }
 
+// IREE extension: binds caller-owned memory to the I/O tensors and checks that
+// it is used in-place across multiple invocations.
+TEST(CApiSimple, StaticCustomAllocation) {
+  TfLiteModel* model =
+      TfLiteModelCreate(IREE_BINDINGS_TFLITE_TESTDATA_ADD_STATIC_EMBEDDED_DATA,
+                        IREE_BINDINGS_TFLITE_TESTDATA_ADD_STATIC_EMBEDDED_SIZE);
+  ASSERT_NE(model, nullptr);
+  TfLiteInterpreter* interpreter = TfLiteInterpreterCreate(model, nullptr);
+  ASSERT_NE(interpreter, nullptr);
+  TfLiteModelDelete(model);
+
+  ASSERT_EQ(TfLiteInterpreterAllocateTensors(interpreter), kTfLiteOk);
+  TfLiteTensor* input_tensor = TfLiteInterpreterGetInputTensor(interpreter, 0);
+  ASSERT_NE(input_tensor, nullptr);
+  const TfLiteTensor* output_tensor =
+      TfLiteInterpreterGetOutputTensor(interpreter, 0);
+  ASSERT_NE(output_tensor, nullptr);
+
+  // Static outputs are allocated along with the inputs.
+  EXPECT_NE(TfLiteTensorData(output_tensor), nullptr);
+
+  alignas(64) std::array<float, 1 * 8 * 8 * 3> input = {
+      1.f,
+      3.f,
+  };
+  alignas(64) std::array<float, 1 * 8 * 8 * 3> output = {0.f};
+  TfLiteCustomAllocation input_allocation = {input.data(),
+                                             input.size() * sizeof(float)};
+  TfLiteCustomAllocation output_allocation = {output.data(),
+                                              output.size() * sizeof(float)};
+  ASSERT_EQ(TfLiteInterpreterSetCustomAllocationForInputTensor(
+                interpreter, 0, &input_allocation),
+            kTfLiteOk);
+  ASSERT_EQ(TfLiteInterpreterSetCustomAllocationForOutputTensor(
+                interpreter, 0, &output_allocation),
+            kTfLiteOk);
+  EXPECT_EQ(TfLiteTensorData(input_tensor), input.data());
+  EXPECT_EQ(TfLiteTensorData(output_tensor), output.data());
+
+  ASSERT_EQ(TfLiteInterpreterInvoke(interpreter), kTfLiteOk);
+  EXPECT_EQ(output[0], 2.f);
+  EXPECT_EQ(output[1], 6.f);
+
+  // Updates to the custom input memory are visible to the next invocation and
+  // results land in the same output memory.
+  input[0] = 5.f;
+  ASSERT_EQ(TfLiteInterpreterInvoke(interpreter), kTfLiteOk);
+  EXPECT_EQ(TfLiteTensorData(output_tensor), output.data());
+  EXPECT_EQ(output[0], 10.f);
+  EXPECT_EQ(output[1], 6.f);
+
+  // Undersized allocations are rejected.
+  TfLiteCustomAllocation small_allocation = {input.data(), sizeof(float)};
+  EXPECT_NE(TfLiteInterpreterSetCustomAllocationForInputTensor(
+                interpreter, 0, &small_allocation),
+            kTfLiteOk);
+
+  TfLiteInterpreterDelete(interpreter);
+}
+
 // TODO(#3971): fix cmake data deps.
 // TODO(#3972): plumb through quantization params.
 TEST(CApiSimple, DISABLED_QuantizationParams) {
@@ -103,38 +103,56 @@ static iree_status_t _TfLiteTypeToElementType(
   return iree_ok_status();
 }
 
-iree_status_t _TfLiteTensorReallocateIfNeeded(
-    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
-    iree_allocator_t heap_allocator) {
-  IREE_TRACE_ZONE_BEGIN(z0);
+// Computes the total allocation size required for the tensor at its current
+// shape, possibly with padding.
+static iree_status_t _TfLiteTensorComputeAllocationSize(
+    const TfLiteTensor* tensor, iree_device_size_t* out_allocation_size) {
+  *out_allocation_size = 0;
 
   // Format conversion; ensure we can support the type.
   iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
   iree_host_size_t storage_scalar = 1;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
+  IREE_RETURN_IF_ERROR(
       _TfLiteTypeToElementType(tensor->type, &element_type, &storage_scalar));
 
-  // Compute the total allocation size required, possibly with padding.
   iree_hal_dim_t shape_dims[IREE_BINDINGS_TFLITE_MAX_RANK];
   for (int32_t i = 0; i < tensor->shape_rank; ++i) {
     shape_dims[i] = (iree_hal_dim_t)tensor->shape_dims[i];
   }
+  iree_device_size_t allocation_size = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_compute_view_size(
+      tensor->shape_rank, shape_dims, element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &allocation_size));
+  *out_allocation_size = allocation_size * storage_scalar;
+  return iree_ok_status();
+}
+
+bool _TfLiteTensorHasStaticShape(const TfLiteTensor* tensor) {
+  for (int32_t i = 0; i < tensor->shape_rank; ++i) {
+    if (tensor->shape_dims[i] < 0) return false;
+  }
+  return true;
+}
+
+iree_status_t _TfLiteTensorReallocateIfNeeded(
+    TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
+    iree_allocator_t heap_allocator) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
   iree_device_size_t allocation_size = 0;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_buffer_compute_view_size(
-              tensor->shape_rank, shape_dims, element_type,
-              IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &allocation_size));
-  allocation_size *= storage_scalar;
+      z0, _TfLiteTensorComputeAllocationSize(tensor, &allocation_size));
 
   // If the old buffer is the same size then no need to realloc.
   if (tensor->buffer &&
       iree_hal_buffer_byte_length(tensor->buffer) == allocation_size) {
+    tensor->is_persistent = true;
     IREE_TRACE_ZONE_END(z0);
     return iree_ok_status();
   }
 
   // Allocate the underlying buffer for the tensor.
+  _TfLiteTensorDiscardBuffer(tensor);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_allocator_allocate_buffer(
               buffer_allocator,
@@ -157,11 +175,80 @@ iree_status_t _TfLiteTensorReallocateIfNeeded(
       iree_hal_buffer_map_range(tensor->buffer, IREE_HAL_MAPPING_MODE_SCOPED,
                                 IREE_HAL_MEMORY_ACCESS_ALL, 0,
                                 IREE_WHOLE_BUFFER, &tensor->buffer_mapping));
+  tensor->is_persistent = true;
 
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
 
+iree_status_t _TfLiteTensorImport(TfLiteTensor* tensor,
+                                  iree_hal_allocator_t* buffer_allocator,
+                                  void* data, iree_host_size_t data_length) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_device_size_t allocation_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, _TfLiteTensorComputeAllocationSize(tensor, &allocation_size));
+  if (data_length < allocation_size) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "custom allocation of %" PRIhsz
+                            " bytes is smaller than the %" PRIdsz
+                            " bytes required by the tensor",
+                            data_length, allocation_size);
+  }
+
+  // Wrap only the portion of the memory the tensor uses so that size checks
+  // on reallocation treat the binding like any other buffer.
+  iree_hal_external_buffer_t external_buffer = {
+      .type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+      .flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE,
+      .size = allocation_size,
+      .handle.host_allocation.ptr = data,
+  };
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_allocator_import_buffer(
+              buffer_allocator,
+              (iree_hal_buffer_params_t){
+                  .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL |
+                          IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+                  .usage = IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE |
+                           IREE_HAL_BUFFER_USAGE_TRANSFER |
+                           IREE_HAL_BUFFER_USAGE_MAPPING,
+              },
+              &external_buffer, iree_hal_buffer_release_callback_null(),
+              &buffer),
+      "importing custom tensor allocation");
+
+  iree_status_t status = _TfLiteTensorBind(tensor, buffer);
+  iree_hal_buffer_release(buffer);
+  tensor->is_persistent = iree_status_is_ok(status);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t _TfLiteTensorCopyFrom(TfLiteTensor* tensor,
+                                    iree_hal_buffer_t* buffer) {
+  if (buffer == tensor->buffer) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_device_size_t byte_length = iree_hal_buffer_byte_length(buffer);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, byte_length);
+  if (byte_length != tensor->buffer_mapping.contents.data_length) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "result buffer length %" PRIdsz
+        " does not match the tensor allocation of %" PRIhsz,
+        byte_length, tensor->buffer_mapping.contents.data_length);
+  }
+  iree_status_t status = iree_hal_buffer_map_read(
+      buffer, 0, tensor->buffer_mapping.contents.data, byte_length);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
                                 iree_hal_buffer_t* buffer) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -199,6 +286,7 @@ void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor) {
   }
   iree_hal_buffer_release(tensor->buffer);
   tensor->buffer = NULL;
+  tensor->is_persistent = false;
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -252,7 +340,11 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyFromBuffer(
   // have the buffer mapped. If we knew the user would never use
   // TfLiteTensorData and could avoid mapping the buffer it would be more
   // efficient and portable to do the iree_hal_buffer_map_copy.
-  memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  // Callers that wrote into TfLiteTensorData (or a custom allocation) may pass
+  // the tensor memory back to us, in which case there is nothing to copy.
+  if (input_data != tensor->buffer_mapping.contents.data) {
+    memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return kTfLiteOk;
@@ -269,8 +361,10 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyToBuffer(
       z0, output_tensor->buffer_mapping.contents.data_length);
 
   // NOTE: as with above we should use an iree_hal_buffer_map_read here.
-  memcpy(output_data, output_tensor->buffer_mapping.contents.data,
-         output_data_size);
+  if (output_data != output_tensor->buffer_mapping.contents.data) {
+    memcpy(output_data, output_tensor->buffer_mapping.contents.data,
+           output_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return kTfLiteOk;
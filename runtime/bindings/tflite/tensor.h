@@ -38,6 +38,9 @@ struct TfLiteTensor {
   iree_hal_buffer_t* buffer;
   // Persistently mapped buffer; invalidated when buffer is resized.
   iree_hal_buffer_mapping_t buffer_mapping;
+  // True if |buffer| is storage allocated (or imported) for the tensor that
+  // persists across invocations, as opposed to a bound invocation result.
+  bool is_persistent;
 };
 
 // Parses a tfl.io.names value and sets the |tensor| name.
@@ -60,6 +63,23 @@ iree_status_t _TfLiteTensorReallocateIfNeeded(
     TfLiteTensor* tensor, iree_hal_allocator_t* buffer_allocator,
     iree_allocator_t heap_allocator);
 
+// Returns true if all dimensions of the tensor shape are known.
+bool _TfLiteTensorHasStaticShape(const TfLiteTensor* tensor);
+
+// Imports the caller-owned host memory |data| of |data_length| bytes as the
+// tensor buffer without copying and maps it.
+// Fails if the memory is too small for the current tensor shape or cannot be
+// imported by |buffer_allocator| (for example when it is insufficiently
+// aligned).
+iree_status_t _TfLiteTensorImport(TfLiteTensor* tensor,
+                                  iree_hal_allocator_t* buffer_allocator,
+                                  void* data, iree_host_size_t data_length);
+
+// Copies the contents of |buffer| into the tensor's existing mapped buffer.
+// The byte length of |buffer| must match the tensor buffer.
+iree_status_t _TfLiteTensorCopyFrom(TfLiteTensor* tensor,
+                                    iree_hal_buffer_t* buffer);
+
 // Binds the given |buffer| to the tensor and maps it.
 // The tensor shape will be overwritten with the buffer view shape.
 iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
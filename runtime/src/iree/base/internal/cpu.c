@@ -93,6 +93,106 @@ static void iree_cpu_initialize_from_platform(iree_allocator_t temp_allocator,
 
 #endif  // IREE_PLATFORM_*
 
+//===----------------------------------------------------------------------===//
+// Architecture-specific processor data queries
+//===----------------------------------------------------------------------===//
+// Some architectures allow user-mode code to directly query processor features
+// independent of the platform. These are run after the platform queries.
+
+#if defined(IREE_ARCH_X86_64) && \
+    (defined(IREE_COMPILER_GCC_COMPAT) || defined(IREE_COMPILER_MSVC))
+
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+
+// Queries CPUID leaf |leaf| subleaf |subleaf| into |out_regs| (eax-edx).
+static void iree_cpu_x86_64_cpuid(uint32_t leaf, uint32_t subleaf,
+                                  uint32_t out_regs[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  int regs[4];
+  __cpuidex(regs, (int)leaf, (int)subleaf);
+  for (int i = 0; i < 4; ++i) out_regs[i] = (uint32_t)regs[i];
+#else
+  __cpuid_count(leaf, subleaf, out_regs[0], out_regs[1], out_regs[2],
+                out_regs[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the low 32 bits of XCR0 indicating which register state the OS
+// saves on context switches. Requires OSXSAVE to have been checked.
+static uint32_t iree_cpu_x86_64_xgetbv0(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return (uint32_t)_xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+// OR's |field_bit| into |field_value| if bit |reg_bit| is set in |reg_value|.
+#define IREE_SET_IF_CPUID(reg_value, reg_bit, field_value, field_bit) \
+  if (iree_all_bits_set(reg_value, 1u << (reg_bit)))                  \
+  (field_value) |= (field_bit)
+
+static void iree_cpu_initialize_from_arch(uint64_t* out_fields) {
+  uint32_t leaf0[4] = {0};
+  iree_cpu_x86_64_cpuid(0, 0, leaf0);
+  const uint32_t max_leaf = leaf0[0];
+  if (max_leaf < 1) return;
+
+  uint32_t leaf1[4] = {0};
+  iree_cpu_x86_64_cpuid(1, 0, leaf1);
+  uint32_t leaf7[4] = {0};
+  if (max_leaf >= 7) iree_cpu_x86_64_cpuid(7, 0, leaf7);
+
+  // AVX-class features are only usable if the OS saves the extended register
+  // state: XMM|YMM for AVX and additionally opmask|ZMM_Hi256|Hi16_ZMM for
+  // AVX-512.
+  const bool has_osxsave = iree_all_bits_set(leaf1[2], 1u << 27);
+  const uint32_t xcr0 = has_osxsave ? iree_cpu_x86_64_xgetbv0() : 0;
+  const bool has_avx_state = iree_all_bits_set(xcr0, 0x06u);
+  const bool has_avx512_state = iree_all_bits_set(xcr0, 0xE6u);
+
+  if (has_avx_state) {
+    IREE_SET_IF_CPUID(leaf1[2], 28, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX);
+    IREE_SET_IF_CPUID(leaf7[1], 5, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2);
+    IREE_SET_IF_CPUID(leaf1[2], 12, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA);
+    IREE_SET_IF_CPUID(leaf1[2], 29, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C);
+  }
+  if (has_avx512_state) {
+    IREE_SET_IF_CPUID(leaf7[1], 16, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F);
+    IREE_SET_IF_CPUID(leaf7[1], 28, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD);
+    IREE_SET_IF_CPUID(leaf7[1], 31, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL);
+    IREE_SET_IF_CPUID(leaf7[1], 17, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ);
+    IREE_SET_IF_CPUID(leaf7[1], 30, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW);
+    IREE_SET_IF_CPUID(leaf7[2], 11, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI);
+  }
+}
+
+#undef IREE_SET_IF_CPUID
+
+#else
+
+static void iree_cpu_initialize_from_arch(uint64_t* out_fields) {
+  // No architecture-level queries available; rely on the platform.
+}
+
+#endif  // IREE_ARCH_*
+
 //===----------------------------------------------------------------------===//
 // Architecture-specific string lookup
 //===----------------------------------------------------------------------===//
@@ -115,6 +215,32 @@ static bool iree_cpu_lookup_data_by_key_for_arch(
   return false;
 }
 
+#elif defined(IREE_ARCH_X86_64)
+
+static bool iree_cpu_lookup_data_by_key_for_arch(
+    const uint64_t* fields, iree_string_view_t key,
+    int64_t* IREE_RESTRICT out_value) {
+  IREE_TEST_FIELD_BIT("avx", fields[0], IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX);
+  IREE_TEST_FIELD_BIT("avx2", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2);
+  IREE_TEST_FIELD_BIT("fma", fields[0], IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA);
+  IREE_TEST_FIELD_BIT("f16c", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C);
+  IREE_TEST_FIELD_BIT("avx512f", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F);
+  IREE_TEST_FIELD_BIT("avx512cd", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD);
+  IREE_TEST_FIELD_BIT("avx512vl", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL);
+  IREE_TEST_FIELD_BIT("avx512dq", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ);
+  IREE_TEST_FIELD_BIT("avx512bw", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW);
+  IREE_TEST_FIELD_BIT("avx512vnni", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI);
+  return false;
+}
+
 #else
 
 static bool iree_cpu_lookup_data_by_key_for_arch(
@@ -139,6 +265,7 @@ void iree_cpu_initialize(iree_allocator_t temp_allocator) {
   IREE_TRACE_ZONE_BEGIN(z0);
   memset(iree_cpu_data_cache_, 0, sizeof(iree_cpu_data_cache_));
   iree_cpu_initialize_from_platform(temp_allocator, iree_cpu_data_cache_);
+  iree_cpu_initialize_from_arch(iree_cpu_data_cache_);
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -0,0 +1,101 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/cpu.h"
+
+#include "iree/base/api.h"
+#include "iree/schemas/cpu_data.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Looks up |key| and returns its value, failing the test if not found.
+int64_t LookupKey(const char* key) {
+  int64_t value = -1;
+  IREE_EXPECT_OK(
+      iree_cpu_lookup_data_by_key(iree_make_cstring_view(key), &value));
+  return value;
+}
+
+TEST(CPUTest, UnknownKeyNotFound) {
+  int64_t value = 0;
+  iree_status_t status = iree_cpu_lookup_data_by_key(
+      iree_make_cstring_view("not-a-feature"), &value);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_NOT_FOUND, status);
+  iree_status_free(status);
+}
+
+#if defined(IREE_ARCH_X86_64)
+
+// Keys map to the bits in field 0 independent of the host CPU.
+TEST(CPUTest, X86_64LookupByKey) {
+  const uint64_t fields[1] = {IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX |
+                              IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2 |
+                              IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA |
+                              IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI};
+  iree_cpu_initialize_with_data(IREE_ARRAYSIZE(fields), fields);
+  EXPECT_EQ(LookupKey("avx"), 1);
+  EXPECT_EQ(LookupKey("avx2"), 1);
+  EXPECT_EQ(LookupKey("fma"), 1);
+  EXPECT_EQ(LookupKey("f16c"), 0);
+  EXPECT_EQ(LookupKey("avx512f"), 0);
+  EXPECT_EQ(LookupKey("avx512cd"), 0);
+  EXPECT_EQ(LookupKey("avx512vl"), 0);
+  EXPECT_EQ(LookupKey("avx512dq"), 0);
+  EXPECT_EQ(LookupKey("avx512bw"), 0);
+  EXPECT_EQ(LookupKey("avx512vnni"), 1);
+
+  // aarch64 keys are not recognized on x86-64.
+  int64_t value = 0;
+  iree_status_t status =
+      iree_cpu_lookup_data_by_key(iree_make_cstring_view("dotprod"), &value);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_NOT_FOUND, status);
+  iree_status_free(status);
+
+  iree_cpu_initialize(iree_allocator_system());
+}
+
+#if defined(IREE_COMPILER_GCC_COMPAT)
+
+// CPUID/XGETBV detection agrees with the compiler runtime, which performs the
+// same OS register state checks.
+TEST(CPUTest, X86_64DetectionMatchesCompilerRuntime) {
+  iree_cpu_initialize(iree_allocator_system());
+  __builtin_cpu_init();
+  EXPECT_EQ(LookupKey("avx"), __builtin_cpu_supports("avx") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx2"), __builtin_cpu_supports("avx2") ? 1 : 0);
+  EXPECT_EQ(LookupKey("fma"), __builtin_cpu_supports("fma") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512f"), __builtin_cpu_supports("avx512f") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512cd"),
+            __builtin_cpu_supports("avx512cd") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512vl"),
+            __builtin_cpu_supports("avx512vl") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512dq"),
+            __builtin_cpu_supports("avx512dq") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512bw"),
+            __builtin_cpu_supports("avx512bw") ? 1 : 0);
+  EXPECT_EQ(LookupKey("avx512vnni"),
+            __builtin_cpu_supports("avx512vnni") ? 1 : 0);
+}
+
+#endif  // IREE_COMPILER_GCC_COMPAT
+
+// Features that depend on others are never reported without them.
+TEST(CPUTest, X86_64DetectionIsConsistent) {
+  iree_cpu_initialize(iree_allocator_system());
+  if (LookupKey("avx2") || LookupKey("fma") || LookupKey("f16c")) {
+    EXPECT_EQ(LookupKey("avx"), 1);
+  }
+  for (const char* key :
+       {"avx512cd", "avx512vl", "avx512dq", "avx512bw", "avx512vnni"}) {
+    if (LookupKey(key)) EXPECT_EQ(LookupKey("avx512f"), 1) << key;
+  }
+}
+
+#endif  // IREE_ARCH_X86_64
+
+}  // namespace
@@ -26,6 +26,16 @@
 #define IREE_SET_BINARY_MODE(handle) ((void)0)
 #endif  // IREE_PLATFORM_WINDOWS
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define IREE_FILE_MAPPING_POSIX 1
+#elif defined(IREE_PLATFORM_WINDOWS)
+#define IREE_FILE_MAPPING_WIN32 1
+#endif  // IREE_PLATFORM_*
+
 // We could take alignment as an arg, but roughly page aligned should be
 // acceptable for all uses - if someone cares about memory usage they won't
 // be using this method.
@@ -99,8 +109,7 @@ iree_status_t iree_file_contents_allocator_ctl(void* self,
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "only the file contents buffer is valid");
   }
-  iree_allocator_t allocator = contents->allocator;
-  iree_allocator_free(allocator, contents);
+  iree_file_contents_free(contents);
   return iree_ok_status();
 }
 
@@ -113,9 +122,12 @@ iree_allocator_t iree_file_contents_deallocator(
   return allocator;
 }
 
+static void iree_file_unmap(iree_byte_span_t buffer);
+
 void iree_file_contents_free(iree_file_contents_t* contents) {
   if (!contents) return;
   IREE_TRACE_ZONE_BEGIN(z0);
+  if (contents->mapped) iree_file_unmap(contents->buffer);
   iree_allocator_free(contents->allocator, contents);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -147,6 +159,7 @@ static iree_status_t iree_file_read_contents_impl(
   contents->buffer.data = (void*)iree_host_align(
       (uintptr_t)contents + sizeof(*contents), IREE_FILE_BASE_ALIGNMENT);
   contents->buffer.data_length = file_size;
+  contents->mapped = false;
 
   // Attempt to read the file into memory.
   if (fread(contents->buffer.data, file_size, 1, file) != 1) {
@@ -189,6 +202,154 @@ iree_status_t iree_file_read_contents(const char* path,
   return status;
 }
 
+#if defined(IREE_FILE_MAPPING_POSIX)
+
+static iree_status_t iree_file_map_contents_impl(
+    const char* path, iree_allocator_t allocator,
+    iree_file_contents_t** out_contents) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path);
+  }
+
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == -1) {
+    close(fd);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to stat file '%s'", path);
+  }
+  if ((uint64_t)stat_buf.st_size > IREE_HOST_SIZE_MAX) {
+    close(fd);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "file length exceeds host address range");
+  }
+  iree_host_size_t file_size = (iree_host_size_t)stat_buf.st_size;
+
+  // Zero-length mappings are not allowed; empty files get empty contents.
+  void* data = NULL;
+  if (file_size > 0) {
+    data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to map file '%s'", path);
+    }
+  }
+
+  // The mapping remains valid after the descriptor is closed.
+  close(fd);
+
+  iree_file_contents_t* contents = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(allocator, sizeof(*contents), (void**)&contents);
+  if (!iree_status_is_ok(status)) {
+    if (data) munmap(data, file_size);
+    return status;
+  }
+  contents->allocator = allocator;
+  contents->buffer = iree_make_byte_span(data, file_size);
+  contents->mapped = data != NULL;
+  *out_contents = contents;
+  return iree_ok_status();
+}
+
+static void iree_file_unmap(iree_byte_span_t buffer) {
+  munmap(buffer.data, buffer.data_length);
+}
+
+#elif defined(IREE_FILE_MAPPING_WIN32)
+
+static iree_status_t iree_file_map_contents_impl(
+    const char* path, iree_allocator_t allocator,
+    iree_file_contents_t** out_contents) {
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "failed to open file '%s'", path);
+  }
+
+  LARGE_INTEGER file_size_li;
+  if (!GetFileSizeEx(file, &file_size_li)) {
+    CloseHandle(file);
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "failed to query file size '%s'", path);
+  }
+  if ((uint64_t)file_size_li.QuadPart > IREE_HOST_SIZE_MAX) {
+    CloseHandle(file);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "file length exceeds host address range");
+  }
+  iree_host_size_t file_size = (iree_host_size_t)file_size_li.QuadPart;
+
+  // Zero-length mappings are not allowed; empty files get empty contents.
+  void* data = NULL;
+  if (file_size > 0) {
+    HANDLE mapping =
+        CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+      CloseHandle(file);
+      return iree_make_status(
+          iree_status_code_from_win32_error(GetLastError()),
+          "failed to create file mapping '%s'", path);
+    }
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, file_size);
+    // The view retains the mapping object and file.
+    CloseHandle(mapping);
+    if (!data) {
+      CloseHandle(file);
+      return iree_make_status(
+          iree_status_code_from_win32_error(GetLastError()),
+          "failed to map file '%s'", path);
+    }
+  }
+  CloseHandle(file);
+
+  iree_file_contents_t* contents = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(allocator, sizeof(*contents), (void**)&contents);
+  if (!iree_status_is_ok(status)) {
+    if (data) UnmapViewOfFile(data);
+    return status;
+  }
+  contents->allocator = allocator;
+  contents->buffer = iree_make_byte_span(data, file_size);
+  contents->mapped = data != NULL;
+  *out_contents = contents;
+  return iree_ok_status();
+}
+
+static void iree_file_unmap(iree_byte_span_t buffer) {
+  UnmapViewOfFile(buffer.data);
+}
+
+#else
+
+static iree_status_t iree_file_map_contents_impl(
+    const char* path, iree_allocator_t allocator,
+    iree_file_contents_t** out_contents) {
+  // No mapping support; read the entire file into memory instead.
+  return iree_file_read_contents(path, allocator, out_contents);
+}
+
+static void iree_file_unmap(iree_byte_span_t buffer) {}
+
+#endif  // IREE_FILE_MAPPING_*
+
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t allocator,
+                                     iree_file_contents_t** out_contents) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_contents);
+  *out_contents = NULL;
+  iree_status_t status =
+      iree_file_map_contents_impl(path, allocator, out_contents);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 iree_status_t iree_file_write_contents(const char* path,
                                        iree_const_byte_span_t content) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -265,6 +426,7 @@ static iree_status_t iree_stdin_read_contents_impl(
   }
 
   contents->allocator = allocator;
+  contents->mapped = false;
   contents->buffer.data[size] = 0;  // NUL
   contents->buffer.data_length = size;
   *out_contents = contents;
@@ -300,6 +462,12 @@ iree_status_t iree_file_read_contents(const char* path,
   return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
 }
 
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t allocator,
+                                     iree_file_contents_t** out_contents) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
+}
+
 iree_status_t iree_file_write_contents(const char* path,
                                        iree_const_byte_span_t content) {
   return iree_make_status(IREE_STATUS_UNAVAILABLE, "File I/O is disabled");
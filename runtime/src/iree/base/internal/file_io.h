@@ -36,6 +36,9 @@ typedef struct iree_file_contents_t {
     iree_byte_span_t buffer;
     iree_const_byte_span_t const_buffer;
   };
+  // True if |buffer| is a read-only view of a file mapping that must be
+  // unmapped when the contents are freed.
+  bool mapped;
 } iree_file_contents_t;
 
 // Returns an allocator that deallocates the |contents|.
@@ -54,6 +57,24 @@ iree_status_t iree_file_read_contents(const char* path,
                                       iree_allocator_t allocator,
                                       iree_file_contents_t** out_contents);
 
+// Maps a file's contents into memory read-only.
+//
+// Pages are brought in on demand by the OS and can be shared with other
+// processes mapping the same file, making this preferable to
+// iree_file_read_contents for large files that are only read. The mapping is
+// page aligned. Unlike iree_file_read_contents the contents are not NUL
+// terminated and must not be written to.
+//
+// On platforms without file mapping support this falls back to reading the
+// file contents into memory.
+//
+// Returns the contents of the file in |out_contents|.
+// |allocator| is used to allocate the contents structure and the caller must
+// use iree_file_contents_free to unmap the file and release the memory.
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t allocator,
+                                     iree_file_contents_t** out_contents);
+
 // Synchronously writes a byte buffer into a file.
 // Existing contents are overwritten.
 iree_status_t iree_file_write_contents(const char* path,
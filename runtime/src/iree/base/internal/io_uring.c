@@ -0,0 +1,263 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/io_uring.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_LINUX)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_EXT_ARG)
+#define IREE_HAVE_IO_URING 1
+#endif  // __NR_io_uring_setup && IORING_FEAT_EXT_ARG
+#endif  // IREE_PLATFORM_LINUX
+
+#if defined(IREE_HAVE_IO_URING)
+
+//===----------------------------------------------------------------------===//
+// iree_io_uring_t
+//===----------------------------------------------------------------------===//
+
+// NOTE: the ring indices are shared with the kernel and must be accessed with
+// acquire/release semantics. We use the compiler builtins directly as the
+// mapped memory is not of our atomic types.
+#define iree_io_uring_load_acquire(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define iree_io_uring_store_release(ptr, value) \
+  __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+iree_status_t iree_io_uring_initialize(uint32_t entries,
+                                       iree_io_uring_t* out_ring) {
+  IREE_ASSERT_ARGUMENT(out_ring);
+  memset(out_ring, 0, sizeof(*out_ring));
+  out_ring->ring_fd = -1;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd < 0) {
+    // ENOSYS: kernel too old or compiled without io_uring.
+    // EPERM: disabled by seccomp (containers/android) or the
+    //        kernel.io_uring_disabled sysctl.
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "io_uring_setup failed (%d)", errno);
+  }
+  const uint32_t required_features = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((params.features & required_features) != required_features) {
+    close(ring_fd);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "io_uring features 0x%08X missing from 0x%08X",
+                            required_features, params.features);
+  }
+
+  iree_io_uring_t* ring = out_ring;
+  ring->ring_fd = ring_fd;
+  ring->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  ring->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    // Both rings share one mapping.
+    ring->sq_ring_size = iree_max(ring->sq_ring_size, ring->cq_ring_size);
+    ring->cq_ring_size = 0;
+  }
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  iree_status_t status = iree_ok_status();
+  ring->sq_ring_ptr =
+      mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring_ptr == MAP_FAILED) {
+    ring->sq_ring_ptr = NULL;
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to map io_uring SQ ring");
+  }
+  if (iree_status_is_ok(status)) {
+    if (ring->cq_ring_size) {
+      ring->cq_ring_ptr =
+          mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+      if (ring->cq_ring_ptr == MAP_FAILED) {
+        ring->cq_ring_ptr = NULL;
+        status = iree_make_status(iree_status_code_from_errno(errno),
+                                  "failed to map io_uring CQ ring");
+      }
+    } else {
+      ring->cq_ring_ptr = ring->sq_ring_ptr;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    void* sqes_ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes_ptr == MAP_FAILED) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to map io_uring SQEs");
+    } else {
+      ring->sqes = (struct io_uring_sqe*)sqes_ptr;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    uint8_t* sq_base = (uint8_t*)ring->sq_ring_ptr;
+    ring->sq_head = (uint32_t*)(sq_base + params.sq_off.head);
+    ring->sq_tail = (uint32_t*)(sq_base + params.sq_off.tail);
+    ring->sq_array = (uint32_t*)(sq_base + params.sq_off.array);
+    ring->sq_ring_mask = *(uint32_t*)(sq_base + params.sq_off.ring_mask);
+    ring->sq_ring_entries = *(uint32_t*)(sq_base + params.sq_off.ring_entries);
+    ring->sq_pending_tail = *ring->sq_tail;
+    uint8_t* cq_base = (uint8_t*)ring->cq_ring_ptr;
+    ring->cq_head = (uint32_t*)(cq_base + params.cq_off.head);
+    ring->cq_tail = (uint32_t*)(cq_base + params.cq_off.tail);
+    ring->cq_ring_mask = *(uint32_t*)(cq_base + params.cq_off.ring_mask);
+    ring->cqes = cq_base + params.cq_off.cqes;
+  } else {
+    iree_io_uring_deinitialize(ring);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_io_uring_deinitialize(iree_io_uring_t* ring) {
+  IREE_ASSERT_ARGUMENT(ring);
+  if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring_ptr && ring->cq_ring_ptr != ring->sq_ring_ptr) {
+    munmap(ring->cq_ring_ptr, ring->cq_ring_size);
+  }
+  if (ring->sq_ring_ptr) munmap(ring->sq_ring_ptr, ring->sq_ring_size);
+  if (ring->ring_fd >= 0) close(ring->ring_fd);
+  memset(ring, 0, sizeof(*ring));
+  ring->ring_fd = -1;
+}
+
+iree_status_t iree_io_uring_acquire_sqe(iree_io_uring_t* ring,
+                                        struct io_uring_sqe** out_sqe) {
+  *out_sqe = NULL;
+  uint32_t head = iree_io_uring_load_acquire(ring->sq_head);
+  if (ring->sq_pending_tail - head >= ring->sq_ring_entries) {
+    // Queue is full; flush the pending entries to the kernel. The kernel
+    // consumes all SQEs during submission so this frees up the whole ring.
+    IREE_RETURN_IF_ERROR(
+        iree_io_uring_enter(ring, /*min_complete=*/0, IREE_TIME_INFINITE_PAST));
+    head = iree_io_uring_load_acquire(ring->sq_head);
+    if (ring->sq_pending_tail - head >= ring->sq_ring_entries) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "io_uring submission queue full");
+    }
+  }
+  uint32_t index = ring->sq_pending_tail & ring->sq_ring_mask;
+  struct io_uring_sqe* sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index] = index;
+  ++ring->sq_pending_tail;
+  *out_sqe = sqe;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_enter(iree_io_uring_t* ring, uint32_t min_complete,
+                                  iree_time_t deadline_ns) {
+  // Publish all SQEs acquired since the last enter.
+  iree_io_uring_store_release(ring->sq_tail, ring->sq_pending_tail);
+  uint32_t to_submit =
+      ring->sq_pending_tail - iree_io_uring_load_acquire(ring->sq_head);
+  if (!to_submit && !min_complete) return iree_ok_status();
+
+  int rv = -1;
+  do {
+    uint32_t flags = 0;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    struct __kernel_timespec ts;
+    if (min_complete) {
+      flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+      if (deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+        // Recomputed each iteration as a prior attempt may have taken time.
+        iree_duration_t timeout_ns =
+            deadline_ns == IREE_TIME_INFINITE_PAST
+                ? 0
+                : iree_max(0, deadline_ns - iree_time_now());
+        ts.tv_sec = (int64_t)(timeout_ns / 1000000000ull);
+        ts.tv_nsec = (long long)(timeout_ns % 1000000000ull);
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+      }
+    }
+    rv = (int)syscall(__NR_io_uring_enter, ring->ring_fd, to_submit,
+                      min_complete, flags, min_complete ? &arg : NULL,
+                      min_complete ? sizeof(arg) : 0);
+    if (rv > 0) {
+      // Some SQEs were consumed; only retry what remains.
+      to_submit -= iree_min((uint32_t)rv, to_submit);
+    }
+  } while (rv < 0 && errno == EINTR);
+  if (rv >= 0) return iree_ok_status();
+  switch (errno) {
+    case ETIME:
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    case EBUSY:
+    case EAGAIN:
+      // Completion queue backpressure: the caller needs to drain CQEs. All
+      // completions are retained (IORING_FEAT_NODROP) so this is not an error.
+      return iree_ok_status();
+    default:
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "io_uring_enter failure %d", errno);
+  }
+}
+
+bool iree_io_uring_pop_cqe(iree_io_uring_t* ring, uint64_t* out_user_data,
+                           int32_t* out_result) {
+  uint32_t head = *ring->cq_head;
+  if (head == iree_io_uring_load_acquire(ring->cq_tail)) return false;
+  const struct io_uring_cqe* cqe =
+      &((const struct io_uring_cqe*)ring->cqes)[head & ring->cq_ring_mask];
+  *out_user_data = cqe->user_data;
+  *out_result = cqe->res;
+  iree_io_uring_store_release(ring->cq_head, head + 1);
+  return true;
+}
+
+#else
+
+iree_status_t iree_io_uring_initialize(uint32_t entries,
+                                       iree_io_uring_t* out_ring) {
+  IREE_ASSERT_ARGUMENT(out_ring);
+  memset(out_ring, 0, sizeof(*out_ring));
+  out_ring->ring_fd = -1;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "io_uring not available on this platform");
+}
+
+void iree_io_uring_deinitialize(iree_io_uring_t* ring) {}
+
+iree_status_t iree_io_uring_acquire_sqe(iree_io_uring_t* ring,
+                                        struct io_uring_sqe** out_sqe) {
+  *out_sqe = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "io_uring not available on this platform");
+}
+
+iree_status_t iree_io_uring_enter(iree_io_uring_t* ring, uint32_t min_complete,
+                                  iree_time_t deadline_ns) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "io_uring not available on this platform");
+}
+
+bool iree_io_uring_pop_cqe(iree_io_uring_t* ring, uint64_t* out_user_data,
+                           int32_t* out_result) {
+  return false;
+}
+
+#endif  // IREE_HAVE_IO_URING
@@ -0,0 +1,102 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_IO_URING_H_
+#define IREE_BASE_INTERNAL_IO_URING_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_io_uring_t
+//===----------------------------------------------------------------------===//
+
+struct io_uring_sqe;
+
+// A minimal Linux io_uring submission/completion ring.
+// https://kernel.dk/io_uring.pdf
+//
+// This talks to the kernel directly via syscalls so that we don't take a
+// dependency on liburing. Only the small subset of functionality we use is
+// exposed: callers acquire submission queue entries (SQEs), fill them in, and
+// then submit all pending entries with a single iree_io_uring_enter call that
+// can also block for completions. Completions (CQEs) are then drained in bulk
+// with iree_io_uring_pop_cqe without additional syscalls.
+//
+// Rings require Linux 5.11+ (IORING_FEAT_EXT_ARG for waits with timeouts and
+// IORING_FEAT_NODROP to never lose completions). On older kernels, non-Linux
+// platforms, or when io_uring is disabled by policy (seccomp/sysctl) creation
+// fails with IREE_STATUS_UNAVAILABLE and callers are expected to fall back to
+// another mechanism.
+//
+// Thread-compatible; only one thread may be manipulating a ring at a time.
+typedef struct iree_io_uring_t {
+  // Ring file descriptor or -1 if not initialized.
+  int ring_fd;
+
+  // Submission queue ring. |sq_pending_tail| is our local tail that is
+  // published to |sq_tail| on iree_io_uring_enter.
+  uint32_t* sq_head;
+  uint32_t* sq_tail;
+  uint32_t* sq_array;
+  uint32_t sq_ring_mask;
+  uint32_t sq_ring_entries;
+  uint32_t sq_pending_tail;
+  struct io_uring_sqe* sqes;
+
+  // Completion queue ring.
+  uint32_t* cq_head;
+  uint32_t* cq_tail;
+  uint32_t cq_ring_mask;
+  void* cqes;
+
+  // Mappings of the rings shared with the kernel.
+  void* sq_ring_ptr;
+  iree_host_size_t sq_ring_size;
+  void* cq_ring_ptr;
+  iree_host_size_t cq_ring_size;
+  iree_host_size_t sqes_size;
+} iree_io_uring_t;
+
+// Initializes a ring with at least |entries| submission queue entries.
+// Returns IREE_STATUS_UNAVAILABLE if io_uring is not usable on this system.
+iree_status_t iree_io_uring_initialize(uint32_t entries,
+                                       iree_io_uring_t* out_ring);
+
+// Deinitializes |ring|. Any in-flight operations are cancelled by the kernel.
+void iree_io_uring_deinitialize(iree_io_uring_t* ring);
+
+// Returns true if |ring| has been successfully initialized.
+static inline bool iree_io_uring_is_initialized(const iree_io_uring_t* ring) {
+  return ring->ring_fd >= 0;
+}
+
+// Acquires a zeroed SQE that will be submitted on the next iree_io_uring_enter.
+// If the submission queue is full the pending entries are submitted first.
+iree_status_t iree_io_uring_acquire_sqe(iree_io_uring_t* ring,
+                                        struct io_uring_sqe** out_sqe);
+
+// Submits all pending SQEs and waits until at least |min_complete| CQEs are
+// available or |deadline_ns| elapses. A |min_complete| of 0 only submits.
+//
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the deadline elapsed before the
+// requested completions were available; pending SQEs are still submitted.
+iree_status_t iree_io_uring_enter(iree_io_uring_t* ring, uint32_t min_complete,
+                                  iree_time_t deadline_ns);
+
+// Pops the next available CQE from the completion queue, if any.
+// Returns false if the completion queue is empty.
+bool iree_io_uring_pop_cqe(iree_io_uring_t* ring, uint64_t* out_user_data,
+                           int32_t* out_result);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_IO_URING_H_
@@ -0,0 +1,82 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/io_uring.h"
+
+#include "iree/base/target_platform.h"
+
+#if defined(IREE_PLATFORM_LINUX)
+
+#include <linux/io_uring.h>
+
+#include <cstdint>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+class IoUringTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_status_t status = iree_io_uring_initialize(4, &ring_);
+    if (iree_status_is_unavailable(status)) {
+      iree_status_ignore(status);
+      GTEST_SKIP() << "io_uring not available";
+    }
+    IREE_ASSERT_OK(status);
+  }
+  void TearDown() override {
+    if (iree_io_uring_is_initialized(&ring_)) {
+      iree_io_uring_deinitialize(&ring_);
+    }
+  }
+  iree_io_uring_t ring_;
+};
+
+// Submits more NOPs than fit in the submission queue and drains them all.
+TEST_F(IoUringTest, NopRoundTrip) {
+  constexpr uint64_t kNopCount = 10;
+  for (uint64_t i = 0; i < kNopCount; ++i) {
+    struct io_uring_sqe* sqe = NULL;
+    IREE_ASSERT_OK(iree_io_uring_acquire_sqe(&ring_, &sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 100 + i;
+  }
+
+  uint64_t completed_mask = 0;
+  uint64_t completed = 0;
+  while (completed < kNopCount) {
+    IREE_ASSERT_OK(iree_io_uring_enter(&ring_, /*min_complete=*/1,
+                                       IREE_TIME_INFINITE_FUTURE));
+    uint64_t user_data = 0;
+    int32_t result = -1;
+    while (iree_io_uring_pop_cqe(&ring_, &user_data, &result)) {
+      ASSERT_GE(user_data, 100u);
+      ASSERT_LT(user_data, 100u + kNopCount);
+      EXPECT_EQ(result, 0);
+      completed_mask |= 1ull << (user_data - 100);
+      ++completed;
+    }
+  }
+  EXPECT_EQ(completed_mask, (1ull << kNopCount) - 1);
+}
+
+// Waiting for completions that never arrive honors the deadline.
+TEST_F(IoUringTest, EnterDeadline) {
+  iree_status_t status = iree_io_uring_enter(
+      &ring_, /*min_complete=*/1, iree_time_now() + 10 * 1000000ll);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DEADLINE_EXCEEDED, status);
+  iree_status_free(status);
+
+  uint64_t user_data = 0;
+  int32_t result = 0;
+  EXPECT_FALSE(iree_io_uring_pop_cqe(&ring_, &user_data, &result));
+}
+
+}  // namespace
+
+#endif  // IREE_PLATFORM_LINUX
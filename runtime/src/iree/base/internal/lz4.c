@@ -0,0 +1,259 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/lz4.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+
+// Minimum length of a match; match lengths are encoded relative to this.
+#define IREE_LZ4_MIN_MATCH 4
+// The last 5 bytes of a block are always literals.
+#define IREE_LZ4_LAST_LITERALS 5
+// The last match must start at least 12 bytes before the end of the block.
+#define IREE_LZ4_MF_LIMIT 12
+// Matches are referenced with 16-bit offsets.
+#define IREE_LZ4_MAX_DISTANCE 65535
+// Number of hash table entries used by the compressor as a power of two.
+// 4096 entries keeps the table at 16KB so that it can live on the stack.
+#define IREE_LZ4_HASH_LOG 12
+
+static inline uint32_t iree_lz4_read32(const uint8_t* ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+static inline uint32_t iree_lz4_hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - IREE_LZ4_HASH_LOG);
+}
+
+// Writes the continuation bytes of a literal or match |length| that did not
+// fit in its token nibble.
+static uint8_t* iree_lz4_write_length(uint8_t* op, iree_host_size_t length) {
+  for (; length >= 255; length -= 255) *op++ = 255;
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+// Emits a sequence of |literal_length| literals followed by an optional match
+// of |match_length| bytes at |offset| (a |match_length| of 0 emits the final
+// literal-only sequence of the block).
+static iree_status_t iree_lz4_emit_sequence(
+    const uint8_t* literals, iree_host_size_t literal_length, uint32_t offset,
+    iree_host_size_t match_length, uint8_t** inout_op, uint8_t* oend) {
+  uint8_t* op = *inout_op;
+  iree_host_size_t encoded_match_length =
+      match_length ? match_length - IREE_LZ4_MIN_MATCH : 0;
+
+  // Worst case: token, literal length, literals, offset, match length.
+  iree_host_size_t required_length = 1 + (literal_length / 255 + 1) +
+                                     literal_length +
+                                     (match_length ? 2 : 0) +
+                                     (encoded_match_length / 255 + 1);
+  if (required_length > (iree_host_size_t)(oend - op)) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "target buffer too small for compressed block");
+  }
+
+  uint8_t* token = op++;
+  if (literal_length >= 15) {
+    *token = 15 << 4;
+    op = iree_lz4_write_length(op, literal_length - 15);
+  } else {
+    *token = (uint8_t)(literal_length << 4);
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+
+  if (match_length) {
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    if (encoded_match_length >= 15) {
+      *token |= 15;
+      op = iree_lz4_write_length(op, encoded_match_length - 15);
+    } else {
+      *token |= (uint8_t)encoded_match_length;
+    }
+  }
+
+  *inout_op = op;
+  return iree_ok_status();
+}
+
+iree_status_t iree_lz4_block_compress(iree_const_byte_span_t source,
+                                      iree_byte_span_t target,
+                                      iree_host_size_t* out_length) {
+  IREE_ASSERT_ARGUMENT(out_length);
+  *out_length = 0;
+  if (source.data_length > IREE_LZ4_MAX_BLOCK_LENGTH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "block length %zu exceeds the LZ4 maximum of %u",
+                            source.data_length, IREE_LZ4_MAX_BLOCK_LENGTH);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, source.data_length);
+
+  const uint8_t* const base = source.data;
+  const uint8_t* const iend = base + source.data_length;
+  const uint8_t* ip = base;
+  const uint8_t* anchor = base;
+  uint8_t* op = target.data;
+  uint8_t* const oend = target.data + target.data_length;
+
+  iree_status_t status = iree_ok_status();
+  if (source.data_length > IREE_LZ4_MF_LIMIT) {
+    const uint8_t* const mf_limit = iend - IREE_LZ4_MF_LIMIT;
+    const uint8_t* const match_limit = iend - IREE_LZ4_LAST_LITERALS;
+
+    // Positions (+1 so that 0 means empty) of the last occurrence of each
+    // hashed 4-byte sequence.
+    uint32_t table[1 << IREE_LZ4_HASH_LOG];
+    memset(table, 0, sizeof(table));
+
+    while (ip < mf_limit) {
+      uint32_t sequence = iree_lz4_read32(ip);
+      uint32_t hash = iree_lz4_hash(sequence);
+      const uint8_t* match = table[hash] ? base + table[hash] - 1 : NULL;
+      table[hash] = (uint32_t)(ip - base) + 1;
+      if (!match || ip - match > IREE_LZ4_MAX_DISTANCE ||
+          iree_lz4_read32(match) != sequence) {
+        // Skip faster through long runs of incompressible data.
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+
+      // Extend the match backward into the pending literals and forward as
+      // far as the block allows.
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+      const uint8_t* match_end = ip + IREE_LZ4_MIN_MATCH;
+      const uint8_t* match_ref = match + IREE_LZ4_MIN_MATCH;
+      while (match_end < match_limit && *match_end == *match_ref) {
+        ++match_end;
+        ++match_ref;
+      }
+
+      status = iree_lz4_emit_sequence(anchor, (iree_host_size_t)(ip - anchor),
+                                      (uint32_t)(ip - match),
+                                      (iree_host_size_t)(match_end - ip), &op,
+                                      oend);
+      if (!iree_status_is_ok(status)) break;
+      ip = match_end;
+      anchor = ip;
+    }
+  }
+
+  // Remaining bytes are emitted as literals.
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_lz4_emit_sequence(anchor, (iree_host_size_t)(iend - anchor),
+                               /*offset=*/0, /*match_length=*/0, &op, oend);
+  }
+  if (iree_status_is_ok(status)) {
+    *out_length = (iree_host_size_t)(op - target.data);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Reads the continuation bytes of a literal or match length into
+// |inout_length|. Returns false if the input ends before the length does.
+static bool iree_lz4_read_length(const uint8_t** inout_ip,
+                                 const uint8_t* iend,
+                                 iree_host_size_t* inout_length) {
+  const uint8_t* ip = *inout_ip;
+  uint8_t value = 0;
+  do {
+    if (ip >= iend) return false;
+    value = *ip++;
+    *inout_length += value;
+  } while (value == 255);
+  *inout_ip = ip;
+  return true;
+}
+
+iree_status_t iree_lz4_block_decompress(iree_const_byte_span_t source,
+                                        iree_byte_span_t target) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, target.data_length);
+
+  const uint8_t* ip = source.data;
+  const uint8_t* const iend = source.data + source.data_length;
+  uint8_t* op = target.data;
+  uint8_t* const ostart = target.data;
+  uint8_t* const oend = target.data + target.data_length;
+
+  bool valid = true;
+  while (ip < iend) {
+    uint8_t token = *ip++;
+
+    iree_host_size_t literal_length = token >> 4;
+    if (literal_length == 15 &&
+        !iree_lz4_read_length(&ip, iend, &literal_length)) {
+      valid = false;
+      break;
+    }
+    if (literal_length > (iree_host_size_t)(iend - ip) ||
+        literal_length > (iree_host_size_t)(oend - op)) {
+      valid = false;
+      break;
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    // The final sequence of a block has no match.
+    if (ip == iend) break;
+
+    if (iend - ip < 2) {
+      valid = false;
+      break;
+    }
+    iree_host_size_t offset =
+        (iree_host_size_t)ip[0] | ((iree_host_size_t)ip[1] << 8);
+    ip += 2;
+    iree_host_size_t match_length = token & 15;
+    if (match_length == 15 &&
+        !iree_lz4_read_length(&ip, iend, &match_length)) {
+      valid = false;
+      break;
+    }
+    match_length += IREE_LZ4_MIN_MATCH;
+    if (offset == 0 || offset > (iree_host_size_t)(op - ostart) ||
+        match_length > (iree_host_size_t)(oend - op)) {
+      valid = false;
+      break;
+    }
+
+    const uint8_t* match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // Overlapping matches repeat the last |offset| bytes.
+      for (iree_host_size_t i = 0; i < match_length; ++i) *op++ = *match++;
+    }
+  }
+
+  iree_status_t status = iree_ok_status();
+  if (!valid) {
+    status = iree_make_status(
+        IREE_STATUS_DATA_LOSS, "malformed LZ4 block at input offset %zu",
+        (iree_host_size_t)(ip - source.data));
+  } else if (op != oend) {
+    status = iree_make_status(
+        IREE_STATUS_DATA_LOSS,
+        "LZ4 block decompressed to %zu bytes but %zu were expected",
+        (iree_host_size_t)(op - ostart), target.data_length);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
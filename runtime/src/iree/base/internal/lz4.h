@@ -0,0 +1,61 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_LZ4_H_
+#define IREE_BASE_INTERNAL_LZ4_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// LZ4 block format
+//===----------------------------------------------------------------------===//
+//
+// A small self-contained codec for the LZ4 block format:
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// Only raw blocks are supported (no frame format, checksums, or dictionaries).
+// Blocks are independent and callers wanting to process large buffers in
+// parallel are expected to split them into multiple blocks themselves and
+// track the compressed and uncompressed lengths of each.
+//
+// The compressor is a simple greedy single-hash matcher that favors
+// decompression speed and predictable output over ratio. The decompressor is
+// safe to use on untrusted input and never reads or writes out of bounds.
+
+// Largest uncompressed block length supported by the codec.
+#define IREE_LZ4_MAX_BLOCK_LENGTH 0x7E000000u
+
+// Returns the worst-case compressed length of a block of |length| bytes.
+static inline iree_host_size_t iree_lz4_block_compress_bound(
+    iree_host_size_t length) {
+  return length + length / 255 + 16;
+}
+
+// Compresses |source| into |target| as a single LZ4 block.
+// Returns the number of bytes written to |target| in |out_length|. Fails with
+// IREE_STATUS_RESOURCE_EXHAUSTED if |target| is too small to hold the
+// compressed block; a |target| of iree_lz4_block_compress_bound bytes always
+// succeeds.
+iree_status_t iree_lz4_block_compress(iree_const_byte_span_t source,
+                                      iree_byte_span_t target,
+                                      iree_host_size_t* out_length);
+
+// Decompresses the LZ4 block in |source| into |target|.
+// |target| must be exactly the uncompressed length of the block. Fails with
+// IREE_STATUS_DATA_LOSS if the block is malformed or decompresses to a
+// different length.
+iree_status_t iree_lz4_block_decompress(iree_const_byte_span_t source,
+                                        iree_byte_span_t target);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_LZ4_H_
@@ -0,0 +1,143 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iree/base/internal/prng.h"
+#include "iree/base/status_cc.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using iree::Status;
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& source) {
+  std::vector<uint8_t> target(iree_lz4_block_compress_bound(source.size()));
+  iree_host_size_t length = 0;
+  IREE_CHECK_OK(iree_lz4_block_compress(
+      iree_make_const_byte_span(source.data(), source.size()),
+      iree_make_byte_span(target.data(), target.size()), &length));
+  target.resize(length);
+  return target;
+}
+
+Status Decompress(const std::vector<uint8_t>& source,
+                  std::vector<uint8_t>* target) {
+  return iree_lz4_block_decompress(
+      iree_make_const_byte_span(source.data(), source.size()),
+      iree_make_byte_span(target->data(), target->size()));
+}
+
+void ExpectRoundTrip(const std::vector<uint8_t>& source) {
+  std::vector<uint8_t> compressed = Compress(source);
+  EXPECT_LE(compressed.size(), iree_lz4_block_compress_bound(source.size()));
+  std::vector<uint8_t> decompressed(source.size());
+  IREE_ASSERT_OK(Decompress(compressed, &decompressed));
+  EXPECT_TRUE(decompressed == source);
+}
+
+TEST(LZ4Test, RoundTripSmall) {
+  for (size_t length = 0; length < 32; ++length) {
+    std::vector<uint8_t> source(length);
+    for (size_t i = 0; i < length; ++i) source[i] = (uint8_t)(i % 3);
+    ExpectRoundTrip(source);
+  }
+}
+
+TEST(LZ4Test, RoundTripZeros) {
+  std::vector<uint8_t> source(1024 * 1024);
+  std::vector<uint8_t> compressed = Compress(source);
+  EXPECT_LT(compressed.size(), source.size() / 100);
+  ExpectRoundTrip(source);
+}
+
+TEST(LZ4Test, RoundTripText) {
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "the quick brown fox " + std::to_string(i * 7) + " jumps over ";
+  }
+  std::vector<uint8_t> source(text.begin(), text.end());
+  std::vector<uint8_t> compressed = Compress(source);
+  EXPECT_LT(compressed.size(), source.size() / 2);
+  ExpectRoundTrip(source);
+}
+
+TEST(LZ4Test, RoundTripRandom) {
+  iree_prng_xoroshiro128_state_t prng;
+  iree_prng_xoroshiro128_initialize(/*seed=*/0x1234, &prng);
+  std::vector<uint8_t> source(300 * 1000);
+  for (auto& value : source) {
+    value = iree_prng_xoroshiro128plus_next_uint8(&prng);
+  }
+  ExpectRoundTrip(source);
+  // Repeat the random data so that long-distance matches are both found (within
+  // the 64KB window) and rejected (beyond it).
+  std::vector<uint8_t> repeated(source.begin(), source.begin() + 40000);
+  repeated.insert(repeated.end(), source.begin(), source.begin() + 40000);
+  repeated.insert(repeated.end(), source.begin(), source.end());
+  ExpectRoundTrip(repeated);
+}
+
+TEST(LZ4Test, CompressTargetTooSmall) {
+  std::vector<uint8_t> source(1000);
+  for (size_t i = 0; i < source.size(); ++i) source[i] = (uint8_t)(i * 13);
+  std::vector<uint8_t> target(100);
+  iree_host_size_t length = 0;
+  EXPECT_THAT(Status(iree_lz4_block_compress(
+                  iree_make_const_byte_span(source.data(), source.size()),
+                  iree_make_byte_span(target.data(), target.size()),
+                  &length)),
+              StatusIs(StatusCode::kResourceExhausted));
+}
+
+// Decodes a hand-assembled block containing an overlapping match.
+TEST(LZ4Test, DecompressReference) {
+  // "abc" + match(offset=3, length=15) + "abcab"
+  std::vector<uint8_t> block = {0x3B, 'a', 'b', 'c', 0x03, 0x00,
+                                0x50, 'a', 'b', 'c', 'a',  'b'};
+  std::vector<uint8_t> decompressed(23);
+  IREE_ASSERT_OK(Decompress(block, &decompressed));
+  EXPECT_EQ(std::string(decompressed.begin(), decompressed.end()),
+            "abcabcabcabcabcabcabcab");
+}
+
+TEST(LZ4Test, DecompressMalformed) {
+  std::vector<uint8_t> decompressed(23);
+  // Literals run past the end of the input.
+  EXPECT_THAT(Status(Decompress({0x50, 'a', 'b'}, &decompressed)),
+              StatusIs(StatusCode::kDataLoss));
+  // Offset reaches before the start of the output.
+  EXPECT_THAT(
+      Status(Decompress({0x1B, 'a', 0x03, 0x00, 0x00}, &decompressed)),
+      StatusIs(StatusCode::kDataLoss));
+  // Zero offset.
+  EXPECT_THAT(
+      Status(Decompress({0x1B, 'a', 0x00, 0x00, 0x00}, &decompressed)),
+      StatusIs(StatusCode::kDataLoss));
+  // Truncated offset.
+  EXPECT_THAT(Status(Decompress({0x1B, 'a', 0x01}, &decompressed)),
+              StatusIs(StatusCode::kDataLoss));
+  // Valid block but the output is larger than expected.
+  std::vector<uint8_t> small(8);
+  EXPECT_THAT(Status(Decompress({0x3B, 'a', 'b', 'c', 0x03, 0x00, 0x50, 'a',
+                                 'b', 'c', 'a', 'b'},
+                                &small)),
+              StatusIs(StatusCode::kDataLoss));
+  // Valid block but the output is smaller than expected.
+  std::vector<uint8_t> large(64);
+  EXPECT_THAT(Status(Decompress({0x30, 'a', 'b', 'c'}, &large)),
+              StatusIs(StatusCode::kDataLoss));
+}
+
+}  // namespace
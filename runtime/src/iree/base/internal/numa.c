@@ -0,0 +1,420 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// NOTE: must be first before _any_ system includes.
+#define _GNU_SOURCE
+
+#include "iree/base/internal/numa.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/call_once.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+
+//===----------------------------------------------------------------------===//
+// Placement policy parsing
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_numa_placement_parse(iree_string_view_t value,
+                                        iree_numa_placement_t* out_placement) {
+  IREE_ASSERT_ARGUMENT(out_placement);
+  if (iree_string_view_is_empty(value) ||
+      iree_string_view_equal(value, IREE_SV("default"))) {
+    *out_placement = IREE_NUMA_PLACEMENT_DEFAULT;
+  } else if (iree_string_view_equal(value, IREE_SV("first_touch"))) {
+    *out_placement = IREE_NUMA_PLACEMENT_FIRST_TOUCH;
+  } else if (iree_string_view_equal(value, IREE_SV("bind"))) {
+    *out_placement = IREE_NUMA_PLACEMENT_BIND;
+  } else if (iree_string_view_equal(value, IREE_SV("interleave"))) {
+    *out_placement = IREE_NUMA_PLACEMENT_INTERLEAVE;
+  } else {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unknown NUMA placement policy '%.*s'; expected "
+                            "one of [default, first_touch, bind, interleave]",
+                            (int)value.size, value.data);
+  }
+  return iree_ok_status();
+}
+
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// NOTE: we avoid a dependency on libnuma (and its headers) by issuing the
+// syscalls directly; the policy constants are ABI and defined here locally.
+#define IREE_MPOL_BIND 2
+#define IREE_MPOL_INTERLEAVE 3
+
+//===----------------------------------------------------------------------===//
+// NUMA node query (Linux)
+//===----------------------------------------------------------------------===//
+
+static iree_once_flag iree_numa_node_count_flag = IREE_ONCE_FLAG_INIT;
+static iree_host_size_t iree_numa_node_count_value = 1;
+
+// Parses the node list in /sys/devices/system/node/online (like `0-3` or
+// `0,2-3`) and returns the highest node ID + 1. Node IDs may be sparse but
+// callers treat them as dense so we report the range. `possible` is not used
+// as it includes nodes that may be hotplugged later (often all
+// CONFIG_NODES_SHIFT nodes on virtualized systems) and would have us spread
+// work and memory across nodes that do not exist.
+static void iree_numa_node_count_initialize(void) {
+  FILE* file = fopen("/sys/devices/system/node/online", "r");
+  if (!file) return;  // no NUMA support in the kernel
+  char buffer[256];
+  size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+  fclose(file);
+  buffer[length] = 0;
+  uint32_t max_node_id = 0;
+  uint32_t value = 0;
+  bool has_value = false;
+  for (size_t i = 0; i <= length; ++i) {
+    char c = buffer[i];
+    if (c >= '0' && c <= '9') {
+      value = value * 10 + (uint32_t)(c - '0');
+      has_value = true;
+    } else {
+      if (has_value && value > max_node_id) max_node_id = value;
+      value = 0;
+      has_value = false;
+    }
+  }
+  iree_numa_node_count_value =
+      iree_min((iree_host_size_t)max_node_id + 1, IREE_NUMA_MAX_NODE_COUNT);
+}
+
+iree_host_size_t iree_numa_node_count(void) {
+  iree_call_once(&iree_numa_node_count_flag, iree_numa_node_count_initialize);
+  return iree_numa_node_count_value;
+}
+
+iree_numa_node_id_t iree_numa_node_for_processor(uint32_t processor_id) {
+  iree_host_size_t node_count = iree_numa_node_count();
+  if (node_count <= 1) return 0;
+  // Each cpu directory contains a `nodeN` link to the node it belongs to.
+  char path[64];
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/node%u",
+             processor_id, (uint32_t)i);
+    if (access(path, F_OK) == 0) return (iree_numa_node_id_t)i;
+  }
+  return 0;
+}
+
+iree_numa_node_id_t iree_numa_node_current(void) {
+  if (iree_numa_node_count() <= 1) return 0;
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) return 0;
+  return iree_min((iree_numa_node_id_t)node, IREE_NUMA_MAX_NODE_COUNT - 1);
+}
+
+//===----------------------------------------------------------------------===//
+// NUMA-local host allocator (Linux)
+//===----------------------------------------------------------------------===//
+
+// Bytes reserved at the head of each allocation to store its header.
+// Kept at the max alignment so that the returned pointers remain aligned.
+#define IREE_NUMA_ALLOCATION_HEADER_SIZE 64
+
+// Header stored at the head of each allocation.
+typedef struct iree_numa_allocation_header_t {
+  // Total length of the mapping in bytes or 0 if the allocation is below the
+  // placement threshold and was made from the system allocator.
+  size_t mapped_length;
+  // Length of the allocation in bytes as requested by the user.
+  size_t byte_length;
+} iree_numa_allocation_header_t;
+static_assert(sizeof(iree_numa_allocation_header_t) <=
+                  IREE_NUMA_ALLOCATION_HEADER_SIZE,
+              "header must fit in the reserved bytes");
+
+static iree_numa_allocation_header_t* iree_numa_allocation_header(void* ptr) {
+  return (iree_numa_allocation_header_t*)((uint8_t*)ptr -
+                                          IREE_NUMA_ALLOCATION_HEADER_SIZE);
+}
+
+// Applies the |placement| memory policy to the given mapped range.
+// Failures are ignored: the pages will still be placed by first-touch.
+static void iree_numa_apply_placement(void* base_ptr, size_t length,
+                                      iree_numa_node_id_t node_id,
+                                      iree_numa_placement_t placement) {
+  iree_host_size_t node_count = iree_numa_node_count();
+  if (node_count <= 1) return;  // nothing to place
+  unsigned long node_mask[IREE_NUMA_MAX_NODE_COUNT / (8 * sizeof(long))];
+  memset(node_mask, 0, sizeof(node_mask));
+  int mode = 0;
+  switch (placement) {
+    case IREE_NUMA_PLACEMENT_BIND: {
+      if (node_id == IREE_NUMA_NODE_ID_ANY) node_id = iree_numa_node_current();
+      if (node_id >= node_count) return;
+      node_mask[node_id / (8 * sizeof(long))] |=
+          1ul << (node_id % (8 * sizeof(long)));
+      mode = IREE_MPOL_BIND;
+      break;
+    }
+    case IREE_NUMA_PLACEMENT_INTERLEAVE: {
+      for (iree_host_size_t i = 0; i < node_count; ++i) {
+        node_mask[i / (8 * sizeof(long))] |= 1ul << (i % (8 * sizeof(long)));
+      }
+      mode = IREE_MPOL_INTERLEAVE;
+      break;
+    }
+    default:
+      return;  // first-touch needs no policy
+  }
+  // NOTE: maxnode is the number of bits in the mask + 1 per the kernel ABI.
+  syscall(SYS_mbind, base_ptr, length, mode, node_mask,
+          (unsigned long)(sizeof(node_mask) * 8 + 1), 0);
+}
+
+// The allocator is stateless and packs its configuration into the self pointer
+// so that it can be passed around by value like iree_allocator_system():
+//   [0, 8): placement
+//   [8, 24): node ID (0xFFFF for any)
+//   [24, 30): log2 of the minimum placed allocation size
+#define IREE_NUMA_ALLOCATOR_PLACEMENT_BITS 8
+#define IREE_NUMA_ALLOCATOR_PLACEMENT_MASK \
+  ((1u << IREE_NUMA_ALLOCATOR_PLACEMENT_BITS) - 1)
+#define IREE_NUMA_ALLOCATOR_NODE_ID_SHIFT IREE_NUMA_ALLOCATOR_PLACEMENT_BITS
+#define IREE_NUMA_ALLOCATOR_NODE_ID_MASK 0xFFFFu
+#define IREE_NUMA_ALLOCATOR_MIN_SIZE_SHIFT 24
+#define IREE_NUMA_ALLOCATOR_MIN_SIZE_MASK 0x3Fu
+
+static void* iree_numa_allocator_pack(iree_numa_node_id_t node_id,
+                                      iree_numa_placement_t placement,
+                                      iree_host_size_t min_placed_size) {
+  uintptr_t packed_node_id = node_id == IREE_NUMA_NODE_ID_ANY
+                                 ? IREE_NUMA_ALLOCATOR_NODE_ID_MASK
+                                 : (node_id & IREE_NUMA_ALLOCATOR_NODE_ID_MASK);
+  uintptr_t min_size_log2 = 0;
+  while (min_size_log2 < IREE_NUMA_ALLOCATOR_MIN_SIZE_MASK &&
+         ((iree_host_size_t)1 << min_size_log2) < min_placed_size) {
+    ++min_size_log2;
+  }
+  return (void*)((min_size_log2 << IREE_NUMA_ALLOCATOR_MIN_SIZE_SHIFT) |
+                 (packed_node_id << IREE_NUMA_ALLOCATOR_NODE_ID_SHIFT) |
+                 ((uintptr_t)placement & IREE_NUMA_ALLOCATOR_PLACEMENT_MASK));
+}
+
+static void iree_numa_allocator_unpack(
+    void* self, iree_numa_node_id_t* out_node_id,
+    iree_numa_placement_t* out_placement,
+    iree_host_size_t* out_min_placed_size) {
+  uintptr_t packed = (uintptr_t)self;
+  uintptr_t packed_node_id = (packed >> IREE_NUMA_ALLOCATOR_NODE_ID_SHIFT) &
+                             IREE_NUMA_ALLOCATOR_NODE_ID_MASK;
+  *out_node_id = packed_node_id == IREE_NUMA_ALLOCATOR_NODE_ID_MASK
+                     ? IREE_NUMA_NODE_ID_ANY
+                     : (iree_numa_node_id_t)packed_node_id;
+  *out_placement =
+      (iree_numa_placement_t)(packed & IREE_NUMA_ALLOCATOR_PLACEMENT_MASK);
+  uintptr_t min_size_log2 = (packed >> IREE_NUMA_ALLOCATOR_MIN_SIZE_SHIFT) &
+                            IREE_NUMA_ALLOCATOR_MIN_SIZE_MASK;
+  *out_min_placed_size = min_size_log2 ? (iree_host_size_t)1 << min_size_log2
+                                       : 0;
+}
+
+// Allocates |byte_length| bytes from the system allocator for allocations
+// below the placement threshold. If |inout_ptr| references an existing
+// system allocation it is reallocated.
+static iree_status_t iree_numa_allocator_alloc_unplaced(
+    iree_allocator_command_t command, iree_host_size_t byte_length,
+    void** inout_ptr) {
+  iree_allocator_t system_allocator = iree_allocator_system();
+  void* base_ptr = *inout_ptr ? iree_numa_allocation_header(*inout_ptr) : NULL;
+  const iree_host_size_t length =
+      IREE_NUMA_ALLOCATION_HEADER_SIZE + byte_length;
+  if (base_ptr) {
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_realloc(system_allocator, length, &base_ptr));
+  } else if (command == IREE_ALLOCATOR_COMMAND_CALLOC) {
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_malloc(system_allocator, length, &base_ptr));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc_uninitialized(
+        system_allocator, length, &base_ptr));
+  }
+  iree_numa_allocation_header_t* header =
+      (iree_numa_allocation_header_t*)base_ptr;
+  header->mapped_length = 0;
+  header->byte_length = byte_length;
+  *inout_ptr = (uint8_t*)base_ptr + IREE_NUMA_ALLOCATION_HEADER_SIZE;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_numa_allocator_free(void** inout_ptr);
+
+static iree_status_t iree_numa_allocator_alloc(
+    iree_numa_node_id_t node_id, iree_numa_placement_t placement,
+    iree_host_size_t min_placed_size, iree_allocator_command_t command,
+    const iree_allocator_alloc_params_t* params, void** inout_ptr) {
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(inout_ptr);
+  if (IREE_UNLIKELY(params->byte_length == 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocations must be >0 bytes");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, params->byte_length);
+
+  void* existing_ptr =
+      command == IREE_ALLOCATOR_COMMAND_REALLOC ? *inout_ptr : NULL;
+  iree_numa_allocation_header_t* existing_header =
+      existing_ptr ? iree_numa_allocation_header(existing_ptr) : NULL;
+
+  // Small allocations are not worth a page-granular mapping and the syscalls
+  // to place it and are served from the system allocator. They move to a
+  // placed mapping if they grow beyond the threshold but placed mappings stay
+  // placed when shrunk.
+  if ((!existing_header || existing_header->mapped_length == 0) &&
+      params->byte_length < min_placed_size) {
+    void* ptr = existing_ptr;
+    iree_status_t status = iree_numa_allocator_alloc_unplaced(
+        command, params->byte_length, &ptr);
+    if (iree_status_is_ok(status)) *inout_ptr = ptr;
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  } else if (existing_header && existing_header->mapped_length == 0) {
+    void* new_ptr = NULL;
+    iree_status_t status = iree_numa_allocator_alloc(
+        node_id, placement, min_placed_size, IREE_ALLOCATOR_COMMAND_MALLOC,
+        params, &new_ptr);
+    if (iree_status_is_ok(status)) {
+      memcpy(new_ptr, existing_ptr,
+             iree_min(existing_header->byte_length, params->byte_length));
+      iree_numa_allocator_free(&existing_ptr);
+      *inout_ptr = new_ptr;
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t length = iree_host_align(
+      params->byte_length + IREE_NUMA_ALLOCATION_HEADER_SIZE, page_size);
+
+  uint8_t* base_ptr = NULL;
+  if (existing_header) {
+    // mremap preserves the memory policy of the mapping so we don't need to
+    // reapply the placement.
+    base_ptr = (uint8_t*)mremap(existing_header,
+                                existing_header->mapped_length, length,
+                                MREMAP_MAYMOVE);
+    if (base_ptr == MAP_FAILED) base_ptr = NULL;
+  } else {
+    // NOTE: anonymous mappings are always zero-filled and the pages are not
+    // populated until first touched so MALLOC and CALLOC are identical. We
+    // must not write to the pages here or we'd defeat first-touch placement.
+    base_ptr = (uint8_t*)mmap(NULL, length, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base_ptr == MAP_FAILED) {
+      base_ptr = NULL;
+    } else {
+      iree_numa_apply_placement(base_ptr, length, node_id, placement);
+    }
+  }
+  if (!base_ptr) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "NUMA allocator failed to map %zu bytes", length);
+  }
+
+  // Only the header page is touched by the allocating thread.
+  iree_numa_allocation_header_t* header =
+      (iree_numa_allocation_header_t*)base_ptr;
+  header->mapped_length = length;
+  header->byte_length = params->byte_length;
+  void* new_ptr = base_ptr + IREE_NUMA_ALLOCATION_HEADER_SIZE;
+  if (existing_ptr) {
+    IREE_TRACE_FREE(existing_ptr);
+  }
+  IREE_TRACE_ALLOC(new_ptr, params->byte_length);
+
+  *inout_ptr = new_ptr;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_numa_allocator_free(void** inout_ptr) {
+  IREE_ASSERT_ARGUMENT(inout_ptr);
+  void* ptr = *inout_ptr;
+  if (IREE_UNLIKELY(ptr == NULL)) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_numa_allocation_header_t* header = iree_numa_allocation_header(ptr);
+  if (header->mapped_length == 0) {
+    iree_allocator_free(iree_allocator_system(), header);
+  } else {
+    IREE_TRACE_FREE(ptr);
+    munmap(header, header->mapped_length);
+  }
+  *inout_ptr = NULL;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_numa_allocator_ctl(void* self,
+                                             iree_allocator_command_t command,
+                                             const void* params,
+                                             void** inout_ptr) {
+  iree_numa_node_id_t node_id = 0;
+  iree_numa_placement_t placement = IREE_NUMA_PLACEMENT_DEFAULT;
+  iree_host_size_t min_placed_size = 0;
+  iree_numa_allocator_unpack(self, &node_id, &placement, &min_placed_size);
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_MALLOC:
+    case IREE_ALLOCATOR_COMMAND_CALLOC:
+    case IREE_ALLOCATOR_COMMAND_REALLOC:
+      return iree_numa_allocator_alloc(
+          node_id, placement, min_placed_size, command,
+          (const iree_allocator_alloc_params_t*)params, inout_ptr);
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      return iree_numa_allocator_free(inout_ptr);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported NUMA allocator command");
+  }
+}
+
+iree_allocator_t iree_numa_allocator(iree_numa_node_id_t node_id,
+                                     iree_numa_placement_t placement,
+                                     iree_host_size_t min_placed_size) {
+  if (placement == IREE_NUMA_PLACEMENT_DEFAULT) return iree_allocator_system();
+  iree_allocator_t allocator = {
+      iree_numa_allocator_pack(node_id, placement, min_placed_size),
+      iree_numa_allocator_ctl,
+  };
+  return allocator;
+}
+
+#else
+
+//===----------------------------------------------------------------------===//
+// Fallback for platforms without NUMA support
+//===----------------------------------------------------------------------===//
+
+// TODO: use GetNumaHighestNodeNumber/VirtualAllocExNuma on Windows.
+
+iree_host_size_t iree_numa_node_count(void) { return 1; }
+
+iree_numa_node_id_t iree_numa_node_for_processor(uint32_t processor_id) {
+  return 0;
+}
+
+iree_numa_node_id_t iree_numa_node_current(void) { return 0; }
+
+iree_allocator_t iree_numa_allocator(iree_numa_node_id_t node_id,
+                                     iree_numa_placement_t placement,
+                                     iree_host_size_t min_placed_size) {
+  return iree_allocator_system();
+}
+
+#endif  // IREE_PLATFORM_*
@@ -0,0 +1,94 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_NUMA_H_
+#define IREE_BASE_INTERNAL_NUMA_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// NUMA node query
+//===----------------------------------------------------------------------===//
+
+// Identifies a NUMA node in the system. Node IDs are dense in [0, node_count).
+typedef uint32_t iree_numa_node_id_t;
+
+// Indicates that any node may be used.
+#define IREE_NUMA_NODE_ID_ANY UINT32_MAX
+
+// Maximum number of NUMA nodes supported. Systems reporting more nodes will
+// have the excess nodes folded into the last supported node.
+#define IREE_NUMA_MAX_NODE_COUNT 64
+
+// Returns the total number of NUMA nodes in the system.
+// Always returns at least 1; systems without NUMA support (or platforms where
+// we can't query it) are treated as a single node containing all processors.
+iree_host_size_t iree_numa_node_count(void);
+
+// Returns the NUMA node the logical processor with the given platform
+// |processor_id| (linux cpu ID, etc) is attached to or 0 if unknown.
+iree_numa_node_id_t iree_numa_node_for_processor(uint32_t processor_id);
+
+// Returns the NUMA node of the processor executing this code or 0 if unknown.
+// Note that unless the calling thread is pinned the result may be stale by the
+// time it is used.
+iree_numa_node_id_t iree_numa_node_current(void);
+
+//===----------------------------------------------------------------------===//
+// NUMA-local host allocator
+//===----------------------------------------------------------------------===//
+
+// Defines how pages backing allocations are placed across NUMA nodes.
+typedef enum iree_numa_placement_e {
+  // Uses the default policy of the calling thread (usually the system
+  // allocator with whatever policy the process was launched with).
+  IREE_NUMA_PLACEMENT_DEFAULT = 0,
+  // Allocations are reserved but not touched by the allocator so that pages
+  // are placed on the node of the thread that first writes to them. This
+  // is the cheapest policy and works well when the thread initializing the
+  // memory is the same one (or on the same node as the ones) using it.
+  IREE_NUMA_PLACEMENT_FIRST_TOUCH,
+  // Pages are bound to the allocator node regardless of which thread touches
+  // them first. Falls back to first-touch if the kernel rejects the binding.
+  IREE_NUMA_PLACEMENT_BIND,
+  // Pages are interleaved across all nodes. Useful for large shared data that
+  // is accessed uniformly by workers on every node.
+  IREE_NUMA_PLACEMENT_INTERLEAVE,
+} iree_numa_placement_t;
+
+// Parses a placement policy name ("default", "first_touch", "bind",
+// "interleave") into |out_placement|.
+iree_status_t iree_numa_placement_parse(iree_string_view_t value,
+                                        iree_numa_placement_t* out_placement);
+
+// Default minimum allocation size placed by iree_numa_allocator. Smaller
+// allocations are not worth a page-granular mapping and are usually transient.
+#define IREE_NUMA_ALLOCATOR_DEFAULT_MIN_PLACED_SIZE (64 * 1024)
+
+// Returns an allocator that places the pages of its allocations according to
+// |placement| relative to |node_id|. The allocator has no state and need not
+// be freed.
+//
+// Allocations of at least |min_placed_size| bytes (rounded up to a power of
+// two) are made at page granularity directly from the OS. Smaller allocations
+// are made from iree_allocator_system() and are not placed. On platforms
+// without NUMA support or with IREE_NUMA_PLACEMENT_DEFAULT this behaves the
+// same as iree_allocator_system().
+iree_allocator_t iree_numa_allocator(iree_numa_node_id_t node_id,
+                                     iree_numa_placement_t placement,
+                                     iree_host_size_t min_placed_size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_NUMA_H_
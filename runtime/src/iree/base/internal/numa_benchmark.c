@@ -0,0 +1,135 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/numa.h"
+#include "iree/testing/benchmark.h"
+
+// Large enough to defeat the last level cache on most server parts so that we
+// are measuring DRAM (and interconnect) bandwidth.
+#define IREE_NUMA_BENCHMARK_BYTE_LENGTH (256 * 1024 * 1024)
+
+// Describes where the benchmarked memory is placed relative to the node of the
+// thread running the benchmark.
+typedef struct iree_numa_benchmark_params_t {
+  iree_numa_placement_t placement;
+  // Offset added to the calling node (modulo node count) to select the target
+  // node: 0 is local and 1 is the next (remote) node.
+  uint32_t node_offset;
+} iree_numa_benchmark_params_t;
+
+// Streams through |byte_length| bytes at |ptr| and returns a checksum so that
+// the reads can't be elided.
+static uint64_t iree_numa_benchmark_read(const uint64_t* ptr,
+                                         iree_host_size_t byte_length) {
+  uint64_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  for (iree_host_size_t i = 0; i < byte_length / sizeof(uint64_t); i += 4) {
+    sum0 += ptr[i + 0];
+    sum1 += ptr[i + 1];
+    sum2 += ptr[i + 2];
+    sum3 += ptr[i + 3];
+  }
+  return sum0 + sum1 + sum2 + sum3;
+}
+
+// Measures read bandwidth of memory allocated with the placement described by
+// the iree_numa_benchmark_params_t in user_data.
+static iree_status_t iree_numa_benchmark_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_numa_benchmark_params_t* params =
+      (const iree_numa_benchmark_params_t*)benchmark_def->user_data;
+
+  const iree_host_size_t node_count = iree_numa_node_count();
+  if (params->node_offset > 0 && node_count < 2) {
+    iree_benchmark_skip(benchmark_state, "requires a multi-node system");
+    return iree_ok_status();
+  }
+  const iree_numa_node_id_t current_node = iree_numa_node_current();
+  const iree_numa_node_id_t target_node =
+      (current_node + params->node_offset) % node_count;
+
+  // Memory is touched first by this thread; for first-touch this places the
+  // pages on the current node while bind/interleave override it.
+  iree_allocator_t allocator =
+      iree_numa_allocator(target_node, params->placement,
+                          IREE_NUMA_ALLOCATOR_DEFAULT_MIN_PLACED_SIZE);
+  uint64_t* ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc_uninitialized(
+      allocator, IREE_NUMA_BENCHMARK_BYTE_LENGTH, (void**)&ptr));
+  memset(ptr, 1, IREE_NUMA_BENCHMARK_BYTE_LENGTH);
+
+  int64_t iteration_count = 0;
+  volatile uint64_t sink = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    sink += iree_numa_benchmark_read(ptr, IREE_NUMA_BENCHMARK_BYTE_LENGTH);
+    ++iteration_count;
+  }
+  (void)sink;
+  iree_benchmark_set_bytes_processed(
+      benchmark_state, iteration_count * IREE_NUMA_BENCHMARK_BYTE_LENGTH);
+
+  char label[64];
+  snprintf(label, sizeof(label), "node=%u/%" PRIhsz " target=%u",
+           current_node, node_count, target_node);
+  iree_benchmark_set_label(benchmark_state, label);
+
+  iree_allocator_free(allocator, ptr);
+  return iree_ok_status();
+}
+
+static const iree_numa_benchmark_params_t iree_numa_benchmark_system = {
+    .placement = IREE_NUMA_PLACEMENT_DEFAULT,
+};
+static const iree_numa_benchmark_params_t iree_numa_benchmark_first_touch = {
+    .placement = IREE_NUMA_PLACEMENT_FIRST_TOUCH,
+};
+static const iree_numa_benchmark_params_t iree_numa_benchmark_bind_local = {
+    .placement = IREE_NUMA_PLACEMENT_BIND,
+    .node_offset = 0,
+};
+static const iree_numa_benchmark_params_t iree_numa_benchmark_bind_remote = {
+    .placement = IREE_NUMA_PLACEMENT_BIND,
+    .node_offset = 1,
+};
+static const iree_numa_benchmark_params_t iree_numa_benchmark_interleave = {
+    .placement = IREE_NUMA_PLACEMENT_INTERLEAVE,
+};
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MILLISECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_numa_benchmark_run,
+  };
+  benchmark_def.user_data = &iree_numa_benchmark_system;
+  iree_benchmark_register(iree_make_cstring_view("read_system"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_numa_benchmark_first_touch;
+  iree_benchmark_register(iree_make_cstring_view("read_first_touch"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_numa_benchmark_bind_local;
+  iree_benchmark_register(iree_make_cstring_view("read_bind_local"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_numa_benchmark_bind_remote;
+  iree_benchmark_register(iree_make_cstring_view("read_bind_remote"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_numa_benchmark_interleave;
+  iree_benchmark_register(iree_make_cstring_view("read_interleave"),
+                          &benchmark_def);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
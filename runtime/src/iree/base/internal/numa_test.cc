@@ -0,0 +1,105 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/numa.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+TEST(NumaTest, NodeQuery) {
+  iree_host_size_t node_count = iree_numa_node_count();
+  EXPECT_GE(node_count, 1);
+  EXPECT_LE(node_count, IREE_NUMA_MAX_NODE_COUNT);
+  EXPECT_LT(iree_numa_node_current(), node_count);
+  EXPECT_LT(iree_numa_node_for_processor(0), node_count);
+}
+
+TEST(NumaTest, ParsePlacement) {
+  iree_numa_placement_t placement = IREE_NUMA_PLACEMENT_DEFAULT;
+  IREE_EXPECT_OK(iree_numa_placement_parse(IREE_SV("bind"), &placement));
+  EXPECT_EQ(placement, IREE_NUMA_PLACEMENT_BIND);
+  IREE_EXPECT_OK(
+      iree_numa_placement_parse(IREE_SV("first_touch"), &placement));
+  EXPECT_EQ(placement, IREE_NUMA_PLACEMENT_FIRST_TOUCH);
+  IREE_EXPECT_OK(iree_numa_placement_parse(IREE_SV("interleave"), &placement));
+  EXPECT_EQ(placement, IREE_NUMA_PLACEMENT_INTERLEAVE);
+  IREE_EXPECT_OK(iree_numa_placement_parse(IREE_SV(""), &placement));
+  EXPECT_EQ(placement, IREE_NUMA_PLACEMENT_DEFAULT);
+  EXPECT_THAT(
+      iree::Status(iree_numa_placement_parse(IREE_SV("nope"), &placement)),
+      StatusIs(iree::StatusCode::kInvalidArgument));
+}
+
+class NumaAllocatorTest
+    : public ::testing::TestWithParam<iree_numa_placement_t> {};
+
+TEST_P(NumaAllocatorTest, Lifetime) {
+  iree_allocator_t allocator = iree_numa_allocator(
+      iree_numa_node_current(), GetParam(), /*min_placed_size=*/0);
+
+  // Calloc must return zeros and the pointer must be usable.
+  uint8_t* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 123, (void**)&ptr));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % iree_max_align_t);
+  for (int i = 0; i < 123; ++i) EXPECT_EQ(ptr[i], 0);
+  std::memset(ptr, 0xCD, 123);
+
+  // Growing must preserve contents.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 64 * 1024, (void**)&ptr));
+  for (int i = 0; i < 123; ++i) EXPECT_EQ(ptr[i], 0xCD);
+  ptr[64 * 1024 - 1] = 0xAB;
+
+  // Shrinking must preserve contents up to the new size.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 100, (void**)&ptr));
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(ptr[i], 0xCD);
+
+  iree_allocator_free(allocator, ptr);
+}
+
+// Allocations below the threshold come from the system allocator and must
+// move to a placed mapping when they grow past it.
+TEST_P(NumaAllocatorTest, MinPlacedSize) {
+  iree_allocator_t allocator = iree_numa_allocator(
+      iree_numa_node_current(), GetParam(), /*min_placed_size=*/4096);
+
+  uint8_t* small_ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 16, (void**)&small_ptr));
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(small_ptr) % iree_max_align_t);
+  for (int i = 0; i < 16; ++i) EXPECT_EQ(small_ptr[i], 0);
+  std::memset(small_ptr, 0xCD, 16);
+
+  // Growing within the threshold stays unplaced.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 123, (void**)&small_ptr));
+  for (int i = 0; i < 16; ++i) EXPECT_EQ(small_ptr[i], 0xCD);
+  std::memset(small_ptr, 0xCD, 123);
+
+  // Growing past the threshold moves the contents to a placed mapping.
+  IREE_ASSERT_OK(
+      iree_allocator_realloc(allocator, 64 * 1024, (void**)&small_ptr));
+  for (int i = 0; i < 123; ++i) EXPECT_EQ(small_ptr[i], 0xCD);
+  small_ptr[64 * 1024 - 1] = 0xAB;
+
+  // Shrinking a placed mapping keeps it placed.
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 100, (void**)&small_ptr));
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(small_ptr[i], 0xCD);
+
+  iree_allocator_free(allocator, small_ptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllPlacements, NumaAllocatorTest,
+                         ::testing::Values(IREE_NUMA_PLACEMENT_DEFAULT,
+                                           IREE_NUMA_PLACEMENT_FIRST_TOUCH,
+                                           IREE_NUMA_PLACEMENT_BIND,
+                                           IREE_NUMA_PLACEMENT_INTERLEAVE));
+
+}  // namespace
@@ -7,60 +7,633 @@
 // NOTE: must be first to ensure that we can define settings for all includes.
 #include "iree/base/internal/wait_handle_impl.h"
 
-#if IREE_WAIT_API == IREE_WAIT_API_EPOLL
+#if IREE_WAIT_API == IREE_WAIT_API_EPOLL || \
+    IREE_WAIT_API == IREE_WAIT_API_IO_URING
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "iree/base/internal/wait_handle_posix.h"
 #include "iree/base/tracing.h"
 
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+#include <linux/io_uring.h>
+
+#include "iree/base/internal/io_uring.h"
+#endif  // IREE_WAIT_API_IO_URING
+
 //===----------------------------------------------------------------------===//
 // iree_wait_set_t
 //===----------------------------------------------------------------------===//
 
-// TODO(benvanik): iree_wait_set_s using an epoll fd.
-// epoll lets us route the wait set operations right to kernel and not need our
-// own duplicate data structure. epoll is great, just not available on mac/ios
-// so we still need poll for that. linux/android/bsd all have epoll, though.
+// Unlike the poll/ppoll implementation the kernel tracks the set of handles
+// and we never rebuild or rescan the full list on each wait. Handles are
+// indexed by their fd so insertion and erasure are O(1) regardless of how many
+// handles are in the set and storage is grown on demand.
+//
+// When IREE_WAIT_API_IO_URING is used we try to create an io_uring and fall
+// back to epoll if the kernel doesn't support it (or it's disabled by policy).
+// With io_uring each handle has a one-shot IORING_OP_POLL_ADD in flight while
+// it is being waited on. New and re-armed polls are batched and submitted with
+// the same io_uring_enter that waits for completions and every completion
+// available after a wake is drained at once. Polls stay armed across waits so
+// sets with thousands of mostly-idle handles only pay for the handles that
+// changed since the last wait.
+//
+// With epoll the handles are registered level-triggered on insertion and
+// unregistered on erasure.
+
+typedef enum iree_wait_set_entry_state_e {
+  // Entry is unused.
+  IREE_WAIT_SET_ENTRY_FREE = 0,
+  // Handle is in the set but not yet armed in the kernel (io_uring only).
+  IREE_WAIT_SET_ENTRY_IDLE,
+  // Handle has an in-flight poll (io_uring) or is registered (epoll).
+  IREE_WAIT_SET_ENTRY_ARMED,
+  // Handle was signaled during the current wait.
+  IREE_WAIT_SET_ENTRY_FIRED,
+} iree_wait_set_entry_state_t;
+
+typedef struct iree_wait_set_entry_t {
+  // Bumped each time the entry is freed so that completions of in-flight polls
+  // for prior uses of the fd can be ignored.
+  uint32_t generation;
+  // Number of additional insertions of the same handle.
+  uint16_t dupe_count;
+  // iree_wait_set_entry_state_t.
+  uint8_t state;
+  // True if the entry is in the arm_list.
+  uint8_t queued;
+  // User-provided handle.
+  iree_wait_handle_t handle;
+} iree_wait_set_entry_t;
+
+// user_data of io_uring operations whose completions we don't care about.
+#define IREE_WAIT_SET_IGNORED_USER_DATA UINT64_MAX
+
+// Maximum number of epoll events returned from a single epoll_wait.
+#define IREE_WAIT_SET_MAX_EPOLL_EVENTS 64
+
 struct iree_wait_set_t {
-  // NOTE: we could in theory use the epoll handle directly (iree_wait_set_s
-  // then is just a pointer). Then allocate/free just go straight to the system.
-  int reserved;
+  iree_allocator_t allocator;
+
+  // Maximum number of unique handles in the set.
+  iree_host_size_t handle_capacity;
+  // Number of unique handles in the set (ignoring duplicates).
+  iree_host_size_t handle_count;
+
+  // Entries indexed by fd; grown on demand to cover the largest fd inserted.
+  iree_host_size_t entry_capacity;
+  iree_wait_set_entry_t* entries;
+
+  // fds of IDLE entries that need to be armed on the next wait (io_uring).
+  iree_host_size_t arm_count;
+  int* arm_list;
+
+  // fds of entries that FIRED during the current wait.
+  iree_host_size_t fired_count;
+  int* fired_list;
+
+  // epoll instance used when io_uring is not available. -1 if unused.
+  int epoll_fd;
+
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  // Ring used for polling. Uninitialized if unavailable.
+  iree_io_uring_t ring;
+#endif  // IREE_WAIT_API_IO_URING
 };
 
+static bool iree_wait_set_uses_io_uring(const iree_wait_set_t* set) {
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  return iree_io_uring_is_initialized(&set->ring);
+#else
+  return false;
+#endif  // IREE_WAIT_API_IO_URING
+}
+
 iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
                                      iree_allocator_t allocator,
                                      iree_wait_set_t** out_set) {
-  // TODO(benvanik): epoll_create()
+  IREE_ASSERT_ARGUMENT(out_set);
+  *out_set = NULL;
+
+  // Storage is allocated on demand so large capacities only cost when used;
+  // we still reject those that can't be represented in the set_internal index.
+  if (capacity >= UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait set capacity of %zu is unreasonably large",
+                            capacity);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, sizeof(*set), (void**)&set));
+  set->allocator = allocator;
+  set->handle_capacity = capacity;
+  set->epoll_fd = -1;
+
+  iree_status_t status = iree_ok_status();
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  // The submission queue only needs to hold the polls armed in a single wait;
+  // larger batches are flushed automatically.
+  iree_status_t ring_status = iree_io_uring_initialize(
+      (uint32_t)iree_max(8, iree_min(capacity, 256)), &set->ring);
+  if (!iree_status_is_ok(ring_status)) {
+    // Fall back to epoll.
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "io_uring unavailable");
+    iree_status_ignore(ring_status);
+  }
+#endif  // IREE_WAIT_API_IO_URING
+  if (!iree_wait_set_uses_io_uring(set)) {
+    set->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (set->epoll_fd < 0) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "epoll_create1 failed (%d)", errno);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_set = set;
+  } else {
+    iree_wait_set_free(set);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 void iree_wait_set_free(iree_wait_set_t* set) {
-  // TODO(benvanik): close()
+  if (!set) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  // Closing the ring/epoll fd drops any in-flight polls.
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  iree_io_uring_deinitialize(&set->ring);
+#endif  // IREE_WAIT_API_IO_URING
+  if (set->epoll_fd >= 0) close(set->epoll_fd);
+  iree_allocator_free(set->allocator, set->entries);
+  iree_allocator_free(set->allocator, set->arm_list);
+  iree_allocator_free(set->allocator, set->fired_list);
+  iree_allocator_free(set->allocator, set);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+bool iree_wait_set_is_empty(const iree_wait_set_t* set) {
+  return set->handle_count == 0;
+}
+
+// Grows the entry storage such that |fd| can be indexed.
+static iree_status_t iree_wait_set_reserve(iree_wait_set_t* set, int fd) {
+  if ((iree_host_size_t)fd < set->entry_capacity) return iree_ok_status();
+  iree_host_size_t new_capacity = iree_max(64, set->entry_capacity);
+  while (new_capacity <= (iree_host_size_t)fd) new_capacity *= 2;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)new_capacity);
+  iree_status_t status = iree_allocator_realloc(
+      set->allocator, new_capacity * sizeof(*set->entries),
+      (void**)&set->entries);
+  if (iree_status_is_ok(status)) {
+    memset(&set->entries[set->entry_capacity], 0,
+           (new_capacity - set->entry_capacity) * sizeof(*set->entries));
+    // Each fd is in each list at most once.
+    status = iree_allocator_realloc(set->allocator,
+                                    new_capacity * sizeof(*set->arm_list),
+                                    (void**)&set->arm_list);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_realloc(set->allocator,
+                                    new_capacity * sizeof(*set->fired_list),
+                                    (void**)&set->fired_list);
+  }
+  if (iree_status_is_ok(status)) {
+    set->entry_capacity = new_capacity;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Queues |fd| to be armed on the next wait.
+static void iree_wait_set_queue_arm(iree_wait_set_t* set, int fd) {
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  entry->state = IREE_WAIT_SET_ENTRY_IDLE;
+  if (!entry->queued) {
+    entry->queued = 1;
+    set->arm_list[set->arm_count++] = fd;
+  }
+}
+
+// Marks |fd| as fired in the current wait.
+static void iree_wait_set_mark_fired(iree_wait_set_t* set, int fd) {
+  set->entries[fd].state = IREE_WAIT_SET_ENTRY_FIRED;
+  set->fired_list[set->fired_count++] = fd;
+}
+
+static iree_status_t iree_wait_set_epoll_ctl(iree_wait_set_t* set, int op,
+                                             int fd, uint32_t events) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(set->epoll_fd, op, fd, &event) < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "epoll_ctl(%d) failed on fd %d (%d)", op, fd,
+                            errno);
+  }
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_set_insert(iree_wait_set_t* set,
                                    iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_ADD)
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  if (IREE_UNLIKELY(fd < 0)) {
+    // Immediate handles have nothing to wait on; like poll we ignore them.
+    return iree_ok_status();
+  }
+
+  if ((iree_host_size_t)fd < set->entry_capacity &&
+      set->entries[fd].state != IREE_WAIT_SET_ENTRY_FREE) {
+    // Already present; just track the duplicate.
+    iree_wait_set_entry_t* entry = &set->entries[fd];
+    if (IREE_UNLIKELY(entry->dupe_count == UINT16_MAX)) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "too many duplicate wait handles");
+    }
+    ++entry->dupe_count;
+    return iree_ok_status();
+  }
+
+  if (set->handle_count + 1 > set->handle_capacity) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "wait set capacity reached");
+  }
+  IREE_RETURN_IF_ERROR(iree_wait_set_reserve(set, fd));
+
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  entry->dupe_count = 0;
+  iree_wait_handle_wrap_primitive(handle.type, handle.value, &entry->handle);
+  if (iree_wait_set_uses_io_uring(set)) {
+    // Armed lazily on the next wait so inserts are batched.
+    iree_wait_set_queue_arm(set, fd);
+  } else {
+    IREE_RETURN_IF_ERROR(iree_wait_set_epoll_ctl(set, EPOLL_CTL_ADD, fd,
+                                                 EPOLLIN | EPOLLPRI));
+    entry->state = IREE_WAIT_SET_ENTRY_ARMED;
+  }
+  ++set->handle_count;
+  return iree_ok_status();
+}
+
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+// Returns the io_uring user_data used for polls of |fd|.
+static uint64_t iree_wait_set_entry_user_data(const iree_wait_set_t* set,
+                                              int fd) {
+  return ((uint64_t)set->entries[fd].generation << 32) | (uint32_t)fd;
+}
+#endif  // IREE_WAIT_API_IO_URING
+
+// Disarms any in-flight poll or registration of |fd| and frees the entry.
+static void iree_wait_set_release_entry(iree_wait_set_t* set, int fd) {
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  if (iree_wait_set_uses_io_uring(set)) {
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+    if (entry->state == IREE_WAIT_SET_ENTRY_ARMED) {
+      // Cancel the poll; the cancellation is submitted with the next wait and
+      // both its completion and the poll completion will be ignored.
+      struct io_uring_sqe* sqe = NULL;
+      iree_status_t status = iree_io_uring_acquire_sqe(&set->ring, &sqe);
+      if (iree_status_is_ok(status)) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = iree_wait_set_entry_user_data(set, fd);
+        sqe->user_data = IREE_WAIT_SET_IGNORED_USER_DATA;
+      } else {
+        // The poll will remain in flight until it fires or the set is freed;
+        // its completion will be ignored as the generation no longer matches.
+        iree_status_ignore(status);
+      }
+    }
+#endif  // IREE_WAIT_API_IO_URING
+  } else {
+    // The fd may have already been closed (which implicitly unregisters it).
+    iree_status_ignore(iree_wait_set_epoll_ctl(set, EPOLL_CTL_DEL, fd, 0));
+  }
+  entry->state = IREE_WAIT_SET_ENTRY_FREE;
+  entry->dupe_count = 0;
+  ++entry->generation;
 }
 
 void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {
-  // TODO(benvanik): epoll_ctl(EPOLL_CTL_DEL)
+  int fd = iree_wait_primitive_get_read_fd(&handle);
+  if (fd < 0 || (iree_host_size_t)fd >= set->entry_capacity) return;
+  iree_wait_set_entry_t* entry = &set->entries[fd];
+  if (entry->state == IREE_WAIT_SET_ENTRY_FREE) return;
+  if (entry->dupe_count > 0) {
+    --entry->dupe_count;
+    return;
+  }
+  iree_wait_set_release_entry(set, fd);
+  --set->handle_count;
 }
 
 void iree_wait_set_clear(iree_wait_set_t* set) {
-  // TODO(benvanik): close and reopen?
+  for (iree_host_size_t fd = 0; fd < set->entry_capacity; ++fd) {
+    if (set->entries[fd].state != IREE_WAIT_SET_ENTRY_FREE) {
+      iree_wait_set_release_entry(set, (int)fd);
+    }
+    set->entries[fd].queued = 0;
+  }
+  set->handle_count = 0;
+  set->arm_count = 0;
+}
+
+// Maps poll revents to a status (on failure) and whether the fd is signaled.
+static iree_status_t iree_wait_set_resolve_events(uint32_t events,
+                                                  bool* out_signaled) {
+  if (events & POLLERR) {
+    return iree_make_status(IREE_STATUS_INTERNAL, "POLLERR on fd");
+  } else if (events & POLLHUP) {
+    return iree_make_status(IREE_STATUS_CANCELLED, "POLLHUP on fd");
+  } else if (events & POLLNVAL) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "POLLNVAL on fd");
+  }
+  *out_signaled = (events & (POLLIN | POLLPRI)) != 0;
+  return iree_ok_status();
+}
+
+// Re-arms all entries that fired during the current wait so that they are
+// polled again on the next wait.
+static void iree_wait_set_rearm_fired(iree_wait_set_t* set) {
+  for (iree_host_size_t i = 0; i < set->fired_count; ++i) {
+    int fd = set->fired_list[i];
+    iree_wait_set_entry_t* entry = &set->entries[fd];
+    if (entry->state != IREE_WAIT_SET_ENTRY_FIRED) continue;
+    if (iree_wait_set_uses_io_uring(set)) {
+      iree_wait_set_queue_arm(set, fd);
+    } else {
+      // Re-enable entries disabled during iree_wait_all. If this fails we
+      // drop the handle from the kernel set and the wait will fail later.
+      iree_status_ignore(iree_wait_set_epoll_ctl(set, EPOLL_CTL_MOD, fd,
+                                                 EPOLLIN | EPOLLPRI));
+      entry->state = IREE_WAIT_SET_ENTRY_ARMED;
+    }
+  }
+  set->fired_count = 0;
+}
+
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+
+// Queues polls for all IDLE entries.
+static iree_status_t iree_wait_set_arm_pending(iree_wait_set_t* set) {
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t i = 0;
+  for (; i < set->arm_count; ++i) {
+    int fd = set->arm_list[i];
+    iree_wait_set_entry_t* entry = &set->entries[fd];
+    if (entry->state != IREE_WAIT_SET_ENTRY_IDLE) {
+      // Erased (and possibly re-added and armed) since queued.
+      entry->queued = 0;
+      continue;
+    }
+    struct io_uring_sqe* sqe = NULL;
+    status = iree_io_uring_acquire_sqe(&set->ring, &sqe);
+    if (!iree_status_is_ok(status)) break;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN | POLLPRI;
+    sqe->user_data = iree_wait_set_entry_user_data(set, fd);
+    entry->state = IREE_WAIT_SET_ENTRY_ARMED;
+    entry->queued = 0;
+  }
+  // Keep any we failed to arm for the next attempt.
+  memmove(set->arm_list, &set->arm_list[i],
+          (set->arm_count - i) * sizeof(*set->arm_list));
+  set->arm_count -= i;
+  return status;
+}
+
+// Drains all available completions and marks the entries they belong to.
+// When |rearm_signaled| is set signaled entries are re-armed instead of being
+// marked as fired: completions that arrived before the current wait began may
+// be stale if the handle was reset in the meantime and polling again will
+// report the current state.
+static iree_status_t iree_wait_set_reap(iree_wait_set_t* set,
+                                        bool rearm_signaled) {
+  iree_status_t status = iree_ok_status();
+  uint64_t user_data = 0;
+  int32_t result = 0;
+  while (iree_io_uring_pop_cqe(&set->ring, &user_data, &result)) {
+    if (user_data == IREE_WAIT_SET_IGNORED_USER_DATA) continue;
+    int fd = (int)(uint32_t)user_data;
+    uint32_t generation = (uint32_t)(user_data >> 32);
+    if ((iree_host_size_t)fd >= set->entry_capacity) continue;
+    iree_wait_set_entry_t* entry = &set->entries[fd];
+    if (entry->generation != generation ||
+        entry->state != IREE_WAIT_SET_ENTRY_ARMED) {
+      continue;  // stale completion from a prior use of the fd
+    }
+    bool signaled = false;
+    if (result < 0 || rearm_signaled) {
+      // Leave the entry disarmed so the next arm tries again.
+      iree_wait_set_queue_arm(set, fd);
+      if (result < 0 && result != -ECANCELED && result != -EINTR &&
+          iree_status_is_ok(status)) {
+        status = iree_make_status(iree_status_code_from_errno(-result),
+                                  "io_uring poll failed on fd %d (%d)", fd,
+                                  -result);
+      }
+      continue;
+    }
+    iree_status_t event_status =
+        iree_wait_set_resolve_events((uint32_t)result, &signaled);
+    if (signaled || !iree_status_is_ok(event_status)) {
+      iree_wait_set_mark_fired(set, fd);
+    }
+    if (iree_status_is_ok(status)) {
+      status = event_status;
+    } else {
+      iree_status_ignore(event_status);
+    }
+  }
+  return status;
+}
+
+// Waits until |signaled_target| entries have fired or |deadline_ns| elapses.
+static iree_status_t iree_wait_set_wait_io_uring(
+    iree_wait_set_t* set, iree_host_size_t signaled_target,
+    iree_time_t deadline_ns) {
+  // Completions may have arrived since the last wait; they'll be re-armed
+  // alongside any new handles and complete immediately if still signaled.
+  IREE_RETURN_IF_ERROR(iree_wait_set_reap(set, /*rearm_signaled=*/true));
+  IREE_RETURN_IF_ERROR(iree_wait_set_arm_pending(set));
+  while (set->fired_count < signaled_target) {
+    // Submits any pending polls/cancellations in the same syscall.
+    iree_status_t status =
+        iree_io_uring_enter(&set->ring, /*min_complete=*/1, deadline_ns);
+    if (iree_status_is_deadline_exceeded(status)) {
+      // Handled below after draining whatever did complete.
+      iree_status_ignore(status);
+      status = iree_ok_status();
+    }
+    IREE_RETURN_IF_ERROR(status);
+    IREE_RETURN_IF_ERROR(iree_wait_set_reap(set, /*rearm_signaled=*/false));
+    if (set->fired_count < signaled_target &&
+        (deadline_ns == IREE_TIME_INFINITE_PAST ||
+         (deadline_ns != IREE_TIME_INFINITE_FUTURE &&
+          iree_time_now() >= deadline_ns))) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+  }
+  return iree_ok_status();
+}
+
+#endif  // IREE_WAIT_API_IO_URING
+
+// Waits on the epoll set until |signaled_target| entries have fired or
+// |deadline_ns| elapses. When |disable_fired| is set fired entries are removed
+// from the kernel set for the remainder of the wait.
+static iree_status_t iree_wait_set_wait_epoll(iree_wait_set_t* set,
+                                              iree_host_size_t signaled_target,
+                                              bool disable_fired,
+                                              iree_time_t deadline_ns) {
+  struct epoll_event events[IREE_WAIT_SET_MAX_EPOLL_EVENTS];
+  while (set->fired_count < signaled_target) {
+    int rv = -1;
+    do {
+      // Recomputed each iteration as a prior attempt may have taken time.
+      uint32_t timeout_ms = iree_absolute_deadline_to_timeout_ms(deadline_ns);
+      rv = epoll_wait(set->epoll_fd, events, IREE_ARRAYSIZE(events),
+                      (int)timeout_ms);
+    } while (rv < 0 && errno == EINTR);
+    if (rv < 0) {
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "epoll_wait failure %d", errno);
+    } else if (rv == 0) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    for (int i = 0; i < rv; ++i) {
+      int fd = events[i].data.fd;
+      if (set->entries[fd].state != IREE_WAIT_SET_ENTRY_ARMED) continue;
+      bool signaled = false;
+      iree_status_t status =
+          iree_wait_set_resolve_events(events[i].events, &signaled);
+      if (!signaled && iree_status_is_ok(status)) continue;
+      iree_wait_set_mark_fired(set, fd);
+      if (disable_fired) {
+        status = iree_status_join(
+            status, iree_wait_set_epoll_ctl(set, EPOLL_CTL_MOD, fd, 0));
+      }
+      IREE_RETURN_IF_ERROR(status);
+    }
+  }
+  return iree_ok_status();
 }
 
 iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
-  // TODO(benvanik): epoll_wait
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count == 0) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)set->handle_count);
+
+  iree_status_t status = iree_ok_status();
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  if (iree_wait_set_uses_io_uring(set)) {
+    // Polls are one-shot so fired entries stay disarmed until we return.
+    status = iree_wait_set_wait_io_uring(set, set->handle_count, deadline_ns);
+  } else
+#endif  // IREE_WAIT_API_IO_URING
+  {
+    status = iree_wait_set_wait_epoll(set, set->handle_count,
+                                      /*disable_fired=*/true, deadline_ns);
+  }
+  iree_wait_set_rearm_fired(set);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
                             iree_wait_handle_t* out_wake_handle) {
-  // TODO(benvanik): epoll_wait
+  memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count == 0) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)set->handle_count);
+
+  iree_status_t status = iree_ok_status();
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+  if (iree_wait_set_uses_io_uring(set)) {
+    status = iree_wait_set_wait_io_uring(set, 1, deadline_ns);
+  } else
+#endif  // IREE_WAIT_API_IO_URING
+  {
+    status = iree_wait_set_wait_epoll(set, 1, /*disable_fired=*/false,
+                                      deadline_ns);
+  }
+  if (iree_status_is_ok(status) && set->fired_count > 0) {
+    int fd = set->fired_list[0];
+    memcpy(out_wake_handle, &set->entries[fd].handle,
+           sizeof(*out_wake_handle));
+    out_wake_handle->set_internal.index =
+        (uint16_t)iree_min((iree_host_size_t)fd, UINT16_MAX);
+  }
+  iree_wait_set_rearm_fired(set);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 iree_status_t iree_wait_one(iree_wait_handle_t* handle,
                             iree_time_t deadline_ns) {
-  // TODO(benvanik): just use poll?
+  struct pollfd poll_fd;
+  poll_fd.fd = iree_wait_primitive_get_read_fd(handle);
+  if (poll_fd.fd == -1) return iree_ok_status();  // immediate
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // A single handle doesn't benefit from a kernel-side set; a plain ppoll
+  // avoids creating one and keeps the same syscall as the poll implementation.
+  int rv = -1;
+  do {
+    struct timespec timeout_ts;
+    struct timespec* tmo_p = &timeout_ts;
+    if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+      tmo_p = NULL;
+    } else {
+      iree_duration_t timeout_ns =
+          deadline_ns == IREE_TIME_INFINITE_PAST
+              ? 0
+              : iree_max(0, deadline_ns - iree_time_now());
+      timeout_ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+      timeout_ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+    }
+    rv = ppoll(&poll_fd, 1, tmo_p, NULL);
+  } while (rv < 0 && errno == EINTR);
+
+  iree_status_t status = iree_ok_status();
+  if (rv < 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "ppoll failure %d", errno);
+  } else if (rv == 0) {
+    status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  } else {
+    bool signaled = false;
+    status = iree_wait_set_resolve_events((uint32_t)poll_fd.revents, &signaled);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
-#endif  // IREE_WAIT_API == IREE_WAIT_API_EPOLL
+#endif  // IREE_WAIT_API == IREE_WAIT_API_EPOLL ||
+        // IREE_WAIT_API == IREE_WAIT_API_IO_URING
@@ -31,7 +31,7 @@
 #include "iree/base/config.h"
 #include "iree/base/target_platform.h"
 
-// NOTE: order matters; priorities are (kqueue|epoll) > ppoll > poll.
+// NOTE: order matters; priorities are io_uring > (kqueue|epoll) > ppoll > poll.
 // When overridden with NULL (no platform primitives) or on Win32 we always use
 // those implementations (today).
 #define IREE_WAIT_API_NULL 0
@@ -41,6 +41,7 @@
 #define IREE_WAIT_API_PPOLL 4
 #define IREE_WAIT_API_EPOLL 5
 #define IREE_WAIT_API_KQUEUE 6
+#define IREE_WAIT_API_IO_URING 7  // with runtime fallback to EPOLL
 
 // We allow overriding the wait API via command line flags. If unspecified we
 // try to guess based on the target platform.
@@ -53,8 +54,13 @@
 #define IREE_WAIT_API IREE_WAIT_API_INPROC
 #elif defined(IREE_PLATFORM_WINDOWS)
 #define IREE_WAIT_API IREE_WAIT_API_WIN32  // WFMO used in wait_handle_win32.c
+#elif defined(IREE_PLATFORM_LINUX) && !defined(IREE_PLATFORM_ANDROID)
+// io_uring when the kernel supports it and otherwise epoll; see
+// wait_handle_epoll.c. Android blocks io_uring for apps via seccomp and we
+// stick with ppoll there.
+#define IREE_WAIT_API IREE_WAIT_API_IO_URING
 #else
-// TODO(benvanik): EPOLL on android/linux/bsd/etc.
+// TODO(benvanik): EPOLL on android/bsd/etc.
 // TODO(benvanik): KQUEUE on mac/ios.
 // KQUEUE is not implemented yet. Use POLL for mac/ios
 // Android ppoll requires API version >= 21
@@ -70,10 +76,11 @@
 
 // Many implementations share the same posix-like nature (file descriptors/etc)
 // and can share most of their code.
-#if (IREE_WAIT_API == IREE_WAIT_API_POLL) ||  \
-    (IREE_WAIT_API == IREE_WAIT_API_PPOLL) || \
-    (IREE_WAIT_API == IREE_WAIT_API_EPOLL) || \
-    (IREE_WAIT_API == IREE_WAIT_API_KQUEUE)
+#if (IREE_WAIT_API == IREE_WAIT_API_POLL) ||   \
+    (IREE_WAIT_API == IREE_WAIT_API_PPOLL) ||  \
+    (IREE_WAIT_API == IREE_WAIT_API_EPOLL) ||  \
+    (IREE_WAIT_API == IREE_WAIT_API_KQUEUE) || \
+    (IREE_WAIT_API == IREE_WAIT_API_IO_URING)
 #define IREE_WAIT_API_POSIX_LIKE 1
 #endif  // IREE_WAIT_API = posix-like
 
@@ -325,8 +325,10 @@ iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
   // kind of thing kqueue/epoll solves (mutable in-place updates on polls) and
   // an unfortunate reality of using an ancient API. Thankfully most waits are
   // wait-any so a little loop isn't the worst thing in the wait-all case.
+  // Only handles that signaled were negated; ones left unsignaled by a timeout
+  // or failure must be preserved as-is.
   for (nfds_t i = 0; i < set->handle_count; ++i) {
-    set->poll_fds[i].fd = -set->poll_fds[i].fd;
+    if (set->poll_fds[i].fd < 0) set->poll_fds[i].fd = -set->poll_fds[i].fd;
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -13,6 +13,7 @@
 #include <cstddef>
 #include <cstring>
 #include <thread>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -796,6 +797,64 @@ TEST(WaitSet, WaitAnyEraseSplit) {
   iree_event_deinitialize(&ev_set);
 }
 
+// WFMO on Win32 is limited to MAXIMUM_WAIT_OBJECTS (64) handles per set.
+#if !defined(IREE_PLATFORM_WINDOWS)
+// Tests a set with many handles where only a few are signaled at a time and
+// handles are reset between waits.
+TEST(WaitSet, ManyHandles) {
+  constexpr int kHandleCount = 500;
+  std::vector<iree_event_t> events(kHandleCount);
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(
+      iree_wait_set_allocate(kHandleCount, iree_allocator_system(), &wait_set));
+  for (auto& event : events) {
+    IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+    IREE_ASSERT_OK(iree_wait_set_insert(wait_set, event));
+  }
+
+  // Nothing signaled yet.
+  iree_wait_handle_t wake_handle;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  // Signal one handle in the middle and ensure we wake on it.
+  iree_event_set(&events[kHandleCount / 2]);
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_FUTURE, &wake_handle));
+  EXPECT_EQ(0, memcmp(&events[kHandleCount / 2].value, &wake_handle.value,
+                      sizeof(wake_handle.value)));
+
+  // Resetting the handle must not leave a stale wake behind.
+  iree_event_reset(&events[kHandleCount / 2]);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  // Erase and reinsert a handle after it was signaled and reset.
+  iree_event_set(&events[0]);
+  iree_wait_set_erase(wait_set, events[0]);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  IREE_ASSERT_OK(iree_wait_set_insert(wait_set, events[0]));
+  IREE_ASSERT_OK(
+      iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+  EXPECT_EQ(0, memcmp(&events[0].value, &wake_handle.value,
+                      sizeof(wake_handle.value)));
+
+  // Wait-all only succeeds once every handle has been signaled.
+  for (int i = 0; i < kHandleCount - 1; ++i) iree_event_set(&events[i]);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_DEADLINE_EXCEEDED,
+                        iree_wait_all(wait_set, IREE_TIME_INFINITE_PAST));
+  iree_event_set(&events[kHandleCount - 1]);
+  IREE_EXPECT_OK(iree_wait_all(wait_set, IREE_TIME_INFINITE_FUTURE));
+
+  iree_wait_set_free(wait_set);
+  for (auto& event : events) iree_event_deinitialize(&event);
+}
+#endif  // !IREE_PLATFORM_WINDOWS
+
 // Tests iree_wait_one when polling (deadline_ns = IREE_TIME_INFINITE_PAST).
 TEST(WaitSet, WaitOnePolling) {
   iree_event_t ev_unset, ev_set;
@@ -210,6 +210,13 @@ typedef enum iree_hal_external_buffer_type_e {
   // Vulkan:
   //  Requires device support.
   //  Uses VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT.
+  //
+  // Heap (local CPU devices):
+  //  Requires Linux/Android.
+  //  Imports any mappable shared memory fd (memfd, shm, dma-buf) by mapping it
+  //  with MAP_SHARED. Exports buffers allocated with
+  //  IREE_HAL_BUFFER_USAGE_SHARING_EXPORT, which are backed by a memfd, without
+  //  copying. The exported fd is owned by the caller.
   IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD = 2,
 
   // A driver/device-specific Win32 HANDLE.
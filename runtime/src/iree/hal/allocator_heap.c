@@ -184,21 +184,29 @@ static iree_status_t iree_hal_heap_allocator_import_buffer(
     iree_hal_external_buffer_t* IREE_RESTRICT external_buffer,
     iree_hal_buffer_release_callback_t release_callback,
     iree_hal_buffer_t** IREE_RESTRICT out_buffer) {
-  if (external_buffer->type != IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION) {
-    return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                            "external buffer type not supported");
-  }
-
   // Coerce options into those required for use by heap-based devices.
   iree_hal_buffer_params_t compat_params =
       iree_hal_heap_allocator_make_compatible(params);
 
-  return iree_hal_heap_buffer_wrap(
-      base_allocator, compat_params.type, compat_params.access,
-      compat_params.usage, external_buffer->size,
-      iree_make_byte_span(external_buffer->handle.host_allocation.ptr,
-                          external_buffer->size),
-      release_callback, out_buffer);
+  switch (external_buffer->type) {
+    case IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION:
+      return iree_hal_heap_buffer_wrap(
+          base_allocator, compat_params.type, compat_params.access,
+          compat_params.usage, external_buffer->size,
+          iree_make_byte_span(external_buffer->handle.host_allocation.ptr,
+                              external_buffer->size),
+          release_callback, out_buffer);
+    case IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD:
+      // Shared memory files (memfd/shm/dma-buf with mmap support) are mapped
+      // into the process and retained by the buffer.
+      return iree_hal_heap_buffer_wrap_fd(
+          base_allocator, compat_params.type, compat_params.access,
+          compat_params.usage, external_buffer->size,
+          external_buffer->handle.opaque_fd.fd, release_callback, out_buffer);
+    default:
+      return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "external buffer type not supported");
+  }
 }
 
 static iree_status_t iree_hal_heap_allocator_export_buffer(
@@ -207,7 +215,17 @@ static iree_status_t iree_hal_heap_allocator_export_buffer(
     iree_hal_external_buffer_type_t requested_type,
     iree_hal_external_buffer_flags_t requested_flags,
     iree_hal_external_buffer_t* IREE_RESTRICT out_external_buffer) {
-  if (requested_type != IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION) {
+  if (requested_type == IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD) {
+    // The caller owns the returned fd and must close it; the buffer storage
+    // remains live until both the buffer and all fds are released.
+    int fd = -1;
+    IREE_RETURN_IF_ERROR(iree_hal_heap_buffer_export_fd(buffer, &fd));
+    out_external_buffer->type = requested_type;
+    out_external_buffer->flags = requested_flags;
+    out_external_buffer->size = iree_hal_buffer_byte_length(buffer);
+    out_external_buffer->handle.opaque_fd.fd = fd;
+    return iree_ok_status();
+  } else if (requested_type != IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION) {
     return iree_make_status(IREE_STATUS_UNAVAILABLE,
                             "external buffer type not supported");
   }
@@ -0,0 +1,251 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define IREE_HAL_HEAP_TEST_FD 1
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+struct HeapAllocatorTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* allocator = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("heap"), host_allocator, host_allocator, &allocator));
+  }
+
+  void TearDown() override { iree_hal_allocator_release(allocator); }
+
+  iree_hal_buffer_params_t MakeParams(iree_hal_buffer_usage_t usage) {
+    iree_hal_buffer_params_t params = {0};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER |
+                   IREE_HAL_BUFFER_USAGE_MAPPING | usage;
+    return params;
+  }
+};
+
+TEST_F(HeapAllocatorTest, HostAllocationRoundTrip) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_SHARING_EXPORT), 128,
+      iree_const_byte_span_empty(), &buffer));
+  iree_hal_external_buffer_t external_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_export_buffer(
+      allocator, buffer, IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+      IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer));
+  EXPECT_EQ(external_buffer.size, 128);
+  EXPECT_NE(external_buffer.handle.host_allocation.ptr, nullptr);
+  iree_hal_buffer_release(buffer);
+}
+
+#if defined(IREE_HAL_HEAP_TEST_FD)
+
+// Only exportable buffers are fd-backed.
+TEST_F(HeapAllocatorTest, ExportFdRequiresSharingUsage) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_NONE), 128,
+      iree_const_byte_span_empty(), &buffer));
+  iree_hal_external_buffer_t external_buffer;
+  EXPECT_THAT(Status(iree_hal_allocator_export_buffer(
+                  allocator, buffer, IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD,
+                  IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer)),
+              StatusIs(StatusCode::kUnavailable));
+  iree_hal_buffer_release(buffer);
+}
+
+// Exports a buffer as an fd and imports it back; both alias the same memory
+// and the storage outlives the original buffer while the import is live.
+TEST_F(HeapAllocatorTest, FdRoundTrip) {
+  const uint8_t initial_data[4] = {1, 2, 3, 4};
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_SHARING_EXPORT),
+      sizeof(initial_data),
+      iree_make_const_byte_span(initial_data, sizeof(initial_data)), &buffer));
+
+  iree_hal_external_buffer_t external_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_export_buffer(
+      allocator, buffer, IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD,
+      IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer));
+  EXPECT_EQ(external_buffer.size, sizeof(initial_data));
+  EXPECT_GE(external_buffer.handle.opaque_fd.fd, 0);
+
+  iree_hal_buffer_t* imported_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_import_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_NONE), &external_buffer,
+      iree_hal_buffer_release_callback_null(), &imported_buffer));
+  // The import holds its own reference to the file.
+  close(external_buffer.handle.opaque_fd.fd);
+
+  const uint32_t pattern = 0xCDCDCDCDu;
+  IREE_ASSERT_OK(iree_hal_buffer_map_write(buffer, 0, &pattern, 2));
+  iree_hal_buffer_release(buffer);
+
+  uint8_t readback[4] = {0};
+  IREE_ASSERT_OK(
+      iree_hal_buffer_map_read(imported_buffer, 0, readback, sizeof(readback)));
+  EXPECT_EQ(readback[0], 0xCD);
+  EXPECT_EQ(readback[1], 0xCD);
+  EXPECT_EQ(readback[2], 3);
+  EXPECT_EQ(readback[3], 4);
+  iree_hal_buffer_release(imported_buffer);
+}
+
+// Imports must not extend beyond the end of the file as accesses to the
+// unbacked pages would fault.
+TEST_F(HeapAllocatorTest, ImportFdBeyondFileSize) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_SHARING_EXPORT), 128,
+      iree_const_byte_span_empty(), &buffer));
+  iree_hal_external_buffer_t external_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_export_buffer(
+      allocator, buffer, IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD,
+      IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer));
+  iree_hal_buffer_release(buffer);
+
+  external_buffer.size = 128 + 4096;
+  iree_hal_buffer_t* imported_buffer = NULL;
+  EXPECT_THAT(Status(iree_hal_allocator_import_buffer(
+                  allocator, MakeParams(IREE_HAL_BUFFER_USAGE_NONE),
+                  &external_buffer, iree_hal_buffer_release_callback_null(),
+                  &imported_buffer)),
+              StatusIs(StatusCode::kOutOfRange));
+  EXPECT_EQ(imported_buffer, nullptr);
+  close(external_buffer.handle.opaque_fd.fd);
+}
+
+// Sends |fd| over the unix domain |socket| with SCM_RIGHTS.
+static bool SendFd(int socket, int fd) {
+  char payload = 0;
+  struct iovec iov = {&payload, sizeof(payload)};
+  char control[CMSG_SPACE(sizeof(int))];
+  memset(control, 0, sizeof(control));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  return sendmsg(socket, &msg, 0) == sizeof(payload);
+}
+
+// Receives an fd sent with SendFd or returns -1.
+static int ReceiveFd(int socket) {
+  char payload = 0;
+  struct iovec iov = {&payload, sizeof(payload)};
+  char control[CMSG_SPACE(sizeof(int))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if (recvmsg(socket, &msg, 0) != sizeof(payload)) return -1;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+  int fd = -1;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return fd;
+}
+
+// A producer process fills an exported buffer and hands the fd to the
+// consumer (this process), which imports it without copying and writes a
+// response the producer observes through its own mapping.
+TEST_F(HeapAllocatorTest, FdSharedAcrossProcesses) {
+  int sockets[2] = {-1, -1};
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+  const iree_device_size_t kLength = 4096;
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Producer: allocate, fill, and send the fd. Wait for the consumer to
+    // acknowledge and verify its response landed in our buffer.
+    close(sockets[0]);
+    iree_hal_buffer_t* buffer = NULL;
+    iree_hal_external_buffer_t external_buffer;
+    bool ok =
+        iree_status_is_ok(iree_hal_allocator_allocate_buffer(
+            allocator, MakeParams(IREE_HAL_BUFFER_USAGE_SHARING_EXPORT),
+            kLength, iree_const_byte_span_empty(), &buffer)) &&
+        iree_status_is_ok(iree_hal_buffer_map_fill(buffer, 0, kLength - 1,
+                                                   "\x5A", 1)) &&
+        iree_status_is_ok(iree_hal_allocator_export_buffer(
+            allocator, buffer, IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD,
+            IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer)) &&
+        SendFd(sockets[1], external_buffer.handle.opaque_fd.fd);
+    char ack = 0;
+    ok = ok && read(sockets[1], &ack, 1) == 1;
+    uint8_t response = 0;
+    ok = ok && iree_status_is_ok(iree_hal_buffer_map_read(
+                   buffer, kLength - 1, &response, 1));
+    _exit(ok && response == 0xA5 ? 0 : 1);
+  }
+
+  close(sockets[1]);
+  int fd = ReceiveFd(sockets[0]);
+  ASSERT_GE(fd, 0);
+  iree_hal_external_buffer_t external_buffer;
+  memset(&external_buffer, 0, sizeof(external_buffer));
+  external_buffer.type = IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD;
+  external_buffer.size = kLength;
+  external_buffer.handle.opaque_fd.fd = fd;
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_import_buffer(
+      allocator, MakeParams(IREE_HAL_BUFFER_USAGE_NONE), &external_buffer,
+      iree_hal_buffer_release_callback_null(), &buffer));
+  close(fd);
+
+  uint8_t readback[2] = {0};
+  IREE_ASSERT_OK(iree_hal_buffer_map_read(buffer, 0, readback, 1));
+  IREE_ASSERT_OK(
+      iree_hal_buffer_map_read(buffer, kLength - 2, &readback[1], 1));
+  EXPECT_EQ(readback[0], 0x5A);
+  EXPECT_EQ(readback[1], 0x5A);
+  const uint8_t response = 0xA5;
+  IREE_ASSERT_OK(iree_hal_buffer_map_write(buffer, kLength - 1, &response, 1));
+  iree_hal_buffer_release(buffer);
+
+  char ack = 1;
+  ASSERT_EQ(write(sockets[0], &ack, 1), 1);
+  int wait_status = 0;
+  ASSERT_EQ(waitpid(pid, &wait_status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(wait_status));
+  EXPECT_EQ(WEXITSTATUS(wait_status), 0);
+  close(sockets[0]);
+}
+
+#endif  // IREE_HAL_HEAP_TEST_FD
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -190,6 +190,60 @@ static const iree_hal_buffer_vtable_t iree_hal_subspan_buffer_vtable = {
     .flush_range = iree_hal_subspan_buffer_flush_range,
 };
 
+//===----------------------------------------------------------------------===//
+// iree_hal_owned_subspan_buffer_t
+//===----------------------------------------------------------------------===//
+
+// A subspan of an allocated buffer that also keeps alive the buffer it was
+// derived from. Used when subspanning a buffer that is itself a subspan managed
+// by an allocator (such as a suballocation of a larger slab) so that the
+// allocator does not reclaim the range while the new subspan references it.
+typedef struct iree_hal_owned_subspan_buffer_t {
+  iree_hal_buffer_t base;
+  iree_hal_buffer_t* owner;
+} iree_hal_owned_subspan_buffer_t;
+
+static const iree_hal_buffer_vtable_t iree_hal_owned_subspan_buffer_vtable;
+
+static iree_status_t iree_hal_owned_subspan_buffer_create(
+    iree_hal_buffer_t* owner, iree_device_size_t byte_offset,
+    iree_device_size_t byte_length, iree_hal_buffer_t** out_buffer) {
+  iree_hal_buffer_t* allocated_buffer = owner->allocated_buffer;
+  iree_allocator_t host_allocator = owner->host_allocator;
+  iree_hal_owned_subspan_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, sizeof(*buffer), (void**)&buffer));
+  iree_hal_buffer_initialize(
+      host_allocator, /*device_allocator=*/NULL, allocated_buffer,
+      allocated_buffer->allocation_size, byte_offset, byte_length,
+      owner->memory_type, owner->allowed_access, owner->allowed_usage,
+      &iree_hal_owned_subspan_buffer_vtable, &buffer->base);
+  buffer->owner = owner;
+  iree_hal_buffer_retain(owner);
+  *out_buffer = &buffer->base;
+  return iree_ok_status();
+}
+
+static void iree_hal_owned_subspan_buffer_destroy(
+    iree_hal_buffer_t* base_buffer) {
+  iree_hal_owned_subspan_buffer_t* buffer =
+      (iree_hal_owned_subspan_buffer_t*)base_buffer;
+  iree_allocator_t host_allocator = base_buffer->host_allocator;
+  iree_hal_buffer_t* owner = buffer->owner;
+  iree_hal_buffer_release(base_buffer->allocated_buffer);
+  iree_allocator_free(host_allocator, buffer);
+  iree_hal_buffer_release(owner);
+}
+
+static const iree_hal_buffer_vtable_t iree_hal_owned_subspan_buffer_vtable = {
+    .recycle = iree_hal_buffer_recycle,
+    .destroy = iree_hal_owned_subspan_buffer_destroy,
+    .map_range = iree_hal_subspan_buffer_map_range,
+    .unmap_range = iree_hal_subspan_buffer_unmap_range,
+    .invalidate_range = iree_hal_subspan_buffer_invalidate_range,
+    .flush_range = iree_hal_subspan_buffer_flush_range,
+};
+
 //===----------------------------------------------------------------------===//
 // iree_hal_buffer_t
 //===----------------------------------------------------------------------===//
@@ -482,7 +536,21 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan(
   // the super deep indirection that could arise.
   iree_hal_buffer_t* allocated_buffer =
       iree_hal_buffer_allocated_buffer(buffer);
+  if (buffer->resource.vtable == &iree_hal_owned_subspan_buffer_vtable) {
+    // Owned subspans reference the backing block directly and only their owner
+    // keeps the suballocation alive so we must forward through it.
+    iree_hal_buffer_t* owner =
+        ((iree_hal_owned_subspan_buffer_t*)buffer)->owner;
+    return iree_hal_owned_subspan_buffer_create(owner, byte_offset, byte_length,
+                                                out_buffer);
+  }
   if (allocated_buffer != buffer) {
+    // Subspans managed by an allocator (suballocations) must stay alive as long
+    // as any subspan of them does or the allocator may reuse the range.
+    if (buffer->device_allocator) {
+      return iree_hal_owned_subspan_buffer_create(buffer, byte_offset,
+                                                  byte_length, out_buffer);
+    }
     return iree_hal_buffer_subspan(allocated_buffer, byte_offset, byte_length,
                                    out_buffer);
   }
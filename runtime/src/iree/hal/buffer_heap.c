@@ -15,6 +15,17 @@
 #include "iree/hal/buffer_heap_impl.h"
 #include "iree/hal/resource.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_memfd_create)
+#define IREE_HAL_HEAP_BUFFER_FD_SUPPORTED 1
+#endif  // __NR_memfd_create
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
 typedef enum iree_hal_heap_buffer_storage_mode_e {
   // Allocated as a [metadata, data] slab.
   // The base metadata pointer must be freed with iree_allocator_free_aligned.
@@ -29,6 +40,11 @@ typedef enum iree_hal_heap_buffer_storage_mode_e {
   // A user-provided buffer release callback is notified that the buffer is no
   // longer referencing the data.
   IREE_HAL_HEAP_BUFFER_STORAGE_MODE_EXTERNAL = 2u,
+  // Allocated as split [metadata] and a shared memory file mapping [data].
+  // The base metadata pointer must be freed with iree_allocator_free.
+  // The data storage must be unmapped and the owned file descriptor closed.
+  // An optional user-provided buffer release callback is notified after.
+  IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD = 3u,
 } iree_hal_heap_buffer_storage_mode_t;
 
 typedef struct iree_hal_heap_buffer_t {
@@ -39,7 +55,8 @@ typedef struct iree_hal_heap_buffer_t {
   union {
     // Used for IREE_HAL_HEAP_BUFFER_STORAGE_MODE_SPLIT.
     iree_allocator_t data_allocator;
-    // Used for IREE_HAL_HEAP_BUFFER_STORAGE_MODE_EXTERNAL.
+    // Used for IREE_HAL_HEAP_BUFFER_STORAGE_MODE_EXTERNAL and
+    // IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD.
     iree_hal_buffer_release_callback_t release_callback;
   };
 
@@ -50,6 +67,14 @@ static_assert(sizeof(iree_hal_heap_buffer_t) <= 128,
               "header should be <= the minimum buffer alignment so that we "
               "don't introduce internal waste");
 
+// A heap buffer with IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD.
+// Always allocated separately from its data so it is not size constrained.
+typedef struct iree_hal_heap_fd_buffer_t {
+  iree_hal_heap_buffer_t base;
+  // File descriptor owned by the buffer backing the data mapping.
+  int fd;
+} iree_hal_heap_fd_buffer_t;
+
 static const iree_hal_buffer_vtable_t iree_hal_heap_buffer_vtable;
 
 // Allocates a buffer with the metadata and storage split.
@@ -111,6 +136,71 @@ static iree_status_t iree_hal_heap_buffer_allocate_slab(
   return iree_ok_status();
 }
 
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+
+// Maps |fd| for |access| and returns the mapping in |out_data|.
+static iree_status_t iree_hal_heap_buffer_map_fd(
+    int fd, iree_device_size_t allocation_size,
+    iree_hal_memory_access_t access, iree_byte_span_t* out_data) {
+  int prot = 0;
+  if (iree_any_bit_set(access, IREE_HAL_MEMORY_ACCESS_READ)) prot |= PROT_READ;
+  if (iree_any_bit_set(access, IREE_HAL_MEMORY_ACCESS_WRITE |
+                                   IREE_HAL_MEMORY_ACCESS_DISCARD)) {
+    prot |= PROT_WRITE;
+  }
+  void* data_ptr =
+      mmap(NULL, (size_t)allocation_size, prot, MAP_SHARED, fd, /*offset=*/0);
+  if (data_ptr == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to map fd %d of %" PRIdsz " bytes", fd,
+                            allocation_size);
+  }
+  *out_data = iree_make_byte_span(data_ptr, (iree_host_size_t)allocation_size);
+  return iree_ok_status();
+}
+
+// Allocates a buffer with its storage in an anonymous shared memory file that
+// can be exported to other processes.
+static iree_status_t iree_hal_heap_buffer_allocate_fd(
+    iree_device_size_t allocation_size, iree_allocator_t host_allocator,
+    iree_hal_heap_buffer_t** out_buffer, iree_byte_span_t* out_data,
+    int* out_fd) {
+  iree_hal_heap_fd_buffer_t* buffer = NULL;
+  int fd = (int)syscall(__NR_memfd_create, "iree_hal_heap_buffer",
+                        /*MFD_CLOEXEC=*/1u);
+  if (fd < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "memfd_create failed");
+  }
+  iree_status_t status = iree_ok_status();
+  if (ftruncate(fd, (off_t)allocation_size) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to size memfd to %" PRIdsz " bytes",
+                              allocation_size);
+  }
+  if (iree_status_is_ok(status)) {
+    // Always map for read/write so that the contents can be initialized.
+    status = iree_hal_heap_buffer_map_fd(
+        fd, allocation_size, IREE_HAL_MEMORY_ACCESS_ALL, out_data);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(host_allocator, sizeof(*buffer),
+                                   (void**)&buffer);
+    if (!iree_status_is_ok(status)) {
+      munmap(out_data->data, out_data->data_length);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    *out_buffer = &buffer->base;
+    *out_fd = fd;
+  } else {
+    close(fd);
+  }
+  return status;
+}
+
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
+
 iree_status_t iree_hal_heap_buffer_create(
     iree_hal_allocator_t* allocator,
     iree_hal_heap_allocator_statistics_t* statistics,
@@ -128,14 +218,31 @@ iree_status_t iree_hal_heap_buffer_create(
   const bool same_allocator =
       memcmp(&data_allocator, &host_allocator, sizeof(data_allocator)) == 0;
 
+  // Exportable buffers are backed by shared memory files when supported so
+  // that they can be passed to other processes as file descriptors.
+  bool fd_backed = false;
+  int fd = -1;
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+  fd_backed =
+      iree_all_bits_set(params->usage, IREE_HAL_BUFFER_USAGE_SHARING_EXPORT) &&
+      allocation_size > 0;
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
+
   iree_hal_heap_buffer_t* buffer = NULL;
   iree_byte_span_t data = iree_make_byte_span(NULL, 0);
-  iree_status_t status =
-      same_allocator
-          ? iree_hal_heap_buffer_allocate_slab(allocation_size, host_allocator,
-                                               &buffer, &data)
-          : iree_hal_heap_buffer_allocate_split(allocation_size, data_allocator,
+  iree_status_t status = iree_ok_status();
+  if (fd_backed) {
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+    status = iree_hal_heap_buffer_allocate_fd(allocation_size, host_allocator,
+                                              &buffer, &data, &fd);
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
+  } else if (same_allocator) {
+    status = iree_hal_heap_buffer_allocate_slab(allocation_size,
                                                 host_allocator, &buffer, &data);
+  } else {
+    status = iree_hal_heap_buffer_allocate_split(
+        allocation_size, data_allocator, host_allocator, &buffer, &data);
+  }
 
   if (iree_status_is_ok(status)) {
     iree_hal_buffer_initialize(host_allocator, allocator, &buffer->base,
@@ -144,7 +251,11 @@ iree_status_t iree_hal_heap_buffer_create(
                                &iree_hal_heap_buffer_vtable, &buffer->base);
     buffer->data = data;
 
-    if (same_allocator) {
+    if (fd_backed) {
+      buffer->base.flags = IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD;
+      buffer->release_callback = iree_hal_buffer_release_callback_null();
+      ((iree_hal_heap_fd_buffer_t*)buffer)->fd = fd;
+    } else if (same_allocator) {
       buffer->base.flags = IREE_HAL_HEAP_BUFFER_STORAGE_MODE_SLAB;
       buffer->data_allocator = iree_allocator_null();
     } else {
@@ -217,6 +328,122 @@ iree_status_t iree_hal_heap_buffer_wrap(
   return status;
 }
 
+iree_status_t iree_hal_heap_buffer_wrap_fd(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    int fd, iree_hal_buffer_release_callback_t release_callback,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(allocator);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)allocation_size);
+
+  if (allocation_size == 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "imported fd buffers must be non-empty");
+  }
+
+  // Mapping beyond the end of the file succeeds but faults on access so the
+  // file must be verified to cover the requested size.
+  struct stat fd_stat;
+  if (fstat(fd, &fd_stat) != 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to query imported fd %d", fd);
+  }
+  if (fd_stat.st_size < 0 ||
+      allocation_size > (iree_device_size_t)fd_stat.st_size) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "imported fd %d is %" PRId64
+                            " bytes but %" PRIdsz " bytes were requested",
+                            fd, (int64_t)fd_stat.st_size, allocation_size);
+  }
+
+  // Take our own reference to the file so the caller can close theirs.
+  int owned_fd = dup(fd);
+  if (owned_fd < 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to duplicate imported fd %d", fd);
+  }
+
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(allocator);
+  iree_byte_span_t data = iree_make_byte_span(NULL, 0);
+  iree_status_t status = iree_hal_heap_buffer_map_fd(
+      owned_fd, allocation_size, allowed_access, &data);
+  iree_hal_heap_fd_buffer_t* buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(host_allocator, sizeof(*buffer),
+                                   (void**)&buffer);
+    if (!iree_status_is_ok(status)) munmap(data.data, data.data_length);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_initialize(
+        host_allocator, allocator, &buffer->base.base, allocation_size, 0,
+        allocation_size, memory_type, allowed_access, allowed_usage,
+        &iree_hal_heap_buffer_vtable, &buffer->base.base);
+    buffer->base.data = data;
+    buffer->base.base.flags = IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD;
+    buffer->base.release_callback = release_callback;
+    buffer->fd = owned_fd;
+    *out_buffer = &buffer->base.base;
+  } else {
+    close(owned_fd);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "fd-backed heap buffers not supported on this "
+                          "platform");
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
+}
+
+iree_status_t iree_hal_heap_buffer_export_fd(iree_hal_buffer_t* base_buffer,
+                                             int* out_fd) {
+  IREE_ASSERT_ARGUMENT(base_buffer);
+  IREE_ASSERT_ARGUMENT(out_fd);
+  *out_fd = -1;
+  iree_hal_buffer_t* allocated_buffer =
+      iree_hal_buffer_allocated_buffer(base_buffer);
+  if (!iree_hal_resource_is(allocated_buffer, &iree_hal_heap_buffer_vtable) ||
+      allocated_buffer->flags != IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD) {
+    return iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "only buffers allocated with IREE_HAL_BUFFER_USAGE_SHARING_EXPORT or "
+        "imported from fds can be exported as fds");
+  }
+  if (iree_hal_buffer_byte_offset(base_buffer) != 0 ||
+      iree_hal_buffer_byte_length(base_buffer) !=
+          iree_hal_buffer_allocation_size(allocated_buffer)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "fd export requires the entire allocation; subspans cannot be "
+        "represented as external fd buffers");
+  }
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+  iree_hal_heap_fd_buffer_t* buffer =
+      (iree_hal_heap_fd_buffer_t*)allocated_buffer;
+  int fd = dup(buffer->fd);
+  if (fd < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to duplicate buffer fd %d", buffer->fd);
+  }
+  *out_fd = fd;
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "fd-backed heap buffers not supported on this "
+                          "platform");
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
+}
+
 static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   iree_hal_heap_buffer_t* buffer = (iree_hal_heap_buffer_t*)base_buffer;
   iree_allocator_t host_allocator = base_buffer->host_allocator;
@@ -250,6 +477,18 @@ static void iree_hal_heap_buffer_destroy(iree_hal_buffer_t* base_buffer) {
       iree_allocator_free(host_allocator, buffer);
       break;
     }
+#if defined(IREE_HAL_HEAP_BUFFER_FD_SUPPORTED)
+    case IREE_HAL_HEAP_BUFFER_STORAGE_MODE_FD: {
+      munmap(buffer->data.data, buffer->data.data_length);
+      close(((iree_hal_heap_fd_buffer_t*)buffer)->fd);
+      if (buffer->release_callback.fn) {
+        buffer->release_callback.fn(buffer->release_callback.user_data,
+                                    base_buffer);
+      }
+      iree_allocator_free(host_allocator, buffer);
+      break;
+    }
+#endif  // IREE_HAL_HEAP_BUFFER_FD_SUPPORTED
     default:
       IREE_ASSERT_UNREACHABLE("unhandled buffer storage mode");
       break;
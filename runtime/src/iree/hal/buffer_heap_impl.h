@@ -52,6 +52,26 @@ iree_status_t iree_hal_heap_buffer_wrap(
     iree_byte_span_t data, iree_hal_buffer_release_callback_t release_callback,
     iree_hal_buffer_t** out_buffer);
 
+// Wraps a shared memory file descriptor |fd| in a buffer by mapping it into
+// the process. The buffer retains its own duplicate of |fd| until it is
+// destroyed, at which point the provided |release_callback| will be called.
+//
+// Fails with IREE_STATUS_UNAVAILABLE on platforms without fd support.
+iree_status_t iree_hal_heap_buffer_wrap_fd(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    int fd, iree_hal_buffer_release_callback_t release_callback,
+    iree_hal_buffer_t** out_buffer);
+
+// Exports a new file descriptor referencing the storage of |buffer| in
+// |out_fd|. The caller owns the returned fd and must close it.
+//
+// Only buffers allocated with IREE_HAL_BUFFER_USAGE_SHARING_EXPORT or imported
+// from fds are backed by files; all others fail with IREE_STATUS_UNAVAILABLE.
+iree_status_t iree_hal_heap_buffer_export_fd(iree_hal_buffer_t* buffer,
+                                             int* out_fd);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -428,6 +428,45 @@ TEST_P(command_buffer_test, FillBuffer_pattern4_size16_offset0_length8) {
   EXPECT_THAT(actual_buffer, ContainerEq(reference_buffer));
 }
 
+TEST_P(command_buffer_test, FillBufferReusable) {
+  iree_device_size_t buffer_size = 16;
+  iree_hal_buffer_t* device_buffer = NULL;
+  CreateZeroedDeviceBuffer(buffer_size, &device_buffer);
+
+  // Record once without the ONE_SHOT bit so that it can be submitted again.
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_ANY,
+      IREE_HAL_QUEUE_AFFINITY_ANY,
+      /*binding_capacity=*/0, &command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  uint8_t pattern = 0x07;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/4, /*length=*/8,
+      &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  std::vector<uint8_t> reference_buffer{0x00, 0x00, 0x00, 0x00,  //
+                                        0x07, 0x07, 0x07, 0x07,  //
+                                        0x07, 0x07, 0x07, 0x07,  //
+                                        0x00, 0x00, 0x00, 0x00};
+  for (int i = 0; i < 2; ++i) {
+    // Reset the contents so that each submission is observable.
+    IREE_ASSERT_OK(
+        iree_hal_buffer_map_zero(device_buffer, 0, IREE_WHOLE_BUFFER));
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(command_buffer));
+    std::vector<uint8_t> actual_data(buffer_size);
+    IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+        device_, device_buffer, /*source_offset=*/0, actual_data.data(),
+        actual_data.size(), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+  }
+
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+}
+
 TEST_P(command_buffer_test, UpdateBufferWholeBuffer) {
   iree_device_size_t target_buffer_size = 16;
   std::vector<uint8_t> source_buffer{0x01, 0x02, 0x03, 0x04,  //
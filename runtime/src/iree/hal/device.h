@@ -248,6 +248,15 @@ iree_hal_device_host_allocator(iree_hal_device_t* device);
 IREE_API_EXPORT iree_hal_allocator_t* iree_hal_device_allocator(
     iree_hal_device_t* device);
 
+// Replaces the device allocator used for allocating buffers with
+// |new_allocator|. Buffers allocated from the prior allocator remain valid.
+// This is intended to be used to wrap the device allocator with additional
+// behavior (such as suballocation or tracing) immediately after the device is
+// created and before any allocations are made; changing the allocator while
+// other threads are allocating is not thread-safe.
+IREE_API_EXPORT void iree_hal_device_replace_allocator(
+    iree_hal_device_t* device, iree_hal_allocator_t* new_allocator);
+
 // Trims pools and caches used by the HAL to the minimum required for live
 // allocations. This can be used on low-memory conditions or when
 // suspending/parking instances.
@@ -460,6 +469,8 @@ typedef struct iree_hal_device_vtable_t {
   iree_allocator_t(IREE_API_PTR* host_allocator)(iree_hal_device_t* device);
   iree_hal_allocator_t*(IREE_API_PTR* device_allocator)(
       iree_hal_device_t* device);
+  void(IREE_API_PTR* replace_device_allocator)(
+      iree_hal_device_t* device, iree_hal_allocator_t* new_allocator);
 
   iree_status_t(IREE_API_PTR* trim)(iree_hal_device_t* device);
 
@@ -10,10 +10,36 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/internal/numa.h"
 #include "iree/hal/drivers/local_task/task_driver.h"
 #include "iree/hal/local/loaders/registration/init.h"
 #include "iree/task/api.h"
 
+// Maximum number of queues (and executors) created; one per NUMA node.
+#define IREE_HAL_LOCAL_TASK_MAX_QUEUE_COUNT 8
+
+IREE_FLAG(
+    string, task_allocator_numa_placement, "default",
+    "NUMA placement policy of device buffer memory:\n"
+    " 'default': system allocator.\n"
+    " 'first_touch': pages placed on the node of the thread first writing.\n"
+    " 'bind': pages bound to --task_allocator_numa_node.\n"
+    " 'interleave': pages spread over all nodes.");
+
+IREE_FLAG(
+    int32_t, task_allocator_numa_node, -1,
+    "NUMA node device buffers are bound to with\n"
+    "--task_allocator_numa_placement=bind. -1 uses the node of the thread\n"
+    "performing the allocation.");
+
+IREE_FLAG(
+    int64_t, task_allocator_numa_min_size,
+    IREE_NUMA_ALLOCATOR_DEFAULT_MIN_PLACED_SIZE,
+    "Minimum size in bytes of device buffers placed with\n"
+    "--task_allocator_numa_placement. Smaller buffers are usually transient\n"
+    "and are allocated from the system allocator.");
+
 static iree_status_t iree_hal_local_task_driver_factory_enumerate(
     void* self, iree_host_size_t* out_driver_info_count,
     const iree_hal_driver_info_t** out_driver_infos) {
@@ -47,26 +73,46 @@ static iree_status_t iree_hal_local_task_driver_factory_try_create(
       iree_hal_executable_import_provider_default(), IREE_ARRAYSIZE(loaders),
       &loader_count, loaders, host_allocator);
 
-  iree_task_executor_t* executor = NULL;
+  // With --task_topology_per_node each NUMA node gets its own executor that
+  // backs one device queue; queue affinity then selects the node.
+  iree_task_executor_t* executors[IREE_HAL_LOCAL_TASK_MAX_QUEUE_COUNT] = {
+      NULL};
+  iree_host_size_t executor_count = 0;
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create_from_flags(host_allocator, &executor);
+    status = iree_task_executors_create_from_flags(
+        IREE_ARRAYSIZE(executors), host_allocator, &executor_count, executors);
+  }
+
+  iree_numa_placement_t placement = IREE_NUMA_PLACEMENT_DEFAULT;
+  if (iree_status_is_ok(status)) {
+    status = iree_numa_placement_parse(
+        iree_make_cstring_view(FLAG_task_allocator_numa_placement),
+        &placement);
   }
 
   iree_hal_allocator_t* device_allocator = NULL;
   if (iree_status_is_ok(status)) {
+    iree_allocator_t data_allocator = iree_numa_allocator(
+        FLAG_task_allocator_numa_node >= 0
+            ? (iree_numa_node_id_t)FLAG_task_allocator_numa_node
+            : IREE_NUMA_NODE_ID_ANY,
+        placement,
+        (iree_host_size_t)iree_max(0, FLAG_task_allocator_numa_min_size));
     status = iree_hal_allocator_create_heap(iree_make_cstring_view("local"),
-                                            host_allocator, host_allocator,
+                                            data_allocator, host_allocator,
                                             &device_allocator);
   }
 
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_driver_create(
-        driver_name, &default_params, /*queue_count=*/1, &executor,
-        loader_count, loaders, device_allocator, host_allocator, out_driver);
+        driver_name, &default_params, executor_count, executors, loader_count,
+        loaders, device_allocator, host_allocator, out_driver);
   }
 
   iree_hal_allocator_release(device_allocator);
-  iree_task_executor_release(executor);
+  for (iree_host_size_t i = 0; i < executor_count; ++i) {
+    iree_task_executor_release(executors[i]);
+  }
   for (iree_host_size_t i = 0; i < loader_count; ++i) {
     iree_hal_executable_loader_release(loaders[i]);
   }
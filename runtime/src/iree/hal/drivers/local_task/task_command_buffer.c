@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "iree/base/api.h"
@@ -27,6 +28,47 @@
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
 
+// A task recorded into a reusable or nested command buffer.
+// Templates are never issued themselves: each submission clones them into
+// submission-owned memory so that the same recording can be in-flight any
+// number of times concurrently.
+typedef struct iree_hal_task_template_t {
+  // Recorded task followed in memory by any command-specific data.
+  iree_task_t* task;
+  // Total size, in bytes, of the task and its command-specific data.
+  iree_host_size_t size;
+  // Index of the template |task| completes into or UINT32_MAX if none.
+  uint32_t completion_index;
+  // Barriers only: indices of the templates readied by the barrier.
+  uint32_t dependent_count;
+  uint32_t* dependent_indices;
+} iree_hal_task_template_t;
+
+// A dispatch binding that is resolved from a binding table when the templates
+// are instantiated.
+typedef struct iree_hal_task_binding_patch_t {
+  // Index of the dispatch template the binding is used by.
+  uint32_t template_index;
+  // Index into the dense binding_ptrs/binding_lengths tables of the dispatch.
+  uint32_t binding_index;
+  // Binding table slot the buffer is sourced from.
+  uint32_t slot;
+  // Offset and length relative to the binding table entry.
+  iree_device_size_t offset;
+  iree_device_size_t length;
+} iree_hal_task_binding_patch_t;
+
+// Linked list nodes used to accumulate templates and patches during recording.
+typedef struct iree_hal_task_template_node_t {
+  struct iree_hal_task_template_node_t* next;
+  iree_task_t* task;
+  iree_host_size_t size;
+} iree_hal_task_template_node_t;
+typedef struct iree_hal_task_binding_patch_node_t {
+  struct iree_hal_task_binding_patch_node_t* next;
+  iree_hal_task_binding_patch_t patch;
+} iree_hal_task_binding_patch_node_t;
+
 // iree/task/-based command buffer.
 // We track a minimal amount of state here and incrementally build out the task
 // DAG that we can submit to the task system directly. There's no intermediate
@@ -60,6 +102,24 @@ typedef struct iree_hal_task_command_buffer_t {
   // An empty list indicates that root_tasks are also the leaves.
   iree_task_list_t leaf_tasks;
 
+  // Task templates of reusable and nested command buffers. The recorded
+  // root_tasks/leaf_tasks DAG is never issued directly and instead each
+  // submission instantiates a copy of it from these templates.
+  // Empty for one-shot command buffers that issue their recorded tasks.
+  struct {
+    // All recorded tasks in recording order.
+    iree_host_size_t count;
+    iree_hal_task_template_t* entries;
+    // Indices of the templates matching root_tasks and leaf_tasks.
+    iree_host_size_t root_count;
+    uint32_t* root_indices;
+    iree_host_size_t leaf_count;
+    uint32_t* leaf_indices;
+    // Dispatch bindings that must be resolved from a binding table.
+    iree_host_size_t binding_patch_count;
+    iree_hal_task_binding_patch_t* binding_patches;
+  } templates;
+
   // TODO(benvanik): move this out of the struct and allocate from the arena -
   // we only need this during recording and it's ~4KB of waste otherwise.
   // State tracked within the command buffer during recording only.
@@ -90,6 +150,22 @@ typedef struct iree_hal_task_command_buffer_t {
         binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // Binding table slot + 1 of each binding that is indirect or 0 if the
+    // binding references a buffer directly. Indirect bindings store their
+    // offset in |binding_offsets| and length in |binding_lengths|.
+    uint32_t binding_slots[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                           IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+    iree_device_size_t
+        binding_offsets[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                        IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+
+    // Templates and binding patches recorded so far, most recent first.
+    // Flattened into |templates| when recording ends.
+    iree_hal_task_template_node_t* template_list;
+    iree_host_size_t template_count;
+    iree_hal_task_binding_patch_node_t* binding_patch_list;
+    iree_host_size_t binding_patch_count;
+
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
@@ -106,6 +182,16 @@ static iree_hal_task_command_buffer_t* iree_hal_task_command_buffer_cast(
   return (iree_hal_task_command_buffer_t*)base_value;
 }
 
+// Returns true if the command buffer records templates that are instantiated
+// for each submission instead of issuing the recorded tasks directly.
+static bool iree_hal_task_command_buffer_is_reusable(
+    const iree_hal_task_command_buffer_t* command_buffer) {
+  return !iree_all_bits_set(command_buffer->base.mode,
+                            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT) ||
+         iree_all_bits_set(command_buffer->base.mode,
+                           IREE_HAL_COMMAND_BUFFER_MODE_NESTED);
+}
+
 iree_status_t iree_hal_task_command_buffer_create(
     iree_hal_device_t* device, iree_task_scope_t* scope,
     iree_hal_command_buffer_mode_t mode,
@@ -116,25 +202,9 @@ iree_status_t iree_hal_task_command_buffer_create(
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
 
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-  if (binding_capacity > 0) {
-    // TODO(#10144): support indirect command buffers with binding tables.
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "indirect command buffers not yet implemented");
-  }
-
+  // NOTE: reusable (not one-shot) and nested command buffers record the same
+  // task DAG as one-shot ones but keep it as a template that is cloned on each
+  // submission (see iree_hal_task_command_buffer_instantiate).
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -149,6 +219,7 @@ iree_status_t iree_hal_task_command_buffer_create(
     iree_arena_initialize(block_pool, &command_buffer->arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
     iree_task_list_initialize(&command_buffer->leaf_tasks);
+    memset(&command_buffer->templates, 0, sizeof(command_buffer->templates));
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -171,8 +242,12 @@ static void iree_hal_task_command_buffer_destroy(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
-  iree_task_list_discard(&command_buffer->leaf_tasks);
-  iree_task_list_discard(&command_buffer->root_tasks);
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    iree_task_list_discard(&command_buffer->leaf_tasks);
+    iree_task_list_discard(&command_buffer->root_tasks);
+  }
+  // NOTE: templates are never issued and only reference arena memory; they
+  // are dropped with the arena below.
   iree_arena_deinitialize(&command_buffer->arena);
   iree_hal_resource_set_free(command_buffer->resource_set);
   iree_allocator_free(host_allocator, command_buffer);
@@ -201,6 +276,8 @@ static void* iree_hal_task_command_buffer_dyn_cast(
 
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer);
+static iree_status_t iree_hal_task_command_buffer_finalize_templates(
+    iree_hal_task_command_buffer_t* command_buffer);
 
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
@@ -230,6 +307,11 @@ static iree_status_t iree_hal_task_command_buffer_end(
                         &command_buffer->root_tasks);
   }
 
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_finalize_templates(command_buffer));
+  }
+
   return iree_ok_status();
 }
 
@@ -282,6 +364,26 @@ static iree_status_t iree_hal_task_command_buffer_flush_tasks(
   return iree_ok_status();
 }
 
+// Records |task| (of |task_size| total bytes including command data) as a
+// template if the command buffer is reusable. Must be called for every task
+// inserted into the DAG.
+static iree_status_t iree_hal_task_command_buffer_record_template(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t task_size) {
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_ok_status();
+  }
+  iree_hal_task_template_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*node), (void**)&node));
+  node->next = command_buffer->state.template_list;
+  node->task = task;
+  node->size = task_size;
+  command_buffer->state.template_list = node;
+  ++command_buffer->state.template_count;
+  return iree_ok_status();
+}
+
 // Emits a global barrier, splitting execution into all prior recorded tasks
 // and all subsequent recorded tasks. This is currently the critical piece that
 // limits our concurrency: changing to fine-grained barriers (via barrier
@@ -304,6 +406,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
                                            sizeof(*barrier), (void**)&barrier));
   iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_record_template(
+      command_buffer, &barrier->header, sizeof(*barrier)));
 
   // If there were previous tasks then join them to the barrier.
   for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
@@ -334,8 +438,12 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
 
 // Emits a the given execution |task| into the current open synchronization
 // scope (after state.open_barrier and before the next barrier).
+// |task_size| is the total size of the task and its trailing command data.
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
-    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t task_size) {
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_record_template(
+      command_buffer, task, task_size));
   if (command_buffer->state.open_barrier == NULL) {
     // If there is no open barrier then we are at the head and going right into
     // the task DAG.
@@ -352,6 +460,50 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+static iree_status_t iree_hal_task_command_buffer_instantiate(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_arena_allocator_t* arena, iree_task_t*** out_tasks);
+
+// Issues a reusable command buffer by instantiating a copy of its templates
+// into the submission |arena|. The command buffer itself is unchanged and may
+// be issued again (even concurrently).
+static iree_status_t iree_hal_task_command_buffer_issue_templates(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+  // If the command buffer is empty (valid!) then we are a no-op.
+  if (command_buffer->templates.root_count == 0) return iree_ok_status();
+
+  // Queue submissions have no binding table; only nested command buffers
+  // may use indirect bindings and they are resolved by execute_commands.
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_instantiate(
+      command_buffer, iree_hal_buffer_binding_table_empty(), arena, &tasks));
+
+  // Chain the retire task onto the leaf tasks (or the roots of a single layer
+  // DAG) as their completion indicates that all commands have completed.
+  const iree_host_size_t root_count = command_buffer->templates.root_count;
+  const uint32_t* root_indices = command_buffer->templates.root_indices;
+  const bool has_leaf_tasks = command_buffer->templates.leaf_count > 0;
+  const iree_host_size_t leaf_count =
+      has_leaf_tasks ? command_buffer->templates.leaf_count : root_count;
+  const uint32_t* leaf_indices =
+      has_leaf_tasks ? command_buffer->templates.leaf_indices : root_indices;
+  for (iree_host_size_t i = 0; i < leaf_count; ++i) {
+    iree_task_set_completion_task(tasks[leaf_indices[i]], retire_task);
+  }
+
+  // Enqueue all root tasks that are ready to run immediately.
+  iree_task_list_t root_tasks;
+  iree_task_list_initialize(&root_tasks);
+  for (iree_host_size_t i = 0; i < root_count; ++i) {
+    iree_task_list_push_back(&root_tasks, tasks[root_indices[i]]);
+  }
+  iree_task_submission_enqueue_list(pending_submission, &root_tasks);
+
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -361,6 +513,11 @@ iree_status_t iree_hal_task_command_buffer_issue(
                                        &iree_hal_task_command_buffer_vtable);
   IREE_ASSERT_TRUE(command_buffer);
 
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_hal_task_command_buffer_issue_templates(
+        command_buffer, retire_task, arena, pending_submission);
+  }
+
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
@@ -560,8 +717,8 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   memcpy(cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, sizeof(*cmd));
 }
 
 //===----------------------------------------------------------------------===//
@@ -616,8 +773,8 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->length);
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, total_cmd_size);
 }
 
 //===----------------------------------------------------------------------===//
@@ -700,8 +857,8 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   cmd->target_offset = target_offset;
   cmd->length = length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, sizeof(*cmd));
 }
 
 //===----------------------------------------------------------------------===//
@@ -788,13 +945,13 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
     }
     iree_host_size_t binding_ordinal = binding_base + bindings[i].binding;
 
-    // TODO(benvanik): batch insert by getting the resources in their own list.
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &bindings[i].buffer));
-
     // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
     iree_hal_buffer_mapping_t buffer_mapping = {{0}};
     if (bindings[i].buffer) {
+      // TODO(benvanik): batch insert by getting the resources in their own
+      // list.
+      IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
+          command_buffer->resource_set, 1, &bindings[i].buffer));
       IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
           bindings[i].buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
           IREE_HAL_MEMORY_ACCESS_ANY, bindings[i].offset, bindings[i].length,
@@ -803,10 +960,24 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
           buffer_mapping.contents.data;
       command_buffer->state.binding_lengths[binding_ordinal] =
           buffer_mapping.contents.data_length;
+      command_buffer->state.binding_slots[binding_ordinal] = 0;
+    } else if (bindings[i].buffer_slot <
+               command_buffer->base.binding_capacity) {
+      // Indirect binding resolved from the binding table each time the
+      // command buffer is instantiated.
+      command_buffer->state.bindings[binding_ordinal] = NULL;
+      command_buffer->state.binding_lengths[binding_ordinal] =
+          bindings[i].length;
+      command_buffer->state.binding_offsets[binding_ordinal] =
+          bindings[i].offset;
+      command_buffer->state.binding_slots[binding_ordinal] =
+          bindings[i].buffer_slot + 1;
     } else {
-      // TODO(#10144): stash indirect binding reference in the state table.
-      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                              "binding table lookup not yet supported");
+      return iree_make_status(
+          IREE_STATUS_OUT_OF_RANGE,
+          "binding table slot %u out of range (binding capacity %u)",
+          (uint32_t)bindings[i].buffer_slot,
+          command_buffer->base.binding_capacity);
     }
   }
 
@@ -974,15 +1145,34 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     used_binding_mask = iree_shr(used_binding_mask, mask_offset + 1);
     binding_ptrs[i] = command_buffer->state.bindings[binding_ordinal];
     binding_lengths[i] = command_buffer->state.binding_lengths[binding_ordinal];
-    if (!binding_ptrs[i]) {
+    if (command_buffer->state.binding_slots[binding_ordinal]) {
+      // Indirect binding: the pointer is patched in when instantiated. The
+      // template index of this dispatch is the next one to be recorded.
+      iree_hal_task_binding_patch_node_t* node = NULL;
+      IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                               sizeof(*node), (void**)&node));
+      node->next = command_buffer->state.binding_patch_list;
+      node->patch.template_index =
+          (uint32_t)command_buffer->state.template_count;
+      node->patch.binding_index = (uint32_t)i;
+      node->patch.slot =
+          command_buffer->state.binding_slots[binding_ordinal] - 1;
+      node->patch.offset =
+          command_buffer->state.binding_offsets[binding_ordinal];
+      node->patch.length = binding_lengths[i];
+      command_buffer->state.binding_patch_list = node;
+      ++command_buffer->state.binding_patch_count;
+      binding_ptrs[i] = NULL;
+      binding_lengths[i] = 0;
+    } else if (!binding_ptrs[i]) {
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
   }
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, total_cmd_size);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -1026,24 +1216,384 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_task_command_buffer_t templates
+//===----------------------------------------------------------------------===//
+
+// Maps a recorded task pointer to its template index during finalization.
+typedef struct iree_hal_task_template_lookup_t {
+  const iree_task_t* task;
+  uint32_t index;
+} iree_hal_task_template_lookup_t;
+
+static int iree_hal_task_template_lookup_cmp(const void* lhs, const void* rhs) {
+  const iree_task_t* lhs_task =
+      ((const iree_hal_task_template_lookup_t*)lhs)->task;
+  const iree_task_t* rhs_task =
+      ((const iree_hal_task_template_lookup_t*)rhs)->task;
+  return lhs_task < rhs_task ? -1 : (lhs_task > rhs_task ? 1 : 0);
+}
+
+// Returns the template index of |task| in the sorted |lookup| table.
+static iree_status_t iree_hal_task_template_lookup_find(
+    const iree_hal_task_template_lookup_t* lookup, iree_host_size_t count,
+    const iree_task_t* task, uint32_t* out_index) {
+  iree_hal_task_template_lookup_t key = {task, 0};
+  const iree_hal_task_template_lookup_t* entry =
+      (const iree_hal_task_template_lookup_t*)bsearch(
+          &key, lookup, count, sizeof(*lookup),
+          iree_hal_task_template_lookup_cmp);
+  if (IREE_UNLIKELY(!entry)) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "task %p not recorded as a template", task);
+  }
+  *out_index = entry->index;
+  return iree_ok_status();
+}
+
+// Flattens the templates and binding patches recorded into the command buffer
+// and resolves all task pointers in the recorded DAG into template indices.
+static iree_status_t iree_hal_task_command_buffer_finalize_templates_with(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_template_lookup_t* lookup) {
+  iree_host_size_t count = command_buffer->state.template_count;
+  iree_hal_task_template_t* entries = command_buffer->templates.entries;
+
+  // Lists were built in reverse recording order.
+  iree_hal_task_template_node_t* node = command_buffer->state.template_list;
+  for (iree_host_size_t i = count; i > 0; --i, node = node->next) {
+    entries[i - 1].task = node->task;
+    entries[i - 1].size = node->size;
+    entries[i - 1].completion_index = UINT32_MAX;
+    entries[i - 1].dependent_count = 0;
+    entries[i - 1].dependent_indices = NULL;
+    lookup[i - 1].task = node->task;
+    lookup[i - 1].index = (uint32_t)(i - 1);
+  }
+  qsort(lookup, count, sizeof(*lookup), iree_hal_task_template_lookup_cmp);
+
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_task_t* task = entries[i].task;
+    if (task->completion_task) {
+      IREE_RETURN_IF_ERROR(iree_hal_task_template_lookup_find(
+          lookup, count, task->completion_task, &entries[i].completion_index));
+    }
+    if (task->type == IREE_TASK_TYPE_BARRIER) {
+      iree_task_barrier_t* barrier = (iree_task_barrier_t*)task;
+      if (barrier->dependent_task_count == 0) continue;
+      IREE_RETURN_IF_ERROR(iree_arena_allocate(
+          &command_buffer->arena,
+          barrier->dependent_task_count * sizeof(uint32_t),
+          (void**)&entries[i].dependent_indices));
+      entries[i].dependent_count = (uint32_t)barrier->dependent_task_count;
+      for (iree_host_size_t j = 0; j < barrier->dependent_task_count; ++j) {
+        IREE_RETURN_IF_ERROR(iree_hal_task_template_lookup_find(
+            lookup, count, barrier->dependent_tasks[j],
+            &entries[i].dependent_indices[j]));
+      }
+    }
+  }
+
+  // Root and leaf tasks in list order.
+  iree_task_list_t* lists[2] = {&command_buffer->root_tasks,
+                                &command_buffer->leaf_tasks};
+  iree_host_size_t* list_counts[2] = {&command_buffer->templates.root_count,
+                                      &command_buffer->templates.leaf_count};
+  uint32_t** list_indices[2] = {&command_buffer->templates.root_indices,
+                                &command_buffer->templates.leaf_indices};
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(lists); ++i) {
+    iree_host_size_t list_count = 0;
+    for (iree_task_t* task = iree_task_list_front(lists[i]); task != NULL;
+         task = task->next_task) {
+      ++list_count;
+    }
+    if (list_count == 0) continue;
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                             list_count * sizeof(uint32_t),
+                                             (void**)list_indices[i]));
+    iree_host_size_t j = 0;
+    for (iree_task_t* task = iree_task_list_front(lists[i]); task != NULL;
+         task = task->next_task) {
+      IREE_RETURN_IF_ERROR(iree_hal_task_template_lookup_find(
+          lookup, count, task, &(*list_indices[i])[j++]));
+    }
+    *list_counts[i] = list_count;
+  }
+
+  // Binding patches in recording order.
+  iree_host_size_t patch_count = command_buffer->state.binding_patch_count;
+  if (patch_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena,
+        patch_count * sizeof(*command_buffer->templates.binding_patches),
+        (void**)&command_buffer->templates.binding_patches));
+    iree_hal_task_binding_patch_node_t* patch_node =
+        command_buffer->state.binding_patch_list;
+    for (iree_host_size_t i = patch_count; i > 0;
+         --i, patch_node = patch_node->next) {
+      command_buffer->templates.binding_patches[i - 1] = patch_node->patch;
+    }
+    command_buffer->templates.binding_patch_count = patch_count;
+  }
+
+  command_buffer->templates.count = count;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_command_buffer_finalize_templates(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  iree_host_size_t count = command_buffer->state.template_count;
+  if (count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, count);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(
+              &command_buffer->arena,
+              count * sizeof(*command_buffer->templates.entries),
+              (void**)&command_buffer->templates.entries));
+
+  // The lookup table is only needed while resolving and is not kept around.
+  iree_hal_task_template_lookup_t* lookup = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(command_buffer->host_allocator,
+                                count * sizeof(*lookup), (void**)&lookup));
+  iree_status_t status = iree_hal_task_command_buffer_finalize_templates_with(
+      command_buffer, lookup);
+  iree_allocator_free(command_buffer->host_allocator, lookup);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Resolves the binding |patch| against |binding_table| and writes the resulting
+// pointer into the instantiated dispatch |cmd|.
+static iree_status_t iree_hal_task_command_buffer_apply_binding_patch(
+    const iree_hal_task_binding_patch_t* patch,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_hal_cmd_dispatch_t* cmd) {
+  if (IREE_UNLIKELY(patch->slot >= binding_table.count)) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "binding table slot %u out of range (table has %" PRIhsz " entries)",
+        patch->slot, binding_table.count);
+  }
+  const iree_hal_buffer_binding_t* binding =
+      &binding_table.bindings[patch->slot];
+  if (IREE_UNLIKELY(!binding->buffer)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "binding table slot %u has no buffer",
+                            patch->slot);
+  }
+  iree_device_size_t length = patch->length;
+  if (length == IREE_WHOLE_BUFFER) length = binding->length;
+
+  // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
+  iree_hal_buffer_mapping_t buffer_mapping = {{0}};
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      binding->buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
+      IREE_HAL_MEMORY_ACCESS_ANY, binding->offset + patch->offset, length,
+      &buffer_mapping));
+
+  uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
+  cmd_ptr += cmd->push_constant_count * sizeof(uint32_t);
+  void** binding_ptrs = (void**)cmd_ptr;
+  cmd_ptr += cmd->binding_count * sizeof(*binding_ptrs);
+  size_t* binding_lengths = (size_t*)cmd_ptr;
+  binding_ptrs[patch->binding_index] = buffer_mapping.contents.data;
+  binding_lengths[patch->binding_index] =
+      (size_t)buffer_mapping.contents.data_length;
+  return iree_ok_status();
+}
+
+// Clones the recorded templates of |command_buffer| into |arena| and returns
+// the cloned tasks in template order in |out_tasks|. Indirect bindings are
+// resolved against |binding_table|. The cloned DAG is fully linked and ready
+// to be chained onto and submitted by the caller; the root and leaf tasks are
+// available via the templates.root_indices/leaf_indices tables.
+static iree_status_t iree_hal_task_command_buffer_instantiate(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_arena_allocator_t* arena, iree_task_t*** out_tasks) {
+  *out_tasks = NULL;
+  const iree_host_size_t count = command_buffer->templates.count;
+  const iree_hal_task_template_t* entries = command_buffer->templates.entries;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, count);
+
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(arena, count * sizeof(*tasks), (void**)&tasks));
+
+  // Copy all tasks first so that task pointers can be remapped after.
+  // Templates have never been issued and have their dependency counts set as
+  // they would be prior to submission so a bitwise copy is a valid task.
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_arena_allocate(arena, entries[i].size, (void**)&tasks[i]));
+    memcpy(tasks[i], entries[i].task, entries[i].size);
+    tasks[i]->next_task = NULL;
+  }
+
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_task_t* task = tasks[i];
+    const iree_hal_task_template_t* entry = &entries[i];
+    task->completion_task = entry->completion_index != UINT32_MAX
+                                ? tasks[entry->completion_index]
+                                : NULL;
+    switch (task->type) {
+      case IREE_TASK_TYPE_CALL: {
+        // Commands pass themselves as the closure context.
+        iree_task_call_t* call_task = (iree_task_call_t*)task;
+        if (call_task->closure.user_context == entry->task) {
+          call_task->closure.user_context = task;
+        }
+        break;
+      }
+      case IREE_TASK_TYPE_DISPATCH: {
+        iree_task_dispatch_t* dispatch_task = (iree_task_dispatch_t*)task;
+        if (dispatch_task->closure.user_context == entry->task) {
+          dispatch_task->closure.user_context = task;
+        }
+        break;
+      }
+      case IREE_TASK_TYPE_BARRIER: {
+        // Dependents were already counted in the copied pending counts so the
+        // fields are assigned directly instead of with
+        // iree_task_barrier_set_dependent_tasks.
+        iree_task_barrier_t* barrier_task = (iree_task_barrier_t*)task;
+        iree_task_t** dependent_tasks = NULL;
+        if (entry->dependent_count > 0) {
+          IREE_RETURN_AND_END_ZONE_IF_ERROR(
+              z0, iree_arena_allocate(
+                      arena, entry->dependent_count * sizeof(*dependent_tasks),
+                      (void**)&dependent_tasks));
+          for (uint32_t j = 0; j < entry->dependent_count; ++j) {
+            dependent_tasks[j] = tasks[entry->dependent_indices[j]];
+          }
+        }
+        barrier_task->dependent_task_count = entry->dependent_count;
+        barrier_task->dependent_tasks = dependent_tasks;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  for (iree_host_size_t i = 0;
+       i < command_buffer->templates.binding_patch_count; ++i) {
+    const iree_hal_task_binding_patch_t* patch =
+        &command_buffer->templates.binding_patches[i];
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_task_command_buffer_apply_binding_patch(
+                patch, binding_table,
+                (iree_hal_cmd_dispatch_t*)tasks[patch->template_index]));
+  }
+
+  *out_tasks = tasks;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_execute_commands
 //===----------------------------------------------------------------------===//
 
+// Inlines the nested |base_commands| into the command buffer by instantiating
+// its templates with |binding_table| into our arena. The nested DAG executes
+// between two global barriers such that it behaves as if its commands had been
+// recorded directly in place.
 static iree_status_t iree_hal_task_command_buffer_execute_commands(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_command_buffer_t* base_commands,
     iree_hal_buffer_binding_table_t binding_table) {
-  // TODO(#10144): support indirect command buffers by using deferred command
-  // buffers or caching the task topology (probably not worth the tracking).
-  // If we could separate the topology that referenced the binding table we'd
-  // be able to reissue but not concurrently (as each task can only be in flight
-  // as a singleton) - which may be enough in many cases but adds complexity to
-  // tracking as we'd need to either enforce serialization of subsequent
-  // submissions or copy-on-write-style clone the topology for each additional
-  // concurrent submission.
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "indirect command buffers not yet implemented");
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+  iree_hal_task_command_buffer_t* commands =
+      iree_hal_command_buffer_dyn_cast(base_commands,
+                                       &iree_hal_task_command_buffer_vtable);
+  if (IREE_UNLIKELY(!commands)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "nested command buffers must be created by the local-task device");
+  }
+  if (!iree_hal_task_command_buffer_is_reusable(commands)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "nested command buffers must be reusable or have the NESTED mode");
+  }
+  if (commands->templates.count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The nested command buffer and all buffers it may reference must remain
+  // live for as long as we do.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_resource_set_insert(command_buffer->resource_set, 1,
+                                       &base_commands));
+  for (iree_host_size_t i = 0; i < binding_table.count; ++i) {
+    if (!binding_table.bindings[i].buffer) continue;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_resource_set_insert(command_buffer->resource_set, 1,
+                                         &binding_table.bindings[i].buffer));
+  }
+
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_task_command_buffer_instantiate(
+              commands, binding_table, &command_buffer->arena, &tasks));
+
+  // If we are reusable ourselves the clones become part of our templates.
+  for (iree_host_size_t i = 0; i < commands->templates.count; ++i) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_task_command_buffer_record_template(
+                command_buffer, tasks[i], commands->templates.entries[i].size));
+  }
+
+  // Open a barrier and fan it out to the nested root tasks.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  iree_task_barrier_t* barrier = command_buffer->state.open_barrier;
+  const iree_host_size_t root_count = commands->templates.root_count;
+  if (root_count == 1) {
+    iree_task_set_completion_task(&barrier->header,
+                                  tasks[commands->templates.root_indices[0]]);
+  } else {
+    iree_task_t** dependent_tasks = NULL;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_arena_allocate(&command_buffer->arena,
+                                root_count * sizeof(*dependent_tasks),
+                                (void**)&dependent_tasks));
+    for (iree_host_size_t i = 0; i < root_count; ++i) {
+      dependent_tasks[i] = tasks[commands->templates.root_indices[i]];
+    }
+    iree_task_barrier_set_dependent_tasks(barrier, root_count,
+                                          dependent_tasks);
+  }
+  command_buffer->state.open_barrier = NULL;
+
+  // The nested leaf tasks (or roots if it was a single layer) become our leaf
+  // tasks and are joined by the next barrier.
+  if (iree_task_list_is_empty(&command_buffer->root_tasks)) {
+    iree_task_list_move(&command_buffer->leaf_tasks,
+                        &command_buffer->root_tasks);
+  }
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  const iree_host_size_t leaf_count = commands->templates.leaf_count
+                                          ? commands->templates.leaf_count
+                                          : root_count;
+  const uint32_t* leaf_indices = commands->templates.leaf_count
+                                     ? commands->templates.leaf_indices
+                                     : commands->templates.root_indices;
+  for (iree_host_size_t i = 0; i < leaf_count; ++i) {
+    iree_task_list_push_back(&command_buffer->leaf_tasks,
+                             tasks[leaf_indices[i]]);
+  }
+
+  iree_status_t status =
+      iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,216 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/local_task/task_device.h"
+#include "iree/task/api.h"
+#include "iree/testing/benchmark.h"
+
+// Size of each region filled/copied by a command. Kept small so that the
+// benchmarks are dominated by command buffer overheads and not memory traffic.
+#define IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH 64
+
+typedef struct iree_hal_task_benchmark_t {
+  iree_hal_device_t* device;
+  iree_hal_buffer_t* buffer;
+  iree_hal_semaphore_t* semaphore;
+  uint64_t semaphore_value;
+} iree_hal_task_benchmark_t;
+
+static iree_status_t iree_hal_task_benchmark_initialize(
+    iree_host_size_t command_count, iree_allocator_t host_allocator,
+    iree_hal_task_benchmark_t* out_benchmark) {
+  memset(out_benchmark, 0, sizeof(*out_benchmark));
+
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_task_executor_create_from_flags(host_allocator, &executor));
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_status_t status = iree_hal_allocator_create_heap(
+      iree_make_cstring_view("local"), host_allocator, host_allocator,
+      &device_allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    status = iree_hal_task_device_create(
+        iree_make_cstring_view("local-task"), &params, /*queue_count=*/1,
+        &executor, /*loader_count=*/0, /*loaders=*/NULL, device_allocator,
+        host_allocator, &out_benchmark->device);
+  }
+  iree_hal_allocator_release(device_allocator);
+  iree_task_executor_release(executor);
+
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_params_t params = {
+        .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL |
+                IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        .usage = IREE_HAL_BUFFER_USAGE_TRANSFER,
+    };
+    status = iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(out_benchmark->device), params,
+        (command_count + 1) * IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH,
+        iree_const_byte_span_empty(), &out_benchmark->buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(out_benchmark->device, 0ull,
+                                       &out_benchmark->semaphore);
+  }
+  return status;
+}
+
+static void iree_hal_task_benchmark_deinitialize(
+    iree_hal_task_benchmark_t* benchmark) {
+  iree_hal_semaphore_release(benchmark->semaphore);
+  iree_hal_buffer_release(benchmark->buffer);
+  iree_hal_device_release(benchmark->device);
+}
+
+// Records |command_count| alternating fills and copies into a new command
+// buffer with the given |mode|.
+static iree_status_t iree_hal_task_benchmark_record(
+    iree_hal_task_benchmark_t* benchmark, iree_hal_command_buffer_mode_t mode,
+    iree_host_size_t command_count,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+      benchmark->device, mode, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      IREE_HAL_QUEUE_AFFINITY_ANY, /*binding_capacity=*/0, &command_buffer));
+  iree_status_t status = iree_hal_command_buffer_begin(command_buffer);
+  const uint32_t pattern = 0xCDu;
+  for (iree_host_size_t i = 0; i < command_count && iree_status_is_ok(status);
+       ++i) {
+    iree_device_size_t offset = i * IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH;
+    if (i % 2 == 0) {
+      status = iree_hal_command_buffer_fill_buffer(
+          command_buffer, benchmark->buffer, offset,
+          IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH, &pattern, sizeof(pattern));
+    } else {
+      status = iree_hal_command_buffer_copy_buffer(
+          command_buffer, benchmark->buffer,
+          offset - IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH, benchmark->buffer,
+          offset, IREE_HAL_TASK_BENCHMARK_COMMAND_LENGTH);
+    }
+    // Split into a few barriers to produce a non-trivial task DAG.
+    if (iree_status_is_ok(status) && i % 8 == 7) {
+      status = iree_hal_command_buffer_execution_barrier(
+          command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+          IREE_HAL_EXECUTION_STAGE_TRANSFER,
+          IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 0, NULL, 0, NULL);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = command_buffer;
+  } else {
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  return status;
+}
+
+// Submits |command_buffer| and waits for it to complete.
+static iree_status_t iree_hal_task_benchmark_submit_and_wait(
+    iree_hal_task_benchmark_t* benchmark,
+    iree_hal_command_buffer_t* command_buffer) {
+  uint64_t signal_value = ++benchmark->semaphore_value;
+  iree_hal_semaphore_list_t signal_semaphores = {
+      .count = 1,
+      .semaphores = &benchmark->semaphore,
+      .payload_values = &signal_value,
+  };
+  IREE_RETURN_IF_ERROR(iree_hal_device_queue_execute(
+      benchmark->device, IREE_HAL_QUEUE_AFFINITY_ANY,
+      iree_hal_semaphore_list_empty(), signal_semaphores, 1, &command_buffer));
+  return iree_hal_semaphore_wait(benchmark->semaphore, signal_value,
+                                 iree_infinite_timeout());
+}
+
+// Records a new one-shot command buffer each iteration and submits it.
+//
+// user_data is the number of commands recorded.
+static iree_status_t iree_hal_task_command_buffer_benchmark_one_shot(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_host_size_t command_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+  iree_hal_task_benchmark_t benchmark;
+  iree_status_t status = iree_hal_task_benchmark_initialize(
+      command_count, benchmark_state->host_allocator, &benchmark);
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    status = iree_hal_task_benchmark_record(
+        &benchmark, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT, command_count,
+        &command_buffer);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_task_benchmark_submit_and_wait(&benchmark,
+                                                       command_buffer);
+    }
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  iree_hal_task_benchmark_deinitialize(&benchmark);
+  return status;
+}
+
+// Records a reusable command buffer once and submits it each iteration.
+//
+// user_data is the number of commands recorded.
+static iree_status_t iree_hal_task_command_buffer_benchmark_reusable(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_host_size_t command_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+  iree_hal_task_benchmark_t benchmark;
+  iree_status_t status = iree_hal_task_benchmark_initialize(
+      command_count, benchmark_state->host_allocator, &benchmark);
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    // No ONE_SHOT bit: the command buffer may be submitted multiple times.
+    status = iree_hal_task_benchmark_record(
+        &benchmark, /*mode=*/0, command_count, &command_buffer);
+  }
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    status =
+        iree_hal_task_benchmark_submit_and_wait(&benchmark, command_buffer);
+  }
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_task_benchmark_deinitialize(&benchmark);
+  return status;
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  static const uint32_t command_counts[] = {1, 16, 256};
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+  };
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(command_counts); ++i) {
+    char name[64];
+    benchmark_def.user_data = (void*)(uintptr_t)command_counts[i];
+    benchmark_def.run = iree_hal_task_command_buffer_benchmark_one_shot;
+    snprintf(name, sizeof(name), "record_submit_one_shot_%u",
+             command_counts[i]);
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+    benchmark_def.run = iree_hal_task_command_buffer_benchmark_reusable;
+    snprintf(name, sizeof(name), "submit_reusable_%u", command_counts[i]);
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
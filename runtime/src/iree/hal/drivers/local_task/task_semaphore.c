@@ -27,6 +27,9 @@
 // When the semaphore is signaled to at least the specified value then the
 // given event will be signaled and the timepoint discarded.
 //
+// Only used when the wait is performed by the task executor, which requires an
+// OS wait handle; host waits use the fd-free iree_hal_semaphore_host_waiter_t.
+//
 // Instances are owned and retained by the caller that requested them - usually
 // in the arena associated with the submission, but could be on the stack of a
 // synchronously waiting thread.
@@ -281,6 +284,24 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
   return status;
 }
 
+// Returns the result of waiting for |semaphore| to reach |value| based on its
+// current state:
+// - IREE_STATUS_OK: the value has been reached.
+// - IREE_STATUS_ABORTED: the semaphore has failed.
+// - IREE_STATUS_DEADLINE_EXCEEDED: the value has not yet been reached.
+static iree_status_code_t iree_hal_task_semaphore_wait_result(
+    iree_hal_task_semaphore_t* semaphore, uint64_t value) {
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_status_code_t status_code = IREE_STATUS_OK;
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    status_code = IREE_STATUS_ABORTED;
+  } else if (semaphore->current_value < value) {
+    status_code = IREE_STATUS_DEADLINE_EXCEEDED;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status_code;
+}
+
 static iree_status_t iree_hal_task_semaphore_wait(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_timeout_t timeout) {
@@ -305,30 +326,61 @@ static iree_status_t iree_hal_task_semaphore_wait(
 
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
-  // Slow path: acquire a timepoint while we hold the lock.
-  iree_hal_task_timepoint_t timepoint;
-  iree_status_t status = iree_hal_task_semaphore_acquire_timepoint(
-      semaphore, value, timeout, &timepoint);
+  // Slow path: acquire a timepoint while we hold the lock. Host waits are
+  // entirely in-process and block on a futex instead of an OS wait handle.
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_hal_semaphore_timepoint_t timepoint;
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, &semaphore->base, value, timeout, &timepoint);
 
   iree_slim_mutex_unlock(&semaphore->mutex);
-  if (IREE_UNLIKELY(!iree_status_is_ok(status))) return status;
-
-  // Wait until the timepoint resolves.
-  // If satisfied the timepoint is automatically cleaned up and we are done. If
-  // the deadline is reached before satisfied then we have to clean it up.
-  status = iree_wait_one(&timepoint.event, deadline_ns);
-  if (!iree_status_is_ok(status)) {
-    iree_hal_semaphore_cancel_timepoint(&semaphore->base, &timepoint.base);
-  }
-  iree_event_pool_release(semaphore->event_pool, 1, &timepoint.event);
 
-  return status;
+  // Wait until the timepoint resolves. The timepoint is always cancelled:
+  // if it was reached this is a no-op but ensures the callback has finished
+  // touching the waiter before we tear it down.
+  iree_hal_semaphore_host_waiter_await(&waiter, 1, deadline_ns);
+  iree_hal_semaphore_cancel_timepoint(&semaphore->base, &timepoint);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+
+  return iree_status_from_code(
+      iree_hal_task_semaphore_wait_result(semaphore, value));
+}
+
+// Returns a status derived from the |semaphore_list| at the current time:
+// - IREE_STATUS_OK: any or all semaphores signaled (based on |wait_mode|).
+// - IREE_STATUS_ABORTED: one or more semaphores failed.
+// - IREE_STATUS_DEADLINE_EXCEEDED: any or all semaphores unsignaled.
+static iree_status_t iree_hal_task_semaphore_multi_wait_result(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t semaphore_list) {
+  bool any_signaled = false;
+  bool all_signaled = true;
+  for (iree_host_size_t i = 0; i < semaphore_list.count; ++i) {
+    switch (iree_hal_task_semaphore_wait_result(
+        iree_hal_task_semaphore_cast(semaphore_list.semaphores[i]),
+        semaphore_list.payload_values[i])) {
+      case IREE_STATUS_OK:
+        any_signaled = true;
+        break;
+      case IREE_STATUS_ABORTED:
+        // Always prioritize failure state.
+        return iree_status_from_code(IREE_STATUS_ABORTED);
+      default:
+        all_signaled = false;
+        break;
+    }
+  }
+  bool is_satisfied =
+      wait_mode == IREE_HAL_WAIT_MODE_ANY ? any_signaled : all_signaled;
+  return is_satisfied ? iree_ok_status()
+                      : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
 }
 
 iree_status_t iree_hal_task_semaphore_multi_wait(
     iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t semaphore_list, iree_timeout_t timeout,
-    iree_event_pool_t* event_pool, iree_arena_block_pool_t* block_pool) {
+    iree_arena_block_pool_t* block_pool) {
   if (semaphore_list.count == 0) {
     return iree_ok_status();
   } else if (semaphore_list.count == 1) {
@@ -341,66 +393,69 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
 
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
-  // Avoid heap allocations by using the device block pool for the wait set.
+  // Avoid heap allocations by using the device block pool for the timepoints.
   iree_arena_allocator_t arena;
   iree_arena_initialize(block_pool, &arena);
-  iree_wait_set_t* wait_set = NULL;
-  iree_status_t status = iree_wait_set_allocate(
-      semaphore_list.count, iree_arena_allocator(&arena), &wait_set);
-
-  // Acquire a wait handle for each semaphore timepoint we are to wait on.
-  // TODO(benvanik): flip this API around so we can batch request events from
-  // the event pool. We should be acquiring all required time points in one
-  // call.
-  iree_host_size_t timepoint_count = 0;
-  iree_hal_task_timepoint_t* timepoints = NULL;
-  iree_host_size_t total_timepoint_size =
-      semaphore_list.count * sizeof(timepoints[0]);
-  status =
-      iree_arena_allocate(&arena, total_timepoint_size, (void**)&timepoints);
+  iree_hal_semaphore_timepoint_t* timepoints = NULL;
+  iree_hal_semaphore_t** timepoint_semaphores = NULL;
+  iree_status_t status = iree_arena_allocate(
+      &arena, semaphore_list.count * sizeof(timepoints[0]),
+      (void**)&timepoints);
   if (iree_status_is_ok(status)) {
-    memset(timepoints, 0, total_timepoint_size);
-    for (iree_host_size_t i = 0; i < semaphore_list.count; ++i) {
-      iree_hal_task_semaphore_t* semaphore =
-          iree_hal_task_semaphore_cast(semaphore_list.semaphores[i]);
-      iree_slim_mutex_lock(&semaphore->mutex);
-      if (semaphore->current_value >= semaphore_list.payload_values[i]) {
-        // Fast path: already satisfied.
-      } else {
-        // Slow path: get a native wait handle for the timepoint.
-        iree_hal_task_timepoint_t* timepoint = &timepoints[timepoint_count++];
-        status = iree_hal_task_semaphore_acquire_timepoint(
-            semaphore, semaphore_list.payload_values[i], timeout, timepoint);
-        if (iree_status_is_ok(status)) {
-          status = iree_wait_set_insert(wait_set, timepoint->event);
-        }
-      }
-      iree_slim_mutex_unlock(&semaphore->mutex);
-      if (!iree_status_is_ok(status)) break;
+    status = iree_arena_allocate(
+        &arena, semaphore_list.count * sizeof(timepoint_semaphores[0]),
+        (void**)&timepoint_semaphores);
+  }
+
+  // Acquire a timepoint for each semaphore not yet satisfied. All of them
+  // notify the same futex-backed waiter so no OS wait handles are required
+  // regardless of how many semaphores are involved.
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_host_size_t timepoint_count = 0;
+  bool any_satisfied = false;
+  for (iree_host_size_t i = 0;
+       i < semaphore_list.count && iree_status_is_ok(status); ++i) {
+    iree_hal_task_semaphore_t* semaphore =
+        iree_hal_task_semaphore_cast(semaphore_list.semaphores[i]);
+    iree_slim_mutex_lock(&semaphore->mutex);
+    if (semaphore->current_value >= semaphore_list.payload_values[i]) {
+      // Fast path: already satisfied (or failed).
+      any_satisfied = true;
+    } else if (!iree_timeout_is_immediate(timeout)) {
+      // Slow path: register a timepoint with the waiter.
+      timepoint_semaphores[timepoint_count] = &semaphore->base;
+      iree_hal_semaphore_host_waiter_acquire_timepoint(
+          &waiter, &semaphore->base, semaphore_list.payload_values[i],
+          timeout, &timepoints[timepoint_count]);
+      ++timepoint_count;
     }
+    iree_slim_mutex_unlock(&semaphore->mutex);
   }
 
   // Perform the wait.
-  if (iree_status_is_ok(status)) {
-    if (wait_mode == IREE_HAL_WAIT_MODE_ANY) {
-      status = iree_wait_any(wait_set, deadline_ns, /*out_wake_handle=*/NULL);
-    } else {
-      status = iree_wait_all(wait_set, deadline_ns);
-    }
+  if (iree_status_is_ok(status) && timepoint_count > 0 &&
+      (wait_mode == IREE_HAL_WAIT_MODE_ALL || !any_satisfied)) {
+    iree_hal_semaphore_host_waiter_await(
+        &waiter,
+        wait_mode == IREE_HAL_WAIT_MODE_ANY ? 1 : (int32_t)timepoint_count,
+        deadline_ns);
   }
 
-  // TODO(benvanik): if we flip the API to multi-acquire events from the pool
-  // above then we can multi-release here too.
+  // Cancel all timepoints; resolved ones are no-ops but this ensures their
+  // callbacks have finished touching the waiter.
   for (iree_host_size_t i = 0; i < timepoint_count; ++i) {
-    iree_hal_semaphore_t* semaphore = timepoints[i].semaphore;
-    if (semaphore) {
-      iree_hal_semaphore_cancel_timepoint(semaphore, &timepoints[i].base);
-      iree_event_pool_release(event_pool, 1, &timepoints[i].event);
-    }
+    iree_hal_semaphore_cancel_timepoint(timepoint_semaphores[i],
+                                        &timepoints[i]);
   }
-  iree_wait_set_free(wait_set);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
   iree_arena_deinitialize(&arena);
 
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_semaphore_multi_wait_result(wait_mode,
+                                                       semaphore_list);
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
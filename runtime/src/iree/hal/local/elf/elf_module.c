@@ -230,11 +230,86 @@ static iree_byte_range_t iree_elf_module_calculate_vaddr_range(
   return byte_range;
 }
 
+// Maps the file-backed portion of the PT_LOAD segment |phdr| directly from
+// |file| with copy-on-write pages. |out_mapped| is set to false if the segment
+// could not be mapped and must be committed and copied instead.
+static iree_status_t iree_elf_module_map_segment(
+    const iree_elf_file_t* file, const iree_elf_phdr_t* phdr,
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module,
+    bool* out_mapped) {
+  *out_mapped = false;
+
+  // Pages can only be mapped if the segment has the same offset within a page
+  // in both the file and the host address space. This holds for all segments
+  // aligned to at least the host page size when the ELF itself is page aligned
+  // within the file.
+  const iree_host_size_t page_size = load_state->memory_info.normal_page_size;
+  uint8_t* segment_ptr = module->vaddr_bias + phdr->p_vaddr;
+  const uint64_t file_offset = file->offset + phdr->p_offset;
+  if (((uintptr_t)segment_ptr & (page_size - 1)) !=
+      (file_offset & (page_size - 1))) {
+    return iree_ok_status();
+  }
+
+  // Executable segments are mapped executable first to probe whether the file
+  // allows it: on noexec mounts mapping (or later protecting) file pages with
+  // PROT_EXEC fails and we must copy the segment into anonymous memory
+  // instead. Any other failure to map the file is treated the same way as the
+  // copy path is always available; the commit replaces whatever was mapped.
+  iree_byte_range_t file_range = {
+      .offset = phdr->p_vaddr,
+      .length = phdr->p_filesz,
+  };
+  const bool is_executable = (phdr->p_flags & IREE_ELF_PF_X) != 0;
+  iree_status_t status = iree_memory_view_map_file_range(
+      module->vaddr_bias, file_range, file->fd, file_offset,
+      is_executable ? IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_EXECUTE
+                    : IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE);
+
+  // Relocations still need to be applied so mapped pages start writable. Only
+  // pages that are actually written (relocation targets and data) are copied;
+  // the rest remain shared with the page cache.
+  if (iree_status_is_ok(status) && is_executable) {
+    status = iree_memory_view_protect_ranges(
+        module->vaddr_bias, 1, &file_range,
+        IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return iree_ok_status();
+  }
+
+  // p_memsz may be larger than p_filesz (.bss) and the extra bytes must be
+  // zeroed. The remainder of the last mapped page contains whatever follows
+  // the segment in the file and is cleared by hand while any whole pages past
+  // it are committed fresh (and thus zeroed).
+  if (phdr->p_memsz > phdr->p_filesz) {
+    uint8_t* fill_start = segment_ptr + phdr->p_filesz;
+    uint8_t* fill_end = segment_ptr + phdr->p_memsz;
+    uint8_t* page_end =
+        (uint8_t*)iree_page_align_end((uintptr_t)fill_start, page_size);
+    memset(fill_start, 0, iree_min(page_end, fill_end) - fill_start);
+    if (fill_end > page_end) {
+      iree_byte_range_t fill_range = {
+          .offset = (iree_host_size_t)(page_end - module->vaddr_bias),
+          .length = (iree_host_size_t)(fill_end - page_end),
+      };
+      IREE_RETURN_IF_ERROR(iree_memory_view_commit_ranges(
+          module->vaddr_bias, 1, &fill_range,
+          IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
+    }
+  }
+
+  *out_mapped = true;
+  return iree_ok_status();
+}
+
 // Allocates space for and loads all DT_LOAD segments into the host virtual
-// address space.
+// address space. If |file| is provided segments are mapped from it where
+// possible and otherwise copied from |raw_data|.
 static iree_status_t iree_elf_module_load_segments(
-    iree_const_byte_span_t raw_data, iree_elf_module_load_state_t* load_state,
-    iree_elf_module_t* module) {
+    iree_const_byte_span_t raw_data, const iree_elf_file_t* file,
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module) {
   // Calculate the total internally-aligned vaddr range.
   iree_byte_range_t vaddr_range =
       iree_elf_module_calculate_vaddr_range(load_state);
@@ -253,6 +328,14 @@ static iree_status_t iree_elf_module_load_segments(
     const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
     if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
 
+    // Map the segment directly from the source file when we have one.
+    bool is_mapped = false;
+    if (file && phdr->p_filesz > 0) {
+      IREE_RETURN_IF_ERROR(iree_elf_module_map_segment(file, phdr, load_state,
+                                                       module, &is_mapped));
+    }
+    if (is_mapped) continue;
+
     // Commit the range of pages used by this segment, initially with write
     // access so that we can modify the pages.
     iree_byte_range_t byte_range = {
@@ -264,13 +347,6 @@ static iree_status_t iree_elf_module_load_segments(
         IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
 
     // Copy data present in the file.
-    // TODO(benvanik): infra for being able to detect if the source model is in
-    // a mapped file - if it is, we can remap the page and directly reference it
-    // here for read-only segments and setup copy-on-write for writeable ones.
-    // We'd need a way to pass in the underlying mapping and some guarantees on
-    // the lifetime of it. Today we are just always committing above and copying
-    // here because it keeps this all super simple (you know, as simple as an
-    // entire custom ELF loader can be :).
     if (phdr->p_filesz > 0) {
       memcpy(module->vaddr_bias + phdr->p_vaddr, raw_data.data + phdr->p_offset,
              phdr->p_filesz);
@@ -279,12 +355,12 @@ static iree_status_t iree_elf_module_load_segments(
     // NOTE: p_memsz may be larger than p_filesz - if so, the extra memory bytes
     // must be zeroed. We require that the initial allocation is zeroed anyway
     // so this is a no-op.
-
-    // NOTE: the pages are still writeable; we need to apply relocations before
-    // we can go back through and remove write access from read-only/executable
-    // pages in iree_elf_module_protect_segments.
   }
 
+  // NOTE: the pages are still writeable; we need to apply relocations before
+  // we can go back through and remove write access from read-only/executable
+  // pages in iree_elf_module_protect_segments.
+
   return iree_ok_status();
 }
 
@@ -569,8 +645,8 @@ static const iree_elf_sym_t* iree_elf_module_lookup_global_symbol(
 // API
 //==============================================================================
 
-iree_status_t iree_elf_module_initialize_from_memory(
-    iree_const_byte_span_t raw_data,
+static iree_status_t iree_elf_module_initialize(
+    iree_const_byte_span_t raw_data, const iree_elf_file_t* file,
     const iree_elf_import_table_t* import_table,
     iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
   IREE_ASSERT_ARGUMENT(raw_data.data);
@@ -589,7 +665,8 @@ iree_status_t iree_elf_module_initialize_from_memory(
   // Allocate and load the ELF into memory.
   iree_memory_jit_context_begin();
   if (iree_status_is_ok(status)) {
-    status = iree_elf_module_load_segments(raw_data, &load_state, out_module);
+    status = iree_elf_module_load_segments(raw_data, file, &load_state,
+                                           out_module);
   }
 
   // Parse required dynamic symbol tables in loaded memory. These are used for
@@ -630,6 +707,23 @@ iree_status_t iree_elf_module_initialize_from_memory(
   return status;
 }
 
+iree_status_t iree_elf_module_initialize_from_memory(
+    iree_const_byte_span_t raw_data,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  return iree_elf_module_initialize(raw_data, /*file=*/NULL, import_table,
+                                    host_allocator, out_module);
+}
+
+iree_status_t iree_elf_module_initialize_from_file(
+    iree_const_byte_span_t raw_data, const iree_elf_file_t* file,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  IREE_ASSERT_ARGUMENT(file);
+  return iree_elf_module_initialize(raw_data, file, import_table,
+                                    host_allocator, out_module);
+}
+
 void iree_elf_module_deinitialize(iree_elf_module_t* module) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -77,6 +77,30 @@ iree_status_t iree_elf_module_initialize_from_memory(
     const iree_elf_import_table_t* import_table,
     iree_allocator_t host_allocator, iree_elf_module_t* out_module);
 
+// A file containing an ELF that loadable segments may be mapped from.
+typedef struct iree_elf_file_t {
+  // File descriptor opened for reading. Mappings retain their own reference to
+  // the file and the descriptor may be closed once initialization returns.
+  int fd;
+  // Offset of the ELF within the file. Segments are only mapped if this is
+  // page aligned (or otherwise congruent with the segment alignment).
+  uint64_t offset;
+} iree_elf_file_t;
+
+// Initializes an ELF module from the ELF |raw_data| stored in |file|.
+// |raw_data| must contain the same bytes as |file| starting at its offset and
+// is usually a read-only mapping of the file. Loadable segments are mapped
+// directly from the file such that pages that are never written (code and
+// read-only data) are shared through the page cache with all other processes
+// loading the same file while writable segments are copy-on-write. Segments
+// that cannot be mapped are copied as with
+// iree_elf_module_initialize_from_memory. The file must not be modified while
+// the module is loaded.
+iree_status_t iree_elf_module_initialize_from_file(
+    iree_const_byte_span_t raw_data, const iree_elf_file_t* file,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module);
+
 // Deinitializes a |module|, releasing any allocated executable or data pages.
 // Invalidates all symbol pointers previous retrieved from the module and any
 // pointer to data that may have been in the module text or rwdata.
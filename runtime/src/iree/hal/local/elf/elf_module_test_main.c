@@ -4,6 +4,11 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "iree/base/api.h"
 #include "iree/base/internal/cpu.h"
 #include "iree/base/target_platform.h"
@@ -11,6 +16,13 @@
 #include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/executable_library.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
 // ELF modules for various platforms embedded in the binary:
 #include "iree/hal/local/elf/testdata/elementwise_mul.h"
 
@@ -52,23 +64,14 @@ static iree_status_t query_arch_test_file_data(
                           "the application for the current target platform");
 }
 
-static iree_status_t run_test() {
-  iree_const_byte_span_t file_data;
-  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
-
-  iree_elf_import_table_t import_table;
-  memset(&import_table, 0, sizeof(import_table));
-  iree_elf_module_t module;
-  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
-      file_data, &import_table, iree_allocator_system(), &module));
-
+static iree_status_t run_module(iree_elf_module_t* module) {
   iree_hal_executable_environment_v0_t environment;
   iree_hal_executable_environment_initialize(iree_allocator_system(),
                                              &environment);
 
   void* query_fn_ptr = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
+      module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
 
   union {
     const iree_hal_executable_library_header_t** header;
@@ -152,10 +155,169 @@ static iree_status_t run_test() {
     }
   }
 
+  return status;
+}
+
+static iree_status_t run_test_from_memory(iree_const_byte_span_t file_data) {
+  iree_elf_import_table_t import_table;
+  memset(&import_table, 0, sizeof(import_table));
+  iree_elf_module_t module;
+  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
+      file_data, &import_table, iree_allocator_system(), &module));
+  iree_status_t status = run_module(&module);
   iree_elf_module_deinitialize(&module);
   return status;
 }
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+
+// Returns the number of mappings of the file with inode |file_ino| within the
+// address space reserved by |module| as reported by /proc/self/maps.
+static iree_status_t count_file_mappings(const iree_elf_module_t* module,
+                                         ino_t file_ino,
+                                         iree_host_size_t* out_count) {
+  *out_count = 0;
+  FILE* maps = fopen("/proc/self/maps", "r");
+  if (!maps) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open /proc/self/maps");
+  }
+  const uintptr_t module_begin = (uintptr_t)module->vaddr_base;
+  const uintptr_t module_end = module_begin + module->vaddr_size;
+  char line[512];
+  while (fgets(line, sizeof(line), maps)) {
+    uintptr_t begin = 0, end = 0;
+    char perms[5];
+    unsigned long long offset = 0, inode = 0;
+    unsigned int dev_major = 0, dev_minor = 0;
+    if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " %4s %llx %x:%x %llu", &begin,
+               &end, perms, &offset, &dev_major, &dev_minor, &inode) != 7) {
+      continue;
+    }
+    if (begin >= module_begin && end <= module_end &&
+        inode == (unsigned long long)file_ino) {
+      ++*out_count;
+    }
+  }
+  fclose(maps);
+  return iree_ok_status();
+}
+
+// Writes |file_data| into an unlinked temporary file after a page of padding
+// and loads the module with its segments mapped from the file.
+static iree_status_t run_test_from_file(iree_const_byte_span_t file_data) {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TMPDIR");
+  if (!tmpdir) tmpdir = "/tmp";
+  char path[256];
+  snprintf(path, sizeof(path), "%s/iree_elf_module_test_XXXXXX", tmpdir);
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to create temporary file '%s'", path);
+  }
+  unlink(path);
+
+  const iree_elf_file_t file = {
+      .fd = fd,
+      .offset = (uint64_t)sysconf(_SC_PAGESIZE),
+  };
+  const size_t file_length = (size_t)file.offset + file_data.data_length;
+  iree_status_t status = iree_ok_status();
+  if (ftruncate(fd, (off_t)file.offset) != 0 ||
+      pwrite(fd, file_data.data, file_data.data_length, (off_t)file.offset) !=
+          (ssize_t)file_data.data_length) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write temporary file");
+  }
+
+  struct stat file_stat;
+  if (iree_status_is_ok(status) && fstat(fd, &file_stat) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to stat temporary file");
+  }
+
+  void* file_ptr = MAP_FAILED;
+  if (iree_status_is_ok(status)) {
+    file_ptr = mmap(NULL, file_length, PROT_READ, MAP_SHARED, fd, 0);
+    if (file_ptr == MAP_FAILED) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to map temporary file");
+    }
+  }
+
+  // The module must remain usable after the descriptor is closed.
+  iree_elf_module_t module;
+  if (iree_status_is_ok(status)) {
+    iree_elf_import_table_t import_table;
+    memset(&import_table, 0, sizeof(import_table));
+    status = iree_elf_module_initialize_from_file(
+        iree_make_const_byte_span((const uint8_t*)file_ptr + file.offset,
+                                  file_data.data_length),
+        &file, &import_table, iree_allocator_system(), &module);
+  }
+  close(fd);
+  if (file_ptr != MAP_FAILED) munmap(file_ptr, file_length);
+
+  if (iree_status_is_ok(status)) {
+    // The file is page aligned and segments are laid out at the same offset
+    // within a page in the file and in memory, so at least one of them must
+    // have been mapped instead of copied.
+    iree_host_size_t mapping_count = 0;
+    status = count_file_mappings(&module, file_stat.st_ino, &mapping_count);
+    if (iree_status_is_ok(status) && mapping_count == 0) {
+      status = iree_make_status(IREE_STATUS_INTERNAL,
+                                "no segments were mapped from the file");
+    }
+    if (iree_status_is_ok(status)) {
+      status = run_module(&module);
+    }
+    iree_elf_module_deinitialize(&module);
+  }
+  return status;
+}
+
+// Loads the module with a file descriptor that cannot be mapped (a pipe) to
+// check that segments fall back to being copied from |file_data|, as they must
+// when the file lives on a mount that disallows mapping or executing it.
+static iree_status_t run_test_from_unmappable_file(
+    iree_const_byte_span_t file_data) {
+  int fds[2] = {-1, -1};
+  if (pipe(fds) != 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to create pipe");
+  }
+  const iree_elf_file_t file = {
+      .fd = fds[0],
+      .offset = 0,
+  };
+  iree_elf_import_table_t import_table;
+  memset(&import_table, 0, sizeof(import_table));
+  iree_elf_module_t module;
+  iree_status_t status = iree_elf_module_initialize_from_file(
+      file_data, &file, &import_table, iree_allocator_system(), &module);
+  close(fds[0]);
+  close(fds[1]);
+  if (iree_status_is_ok(status)) {
+    status = run_module(&module);
+    iree_elf_module_deinitialize(&module);
+  }
+  return status;
+}
+
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+static iree_status_t run_test() {
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
+  IREE_RETURN_IF_ERROR(run_test_from_memory(file_data));
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+  IREE_RETURN_IF_ERROR(run_test_from_file(file_data));
+  IREE_RETURN_IF_ERROR(run_test_from_unmappable_file(file_data));
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+  return iree_ok_status();
+}
+
 int main() {
   const iree_status_t result = run_test();
   int ret = (int)iree_status_code(result);
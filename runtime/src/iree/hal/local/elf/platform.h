@@ -158,6 +158,22 @@ iree_status_t iree_memory_view_commit_ranges(
     void* base_address, iree_host_size_t range_count,
     const iree_byte_range_t* ranges, iree_memory_access_t initial_access);
 
+// Maps the pages overlapping |range| directly from the file |fd| such that the
+// byte at |range|.offset is the byte at |file_offset| in the file. The pages
+// are private copy-on-write: they are shared with the page cache and any other
+// process mapping the same file until written. The file must not be modified
+// for the lifetime of the view and |fd| may be closed after this returns.
+//
+// The view address and |file_offset| must be congruent modulo the page size
+// and any bytes in the pages before and after |range| are also taken from the
+// file. Returns IREE_STATUS_UNAVAILABLE on platforms that cannot map files into
+// views in which case callers must commit and copy instead.
+//
+// Implemented by mmap+MAP_FIXED|MAP_PRIVATE.
+iree_status_t iree_memory_view_map_file_range(
+    void* base_address, iree_byte_range_t range, int fd, uint64_t file_offset,
+    iree_memory_access_t initial_access);
+
 // Changes the access protection of view byte ranges defined by |byte_ranges|.
 // Ranges will be adjusted to the page granularity of the view.
 //
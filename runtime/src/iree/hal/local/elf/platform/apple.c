@@ -143,6 +143,16 @@ iree_status_t iree_memory_view_commit_ranges(
   return status;
 }
 
+iree_status_t iree_memory_view_map_file_range(
+    void* base_address, iree_byte_range_t range, int fd, uint64_t file_offset,
+    iree_memory_access_t initial_access) {
+  // Executable pages must be MAP_JIT or code signed so file-backed
+  // executable pages are not usable for loaded modules.
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "file mapping not supported for executable views on Apple platforms");
+}
+
 iree_status_t iree_memory_view_protect_ranges(void* base_address,
                                               iree_host_size_t range_count,
                                               const iree_byte_range_t* ranges,
@@ -118,6 +118,16 @@ iree_status_t iree_memory_view_commit_ranges(
   return status;
 }
 
+iree_status_t iree_memory_view_map_file_range(
+    void* base_address, iree_byte_range_t range, int fd, uint64_t file_offset,
+    iree_memory_access_t initial_access) {
+  // Mapping a file view into an existing reservation requires the reservation
+  // to be made of placeholders (VirtualAlloc2/MapViewOfFile3) which the views
+  // here are not. Callers fall back to committing and copying the range.
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "file mapping not supported on Windows");
+}
+
 iree_status_t iree_memory_view_protect_ranges(void* base_address,
                                               iree_host_size_t range_count,
                                               const iree_byte_range_t* ranges,
@@ -0,0 +1,752 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/profiling.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_perf_event_open)
+#define IREE_HAL_LOCAL_PROFILING_PERF_EVENTS 1
+#endif  // __NR_perf_event_open
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
+#if !defined(IREE_PLATFORM_WINDOWS) && !defined(IREE_PLATFORM_GENERIC)
+#include <pthread.h>
+#endif  // !IREE_PLATFORM_WINDOWS && !IREE_PLATFORM_GENERIC
+
+// Maximum number of distinct threads that may issue workgroups during a
+// profile. Samples from additional threads are dropped.
+#define IREE_HAL_LOCAL_PROFILING_MAX_THREADS 256
+
+// Initial capacity of the per-thread entry point tables; must be a power of 2.
+#define IREE_HAL_LOCAL_PROFILING_INITIAL_ENTRY_CAPACITY 64
+
+static const char* iree_hal_local_profiling_counter_names
+    [IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT] = {
+        "cycles",
+        "instructions",
+        "llc-misses",
+        "branch-misses",
+};
+
+// Returns a nonzero value uniquely identifying the calling thread.
+static intptr_t iree_hal_local_profiling_thread_key(void) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  return (intptr_t)GetCurrentThreadId() + 1;
+#elif defined(IREE_PLATFORM_GENERIC)
+  return 1;  // single-threaded
+#else
+  return (intptr_t)pthread_self() | 1;
+#endif  // IREE_PLATFORM_*
+}
+
+//===----------------------------------------------------------------------===//
+// perf_event_open
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_HAL_LOCAL_PROFILING_PERF_EVENTS)
+
+#if !defined(PERF_FLAG_FD_CLOEXEC)
+#define PERF_FLAG_FD_CLOEXEC 0
+#endif  // !PERF_FLAG_FD_CLOEXEC
+
+static const uint64_t iree_hal_local_profiling_counter_configs
+    [IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Opens |counter| for the calling thread as part of |group_fd| (or as a new
+// group leader if -1). Returns -1 and sets errno on failure.
+static int iree_hal_local_profiling_open_counter(
+    iree_hal_local_profiling_counter_t counter, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = iree_hal_local_profiling_counter_configs[counter];
+  attr.read_format = PERF_FORMAT_GROUP;
+  // User-space only so that the default perf_event_paranoid level allows it.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                      group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+#endif  // IREE_HAL_LOCAL_PROFILING_PERF_EVENTS
+
+//===----------------------------------------------------------------------===//
+// Session state
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_local_profiling_thread_entry_t {
+  // Retained executable or NULL if the table slot is empty.
+  iree_hal_executable_t* executable;
+  iree_host_size_t ordinal;
+  const char* name;
+  uint64_t workgroup_count;
+  iree_duration_t duration_ns;
+  uint64_t counters[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+} iree_hal_local_profiling_thread_entry_t;
+
+typedef struct iree_hal_local_profiling_session_t
+    iree_hal_local_profiling_session_t;
+
+// Per-thread sampling state. Only ever accessed by the owning thread while the
+// profile is active and by the thread ending the profile afterward.
+struct iree_hal_local_profiling_thread_t {
+  // Thread key that claimed the slot or 0 if unclaimed.
+  iree_atomic_intptr_t key;
+  iree_hal_local_profiling_session_t* session;
+
+  // perf_event group leader or -1 if no counters could be opened.
+  int group_fd;
+  int counter_fds[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+  // Counters opened in group read order.
+  iree_host_size_t counter_count;
+  iree_hal_local_profiling_counter_t
+      counter_order[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+
+  // Open-addressed table of entries keyed on (executable, ordinal).
+  iree_host_size_t entry_capacity;
+  iree_host_size_t entry_count;
+  iree_hal_local_profiling_thread_entry_t* entries;
+};
+
+struct iree_hal_local_profiling_session_t {
+  iree_allocator_t host_allocator;
+  // Optional report path; owned.
+  char* file_path;
+  // Counters that could be opened when the profile began.
+  uint32_t counter_mask;
+  // errno from the first counter that could not be opened, if any.
+  int counter_errno;
+  iree_hal_local_profiling_thread_t
+      threads[IREE_HAL_LOCAL_PROFILING_MAX_THREADS];
+};
+
+static struct {
+  iree_slim_mutex_t mutex;
+  // Number of outstanding iree_hal_local_profiling_begin calls.
+  int32_t begin_count;
+  // Active session or NULL if not profiling. Read without the lock.
+  iree_atomic_intptr_t session;
+  // Number of threads between sample begin and end that may be using the
+  // session. Incremented before the session is loaded so that ending a profile
+  // can wait for all samplers to drain before freeing the session.
+  iree_atomic_int32_t sampler_count;
+
+  // Results of the last completed profile; a single allocation with names
+  // stored after the entries.
+  iree_allocator_t results_allocator;
+  iree_host_size_t result_count;
+  iree_hal_local_profiling_entry_t* results;
+  uint32_t result_counter_mask;
+  int result_counter_errno;
+  bool has_results;
+} iree_hal_local_profiling_state_;
+static iree_once_flag iree_hal_local_profiling_state_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_local_profiling_state_initialize(void) {
+  memset(&iree_hal_local_profiling_state_, 0,
+         sizeof(iree_hal_local_profiling_state_));
+  iree_slim_mutex_initialize(&iree_hal_local_profiling_state_.mutex);
+}
+
+static void iree_hal_local_profiling_state_lock(void) {
+  iree_call_once(&iree_hal_local_profiling_state_flag_,
+                 iree_hal_local_profiling_state_initialize);
+  iree_slim_mutex_lock(&iree_hal_local_profiling_state_.mutex);
+}
+
+static void iree_hal_local_profiling_state_unlock(void) {
+  iree_slim_mutex_unlock(&iree_hal_local_profiling_state_.mutex);
+}
+
+// Probes which counters can be opened by the calling thread.
+static void iree_hal_local_profiling_session_probe_counters(
+    iree_hal_local_profiling_session_t* session) {
+#if defined(IREE_HAL_LOCAL_PROFILING_PERF_EVENTS)
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    int fd = iree_hal_local_profiling_open_counter(
+        (iree_hal_local_profiling_counter_t)i, /*group_fd=*/-1);
+    if (fd >= 0) {
+      session->counter_mask |= 1u << i;
+      close(fd);
+    } else if (!session->counter_errno) {
+      session->counter_errno = errno;
+    }
+  }
+#else
+  session->counter_errno = ENOSYS;
+#endif  // IREE_HAL_LOCAL_PROFILING_PERF_EVENTS
+}
+
+// Opens the counter group for |thread| on the calling thread.
+static void iree_hal_local_profiling_thread_initialize(
+    iree_hal_local_profiling_session_t* session,
+    iree_hal_local_profiling_thread_t* thread) {
+  thread->session = session;
+  thread->group_fd = -1;
+  thread->counter_count = 0;
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    thread->counter_fds[i] = -1;
+  }
+#if defined(IREE_HAL_LOCAL_PROFILING_PERF_EVENTS)
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    if (!iree_all_bits_set(session->counter_mask, 1u << i)) continue;
+    int fd = iree_hal_local_profiling_open_counter(
+        (iree_hal_local_profiling_counter_t)i, thread->group_fd);
+    if (fd < 0) continue;  // counts as zero for this thread
+    if (thread->group_fd == -1) thread->group_fd = fd;
+    thread->counter_fds[i] = fd;
+    thread->counter_order[thread->counter_count++] =
+        (iree_hal_local_profiling_counter_t)i;
+  }
+#endif  // IREE_HAL_LOCAL_PROFILING_PERF_EVENTS
+}
+
+static void iree_hal_local_profiling_thread_deinitialize(
+    iree_hal_local_profiling_thread_t* thread) {
+#if defined(IREE_HAL_LOCAL_PROFILING_PERF_EVENTS)
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    if (thread->counter_fds[i] >= 0) close(thread->counter_fds[i]);
+  }
+#endif  // IREE_HAL_LOCAL_PROFILING_PERF_EVENTS
+  for (iree_host_size_t i = 0; i < thread->entry_capacity; ++i) {
+    iree_hal_executable_release(thread->entries[i].executable);
+  }
+  iree_allocator_free(thread->session->host_allocator, thread->entries);
+}
+
+// Reads the current counter values of |thread| into |out_counters|.
+static void iree_hal_local_profiling_thread_read(
+    iree_hal_local_profiling_thread_t* thread, uint64_t* out_counters) {
+#if defined(IREE_HAL_LOCAL_PROFILING_PERF_EVENTS)
+  if (thread->group_fd < 0) return;
+  // PERF_FORMAT_GROUP: { u64 nr; u64 values[nr]; }
+  uint64_t values[1 + IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+  ssize_t read_length = read(thread->group_fd, values,
+                             (1 + thread->counter_count) * sizeof(uint64_t));
+  if (read_length < (ssize_t)sizeof(uint64_t)) return;
+  iree_host_size_t count = iree_min((iree_host_size_t)values[0],
+                                    thread->counter_count);
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    out_counters[thread->counter_order[i]] = values[1 + i];
+  }
+#endif  // IREE_HAL_LOCAL_PROFILING_PERF_EVENTS
+}
+
+// Returns the state of the calling thread, claiming a slot if needed.
+static iree_hal_local_profiling_thread_t*
+iree_hal_local_profiling_session_acquire_thread(
+    iree_hal_local_profiling_session_t* session) {
+  intptr_t key = iree_hal_local_profiling_thread_key();
+  uintptr_t hash = (uintptr_t)key;
+  hash ^= hash >> 17;
+  hash *= 0x9E3779B1u;
+  for (iree_host_size_t probe = 0; probe < IREE_HAL_LOCAL_PROFILING_MAX_THREADS;
+       ++probe) {
+    iree_hal_local_profiling_thread_t* thread =
+        &session->threads[(hash + probe) %
+                          IREE_HAL_LOCAL_PROFILING_MAX_THREADS];
+    intptr_t existing =
+        iree_atomic_load_intptr(&thread->key, iree_memory_order_acquire);
+    if (existing == key) return thread;
+    if (existing != 0) continue;
+    if (iree_atomic_compare_exchange_strong_intptr(
+            &thread->key, &existing, key, iree_memory_order_acq_rel,
+            iree_memory_order_acquire)) {
+      iree_hal_local_profiling_thread_initialize(session, thread);
+      return thread;
+    } else if (existing == key) {
+      return thread;
+    }
+  }
+  return NULL;  // too many threads
+}
+
+static iree_host_size_t iree_hal_local_profiling_entry_hash(
+    iree_hal_executable_t* executable, iree_host_size_t ordinal) {
+  uintptr_t hash = (uintptr_t)executable ^ (ordinal * 0x9E3779B1u);
+  return (iree_host_size_t)(hash ^ (hash >> 13));
+}
+
+// Grows the entry table of |thread| to |new_capacity| and rehashes.
+static iree_status_t iree_hal_local_profiling_thread_grow(
+    iree_hal_local_profiling_thread_t* thread, iree_host_size_t new_capacity) {
+  iree_hal_local_profiling_thread_entry_t* new_entries = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      thread->session->host_allocator, new_capacity * sizeof(*new_entries),
+      (void**)&new_entries));
+  for (iree_host_size_t i = 0; i < thread->entry_capacity; ++i) {
+    iree_hal_local_profiling_thread_entry_t* entry = &thread->entries[i];
+    if (!entry->executable) continue;
+    iree_host_size_t slot =
+        iree_hal_local_profiling_entry_hash(entry->executable, entry->ordinal);
+    while (new_entries[slot & (new_capacity - 1)].executable) ++slot;
+    new_entries[slot & (new_capacity - 1)] = *entry;
+  }
+  iree_allocator_free(thread->session->host_allocator, thread->entries);
+  thread->entries = new_entries;
+  thread->entry_capacity = new_capacity;
+  return iree_ok_status();
+}
+
+// Returns the entry for |executable| |ordinal| in |thread|, inserting it if
+// needed. Returns NULL if the entry could not be allocated.
+static iree_hal_local_profiling_thread_entry_t*
+iree_hal_local_profiling_thread_lookup(
+    iree_hal_local_profiling_thread_t* thread,
+    iree_hal_executable_t* executable, iree_host_size_t ordinal,
+    const char* name) {
+  if (thread->entry_count + 1 > thread->entry_capacity * 3 / 4) {
+    iree_status_t status = iree_hal_local_profiling_thread_grow(
+        thread, thread->entry_capacity
+                    ? thread->entry_capacity * 2
+                    : IREE_HAL_LOCAL_PROFILING_INITIAL_ENTRY_CAPACITY);
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      return NULL;
+    }
+  }
+  iree_host_size_t mask = thread->entry_capacity - 1;
+  for (iree_host_size_t slot =
+           iree_hal_local_profiling_entry_hash(executable, ordinal);
+       ; ++slot) {
+    iree_hal_local_profiling_thread_entry_t* entry =
+        &thread->entries[slot & mask];
+    if (entry->executable == executable && entry->ordinal == ordinal) {
+      return entry;
+    } else if (!entry->executable) {
+      // Retain so that the executable (and its name) outlive the profile and
+      // the pointer cannot be reused by another executable in the meantime.
+      iree_hal_executable_retain(executable);
+      entry->executable = executable;
+      entry->ordinal = ordinal;
+      entry->name = name;
+      ++thread->entry_count;
+      return entry;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Aggregation and reporting
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_local_profiling_merge_t {
+  iree_allocator_t host_allocator;
+  iree_string_builder_t names;
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+  iree_hal_local_profiling_entry_t* entries;
+  // Offsets of each entry name in |names| (as names.data is reallocated).
+  iree_host_size_t* name_offsets;
+} iree_hal_local_profiling_merge_t;
+
+// Accumulates |source| into the merged entry with the same name.
+static iree_status_t iree_hal_local_profiling_merge_entry(
+    iree_hal_local_profiling_merge_t* merge,
+    const iree_hal_local_profiling_thread_entry_t* source) {
+  char unnamed_buffer[64];
+  iree_string_view_t name = iree_string_view_empty();
+  if (source->name) {
+    name = iree_make_cstring_view(source->name);
+  } else {
+    int length = snprintf(unnamed_buffer, sizeof(unnamed_buffer),
+                          "executable@%p:%" PRIhsz,
+                          (void*)source->executable, source->ordinal);
+    name = iree_make_string_view(unnamed_buffer, (iree_host_size_t)length);
+  }
+
+  iree_hal_local_profiling_entry_t* target = NULL;
+  const char* names = iree_string_builder_buffer(&merge->names);
+  for (iree_host_size_t i = 0; i < merge->count; ++i) {
+    if (iree_string_view_equal(
+            name, iree_make_string_view(names + merge->name_offsets[i],
+                                        merge->entries[i].name.size))) {
+      target = &merge->entries[i];
+      break;
+    }
+  }
+  if (!target) {
+    if (merge->count == merge->capacity) {
+      iree_host_size_t new_capacity = iree_max(16, merge->capacity * 2);
+      IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+          merge->host_allocator, new_capacity * sizeof(*merge->entries),
+          (void**)&merge->entries));
+      IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+          merge->host_allocator, new_capacity * sizeof(*merge->name_offsets),
+          (void**)&merge->name_offsets));
+      merge->capacity = new_capacity;
+    }
+    merge->name_offsets[merge->count] = iree_string_builder_size(&merge->names);
+    IREE_RETURN_IF_ERROR(
+        iree_string_builder_append_string(&merge->names, name));
+    target = &merge->entries[merge->count++];
+    memset(target, 0, sizeof(*target));
+    target->name.size = name.size;
+  }
+
+  target->workgroup_count += source->workgroup_count;
+  target->duration_ns += source->duration_ns;
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    target->counters[i] += source->counters[i];
+  }
+  return iree_ok_status();
+}
+
+static int iree_hal_local_profiling_entry_compare(const void* lhs_ptr,
+                                                  const void* rhs_ptr) {
+  const iree_hal_local_profiling_entry_t* lhs =
+      (const iree_hal_local_profiling_entry_t*)lhs_ptr;
+  const iree_hal_local_profiling_entry_t* rhs =
+      (const iree_hal_local_profiling_entry_t*)rhs_ptr;
+  // Most expensive first.
+  if (lhs->duration_ns != rhs->duration_ns) {
+    return lhs->duration_ns > rhs->duration_ns ? -1 : 1;
+  }
+  return iree_string_view_compare(lhs->name, rhs->name);
+}
+
+// Merges all thread samples of |session| and replaces the global results.
+// Must be called with the state lock held.
+static iree_status_t iree_hal_local_profiling_session_publish(
+    iree_hal_local_profiling_session_t* session) {
+  iree_hal_local_profiling_merge_t merge;
+  memset(&merge, 0, sizeof(merge));
+  merge.host_allocator = session->host_allocator;
+  iree_string_builder_initialize(session->host_allocator, &merge.names);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0;
+       i < IREE_HAL_LOCAL_PROFILING_MAX_THREADS && iree_status_is_ok(status);
+       ++i) {
+    iree_hal_local_profiling_thread_t* thread = &session->threads[i];
+    for (iree_host_size_t j = 0;
+         j < thread->entry_capacity && iree_status_is_ok(status); ++j) {
+      if (!thread->entries[j].executable) continue;
+      status = iree_hal_local_profiling_merge_entry(&merge,
+                                                    &thread->entries[j]);
+    }
+  }
+
+  // Pack the entries and names into a single allocation.
+  iree_hal_local_profiling_entry_t* results = NULL;
+  if (iree_status_is_ok(status) && merge.count > 0) {
+    iree_host_size_t entries_size = merge.count * sizeof(*results);
+    status = iree_allocator_malloc(
+        session->host_allocator,
+        entries_size + iree_string_builder_size(&merge.names),
+        (void**)&results);
+    if (iree_status_is_ok(status)) {
+      char* names = (char*)results + entries_size;
+      memcpy(names, iree_string_builder_buffer(&merge.names),
+             iree_string_builder_size(&merge.names));
+      for (iree_host_size_t i = 0; i < merge.count; ++i) {
+        results[i] = merge.entries[i];
+        results[i].name.data = names + merge.name_offsets[i];
+      }
+      qsort(results, merge.count, sizeof(*results),
+            iree_hal_local_profiling_entry_compare);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_allocator_free(iree_hal_local_profiling_state_.results_allocator,
+                        iree_hal_local_profiling_state_.results);
+    iree_hal_local_profiling_state_.results_allocator = session->host_allocator;
+    iree_hal_local_profiling_state_.result_count = merge.count;
+    iree_hal_local_profiling_state_.results = results;
+    iree_hal_local_profiling_state_.result_counter_mask = session->counter_mask;
+    iree_hal_local_profiling_state_.result_counter_errno =
+        session->counter_errno;
+    iree_hal_local_profiling_state_.has_results = true;
+  }
+
+  iree_allocator_free(session->host_allocator, merge.name_offsets);
+  iree_allocator_free(session->host_allocator, merge.entries);
+  iree_string_builder_deinitialize(&merge.names);
+  return status;
+}
+
+// Formats the global results. Must be called with the state lock held.
+static iree_status_t iree_hal_local_profiling_format_results(
+    iree_string_builder_t* builder) {
+  if (!iree_hal_local_profiling_state_.has_results) return iree_ok_status();
+  uint32_t counter_mask = iree_hal_local_profiling_state_.result_counter_mask;
+
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(
+      builder, "[[ iree_hal_local dispatch statistics ]]\n"));
+  if (counter_mask != (1u << IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT) - 1) {
+    int counter_errno = iree_hal_local_profiling_state_.result_counter_errno;
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "  (%s perf events unavailable: %s)\n",
+        counter_mask ? "some" : "all",
+        counter_errno ? strerror(counter_errno) : "unknown"));
+  }
+
+  // Header.
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "  %12s %12s", "total ms", "workgroups"));
+  for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, " %14s", iree_hal_local_profiling_counter_names[i]));
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_string_builder_append_format(builder, " %6s  %s\n", "IPC", "name"));
+
+  for (iree_host_size_t i = 0; i < iree_hal_local_profiling_state_.result_count;
+       ++i) {
+    const iree_hal_local_profiling_entry_t* entry =
+        &iree_hal_local_profiling_state_.results[i];
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "  %12.3f %12" PRIu64, entry->duration_ns / 1000000.0,
+        entry->workgroup_count));
+    for (int j = 0; j < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++j) {
+      if (iree_all_bits_set(counter_mask, 1u << j)) {
+        IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+            builder, " %14" PRIu64, entry->counters[j]));
+      } else {
+        IREE_RETURN_IF_ERROR(
+            iree_string_builder_append_format(builder, " %14s", "-"));
+      }
+    }
+    const int cycles = IREE_HAL_LOCAL_PROFILING_COUNTER_CYCLES;
+    const int instructions = IREE_HAL_LOCAL_PROFILING_COUNTER_INSTRUCTIONS;
+    if (entry->counters[cycles] > 0 &&
+        iree_all_bits_set(counter_mask, 1u << instructions)) {
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+          builder, " %6.2f",
+          (double)entry->counters[instructions] /
+              (double)entry->counters[cycles]));
+    } else {
+      IREE_RETURN_IF_ERROR(
+          iree_string_builder_append_format(builder, " %6s", "-"));
+    }
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "  %.*s\n", (int)entry->name.size, entry->name.data));
+  }
+  return iree_ok_status();
+}
+
+// Writes the global results to |file_path|. Must be called with the state
+// lock held.
+static iree_status_t iree_hal_local_profiling_write_results(
+    const char* file_path, iree_allocator_t host_allocator) {
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(host_allocator, &builder);
+  iree_status_t status = iree_hal_local_profiling_format_results(&builder);
+  if (iree_status_is_ok(status)) {
+    FILE* file = fopen(file_path, "wb");
+    if (!file) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to open profile file '%s'", file_path);
+    } else {
+      if (fwrite(iree_string_builder_buffer(&builder), 1,
+                 iree_string_builder_size(&builder),
+                 file) != iree_string_builder_size(&builder)) {
+        status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "failed to write profile file '%s'",
+                                  file_path);
+      }
+      fclose(file);
+    }
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Public API
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_hal_local_profiling_begin(
+    const iree_hal_device_profiling_options_t* options,
+    iree_allocator_t host_allocator) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_local_profiling_state_lock();
+
+  iree_status_t status = iree_ok_status();
+  if (iree_hal_local_profiling_state_.begin_count == 0) {
+    const char* file_path = options->file_path ? options->file_path : "";
+    iree_host_size_t file_path_length = strlen(file_path);
+    iree_hal_local_profiling_session_t* session = NULL;
+    status = iree_allocator_malloc(
+        host_allocator, sizeof(*session) + file_path_length + 1,
+        (void**)&session);
+    if (iree_status_is_ok(status)) {
+      session->host_allocator = host_allocator;
+      if (file_path_length > 0) {
+        session->file_path = (char*)session + sizeof(*session);
+        memcpy(session->file_path, file_path, file_path_length + 1);
+      }
+      iree_hal_local_profiling_session_probe_counters(session);
+      iree_atomic_store_intptr(&iree_hal_local_profiling_state_.session,
+                               (intptr_t)session, iree_memory_order_release);
+    }
+  }
+  if (iree_status_is_ok(status)) ++iree_hal_local_profiling_state_.begin_count;
+
+  iree_hal_local_profiling_state_unlock();
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_local_profiling_end(void) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_local_profiling_state_lock();
+
+  iree_status_t status = iree_ok_status();
+  if (iree_hal_local_profiling_state_.begin_count == 0) {
+    status = iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "no dispatch profile is active");
+  } else if (--iree_hal_local_profiling_state_.begin_count == 0) {
+    iree_hal_local_profiling_session_t* session =
+        (iree_hal_local_profiling_session_t*)iree_atomic_exchange_intptr(
+            &iree_hal_local_profiling_state_.session, 0,
+            iree_memory_order_seq_cst);
+    // Workers may still be sampling workgroups that began before the session
+    // was cleared; new samplers will observe the NULL session and back out.
+    while (iree_atomic_load_int32(
+               &iree_hal_local_profiling_state_.sampler_count,
+               iree_memory_order_seq_cst) != 0) {
+      iree_thread_yield();
+    }
+    status = iree_hal_local_profiling_session_publish(session);
+    if (iree_status_is_ok(status) && session->file_path) {
+      status = iree_hal_local_profiling_write_results(session->file_path,
+                                                      session->host_allocator);
+    }
+    for (iree_host_size_t i = 0; i < IREE_HAL_LOCAL_PROFILING_MAX_THREADS;
+         ++i) {
+      iree_hal_local_profiling_thread_t* thread = &session->threads[i];
+      if (!iree_atomic_load_intptr(&thread->key, iree_memory_order_acquire)) {
+        continue;
+      }
+      iree_hal_local_profiling_thread_deinitialize(thread);
+    }
+    iree_allocator_free(session->host_allocator, session);
+  }
+
+  iree_hal_local_profiling_state_unlock();
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_local_profiling_statistics_format(
+    iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(builder);
+  iree_hal_local_profiling_state_lock();
+  iree_status_t status = iree_hal_local_profiling_format_results(builder);
+  iree_hal_local_profiling_state_unlock();
+  return status;
+}
+
+iree_status_t iree_hal_local_profiling_statistics_fprint(FILE* file) {
+  IREE_ASSERT_ARGUMENT(file);
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_allocator_system(), &builder);
+  iree_status_t status = iree_hal_local_profiling_statistics_format(&builder);
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "%.*s", (int)iree_string_builder_size(&builder),
+            iree_string_builder_buffer(&builder));
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
+}
+
+iree_status_t iree_hal_local_profiling_statistics_enumerate(
+    iree_status_t (*callback)(void* user_data,
+                              const iree_hal_local_profiling_entry_t* entry),
+    void* user_data, uint32_t* out_counter_mask) {
+  IREE_ASSERT_ARGUMENT(callback);
+  iree_hal_local_profiling_state_lock();
+  if (out_counter_mask) {
+    *out_counter_mask = iree_hal_local_profiling_state_.result_counter_mask;
+  }
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0;
+       i < iree_hal_local_profiling_state_.result_count &&
+       iree_status_is_ok(status);
+       ++i) {
+    status = callback(user_data, &iree_hal_local_profiling_state_.results[i]);
+  }
+  iree_hal_local_profiling_state_unlock();
+  return status;
+}
+
+bool iree_hal_local_profiling_is_active(void) {
+  return iree_atomic_load_intptr(&iree_hal_local_profiling_state_.session,
+                                 iree_memory_order_relaxed) != 0;
+}
+
+// Releases the sampler reference taken by sample_begin.
+static void iree_hal_local_profiling_sampler_release(void) {
+  iree_atomic_fetch_sub_int32(&iree_hal_local_profiling_state_.sampler_count, 1,
+                              iree_memory_order_release);
+}
+
+bool iree_hal_local_profiling_sample_begin(
+    iree_hal_local_profiling_sample_t* out_sample) {
+  iree_atomic_fetch_add_int32(&iree_hal_local_profiling_state_.sampler_count, 1,
+                              iree_memory_order_seq_cst);
+  iree_hal_local_profiling_session_t* session =
+      (iree_hal_local_profiling_session_t*)iree_atomic_load_intptr(
+          &iree_hal_local_profiling_state_.session, iree_memory_order_seq_cst);
+  if (!session) {
+    iree_hal_local_profiling_sampler_release();
+    return false;
+  }
+  iree_hal_local_profiling_thread_t* thread =
+      iree_hal_local_profiling_session_acquire_thread(session);
+  if (!thread) {
+    iree_hal_local_profiling_sampler_release();
+    return false;
+  }
+  memset(out_sample, 0, sizeof(*out_sample));
+  out_sample->thread = thread;
+  iree_hal_local_profiling_thread_read(thread, out_sample->counters);
+  out_sample->start_time_ns = iree_time_now();
+  return true;
+}
+
+void iree_hal_local_profiling_sample_end(
+    iree_hal_local_profiling_sample_t* sample,
+    iree_hal_executable_t* executable, iree_host_size_t ordinal,
+    const char* name) {
+  iree_time_t end_time_ns = iree_time_now();
+  uint64_t end_counters[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT] = {0};
+  iree_hal_local_profiling_thread_t* thread = sample->thread;
+  iree_hal_local_profiling_thread_read(thread, end_counters);
+
+  iree_hal_local_profiling_thread_entry_t* entry =
+      iree_hal_local_profiling_thread_lookup(thread, executable, ordinal, name);
+  if (entry) {
+    ++entry->workgroup_count;
+    entry->duration_ns += end_time_ns - sample->start_time_ns;
+    for (int i = 0; i < IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT; ++i) {
+      entry->counters[i] += end_counters[i] - sample->counters[i];
+    }
+  }
+  iree_hal_local_profiling_sampler_release();
+}
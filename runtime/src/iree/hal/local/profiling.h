@@ -0,0 +1,129 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_PROFILING_H_
+#define IREE_HAL_LOCAL_PROFILING_H_
+
+#include <stdio.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// Local dispatch profiling
+//===----------------------------------------------------------------------===//
+//
+// Shared implementation of IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_COUNTERS
+// for local HAL devices. While a profile is active every workgroup issued
+// through iree_hal_local_executable_issue_call is timed and (where permitted)
+// hardware performance counters are sampled around it. Samples are aggregated
+// per executable entry point.
+//
+// On Linux/Android each thread issuing workgroups lazily opens its own
+// perf_event_open counter group measuring only that thread so that workers
+// never contend. If perf events are not available (unsupported platform, no
+// PMU access in a VM, or disallowed by kernel.perf_event_paranoid) profiles
+// degrade to workgroup counts and durations.
+//
+// Profiling is process-wide: all local devices share the active profile and
+// nested begin/end pairs from multiple devices are reference counted. As with
+// iree_hal_device_profiling_begin all local devices should be idle when
+// profiling begins or ends; workgroups still in flight when the profile ends
+// are waited on before their samples are released and may be dropped from the
+// results.
+
+// Hardware counters sampled around each workgroup.
+typedef enum iree_hal_local_profiling_counter_e {
+  IREE_HAL_LOCAL_PROFILING_COUNTER_CYCLES = 0,
+  IREE_HAL_LOCAL_PROFILING_COUNTER_INSTRUCTIONS,
+  IREE_HAL_LOCAL_PROFILING_COUNTER_LLC_MISSES,
+  IREE_HAL_LOCAL_PROFILING_COUNTER_BRANCH_MISSES,
+  IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT,
+} iree_hal_local_profiling_counter_t;
+
+// Aggregated statistics for a single executable entry point.
+typedef struct iree_hal_local_profiling_entry_t {
+  // Entry point name or `executable@<ptr>:<ordinal>` if the executable has no
+  // export names.
+  iree_string_view_t name;
+  // Total number of workgroups issued.
+  uint64_t workgroup_count;
+  // Total time spent executing workgroups summed across all threads.
+  iree_duration_t duration_ns;
+  // Hardware counter totals indexed by iree_hal_local_profiling_counter_t.
+  // Only valid if the counter bit is set in the profile's counter mask.
+  uint64_t counters[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+} iree_hal_local_profiling_entry_t;
+
+// Begins (or joins) the process-wide dispatch profile.
+// |options| file_path, if non-empty, receives a text report when the profile
+// ends. Fails only if the profile could not be allocated; unavailable
+// hardware counters are not an error.
+iree_status_t iree_hal_local_profiling_begin(
+    const iree_hal_device_profiling_options_t* options,
+    iree_allocator_t host_allocator);
+
+// Ends a profile begun with iree_hal_local_profiling_begin. When the last
+// participant ends the samples from all threads are aggregated and retained
+// until the next profile begins.
+iree_status_t iree_hal_local_profiling_end(void);
+
+// Formats the statistics of the last completed profile into |builder|.
+// Appends nothing if no profile has completed.
+iree_status_t iree_hal_local_profiling_statistics_format(
+    iree_string_builder_t* builder);
+
+// Prints the statistics of the last completed profile to |file|.
+iree_status_t iree_hal_local_profiling_statistics_fprint(FILE* file);
+
+// Calls |callback| for each entry point in the last completed profile.
+// |counter_mask| receives a bitmask of iree_hal_local_profiling_counter_t that
+// were captured.
+iree_status_t iree_hal_local_profiling_statistics_enumerate(
+    iree_status_t (*callback)(void* user_data,
+                              const iree_hal_local_profiling_entry_t* entry),
+    void* user_data, uint32_t* out_counter_mask);
+
+//===----------------------------------------------------------------------===//
+// Sampling (used by iree_hal_local_executable_issue_call)
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_local_profiling_thread_t
+    iree_hal_local_profiling_thread_t;
+
+// A sample in progress for a single workgroup.
+typedef struct iree_hal_local_profiling_sample_t {
+  iree_hal_local_profiling_thread_t* thread;
+  iree_time_t start_time_ns;
+  uint64_t counters[IREE_HAL_LOCAL_PROFILING_COUNTER_COUNT];
+} iree_hal_local_profiling_sample_t;
+
+// Returns true if a profile is active and workgroups should be sampled.
+bool iree_hal_local_profiling_is_active(void);
+
+// Begins sampling a workgroup on the calling thread.
+// Returns false if the sample could not be started (the profile ended or the
+// thread could not be registered) in which case the sample must not be ended.
+bool iree_hal_local_profiling_sample_begin(
+    iree_hal_local_profiling_sample_t* out_sample);
+
+// Ends a workgroup |sample| and accumulates it into |executable| |ordinal|.
+// |name| is the optional entry point name and must remain valid for as long as
+// |executable| is live; the executable is retained until the profile ends.
+void iree_hal_local_profiling_sample_end(
+    iree_hal_local_profiling_sample_t* sample,
+    iree_hal_executable_t* executable, iree_host_size_t ordinal,
+    const char* name);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_PROFILING_H_
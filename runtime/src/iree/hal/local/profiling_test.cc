@@ -0,0 +1,178 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/profiling.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "iree/hal/local/local_executable.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Executable with two entry points that spin for a bit so that there's
+// something to count.
+typedef struct {
+  iree_hal_local_executable_t base;
+  volatile uint32_t sink;
+} FakeExecutable;
+
+static const char* const kFakeExecutableNames[] = {"fake_a", "fake_b"};
+
+static void FakeExecutableDestroy(iree_hal_executable_t* base_executable) {
+  FakeExecutable* executable = (FakeExecutable*)base_executable;
+  iree_hal_local_executable_deinitialize(&executable->base);
+  iree_allocator_free(executable->base.host_allocator, executable);
+}
+
+static iree_status_t FakeExecutableIssueCall(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_state_v0_t* workgroup_state,
+    uint32_t worker_id) {
+  FakeExecutable* executable = (FakeExecutable*)base_executable;
+  for (uint32_t i = 0; i < 1000 * (ordinal + 1); ++i) executable->sink += i;
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t kFakeExecutableVTable = {
+    /*.base=*/{/*.destroy=*/FakeExecutableDestroy},
+    /*.issue_call=*/FakeExecutableIssueCall,
+};
+
+class ProfilingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_allocator_malloc(
+        iree_allocator_system(), sizeof(*executable_), (void**)&executable_));
+    iree_hal_local_executable_initialize(
+        &kFakeExecutableVTable, /*pipeline_layout_count=*/0,
+        /*source_pipeline_layouts=*/NULL, /*target_pipeline_layouts=*/NULL,
+        iree_allocator_system(), &executable_->base);
+    executable_->base.dispatch_names = kFakeExecutableNames;
+    executable_->sink = 0;
+  }
+
+  void TearDown() override {
+    iree_hal_executable_release((iree_hal_executable_t*)executable_);
+  }
+
+  // Issues |count| workgroups of entry point |ordinal|.
+  void IssueCalls(iree_host_size_t ordinal, int count) {
+    iree_hal_executable_dispatch_state_v0_t dispatch_state = {};
+    iree_hal_executable_workgroup_state_v0_t workgroup_state = {};
+    for (int i = 0; i < count; ++i) {
+      IREE_ASSERT_OK(iree_hal_local_executable_issue_call(
+          &executable_->base, ordinal, &dispatch_state, &workgroup_state,
+          /*worker_id=*/0));
+    }
+  }
+
+  // Returns the entries of the last completed profile.
+  std::vector<std::pair<std::string, iree_hal_local_profiling_entry_t>>
+  GetEntries(uint32_t* out_counter_mask) {
+    std::vector<std::pair<std::string, iree_hal_local_profiling_entry_t>>
+        entries;
+    IREE_CHECK_OK(iree_hal_local_profiling_statistics_enumerate(
+        [](void* user_data, const iree_hal_local_profiling_entry_t* entry) {
+          auto* entries = (std::vector<
+              std::pair<std::string, iree_hal_local_profiling_entry_t>>*)
+              user_data;
+          entries->push_back(
+              {std::string(entry->name.data, entry->name.size), *entry});
+          return iree_ok_status();
+        },
+        &entries, out_counter_mask));
+    return entries;
+  }
+
+  FakeExecutable* executable_ = nullptr;
+};
+
+TEST_F(ProfilingTest, AggregatesPerEntryPoint) {
+  iree_hal_device_profiling_options_t options = {0};
+  options.mode = IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_COUNTERS;
+  IREE_ASSERT_OK(
+      iree_hal_local_profiling_begin(&options, iree_allocator_system()));
+  EXPECT_TRUE(iree_hal_local_profiling_is_active());
+  IssueCalls(/*ordinal=*/0, 3);
+  IssueCalls(/*ordinal=*/1, 5);
+  IREE_ASSERT_OK(iree_hal_local_profiling_end());
+  EXPECT_FALSE(iree_hal_local_profiling_is_active());
+
+  // Calls outside of a profile are not recorded.
+  IssueCalls(/*ordinal=*/0, 7);
+
+  uint32_t counter_mask = 0;
+  auto entries = GetEntries(&counter_mask);
+  ASSERT_EQ(entries.size(), 2);
+  std::sort(entries.begin(), entries.end(),
+            [](const auto& lhs, const auto& rhs) {
+              return lhs.first < rhs.first;
+            });
+  EXPECT_EQ(entries[0].first, "fake_a");
+  EXPECT_EQ(entries[0].second.workgroup_count, 3);
+  EXPECT_EQ(entries[1].first, "fake_b");
+  EXPECT_EQ(entries[1].second.workgroup_count, 5);
+
+  // Counters are only present if perf events are permitted on this machine;
+  // when they are the spin loops must have retired some instructions.
+  const int instructions = IREE_HAL_LOCAL_PROFILING_COUNTER_INSTRUCTIONS;
+  if (iree_all_bits_set(counter_mask, 1u << instructions)) {
+    EXPECT_GT(entries[1].second.counters[instructions], 0);
+  }
+
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_allocator_system(), &builder);
+  IREE_ASSERT_OK(iree_hal_local_profiling_statistics_format(&builder));
+  std::string report(iree_string_builder_buffer(&builder),
+                     iree_string_builder_size(&builder));
+  iree_string_builder_deinitialize(&builder);
+  EXPECT_NE(report.find("fake_a"), std::string::npos);
+  EXPECT_NE(report.find("fake_b"), std::string::npos);
+}
+
+TEST_F(ProfilingTest, NestedBeginEnd) {
+  iree_hal_device_profiling_options_t options = {0};
+  options.mode = IREE_HAL_DEVICE_PROFILING_MODE_EXECUTABLE_COUNTERS;
+  IREE_ASSERT_OK(
+      iree_hal_local_profiling_begin(&options, iree_allocator_system()));
+  IREE_ASSERT_OK(
+      iree_hal_local_profiling_begin(&options, iree_allocator_system()));
+  IssueCalls(/*ordinal=*/0, 2);
+  IREE_ASSERT_OK(iree_hal_local_profiling_end());
+  EXPECT_TRUE(iree_hal_local_profiling_is_active());
+  IssueCalls(/*ordinal=*/0, 2);
+  IREE_ASSERT_OK(iree_hal_local_profiling_end());
+
+  auto entries = GetEntries(/*out_counter_mask=*/NULL);
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_EQ(entries[0].second.workgroup_count, 4);
+
+  iree_status_t status = iree_hal_local_profiling_end();
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION, status);
+  iree_status_free(status);
+}
+
+TEST_F(ProfilingTest, UnnamedEntryPoints) {
+  executable_->base.dispatch_names = NULL;
+  iree_hal_device_profiling_options_t options = {0};
+  options.mode = IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_COUNTERS;
+  IREE_ASSERT_OK(
+      iree_hal_local_profiling_begin(&options, iree_allocator_system()));
+  IssueCalls(/*ordinal=*/1, 1);
+  IREE_ASSERT_OK(iree_hal_local_profiling_end());
+
+  auto entries = GetEntries(/*out_counter_mask=*/NULL);
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_EQ(entries[0].first.rfind("executable@", 0), 0);
+  EXPECT_EQ(entries[0].first.back(), '1');
+}
+
+}  // namespace
@@ -305,3 +305,88 @@ IREE_API_EXPORT void iree_hal_semaphore_poll(iree_hal_semaphore_t* semaphore) {
 
   IREE_TRACE_ZONE_END(z0);
 }
+
+//===----------------------------------------------------------------------===//
+// iree_hal_semaphore_host_waiter_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_initialize(
+    iree_hal_semaphore_host_waiter_t* out_waiter) {
+  IREE_ASSERT_ARGUMENT(out_waiter);
+  iree_notification_initialize(&out_waiter->notification);
+  iree_atomic_store_int32(&out_waiter->resolved_count, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&out_waiter->failed_count, 0,
+                          iree_memory_order_relaxed);
+}
+
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_deinitialize(
+    iree_hal_semaphore_host_waiter_t* waiter) {
+  IREE_ASSERT_ARGUMENT(waiter);
+  iree_notification_deinitialize(&waiter->notification);
+}
+
+// Handles timepoint callbacks for host waiters by bumping the resolved count
+// and waking the waiting thread. The timepoint callback is issued under the
+// semaphore timepoint lock so this can't race with cancellation.
+static iree_status_t iree_hal_semaphore_host_waiter_timepoint_callback(
+    void* user_data, iree_hal_semaphore_t* semaphore, uint64_t value,
+    iree_status_code_t status_code) {
+  iree_hal_semaphore_host_waiter_t* waiter =
+      (iree_hal_semaphore_host_waiter_t*)user_data;
+  if (status_code != IREE_STATUS_OK) {
+    iree_atomic_fetch_add_int32(&waiter->failed_count, 1,
+                                iree_memory_order_relaxed);
+  }
+  iree_atomic_fetch_add_int32(&waiter->resolved_count, 1,
+                              iree_memory_order_acq_rel);
+  iree_notification_post(&waiter->notification, IREE_ALL_WAITERS);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_acquire_timepoint(
+    iree_hal_semaphore_host_waiter_t* waiter, iree_hal_semaphore_t* semaphore,
+    uint64_t minimum_value, iree_timeout_t timeout,
+    iree_hal_semaphore_timepoint_t* out_timepoint) {
+  iree_hal_semaphore_acquire_timepoint(
+      semaphore, minimum_value, timeout,
+      (iree_hal_semaphore_callback_t){
+          .fn = iree_hal_semaphore_host_waiter_timepoint_callback,
+          .user_data = waiter,
+      },
+      out_timepoint);
+}
+
+typedef struct iree_hal_semaphore_host_waiter_condition_t {
+  iree_hal_semaphore_host_waiter_t* waiter;
+  int32_t required_count;
+} iree_hal_semaphore_host_waiter_condition_t;
+
+// Returns true if the required number of timepoints have resolved or any
+// has failed. Used with iree_condition_fn_t and must match that signature.
+static bool iree_hal_semaphore_host_waiter_is_resolved(
+    const iree_hal_semaphore_host_waiter_condition_t* condition) {
+  // The acquire on the resolved count orders the failed count load after it.
+  int32_t resolved_count = iree_atomic_load_int32(
+      &condition->waiter->resolved_count, iree_memory_order_acquire);
+  return resolved_count >= condition->required_count ||
+         iree_atomic_load_int32(&condition->waiter->failed_count,
+                                iree_memory_order_relaxed) > 0;
+}
+
+IREE_API_EXPORT bool iree_hal_semaphore_host_waiter_await(
+    iree_hal_semaphore_host_waiter_t* waiter, int32_t required_count,
+    iree_time_t deadline_ns) {
+  IREE_ASSERT_ARGUMENT(waiter);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_semaphore_host_waiter_condition_t condition = {
+      .waiter = waiter,
+      .required_count = required_count,
+  };
+  bool is_resolved = iree_notification_await(
+      &waiter->notification,
+      (iree_condition_fn_t)iree_hal_semaphore_host_waiter_is_resolved,
+      (void*)&condition, iree_make_deadline(deadline_ns));
+  IREE_TRACE_ZONE_END(z0);
+  return is_resolved;
+}
@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 
@@ -173,6 +174,63 @@ IREE_API_EXPORT void iree_hal_semaphore_notify(
 // Must not be called from a timepoint callback.
 IREE_API_EXPORT void iree_hal_semaphore_poll(iree_hal_semaphore_t* semaphore);
 
+//===----------------------------------------------------------------------===//
+// iree_hal_semaphore_host_waiter_t
+//===----------------------------------------------------------------------===//
+
+// An in-process waiter for one or more semaphore timepoints.
+// Timepoints acquired through the waiter post an iree_notification_t (a futex
+// where available) when resolved instead of setting an OS wait handle. This
+// makes host waits that never leave the process allocation- and fd-free and
+// lets a single waiter block on timepoints from any number of semaphores.
+//
+// Usage:
+//   iree_hal_semaphore_host_waiter_t waiter;
+//   iree_hal_semaphore_host_waiter_initialize(&waiter);
+//   iree_hal_semaphore_timepoint_t timepoints[2];
+//   iree_hal_semaphore_host_waiter_acquire_timepoint(&waiter, a, 1, timeout,
+//                                                    &timepoints[0]);
+//   iree_hal_semaphore_host_waiter_acquire_timepoint(&waiter, b, 2, timeout,
+//                                                    &timepoints[1]);
+//   iree_hal_semaphore_host_waiter_await(&waiter, 2, deadline_ns);
+//   iree_hal_semaphore_cancel_timepoint(a, &timepoints[0]);
+//   iree_hal_semaphore_cancel_timepoint(b, &timepoints[1]);
+//   iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+typedef struct iree_hal_semaphore_host_waiter_t {
+  // Posted each time a timepoint resolves.
+  iree_notification_t notification;
+  // Number of timepoints that have resolved (reached, expired, or failed).
+  iree_atomic_int32_t resolved_count;
+  // Number of timepoints that have resolved due to expiration or failure.
+  iree_atomic_int32_t failed_count;
+} iree_hal_semaphore_host_waiter_t;
+
+// Initializes |out_waiter| with no resolved timepoints.
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_initialize(
+    iree_hal_semaphore_host_waiter_t* out_waiter);
+
+// Deinitializes |waiter|. All timepoints acquired through the waiter must have
+// been cancelled with iree_hal_semaphore_cancel_timepoint (which is required
+// even if they resolved to ensure no callback is still touching the waiter).
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_deinitialize(
+    iree_hal_semaphore_host_waiter_t* waiter);
+
+// Acquires a timepoint on |semaphore| that notifies |waiter| when the payload
+// reaches or exceeds |minimum_value|, |timeout| elapses, or the semaphore
+// fails. See iree_hal_semaphore_acquire_timepoint.
+IREE_API_EXPORT void iree_hal_semaphore_host_waiter_acquire_timepoint(
+    iree_hal_semaphore_host_waiter_t* waiter, iree_hal_semaphore_t* semaphore,
+    uint64_t minimum_value, iree_timeout_t timeout,
+    iree_hal_semaphore_timepoint_t* out_timepoint);
+
+// Blocks the caller until at least |required_count| timepoints acquired
+// through |waiter| have resolved, any timepoint expires or fails, or
+// |deadline_ns| elapses. Returns false only if the deadline elapsed. Callers
+// must inspect the semaphores to determine the outcome.
+IREE_API_EXPORT bool iree_hal_semaphore_host_waiter_await(
+    iree_hal_semaphore_host_waiter_t* waiter, int32_t required_count,
+    iree_time_t deadline_ns);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
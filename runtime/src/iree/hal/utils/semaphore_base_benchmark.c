@@ -0,0 +1,276 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/hal/api.h"
+#include "iree/hal/utils/semaphore_base.h"
+#include "iree/testing/benchmark.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_test_semaphore_t
+//===----------------------------------------------------------------------===//
+
+// Minimal timeline semaphore that only tracks its value and notifies
+// timepoints. Waits are performed by the benchmarks themselves.
+typedef struct iree_hal_test_semaphore_t {
+  iree_hal_semaphore_t base;
+  iree_allocator_t host_allocator;
+  iree_slim_mutex_t mutex;
+  uint64_t current_value;
+} iree_hal_test_semaphore_t;
+
+static const iree_hal_semaphore_vtable_t iree_hal_test_semaphore_vtable;
+
+static iree_hal_test_semaphore_t* iree_hal_test_semaphore_cast(
+    iree_hal_semaphore_t* base_semaphore) {
+  return (iree_hal_test_semaphore_t*)base_semaphore;
+}
+
+static iree_status_t iree_hal_test_semaphore_create(
+    iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore) {
+  iree_hal_test_semaphore_t* semaphore = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, sizeof(*semaphore), (void**)&semaphore));
+  iree_hal_semaphore_initialize(&iree_hal_test_semaphore_vtable,
+                                &semaphore->base);
+  semaphore->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&semaphore->mutex);
+  semaphore->current_value = 0;
+  *out_semaphore = &semaphore->base;
+  return iree_ok_status();
+}
+
+static void iree_hal_test_semaphore_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_test_semaphore_t* semaphore =
+      iree_hal_test_semaphore_cast(base_semaphore);
+  iree_slim_mutex_deinitialize(&semaphore->mutex);
+  iree_hal_semaphore_deinitialize(&semaphore->base);
+  iree_allocator_free(semaphore->host_allocator, semaphore);
+}
+
+static iree_status_t iree_hal_test_semaphore_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_hal_test_semaphore_t* semaphore =
+      iree_hal_test_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  *out_value = semaphore->current_value;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_test_semaphore_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_hal_test_semaphore_t* semaphore =
+      iree_hal_test_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  semaphore->current_value = new_value;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  iree_hal_semaphore_notify(&semaphore->base, new_value, IREE_STATUS_OK);
+  return iree_ok_status();
+}
+
+static void iree_hal_test_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
+                                         iree_status_t status) {
+  iree_status_ignore(status);
+}
+
+static iree_status_t iree_hal_test_semaphore_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED);
+}
+
+static const iree_hal_semaphore_vtable_t iree_hal_test_semaphore_vtable = {
+    .destroy = iree_hal_test_semaphore_destroy,
+    .query = iree_hal_test_semaphore_query,
+    .signal = iree_hal_test_semaphore_signal,
+    .fail = iree_hal_test_semaphore_fail,
+    .wait = iree_hal_test_semaphore_wait,
+};
+
+// Returns true if |semaphore| has reached |value|.
+static bool iree_hal_test_semaphore_is_reached(iree_hal_semaphore_t* semaphore,
+                                               uint64_t value) {
+  uint64_t current_value = 0;
+  IREE_CHECK_OK(iree_hal_semaphore_query(semaphore, &current_value));
+  return current_value >= value;
+}
+
+//===----------------------------------------------------------------------===//
+// Wait strategies
+//===----------------------------------------------------------------------===//
+
+typedef enum iree_hal_semaphore_benchmark_mode_e {
+  // Timepoints notify an iree_hal_semaphore_host_waiter_t (futex).
+  IREE_HAL_SEMAPHORE_BENCHMARK_MODE_HOST_WAITER = 0,
+  // Timepoints set an iree_event_t that is waited on with iree_wait_one (an
+  // OS wait handle such as an eventfd).
+  IREE_HAL_SEMAPHORE_BENCHMARK_MODE_WAIT_HANDLE,
+} iree_hal_semaphore_benchmark_mode_t;
+
+static iree_status_t iree_hal_semaphore_benchmark_event_callback(
+    void* user_data, iree_hal_semaphore_t* semaphore, uint64_t value,
+    iree_status_code_t status_code) {
+  iree_event_set((iree_event_t*)user_data);
+  return iree_ok_status();
+}
+
+// Blocks until |semaphore| reaches |value| using the strategy in |mode|.
+// |event| is a reusable event used by the wait handle mode.
+static void iree_hal_semaphore_benchmark_wait(
+    iree_hal_semaphore_benchmark_mode_t mode, iree_hal_semaphore_t* semaphore,
+    uint64_t value, iree_event_t* event) {
+  // As in the real implementations the timepoint is acquired under the
+  // semaphore lock so that it can't miss a signal.
+  iree_hal_test_semaphore_t* test_semaphore =
+      iree_hal_test_semaphore_cast(semaphore);
+  iree_slim_mutex_lock(&test_semaphore->mutex);
+  if (test_semaphore->current_value >= value) {
+    iree_slim_mutex_unlock(&test_semaphore->mutex);
+    return;
+  }
+  iree_hal_semaphore_timepoint_t timepoint;
+  switch (mode) {
+    case IREE_HAL_SEMAPHORE_BENCHMARK_MODE_HOST_WAITER: {
+      iree_hal_semaphore_host_waiter_t waiter;
+      iree_hal_semaphore_host_waiter_initialize(&waiter);
+      iree_hal_semaphore_host_waiter_acquire_timepoint(
+          &waiter, semaphore, value, iree_infinite_timeout(), &timepoint);
+      iree_slim_mutex_unlock(&test_semaphore->mutex);
+      iree_hal_semaphore_host_waiter_await(&waiter, 1,
+                                           IREE_TIME_INFINITE_FUTURE);
+      iree_hal_semaphore_cancel_timepoint(semaphore, &timepoint);
+      iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+      break;
+    }
+    case IREE_HAL_SEMAPHORE_BENCHMARK_MODE_WAIT_HANDLE: {
+      iree_event_reset(event);
+      iree_hal_semaphore_acquire_timepoint(
+          semaphore, value, iree_infinite_timeout(),
+          (iree_hal_semaphore_callback_t){
+              .fn = iree_hal_semaphore_benchmark_event_callback,
+              .user_data = event,
+          },
+          &timepoint);
+      iree_slim_mutex_unlock(&test_semaphore->mutex);
+      IREE_CHECK_OK(iree_wait_one(event, IREE_TIME_INFINITE_FUTURE));
+      iree_hal_semaphore_cancel_timepoint(semaphore, &timepoint);
+      break;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Signal→wake latency
+//===----------------------------------------------------------------------===//
+
+// Value the ping semaphore is signaled to in order to stop the responder.
+#define IREE_HAL_SEMAPHORE_BENCHMARK_STOP_VALUE (UINT64_MAX - 1)
+
+typedef struct iree_hal_semaphore_benchmark_pair_t {
+  iree_hal_semaphore_benchmark_mode_t mode;
+  iree_hal_semaphore_t* ping;
+  iree_hal_semaphore_t* pong;
+} iree_hal_semaphore_benchmark_pair_t;
+
+// Waits for each ping and answers with a pong of the same value until the
+// stop value is observed.
+static int iree_hal_semaphore_benchmark_responder_main(void* entry_arg) {
+  iree_hal_semaphore_benchmark_pair_t* pair =
+      (iree_hal_semaphore_benchmark_pair_t*)entry_arg;
+  iree_event_t event;
+  IREE_CHECK_OK(iree_event_initialize(/*initial_state=*/false, &event));
+  for (uint64_t value = 1;; ++value) {
+    iree_hal_semaphore_benchmark_wait(pair->mode, pair->ping, value, &event);
+    if (iree_hal_test_semaphore_is_reached(
+            pair->ping, IREE_HAL_SEMAPHORE_BENCHMARK_STOP_VALUE)) {
+      break;
+    }
+    IREE_CHECK_OK(iree_hal_semaphore_signal(pair->pong, value));
+  }
+  iree_event_deinitialize(&event);
+  return 0;
+}
+
+// Measures the round-trip latency of signaling a semaphore waited on by
+// another thread and being woken by its response. Each iteration is two
+// signal→wake hops.
+//
+// user_data is the iree_hal_semaphore_benchmark_mode_t wait strategy.
+static iree_status_t iree_hal_semaphore_benchmark_signal_wake(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_hal_semaphore_benchmark_pair_t pair = {
+      .mode = (iree_hal_semaphore_benchmark_mode_t)(uintptr_t)
+                  benchmark_def->user_data,
+  };
+  IREE_CHECK_OK(iree_hal_test_semaphore_create(host_allocator, &pair.ping));
+  IREE_CHECK_OK(iree_hal_test_semaphore_create(host_allocator, &pair.pong));
+  iree_event_t event;
+  IREE_CHECK_OK(iree_event_initialize(/*initial_state=*/false, &event));
+
+  iree_thread_create_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.name = iree_make_cstring_view("responder");
+  iree_thread_t* thread = NULL;
+  IREE_CHECK_OK(iree_thread_create(iree_hal_semaphore_benchmark_responder_main,
+                                   &pair, params, host_allocator, &thread));
+
+  uint64_t value = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    ++value;
+    IREE_CHECK_OK(iree_hal_semaphore_signal(pair.ping, value));
+    iree_hal_semaphore_benchmark_wait(pair.mode, pair.pong, value, &event);
+  }
+
+  // Stop the responder and join it.
+  IREE_CHECK_OK(iree_hal_semaphore_signal(
+      pair.ping, IREE_HAL_SEMAPHORE_BENCHMARK_STOP_VALUE));
+  iree_thread_release(thread);
+
+  iree_event_deinitialize(&event);
+  iree_hal_semaphore_release(pair.pong);
+  iree_hal_semaphore_release(pair.ping);
+  return iree_ok_status();
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  // iree_hal_semaphore_benchmark_signal_wake
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_semaphore_benchmark_signal_wake,
+    };
+    benchmark_def.user_data =
+        (void*)(uintptr_t)IREE_HAL_SEMAPHORE_BENCHMARK_MODE_HOST_WAITER;
+    iree_benchmark_register(iree_make_cstring_view("signal_wake_host_waiter"),
+                            &benchmark_def);
+    benchmark_def.user_data =
+        (void*)(uintptr_t)IREE_HAL_SEMAPHORE_BENCHMARK_MODE_WAIT_HANDLE;
+    iree_benchmark_register(iree_make_cstring_view("signal_wake_wait_handle"),
+                            &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
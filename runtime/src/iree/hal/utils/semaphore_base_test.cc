@@ -374,6 +374,121 @@ TEST_F(TrackingSemaphoreTest, CancelResolvedTimepoint) {
   iree_hal_semaphore_release(*semaphore);
 }
 
+// Tests that a host waiter is woken when its timepoint is resolved from
+// another thread.
+TEST_F(TrackingSemaphoreTest, HostWaiterAsyncSignal) {
+  auto* semaphore = TestSemaphore::Create(0ull, host_allocator);
+
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_hal_semaphore_timepoint_t timepoint;
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore, 1ull, iree_infinite_timeout(), &timepoint);
+
+  std::thread thread([&]() {
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(*semaphore, 1ull));
+  });
+  EXPECT_TRUE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/1, IREE_TIME_INFINITE_FUTURE));
+  thread.join();
+
+  iree_hal_semaphore_cancel_timepoint(*semaphore, &timepoint);
+  EXPECT_EQ(iree_atomic_load_int32(&waiter.failed_count,
+                                   iree_memory_order_acquire),
+            0);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+  iree_hal_semaphore_release(*semaphore);
+}
+
+// Tests that a host waiter returns false when the deadline elapses.
+TEST_F(TrackingSemaphoreTest, HostWaiterDeadline) {
+  auto* semaphore = TestSemaphore::Create(0ull, host_allocator);
+
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_hal_semaphore_timepoint_t timepoint;
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore, 1ull, iree_infinite_timeout(), &timepoint);
+
+  EXPECT_FALSE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/1, IREE_TIME_INFINITE_PAST));
+  EXPECT_FALSE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/1,
+      iree_relative_timeout_to_deadline_ns(1000000)));
+
+  // Signals after cancellation must not touch the waiter.
+  iree_hal_semaphore_cancel_timepoint(*semaphore, &timepoint);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(*semaphore, 1ull));
+  iree_hal_semaphore_release(*semaphore);
+}
+
+// Tests a single host waiter shared by timepoints on multiple semaphores.
+TEST_F(TrackingSemaphoreTest, HostWaiterMultipleTimepoints) {
+  auto* semaphore0 = TestSemaphore::Create(0ull, host_allocator);
+  auto* semaphore1 = TestSemaphore::Create(0ull, host_allocator);
+
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_hal_semaphore_timepoint_t timepoints[2];
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore0, 1ull, iree_infinite_timeout(), &timepoints[0]);
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore1, 1ull, iree_infinite_timeout(), &timepoints[1]);
+
+  // Wait-any is satisfied by the first signal but wait-all is not.
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(*semaphore0, 1ull));
+  EXPECT_TRUE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/1, IREE_TIME_INFINITE_PAST));
+  EXPECT_FALSE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/2, IREE_TIME_INFINITE_PAST));
+
+  std::thread thread([&]() {
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(*semaphore1, 1ull));
+  });
+  EXPECT_TRUE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/2, IREE_TIME_INFINITE_FUTURE));
+  thread.join();
+
+  iree_hal_semaphore_cancel_timepoint(*semaphore0, &timepoints[0]);
+  iree_hal_semaphore_cancel_timepoint(*semaphore1, &timepoints[1]);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+  iree_hal_semaphore_release(*semaphore1);
+  iree_hal_semaphore_release(*semaphore0);
+}
+
+// Tests that a failure wakes a host waiter regardless of how many timepoints
+// it requires.
+TEST_F(TrackingSemaphoreTest, HostWaiterFailure) {
+  auto* semaphore0 = TestSemaphore::Create(0ull, host_allocator);
+  auto* semaphore1 = TestSemaphore::Create(0ull, host_allocator);
+
+  iree_hal_semaphore_host_waiter_t waiter;
+  iree_hal_semaphore_host_waiter_initialize(&waiter);
+  iree_hal_semaphore_timepoint_t timepoints[2];
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore0, 1ull, iree_infinite_timeout(), &timepoints[0]);
+  iree_hal_semaphore_host_waiter_acquire_timepoint(
+      &waiter, *semaphore1, 1ull, iree_infinite_timeout(), &timepoints[1]);
+
+  std::thread thread([&]() {
+    iree_hal_semaphore_fail(*semaphore1,
+                            iree_make_status(IREE_STATUS_DATA_LOSS, "whoops"));
+  });
+  EXPECT_TRUE(iree_hal_semaphore_host_waiter_await(
+      &waiter, /*required_count=*/2, IREE_TIME_INFINITE_FUTURE));
+  thread.join();
+  EXPECT_EQ(iree_atomic_load_int32(&waiter.failed_count,
+                                   iree_memory_order_acquire),
+            1);
+
+  iree_hal_semaphore_cancel_timepoint(*semaphore0, &timepoints[0]);
+  iree_hal_semaphore_cancel_timepoint(*semaphore1, &timepoints[1]);
+  iree_hal_semaphore_host_waiter_deinitialize(&waiter);
+  iree_hal_semaphore_release(*semaphore1);
+  iree_hal_semaphore_release(*semaphore0);
+}
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
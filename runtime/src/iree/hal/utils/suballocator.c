@@ -0,0 +1,775 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/suballocator.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+//===----------------------------------------------------------------------===//
+// TLSF free block index
+//===----------------------------------------------------------------------===//
+// Two-level segregated fit: free blocks are binned first by the power-of-two
+// range of their size (first level) and then linearly within that range
+// (second level). Bitmaps over both levels allow finding a free block at least
+// as large as a request in O(1) with a handful of bit scans.
+//
+// All sizes are tracked in units of the suballocator alignment such that the
+// first level is only used for ranges of at least IREE_HAL_TLSF_SL_COUNT units.
+//
+// Reference:
+//   http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+
+// log2 of the number of second-level bins per first-level range.
+#define IREE_HAL_TLSF_SL_LOG2 4
+#define IREE_HAL_TLSF_SL_COUNT (1u << IREE_HAL_TLSF_SL_LOG2)
+// Number of first-level ranges; bounds the maximum block size to
+// 2^(FL_COUNT + SL_LOG2 - 1) alignment units.
+#define IREE_HAL_TLSF_FL_COUNT 32
+
+typedef struct iree_hal_suballocator_slab_t iree_hal_suballocator_slab_t;
+
+// A contiguous range of a slab that is either free or suballocated.
+// Metadata is kept out-of-band as slab memory may not be host accessible.
+typedef struct iree_hal_suballocator_block_t {
+  // Offset and size of the block in bytes within the slab.
+  iree_device_size_t offset;
+  iree_device_size_t size;
+  iree_hal_suballocator_slab_t* slab;
+  // Physically adjacent blocks in the slab, if any.
+  struct iree_hal_suballocator_block_t* prev_physical;
+  struct iree_hal_suballocator_block_t* next_physical;
+  // Neighbors in the free list of the block size class when free.
+  // |next_free| is also used to chain unused block metadata.
+  struct iree_hal_suballocator_block_t* prev_free;
+  struct iree_hal_suballocator_block_t* next_free;
+  bool is_free;
+} iree_hal_suballocator_block_t;
+
+typedef struct iree_hal_suballocator_heap_t iree_hal_suballocator_heap_t;
+
+// A buffer reserved from the base allocator that blocks are carved from.
+struct iree_hal_suballocator_slab_t {
+  iree_hal_suballocator_slab_t* next;
+  iree_hal_suballocator_heap_t* heap;
+  iree_hal_buffer_t* buffer;
+  iree_device_size_t size;
+  // Block covering the start of the slab. When the slab is entirely unused this
+  // is a free block spanning the entire slab.
+  iree_hal_suballocator_block_t* first_block;
+};
+
+// A set of slabs all allocated with the same buffer parameters.
+struct iree_hal_suballocator_heap_t {
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t usage;
+  iree_hal_memory_access_t access;
+  iree_hal_suballocator_slab_t* slab_head;
+  uint32_t fl_bitmap;
+  uint32_t sl_bitmaps[IREE_HAL_TLSF_FL_COUNT];
+  iree_hal_suballocator_block_t* free_lists[IREE_HAL_TLSF_FL_COUNT]
+                                           [IREE_HAL_TLSF_SL_COUNT];
+  iree_hal_suballocator_heap_statistics_t statistics;
+};
+
+// Maps a size in alignment units to its first and second level bin.
+static void iree_hal_tlsf_mapping(uint64_t units, uint32_t* out_fl,
+                                  uint32_t* out_sl) {
+  if (units < IREE_HAL_TLSF_SL_COUNT) {
+    *out_fl = 0;
+    *out_sl = (uint32_t)units;
+  } else {
+    const uint32_t log2 = 63 - iree_math_count_leading_zeros_u64(units);
+    *out_fl = log2 - IREE_HAL_TLSF_SL_LOG2 + 1;
+    *out_sl = (uint32_t)(units >> (log2 - IREE_HAL_TLSF_SL_LOG2)) ^
+              IREE_HAL_TLSF_SL_COUNT;
+  }
+}
+
+// Maps a requested size to the first bin whose blocks are all large enough.
+static void iree_hal_tlsf_mapping_search(uint64_t units, uint32_t* out_fl,
+                                         uint32_t* out_sl) {
+  if (units >= IREE_HAL_TLSF_SL_COUNT) {
+    const uint32_t log2 = 63 - iree_math_count_leading_zeros_u64(units);
+    units += (1ull << (log2 - IREE_HAL_TLSF_SL_LOG2)) - 1;
+  }
+  iree_hal_tlsf_mapping(units, out_fl, out_sl);
+}
+
+// Returns the maximum number of alignment units a single block may cover.
+static uint64_t iree_hal_tlsf_max_units(void) {
+  return (1ull << (IREE_HAL_TLSF_FL_COUNT + IREE_HAL_TLSF_SL_LOG2 - 1)) - 1;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_suballocator_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_suballocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* base_allocator;
+  iree_hal_suballocator_options_t options;
+  // log2 of options.alignment used to convert between bytes and units.
+  uint32_t alignment_log2;
+
+  // Guards all heap state below.
+  iree_slim_mutex_t mutex;
+  // Unused block metadata ready for reuse.
+  iree_hal_suballocator_block_t* block_pool;
+  iree_host_size_t heap_count;
+  iree_hal_suballocator_heap_t heaps[IREE_HAL_SUBALLOCATOR_MAX_HEAP_COUNT];
+} iree_hal_suballocator_t;
+
+// A buffer suballocated from a slab. The buffer is a subspan of the slab buffer
+// such that devices see it as their own native buffer type. The subspan has the
+// suballocator as its device allocator so that it is returned to us for reuse
+// when recycled.
+typedef struct iree_hal_suballocator_buffer_t {
+  iree_hal_buffer_t base;
+  iree_hal_suballocator_block_t* block;
+} iree_hal_suballocator_buffer_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_suballocator_vtable;
+
+static iree_hal_suballocator_t* iree_hal_suballocator_cast(
+    iree_hal_allocator_t* IREE_RESTRICT base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_suballocator_vtable);
+  return (iree_hal_suballocator_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_suballocator_options_initialize(
+    iree_hal_suballocator_options_t* out_options) {
+  IREE_ASSERT_ARGUMENT(out_options);
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->slab_size = IREE_HAL_SUBALLOCATOR_DEFAULT_SLAB_SIZE;
+  out_options->max_suballocation_size = out_options->slab_size;
+  out_options->alignment = IREE_HAL_SUBALLOCATOR_DEFAULT_ALIGNMENT;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_suballocator_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+
+  if (!options->alignment ||
+      (options->alignment & (options->alignment - 1)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "suballocation alignment must be a power of two; "
+                            "got %" PRIu64,
+                            (uint64_t)options->alignment);
+  }
+  const uint32_t alignment_log2 =
+      iree_math_count_trailing_zeros_u64(options->alignment);
+  if (options->slab_size < options->alignment ||
+      (iree_device_align(options->slab_size, options->alignment) >>
+       alignment_log2) > iree_hal_tlsf_max_units() ||
+      (options->max_suballocation_size >> alignment_log2) >
+          iree_hal_tlsf_max_units()) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "slab size %" PRIu64
+                            " and maximum suballocation size %" PRIu64
+                            " must be within [alignment, 2^%d * alignment)",
+                            (uint64_t)options->slab_size,
+                            (uint64_t)options->max_suballocation_size,
+                            IREE_HAL_TLSF_FL_COUNT + IREE_HAL_TLSF_SL_LOG2 - 1);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)options->slab_size);
+
+  iree_hal_suballocator_t* allocator = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*allocator),
+                                (void**)&allocator));
+  memset(allocator, 0, sizeof(*allocator));
+  iree_hal_resource_initialize(&iree_hal_suballocator_vtable,
+                               &allocator->resource);
+  allocator->host_allocator = host_allocator;
+  allocator->base_allocator = base_allocator;
+  iree_hal_allocator_retain(base_allocator);
+  allocator->options = *options;
+  allocator->alignment_log2 = alignment_log2;
+  iree_slim_mutex_initialize(&allocator->mutex);
+
+  *out_allocator = (iree_hal_allocator_t*)allocator;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT bool iree_hal_suballocator_isa(
+    iree_hal_allocator_t* allocator) {
+  return iree_hal_resource_is(allocator, &iree_hal_suballocator_vtable);
+}
+
+//===----------------------------------------------------------------------===//
+// Block management
+//===----------------------------------------------------------------------===//
+// All functions in this section require the suballocator mutex be held.
+
+static iree_status_t iree_hal_suballocator_acquire_block(
+    iree_hal_suballocator_t* allocator,
+    iree_hal_suballocator_block_t** out_block) {
+  iree_hal_suballocator_block_t* block = allocator->block_pool;
+  if (block) {
+    allocator->block_pool = block->next_free;
+  } else {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        allocator->host_allocator, sizeof(*block), (void**)&block));
+  }
+  memset(block, 0, sizeof(*block));
+  *out_block = block;
+  return iree_ok_status();
+}
+
+static void iree_hal_suballocator_recycle_block(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_block_t* block) {
+  block->next_free = allocator->block_pool;
+  allocator->block_pool = block;
+}
+
+static uint64_t iree_hal_suballocator_block_units(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_block_t* block) {
+  return block->size >> allocator->alignment_log2;
+}
+
+static void iree_hal_suballocator_insert_free_block(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap,
+    iree_hal_suballocator_block_t* block) {
+  uint32_t fl = 0, sl = 0;
+  iree_hal_tlsf_mapping(iree_hal_suballocator_block_units(allocator, block),
+                        &fl, &sl);
+  iree_hal_suballocator_block_t* head = heap->free_lists[fl][sl];
+  block->is_free = true;
+  block->prev_free = NULL;
+  block->next_free = head;
+  if (head) head->prev_free = block;
+  heap->free_lists[fl][sl] = block;
+  heap->fl_bitmap |= 1u << fl;
+  heap->sl_bitmaps[fl] |= 1u << sl;
+  ++heap->statistics.free_block_count;
+}
+
+static void iree_hal_suballocator_remove_free_block(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap,
+    iree_hal_suballocator_block_t* block) {
+  uint32_t fl = 0, sl = 0;
+  iree_hal_tlsf_mapping(iree_hal_suballocator_block_units(allocator, block),
+                        &fl, &sl);
+  if (block->prev_free) block->prev_free->next_free = block->next_free;
+  if (block->next_free) block->next_free->prev_free = block->prev_free;
+  if (heap->free_lists[fl][sl] == block) {
+    heap->free_lists[fl][sl] = block->next_free;
+    if (!block->next_free) {
+      heap->sl_bitmaps[fl] &= ~(1u << sl);
+      if (!heap->sl_bitmaps[fl]) heap->fl_bitmap &= ~(1u << fl);
+    }
+  }
+  block->is_free = false;
+  block->prev_free = block->next_free = NULL;
+  --heap->statistics.free_block_count;
+}
+
+// Returns a free block of at least |units| or NULL if none is available.
+static iree_hal_suballocator_block_t* iree_hal_suballocator_find_free_block(
+    iree_hal_suballocator_heap_t* heap, uint64_t units) {
+  uint32_t fl = 0, sl = 0;
+  iree_hal_tlsf_mapping_search(units, &fl, &sl);
+  if (fl >= IREE_HAL_TLSF_FL_COUNT) return NULL;
+  uint32_t sl_map = heap->sl_bitmaps[fl] & (~0u << sl);
+  if (!sl_map) {
+    // No block in this first-level range; take the smallest larger range.
+    const uint32_t fl_map =
+        fl + 1 < IREE_HAL_TLSF_FL_COUNT ? heap->fl_bitmap & (~0u << (fl + 1))
+                                        : 0;
+    if (!fl_map) return NULL;
+    fl = iree_math_count_trailing_zeros_u32(fl_map);
+    sl_map = heap->sl_bitmaps[fl];
+  }
+  sl = iree_math_count_trailing_zeros_u32(sl_map);
+  return heap->free_lists[fl][sl];
+}
+
+// Reserves a new slab of at least |min_size| bytes in |heap| and returns the
+// free block spanning it in |out_first_block|. Callers must use the returned
+// block instead of searching the free lists for it: the search rounds up to
+// the next bin while slabs that are not bin-aligned are filed in a lower one.
+static iree_status_t iree_hal_suballocator_allocate_slab(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap,
+    iree_device_size_t min_size,
+    iree_hal_suballocator_block_t** out_first_block) {
+  *out_first_block = NULL;
+  iree_device_size_t slab_size =
+      iree_device_align(iree_max(allocator->options.slab_size, min_size),
+                        allocator->options.alignment);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)slab_size);
+
+  iree_hal_suballocator_slab_t* slab = NULL;
+  iree_hal_suballocator_block_t* block = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      allocator->host_allocator, sizeof(*slab), (void**)&slab);
+  if (iree_status_is_ok(status)) {
+    memset(slab, 0, sizeof(*slab));
+    status = iree_hal_suballocator_acquire_block(allocator, &block);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_params_t params = {
+        .type = heap->memory_type,
+        .usage = heap->usage,
+        .access = heap->access,
+        .min_alignment = allocator->options.alignment,
+    };
+    status = iree_hal_allocator_allocate_buffer(
+        allocator->base_allocator, params, slab_size,
+        iree_const_byte_span_empty(), &slab->buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    slab->heap = heap;
+    slab->size = slab_size;
+    slab->first_block = block;
+    slab->next = heap->slab_head;
+    heap->slab_head = slab;
+    block->offset = 0;
+    block->size = slab_size;
+    block->slab = slab;
+    iree_hal_suballocator_insert_free_block(allocator, heap, block);
+    ++heap->statistics.slab_count;
+    heap->statistics.bytes_reserved += slab_size;
+    *out_first_block = block;
+  } else {
+    if (block) iree_hal_suballocator_recycle_block(allocator, block);
+    iree_allocator_free(allocator->host_allocator, slab);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Allocates a block of |size| bytes (already aligned) from |heap|, reserving a
+// new slab if no free block is large enough.
+static iree_status_t iree_hal_suballocator_allocate_block(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap,
+    iree_device_size_t size, iree_hal_suballocator_block_t** out_block) {
+  const uint64_t units = size >> allocator->alignment_log2;
+  iree_hal_suballocator_block_t* block =
+      iree_hal_suballocator_find_free_block(heap, units);
+  if (!block) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_suballocator_allocate_slab(allocator, heap, size, &block));
+  }
+  iree_hal_suballocator_remove_free_block(allocator, heap, block);
+
+  // Split off the remainder, if any, back into the free lists.
+  if (block->size > size) {
+    iree_hal_suballocator_block_t* remainder = NULL;
+    iree_status_t status =
+        iree_hal_suballocator_acquire_block(allocator, &remainder);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_suballocator_insert_free_block(allocator, heap, block);
+      return status;
+    }
+    remainder->offset = block->offset + size;
+    remainder->size = block->size - size;
+    remainder->slab = block->slab;
+    remainder->prev_physical = block;
+    remainder->next_physical = block->next_physical;
+    if (block->next_physical) block->next_physical->prev_physical = remainder;
+    block->next_physical = remainder;
+    block->size = size;
+    iree_hal_suballocator_insert_free_block(allocator, heap, remainder);
+  }
+
+  ++heap->statistics.allocation_count;
+  heap->statistics.bytes_allocated += block->size;
+  heap->statistics.bytes_peak =
+      iree_max(heap->statistics.bytes_peak, heap->statistics.bytes_allocated);
+  *out_block = block;
+  return iree_ok_status();
+}
+
+// Returns |block| to |heap|, coalescing it with free physical neighbors.
+static void iree_hal_suballocator_free_block(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap,
+    iree_hal_suballocator_block_t* block) {
+  --heap->statistics.allocation_count;
+  heap->statistics.bytes_allocated -= block->size;
+
+  iree_hal_suballocator_block_t* prev = block->prev_physical;
+  if (prev && prev->is_free) {
+    iree_hal_suballocator_remove_free_block(allocator, heap, prev);
+    prev->size += block->size;
+    prev->next_physical = block->next_physical;
+    if (block->next_physical) block->next_physical->prev_physical = prev;
+    iree_hal_suballocator_recycle_block(allocator, block);
+    block = prev;
+  }
+  iree_hal_suballocator_block_t* next = block->next_physical;
+  if (next && next->is_free) {
+    iree_hal_suballocator_remove_free_block(allocator, heap, next);
+    block->size += next->size;
+    block->next_physical = next->next_physical;
+    if (next->next_physical) next->next_physical->prev_physical = block;
+    iree_hal_suballocator_recycle_block(allocator, next);
+  }
+  iree_hal_suballocator_insert_free_block(allocator, heap, block);
+}
+
+// Returns the heap for the given parameters, creating it if needed.
+// Returns NULL if the parameters are new and the heap table is full.
+static iree_hal_suballocator_heap_t* iree_hal_suballocator_select_heap(
+    iree_hal_suballocator_t* allocator,
+    const iree_hal_buffer_params_t* params) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_suballocator_heap_t* heap = &allocator->heaps[i];
+    if (heap->memory_type == params->type && heap->usage == params->usage &&
+        heap->access == params->access) {
+      return heap;
+    }
+  }
+  if (allocator->heap_count >= IREE_ARRAYSIZE(allocator->heaps)) return NULL;
+  iree_hal_suballocator_heap_t* heap =
+      &allocator->heaps[allocator->heap_count++];
+  heap->memory_type = params->type;
+  heap->usage = params->usage;
+  heap->access = params->access;
+  heap->statistics.memory_type = params->type;
+  heap->statistics.usage = params->usage;
+  return heap;
+}
+
+// Returns true if |slab| has no live suballocations.
+static bool iree_hal_suballocator_slab_is_unused(
+    iree_hal_suballocator_slab_t* slab) {
+  return slab->first_block->is_free && slab->first_block->size == slab->size;
+}
+
+// Releases all unused slabs in |heap| back to the base allocator.
+static void iree_hal_suballocator_heap_trim(
+    iree_hal_suballocator_t* allocator, iree_hal_suballocator_heap_t* heap) {
+  iree_hal_suballocator_slab_t** slab_ptr = &heap->slab_head;
+  while (*slab_ptr) {
+    iree_hal_suballocator_slab_t* slab = *slab_ptr;
+    if (!iree_hal_suballocator_slab_is_unused(slab)) {
+      slab_ptr = &slab->next;
+      continue;
+    }
+    *slab_ptr = slab->next;
+    iree_hal_suballocator_remove_free_block(allocator, heap,
+                                            slab->first_block);
+    iree_hal_suballocator_recycle_block(allocator, slab->first_block);
+    --heap->statistics.slab_count;
+    heap->statistics.bytes_reserved -= slab->size;
+    iree_hal_buffer_release(slab->buffer);
+    iree_allocator_free(allocator->host_allocator, slab);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_allocator_t implementation
+//===----------------------------------------------------------------------===//
+
+static void iree_hal_suballocator_destroy(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Suballocated buffers retain the suballocator so all slabs must be unused.
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_suballocator_heap_trim(allocator, &allocator->heaps[i]);
+    IREE_ASSERT(!allocator->heaps[i].slab_head);
+  }
+  while (allocator->block_pool) {
+    iree_hal_suballocator_block_t* block = allocator->block_pool;
+    allocator->block_pool = block->next_free;
+    iree_allocator_free(host_allocator, block);
+  }
+
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  iree_hal_allocator_release(allocator->base_allocator);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_suballocator_host_allocator(
+    const iree_hal_allocator_t* IREE_RESTRICT base_allocator) {
+  iree_hal_suballocator_t* allocator = (iree_hal_suballocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_suballocator_trim(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_suballocator_heap_trim(allocator, &allocator->heaps[i]);
+  }
+  while (allocator->block_pool) {
+    iree_hal_suballocator_block_t* block = allocator->block_pool;
+    allocator->block_pool = block->next_free;
+    iree_allocator_free(allocator->host_allocator, block);
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  iree_status_t status = iree_hal_allocator_trim(allocator->base_allocator);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_suballocator_query_statistics(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    iree_hal_allocator_statistics_t* IREE_RESTRICT out_statistics) {
+  // Physical allocations (slabs and pass-through buffers) are tracked by the
+  // base allocator; per-heap suballocation statistics are queried separately.
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  iree_hal_allocator_query_statistics(allocator->base_allocator,
+                                      out_statistics);
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_suballocator_query_compatibility(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    const iree_hal_buffer_params_t* IREE_RESTRICT params,
+    iree_device_size_t allocation_size) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  return iree_hal_allocator_query_compatibility(allocator->base_allocator,
+                                                *params, allocation_size);
+}
+
+static iree_status_t iree_hal_suballocator_allocate_buffer(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    const iree_hal_buffer_params_t* IREE_RESTRICT params,
+    iree_device_size_t allocation_size, iree_const_byte_span_t initial_data,
+    iree_hal_buffer_t** IREE_RESTRICT out_buffer) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+
+  // Large allocations, those requiring stricter alignment than slabs provide,
+  // and initial data we would have no way to upload go to the base allocator.
+  const bool can_upload =
+      iree_const_byte_span_is_empty(initial_data) ||
+      (iree_all_bits_set(params->type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+       iree_all_bits_set(params->usage, IREE_HAL_BUFFER_USAGE_MAPPING));
+  if (allocation_size > allocator->options.max_suballocation_size ||
+      params->min_alignment > allocator->options.alignment || !can_upload) {
+    return iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                              *params, allocation_size,
+                                              initial_data, out_buffer);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)allocation_size);
+
+  const iree_device_size_t block_size =
+      iree_device_align(iree_max(allocation_size, 1),
+                        allocator->options.alignment);
+
+  iree_hal_suballocator_buffer_t* buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator->host_allocator, sizeof(*buffer),
+                                (void**)&buffer));
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_suballocator_heap_t* heap =
+      iree_hal_suballocator_select_heap(allocator, params);
+  iree_hal_suballocator_block_t* block = NULL;
+  iree_status_t status = iree_ok_status();
+  if (heap) {
+    status = iree_hal_suballocator_allocate_block(allocator, heap, block_size,
+                                                  &block);
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  if (iree_status_is_ok(status) && !block) {
+    // Too many distinct buffer parameters; don't suballocate this one.
+    iree_allocator_free(allocator->host_allocator, buffer);
+    status = iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                                *params, allocation_size,
+                                                initial_data, out_buffer);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  if (iree_status_is_ok(status)) {
+    // The buffer holds a reference to the slab (as a subspan) and to the
+    // suballocator so that the block can be returned when it is recycled.
+    iree_hal_subspan_buffer_initialize(block->slab->buffer, block->offset,
+                                       allocation_size, base_allocator,
+                                       allocator->host_allocator, &buffer->base);
+    buffer->block = block;
+    iree_hal_allocator_retain(base_allocator);
+    if (!iree_const_byte_span_is_empty(initial_data)) {
+      status = iree_hal_buffer_map_write(&buffer->base, 0, initial_data.data,
+                                         initial_data.data_length);
+    }
+    if (iree_status_is_ok(status)) {
+      *out_buffer = &buffer->base;
+    } else {
+      iree_hal_buffer_release(&buffer->base);
+    }
+  } else {
+    iree_allocator_free(allocator->host_allocator, buffer);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_suballocator_deallocate_buffer(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    iree_hal_buffer_t* IREE_RESTRICT base_buffer) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  iree_hal_suballocator_buffer_t* buffer =
+      (iree_hal_suballocator_buffer_t*)base_buffer;
+  iree_hal_suballocator_block_t* block = buffer->block;
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_suballocator_free_block(allocator, block->slab->heap, block);
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  // Drops the slab reference and frees the buffer wrapper (the subspan buffer
+  // is the first member so it frees the entire struct).
+  iree_hal_buffer_destroy(base_buffer);
+
+  // May destroy the suballocator if this was the last outstanding reference.
+  iree_hal_allocator_release(base_allocator);
+}
+
+static iree_status_t iree_hal_suballocator_import_buffer(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    const iree_hal_buffer_params_t* IREE_RESTRICT params,
+    iree_hal_external_buffer_t* IREE_RESTRICT external_buffer,
+    iree_hal_buffer_release_callback_t release_callback,
+    iree_hal_buffer_t** IREE_RESTRICT out_buffer) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  return iree_hal_allocator_import_buffer(allocator->base_allocator, *params,
+                                          external_buffer, release_callback,
+                                          out_buffer);
+}
+
+static iree_status_t iree_hal_suballocator_export_buffer(
+    iree_hal_allocator_t* IREE_RESTRICT base_allocator,
+    iree_hal_buffer_t* IREE_RESTRICT buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* IREE_RESTRICT out_external_buffer) {
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+  if (iree_hal_buffer_allocated_buffer(buffer) != buffer &&
+      buffer->device_allocator == base_allocator) {
+    // Exporting a suballocation would expose the entire slab.
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "suballocated buffers cannot be exported; "
+                            "allocate the buffer with a size larger than the "
+                            "maximum suballocation size");
+  }
+  return iree_hal_allocator_export_buffer(allocator->base_allocator, buffer,
+                                          requested_type, requested_flags,
+                                          out_external_buffer);
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_suballocator_vtable = {
+    .destroy = iree_hal_suballocator_destroy,
+    .host_allocator = iree_hal_suballocator_host_allocator,
+    .trim = iree_hal_suballocator_trim,
+    .query_statistics = iree_hal_suballocator_query_statistics,
+    .query_compatibility = iree_hal_suballocator_query_compatibility,
+    .allocate_buffer = iree_hal_suballocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_suballocator_deallocate_buffer,
+    .import_buffer = iree_hal_suballocator_import_buffer,
+    .export_buffer = iree_hal_suballocator_export_buffer,
+};
+
+//===----------------------------------------------------------------------===//
+// Statistics
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_query_heap_statistics(
+    iree_hal_allocator_t* base_allocator, iree_host_size_t heap_capacity,
+    iree_hal_suballocator_heap_statistics_t* out_heap_statistics,
+    iree_host_size_t* out_heap_count) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(!heap_capacity || out_heap_statistics);
+  IREE_ASSERT_ARGUMENT(out_heap_count);
+  *out_heap_count = 0;
+  if (!iree_hal_suballocator_isa(base_allocator)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a suballocator");
+  }
+  iree_hal_suballocator_t* allocator =
+      iree_hal_suballocator_cast(base_allocator);
+
+  iree_slim_mutex_lock(&allocator->mutex);
+  for (iree_host_size_t i = 0;
+       i < allocator->heap_count && i < heap_capacity; ++i) {
+    iree_hal_suballocator_heap_t* heap = &allocator->heaps[i];
+    out_heap_statistics[i] = heap->statistics;
+    // The largest free block is in the highest non-empty bin; blocks within a
+    // bin are unordered so scan it.
+    iree_device_size_t largest_free_block = 0;
+    if (heap->fl_bitmap) {
+      const uint32_t fl =
+          31 - iree_math_count_leading_zeros_u32(heap->fl_bitmap);
+      const uint32_t sl =
+          31 - iree_math_count_leading_zeros_u32(heap->sl_bitmaps[fl]);
+      for (iree_hal_suballocator_block_t* block = heap->free_lists[fl][sl];
+           block; block = block->next_free) {
+        largest_free_block = iree_max(largest_free_block, block->size);
+      }
+    }
+    out_heap_statistics[i].largest_free_block = largest_free_block;
+  }
+  *out_heap_count = allocator->heap_count;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_statistics_format(
+    iree_hal_allocator_t* allocator, iree_string_builder_t* builder) {
+  iree_hal_suballocator_heap_statistics_t
+      heap_statistics[IREE_HAL_SUBALLOCATOR_MAX_HEAP_COUNT];
+  iree_host_size_t heap_count = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_suballocator_query_heap_statistics(
+      allocator, IREE_ARRAYSIZE(heap_statistics), heap_statistics,
+      &heap_count));
+
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(
+      builder, "[[ iree_hal_suballocator_t statistics ]]\n"));
+  for (iree_host_size_t i = 0; i < heap_count; ++i) {
+    const iree_hal_suballocator_heap_statistics_t* stats = &heap_statistics[i];
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "HEAP %" PRIhsz " (type=0x%08X usage=0x%08X):\n"
+        "  SLABS: %12" PRIhsz " (%" PRIu64 "B reserved)\n"
+        "  ALLOC: %12" PRIhsz " (%" PRIu64 "B live, %" PRIu64 "B peak)\n"
+        "  FREE:  %12" PRIhsz " (%" PRIu64 "B largest)\n",
+        i, (uint32_t)stats->memory_type, (uint32_t)stats->usage,
+        stats->slab_count, (uint64_t)stats->bytes_reserved,
+        stats->allocation_count, (uint64_t)stats->bytes_allocated,
+        (uint64_t)stats->bytes_peak, stats->free_block_count,
+        (uint64_t)stats->largest_free_block));
+  }
+  return iree_ok_status();
+}
@@ -0,0 +1,109 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_SUBALLOCATOR_H_
+#define IREE_HAL_UTILS_SUBALLOCATOR_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_suballocator_t
+//===----------------------------------------------------------------------===//
+
+// Maximum number of distinct heaps (unique memory type and usage pairs) that a
+// suballocator will manage. Allocations with parameters beyond the first N
+// seen pass through to the underlying allocator.
+#define IREE_HAL_SUBALLOCATOR_MAX_HEAP_COUNT 8
+
+// Default size of each slab reserved from the underlying allocator.
+#define IREE_HAL_SUBALLOCATOR_DEFAULT_SLAB_SIZE (64 * 1024 * 1024)
+
+// Default alignment of suballocations. Matches the most restrictive storage
+// buffer offset alignment of common devices such that suballocated buffers are
+// always bindable.
+#define IREE_HAL_SUBALLOCATOR_DEFAULT_ALIGNMENT 256
+
+// Parameters controlling suballocator behavior.
+typedef struct iree_hal_suballocator_options_t {
+  // Minimum size, in bytes, of each slab reserved from the underlying
+  // allocator. Larger suballocations reserve a dedicated slab of their size.
+  iree_device_size_t slab_size;
+
+  // Allocations larger than this bypass suballocation and are allocated
+  // directly from the underlying allocator.
+  iree_device_size_t max_suballocation_size;
+
+  // Power-of-two alignment of all suballocation offsets and sizes.
+  // Also defines the smallest size class.
+  iree_device_size_t alignment;
+} iree_hal_suballocator_options_t;
+
+// Initializes |out_options| to their default values.
+IREE_API_EXPORT void iree_hal_suballocator_options_initialize(
+    iree_hal_suballocator_options_t* out_options);
+
+// Statistics for a single heap of slabs sharing the same buffer parameters.
+typedef struct iree_hal_suballocator_heap_statistics_t {
+  // Memory type and usage of all buffers in the heap.
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t usage;
+  // Total number of slabs currently reserved and their total size.
+  iree_host_size_t slab_count;
+  iree_device_size_t bytes_reserved;
+  // Number of live suballocations and the bytes they cover (including
+  // alignment padding).
+  iree_host_size_t allocation_count;
+  iree_device_size_t bytes_allocated;
+  // High water mark of |bytes_allocated|.
+  iree_device_size_t bytes_peak;
+  // Number of free blocks and the largest contiguous free range. A large free
+  // block count relative to the allocation count indicates fragmentation.
+  iree_host_size_t free_block_count;
+  iree_device_size_t largest_free_block;
+} iree_hal_suballocator_heap_statistics_t;
+
+// Creates an allocator that suballocates buffers from large slabs reserved from
+// |base_allocator|. Free ranges within each slab are tracked out-of-band (no
+// slab memory is touched by the suballocator) with a two-level segregated fit
+// (TLSF) policy giving O(1) allocation and deallocation with bounded
+// fragmentation. Slabs are kept once reserved and only released back to
+// |base_allocator| by iree_hal_allocator_trim when entirely unused.
+//
+// Suballocated buffers are subspans of the native slab buffers and can be used
+// with any device that |base_allocator| services. Import, export, and any
+// allocation larger than the configured maximum suballocation size are
+// forwarded to |base_allocator| unmodified.
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_suballocator_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+// Returns true if |allocator| is a suballocator.
+IREE_API_EXPORT bool iree_hal_suballocator_isa(iree_hal_allocator_t* allocator);
+
+// Queries the statistics of each heap in the suballocator.
+// |out_heap_count| is set to the total number of heaps even if
+// |heap_capacity| is smaller.
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_query_heap_statistics(
+    iree_hal_allocator_t* allocator, iree_host_size_t heap_capacity,
+    iree_hal_suballocator_heap_statistics_t* out_heap_statistics,
+    iree_host_size_t* out_heap_count);
+
+// Formats the per-heap statistics of |allocator| as a pretty-printed
+// multi-line string.
+IREE_API_EXPORT iree_status_t iree_hal_suballocator_statistics_format(
+    iree_hal_allocator_t* allocator, iree_string_builder_t* builder);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_SUBALLOCATOR_H_
@@ -0,0 +1,339 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/suballocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static constexpr iree_device_size_t kSlabSize = 64 * 1024;
+
+struct SuballocatorTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* heap_allocator = NULL;
+  iree_hal_allocator_t* allocator = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("heap"), host_allocator, host_allocator, &heap_allocator));
+    iree_hal_suballocator_options_t options;
+    iree_hal_suballocator_options_initialize(&options);
+    options.slab_size = kSlabSize;
+    options.max_suballocation_size = kSlabSize;
+    IREE_ASSERT_OK(iree_hal_suballocator_create(heap_allocator, &options,
+                                                host_allocator, &allocator));
+  }
+
+  void TearDown() override {
+    iree_hal_allocator_release(allocator);
+    iree_hal_allocator_release(heap_allocator);
+  }
+
+  iree_hal_buffer_params_t MakeParams() {
+    iree_hal_buffer_params_t params = {0};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER |
+                   IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE |
+                   IREE_HAL_BUFFER_USAGE_MAPPING;
+    return params;
+  }
+
+  iree_hal_suballocator_heap_statistics_t QueryHeap(iree_host_size_t index) {
+    iree_hal_suballocator_heap_statistics_t
+        stats[IREE_HAL_SUBALLOCATOR_MAX_HEAP_COUNT];
+    iree_host_size_t heap_count = 0;
+    IREE_CHECK_OK(iree_hal_suballocator_query_heap_statistics(
+        allocator, IREE_ARRAYSIZE(stats), stats, &heap_count));
+    EXPECT_LT(index, heap_count);
+    return stats[index];
+  }
+};
+
+TEST_F(SuballocatorTest, IsA) {
+  EXPECT_TRUE(iree_hal_suballocator_isa(allocator));
+  EXPECT_FALSE(iree_hal_suballocator_isa(heap_allocator));
+}
+
+TEST_F(SuballocatorTest, InvalidOptions) {
+  iree_hal_suballocator_options_t options;
+  iree_hal_suballocator_options_initialize(&options);
+  options.alignment = 24;
+  iree_hal_allocator_t* invalid_allocator = NULL;
+  EXPECT_THAT(Status(iree_hal_suballocator_create(heap_allocator, &options,
+                                                  host_allocator,
+                                                  &invalid_allocator)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+// Buffers share one slab, are aligned, and do not overlap.
+TEST_F(SuballocatorTest, SuballocatesFromSlab) {
+  std::vector<iree_hal_buffer_t*> buffers;
+  for (int i = 0; i < 16; ++i) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        allocator, MakeParams(), 100 + i, iree_const_byte_span_empty(),
+        &buffer));
+    EXPECT_EQ(iree_hal_buffer_byte_length(buffer), 100 + i);
+    EXPECT_EQ(iree_hal_buffer_byte_offset(buffer) %
+                  IREE_HAL_SUBALLOCATOR_DEFAULT_ALIGNMENT,
+              0);
+    if (!buffers.empty()) {
+      EXPECT_EQ(iree_hal_buffer_allocated_buffer(buffer),
+                iree_hal_buffer_allocated_buffer(buffers.front()));
+    }
+    for (iree_hal_buffer_t* other : buffers) {
+      EXPECT_EQ(iree_hal_buffer_test_overlap(buffer, 0, IREE_WHOLE_BUFFER,
+                                             other, 0, IREE_WHOLE_BUFFER),
+                IREE_HAL_BUFFER_OVERLAP_DISJOINT);
+    }
+    buffers.push_back(buffer);
+  }
+
+  auto stats = QueryHeap(0);
+  EXPECT_EQ(stats.slab_count, 1);
+  EXPECT_EQ(stats.bytes_reserved, kSlabSize);
+  EXPECT_EQ(stats.allocation_count, 16);
+  EXPECT_EQ(stats.bytes_allocated, 16 * 256);
+
+  for (iree_hal_buffer_t* buffer : buffers) iree_hal_buffer_release(buffer);
+
+  // All blocks coalesce back into a single free block spanning the slab.
+  stats = QueryHeap(0);
+  EXPECT_EQ(stats.allocation_count, 0);
+  EXPECT_EQ(stats.bytes_allocated, 0);
+  EXPECT_EQ(stats.bytes_peak, 16 * 256);
+  EXPECT_EQ(stats.free_block_count, 1);
+  EXPECT_EQ(stats.largest_free_block, kSlabSize);
+}
+
+// Freed ranges are reused and neighbors coalesce regardless of free order.
+TEST_F(SuballocatorTest, ReuseAndCoalesce) {
+  iree_hal_buffer_t* a = NULL;
+  iree_hal_buffer_t* b = NULL;
+  iree_hal_buffer_t* c = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 1024, iree_const_byte_span_empty(), &a));
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 1024, iree_const_byte_span_empty(), &b));
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 1024, iree_const_byte_span_empty(), &c));
+  iree_device_size_t a_offset = iree_hal_buffer_byte_offset(a);
+  iree_device_size_t b_offset = iree_hal_buffer_byte_offset(b);
+
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+  EXPECT_EQ(QueryHeap(0).free_block_count, 2);
+
+  // a+b coalesced into a range able to hold 2048 bytes.
+  iree_hal_buffer_t* d = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 2048, iree_const_byte_span_empty(), &d));
+  EXPECT_EQ(iree_hal_buffer_byte_offset(d), iree_min(a_offset, b_offset));
+
+  iree_hal_buffer_release(c);
+  iree_hal_buffer_release(d);
+  auto stats = QueryHeap(0);
+  EXPECT_EQ(stats.free_block_count, 1);
+  EXPECT_EQ(stats.largest_free_block, kSlabSize);
+}
+
+// Allocations are isolated per memory type/usage.
+TEST_F(SuballocatorTest, SeparateHeaps) {
+  iree_hal_buffer_params_t params_a = MakeParams();
+  iree_hal_buffer_params_t params_b = MakeParams();
+  params_b.usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
+  iree_hal_buffer_t* a = NULL;
+  iree_hal_buffer_t* b = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, params_a, 128, iree_const_byte_span_empty(), &a));
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, params_b, 128, iree_const_byte_span_empty(), &b));
+  EXPECT_NE(iree_hal_buffer_allocated_buffer(a),
+            iree_hal_buffer_allocated_buffer(b));
+  iree_hal_suballocator_heap_statistics_t
+      stats[IREE_HAL_SUBALLOCATOR_MAX_HEAP_COUNT];
+  iree_host_size_t heap_count = 0;
+  IREE_ASSERT_OK(iree_hal_suballocator_query_heap_statistics(
+      allocator, IREE_ARRAYSIZE(stats), stats, &heap_count));
+  EXPECT_EQ(heap_count, 2);
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+}
+
+// Allocations larger than the maximum suballocation size pass through.
+TEST_F(SuballocatorTest, LargeAllocationPassthrough) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), kSlabSize * 2, iree_const_byte_span_empty(),
+      &buffer));
+  EXPECT_EQ(iree_hal_buffer_allocated_buffer(buffer), buffer);
+  iree_host_size_t heap_count = 0;
+  IREE_ASSERT_OK(iree_hal_suballocator_query_heap_statistics(
+      allocator, 0, NULL, &heap_count));
+  EXPECT_EQ(heap_count, 0);
+  iree_hal_buffer_release(buffer);
+}
+
+// Creates a suballocator over the heap allocator with the given sizes.
+static iree_hal_allocator_t* CreateSuballocator(
+    iree_hal_allocator_t* heap_allocator, iree_device_size_t slab_size,
+    iree_device_size_t max_suballocation_size) {
+  iree_hal_suballocator_options_t options;
+  iree_hal_suballocator_options_initialize(&options);
+  options.slab_size = slab_size;
+  options.max_suballocation_size = max_suballocation_size;
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_suballocator_create(
+      heap_allocator, &options, iree_allocator_system(), &allocator));
+  return allocator;
+}
+
+// A slab size that is neither a power of two nor a free list bin boundary can
+// still be filled by a single allocation of the full slab size.
+TEST_F(SuballocatorTest, NonPowerOfTwoSlabSize) {
+  constexpr iree_device_size_t kOddSlabSize = 250000;
+  iree_hal_allocator_t* odd_allocator =
+      CreateSuballocator(heap_allocator, kOddSlabSize, kOddSlabSize);
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      odd_allocator, MakeParams(), kOddSlabSize, iree_const_byte_span_empty(),
+      &buffer));
+  EXPECT_EQ(iree_hal_buffer_byte_length(buffer), kOddSlabSize);
+  EXPECT_NE(iree_hal_buffer_allocated_buffer(buffer), buffer);
+  iree_hal_buffer_release(buffer);
+  iree_hal_allocator_release(odd_allocator);
+}
+
+// Suballocations larger than the slab size get a slab sized exactly for them.
+TEST_F(SuballocatorTest, OversizedSuballocation) {
+  constexpr iree_device_size_t kOversizedSize = 200000;
+  iree_hal_allocator_t* large_allocator =
+      CreateSuballocator(heap_allocator, kSlabSize, 4 * kSlabSize);
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      large_allocator, MakeParams(), kOversizedSize,
+      iree_const_byte_span_empty(), &buffer));
+  EXPECT_EQ(iree_hal_buffer_byte_length(buffer), kOversizedSize);
+  EXPECT_NE(iree_hal_buffer_allocated_buffer(buffer), buffer);
+  iree_hal_buffer_release(buffer);
+  iree_hal_allocator_release(large_allocator);
+}
+
+// Slabs grow on demand and are released by trim only when unused.
+TEST_F(SuballocatorTest, GrowAndTrim) {
+  iree_hal_buffer_t* a = NULL;
+  iree_hal_buffer_t* b = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), kSlabSize, iree_const_byte_span_empty(), &a));
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), kSlabSize / 2, iree_const_byte_span_empty(),
+      &b));
+  EXPECT_EQ(QueryHeap(0).slab_count, 2);
+
+  iree_hal_buffer_release(a);
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator));
+  auto stats = QueryHeap(0);
+  EXPECT_EQ(stats.slab_count, 1);
+  EXPECT_EQ(stats.bytes_reserved, kSlabSize);
+
+  iree_hal_buffer_release(b);
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator));
+  EXPECT_EQ(QueryHeap(0).slab_count, 0);
+}
+
+TEST_F(SuballocatorTest, InitialDataAndMapping) {
+  uint8_t initial_data[300];
+  for (size_t i = 0; i < sizeof(initial_data); ++i) initial_data[i] = (uint8_t)i;
+  iree_hal_buffer_t* spacer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 16, iree_const_byte_span_empty(), &spacer));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), sizeof(initial_data),
+      iree_make_const_byte_span(initial_data, sizeof(initial_data)), &buffer));
+  EXPECT_NE(iree_hal_buffer_byte_offset(buffer), 0);
+
+  uint8_t readback[sizeof(initial_data)] = {0};
+  IREE_ASSERT_OK(
+      iree_hal_buffer_map_read(buffer, 0, readback, sizeof(readback)));
+  EXPECT_EQ(memcmp(initial_data, readback, sizeof(initial_data)), 0);
+
+  iree_hal_buffer_release(buffer);
+  iree_hal_buffer_release(spacer);
+}
+
+// Subspans keep the suballocation alive after the original is released.
+TEST_F(SuballocatorTest, SubspanRetainsSuballocation) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), 1024, iree_const_byte_span_empty(), &buffer));
+  iree_hal_buffer_t* subspan = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_subspan(buffer, 256, 256, &subspan));
+  EXPECT_EQ(iree_hal_buffer_allocated_buffer(subspan),
+            iree_hal_buffer_allocated_buffer(buffer));
+  EXPECT_EQ(iree_hal_buffer_byte_offset(subspan),
+            iree_hal_buffer_byte_offset(buffer) + 256);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(QueryHeap(0).allocation_count, 1);
+  iree_hal_buffer_release(subspan);
+  EXPECT_EQ(QueryHeap(0).allocation_count, 0);
+}
+
+// Subspans of subspans keep the suballocation alive after both the original
+// and the outer subspan are released.
+TEST_F(SuballocatorTest, NestedSubspanRetainsSuballocation) {
+  uint8_t initial_data[1024];
+  for (size_t i = 0; i < sizeof(initial_data); ++i) {
+    initial_data[i] = (uint8_t)i;
+  }
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), sizeof(initial_data),
+      iree_make_const_byte_span(initial_data, sizeof(initial_data)), &buffer));
+  iree_hal_buffer_t* outer = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_subspan(buffer, 256, 512, &outer));
+  iree_hal_buffer_t* inner = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_subspan(outer, 128, 128, &inner));
+  EXPECT_EQ(iree_hal_buffer_byte_offset(inner),
+            iree_hal_buffer_byte_offset(buffer) + 256 + 128);
+  iree_hal_buffer_release(buffer);
+  iree_hal_buffer_release(outer);
+  EXPECT_EQ(QueryHeap(0).allocation_count, 1);
+
+  // Allocating again must not reuse the range still referenced by |inner|.
+  iree_hal_buffer_t* other = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, MakeParams(), sizeof(initial_data),
+      iree_const_byte_span_empty(), &other));
+  EXPECT_EQ(iree_hal_buffer_test_overlap(inner, 0, IREE_WHOLE_BUFFER, other, 0,
+                                         IREE_WHOLE_BUFFER),
+            IREE_HAL_BUFFER_OVERLAP_DISJOINT);
+  uint8_t readback[128] = {0};
+  IREE_ASSERT_OK(
+      iree_hal_buffer_map_read(inner, 0, readback, sizeof(readback)));
+  EXPECT_EQ(memcmp(initial_data + 256 + 128, readback, sizeof(readback)), 0);
+
+  iree_hal_buffer_release(other);
+  iree_hal_buffer_release(inner);
+  EXPECT_EQ(QueryHeap(0).allocation_count, 0);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -69,6 +69,8 @@ EXPORT_FN("device.queue.dealloca", iree_hal_module_device_queue_dealloca, rIrrr,
 EXPORT_FN("device.queue.execute", iree_hal_module_device_queue_execute, rIrrCrD, v)
 EXPORT_FN("device.queue.flush", iree_hal_module_device_queue_flush, rI, v)
 
+EXPORT_FN("ex.result_cache.insert", iree_hal_module_ex_result_cache_insert, rr, v)
+EXPORT_FN("ex.result_cache.lookup", iree_hal_module_ex_result_cache_lookup, rCrD, rr)
 EXPORT_FN("ex.shared_device", iree_hal_module_ex_shared_device, v, r)
 
 EXPORT_FN("executable.create", iree_hal_module_executable_create, rrrrCrD, r)
@@ -15,6 +15,7 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/utils/buffer_diagnostics.h"
+#include "iree/modules/hal/utils/result_cache.h"
 #include "iree/vm/api.h"
 
 #define IREE_HAL_MODULE_VERSION_0_0 0x00000000u
@@ -32,6 +33,14 @@
 // provided.
 #define IREE_HAL_MODULE_MAX_COMMAND_BUFFER_BINDING_COUNT ((iree_host_size_t)256)
 
+// Default capacity in bytes of the result cache used by memoized functions.
+// Hosting applications can change the capacity at runtime with
+// iree_hal_module_set_result_cache_capacity.
+#if !defined(IREE_HAL_MODULE_RESULT_CACHE_DEFAULT_CAPACITY)
+#define IREE_HAL_MODULE_RESULT_CACHE_DEFAULT_CAPACITY \
+  ((iree_device_size_t)64 * 1024 * 1024)
+#endif  // !IREE_HAL_MODULE_RESULT_CACHE_DEFAULT_CAPACITY
+
 //===----------------------------------------------------------------------===//
 // Module type definitions
 //===----------------------------------------------------------------------===//
@@ -40,6 +49,8 @@ typedef struct iree_hal_module_t {
   iree_allocator_t host_allocator;
   iree_hal_module_flags_t flags;
   iree_hal_device_t* shared_device;
+  // Results of memoized functions shared across all contexts.
+  iree_hal_result_cache_t* result_cache;
   // TODO(benvanik): types.
 } iree_hal_module_t;
 
@@ -69,10 +80,14 @@ typedef struct iree_hal_module_state_t {
   // executables like ones for training vs inference in the same model, or just
   // always use this.
   iree_hal_executable_cache_t* executable_cache;
+
+  // Result cache shared with the module and all other contexts.
+  iree_hal_result_cache_t* result_cache;
 } iree_hal_module_state_t;
 
 static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  iree_hal_result_cache_destroy(module->result_cache);
   iree_hal_device_release(module->shared_device);
 }
 
@@ -91,6 +106,7 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
   state->flags = module->flags;
   state->shared_device = module->shared_device;
   iree_hal_device_retain(state->shared_device);
+  state->result_cache = module->result_cache;
 
   state->loop_status = iree_ok_status();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -122,6 +138,7 @@ static iree_status_t IREE_API_PTR iree_hal_module_notify(
   switch (signal) {
     case IREE_VM_SIGNAL_SUSPEND:
     case IREE_VM_SIGNAL_LOW_MEMORY:
+      iree_hal_result_cache_trim(state->result_cache);
       return iree_hal_device_trim(state->shared_device);
     default:
       return iree_ok_status();
@@ -134,6 +151,61 @@ static iree_status_t IREE_API_PTR iree_hal_module_notify(
 // NOTE: Ex* APIs are experimental and likely to be removed soon. Modules
 // using these APIs are not forward compatible.
 
+// Dereferences the |buffer_view_refs| into |out_buffer_views|.
+static iree_status_t iree_hal_module_deref_buffer_views(
+    iree_vm_size_t buffer_view_count, const iree_vm_abi_r_t* buffer_view_refs,
+    iree_hal_buffer_view_t** out_buffer_views) {
+  for (iree_vm_size_t i = 0; i < buffer_view_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_check_deref(
+        buffer_view_refs[i].r0, &out_buffer_views[i]));
+  }
+  return iree_ok_status();
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_result_cache_insert,  //
+                   iree_hal_module_state_t,                 //
+                   rr, v) {
+  // The key token is null if the lookup found the operands uncacheable.
+  iree_vm_buffer_t* key_token = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_buffer_check_deref_or_null(args->r0, &key_token));
+  iree_vm_list_t* results = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_deref(args->r1, &results));
+  return iree_hal_result_cache_insert(state->result_cache, key_token, results);
+}
+
+IREE_VM_ABI_EXPORT(iree_hal_module_ex_result_cache_lookup,  //
+                   iree_hal_module_state_t,                 //
+                   rCrD, rr) {
+  iree_vm_buffer_t* key = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r0, &key));
+  iree_hal_buffer_view_t** operands = (iree_hal_buffer_view_t**)iree_alloca(
+      args->a1_count * sizeof(iree_hal_buffer_view_t*));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_deref_buffer_views(args->a1_count, args->a1, operands));
+
+  // Misses return an empty list that the caller populates with the results
+  // and passes back to hal.ex.result_cache.insert along with the key token so
+  // that the operands need not be read again.
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_ref_type(iree_hal_buffer_view_type_id());
+  iree_vm_list_t* results = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(&element_type, /*capacity=*/0,
+                                           state->host_allocator, &results));
+  bool hit = false;
+  iree_vm_buffer_t* key_token = NULL;
+  iree_status_t status = iree_hal_result_cache_lookup(
+      state->result_cache, iree_vm_buffer_as_string(key), args->a1_count,
+      operands, results, &hit, &key_token);
+  if (iree_status_is_ok(status)) {
+    rets->r0 = iree_vm_list_move_ref(results);
+    rets->r1 = iree_vm_buffer_move_ref(key_token);
+  } else {
+    iree_vm_list_release(results);
+  }
+  return status;
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_ex_shared_device,  //
                    iree_hal_module_state_t,           //
                    v, r) {
@@ -1468,6 +1540,14 @@ IREE_API_EXPORT iree_status_t iree_hal_module_create(
   module->shared_device = device;
   iree_hal_device_retain(module->shared_device);
 
+  status = iree_hal_result_cache_create(
+      IREE_HAL_MODULE_RESULT_CACHE_DEFAULT_CAPACITY, host_allocator,
+      &module->result_cache);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_module_release(base_module);
+    return status;
+  }
+
   *out_module = base_module;
   return iree_ok_status();
 }
@@ -1477,3 +1557,19 @@ IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
   return state->shared_device;
 }
+
+IREE_API_EXPORT void iree_hal_module_set_result_cache_capacity(
+    iree_vm_module_t* base_module, iree_device_size_t capacity) {
+  IREE_ASSERT_ARGUMENT(base_module);
+  iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  iree_hal_result_cache_set_capacity(module->result_cache, capacity);
+}
+
+IREE_API_EXPORT void iree_hal_module_query_result_cache_statistics(
+    iree_vm_module_t* base_module,
+    iree_hal_result_cache_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_module);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  iree_hal_result_cache_query_statistics(module->result_cache, out_statistics);
+}
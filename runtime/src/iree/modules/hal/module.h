@@ -12,6 +12,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/types.h"
+#include "iree/modules/hal/utils/result_cache.h"
 #include "iree/vm/api.h"
 
 #ifdef __cplusplus
@@ -39,6 +40,17 @@ IREE_API_EXPORT iree_status_t iree_hal_module_create(
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state);
 
+// Sets the capacity in bytes of the result cache used by functions compiled
+// with `iree.abi.memoize`. The cache is shared by all contexts using |module|.
+// A |capacity| of 0 disables memoization and releases all cached results.
+IREE_API_EXPORT void iree_hal_module_set_result_cache_capacity(
+    iree_vm_module_t* module, iree_device_size_t capacity);
+
+// Queries the hit rate and residency statistics of the result cache.
+IREE_API_EXPORT void iree_hal_module_query_result_cache_statistics(
+    iree_vm_module_t* module,
+    iree_hal_result_cache_statistics_t* out_statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
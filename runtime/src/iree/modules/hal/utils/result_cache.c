@@ -0,0 +1,609 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/hal/utils/result_cache.h"
+
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/types.h"
+
+// Initial number of hash buckets. Grows by doubling as entries are added.
+#define IREE_HAL_RESULT_CACHE_INITIAL_BUCKET_COUNT ((iree_host_size_t)64)
+
+//===----------------------------------------------------------------------===//
+// Keys
+//===----------------------------------------------------------------------===//
+// Keys are a flat serialization of the function key and each argument's type,
+// shape, and contents. Entries store the full key so that hash collisions can
+// never return results for different arguments.
+//
+// Keys built on a lookup miss are returned to the caller as a token holding
+// the hash followed by the serialized key so that inserting the results does
+// not need to read and hash the arguments again. The token also records the
+// identity of each argument's allocated buffer so that results aliasing an
+// argument can be detected on insertion. The identities are only compared and
+// never dereferenced.
+
+// Header preceding the argument identities and serialized key in a key token.
+typedef struct iree_hal_result_cache_token_header_t {
+  uint64_t hash;
+  uint64_t arg_count;
+} iree_hal_result_cache_token_header_t;
+
+// Header preceding each serialized argument.
+typedef struct iree_hal_result_cache_arg_header_t {
+  uint32_t element_type;
+  uint32_t encoding_type;
+  uint64_t rank;
+  uint64_t byte_length;
+} iree_hal_result_cache_arg_header_t;
+
+// Returns true if the contents of |buffer_view| can be read from the host.
+static bool iree_hal_result_cache_is_mappable(
+    iree_hal_buffer_view_t* buffer_view) {
+  iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(buffer_view);
+  return iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                           IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+         iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
+                           IREE_HAL_BUFFER_USAGE_MAPPING);
+}
+
+// Computes the serialized key length of |key| applied to |args|.
+// Returns false if any argument is not cacheable.
+static bool iree_hal_result_cache_calculate_key_length(
+    iree_string_view_t key, iree_host_size_t arg_count,
+    iree_hal_buffer_view_t** args, iree_device_size_t* out_length) {
+  iree_device_size_t length = sizeof(uint64_t) + key.size;
+  for (iree_host_size_t i = 0; i < arg_count; ++i) {
+    if (!args[i] || !iree_hal_result_cache_is_mappable(args[i])) return false;
+    iree_host_size_t rank = iree_hal_buffer_view_shape_rank(args[i]);
+    length += sizeof(iree_hal_result_cache_arg_header_t) +
+              rank * sizeof(iree_hal_dim_t) +
+              iree_hal_buffer_view_byte_length(args[i]);
+  }
+  *out_length = length;
+  return true;
+}
+
+// Serializes the key of |key| applied to |args| into |out_data|, which must
+// have the length returned by iree_hal_result_cache_calculate_key_length.
+static iree_status_t iree_hal_result_cache_serialize_key(
+    iree_string_view_t key, iree_host_size_t arg_count,
+    iree_hal_buffer_view_t** args, uint8_t* out_data) {
+  uint8_t* p = out_data;
+  uint64_t key_size = key.size;
+  memcpy(p, &key_size, sizeof(key_size));
+  p += sizeof(key_size);
+  memcpy(p, key.data, key.size);
+  p += key.size;
+  for (iree_host_size_t i = 0; i < arg_count; ++i) {
+    iree_hal_buffer_view_t* buffer_view = args[i];
+    iree_hal_result_cache_arg_header_t header = {
+        .element_type = iree_hal_buffer_view_element_type(buffer_view),
+        .encoding_type = iree_hal_buffer_view_encoding_type(buffer_view),
+        .rank = iree_hal_buffer_view_shape_rank(buffer_view),
+        .byte_length = iree_hal_buffer_view_byte_length(buffer_view),
+    };
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, iree_hal_buffer_view_shape_dims(buffer_view),
+           header.rank * sizeof(iree_hal_dim_t));
+    p += header.rank * sizeof(iree_hal_dim_t);
+    IREE_RETURN_IF_ERROR(
+        iree_hal_buffer_map_read(iree_hal_buffer_view_buffer(buffer_view), 0,
+                                 p, header.byte_length));
+    p += header.byte_length;
+  }
+  return iree_ok_status();
+}
+
+// 64-bit multiplicative hash of |data|. Not cryptographic; collisions are
+// resolved by comparing the full key.
+static uint64_t iree_hal_result_cache_hash(const uint8_t* data,
+                                           iree_host_size_t length) {
+  const uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+  uint64_t hash = 0xCBF29CE484222325ull ^ (length * kMultiplier);
+  iree_host_size_t i = 0;
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  if (i < length) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, length - i);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  hash ^= hash >> 32;
+  return hash;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_result_cache_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_result_cache_entry_t {
+  // Next entry in the same hash bucket.
+  struct iree_hal_result_cache_entry_t* bucket_next;
+  // Neighbors in the LRU list; the head is the most recently used.
+  struct iree_hal_result_cache_entry_t* lru_prev;
+  struct iree_hal_result_cache_entry_t* lru_next;
+  uint64_t hash;
+  // Total bytes charged against the cache capacity.
+  iree_device_size_t size;
+  // Token returned from the lookup that missed holding the serialized key.
+  iree_vm_buffer_t* key_token;
+  iree_host_size_t key_length;
+  const uint8_t* key_data;
+  iree_host_size_t result_count;
+  iree_hal_buffer_view_t* results[];
+} iree_hal_result_cache_entry_t;
+
+struct iree_hal_result_cache_t {
+  iree_allocator_t host_allocator;
+
+  // Guards all fields below.
+  iree_slim_mutex_t mutex;
+
+  iree_hal_result_cache_statistics_t statistics;
+
+  // Entries in least-recently-used order. New entries and hits are moved to
+  // the head and evictions are taken from the tail.
+  iree_hal_result_cache_entry_t* lru_head;
+  iree_hal_result_cache_entry_t* lru_tail;
+
+  // Power-of-two sized hash table of entries chained by bucket_next.
+  iree_host_size_t bucket_count;
+  iree_hal_result_cache_entry_t** buckets;
+};
+
+static void iree_hal_result_cache_entry_free(
+    iree_allocator_t host_allocator, iree_hal_result_cache_entry_t* entry) {
+  for (iree_host_size_t i = 0; i < entry->result_count; ++i) {
+    iree_hal_buffer_view_release(entry->results[i]);
+  }
+  iree_vm_buffer_release(entry->key_token);
+  iree_allocator_free(host_allocator, entry);
+}
+
+iree_status_t iree_hal_result_cache_create(
+    iree_device_size_t capacity, iree_allocator_t host_allocator,
+    iree_hal_result_cache_t** out_cache) {
+  IREE_ASSERT_ARGUMENT(out_cache);
+  *out_cache = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_result_cache_t* cache = NULL;
+  iree_host_size_t total_size =
+      sizeof(*cache) +
+      IREE_HAL_RESULT_CACHE_INITIAL_BUCKET_COUNT * sizeof(cache->buckets[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&cache));
+  memset(cache, 0, total_size);
+  cache->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&cache->mutex);
+  cache->statistics.capacity = capacity;
+  cache->bucket_count = IREE_HAL_RESULT_CACHE_INITIAL_BUCKET_COUNT;
+  cache->buckets = (iree_hal_result_cache_entry_t**)((uint8_t*)cache +
+                                                     sizeof(*cache));
+
+  *out_cache = cache;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_result_cache_destroy(iree_hal_result_cache_t* cache) {
+  if (!cache) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_result_cache_entry_t* entry = cache->lru_head;
+  while (entry) {
+    iree_hal_result_cache_entry_t* next_entry = entry->lru_next;
+    iree_hal_result_cache_entry_free(cache->host_allocator, entry);
+    entry = next_entry;
+  }
+  if (cache->buckets != (iree_hal_result_cache_entry_t**)((uint8_t*)cache +
+                                                          sizeof(*cache))) {
+    iree_allocator_free(cache->host_allocator, cache->buckets);
+  }
+  iree_slim_mutex_deinitialize(&cache->mutex);
+  iree_allocator_free(cache->host_allocator, cache);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_hal_result_cache_entry_t** iree_hal_result_cache_bucket(
+    iree_hal_result_cache_t* cache, uint64_t hash) {
+  return &cache->buckets[hash & (cache->bucket_count - 1)];
+}
+
+// Finds the entry matching |key_data| or NULL if not present.
+// Must be called with the mutex held.
+static iree_hal_result_cache_entry_t* iree_hal_result_cache_find(
+    iree_hal_result_cache_t* cache, uint64_t hash, const uint8_t* key_data,
+    iree_host_size_t key_length) {
+  iree_hal_result_cache_entry_t* entry =
+      *iree_hal_result_cache_bucket(cache, hash);
+  for (; entry; entry = entry->bucket_next) {
+    if (entry->hash == hash && entry->key_length == key_length &&
+        memcmp(entry->key_data, key_data, key_length) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void iree_hal_result_cache_lru_unlink(
+    iree_hal_result_cache_t* cache, iree_hal_result_cache_entry_t* entry) {
+  if (entry->lru_prev) {
+    entry->lru_prev->lru_next = entry->lru_next;
+  } else {
+    cache->lru_head = entry->lru_next;
+  }
+  if (entry->lru_next) {
+    entry->lru_next->lru_prev = entry->lru_prev;
+  } else {
+    cache->lru_tail = entry->lru_prev;
+  }
+  entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void iree_hal_result_cache_lru_push_head(
+    iree_hal_result_cache_t* cache, iree_hal_result_cache_entry_t* entry) {
+  entry->lru_prev = NULL;
+  entry->lru_next = cache->lru_head;
+  if (cache->lru_head) cache->lru_head->lru_prev = entry;
+  cache->lru_head = entry;
+  if (!cache->lru_tail) cache->lru_tail = entry;
+}
+
+// Doubles the bucket count and rehashes all entries. Failure to grow is not an
+// error as the existing table remains valid, just with longer chains.
+// Must be called with the mutex held.
+static void iree_hal_result_cache_grow_buckets(iree_hal_result_cache_t* cache) {
+  iree_host_size_t new_bucket_count = cache->bucket_count * 2;
+  iree_hal_result_cache_entry_t** new_buckets = NULL;
+  if (!iree_status_is_ok(iree_allocator_malloc(
+          cache->host_allocator, new_bucket_count * sizeof(new_buckets[0]),
+          (void**)&new_buckets))) {
+    return;
+  }
+  memset(new_buckets, 0, new_bucket_count * sizeof(new_buckets[0]));
+  for (iree_host_size_t i = 0; i < cache->bucket_count; ++i) {
+    iree_hal_result_cache_entry_t* entry = cache->buckets[i];
+    while (entry) {
+      iree_hal_result_cache_entry_t* next_entry = entry->bucket_next;
+      iree_hal_result_cache_entry_t** bucket =
+          &new_buckets[entry->hash & (new_bucket_count - 1)];
+      entry->bucket_next = *bucket;
+      *bucket = entry;
+      entry = next_entry;
+    }
+  }
+  if (cache->buckets != (iree_hal_result_cache_entry_t**)((uint8_t*)cache +
+                                                          sizeof(*cache))) {
+    iree_allocator_free(cache->host_allocator, cache->buckets);
+  }
+  cache->buckets = new_buckets;
+  cache->bucket_count = new_bucket_count;
+}
+
+// Evicts least-recently-used entries until at most |capacity| bytes are
+// resident. Evicted entries are chained through bucket_next into
+// |out_evicted_head| so that they can be freed outside of the lock.
+// Must be called with the mutex held.
+static void iree_hal_result_cache_evict(
+    iree_hal_result_cache_t* cache, iree_device_size_t capacity,
+    iree_hal_result_cache_entry_t** out_evicted_head) {
+  while (cache->lru_tail && cache->statistics.resident_size > capacity) {
+    iree_hal_result_cache_entry_t* entry = cache->lru_tail;
+    iree_hal_result_cache_lru_unlink(cache, entry);
+    iree_hal_result_cache_entry_t** link =
+        iree_hal_result_cache_bucket(cache, entry->hash);
+    while (*link != entry) link = &(*link)->bucket_next;
+    *link = entry->bucket_next;
+    entry->bucket_next = *out_evicted_head;
+    *out_evicted_head = entry;
+    cache->statistics.resident_size -= entry->size;
+    --cache->statistics.entry_count;
+    ++cache->statistics.eviction_count;
+  }
+}
+
+static void iree_hal_result_cache_free_evicted(
+    iree_hal_result_cache_t* cache, iree_hal_result_cache_entry_t* entry) {
+  while (entry) {
+    iree_hal_result_cache_entry_t* next_entry = entry->bucket_next;
+    iree_hal_result_cache_entry_free(cache->host_allocator, entry);
+    entry = next_entry;
+  }
+}
+
+void iree_hal_result_cache_set_capacity(iree_hal_result_cache_t* cache,
+                                        iree_device_size_t capacity) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_result_cache_entry_t* evicted_head = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  cache->statistics.capacity = capacity;
+  iree_hal_result_cache_evict(cache, capacity, &evicted_head);
+  iree_slim_mutex_unlock(&cache->mutex);
+  iree_hal_result_cache_free_evicted(cache, evicted_head);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_result_cache_trim(iree_hal_result_cache_t* cache) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_result_cache_entry_t* evicted_head = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_result_cache_evict(cache, 0, &evicted_head);
+  iree_slim_mutex_unlock(&cache->mutex);
+  iree_hal_result_cache_free_evicted(cache, evicted_head);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_result_cache_query_statistics(
+    iree_hal_result_cache_t* cache,
+    iree_hal_result_cache_statistics_t* out_statistics) {
+  iree_slim_mutex_lock(&cache->mutex);
+  *out_statistics = cache->statistics;
+  iree_slim_mutex_unlock(&cache->mutex);
+}
+
+// Builds a key token for |key| applied to |args| if it is cacheable and fits
+// within |capacity|. Returns with |out_key_token| NULL if not cacheable.
+static iree_status_t iree_hal_result_cache_build_key_token(
+    iree_hal_result_cache_t* cache, iree_device_size_t capacity,
+    iree_string_view_t key, iree_host_size_t arg_count,
+    iree_hal_buffer_view_t** args, iree_vm_buffer_t** out_key_token) {
+  *out_key_token = NULL;
+  iree_device_size_t key_length = 0;
+  if (!iree_hal_result_cache_calculate_key_length(key, arg_count, args,
+                                                  &key_length) ||
+      key_length > capacity) {
+    return iree_ok_status();
+  }
+  const iree_host_size_t header_size =
+      sizeof(iree_hal_result_cache_token_header_t) +
+      arg_count * sizeof(uintptr_t);
+  iree_vm_buffer_t* key_token = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_create(
+      IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+      header_size + (iree_host_size_t)key_length, cache->host_allocator,
+      &key_token));
+  uint8_t* token_data = key_token->data.data;
+  uint8_t* key_data = token_data + header_size;
+  iree_status_t status =
+      iree_hal_result_cache_serialize_key(key, arg_count, args, key_data);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_buffer_release(key_token);
+    return status;
+  }
+  iree_hal_result_cache_token_header_t header = {
+      .hash =
+          iree_hal_result_cache_hash(key_data, (iree_host_size_t)key_length),
+      .arg_count = arg_count,
+  };
+  memcpy(token_data, &header, sizeof(header));
+  for (iree_host_size_t i = 0; i < arg_count; ++i) {
+    uintptr_t arg_buffer = (uintptr_t)iree_hal_buffer_allocated_buffer(
+        iree_hal_buffer_view_buffer(args[i]));
+    memcpy(token_data + sizeof(header) + i * sizeof(arg_buffer), &arg_buffer,
+           sizeof(arg_buffer));
+  }
+  *out_key_token = key_token;
+  return iree_ok_status();
+}
+
+// Returns the hash, argument identities, and serialized key stored in
+// |key_token|.
+static iree_status_t iree_hal_result_cache_parse_key_token(
+    iree_vm_buffer_t* key_token, uint64_t* out_hash,
+    iree_const_byte_span_t* out_arg_buffers, iree_const_byte_span_t* out_key) {
+  iree_byte_span_t token_data = key_token->data;
+  iree_hal_result_cache_token_header_t header;
+  if (key_token->access != IREE_VM_BUFFER_ACCESS_ORIGIN_HOST ||
+      token_data.data_length < sizeof(header)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "buffer is not a result cache key token");
+  }
+  memcpy(&header, token_data.data, sizeof(header));
+  if (header.arg_count >
+      (token_data.data_length - sizeof(header)) / sizeof(uintptr_t)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "buffer is not a result cache key token");
+  }
+  iree_host_size_t arg_buffers_length =
+      (iree_host_size_t)header.arg_count * sizeof(uintptr_t);
+  *out_hash = header.hash;
+  *out_arg_buffers = iree_make_const_byte_span(token_data.data + sizeof(header),
+                                               arg_buffers_length);
+  *out_key = iree_make_const_byte_span(
+      out_arg_buffers->data + arg_buffers_length,
+      token_data.data_length - sizeof(header) - arg_buffers_length);
+  return iree_ok_status();
+}
+
+// Returns true if |buffer| is backed by the same allocation as any of the
+// argument identities in |arg_buffers|.
+static bool iree_hal_result_cache_aliases_arg(
+    iree_const_byte_span_t arg_buffers, iree_hal_buffer_t* buffer) {
+  uintptr_t allocated_buffer =
+      (uintptr_t)iree_hal_buffer_allocated_buffer(buffer);
+  for (iree_host_size_t offset = 0; offset < arg_buffers.data_length;
+       offset += sizeof(uintptr_t)) {
+    uintptr_t arg_buffer = 0;
+    memcpy(&arg_buffer, arg_buffers.data + offset, sizeof(arg_buffer));
+    if (arg_buffer == allocated_buffer) return true;
+  }
+  return false;
+}
+
+static iree_device_size_t iree_hal_result_cache_capacity(
+    iree_hal_result_cache_t* cache) {
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_device_size_t capacity = cache->statistics.capacity;
+  iree_slim_mutex_unlock(&cache->mutex);
+  return capacity;
+}
+
+iree_status_t iree_hal_result_cache_lookup(
+    iree_hal_result_cache_t* cache, iree_string_view_t key,
+    iree_host_size_t arg_count, iree_hal_buffer_view_t** args,
+    iree_vm_list_t* results, bool* out_hit, iree_vm_buffer_t** out_key_token) {
+  IREE_ASSERT_ARGUMENT(cache);
+  IREE_ASSERT_ARGUMENT(results);
+  IREE_ASSERT_ARGUMENT(out_hit);
+  IREE_ASSERT_ARGUMENT(out_key_token);
+  *out_hit = false;
+  *out_key_token = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, key.data, key.size);
+
+  iree_vm_buffer_t* key_token = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_result_cache_build_key_token(
+              cache, iree_hal_result_cache_capacity(cache), key, arg_count,
+              args, &key_token));
+  uint64_t hash = 0;
+  iree_const_byte_span_t arg_buffers = iree_const_byte_span_empty();
+  iree_const_byte_span_t key_data = iree_const_byte_span_empty();
+  if (key_token) {
+    IREE_IGNORE_ERROR(iree_hal_result_cache_parse_key_token(
+        key_token, &hash, &arg_buffers, &key_data));
+  }
+
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_result_cache_entry_t* entry =
+      key_token ? iree_hal_result_cache_find(cache, hash, key_data.data,
+                                             key_data.data_length)
+                : NULL;
+  if (entry) {
+    iree_hal_result_cache_lru_unlink(cache, entry);
+    iree_hal_result_cache_lru_push_head(cache, entry);
+    for (iree_host_size_t i = 0;
+         i < entry->result_count && iree_status_is_ok(status); ++i) {
+      iree_vm_ref_t result_ref =
+          iree_hal_buffer_view_retain_ref(entry->results[i]);
+      status = iree_vm_list_push_ref_move(results, &result_ref);
+      iree_vm_ref_release(&result_ref);
+    }
+    ++cache->statistics.hit_count;
+    *out_hit = iree_status_is_ok(status);
+  } else {
+    ++cache->statistics.miss_count;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+
+  if (entry || !iree_status_is_ok(status)) {
+    iree_vm_buffer_release(key_token);
+  } else {
+    *out_key_token = key_token;
+  }
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, *out_hit ? "hit" : "miss");
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_result_cache_insert(iree_hal_result_cache_t* cache,
+                                           iree_vm_buffer_t* key_token,
+                                           iree_vm_list_t* results) {
+  IREE_ASSERT_ARGUMENT(cache);
+  IREE_ASSERT_ARGUMENT(results);
+  if (!key_token) return iree_ok_status();  // not cacheable
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  uint64_t hash = 0;
+  iree_const_byte_span_t arg_buffers = iree_const_byte_span_empty();
+  iree_const_byte_span_t key_data = iree_const_byte_span_empty();
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_result_cache_parse_key_token(key_token, &hash, &arg_buffers,
+                                                &key_data));
+
+  // Verify the results before doing any work so that invalid programs fail
+  // consistently regardless of the cache state.
+  iree_host_size_t result_count = iree_vm_list_size(results);
+  iree_device_size_t result_size = 0;
+  for (iree_host_size_t i = 0; i < result_count; ++i) {
+    iree_hal_buffer_view_t* buffer_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            results, i, iree_hal_buffer_view_get_descriptor());
+    if (!buffer_view) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "result %" PRIhsz " is not a buffer view", i);
+    }
+    result_size += iree_hal_buffer_view_byte_length(buffer_view);
+  }
+
+  // Results that alias an argument (such as a returned or reshaped argument)
+  // would observe any later changes the caller makes to the argument and can
+  // not be shared with other callers.
+  for (iree_host_size_t i = 0; i < result_count; ++i) {
+    iree_hal_buffer_view_t* buffer_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            results, i, iree_hal_buffer_view_get_descriptor());
+    if (iree_hal_result_cache_aliases_arg(
+            arg_buffers, iree_hal_buffer_view_buffer(buffer_view))) {
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "aliased");
+      IREE_TRACE_ZONE_END(z0);
+      return iree_ok_status();
+    }
+  }
+
+  // Allocate the entry with the results stored inline. The key is retained
+  // from the token produced by the lookup.
+  iree_hal_result_cache_entry_t* entry = NULL;
+  iree_host_size_t entry_size =
+      sizeof(*entry) + result_count * sizeof(entry->results[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(cache->host_allocator, entry_size,
+                                (void**)&entry));
+  memset(entry, 0, sizeof(*entry));
+  entry->hash = hash;
+  entry->size = key_data.data_length + result_size;
+  entry->key_token = key_token;
+  iree_vm_buffer_retain(entry->key_token);
+  entry->key_length = key_data.data_length;
+  entry->key_data = key_data.data;
+  entry->result_count = result_count;
+  for (iree_host_size_t i = 0; i < result_count; ++i) {
+    entry->results[i] = (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+        results, i, iree_hal_buffer_view_get_descriptor());
+    iree_hal_buffer_view_retain(entry->results[i]);
+  }
+
+  iree_hal_result_cache_entry_t* evicted_head = NULL;
+  iree_slim_mutex_lock(&cache->mutex);
+  if (entry->size > cache->statistics.capacity ||
+      iree_hal_result_cache_find(cache, entry->hash, entry->key_data,
+                                 entry->key_length)) {
+    // Too large or raced with another insertion of the same key.
+    entry->bucket_next = evicted_head;
+    evicted_head = entry;
+  } else {
+    iree_hal_result_cache_evict(
+        cache, cache->statistics.capacity - entry->size, &evicted_head);
+    if (cache->statistics.entry_count >= cache->bucket_count) {
+      iree_hal_result_cache_grow_buckets(cache);
+    }
+    iree_hal_result_cache_entry_t** bucket =
+        iree_hal_result_cache_bucket(cache, entry->hash);
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    iree_hal_result_cache_lru_push_head(cache, entry);
+    cache->statistics.resident_size += entry->size;
+    ++cache->statistics.entry_count;
+    ++cache->statistics.insert_count;
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  iree_hal_result_cache_free_evicted(cache, evicted_head);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
@@ -0,0 +1,101 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_MODULES_HAL_UTILS_RESULT_CACHE_H_
+#define IREE_MODULES_HAL_UTILS_RESULT_CACHE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_result_cache_t
+//===----------------------------------------------------------------------===//
+
+// Statistics tracked over the lifetime of a result cache.
+typedef struct iree_hal_result_cache_statistics_t {
+  // Total number of lookups that were served from the cache.
+  uint64_t hit_count;
+  // Total number of lookups that missed (including uncacheable arguments).
+  uint64_t miss_count;
+  // Total number of entries inserted.
+  uint64_t insert_count;
+  // Total number of entries evicted to stay within the capacity.
+  uint64_t eviction_count;
+  // Number of entries currently resident.
+  iree_host_size_t entry_count;
+  // Bytes of keys and results currently resident.
+  iree_device_size_t resident_size;
+  // Maximum number of resident bytes before entries are evicted.
+  iree_device_size_t capacity;
+} iree_hal_result_cache_statistics_t;
+
+// A content-addressed cache of buffer view results keyed by a function key and
+// the full contents of its buffer view arguments.
+//
+// Entries are evicted in least-recently-used order to keep the total size of
+// the argument contents and retained results within the configured capacity.
+// Arguments must be host-mappable in order to be hashed; lookups with
+// arguments that cannot be mapped always miss and are never inserted.
+//
+// Cached results are shared between all callers that hit the entry and must be
+// treated as immutable.
+//
+// Thread-safe.
+typedef struct iree_hal_result_cache_t iree_hal_result_cache_t;
+
+// Creates a result cache holding up to |capacity| bytes.
+// A |capacity| of 0 disables caching.
+iree_status_t iree_hal_result_cache_create(
+    iree_device_size_t capacity, iree_allocator_t host_allocator,
+    iree_hal_result_cache_t** out_cache);
+
+// Destroys |cache| and releases all retained results.
+void iree_hal_result_cache_destroy(iree_hal_result_cache_t* cache);
+
+// Sets the capacity of |cache| in bytes and evicts entries as needed.
+void iree_hal_result_cache_set_capacity(iree_hal_result_cache_t* cache,
+                                        iree_device_size_t capacity);
+
+// Evicts all entries from |cache|.
+void iree_hal_result_cache_trim(iree_hal_result_cache_t* cache);
+
+// Queries the current |cache| statistics.
+void iree_hal_result_cache_query_statistics(
+    iree_hal_result_cache_t* cache,
+    iree_hal_result_cache_statistics_t* out_statistics);
+
+// Looks up the results of |key| applied to |args|. On a hit the cached results
+// are appended to |results| and |out_hit| is set to true.
+//
+// On a miss with cacheable arguments |out_key_token| receives a token holding
+// the hashed key that can be passed to iree_hal_result_cache_insert without
+// reading the arguments again. The token is NULL on hits and when the
+// arguments cannot be cached. The caller must release the token.
+iree_status_t iree_hal_result_cache_lookup(
+    iree_hal_result_cache_t* cache, iree_string_view_t key,
+    iree_host_size_t arg_count, iree_hal_buffer_view_t** args,
+    iree_vm_list_t* results, bool* out_hit, iree_vm_buffer_t** out_key_token);
+
+// Inserts the buffer view |results| under the |key_token| returned from a
+// missed iree_hal_result_cache_lookup. Ignored if |key_token| is NULL, the
+// entry would exceed the cache capacity, or any result shares an allocated
+// buffer with one of the arguments the token was built from.
+iree_status_t iree_hal_result_cache_insert(iree_hal_result_cache_t* cache,
+                                           iree_vm_buffer_t* key_token,
+                                           iree_vm_list_t* results);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_MODULES_HAL_UTILS_RESULT_CACHE_H_
@@ -0,0 +1,348 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/hal/utils/result_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/modules/hal/types.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static constexpr iree_device_size_t kDefaultCapacity = 1024 * 1024;
+
+struct ResultCacheTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_vm_instance_t* instance = NULL;
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_hal_result_cache_t* cache = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_vm_instance_create(host_allocator, &instance));
+    IREE_ASSERT_OK(iree_hal_module_register_all_types(instance));
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("heap"), host_allocator, host_allocator, &device_allocator));
+    IREE_ASSERT_OK(
+        iree_hal_result_cache_create(kDefaultCapacity, host_allocator, &cache));
+  }
+
+  void TearDown() override {
+    iree_hal_result_cache_destroy(cache);
+    iree_hal_allocator_release(device_allocator);
+    iree_vm_instance_release(instance);
+  }
+
+  // Returns a 4xi32 buffer view with all elements set to |value|.
+  iree_hal_buffer_view_t* MakeBufferView(int32_t value) {
+    int32_t data[4] = {value, value, value, value};
+    iree_hal_dim_t shape[1] = {IREE_ARRAYSIZE(data)};
+    iree_hal_buffer_params_t params = {0};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    params.usage =
+        IREE_HAL_BUFFER_USAGE_DEFAULT | IREE_HAL_BUFFER_USAGE_MAPPING;
+    iree_hal_buffer_view_t* buffer_view = NULL;
+    IREE_CHECK_OK(iree_hal_buffer_view_allocate_buffer(
+        device_allocator, IREE_ARRAYSIZE(shape), shape,
+        IREE_HAL_ELEMENT_TYPE_INT_32, IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+        params, iree_make_const_byte_span(data, sizeof(data)), &buffer_view));
+    return buffer_view;
+  }
+
+  // Returns a list of buffer views containing |result| if not NULL.
+  iree_vm_list_t* MakeList(iree_hal_buffer_view_t* result) {
+    iree_vm_type_def_t element_type =
+        iree_vm_type_def_make_ref_type(iree_hal_buffer_view_type_id());
+    iree_vm_list_t* list = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(&element_type, /*capacity=*/1,
+                                      host_allocator, &list));
+    if (result) {
+      iree_vm_ref_t result_ref = iree_hal_buffer_view_retain_ref(result);
+      IREE_CHECK_OK(iree_vm_list_push_ref_move(list, &result_ref));
+    }
+    return list;
+  }
+
+  // Looks up |arg| and returns the key token if it missed and is cacheable.
+  // |out_result| receives the cached result on a hit.
+  iree_vm_buffer_t* Lookup(iree_hal_buffer_view_t* arg,
+                           iree_hal_buffer_view_t** out_result = NULL) {
+    iree_vm_list_t* results = MakeList(NULL);
+    bool hit = false;
+    iree_vm_buffer_t* key_token = NULL;
+    IREE_CHECK_OK(iree_hal_result_cache_lookup(cache, IREE_SV("fn"), 1, &arg,
+                                               results, &hit, &key_token));
+    if (hit) EXPECT_EQ(key_token, nullptr);
+    EXPECT_EQ(iree_vm_list_size(results), hit ? 1 : 0);
+    if (out_result) {
+      *out_result =
+          hit ? (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+                    results, 0, iree_hal_buffer_view_get_descriptor())
+              : NULL;
+    }
+    iree_vm_list_release(results);
+    return key_token;
+  }
+
+  // Inserts |result| under |key_token| and releases the token.
+  void Insert(iree_vm_buffer_t* key_token, iree_hal_buffer_view_t* result) {
+    iree_vm_list_t* results = MakeList(result);
+    IREE_EXPECT_OK(iree_hal_result_cache_insert(cache, key_token, results));
+    iree_vm_list_release(results);
+    iree_vm_buffer_release(key_token);
+  }
+
+  // Looks up |arg| and inserts |result| if it missed.
+  void Populate(iree_hal_buffer_view_t* arg, iree_hal_buffer_view_t* result) {
+    iree_vm_buffer_t* key_token = Lookup(arg);
+    ASSERT_NE(key_token, nullptr);
+    Insert(key_token, result);
+  }
+
+  iree_hal_result_cache_statistics_t QueryStatistics() {
+    iree_hal_result_cache_statistics_t statistics;
+    iree_hal_result_cache_query_statistics(cache, &statistics);
+    return statistics;
+  }
+};
+
+TEST_F(ResultCacheTest, MissThenHit) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+
+  Populate(arg, result);
+
+  iree_hal_buffer_view_t* cached_result = NULL;
+  EXPECT_EQ(Lookup(arg, &cached_result), nullptr);
+  EXPECT_EQ(cached_result, result);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.hit_count, 1);
+  EXPECT_EQ(statistics.miss_count, 1);
+  EXPECT_EQ(statistics.insert_count, 1);
+  EXPECT_EQ(statistics.entry_count, 1);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(arg);
+}
+
+TEST_F(ResultCacheTest, DifferentContentsMiss) {
+  iree_hal_buffer_view_t* arg0 = MakeBufferView(1);
+  iree_hal_buffer_view_t* arg1 = MakeBufferView(3);
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+
+  Populate(arg0, result);
+
+  iree_vm_buffer_t* key_token = Lookup(arg1);
+  EXPECT_NE(key_token, nullptr);
+  iree_vm_buffer_release(key_token);
+  EXPECT_EQ(QueryStatistics().miss_count, 2);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(arg1);
+  iree_hal_buffer_view_release(arg0);
+}
+
+// Tokens lead with the key hash and end with the serialized argument contents.
+// Flipping the last byte produces a token with the same hash for different
+// contents as if the hash had collided.
+TEST_F(ResultCacheTest, SameHashDifferentContents) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+  iree_hal_buffer_view_t* colliding_result = MakeBufferView(2);
+  iree_hal_buffer_view_t* result = MakeBufferView(3);
+
+  iree_vm_buffer_t* key_token = Lookup(arg);
+  ASSERT_NE(key_token, nullptr);
+  iree_vm_buffer_t* colliding_token = NULL;
+  IREE_ASSERT_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+                                       key_token->data.data_length,
+                                       host_allocator, &colliding_token));
+  memcpy(colliding_token->data.data, key_token->data.data,
+         key_token->data.data_length);
+  colliding_token->data.data[colliding_token->data.data_length - 1] ^= 0xFF;
+  Insert(colliding_token, colliding_result);
+
+  // The colliding entry must not be returned for the original contents.
+  iree_vm_buffer_t* retry_token = Lookup(arg);
+  EXPECT_NE(retry_token, nullptr);
+  iree_vm_buffer_release(retry_token);
+
+  // Both entries are resident and resolved by their full keys.
+  Insert(key_token, result);
+  EXPECT_EQ(QueryStatistics().entry_count, 2);
+  iree_hal_buffer_view_t* cached_result = NULL;
+  EXPECT_EQ(Lookup(arg, &cached_result), nullptr);
+  EXPECT_EQ(cached_result, result);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(colliding_result);
+  iree_hal_buffer_view_release(arg);
+}
+
+TEST_F(ResultCacheTest, EvictsLeastRecentlyUsed) {
+  iree_hal_buffer_view_t* args[3] = {MakeBufferView(0), MakeBufferView(1),
+                                     MakeBufferView(2)};
+  iree_hal_buffer_view_t* result = MakeBufferView(3);
+
+  // All entries have the same size so size the cache to hold two of them.
+  Populate(args[0], result);
+  iree_device_size_t entry_size = QueryStatistics().resident_size;
+  ASSERT_GT(entry_size, 0);
+  iree_hal_result_cache_set_capacity(cache, 2 * entry_size);
+  Populate(args[1], result);
+  EXPECT_EQ(QueryStatistics().resident_size, 2 * entry_size);
+
+  // Touch args[0] so that args[1] is the least recently used.
+  EXPECT_EQ(Lookup(args[0]), nullptr);
+  Populate(args[2], result);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.entry_count, 2);
+  EXPECT_EQ(statistics.eviction_count, 1);
+  EXPECT_EQ(statistics.resident_size, 2 * entry_size);
+  EXPECT_EQ(Lookup(args[0]), nullptr);
+  EXPECT_EQ(Lookup(args[2]), nullptr);
+  iree_vm_buffer_t* key_token = Lookup(args[1]);
+  EXPECT_NE(key_token, nullptr);
+  iree_vm_buffer_release(key_token);
+
+  iree_hal_buffer_view_release(result);
+  for (size_t i = 0; i < IREE_ARRAYSIZE(args); ++i) {
+    iree_hal_buffer_view_release(args[i]);
+  }
+}
+
+TEST_F(ResultCacheTest, ZeroCapacity) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+
+  Populate(arg, result);
+  iree_hal_result_cache_set_capacity(cache, 0);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.capacity, 0);
+  EXPECT_EQ(statistics.entry_count, 0);
+  EXPECT_EQ(statistics.resident_size, 0);
+  EXPECT_EQ(statistics.eviction_count, 1);
+
+  // Nothing fits so lookups return no token and inserts are ignored.
+  EXPECT_EQ(Lookup(arg), nullptr);
+  Insert(NULL, result);
+  EXPECT_EQ(QueryStatistics().entry_count, 0);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(arg);
+}
+
+TEST_F(ResultCacheTest, Trim) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+
+  Populate(arg, result);
+  iree_hal_result_cache_trim(cache);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.capacity, kDefaultCapacity);
+  EXPECT_EQ(statistics.entry_count, 0);
+  EXPECT_EQ(statistics.resident_size, 0);
+
+  // Trimming does not change the capacity so entries can be inserted again.
+  Populate(arg, result);
+  EXPECT_EQ(QueryStatistics().entry_count, 1);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(arg);
+}
+
+TEST_F(ResultCacheTest, DuplicateInsert) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+  iree_hal_buffer_view_t* duplicate_result = MakeBufferView(3);
+
+  // Two callers missing concurrently both insert with their own tokens.
+  iree_vm_buffer_t* key_token0 = Lookup(arg);
+  iree_vm_buffer_t* key_token1 = Lookup(arg);
+  ASSERT_NE(key_token0, nullptr);
+  ASSERT_NE(key_token1, nullptr);
+  Insert(key_token0, result);
+  iree_device_size_t resident_size = QueryStatistics().resident_size;
+  Insert(key_token1, duplicate_result);
+
+  // The first insertion wins.
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.entry_count, 1);
+  EXPECT_EQ(statistics.insert_count, 1);
+  EXPECT_EQ(statistics.resident_size, resident_size);
+  iree_hal_buffer_view_t* cached_result = NULL;
+  EXPECT_EQ(Lookup(arg, &cached_result), nullptr);
+  EXPECT_EQ(cached_result, result);
+
+  iree_hal_buffer_view_release(duplicate_result);
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(arg);
+}
+
+// Results aliasing an argument, such as a returned argument or a reshape of a
+// subspan of it, would change when the caller mutates the argument and must
+// not be inserted.
+TEST_F(ResultCacheTest, AliasedResultsNotInserted) {
+  iree_hal_buffer_view_t* arg = MakeBufferView(1);
+
+  Populate(arg, arg);
+  EXPECT_EQ(QueryStatistics().entry_count, 0);
+
+  iree_hal_buffer_t* subspan = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_subspan(iree_hal_buffer_view_buffer(arg),
+                                         /*byte_offset=*/0,
+                                         /*byte_length=*/2 * sizeof(int32_t),
+                                         &subspan));
+  iree_hal_dim_t shape[2] = {1, 2};
+  iree_hal_buffer_view_t* reshaped = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_view_create(
+      subspan, IREE_ARRAYSIZE(shape), shape, IREE_HAL_ELEMENT_TYPE_INT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, host_allocator, &reshaped));
+  iree_hal_buffer_release(subspan);
+  Populate(arg, reshaped);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(statistics.entry_count, 0);
+  EXPECT_EQ(statistics.insert_count, 0);
+  EXPECT_EQ(statistics.miss_count, 2);
+
+  // Results that do not alias the argument are still inserted.
+  iree_hal_buffer_view_t* result = MakeBufferView(2);
+  Populate(arg, result);
+  EXPECT_EQ(QueryStatistics().entry_count, 1);
+
+  iree_hal_buffer_view_release(result);
+  iree_hal_buffer_view_release(reshaped);
+  iree_hal_buffer_view_release(arg);
+}
+
+TEST_F(ResultCacheTest, RejectsForeignToken) {
+  iree_vm_buffer_t* key_token = NULL;
+  IREE_ASSERT_OK(iree_vm_buffer_create(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_GUEST, 64,
+      host_allocator, &key_token));
+  iree_vm_list_t* results = MakeList(NULL);
+  EXPECT_THAT(Status(iree_hal_result_cache_insert(cache, key_token, results)),
+              StatusIs(StatusCode::kInvalidArgument));
+  iree_vm_list_release(results);
+  iree_vm_buffer_release(key_token);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -61,6 +61,9 @@ struct iree_runtime_session_t {
   // lookup. An application directly using the API may never need this, or could
   // perform VM calls into HAL module exports to gain more portability.
   iree_vm_module_state_t* hal_module_state;
+
+  // Optional observer of session activity; all fields NULL if not set.
+  iree_runtime_session_observer_t observer;
 };
 
 IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
@@ -174,6 +177,17 @@ IREE_API_EXPORT iree_hal_allocator_t* iree_runtime_session_device_allocator(
   return iree_hal_device_allocator(device);
 }
 
+IREE_API_EXPORT void iree_runtime_session_set_observer(
+    iree_runtime_session_t* session,
+    const iree_runtime_session_observer_t* observer) {
+  IREE_ASSERT_ARGUMENT(session);
+  if (observer) {
+    session->observer = *observer;
+  } else {
+    memset(&session->observer, 0, sizeof(session->observer));
+  }
+}
+
 IREE_API_EXPORT iree_status_t
 iree_runtime_session_trim(iree_runtime_session_t* session) {
   IREE_ASSERT_ARGUMENT(session);
@@ -215,6 +229,10 @@ iree_runtime_session_append_bytecode_module_from_memory(
   if (iree_status_is_ok(status)) {
     status = iree_runtime_session_append_module(session, module);
   }
+  if (iree_status_is_ok(status) && session->observer.module_appended) {
+    status = session->observer.module_appended(session->observer.self, module,
+                                               flatbuffer_data);
+  }
   iree_vm_module_release(module);
 
   IREE_TRACE_ZONE_END(z0);
@@ -292,12 +310,29 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
   IREE_ASSERT_ARGUMENT(function);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (session->observer.call_begin) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, session->observer.call_begin(session->observer.self, function,
+                                         input_list));
+  }
+
   iree_status_t status =
       iree_vm_invoke(iree_runtime_session_context(session), *function,
                      IREE_VM_INVOCATION_FLAG_NONE,
                      /*policy=*/NULL, input_list, output_list,
                      iree_runtime_session_host_allocator(session));
 
+  if (session->observer.call_end) {
+    iree_status_t observer_status = session->observer.call_end(
+        session->observer.self, function, iree_status_code(status),
+        iree_status_is_ok(status) ? output_list : NULL);
+    if (iree_status_is_ok(status)) {
+      status = observer_status;
+    } else {
+      iree_status_ignore(observer_status);
+    }
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
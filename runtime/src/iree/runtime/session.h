@@ -67,6 +67,38 @@ typedef struct iree_runtime_session_options_t {
 IREE_API_EXPORT void iree_runtime_session_options_initialize(
     iree_runtime_session_options_t* out_options);
 
+//===----------------------------------------------------------------------===//
+// iree_runtime_session_observer_t
+//===----------------------------------------------------------------------===//
+
+// Observes activity on a session such as module loads and calls.
+// Used by tooling to capture traces of live sessions for later replay (see
+// iree/tooling/trace_capture.h). Any callback may be NULL. Errors returned from
+// the callbacks fail the operation being observed.
+typedef struct iree_runtime_session_observer_t {
+  // User data passed to all callbacks.
+  void* self;
+
+  // Called after a bytecode module has been appended to the session from
+  // |flatbuffer_data|. The data remains valid for the lifetime of the session.
+  iree_status_t(IREE_API_PTR* module_appended)(
+      void* self, iree_vm_module_t* module,
+      iree_const_byte_span_t flatbuffer_data);
+
+  // Called before |function| is invoked with |input_list|. The inputs have not
+  // yet been consumed or modified by the call.
+  iree_status_t(IREE_API_PTR* call_begin)(void* self,
+                                          const iree_vm_function_t* function,
+                                          iree_vm_list_t* input_list);
+
+  // Called after |function| has returned with the |call_status| code and the
+  // populated |output_list| if the call succeeded.
+  iree_status_t(IREE_API_PTR* call_end)(void* self,
+                                        const iree_vm_function_t* function,
+                                        iree_status_code_t call_status,
+                                        iree_vm_list_t* output_list);
+} iree_runtime_session_observer_t;
+
 //===----------------------------------------------------------------------===//
 // iree_runtime_session_t
 //===----------------------------------------------------------------------===//
@@ -128,6 +160,14 @@ IREE_API_EXPORT iree_hal_device_t* iree_runtime_session_device(
 IREE_API_EXPORT iree_hal_allocator_t* iree_runtime_session_device_allocator(
     const iree_runtime_session_t* session);
 
+// Sets the |observer| notified of session activity or NULL to clear it.
+// The observer is copied and the |observer->self| must remain valid until it
+// is cleared or the session is released. Only iree_runtime_session_call and
+// the iree_runtime_session_append_bytecode_module_* methods are observed.
+IREE_API_EXPORT void iree_runtime_session_set_observer(
+    iree_runtime_session_t* session,
+    const iree_runtime_session_observer_t* observer);
+
 // Trims transient/cached resources used by the session.
 // Upon resuming these resources may be expensive to rematerialize/reload and
 // as such this should only be called when it is known the resources will not
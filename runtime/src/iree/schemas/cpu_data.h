@@ -35,6 +35,9 @@
 // be available in cpufeature.h. AT_HWCAP stores only bit flags but we can
 // store any bit-packed scalar value as well such as cache sizes.
 //
+// Canonical keys match the LLVM target feature names (without the leading
+// `+`) so that compiler-specified CPU features can be queried directly.
+//
 // Wherever possible compile-time checks should be used instead to allow for
 // smaller and more optimizable code. For example if compiling for armv8.6+ the
 // I8MM feature will always be available and does not need to be tested.
@@ -73,6 +76,74 @@ enum iree_cpu_data_field_0_e {
   // Canonical key: "i8mm"
   IREE_CPU_DATA_FIELD_0_AARCH64_HAVE_I8MM = 1ull << 1,
 
+  //===--------------------------------------------------------------------===//
+  // IREE_ARCH_X86_64 / x86-64
+  //===--------------------------------------------------------------------===//
+  // Features requiring extended register state (AVX/AVX-512) are only reported
+  // when the OS has enabled saving that state (XCR0).
+
+  // Indicates support for AVX instructions.
+  //
+  // Source: CPUID.(EAX=1):ECX[28] + XCR0[2:1]
+  // Canonical key: "avx"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX = 1ull << 0,
+
+  // Indicates support for AVX2 instructions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[5] + XCR0[2:1]
+  // Canonical key: "avx2"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2 = 1ull << 1,
+
+  // Indicates support for FMA3 instructions.
+  //
+  // Source: CPUID.(EAX=1):ECX[12] + XCR0[2:1]
+  // Canonical key: "fma"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA = 1ull << 2,
+
+  // Indicates support for half-precision conversion instructions.
+  //
+  // Source: CPUID.(EAX=1):ECX[29] + XCR0[2:1]
+  // Canonical key: "f16c"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C = 1ull << 3,
+
+  // Indicates support for AVX-512 Foundation instructions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[16] + XCR0[7:5,2:1]
+  // Canonical key: "avx512f"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F = 1ull << 4,
+
+  // Indicates support for AVX-512 Conflict Detection instructions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[28] + XCR0[7:5,2:1]
+  // Canonical key: "avx512cd"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD = 1ull << 5,
+
+  // Indicates support for AVX-512 Vector Length extensions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[31] + XCR0[7:5,2:1]
+  // Canonical key: "avx512vl"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL = 1ull << 6,
+
+  // Indicates support for AVX-512 Doubleword and Quadword instructions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[17] + XCR0[7:5,2:1]
+  // Canonical key: "avx512dq"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ = 1ull << 7,
+
+  // Indicates support for AVX-512 Byte and Word instructions.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):EBX[30] + XCR0[7:5,2:1]
+  // Canonical key: "avx512bw"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW = 1ull << 8,
+
+  // Indicates support for AVX-512 Vector Neural Network instructions.
+  //
+  // VPDPBUSD, VPDPBUSDS, VPDPWSSD, and VPDPWSSDS instructions are implemented.
+  //
+  // Source: CPUID.(EAX=7,ECX=0):ECX[11] + XCR0[7:5,2:1]
+  // Canonical key: "avx512vnni"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI = 1ull << 9,
+
 };
 
 #endif  // IREE_SCHEMAS_CPU_DATA_H_
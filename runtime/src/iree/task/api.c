@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology.h"
 
@@ -75,6 +76,18 @@ IREE_FLAG(
     "detected and used when --task_topology_group_count=0 and is ignored\n"
     "otherwise.\n");
 
+IREE_FLAG(
+    int32_t, task_topology_node_id, -1,
+    "Restricts the workers selected by --task_topology_mode=physical_cores to\n"
+    "the cores attached to the given NUMA node. -1 selects cores from all\n"
+    "nodes.");
+
+IREE_FLAG(
+    bool, task_topology_per_node, false,
+    "Creates one executor per NUMA node with workers pinned to the cores of\n"
+    "that node when using iree_task_executors_create_from_flags. Each node\n"
+    "receives up to --task_topology_max_group_count workers.");
+
 // TODO(benvanik): add --task_topology_dump to dump out the current machine
 // configuration as seen by the topology utilities.
 
@@ -87,8 +100,20 @@ iree_status_t iree_task_topology_initialize_from_flags(
     iree_task_topology_initialize_from_group_count(
         FLAG_task_topology_group_count, out_topology);
   } else if (strcmp(FLAG_task_topology_mode, "physical_cores") == 0) {
-    iree_task_topology_initialize_from_physical_cores(
-        FLAG_task_topology_max_group_count, out_topology);
+    iree_numa_node_id_t node_id = IREE_NUMA_NODE_ID_ANY;
+    if (FLAG_task_topology_node_id >= 0) {
+      if ((iree_host_size_t)FLAG_task_topology_node_id >=
+          iree_numa_node_count()) {
+        return iree_make_status(
+            IREE_STATUS_OUT_OF_RANGE,
+            "--task_topology_node_id=%d out of range; system has %" PRIhsz
+            " NUMA nodes",
+            FLAG_task_topology_node_id, iree_numa_node_count());
+      }
+      node_id = (iree_numa_node_id_t)FLAG_task_topology_node_id;
+    }
+    iree_task_topology_initialize_from_physical_cores_on_node(
+        node_id, FLAG_task_topology_max_group_count, out_topology);
   } else {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
@@ -126,3 +151,70 @@ iree_status_t iree_task_executor_create_from_flags(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+iree_status_t iree_task_executors_create_from_flags(
+    iree_host_size_t executor_capacity, iree_allocator_t host_allocator,
+    iree_host_size_t* out_executor_count,
+    iree_task_executor_t** out_executors) {
+  IREE_ASSERT_ARGUMENT(out_executor_count);
+  IREE_ASSERT_ARGUMENT(!executor_capacity || out_executors);
+  *out_executor_count = 0;
+  if (executor_capacity == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one executor must be requested");
+  }
+
+  // Per-node executors only apply when the workers are being derived from the
+  // machine topology; explicit configurations use a single executor.
+  const iree_host_size_t node_count = iree_numa_node_count();
+  if (!FLAG_task_topology_per_node || node_count <= 1 ||
+      FLAG_task_topology_group_count != 0 ||
+      FLAG_task_topology_node_id >= 0) {
+    IREE_RETURN_IF_ERROR(
+        iree_task_executor_create_from_flags(host_allocator, out_executors));
+    *out_executor_count = 1;
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, node_count);
+
+  iree_task_executor_options_t options;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_executor_options_initialize_from_flags(&options));
+
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t executor_count = 0;
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    if (executor_count >= executor_capacity) break;
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_physical_cores_on_node(
+        (iree_numa_node_id_t)i, FLAG_task_topology_max_group_count, &topology);
+    // Memory-only nodes have no cores and get no executor.
+    if (iree_task_topology_group_count(&topology) > 0) {
+      status = iree_task_executor_create(options, &topology, host_allocator,
+                                         &out_executors[executor_count]);
+      if (iree_status_is_ok(status)) ++executor_count;
+    }
+    iree_task_topology_deinitialize(&topology);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  if (iree_status_is_ok(status) && executor_count == 0) {
+    // No node had any cores we could query (cpuinfo unavailable, etc).
+    status =
+        iree_task_executor_create_from_flags(host_allocator, out_executors);
+    if (iree_status_is_ok(status)) executor_count = 1;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executor_count = executor_count;
+  } else {
+    for (iree_host_size_t i = 0; i < executor_count; ++i) {
+      iree_task_executor_release(out_executors[i]);
+      out_executors[i] = NULL;
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -45,6 +45,20 @@ iree_status_t iree_task_topology_initialize_from_flags(
 iree_status_t iree_task_executor_create_from_flags(
     iree_allocator_t host_allocator, iree_task_executor_t** out_executor);
 
+// Creates one or more task system executors from the current command line
+// flags and returns them in |out_executors|. Up to |executor_capacity|
+// executors will be created and the count returned in |out_executor_count|.
+// Each executor must be released by the caller.
+//
+// When --task_topology_per_node is set on a system with multiple NUMA nodes
+// one executor is created per node (with cores) and its workers are pinned to
+// that node. Otherwise a single executor is created as with
+// iree_task_executor_create_from_flags.
+iree_status_t iree_task_executors_create_from_flags(
+    iree_host_size_t executor_capacity, iree_allocator_t host_allocator,
+    iree_host_size_t* out_executor_count,
+    iree_task_executor_t** out_executors);
+
 //===----------------------------------------------------------------------===//
 // Task system simple invocation utilities
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,165 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "iree/base/api.h"
+#include "iree/task/api.h"
+#include "iree/testing/benchmark.h"
+
+// Describes the cost distribution of the tiles in a benchmarked dispatch.
+typedef struct iree_task_dispatch_benchmark_params_t {
+  // Total number of tiles in the 1D grid.
+  uint32_t tile_count;
+  // Amount of busy work performed by each tile.
+  uint32_t tile_cost;
+  // Every |skew_stride|th tile performs |skew_cost| work instead of
+  // |tile_cost|. 0 disables skewing.
+  uint32_t skew_stride;
+  uint32_t skew_cost;
+  // Tiles at or past |ramp_start| have their cost scaled by their distance
+  // from the start of the ramp, modeling ragged workloads where the last tiles
+  // are the most expensive. 0 disables the ramp.
+  uint32_t ramp_start;
+} iree_task_dispatch_benchmark_params_t;
+
+static iree_status_t iree_task_dispatch_benchmark_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_task_dispatch_benchmark_params_t* params =
+      (const iree_task_dispatch_benchmark_params_t*)user_context;
+  const uint32_t tile_index = tile_context->workgroup_xyz[0];
+  uint32_t cost = params->tile_cost;
+  if (params->skew_stride && (tile_index % params->skew_stride) == 0) {
+    cost = params->skew_cost;
+  }
+  if (params->ramp_start && tile_index >= params->ramp_start) {
+    cost *= 1 + (tile_index - params->ramp_start) * 16 /
+                    (params->tile_count - params->ramp_start);
+  }
+  volatile uint32_t sink = 0;
+  for (uint32_t i = 0; i < cost; ++i) sink += i;
+  return iree_ok_status();
+}
+
+// Runs one dispatch per iteration with the tile cost distribution described by
+// the iree_task_dispatch_benchmark_params_t in user_data.
+static iree_status_t iree_task_dispatch_benchmark_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_task_dispatch_benchmark_params_t* params =
+      (const iree_task_dispatch_benchmark_params_t*)benchmark_def->user_data;
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      options, &topology, benchmark_state->host_allocator, &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("benchmark"), &scope);
+
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {params->tile_count, 1, 1};
+  int64_t iteration_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_dispatch_t dispatch_task;
+    iree_task_dispatch_initialize(
+        &scope,
+        iree_task_make_dispatch_closure(iree_task_dispatch_benchmark_tile,
+                                        (void*)params),
+        workgroup_size, workgroup_count, &dispatch_task);
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch_task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    ++iteration_count;
+  }
+  iree_benchmark_set_items_processed(benchmark_state,
+                                     iteration_count * params->tile_count);
+
+#if IREE_STATISTICS_ENABLE
+  // Report how many tiles were executed per reservation on average; higher is
+  // less contention on the grid and lower is finer-grained balancing.
+  iree_task_dispatch_statistics_t statistics =
+      iree_task_scope_consume_statistics(&scope);
+  int64_t tile_count = iree_atomic_load_int64(&statistics.tile_count,
+                                              iree_memory_order_relaxed);
+  int64_t reservation_count = iree_atomic_load_int64(
+      &statistics.reservation_count, iree_memory_order_relaxed);
+  char label[64];
+  snprintf(label, sizeof(label), "tiles/reservation=%.2f",
+           reservation_count ? (double)tile_count / reservation_count : 0.0);
+  iree_benchmark_set_label(benchmark_state, label);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+  return iree_ok_status();
+}
+
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_uniform_cheap = {
+        .tile_count = 64 * 1024,
+        .tile_cost = 16,
+};
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_uniform_expensive = {
+        .tile_count = 1024,
+        .tile_cost = 64 * 1024,
+};
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_skewed = {
+        .tile_count = 4096,
+        .tile_cost = 256,
+        .skew_stride = 61,
+        .skew_cost = 512 * 1024,
+};
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_ragged_tail = {
+        .tile_count = 4096,
+        .tile_cost = 1024,
+        .ramp_start = 3072,
+};
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_task_dispatch_benchmark_run,
+  };
+  benchmark_def.user_data = &iree_task_dispatch_benchmark_uniform_cheap;
+  iree_benchmark_register(iree_make_cstring_view("dispatch_uniform_cheap"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_task_dispatch_benchmark_uniform_expensive;
+  iree_benchmark_register(iree_make_cstring_view("dispatch_uniform_expensive"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_task_dispatch_benchmark_skewed;
+  iree_benchmark_register(iree_make_cstring_view("dispatch_skewed"),
+                          &benchmark_def);
+  benchmark_def.user_data = &iree_task_dispatch_benchmark_ragged_tail;
+  iree_benchmark_register(iree_make_cstring_view("dispatch_ragged_tail"),
+                          &benchmark_def);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -398,6 +398,10 @@ void iree_task_executor_flush(iree_task_executor_t* executor) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_executor_wake_poller(iree_task_executor_t* executor) {
+  iree_task_poller_wake(&executor->poller);
+}
+
 // Dispatches tasks in the global submission queue to workers.
 // This is called by users upon submission of new tasks or by workers when they
 // run out of tasks to process. If |current_worker| is provided then tasks will
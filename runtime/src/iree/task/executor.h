@@ -366,6 +366,13 @@ void iree_task_executor_submit(iree_task_executor_t* executor,
 // after the flush has occurred but prior to this call returning.
 void iree_task_executor_flush(iree_task_executor_t* executor);
 
+// Wakes the executor wait thread to rescan all pending wait tasks.
+// Must be called after externally setting a wait task cancellation flag in
+// order for the cancellation to take effect promptly.
+//
+// Safe to call from any thread.
+void iree_task_executor_wake_poller(iree_task_executor_t* executor);
+
 // Donates the calling thread to the executor until either |wait_source|
 // resolves or |timeout| is exceeded. Flushes any pending task batches prior
 // to doing any work or waiting.
@@ -0,0 +1,557 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/loop_task.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/tracing.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+
+static void iree_loop_task_scope_emit_error(iree_loop_task_scope_t* scope,
+                                            iree_status_t status);
+
+//===----------------------------------------------------------------------===//
+// iree_loop_task_op_t
+//===----------------------------------------------------------------------===//
+
+// A single loop operation and the tasks used to execute it.
+// All operations issue their user callback from |call_task|, which is made the
+// completion task of any other tasks used by the operation. The operation is
+// freed once all tasks referencing it have been cleaned up.
+struct iree_loop_task_op_t {
+  // Scope the operation was enqueued against. Unowned.
+  iree_loop_task_scope_t* scope;
+  // Number of tasks that reference the operation and have yet to be cleaned up.
+  iree_atomic_ref_count_t ref_count;
+  // Loop command the operation is performing.
+  iree_loop_command_t command;
+  // Scope abort epoch at the time the operation was enqueued. If the scope
+  // epoch differs when the operation is issued it has been aborted.
+  int32_t abort_epoch;
+
+  // User callback. Reset once issued so that it is issued exactly once.
+  iree_loop_callback_t callback;
+
+  // Intrusive links in the scope wait list (WAIT_* commands only).
+  iree_loop_task_op_t* prev;
+  iree_loop_task_op_t* next;
+  // Cancellation flag shared by all wait tasks of the operation.
+  iree_atomic_int32_t cancellation_flag;
+
+  // DISPATCH: workgroup callback issued from each tile.
+  iree_loop_workgroup_fn_t workgroup_fn;
+  // DISPATCH: first failure of any workgroup.
+  iree_atomic_intptr_t workgroup_status;
+
+  // Call issuing the user callback.
+  iree_task_call_t call_task;
+  union {
+    // DISPATCH: grid dispatch of the workgroups.
+    iree_task_dispatch_t dispatch_task;
+    // WAIT_*: delay used to implement the operation deadline, if any.
+    iree_task_wait_t delay_task;
+  };
+  bool has_delay_task;
+
+  // WAIT_ONE/WAIT_ANY/WAIT_ALL: one wait task per wait source.
+  iree_host_size_t wait_count;
+  iree_task_wait_t wait_tasks[];
+};
+
+static bool iree_loop_task_op_is_wait(const iree_loop_task_op_t* op) {
+  return op->command >= IREE_LOOP_COMMAND_WAIT_UNTIL &&
+         op->command <= IREE_LOOP_COMMAND_WAIT_ALL;
+}
+
+static bool iree_loop_task_op_is_aborted(const iree_loop_task_op_t* op) {
+  return iree_atomic_load_int32(&op->scope->abort_epoch,
+                                iree_memory_order_acquire) != op->abort_epoch;
+}
+
+// Releases a reference to |op| and frees it if it was the last.
+static void iree_loop_task_op_release(iree_loop_task_op_t* op) {
+  if (iree_atomic_ref_count_dec(&op->ref_count) != 1) return;
+  iree_loop_task_scope_t* scope = op->scope;
+
+  if (iree_loop_task_op_is_wait(op)) {
+    iree_slim_mutex_lock(&scope->mutex);
+    if (op->prev) {
+      op->prev->next = op->next;
+    } else {
+      scope->wait_list_head = op->next;
+    }
+    if (op->next) op->next->prev = op->prev;
+    iree_slim_mutex_unlock(&scope->mutex);
+  }
+
+  // Workgroup failures are dropped if the operation was aborted.
+  iree_status_ignore((iree_status_t)iree_atomic_exchange_intptr(
+      &op->workgroup_status, 0, iree_memory_order_acquire));
+
+  iree_allocator_free(scope->allocator, op);
+
+  // NOTE: the scope may be deinitialized as soon as this returns.
+  iree_task_scope_end(&scope->task_scope);
+}
+
+// Issues the user callback of |op| with |status| (ownership transferred).
+// Errors returned from callbacks of aborted operations are ignored.
+static void iree_loop_task_op_issue(iree_loop_task_op_t* op, iree_loop_t loop,
+                                    iree_status_t status) {
+  iree_loop_callback_t callback = op->callback;
+  op->callback.fn = NULL;
+  const bool is_aborted = iree_status_is_aborted(status);
+  iree_status_t callback_status = callback.fn(callback.user_data, loop, status);
+  if (is_aborted) {
+    iree_status_ignore(callback_status);
+  } else if (!iree_status_is_ok(callback_status)) {
+    iree_loop_task_scope_emit_error(op->scope, callback_status);
+  }
+}
+
+// Returns OK if any wait source of |op| has resolved, the failure of the first
+// that failed, or IREE_STATUS_DEADLINE_EXCEEDED if none have resolved.
+static iree_status_t iree_loop_task_op_query_any(iree_loop_task_op_t* op) {
+  for (iree_host_size_t i = 0; i < op->wait_count; ++i) {
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    IREE_RETURN_IF_ERROR(iree_wait_source_query(op->wait_tasks[i].wait_source,
+                                                &wait_status_code));
+    if (wait_status_code == IREE_STATUS_OK) {
+      return iree_ok_status();
+    } else if (wait_status_code != IREE_STATUS_DEFERRED) {
+      return iree_status_from_code(wait_status_code);
+    }
+  }
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+// Returns OK if all wait sources of |op| have resolved, the failure of the
+// first that failed, or IREE_STATUS_DEADLINE_EXCEEDED if any are unresolved.
+static iree_status_t iree_loop_task_op_query_all(iree_loop_task_op_t* op) {
+  for (iree_host_size_t i = 0; i < op->wait_count; ++i) {
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    IREE_RETURN_IF_ERROR(iree_wait_source_query(op->wait_tasks[i].wait_source,
+                                                &wait_status_code));
+    if (wait_status_code == IREE_STATUS_DEFERRED) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    } else if (wait_status_code != IREE_STATUS_OK) {
+      return iree_status_from_code(wait_status_code);
+    }
+  }
+  return iree_ok_status();
+}
+
+// iree_task_call_closure_fn_t issuing the operation callback once all other
+// tasks in the operation have completed.
+static iree_status_t iree_loop_task_op_call(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_loop_task_op_t* op = (iree_loop_task_op_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (op->has_delay_task && op->command == IREE_LOOP_COMMAND_WAIT_ALL) {
+    // The delay does not gate wait-all completion and may still be pending in
+    // the poller; cancel it so it retires (and releases the op) promptly.
+    iree_atomic_store_int32(&op->cancellation_flag, 1,
+                            iree_memory_order_release);
+    iree_task_executor_wake_poller(op->scope->executor);
+  }
+
+  if (iree_loop_task_op_is_aborted(op)) {
+    iree_loop_task_op_issue(op, iree_loop_null(),
+                            iree_make_status(IREE_STATUS_ABORTED));
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  iree_status_t status = iree_ok_status();
+  switch (op->command) {
+    case IREE_LOOP_COMMAND_DISPATCH:
+      status = (iree_status_t)iree_atomic_exchange_intptr(
+          &op->workgroup_status, 0, iree_memory_order_acquire);
+      break;
+    case IREE_LOOP_COMMAND_WAIT_ONE:
+    case IREE_LOOP_COMMAND_WAIT_ANY:
+      status = iree_loop_task_op_query_any(op);
+      break;
+    case IREE_LOOP_COMMAND_WAIT_ALL:
+      status = iree_loop_task_op_query_all(op);
+      break;
+    default:
+      break;
+  }
+  iree_loop_task_op_issue(op, iree_loop_task_scope(op->scope), status);
+
+  // Errors are routed to the scope and never to the task system: a failed call
+  // task would fail the task scope and abort all future operations.
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Cleanup of the call task. If the call was discarded because the task scope
+// failed (such as from a system wait error) the callback is issued here.
+static void iree_loop_task_op_call_cleanup(iree_task_t* task,
+                                           iree_status_code_t status_code) {
+  iree_loop_task_op_t* op =
+      (iree_loop_task_op_t*)((uint8_t*)task -
+                             offsetof(iree_loop_task_op_t, call_task));
+  if (op->callback.fn) {
+    iree_loop_task_scope_t* scope = op->scope;
+    if (iree_task_scope_has_failed(&scope->task_scope)) {
+      iree_loop_task_scope_emit_error(
+          scope, iree_task_scope_consume_status(&scope->task_scope));
+    }
+    iree_loop_task_op_issue(op, iree_loop_null(),
+                            iree_make_status(IREE_STATUS_ABORTED));
+  }
+  iree_loop_task_op_release(op);
+}
+
+// Cleanup of the delay task. The delay holds its own reference to the op as
+// it does not always gate the call task.
+static void iree_loop_task_op_delay_cleanup(iree_task_t* task,
+                                            iree_status_code_t status_code) {
+  iree_loop_task_op_t* op =
+      (iree_loop_task_op_t*)((uint8_t*)task -
+                             offsetof(iree_loop_task_op_t, delay_task));
+  iree_loop_task_op_release(op);
+}
+
+// iree_task_dispatch_closure_fn_t issuing a single loop workgroup.
+static iree_status_t iree_loop_task_op_workgroup(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  iree_loop_task_op_t* op = (iree_loop_task_op_t*)user_context;
+
+  // Skip the remaining workgroups after any has failed or the scope aborted.
+  if (iree_atomic_load_intptr(&op->workgroup_status,
+                              iree_memory_order_acquire) != 0 ||
+      iree_loop_task_op_is_aborted(op)) {
+    return iree_ok_status();
+  }
+
+  iree_status_t status = op->workgroup_fn(
+      op->callback.user_data, iree_loop_task_scope(op->scope),
+      tile_context->workgroup_xyz[0], tile_context->workgroup_xyz[1],
+      tile_context->workgroup_xyz[2]);
+  if (!iree_status_is_ok(status)) {
+    // Keep the first failure only. As with call tasks the failure is routed to
+    // the completion callback instead of the task system.
+    intptr_t expected = 0;
+    if (!iree_atomic_compare_exchange_strong_intptr(
+            &op->workgroup_status, &expected, (intptr_t)status,
+            iree_memory_order_acq_rel, iree_memory_order_relaxed)) {
+      iree_status_ignore(status);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Allocates a new operation in |scope| with storage for |wait_count| waits.
+static iree_status_t iree_loop_task_op_allocate(
+    iree_loop_task_scope_t* scope, iree_loop_command_t command,
+    iree_loop_callback_t callback, iree_host_size_t wait_count,
+    iree_loop_task_op_t** out_op) {
+  *out_op = NULL;
+  iree_host_size_t total_size =
+      sizeof(iree_loop_task_op_t) + wait_count * sizeof(iree_task_wait_t);
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(scope->allocator, total_size, (void**)&op));
+  memset(op, 0, sizeof(*op));
+  op->scope = scope;
+  iree_atomic_ref_count_init(&op->ref_count);
+  op->command = command;
+  op->abort_epoch =
+      iree_atomic_load_int32(&scope->abort_epoch, iree_memory_order_acquire);
+  op->callback = callback;
+  op->wait_count = wait_count;
+
+  iree_task_call_initialize(
+      &scope->task_scope,
+      iree_task_make_call_closure(iree_loop_task_op_call, op), &op->call_task);
+  iree_task_set_cleanup_fn(&op->call_task.header,
+                           iree_loop_task_op_call_cleanup);
+
+  // Keeps the scope from going idle until the op is freed.
+  iree_task_scope_begin(&scope->task_scope);
+
+  *out_op = op;
+  return iree_ok_status();
+}
+
+// Initializes the wait tasks of |op| on |wait_sources|.
+// If |wait_any| is true the first wait to resolve cancels all others and
+// otherwise all must resolve before the call task is issued. The |deadline_ns|
+// is implemented with a delay task that cancels the waits when reached.
+static void iree_loop_task_op_initialize_waits(
+    iree_loop_task_op_t* op, const iree_wait_source_t* wait_sources,
+    iree_time_t deadline_ns, bool wait_any) {
+  iree_loop_task_scope_t* scope = op->scope;
+
+  // Waits never fail with a deadline: that would fail the whole task scope.
+  for (iree_host_size_t i = 0; i < op->wait_count; ++i) {
+    iree_task_wait_t* wait_task = &op->wait_tasks[i];
+    iree_task_wait_initialize(&scope->task_scope, wait_sources[i],
+                              IREE_TIME_INFINITE_FUTURE, wait_task);
+    if (wait_any) {
+      iree_task_wait_set_wait_any(wait_task, &op->cancellation_flag);
+    } else {
+      wait_task->cancellation_flag = &op->cancellation_flag;
+    }
+    iree_task_set_completion_task(&wait_task->header, &op->call_task.header);
+  }
+
+  // The delay cancels all waits when reached. For wait-all the call task only
+  // waits on the wait tasks so that it can be issued as soon as they resolve.
+  if (op->command == IREE_LOOP_COMMAND_WAIT_UNTIL ||
+      deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+    op->has_delay_task = true;
+    iree_task_wait_initialize_delay(&scope->task_scope, deadline_ns,
+                                    &op->delay_task);
+    iree_task_wait_set_wait_any(&op->delay_task, &op->cancellation_flag);
+    iree_task_set_cleanup_fn(&op->delay_task.header,
+                             iree_loop_task_op_delay_cleanup);
+    iree_atomic_ref_count_inc(&op->ref_count);
+    if (wait_any) {
+      iree_task_set_completion_task(&op->delay_task.header,
+                                    &op->call_task.header);
+    }
+  }
+
+  // Track the op so that it can be cancelled if the scope is aborted. If the
+  // scope was aborted since the op was allocated we cancel it immediately.
+  iree_slim_mutex_lock(&scope->mutex);
+  op->next = scope->wait_list_head;
+  if (op->next) op->next->prev = op;
+  scope->wait_list_head = op;
+  iree_slim_mutex_unlock(&scope->mutex);
+  if (iree_loop_task_op_is_aborted(op)) {
+    iree_atomic_store_int32(&op->cancellation_flag, 1,
+                            iree_memory_order_release);
+  }
+}
+
+// Submits all root tasks of |op| to the executor.
+// |op| may be freed before this returns.
+static void iree_loop_task_op_submit(iree_loop_task_op_t* op) {
+  iree_task_executor_t* executor = op->scope->executor;
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  if (op->command == IREE_LOOP_COMMAND_DISPATCH) {
+    iree_task_submission_enqueue(&submission, &op->dispatch_task.header);
+  } else if (iree_loop_task_op_is_wait(op)) {
+    for (iree_host_size_t i = 0; i < op->wait_count; ++i) {
+      iree_task_submission_enqueue(&submission, &op->wait_tasks[i].header);
+    }
+    if (op->has_delay_task) {
+      iree_task_submission_enqueue(&submission, &op->delay_task.header);
+    }
+  }
+  if (iree_task_is_ready(&op->call_task.header)) {
+    iree_task_submission_enqueue(&submission, &op->call_task.header);
+  }
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+}
+
+//===----------------------------------------------------------------------===//
+// Loop commands
+//===----------------------------------------------------------------------===//
+
+// IREE_LOOP_COMMAND_CALL
+static iree_status_t iree_loop_task_run_call(
+    iree_loop_task_scope_t* scope, const iree_loop_call_params_t* params) {
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(iree_loop_task_op_allocate(
+      scope, IREE_LOOP_COMMAND_CALL, params->callback, 0, &op));
+  iree_loop_task_op_submit(op);
+  return iree_ok_status();
+}
+
+// IREE_LOOP_COMMAND_DISPATCH
+static iree_status_t iree_loop_task_run_dispatch(
+    iree_loop_task_scope_t* scope, const iree_loop_dispatch_params_t* params) {
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(iree_loop_task_op_allocate(
+      scope, IREE_LOOP_COMMAND_DISPATCH, params->callback, 0, &op));
+  op->workgroup_fn = params->workgroup_fn;
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  iree_task_dispatch_initialize(
+      &scope->task_scope,
+      iree_task_make_dispatch_closure(iree_loop_task_op_workgroup, op),
+      workgroup_size, params->workgroup_count_xyz, &op->dispatch_task);
+  iree_task_set_completion_task(&op->dispatch_task.header,
+                                &op->call_task.header);
+  iree_loop_task_op_submit(op);
+  return iree_ok_status();
+}
+
+// IREE_LOOP_COMMAND_WAIT_UNTIL
+static iree_status_t iree_loop_task_run_wait_until(
+    iree_loop_task_scope_t* scope,
+    const iree_loop_wait_until_params_t* params) {
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(iree_loop_task_op_allocate(
+      scope, IREE_LOOP_COMMAND_WAIT_UNTIL, params->callback, 0, &op));
+  iree_loop_task_op_initialize_waits(op, NULL, params->deadline_ns,
+                                     /*wait_any=*/true);
+  iree_loop_task_op_submit(op);
+  return iree_ok_status();
+}
+
+// IREE_LOOP_COMMAND_WAIT_ONE
+static iree_status_t iree_loop_task_run_wait_one(
+    iree_loop_task_scope_t* scope, const iree_loop_wait_one_params_t* params) {
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(iree_loop_task_op_allocate(
+      scope, IREE_LOOP_COMMAND_WAIT_ONE, params->callback, 1, &op));
+  iree_loop_task_op_initialize_waits(op, &params->wait_source,
+                                     params->deadline_ns, /*wait_any=*/true);
+  iree_loop_task_op_submit(op);
+  return iree_ok_status();
+}
+
+// IREE_LOOP_COMMAND_WAIT_ANY / IREE_LOOP_COMMAND_WAIT_ALL
+static iree_status_t iree_loop_task_run_wait_multi(
+    iree_loop_task_scope_t* scope, iree_loop_command_t command,
+    const iree_loop_wait_multi_params_t* params) {
+  iree_loop_task_op_t* op = NULL;
+  IREE_RETURN_IF_ERROR(iree_loop_task_op_allocate(
+      scope, command, params->callback, params->count, &op));
+  iree_loop_task_op_initialize_waits(
+      op, params->wait_sources, params->deadline_ns,
+      /*wait_any=*/command == IREE_LOOP_COMMAND_WAIT_ANY);
+  iree_loop_task_op_submit(op);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_loop_task_scope_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_loop_task_scope_initialize(
+    iree_task_executor_t* executor, iree_loop_task_error_fn_t error_fn,
+    void* error_user_data, iree_allocator_t allocator,
+    iree_loop_task_scope_t* out_scope) {
+  IREE_ASSERT_ARGUMENT(executor);
+  IREE_ASSERT_ARGUMENT(out_scope);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  memset(out_scope, 0, sizeof(*out_scope));
+  out_scope->executor = executor;
+  iree_task_executor_retain(executor);
+  out_scope->allocator = allocator;
+  iree_task_scope_initialize(iree_make_cstring_view("loop"),
+                             &out_scope->task_scope);
+  iree_slim_mutex_initialize(&out_scope->mutex);
+  out_scope->error_fn = error_fn;
+  out_scope->error_user_data = error_user_data;
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Aborts all operations currently pending in |scope|.
+// Pending calls and dispatches will issue their callbacks with
+// IREE_STATUS_ABORTED when they are reached and pending waits are cancelled.
+static void iree_loop_task_scope_abort(iree_loop_task_scope_t* scope) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_atomic_fetch_add_int32(&scope->abort_epoch, 1,
+                              iree_memory_order_acq_rel);
+
+  iree_slim_mutex_lock(&scope->mutex);
+  for (iree_loop_task_op_t* op = scope->wait_list_head; op != NULL;
+       op = op->next) {
+    iree_atomic_store_int32(&op->cancellation_flag, 1,
+                            iree_memory_order_release);
+  }
+  iree_slim_mutex_unlock(&scope->mutex);
+  iree_task_executor_wake_poller(scope->executor);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Emits |status| to the |scope| error handler and aborts pending operations.
+static void iree_loop_task_scope_emit_error(iree_loop_task_scope_t* scope,
+                                            iree_status_t status) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(
+      z0, iree_status_code_string(iree_status_code(status)));
+
+  if (scope->error_fn) {
+    scope->error_fn(scope->error_user_data, status);
+  } else {
+    iree_status_ignore(status);
+  }
+
+  iree_loop_task_scope_abort(scope);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_loop_task_scope_deinitialize(
+    iree_loop_task_scope_t* scope) {
+  IREE_ASSERT_ARGUMENT(scope);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Abort and wait for all callbacks to be issued and the tasks to retire.
+  iree_loop_task_scope_abort(scope);
+  iree_status_ignore(iree_task_scope_wait_idle(&scope->task_scope,
+                                               IREE_TIME_INFINITE_FUTURE));
+
+  iree_task_scope_deinitialize(&scope->task_scope);
+  iree_slim_mutex_deinitialize(&scope->mutex);
+  iree_task_executor_release(scope->executor);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_status_t iree_loop_task_scope_wait_idle(
+    iree_loop_task_scope_t* scope, iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(scope);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_task_scope_wait_idle(
+      &scope->task_scope, iree_timeout_as_deadline_ns(timeout));
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_loop_task_ctl(void* self,
+                                                 iree_loop_command_t command,
+                                                 const void* params,
+                                                 void** inout_ptr) {
+  IREE_ASSERT_ARGUMENT(self);
+  iree_loop_task_scope_t* scope = (iree_loop_task_scope_t*)self;
+  switch (command) {
+    case IREE_LOOP_COMMAND_CALL:
+      return iree_loop_task_run_call(scope,
+                                     (const iree_loop_call_params_t*)params);
+    case IREE_LOOP_COMMAND_DISPATCH:
+      return iree_loop_task_run_dispatch(
+          scope, (const iree_loop_dispatch_params_t*)params);
+    case IREE_LOOP_COMMAND_WAIT_UNTIL:
+      return iree_loop_task_run_wait_until(
+          scope, (const iree_loop_wait_until_params_t*)params);
+    case IREE_LOOP_COMMAND_WAIT_ONE:
+      return iree_loop_task_run_wait_one(
+          scope, (const iree_loop_wait_one_params_t*)params);
+    case IREE_LOOP_COMMAND_WAIT_ANY:
+    case IREE_LOOP_COMMAND_WAIT_ALL:
+      return iree_loop_task_run_wait_multi(
+          scope, command, (const iree_loop_wait_multi_params_t*)params);
+    case IREE_LOOP_COMMAND_DRAIN:
+      return iree_loop_task_scope_wait_idle(
+          scope, iree_make_deadline(
+                     ((const iree_loop_drain_params_t*)params)->deadline_ns));
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unimplemented loop command");
+  }
+}
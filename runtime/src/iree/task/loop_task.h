@@ -0,0 +1,114 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TASK_LOOP_TASK_H_
+#define IREE_TASK_LOOP_TASK_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_loop_task_scope_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_loop_task_op_t iree_loop_task_op_t;
+
+// Handles scope errors returned from loop callback operations.
+// Ownership of |status| is passed to the handler and must be freed.
+// All operations pending in the same scope at the time of the error will be
+// aborted.
+typedef void(IREE_API_PTR* iree_loop_task_error_fn_t)(void* user_data,
+                                                      iree_status_t status);
+
+// A scope of execution within a loop backed by a task executor.
+// Operations are mapped onto the task system and may run concurrently:
+//  - calls become iree_task_call_t tasks executed on any worker
+//  - grid dispatches become iree_task_dispatch_t tasks with each workgroup
+//    issued from a dispatch tile on any worker
+//  - waits become iree_task_wait_t tasks serviced by the executor poller such
+//    that no worker blocks while the wait is pending
+//
+// Callbacks are issued from worker threads and may run concurrently with each
+// other; users needing ordering must sequence their operations themselves.
+// Each scope has a dedicated error handler that is notified when an error
+// propagates from a loop operation scheduled against the scope. When an error
+// arises all other operations pending in the same scope are aborted. Failures
+// of the wait system itself are unrecoverable and abort all future operations
+// in the scope.
+//
+// Thread-safe: operations may be enqueued from any thread.
+typedef struct iree_loop_task_scope_t {
+  // Executor all operations are scheduled on. Retained.
+  iree_task_executor_t* executor;
+  // Allocator used for per-operation storage.
+  iree_allocator_t allocator;
+
+  // Task scope all operation tasks are attributed to. Each operation holds a
+  // scope reference from when it is enqueued until all of its tasks have
+  // retired so that waiting for the task scope to go idle drains the loop.
+  iree_task_scope_t task_scope;
+
+  // Incremented each time an error aborts the scope. Operations enqueued under
+  // a prior epoch are issued with IREE_STATUS_ABORTED.
+  iree_atomic_int32_t abort_epoch;
+
+  // Guards |wait_list_head|.
+  iree_slim_mutex_t mutex;
+  // Intrusive list of wait operations that may be pending in the poller and
+  // need to be cancelled when the scope is aborted.
+  iree_loop_task_op_t* wait_list_head;
+
+  // Optional function used to report errors that occur during execution.
+  iree_loop_task_error_fn_t error_fn;
+  void* error_user_data;
+} iree_loop_task_scope_t;
+
+// Initializes a loop scope that runs operations on |executor|.
+// |allocator| is used for transient per-operation storage.
+IREE_API_EXPORT void iree_loop_task_scope_initialize(
+    iree_task_executor_t* executor, iree_loop_task_error_fn_t error_fn,
+    void* error_user_data, iree_allocator_t allocator,
+    iree_loop_task_scope_t* out_scope);
+
+// Deinitializes a loop |scope|, aborting any pending operations and waiting
+// for their callbacks to be issued.
+IREE_API_EXPORT void iree_loop_task_scope_deinitialize(
+    iree_loop_task_scope_t* scope);
+
+// Waits until all operations in |scope| have retired or |timeout| is reached.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if the timeout is reached first.
+// Must not be called from a loop callback of the same scope.
+IREE_API_EXPORT iree_status_t iree_loop_task_scope_wait_idle(
+    iree_loop_task_scope_t* scope, iree_timeout_t timeout);
+
+IREE_API_EXPORT iree_status_t iree_loop_task_ctl(void* self,
+                                                 iree_loop_command_t command,
+                                                 const void* params,
+                                                 void** inout_ptr);
+
+// Returns a loop that schedules operations against |scope|.
+// The scope must remain valid until all operations scheduled against it have
+// completed.
+static inline iree_loop_t iree_loop_task_scope(iree_loop_task_scope_t* scope) {
+  iree_loop_t loop = {
+      scope,
+      iree_loop_task_ctl,
+  };
+  return loop;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_TASK_LOOP_TASK_H_
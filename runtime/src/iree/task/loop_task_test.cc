@@ -0,0 +1,95 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/loop_task.h"
+
+#include "iree/base/api.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+// Contains the test definitions applied to all loop implementations:
+#include "iree/base/loop_test.h"
+
+void AllocateLoop(iree_status_t* out_status, iree_allocator_t allocator,
+                  iree_loop_t* out_loop) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(
+      iree_task_executor_create(options, &topology, allocator, &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_loop_task_scope_t* scope = NULL;
+  IREE_CHECK_OK(
+      iree_allocator_malloc(allocator, sizeof(*scope), (void**)&scope));
+  iree_loop_task_scope_initialize(
+      executor,
+      +[](void* user_data, iree_status_t status) {
+        iree_status_t* status_ptr = (iree_status_t*)user_data;
+        if (iree_status_is_ok(*status_ptr)) {
+          *status_ptr = status;
+        } else {
+          iree_status_ignore(status);
+        }
+      },
+      out_status, allocator, scope);
+  iree_task_executor_release(executor);
+  *out_loop = iree_loop_task_scope(scope);
+}
+
+void FreeLoop(iree_allocator_t allocator, iree_loop_t loop) {
+  iree_loop_task_scope_t* scope = (iree_loop_task_scope_t*)loop.self;
+  iree_loop_task_scope_deinitialize(scope);
+  iree_allocator_free(allocator, scope);
+}
+
+namespace iree {
+namespace testing {
+
+// Tests that workgroups of a dispatch run concurrently across workers by having
+// each workgroup block until all have started. A serial loop would deadlock.
+TEST_F(LoopTest, DispatchConcurrent) {
+  IREE_TRACE_SCOPE();
+  struct UserData {
+    std::atomic<int> started_count = {0};
+    bool completed = false;
+  } user_data;
+  const uint32_t xyz[3] = {2, 1, 1};
+  IREE_ASSERT_OK(iree_loop_dispatch(
+      loop, xyz,
+      +[](void* user_data_ptr, iree_loop_t loop, uint32_t workgroup_x,
+          uint32_t workgroup_y, uint32_t workgroup_z) {
+        IREE_TRACE_SCOPE();
+        auto* user_data = reinterpret_cast<UserData*>(user_data_ptr);
+        ++user_data->started_count;
+        iree_time_t deadline_ns = iree_time_now() + 5000 * 1000000ll;
+        while (user_data->started_count < 2 && iree_time_now() < deadline_ns) {
+          std::this_thread::yield();
+        }
+        return user_data->started_count == 2
+                   ? iree_ok_status()
+                   : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      },
+      +[](void* user_data_ptr, iree_loop_t loop, iree_status_t status) {
+        IREE_TRACE_SCOPE();
+        IREE_EXPECT_OK(status);
+        iree_status_ignore(status);
+        auto* user_data = reinterpret_cast<UserData*>(user_data_ptr);
+        user_data->completed = true;
+        return iree_ok_status();
+      },
+      &user_data));
+  IREE_ASSERT_OK(iree_loop_drain(loop, iree_infinite_timeout()));
+  IREE_ASSERT_OK(loop_status);
+  EXPECT_TRUE(user_data.completed);
+}
+
+}  // namespace testing
+}  // namespace iree
@@ -170,6 +170,10 @@ void iree_task_poller_enqueue(iree_task_poller_t* poller,
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_poller_wake(iree_task_poller_t* poller) {
+  iree_event_set(&poller->wake_event);
+}
+
 // Acquires a wait handle for |task| and inserts it into |wait_set|.
 static iree_status_t iree_task_poller_insert_wait_handle(
     iree_wait_set_t* wait_set, iree_task_wait_t* task) {
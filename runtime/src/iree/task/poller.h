@@ -139,6 +139,14 @@ void iree_task_poller_deinitialize(iree_task_poller_t* poller);
 void iree_task_poller_enqueue(iree_task_poller_t* poller,
                               iree_task_list_t* wait_tasks);
 
+// Kicks the wait thread so that it rescans all wait tasks it is managing.
+// Cancellation flags are only checked during scans and setting one from outside
+// of the poller must be followed by a wake for the cancellation to be observed
+// before the wait would have otherwise resolved or timed out.
+//
+// May be called from any thread.
+void iree_task_poller_wake(iree_task_poller_t* poller);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
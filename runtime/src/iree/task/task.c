@@ -516,7 +516,20 @@ static uint32_t iree_task_tile_to_color(
 void iree_task_dispatch_statistics_merge(
     const iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target) {
-  // TODO(benvanik): statistics.
+#if IREE_STATISTICS_ENABLE
+  iree_task_dispatch_statistics_t* mutable_source =
+      (iree_task_dispatch_statistics_t*)source;
+  iree_atomic_fetch_add_int64(
+      &target->tile_count,
+      iree_atomic_load_int64(&mutable_source->tile_count,
+                             iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(
+      &target->reservation_count,
+      iree_atomic_load_int64(&mutable_source->reservation_count,
+                             iree_memory_order_relaxed),
+      iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 //==============================================================================
@@ -606,16 +619,19 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   iree_host_size_t shard_count =
       iree_min(dispatch_task->tile_count, worker_count);
 
-  // Compute how many tiles we want each shard to reserve at a time from the
-  // larger grid. A higher number reduces overhead and improves locality while
-  // a lower number reduces maximum worst-case latency (coarser work stealing).
+  dispatch_task->shard_count = (uint32_t)shard_count;
+
+  // Compute how many tiles we want each shard to initially reserve at a time
+  // from the larger grid. A higher number reduces overhead and improves
+  // locality while a lower number reduces maximum worst-case latency (coarser
+  // work stealing). Shards adapt this as they execute.
   if (dispatch_task->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
+      worker_count * IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION) {
     // Grid is small - allow it to be eagerly sliced up.
     dispatch_task->tiles_per_reservation = 1;
   } else {
     dispatch_task->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+        IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION;
   }
 
   // Randomize starting worker.
@@ -707,6 +723,55 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
+// Returns the number of tiles a shard should reserve from the grid next given
+// its current |shard_reservation_limit|.
+//
+// This is guided self-scheduling: each reservation takes at most
+// 1/(shard_count * IREE_TASK_DISPATCH_GUIDED_RESERVATION_DIVISOR) of the tiles
+// remaining such that as the grid drains the reservations shrink and the last
+// tiles are spread across all shards. The remaining count is sampled with a
+// relaxed load and may be stale by the time the reservation is made; that only
+// affects how evenly the tail is balanced and never correctness.
+static uint32_t iree_task_dispatch_select_reservation_size(
+    iree_task_dispatch_t* dispatch_task, uint32_t shard_reservation_limit) {
+  if (shard_reservation_limit <= 1) return 1;
+  const uint32_t tile_index = (uint32_t)iree_atomic_load_int32(
+      &dispatch_task->tile_index, iree_memory_order_relaxed);
+  if (tile_index >= dispatch_task->tile_count) return 1;
+  const uint32_t remaining_tiles = dispatch_task->tile_count - tile_index;
+  const uint32_t guided_size =
+      remaining_tiles / (dispatch_task->shard_count *
+                         IREE_TASK_DISPATCH_GUIDED_RESERVATION_DIVISOR);
+  return iree_max(1u, iree_min(shard_reservation_limit, guided_size));
+}
+
+#if IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+
+// Returns an updated reservation limit for a shard that just executed
+// |tile_count| tiles in |duration_ns|. Reservations of cheap tiles grow to
+// reduce contention on the shared tile index and reservations of expensive
+// tiles shrink so that other shards can pick up the work sooner.
+static uint32_t iree_task_dispatch_adapt_reservation_limit(
+    uint32_t shard_reservation_limit, uint32_t tile_count,
+    iree_duration_t duration_ns) {
+  // Predict how long a full reservation at the current limit would take based
+  // on the per-tile cost of the last reservation (which may have been smaller
+  // due to guided sizing or the end of the grid).
+  const uint64_t predicted_ns =
+      (uint64_t)iree_max(duration_ns, 0) * shard_reservation_limit;
+  const uint64_t target_ns =
+      (uint64_t)tile_count * IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS;
+  if (predicted_ns < target_ns / 2) {
+    return iree_min(shard_reservation_limit * 2,
+                    IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION);
+  } else if (predicted_ns > target_ns * 2) {
+    return iree_max(shard_reservation_limit / 2, 1u);
+  }
+  return shard_reservation_limit;
+}
+
+#endif  // IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+
 void iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_cpu_processor_id_t processor_id,
     uint32_t worker_id, iree_byte_span_t worker_local_memory,
@@ -759,16 +824,26 @@ void iree_task_dispatch_shard_execute(
   tile_context.processor_id = processor_id;
 
   // Loop over all tiles until they are all processed.
+  // Each shard sizes its reservations independently: the shard limit adapts to
+  // the observed cost of the tiles it has executed and the guided sizing
+  // shrinks reservations as the grid drains (see tuning.h).
   const uint32_t tile_count = dispatch_task->tile_count;
-  const uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
+  uint32_t shard_reservation_limit = dispatch_task->tiles_per_reservation;
+  uint64_t shard_tile_count = 0;
+  uint64_t shard_reservation_count = 0;
+  uint32_t tile_reservation = iree_task_dispatch_select_reservation_size(
+      dispatch_task, shard_reservation_limit);
   // relaxed order because we only care about atomic increments, not about
   // ordering of tile_index accesses w.r.t. other memory accesses.
   uint32_t tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                                   tiles_per_reservation,
+                                                   tile_reservation,
                                                    iree_memory_order_relaxed);
   while (tile_base < tile_count) {
     const uint32_t tile_range =
-        iree_min(tile_base + tiles_per_reservation, tile_count);
+        iree_min(tile_base + tile_reservation, tile_count);
+#if IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+    const iree_time_t reservation_start_ns = iree_time_now();
+#endif  // IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
     for (uint32_t tile_index = tile_base; tile_index < tile_range;
          ++tile_index) {
       // TODO(benvanik): faster math here, especially knowing we pull off N
@@ -810,13 +885,35 @@ void iree_task_dispatch_shard_execute(
       }
     }
 
+    shard_tile_count += tile_range - tile_base;
+    ++shard_reservation_count;
+
+#if IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+    // Adapt the reservation size to the cost of the tiles just executed.
+    shard_reservation_limit = iree_task_dispatch_adapt_reservation_limit(
+        shard_reservation_limit, tile_range - tile_base,
+        iree_time_now() - reservation_start_ns);
+#endif  // IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+
     // Try to grab the next slice of tiles.
+    tile_reservation = iree_task_dispatch_select_reservation_size(
+        dispatch_task, shard_reservation_limit);
     tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                            tiles_per_reservation,
+                                            tile_reservation,
                                             iree_memory_order_relaxed);
   }
 abort_shard:
 
+#if IREE_STATISTICS_ENABLE
+  iree_atomic_store_int64(&shard_statistics.tile_count, shard_tile_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&shard_statistics.reservation_count,
+                          shard_reservation_count, iree_memory_order_relaxed);
+#else
+  (void)shard_tile_count;
+  (void)shard_reservation_count;
+#endif  // IREE_STATISTICS_ENABLE
+
   // Push aggregate statistics up to the dispatch.
   // Note that we may have partial information here if we errored out of the
   // loop but that's still useful to know.
@@ -496,6 +496,13 @@ typedef struct iree_task_dispatch_statistics_t {
   // NOTE: each of these increases the command buffer storage requirements; we
   // should always guard these with IREE_STATISTICS_ENABLE.
   iree_atomic_int32_t reserved;
+#if IREE_STATISTICS_ENABLE
+  // Total number of tiles executed.
+  iree_atomic_int64_t tile_count;
+  // Total number of tile reservations made from dispatch grids. The ratio of
+  // tiles to reservations indicates how often shards contended on the grid.
+  iree_atomic_int64_t reservation_count;
+#endif  // IREE_STATISTICS_ENABLE
 } iree_task_dispatch_statistics_t;
 
 // Merges statistics from |source| to |target| atomically per-field.
@@ -641,11 +648,16 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // The total number of tiles in the dispatch bounding tile_index.
   uint32_t tile_count;
 
-  // Maximum number of tiles to fetch per tile reservation from the grid.
-  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
-  // reasonable number chosen based on the tile and shard counts.
+  // Initial number of tiles to fetch per tile reservation from the grid.
+  // Shards adapt their reservations within the range of 1 to
+  // IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION based on the observed
+  // tile costs and the number of tiles remaining.
   uint32_t tiles_per_reservation;
 
+  // Total number of shards the dispatch was split into; used to size guided
+  // reservations as the grid drains.
+  uint32_t shard_count;
+
   // The tail tile index; the next reservation will start from here.
   // This is used by shards to slice off the work to perform in their inner
   // loop. Ideally we'd have no destructive interference with other shared data
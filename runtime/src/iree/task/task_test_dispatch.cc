@@ -113,6 +113,64 @@ TEST_F(TaskDispatchTest, Issue345) {
   DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
 }
 
+// Large enough for shards to adapt their reservation sizes over the grid.
+TEST_F(TaskDispatchTest, IssueLarge) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {1000, 7, 3};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+// Tiles with wildly varying costs to exercise reservation shrinking.
+TEST_F(TaskDispatchTest, IssueSkewed) {
+  IREE_TRACE_SCOPE();
+  static const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  static const uint32_t kWorkgroupCount[3] = {4096, 1, 1};
+  GridCoverage coverage(kWorkgroupCount);
+  struct SkewedState {
+    GridCoverage* coverage;
+    iree_atomic_int32_t sink;
+  } state = {&coverage, IREE_ATOMIC_VAR_INIT(0)};
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    auto* state = reinterpret_cast<SkewedState*>(user_context);
+    // Every 64th tile is ~1000x more expensive than the rest.
+    int32_t iterations =
+        (tile_context->workgroup_xyz[0] % 64) == 0 ? 100000 : 100;
+    for (int32_t i = 0; i < iterations; ++i) {
+      iree_atomic_fetch_add_int32(&state->sink, 1, iree_memory_order_relaxed);
+    }
+    return GridCoverage::Tile(state->coverage, tile_context,
+                              pending_submission);
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, &state),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+#if IREE_STATISTICS_ENABLE
+TEST_F(TaskDispatchTest, Statistics) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {512, 3, 1};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+  iree_task_dispatch_statistics_t statistics =
+      iree_task_scope_consume_statistics(&scope_);
+  EXPECT_EQ(512 * 3, iree_atomic_load_int64(&statistics.tile_count,
+                                            iree_memory_order_relaxed));
+  int64_t reservation_count = iree_atomic_load_int64(
+      &statistics.reservation_count, iree_memory_order_relaxed);
+  EXPECT_GE(reservation_count, 1);
+  EXPECT_LE(reservation_count, 512 * 3);
+}
+#endif  // IREE_STATISTICS_ENABLE
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   IREE_TRACE_SCOPE();
 
@@ -12,6 +12,7 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/numa.h"
 #include "iree/base/internal/threading.h"
 #include "iree/task/tuning.h"
 
@@ -41,6 +42,10 @@ typedef struct iree_task_topology_group_t {
   // Processor index in the cpuinfo set.
   uint32_t processor_index;
 
+  // NUMA node the processor is attached to. Memory used primarily by workers
+  // in this group is best placed on this node.
+  iree_numa_node_id_t node_id;
+
   // Ideal thread affinity for threads within this group.
   // All threads within the group share the same affinity and this is what
   // allows us to model Simultaneous Multi-Threading (SMT) (aka hyperthreading).
@@ -126,6 +131,18 @@ void iree_task_topology_initialize_from_group_count(
 void iree_task_topology_initialize_from_physical_cores(
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each physical core attached to the
+// NUMA node |node_id|. Workers will be pinned to the cores of the node and
+// never migrate to cores on other nodes. IREE_NUMA_NODE_ID_ANY behaves the same
+// as iree_task_topology_initialize_from_physical_cores.
+//
+// Applications wanting one executor per node can create a topology for each
+// node in [0, iree_numa_node_count()) and pair each executor with memory
+// allocated via iree_numa_allocator on the same node.
+void iree_task_topology_initialize_from_physical_cores_on_node(
+    iree_numa_node_id_t node_id, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -34,6 +34,12 @@ void iree_task_topology_initialize_from_physical_cores(
   iree_task_topology_initialize_fallback(max_core_count, out_topology);
 }
 
+void iree_task_topology_initialize_from_physical_cores_on_node(
+    iree_numa_node_id_t node_id, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology) {
+  iree_task_topology_initialize_fallback(max_core_count, out_topology);
+}
+
 #else
 
 #include <cpuinfo.h>
@@ -138,6 +144,16 @@ static uint64_t iree_task_topology_calculate_constructive_sharing_mask(
   return mask;
 }
 
+// Returns the NUMA node the given |processor| is attached to.
+static iree_numa_node_id_t iree_task_topology_get_processor_node(
+    const struct cpuinfo_processor* processor) {
+#if defined(__linux__)
+  return iree_numa_node_for_processor(processor->linux_id);
+#else
+  return 0;
+#endif  // __linux__
+}
+
 // Populates |our_group| with the information from |core|.
 static void iree_task_topology_group_initialize_from_core(
     uint32_t group_index, const struct cpuinfo_core* core,
@@ -154,6 +170,7 @@ static void iree_task_topology_group_initialize_from_core(
       cpuinfo_get_processor(processor_i);
   iree_task_topology_set_affinity_from_processor(
       processor, &out_group->ideal_thread_affinity);
+  out_group->node_id = iree_task_topology_get_processor_node(processor);
 }
 
 // Fixes constructive_sharing_mask values such that they represent other chosen
@@ -253,4 +270,26 @@ void iree_task_topology_initialize_from_physical_cores(
       iree_task_topology_core_filter_all, 0, max_core_count, out_topology);
 }
 
+// Matches only cores attached to the NUMA node in |user_data|.
+static bool iree_task_topology_core_filter_node(const struct cpuinfo_core* core,
+                                                uintptr_t user_data) {
+  const struct cpuinfo_processor* processor =
+      cpuinfo_get_processor(core->processor_start);
+  return iree_task_topology_get_processor_node(processor) ==
+         (iree_numa_node_id_t)user_data;
+}
+
+void iree_task_topology_initialize_from_physical_cores_on_node(
+    iree_numa_node_id_t node_id, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology) {
+  if (node_id == IREE_NUMA_NODE_ID_ANY) {
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+    return;
+  }
+  iree_task_topology_initialize_from_physical_cores_with_filter(
+      iree_task_topology_core_filter_node, (uintptr_t)node_id, max_core_count,
+      out_topology);
+}
+
 #endif  // IREE_TASK_CPUINFO_DISABLED
@@ -7,6 +7,8 @@
 #ifndef IREE_TASK_TUNING_H_
 #define IREE_TASK_TUNING_H_
 
+#include "iree/base/target_platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
@@ -40,11 +42,20 @@ extern "C" {
 // Also, the underlying iree_wait_set_t may not support more than 64 handles on
 // certain platforms without emulation. Trying to keep us on the fast-path
 // with a reasonable number seems fine for now until we have a need for more.
+// On Linux the io_uring/epoll wait set tracks handles in the kernel and only
+// grows its storage as handles are inserted so we allow many more outstanding
+// waits (such as thousands of fence waits from concurrent requests).
 //
 // NOTE: we reserve 1 wait handle for our own internal use. This allows us to
 // wake the coordination worker when new work is submitted from external
 // sources.
+#if !defined(IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS)
+#if defined(IREE_PLATFORM_LINUX) && !defined(IREE_PLATFORM_ANDROID)
+#define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS (8192 - 1)
+#else
 #define IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS (64 - 1)
+#endif  // IREE_PLATFORM_LINUX && !IREE_PLATFORM_ANDROID
+#endif  // !IREE_TASK_EXECUTOR_MAX_OUTSTANDING_WAITS
 
 // Amount of time that can remain in a delay task while still retiring.
 // This prevents additional system sleeps when the remaining time before the
@@ -80,9 +91,11 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
-// Number of tiles that will be batched into a single reservation from the grid.
-// This is a maximum; if there are fewer tiles that would otherwise allow for
-// maximum parallelism then this may be ignored.
+// Initial number of tiles that will be batched into a single reservation from
+// the grid. Shards adapt their reservation size from this starting point based
+// on the observed tile cost and the number of tiles remaining in the grid (see
+// IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION). If there are fewer tiles
+// than would otherwise allow for maximum parallelism then this may be ignored.
 //
 // The more tiles reserved at a time the higher the chance for latency to
 // increase as many reserved tiles are held up on one worker while another may
@@ -92,7 +105,31 @@ extern "C" {
 // destroying behavior where multiple workers all stomp on the same cache lines
 // (as say worker 0 and worker 1 both fight over sequential tiles adjacent in
 // memory).
-#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
+#define IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION (8)
+
+// Maximum number of tiles that will be batched into a single reservation from
+// the grid. Shards double their reservation size (up to this limit) when tiles
+// are cheap enough that a reservation completes well under
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS and halve it (down to 1)
+// when a reservation takes much longer. Larger reservations reduce the atomic
+// traffic on the shared tile index for cheap tiles.
+#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (64)
+
+// Target wall-time duration of a single shard reservation, in nanoseconds.
+// Reservations that would take less than half of this grow and those that
+// would take more than twice this shrink. Set to 0 to disable cost-based
+// adaptation and use a fixed reservation size of
+// IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION (still bounded by the
+// guided tail sizing below).
+#define IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS (50 /*us*/ * 1000)
+
+// Controls the guided self-scheduling of shard reservations: no single
+// reservation takes more than 1/(shard_count * divisor) of the tiles remaining
+// in the grid. As the grid drains reservations shrink towards a single tile so
+// that variable-cost tiles at the tail of a dispatch are spread across all
+// shards instead of being stuck behind one. Higher values trade additional
+// reservations for better tail balance.
+#define IREE_TASK_DISPATCH_GUIDED_RESERVATION_DIVISOR (2)
 
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
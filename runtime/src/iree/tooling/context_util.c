@@ -6,6 +6,7 @@
 
 #include "iree/tooling/context_util.h"
 
+#include <inttypes.h>
 #include <memory.h>
 #include <stdio.h>
 #include <string.h>
@@ -17,6 +18,8 @@
 #include "iree/modules/hal/inline/module.h"
 #include "iree/modules/hal/loader/module.h"
 #include "iree/modules/hal/module.h"
+#include "iree/task/api.h"
+#include "iree/task/loop_task.h"
 #include "iree/tooling/device_util.h"
 #include "iree/vm/bytecode_module.h"
 
@@ -35,6 +38,70 @@
 IREE_FLAG(string, module_file, "-",
           "File containing the module to load. Defaults to stdin (`-`).");
 
+IREE_FLAG(bool, parallel_module_decompression, true,
+          "Decompresses compressed module rodata in parallel on a task "
+          "executor configured with the --task_* flags when loading the "
+          "module. When disabled rodata is decompressed serially on the "
+          "calling thread when the module is first added to a context.");
+
+IREE_FLAG(bool, print_module_load_statistics, false,
+          "Prints the time spent reading the module file and decompressing "
+          "its rodata to stderr.");
+
+// Decompresses any compressed rodata in |module| on a transient task executor.
+static iree_status_t iree_tooling_decompress_module_rodata(
+    iree_vm_module_t* module, iree_allocator_t host_allocator) {
+  iree_vm_bytecode_module_rodata_statistics_t statistics;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_module_query_rodata_statistics(module, &statistics));
+  if (!statistics.compressed_segment_count) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_task_executor_t* executor = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_task_executor_create_from_flags(host_allocator, &executor));
+  iree_loop_task_scope_t scope;
+  iree_loop_task_scope_initialize(executor, /*error_fn=*/NULL,
+                                  /*error_user_data=*/NULL, host_allocator,
+                                  &scope);
+  iree_task_executor_release(executor);
+
+  iree_status_t status = iree_vm_bytecode_module_decompress_rodata(
+      module, iree_loop_task_scope(&scope));
+
+  iree_loop_task_scope_deinitialize(&scope);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Prints the time spent loading |module| from a file of |file_length| bytes
+// that took |read_duration_ns| to read.
+static iree_status_t iree_tooling_print_module_load_statistics(
+    iree_vm_module_t* module, iree_host_size_t file_length,
+    iree_duration_t read_duration_ns) {
+  iree_vm_bytecode_module_rodata_statistics_t statistics;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_module_query_rodata_statistics(module, &statistics));
+  fprintf(stderr, "[module] read %" PRIhsz " bytes in %.3fms\n", file_length,
+          read_duration_ns / 1000000.0);
+  if (statistics.compressed_segment_count &&
+      statistics.decompression_duration_ns) {
+    fprintf(stderr,
+            "[module] decompressed %" PRIhsz " rodata segments (%" PRIu64
+            " -> %" PRIu64 " bytes) in %.3fms\n",
+            statistics.compressed_segment_count, statistics.compressed_length,
+            statistics.uncompressed_length,
+            statistics.decompression_duration_ns / 1000000.0);
+  } else if (statistics.compressed_segment_count) {
+    fprintf(stderr,
+            "[module] %" PRIhsz " compressed rodata segments (%" PRIu64
+            " -> %" PRIu64 " bytes) will be decompressed on first use\n",
+            statistics.compressed_segment_count, statistics.compressed_length,
+            statistics.uncompressed_length);
+  }
+  return iree_ok_status();
+}
+
 iree_status_t iree_tooling_load_module_from_flags(
     iree_vm_instance_t* instance, iree_allocator_t host_allocator,
     iree_vm_module_t** out_module) {
@@ -47,6 +114,7 @@ iree_status_t iree_tooling_load_module_from_flags(
   // Fetch the file contents into memory.
   // We could map the memory here if we wanted to and were coming from a file
   // on disk.
+  iree_time_t read_start_time_ns = iree_time_now();
   iree_file_contents_t* file_contents = NULL;
   if (strcmp(FLAG_module_file, "-") == 0) {
     // Reading from stdin. We print it out here because people often get
@@ -60,6 +128,9 @@ iree_status_t iree_tooling_load_module_from_flags(
                                     &file_contents));
   }
 
+  iree_duration_t read_duration_ns = iree_time_now() - read_start_time_ns;
+  iree_host_size_t file_length = file_contents->const_buffer.data_length;
+
   // Try to load the module as bytecode (all we have today that we can use).
   // We could sniff the file ID and switch off to other module types.
   // The module takes ownership of the file contents (when successful).
@@ -67,11 +138,25 @@ iree_status_t iree_tooling_load_module_from_flags(
   iree_status_t status = iree_vm_bytecode_module_create(
       instance, file_contents->const_buffer,
       iree_file_contents_deallocator(file_contents), host_allocator, &module);
+  if (!iree_status_is_ok(status)) {
+    iree_file_contents_free(file_contents);
+  }
+
+  // Decompress rodata up front so that it happens in parallel; otherwise it
+  // happens serially when the module is first added to a context.
+  if (iree_status_is_ok(status) && FLAG_parallel_module_decompression) {
+    status = iree_tooling_decompress_module_rodata(module, host_allocator);
+  }
+
+  if (iree_status_is_ok(status) && FLAG_print_module_load_statistics) {
+    status = iree_tooling_print_module_load_statistics(module, file_length,
+                                                       read_duration_ns);
+  }
 
   if (iree_status_is_ok(status)) {
     *out_module = module;
   } else {
-    iree_file_contents_free(file_contents);
+    iree_vm_module_release(module);
   }
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -137,14 +222,19 @@ static iree_status_t iree_tooling_load_hal_async_module(
   return status;
 }
 
-// Creates a HAL device allocator for host-local heap usage.
-// TODO(benvanik): generalize to allocator wrapper flag (suballocator, etc).
+// Creates a HAL device allocator for host-local heap usage wrapped as specified
+// by the --device_allocator= flag.
 static iree_status_t iree_tooling_create_inline_device_allocator_from_flags(
     iree_allocator_t host_allocator,
     iree_hal_allocator_t** out_device_allocator) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  iree_status_t status = iree_hal_allocator_create_heap(
-      IREE_SV("heap"), host_allocator, host_allocator, out_device_allocator);
+  iree_hal_allocator_t* heap_allocator = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_allocator_create_heap(IREE_SV("heap"), host_allocator,
+                                         host_allocator, &heap_allocator));
+  iree_status_t status = iree_hal_wrap_allocator_from_flags(
+      heap_allocator, host_allocator, out_device_allocator);
+  iree_hal_allocator_release(heap_allocator);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -444,13 +534,26 @@ iree_status_t iree_tooling_create_context_from_flags(
     iree_allocator_t host_allocator, iree_vm_context_t** out_context,
     iree_hal_device_t** out_device,
     iree_hal_allocator_t** out_device_allocator) {
+  return iree_tooling_create_contexts_from_flags(
+      instance, user_module_count, user_modules, default_device_uri,
+      host_allocator, /*context_count=*/1, out_context, out_device,
+      out_device_allocator);
+}
+
+iree_status_t iree_tooling_create_contexts_from_flags(
+    iree_vm_instance_t* instance, iree_host_size_t user_module_count,
+    iree_vm_module_t** user_modules, iree_string_view_t default_device_uri,
+    iree_allocator_t host_allocator, iree_host_size_t context_count,
+    iree_vm_context_t** out_contexts, iree_hal_device_t** out_device,
+    iree_hal_allocator_t** out_device_allocator) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_ASSERT_ARGUMENT(!user_module_count || user_modules);
-  IREE_ASSERT_ARGUMENT(out_context);
-  *out_context = NULL;
+  IREE_ASSERT_ARGUMENT(out_contexts);
+  for (iree_host_size_t i = 0; i < context_count; ++i) out_contexts[i] = NULL;
   if (out_device) *out_device = NULL;
   if (out_device_allocator) *out_device_allocator = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)context_count);
 
   // Resolve all module dependencies into an ordered list.
   // All modules are retained in the list.
@@ -470,12 +573,17 @@ iree_status_t iree_tooling_create_context_from_flags(
     flags |= IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION;
   }
 
-  // Create the context with the full list of resolved modules.
-  // The context retains the modules and we can release them afterward.
-  iree_vm_context_t* context = NULL;
-  iree_status_t status = iree_vm_context_create_with_modules(
-      instance, flags, resolved_list.count, resolved_list.values,
-      host_allocator, &context);
+  // Create the contexts with the full list of resolved modules. Each context
+  // gets its own module state but the modules themselves (and the device the
+  // HAL module was created with) are shared.
+  // The contexts retain the modules and we can release them afterward.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < context_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_vm_context_create_with_modules(
+        instance, flags, resolved_list.count, resolved_list.values,
+        host_allocator, &out_contexts[i]);
+  }
   iree_tooling_module_list_reset(&resolved_list);
 
   // If no device allocator was created we'll create a default one just so that
@@ -488,7 +596,6 @@ iree_status_t iree_tooling_create_context_from_flags(
   }
 
   if (iree_status_is_ok(status)) {
-    *out_context = context;
     if (out_device_allocator) {
       *out_device_allocator = device_allocator;
     } else {
@@ -502,7 +609,10 @@ iree_status_t iree_tooling_create_context_from_flags(
   } else {
     iree_hal_allocator_release(device_allocator);
     iree_hal_device_release(device);
-    iree_vm_context_release(context);
+    for (iree_host_size_t i = 0; i < context_count; ++i) {
+      iree_vm_context_release(out_contexts[i]);
+      out_contexts[i] = NULL;
+    }
   }
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -87,6 +87,18 @@ iree_status_t iree_tooling_create_context_from_flags(
     iree_hal_device_t** out_device,
     iree_hal_allocator_t** out_device_allocator);
 
+// Creates |context_count| VM contexts with the provided |user_modules| and
+// dependent system modules as with iree_tooling_create_context_from_flags.
+// All contexts share the same modules and a single device but have their own
+// module state such that they can be used concurrently from multiple threads.
+// |out_contexts| must have storage for |context_count| contexts.
+iree_status_t iree_tooling_create_contexts_from_flags(
+    iree_vm_instance_t* instance, iree_host_size_t user_module_count,
+    iree_vm_module_t** user_modules, iree_string_view_t default_device_uri,
+    iree_allocator_t host_allocator, iree_host_size_t context_count,
+    iree_vm_context_t** out_contexts, iree_hal_device_t** out_device,
+    iree_hal_allocator_t** out_device_allocator);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -6,10 +6,14 @@
 
 #include "iree/tooling/device_util.h"
 
+#include <string.h>
+
 #include "iree/base/internal/call_once.h"
 #include "iree/base/internal/flags.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/local/profiling.h"
+#include "iree/hal/utils/suballocator.h"
 
 //===----------------------------------------------------------------------===//
 // Shared driver registry
@@ -390,8 +394,87 @@ iree_status_t iree_hal_create_device_from_flags(
     // Exactly one device specified.
     device_uri = flag->inline_uri;
   }
-  return iree_hal_create_device(iree_hal_available_driver_registry(),
-                                device_uri, host_allocator, out_device);
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_create_device(
+      iree_hal_available_driver_registry(), device_uri, host_allocator,
+      &device));
+
+  // Wrap the device allocator if requested.
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_status_t status = iree_hal_wrap_allocator_from_flags(
+      iree_hal_device_allocator(device), host_allocator, &device_allocator);
+  if (iree_status_is_ok(status)) {
+    if (device_allocator != iree_hal_device_allocator(device)) {
+      iree_hal_device_replace_allocator(device, device_allocator);
+    }
+    iree_hal_allocator_release(device_allocator);
+    *out_device = device;
+  } else {
+    iree_hal_device_release(device);
+  }
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Allocators
+//===----------------------------------------------------------------------===//
+
+IREE_FLAG(
+    string, device_allocator, "",
+    "Allocator wrapping the device allocator for all buffer allocations:\n"
+    " '': the device allocator is used directly.\n"
+    " 'suballocator': buffers are suballocated from large slabs reserved from\n"
+    "   the device allocator; see --device_allocator_slab_size.");
+
+IREE_FLAG(
+    int64_t, device_allocator_slab_size,
+    IREE_HAL_SUBALLOCATOR_DEFAULT_SLAB_SIZE,
+    "Minimum size in bytes of each slab reserved by\n"
+    "--device_allocator=suballocator. Allocations larger than this are made\n"
+    "directly from the device allocator.");
+
+iree_status_t iree_hal_wrap_allocator_from_flags(
+    iree_hal_allocator_t* base_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+  if (strlen(FLAG_device_allocator) == 0) {
+    iree_hal_allocator_retain(base_allocator);
+    *out_allocator = base_allocator;
+    return iree_ok_status();
+  } else if (strcmp(FLAG_device_allocator, "suballocator") == 0) {
+    if (FLAG_device_allocator_slab_size <= 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--device_allocator_slab_size must be positive");
+    }
+    iree_hal_suballocator_options_t options;
+    iree_hal_suballocator_options_initialize(&options);
+    options.slab_size = (iree_device_size_t)FLAG_device_allocator_slab_size;
+    options.max_suballocation_size = options.slab_size;
+    return iree_hal_suballocator_create(base_allocator, &options,
+                                        host_allocator, out_allocator);
+  }
+  return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                          "unsupported --device_allocator='%s'",
+                          FLAG_device_allocator);
+}
+
+iree_status_t iree_hal_allocator_statistics_fprint_all(
+    FILE* file, iree_hal_allocator_t* allocator) {
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_statistics_fprint(file, allocator));
+  if (!iree_hal_suballocator_isa(allocator)) return iree_ok_status();
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_hal_allocator_host_allocator(allocator),
+                                 &builder);
+  iree_status_t status =
+      iree_hal_suballocator_statistics_format(allocator, &builder);
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "%.*s", (int)iree_string_builder_size(&builder),
+            iree_string_builder_buffer(&builder));
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
 }
 
 //===----------------------------------------------------------------------===//
@@ -440,3 +523,7 @@ iree_status_t iree_hal_end_profiling_from_flags(iree_hal_device_t* device) {
   if (strlen(FLAG_device_profiling_mode) == 0) return iree_ok_status();
   return iree_hal_device_profiling_end(device);
 }
+
+iree_status_t iree_hal_profiling_statistics_fprint(FILE* file) {
+  return iree_hal_local_profiling_statistics_fprint(file);
+}
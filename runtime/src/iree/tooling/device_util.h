@@ -7,6 +7,8 @@
 #ifndef IREE_TOOLING_DEVICE_UTIL_H_
 #define IREE_TOOLING_DEVICE_UTIL_H_
 
+#include <stdio.h>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 
@@ -29,10 +31,23 @@ void iree_hal_get_devices_flag_list(iree_host_size_t* out_count,
 // Creates a single device from the --device= flag.
 // Uses the |default_device| if no flags were specified.
 // Fails if more than one device was specified.
+// The device allocator is wrapped as specified by the --device_allocator= flag.
 iree_status_t iree_hal_create_device_from_flags(
     iree_string_view_t default_device, iree_allocator_t host_allocator,
     iree_hal_device_t** out_device);
 
+// Wraps |base_allocator| as specified by the --device_allocator= flag and
+// returns the allocator to use in |out_allocator|. Returns |base_allocator|
+// retained if no wrapping was requested.
+iree_status_t iree_hal_wrap_allocator_from_flags(
+    iree_hal_allocator_t* base_allocator, iree_allocator_t host_allocator,
+    iree_hal_allocator_t** out_allocator);
+
+// Prints the statistics of |allocator| to |file| including those of any
+// allocator wrappers (such as per-heap suballocator statistics).
+iree_status_t iree_hal_allocator_statistics_fprint_all(
+    FILE* file, iree_hal_allocator_t* allocator);
+
 // Equivalent to iree_hal_device_profiling_begin with options sourced from
 // command line flags. No-op if profiling is not enabled.
 // Must be matched with a call to iree_hal_end_profiling_from_flags.
@@ -42,6 +57,11 @@ iree_status_t iree_hal_begin_profiling_from_flags(iree_hal_device_t* device);
 // command line flags. No-op if profiling is not enabled.
 iree_status_t iree_hal_end_profiling_from_flags(iree_hal_device_t* device);
 
+// Prints the statistics captured by the last completed profile to |file|, such
+// as the per-dispatch counters of local devices. Prints nothing if no profile
+// has completed.
+iree_status_t iree_hal_profiling_statistics_fprint(FILE* file);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
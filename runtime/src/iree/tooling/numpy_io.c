@@ -4,10 +4,38 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+// Arrays and .npz entries may be at offsets beyond 2GB.
+#define _FILE_OFFSET_BITS 64
+
 #include "iree/tooling/numpy_io.h"
 
+#include <errno.h>
+#include <stdio.h>
+
 #include "iree/base/tracing.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define IREE_NUMPY_FILE_MAPPING_POSIX 1
+#endif  // IREE_PLATFORM_*
+
+#if defined(IREE_PLATFORM_WINDOWS)
+#define iree_numpy_fseek64(stream, offset, origin) \
+  _fseeki64(stream, (__int64)(offset), origin)
+#define iree_numpy_ftell64(stream) ((int64_t)_ftelli64(stream))
+#else
+#define iree_numpy_fseek64(stream, offset, origin) \
+  fseeko(stream, (off_t)(offset), origin)
+#define iree_numpy_ftell64(stream) ((int64_t)ftello(stream))
+#endif  // IREE_PLATFORM_WINDOWS
+
+// Maximum number of bytes mapped at a time when streaming buffer contents to
+// files. Keeps staging memory bounded for buffers that are not host-local.
+#define IREE_NUMPY_STREAM_CHUNK_SIZE (64 * 1024 * 1024)
+
 //===----------------------------------------------------------------------===//
 // .npy (multiple values concatenated)
 //===----------------------------------------------------------------------===//
@@ -136,6 +164,183 @@ static iree_status_t iree_numpy_npy_read_into_mapping(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// File mapping
+//===----------------------------------------------------------------------===//
+
+// A read-only (or copy-on-write) mapping of a range of a file.
+// Freed by iree_numpy_file_mapping_release once all buffers imported from it
+// have been released.
+typedef struct iree_numpy_file_mapping_t {
+  iree_allocator_t host_allocator;
+  // Page-aligned base of the mapping and its total length.
+  void* base;
+  iree_host_size_t length;
+} iree_numpy_file_mapping_t;
+
+static void iree_numpy_file_mapping_release(void* user_data,
+                                            iree_hal_buffer_t* buffer) {
+  iree_numpy_file_mapping_t* mapping = (iree_numpy_file_mapping_t*)user_data;
+#if defined(IREE_NUMPY_FILE_MAPPING_POSIX)
+  munmap(mapping->base, mapping->length);
+#endif  // IREE_NUMPY_FILE_MAPPING_POSIX
+  iree_allocator_free(mapping->host_allocator, mapping);
+}
+
+// Maps |length| bytes of |stream| starting at file |offset|.
+// The mapping is private to the process: if |writable| then writes are
+// copy-on-write and never reach the file.
+// Returns IREE_STATUS_UNAVAILABLE if the stream cannot be mapped (pipes,
+// platforms without mapping support, etc) and callers should fall back to
+// reading the stream.
+static iree_status_t iree_numpy_file_mapping_open(
+    FILE* stream, uint64_t offset, iree_device_size_t length, bool writable,
+    iree_allocator_t host_allocator, iree_numpy_file_mapping_t** out_mapping,
+    iree_byte_span_t* out_contents) {
+  *out_mapping = NULL;
+  *out_contents = iree_make_byte_span(NULL, 0);
+#if defined(IREE_NUMPY_FILE_MAPPING_POSIX)
+  if (length == 0 || length > IREE_HOST_SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "range of %" PRIu64 " bytes cannot be mapped",
+                            (uint64_t)length);
+  }
+
+  // The file must be a regular file that contains the entire range. Mapping
+  // past the end of a file would fault on access instead of failing here.
+  int fd = fileno(stream);
+  struct stat file_stat;
+  if (fd < 0 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "stream is not a mappable file");
+  }
+  if (offset + length > (uint64_t)file_stat.st_size) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "file is truncated; expected %" PRIu64
+                            " bytes at offset %" PRIu64 " but file is %" PRIu64
+                            " bytes",
+                            (uint64_t)length, offset,
+                            (uint64_t)file_stat.st_size);
+  }
+
+  // mmap requires page-aligned offsets so we map from the containing page.
+  uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint64_t page_offset = offset - (offset % page_size);
+  iree_host_size_t page_delta = (iree_host_size_t)(offset - page_offset);
+  iree_host_size_t map_length = page_delta + (iree_host_size_t)length;
+
+  iree_numpy_file_mapping_t* mapping = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator, sizeof(*mapping),
+                                             (void**)&mapping));
+  mapping->host_allocator = host_allocator;
+  mapping->length = map_length;
+  mapping->base =
+      mmap(NULL, map_length, PROT_READ | (writable ? PROT_WRITE : 0),
+           MAP_PRIVATE, fd, (off_t)page_offset);
+  if (mapping->base == MAP_FAILED) {
+    iree_allocator_free(host_allocator, mapping);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "failed to map file range (%d)", errno);
+  }
+
+  *out_mapping = mapping;
+  *out_contents =
+      iree_make_byte_span((uint8_t*)mapping->base + page_delta, length);
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "file mapping not supported on this platform");
+#endif  // IREE_NUMPY_FILE_MAPPING_POSIX
+}
+
+// Loads the ndarray contents at the current position of |stream| by mapping
+// the file. If |device_allocator| can import host allocations the mapping is
+// used directly as the buffer storage (zero-copy) and otherwise the mapping is
+// used as the source of the upload so that the contents are paged in on demand
+// instead of being staged in a temporary host allocation.
+// On success |stream| is positioned immediately following the contents.
+static iree_status_t iree_numpy_npy_map_ndarray(
+    FILE* stream, iree_host_size_t shape_rank, const iree_hal_dim_t* shape,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_params_t buffer_params,
+    iree_hal_allocator_t* device_allocator,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(device_allocator);
+  iree_hal_buffer_params_canonicalize(&buffer_params);
+
+  iree_device_size_t byte_length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_buffer_compute_view_size(shape_rank, shape, element_type,
+                                            encoding_type, &byte_length));
+  int64_t offset = (int64_t)iree_numpy_ftell64(stream);
+  if (offset < 0) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE, "stream is not seekable");
+  }
+
+  iree_numpy_file_mapping_t* mapping = NULL;
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_numpy_file_mapping_open(
+              stream, (uint64_t)offset, byte_length,
+              iree_any_bit_set(buffer_params.access,
+                               IREE_HAL_MEMORY_ACCESS_WRITE),
+              host_allocator, &mapping, &contents));
+
+  // Try to import the mapping directly. This will fail if the allocator does
+  // not support host allocations or the contents are not sufficiently aligned
+  // (npy pads headers to 64 bytes but contents in npz archives are unaligned).
+  iree_hal_external_buffer_t external_buffer = {
+      .type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+      .flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE,
+      .size = contents.data_length,
+      .handle.host_allocation.ptr = contents.data,
+  };
+  iree_hal_buffer_release_callback_t release_callback = {
+      .fn = iree_numpy_file_mapping_release,
+      .user_data = mapping,
+  };
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_allocator_import_buffer(
+      device_allocator, buffer_params, &external_buffer, release_callback,
+      &buffer);
+  if (iree_status_is_ok(status)) {
+    // The buffer now owns the mapping.
+    mapping = NULL;
+    status = iree_hal_buffer_view_create(buffer, shape_rank, shape,
+                                         element_type, encoding_type,
+                                         host_allocator, out_buffer_view);
+    iree_hal_buffer_release(buffer);
+  } else {
+    // Fall back to uploading from the mapping into a new allocation.
+    iree_status_ignore(status);
+    status = iree_hal_buffer_view_allocate_buffer(
+        device_allocator, shape_rank, shape, element_type, encoding_type,
+        buffer_params,
+        iree_make_const_byte_span(contents.data, contents.data_length),
+        out_buffer_view);
+  }
+  if (mapping) iree_numpy_file_mapping_release(mapping, NULL);
+
+  // Skip the stream over the contents we mapped.
+  if (iree_status_is_ok(status) &&
+      iree_numpy_fseek64(stream, offset + (int64_t)byte_length, SEEK_SET) !=
+          0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to seek past npy contents");
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_hal_buffer_view_release(*out_buffer_view);
+    *out_buffer_view = NULL;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Scans for the next key: value pair in |dict|.
 // |dict| will be set to the remaining |dict| string after the key and value.
 static iree_status_t iree_numpy_consume_dict_key_value(
@@ -370,10 +575,25 @@ iree_numpy_npy_load_ndarray(FILE* stream, iree_numpy_npy_load_options_t options,
     if (!iree_status_is_ok(status)) break;
   }
 
+  // Try mapping the file first if requested. If the stream can't be mapped
+  // (pipes, unsupported platforms) we fall back to reading it.
+  bool loaded = false;
+  if (iree_status_is_ok(status) &&
+      iree_all_bits_set(options, IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE)) {
+    status = iree_numpy_npy_map_ndarray(stream, shape_rank, shape, element_type,
+                                        encoding_type, buffer_params,
+                                        device_allocator, out_buffer_view);
+    if (iree_status_is_ok(status)) {
+      loaded = true;
+    } else if (iree_status_is_unavailable(status)) {
+      status = iree_status_ignore(status);
+    }
+  }
+
   // Allocate the buffer view and directly read into the allocated memory.
   // On targets where we can perform host mapping this will be zero-copy; on
   // others it'll at least be _somewhat_ efficient.
-  if (iree_status_is_ok(status)) {
+  if (iree_status_is_ok(status) && !loaded) {
     iree_numpy_npy_read_params_t read_params = {
         .stream = stream,
     };
@@ -577,24 +797,35 @@ static iree_status_t iree_numpy_npy_write_header(
 }
 
 // Writes |buffer_view| contents to |stream|.
+// Contents are mapped and written in chunks so that large buffers that are not
+// host-local do not need to be staged in their entirety.
 static iree_status_t iree_numpy_npy_write_bytes(
     FILE* stream, iree_hal_buffer_view_t* buffer_view) {
   iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(buffer_view);
   iree_device_size_t write_length =
       iree_hal_buffer_view_byte_length(buffer_view);
 
-  iree_hal_buffer_mapping_t mapping;
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
-      buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ, 0,
-      write_length, &mapping));
+  for (iree_device_size_t offset = 0; offset < write_length;) {
+    iree_device_size_t chunk_length =
+        iree_min(write_length - offset, IREE_NUMPY_STREAM_CHUNK_SIZE);
 
-  bool write_ok =
-      fwrite(mapping.contents.data, 1, write_length, stream) == write_length;
+    iree_hal_buffer_mapping_t mapping;
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+        buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ,
+        offset, chunk_length, &mapping));
 
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_unmap_range(&mapping));
-  return write_ok ? iree_ok_status()
-                  : iree_make_status(IREE_STATUS_DATA_LOSS,
-                                     "failed to write buffer contents");
+    bool write_ok = fwrite(mapping.contents.data, 1,
+                           mapping.contents.data_length,
+                           stream) == mapping.contents.data_length;
+
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_unmap_range(&mapping));
+    if (!write_ok) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "failed to write buffer contents");
+    }
+    offset += chunk_length;
+  }
+  return iree_ok_status();
 }
 
 IREE_API_EXPORT iree_status_t iree_numpy_npy_save_ndarray(
@@ -625,3 +856,192 @@ IREE_API_EXPORT iree_status_t iree_numpy_npy_save_ndarray(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+//===----------------------------------------------------------------------===//
+// .npz (zip archive of .npy files)
+//===----------------------------------------------------------------------===//
+
+// File format spec:
+// https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+//
+// numpy.savez writes a zip archive with one stored (uncompressed) .npy entry
+// per array. Each entry is preceded by a local file header and the archive
+// ends with a central directory. We only need the local file headers and scan
+// through the archive sequentially:
+//
+//   4b: signature 0x04034B50
+//   2b: version needed to extract
+//   2b: general purpose flags
+//   2b: compression method (0 = stored)
+//   2b: modification time
+//   2b: modification date
+//   4b: crc-32
+//   4b: compressed size (0xFFFFFFFF if in the zip64 extra field)
+//   4b: uncompressed size (0xFFFFFFFF if in the zip64 extra field)
+//   2b: file name length
+//   2b: extra field length
+//   [file name length]b file name
+//   [extra field length]b extra fields
+//   [compressed size]b file data
+
+#define IREE_NUMPY_ZIP_LOCAL_FILE_HEADER_SIGNATURE 0x04034B50u
+#define IREE_NUMPY_ZIP_CENTRAL_DIRECTORY_SIGNATURE 0x02014B50u
+#define IREE_NUMPY_ZIP_END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054B50u
+#define IREE_NUMPY_ZIP_LOCAL_FILE_HEADER_SIZE 30
+#define IREE_NUMPY_ZIP_FLAG_ENCRYPTED (1u << 0)
+#define IREE_NUMPY_ZIP_FLAG_DATA_DESCRIPTOR (1u << 3)
+#define IREE_NUMPY_ZIP_COMPRESSION_STORED 0
+#define IREE_NUMPY_ZIP64_EXTRA_FIELD_ID 0x0001
+
+static uint16_t iree_numpy_zip_load_u16(const uint8_t* ptr) {
+  return (uint16_t)(ptr[0] | (ptr[1] << 8));
+}
+
+static uint32_t iree_numpy_zip_load_u32(const uint8_t* ptr) {
+  return (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) |
+         ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+static uint64_t iree_numpy_zip_load_u64(const uint8_t* ptr) {
+  return (uint64_t)iree_numpy_zip_load_u32(ptr) |
+         ((uint64_t)iree_numpy_zip_load_u32(ptr + 4) << 32);
+}
+
+// Finds the compressed size of an entry in its zip64 |extra| fields.
+// |has_uncompressed_size| indicates whether the uncompressed size precedes the
+// compressed size in the zip64 field as it is only present if the local header
+// value overflowed.
+static iree_status_t iree_numpy_zip_find_zip64_compressed_size(
+    iree_const_byte_span_t extra, bool has_uncompressed_size,
+    uint64_t* out_compressed_size) {
+  iree_host_size_t offset = 0;
+  while (offset + 4 <= extra.data_length) {
+    uint16_t id = iree_numpy_zip_load_u16(extra.data + offset);
+    uint16_t length = iree_numpy_zip_load_u16(extra.data + offset + 2);
+    offset += 4;
+    if (offset + length > extra.data_length) break;
+    if (id == IREE_NUMPY_ZIP64_EXTRA_FIELD_ID) {
+      iree_host_size_t field_offset = has_uncompressed_size ? 8 : 0;
+      if (field_offset + 8 > length) break;
+      *out_compressed_size =
+          iree_numpy_zip_load_u64(extra.data + offset + field_offset);
+      return iree_ok_status();
+    }
+    offset += length;
+  }
+  return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                          "npz entry missing zip64 size information");
+}
+
+IREE_API_EXPORT iree_status_t iree_numpy_npz_load_ndarrays(
+    FILE* stream, iree_numpy_npy_load_options_t options,
+    iree_hal_buffer_params_t buffer_params,
+    iree_hal_allocator_t* device_allocator,
+    iree_numpy_npz_entry_callback_t callback) {
+  IREE_ASSERT_ARGUMENT(stream);
+  IREE_ASSERT_ARGUMENT(device_allocator);
+  IREE_ASSERT_ARGUMENT(callback.fn);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator =
+      iree_hal_allocator_host_allocator(device_allocator);
+
+  // Scratch storage for entry names and extra fields; both are <= 64KB.
+  uint8_t* scratch = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, 2 * UINT16_MAX,
+                                (void**)&scratch));
+
+  iree_status_t status = iree_ok_status();
+  while (iree_status_is_ok(status)) {
+    // Read the local file header. Hitting the central directory (or the end of
+    // an empty archive) indicates there are no more entries.
+    uint8_t header[IREE_NUMPY_ZIP_LOCAL_FILE_HEADER_SIZE];
+    if (fread(header, 1, 4, stream) != 4) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "npz archive truncated");
+      break;
+    }
+    uint32_t signature = iree_numpy_zip_load_u32(header);
+    if (signature == IREE_NUMPY_ZIP_CENTRAL_DIRECTORY_SIGNATURE ||
+        signature == IREE_NUMPY_ZIP_END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+      break;
+    } else if (signature != IREE_NUMPY_ZIP_LOCAL_FILE_HEADER_SIGNATURE) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "npz zip signature mismatch");
+      break;
+    }
+    if (fread(header + 4, 1, sizeof(header) - 4, stream) !=
+        sizeof(header) - 4) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "npz local file header truncated");
+      break;
+    }
+    uint16_t flags = iree_numpy_zip_load_u16(header + 6);
+    uint16_t compression = iree_numpy_zip_load_u16(header + 8);
+    uint64_t compressed_size = iree_numpy_zip_load_u32(header + 18);
+    uint32_t uncompressed_size = iree_numpy_zip_load_u32(header + 22);
+    uint16_t name_length = iree_numpy_zip_load_u16(header + 26);
+    uint16_t extra_length = iree_numpy_zip_load_u16(header + 28);
+
+    // Read the name and extra fields.
+    uint8_t* name_data = scratch;
+    uint8_t* extra_data = scratch + UINT16_MAX;
+    if (fread(name_data, 1, name_length, stream) != name_length ||
+        fread(extra_data, 1, extra_length, stream) != extra_length) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "npz local file header truncated");
+      break;
+    }
+    iree_string_view_t name =
+        iree_make_string_view((const char*)name_data, name_length);
+
+    if (compression != IREE_NUMPY_ZIP_COMPRESSION_STORED ||
+        iree_any_bit_set(flags, IREE_NUMPY_ZIP_FLAG_ENCRYPTED)) {
+      status = iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "npz entry '%.*s' is compressed or encrypted; only archives written "
+          "with numpy.savez are supported",
+          (int)name.size, name.data);
+      break;
+    }
+    if (compressed_size == UINT32_MAX) {
+      status = iree_numpy_zip_find_zip64_compressed_size(
+          iree_make_const_byte_span(extra_data, extra_length),
+          uncompressed_size == UINT32_MAX, &compressed_size);
+      if (!iree_status_is_ok(status)) break;
+    } else if (compressed_size == 0 &&
+               iree_any_bit_set(flags, IREE_NUMPY_ZIP_FLAG_DATA_DESCRIPTOR)) {
+      // Written to a non-seekable stream with sizes following the data. We'd
+      // need the central directory to find the entry extents.
+      status = iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "npz entry '%.*s' uses a trailing data descriptor", (int)name.size,
+          name.data);
+      break;
+    }
+
+    // Load the ndarray directly from the archive. Stored entries are plain
+    // .npy files and can be mapped just the same.
+    int64_t data_offset = (int64_t)iree_numpy_ftell64(stream);
+    iree_hal_buffer_view_t* buffer_view = NULL;
+    status = iree_numpy_npy_load_ndarray(stream, options, buffer_params,
+                                         device_allocator, &buffer_view);
+    if (iree_status_is_ok(status)) {
+      iree_string_view_consume_suffix(&name, IREE_SV(".npy"));
+      status = callback.fn(callback.user_data, name, buffer_view);
+    }
+    iree_hal_buffer_view_release(buffer_view);
+
+    // Skip to the next entry in case the .npy had trailing data.
+    if (iree_status_is_ok(status) &&
+        iree_numpy_fseek64(stream, data_offset + (int64_t)compressed_size,
+                           SEEK_SET) != 0) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to seek to next npz entry");
+    }
+  }
+
+  iree_allocator_free(host_allocator, scratch);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
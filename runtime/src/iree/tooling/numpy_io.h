@@ -19,7 +19,8 @@
 // .npy and uncompressed .npz files can be mapped into host memory with
 // IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE if the HAL device allocator
 // supports using such memory. On devices with discrete memory the contents will
-// be loaded into host memory and copied to the device.
+// be uploaded directly from the file mapping and paged in as they are copied to
+// the device. Saving streams buffer contents to the file in fixed-size chunks.
 //
 // This current implementation is very basic; in the future it'd be nice to
 // support an iree_io_stream_t to allow for externalizing the file access.
@@ -55,9 +56,11 @@ enum iree_numpy_npy_load_options_bits_t {
 
   // Tries to map the file into memory and use the contents directly from the
   // file system. Only available if the HAL device supports accessing mapped
-  // data.
-  // Like providing `mmap_mode` to `numpy.load`.
-  // May be ignored if the implementation does not support mapping.
+  // data. The mapping is private: writes to buffers with write access are
+  // copy-on-write and never modify the file.
+  // Like providing `mmap_mode='c'` to `numpy.load`.
+  // May be ignored if the implementation does not support mapping or the
+  // stream is not a regular file (such as a pipe).
   IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE = 1u << 0,
 };
 typedef uint32_t iree_numpy_npy_load_options_t;
@@ -73,8 +76,9 @@ typedef uint32_t iree_numpy_npy_save_options_t;
 // in the npy file allocated from the given |device_allocator|.
 //
 // If IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE is set and the
-// |device_allocator| supports mapping then the file will be mapped into the
-// host process. Otherwise the file will be loaded into a new allocation.
+// |device_allocator| supports importing host allocations then the file will be
+// mapped into the host process and the buffer will reference the mapping.
+// Otherwise the file will be loaded into a new allocation.
 //
 // Upon return the |stream| will be positioned immediately following the
 // ndarray contents, which may be end-of-stream.
@@ -98,6 +102,33 @@ IREE_API_EXPORT iree_status_t iree_numpy_npy_save_ndarray(
     FILE* stream, iree_numpy_npy_save_options_t options,
     iree_hal_buffer_view_t* buffer_view, iree_allocator_t host_allocator);
 
+//===----------------------------------------------------------------------===//
+// .npz (zip archive of .npy files)
+//===----------------------------------------------------------------------===//
+
+// A callback issued for each ndarray loaded from an npz archive.
+// |name| is the name of the array in the archive (the keyword passed to
+// `numpy.savez` or `arr_N` for positional arrays) and |buffer_view| must be
+// retained by the callback if it is needed after the callback returns.
+typedef struct iree_numpy_npz_entry_callback_t {
+  iree_status_t(IREE_API_PTR* fn)(void* user_data, iree_string_view_t name,
+                                  iree_hal_buffer_view_t* buffer_view);
+  void* user_data;
+} iree_numpy_npz_entry_callback_t;
+
+// Loads all arrays from an .npz |stream| in archive order and issues
+// |callback| for each. Arrays are loaded as with iree_numpy_npy_load_ndarray
+// and may be mapped with IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE.
+// Only uncompressed archives (as produced by `numpy.savez`) are supported.
+//
+// See `numpy.load`:
+// https://numpy.org/doc/stable/reference/generated/numpy.load.html
+IREE_API_EXPORT iree_status_t iree_numpy_npz_load_ndarrays(
+    FILE* stream, iree_numpy_npy_load_options_t options,
+    iree_hal_buffer_params_t buffer_params,
+    iree_hal_allocator_t* device_allocator,
+    iree_numpy_npz_entry_callback_t callback);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -119,15 +119,16 @@ static void LoadArrayAndAssertContents(FILE* stream,
                                        std::vector<iree_hal_dim_t> shape,
                                        iree_hal_element_type_t element_type,
                                        iree_hal_encoding_type_t encoding_type,
-                                       std::vector<T> contents) {
+                                       std::vector<T> contents,
+                                       iree_numpy_npy_load_options_t options =
+                                           IREE_NUMPY_NPY_LOAD_OPTION_DEFAULT) {
   iree_hal_buffer_params_t buffer_params = {};
   buffer_params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
   buffer_params.access = IREE_HAL_MEMORY_ACCESS_READ;
   buffer_params.type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL;
   iree_hal_buffer_view_t* buffer_view = NULL;
-  IREE_ASSERT_OK(iree_numpy_npy_load_ndarray(
-      stream, IREE_NUMPY_NPY_LOAD_OPTION_DEFAULT, buffer_params,
-      device_allocator, &buffer_view));
+  IREE_ASSERT_OK(iree_numpy_npy_load_ndarray(stream, options, buffer_params,
+                                             device_allocator, &buffer_view));
   AssertBufferViewContents<T>(buffer_view, shape, element_type, encoding_type,
                               contents);
   iree_hal_buffer_view_release(buffer_view);
@@ -194,6 +195,118 @@ TEST_F(NumpyIOTest, LoadMultipleArrays) {
   fclose(stream);
 }
 
+// Tests loading multiple arrays from a concatenated file by mapping it.
+// Only the first array is aligned in the file such that it can be imported
+// directly and the others are copied from the mapping.
+TEST_F(NumpyIOTest, LoadMultipleArraysMapped) {
+  FILE* stream = OpenInputFile("multiple.npy");
+
+  // np.array([1.1, 2.2, 3.3], dtype=np.float32)
+  LoadArrayAndAssertContents<float>(
+      stream, device_allocator_, {3}, IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, {1.1f, 2.2f, 3.3f},
+      IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE);
+
+  // np.array([[0, 1], [2, 3]], dtype=np.int32)
+  LoadArrayAndAssertContents<int32_t>(
+      stream, device_allocator_, {2, 2}, IREE_HAL_ELEMENT_TYPE_SINT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, {0, 1, 2, 3},
+      IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE);
+
+  // np.array(42, dtype=np.int32)
+  LoadArrayAndAssertContents<int32_t>(
+      stream, device_allocator_, {}, IREE_HAL_ELEMENT_TYPE_SINT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, {42},
+      IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE);
+
+  // Should have hit EOF.
+  ASSERT_TRUE(IsEOF(stream));
+  fclose(stream);
+}
+
+// Tests that mapped arrays with write access are copy-on-write.
+TEST_F(NumpyIOTest, MappedArraysAreCopyOnWrite) {
+  FILE* stream = OpenInputFile("single.npy");
+  iree_hal_buffer_params_t buffer_params = {};
+  buffer_params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
+  buffer_params.access = IREE_HAL_MEMORY_ACCESS_ALL;
+  buffer_params.type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL;
+  iree_hal_buffer_view_t* buffer_view = NULL;
+  IREE_ASSERT_OK(iree_numpy_npy_load_ndarray(
+      stream, IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE, buffer_params,
+      device_allocator_, &buffer_view));
+  const float new_value = 4.4f;
+  IREE_ASSERT_OK(iree_hal_buffer_map_write(
+      iree_hal_buffer_view_buffer(buffer_view), 0, &new_value,
+      sizeof(new_value)));
+  AssertBufferViewContents<float>(buffer_view, {3},
+                                  IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+                                  IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+                                  {4.4f, 2.2f, 3.3f});
+  iree_hal_buffer_view_release(buffer_view);
+
+  // The file contents should be unchanged.
+  fseek(stream, 0, SEEK_SET);
+  LoadArrayAndAssertContents<float>(
+      stream, device_allocator_, {3}, IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, {1.1f, 2.2f, 3.3f});
+  fclose(stream);
+}
+
+// Loads all arrays from an npz |stream| into a name -> buffer view list.
+static std::vector<std::pair<std::string, iree_hal_buffer_view_t*>>
+LoadNpzArrays(FILE* stream, iree_numpy_npy_load_options_t options,
+              iree_hal_allocator_t* device_allocator) {
+  std::vector<std::pair<std::string, iree_hal_buffer_view_t*>> arrays;
+  iree_hal_buffer_params_t buffer_params = {};
+  buffer_params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
+  buffer_params.access = IREE_HAL_MEMORY_ACCESS_READ;
+  buffer_params.type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL;
+  iree_numpy_npz_entry_callback_t callback = {
+      [](void* user_data, iree_string_view_t name,
+         iree_hal_buffer_view_t* buffer_view) {
+        iree_hal_buffer_view_retain(buffer_view);
+        ((std::vector<std::pair<std::string, iree_hal_buffer_view_t*>>*)
+             user_data)
+            ->emplace_back(std::string(name.data, name.size), buffer_view);
+        return iree_ok_status();
+      },
+      &arrays,
+  };
+  IREE_CHECK_OK(iree_numpy_npz_load_ndarrays(stream, options, buffer_params,
+                                             device_allocator, callback));
+  return arrays;
+}
+
+// Tests loading all arrays from an npz archive with and without mapping.
+TEST_F(NumpyIOTest, LoadNpzArrays) {
+  for (auto options : {IREE_NUMPY_NPY_LOAD_OPTION_DEFAULT,
+                       IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE}) {
+    FILE* stream = OpenInputFile("multiple.npz");
+    auto arrays = LoadNpzArrays(stream, options, device_allocator_);
+    fclose(stream);
+    ASSERT_EQ(arrays.size(), 3);
+
+    EXPECT_EQ(arrays[0].first, "arr_0");
+    AssertBufferViewContents<float>(arrays[0].second, {3},
+                                    IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+                                    IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+                                    {1.1f, 2.2f, 3.3f});
+    EXPECT_EQ(arrays[1].first, "arr_1");
+    AssertBufferViewContents<int32_t>(arrays[1].second, {2, 2},
+                                      IREE_HAL_ELEMENT_TYPE_SINT_32,
+                                      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+                                      {0, 1, 2, 3});
+    EXPECT_EQ(arrays[2].first, "scalar");
+    AssertBufferViewContents<int32_t>(arrays[2].second, {},
+                                      IREE_HAL_ELEMENT_TYPE_SINT_32,
+                                      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+                                      {42});
+
+    for (auto& array : arrays) iree_hal_buffer_view_release(array.second);
+  }
+}
+
 // Tests loading arrays with various shapes.
 TEST_F(NumpyIOTest, ArrayShapes) {
   FILE* stream = OpenInputFile("array_shapes.npy");
@@ -21,6 +21,12 @@ with open('multiple.npy', 'wb') as f:
   np.save(f, np.array([[0, 1], [2, 3]], dtype=np.int32))
   np.save(f, np.array(42, dtype=np.int32))
 
+# multiple arrays in an uncompressed archive
+np.savez('multiple.npz',
+         np.array([1.1, 2.2, 3.3], dtype=np.float32),
+         np.array([[0, 1], [2, 3]], dtype=np.int32),
+         scalar=np.array(42, dtype=np.int32))
+
 # arrays of various shapes
 with open('array_shapes.npy', 'wb') as f:
   np.save(f, np.array(1, dtype=np.int8))
@@ -0,0 +1,1035 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Blob deduplication reads back previously written blobs which may be at
+// offsets beyond 2GB.
+#define _FILE_OFFSET_BITS 64
+
+#include "iree/tooling/trace_capture.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/file_io.h"
+
+#if defined(IREE_PLATFORM_WINDOWS)
+#define iree_trace_capture_fseek64(stream, offset, origin) \
+  _fseeki64(stream, (__int64)(offset), origin)
+#else
+#define iree_trace_capture_fseek64(stream, offset, origin) \
+  fseeko(stream, (off_t)(offset), origin)
+#endif  // IREE_PLATFORM_WINDOWS
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/types.h"
+
+//===----------------------------------------------------------------------===//
+// Utilities
+//===----------------------------------------------------------------------===//
+
+// Hashes |length| bytes of |data| 8 bytes at a time. This is only used to
+// deduplicate blobs and need not be cryptographically strong; it must be fast
+// as every captured tensor is hashed in its entirety.
+static uint64_t iree_trace_capture_hash(const uint8_t* data,
+                                        iree_host_size_t length) {
+  const uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+  uint64_t hash = 0xCBF29CE484222325ull ^ (length * kMultiplier);
+  iree_host_size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  if (i < length) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, length - i);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 29;
+  }
+  hash ^= hash >> 32;
+  hash *= kMultiplier;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+// A growable byte buffer used to encode records before writing them.
+typedef struct iree_trace_capture_buffer_t {
+  uint8_t* data;
+  iree_host_size_t size;
+  iree_host_size_t capacity;
+} iree_trace_capture_buffer_t;
+
+static void iree_trace_capture_buffer_deinitialize(
+    iree_trace_capture_buffer_t* buffer, iree_allocator_t host_allocator) {
+  iree_allocator_free(host_allocator, buffer->data);
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+// Appends |length| zeroed bytes to |buffer| and returns a pointer to them.
+// The pointer is only valid until the next append.
+static iree_status_t iree_trace_capture_buffer_append(
+    iree_trace_capture_buffer_t* buffer, iree_host_size_t length,
+    iree_allocator_t host_allocator, void** out_ptr) {
+  if (buffer->size + length > buffer->capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(buffer->capacity * 2, iree_max(buffer->size + length, 256));
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(host_allocator, new_capacity,
+                                                (void**)&buffer->data));
+    buffer->capacity = new_capacity;
+  }
+  *out_ptr = buffer->data + buffer->size;
+  memset(*out_ptr, 0, length);
+  buffer->size += length;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_trace_capture_t
+//===----------------------------------------------------------------------===//
+
+// An entry in the blob deduplication table.
+typedef struct iree_trace_capture_blob_entry_t {
+  uint64_t hash;
+  uint64_t length;
+  // File offset of the blob contents used to compare against new blobs.
+  uint64_t offset;
+  // Blob ordinal + 1; 0 indicates an empty slot.
+  uint64_t ordinal_plus_one;
+} iree_trace_capture_blob_entry_t;
+
+struct iree_trace_capture_t {
+  iree_allocator_t host_allocator;
+  FILE* file;
+  // Current write offset in the file.
+  uint64_t offset;
+
+  // Optional device used to read back non-mappable buffers.
+  iree_hal_device_t* device;
+
+  // Total number of blobs written.
+  uint64_t blob_count;
+  // Open-addressed table of written blobs by content hash.
+  iree_host_size_t blob_table_capacity;
+  iree_host_size_t blob_table_count;
+  iree_trace_capture_blob_entry_t* blob_table;
+
+  // Scratch memory used to read back buffer contents.
+  uint8_t* scratch;
+  iree_host_size_t scratch_capacity;
+
+  // Encoded CALL record payload between begin_call and end_call.
+  bool call_pending;
+  iree_trace_capture_buffer_t call_buffer;
+  // Last fence passed as an input to the pending call, if any.
+  iree_hal_fence_t* call_fence;
+};
+
+static iree_status_t iree_trace_capture_write(iree_trace_capture_t* capture,
+                                              const void* data,
+                                              iree_host_size_t length) {
+  if (length == 0) return iree_ok_status();
+  if (fwrite(data, 1, length, capture->file) != length) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to write %" PRIhsz " bytes to trace",
+                            length);
+  }
+  capture->offset += length;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_trace_capture_write_zeros(
+    iree_trace_capture_t* capture, iree_host_size_t length) {
+  static const uint8_t zeros[IREE_TRACE_CAPTURE_BLOB_ALIGNMENT] = {0};
+  while (length > 0) {
+    iree_host_size_t chunk = iree_min(length, sizeof(zeros));
+    IREE_RETURN_IF_ERROR(iree_trace_capture_write(capture, zeros, chunk));
+    length -= chunk;
+  }
+  return iree_ok_status();
+}
+
+// Writes a record with the given payload and pads it to 8 bytes.
+static iree_status_t iree_trace_capture_write_record(
+    iree_trace_capture_t* capture, iree_trace_capture_record_type_t type,
+    const void* payload, iree_host_size_t payload_length) {
+  iree_trace_capture_record_header_t header = {
+      .type = type,
+      .reserved = 0,
+      .length = payload_length,
+  };
+  IREE_RETURN_IF_ERROR(
+      iree_trace_capture_write(capture, &header, sizeof(header)));
+  IREE_RETURN_IF_ERROR(
+      iree_trace_capture_write(capture, payload, payload_length));
+  return iree_trace_capture_write_zeros(
+      capture, iree_host_align(payload_length, 8) - payload_length);
+}
+
+iree_status_t iree_trace_capture_create(const char* path,
+                                        iree_hal_device_t* device,
+                                        iree_allocator_t host_allocator,
+                                        iree_trace_capture_t** out_capture) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_capture);
+  *out_capture = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_trace_capture_t* capture = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*capture),
+                                (void**)&capture));
+  memset(capture, 0, sizeof(*capture));
+  capture->host_allocator = host_allocator;
+  capture->device = device;
+  iree_hal_device_retain(capture->device);
+
+  iree_status_t status = iree_ok_status();
+  // Opened for reading as well so that blobs can be compared on hash matches.
+  capture->file = fopen(path, "w+b");
+  if (!capture->file) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open trace file '%s' for writing",
+                              path);
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_trace_capture_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IREE_TRACE_CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = IREE_TRACE_CAPTURE_VERSION;
+    status = iree_trace_capture_write(capture, &header, sizeof(header));
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_capture = capture;
+  } else {
+    iree_trace_capture_free(capture);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_trace_capture_free(iree_trace_capture_t* capture) {
+  if (!capture) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = capture->host_allocator;
+  if (capture->file) fclose(capture->file);
+  iree_hal_fence_release(capture->call_fence);
+  iree_trace_capture_buffer_deinitialize(&capture->call_buffer,
+                                         host_allocator);
+  iree_allocator_free(host_allocator, capture->scratch);
+  iree_allocator_free(host_allocator, capture->blob_table);
+  iree_hal_device_release(capture->device);
+  iree_allocator_free(host_allocator, capture);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Compares the contents of the blob written at |entry| with |data|.
+// Blob contents are not retained in memory and are read back from the file;
+// this only happens when both the hash and length match.
+static iree_status_t iree_trace_capture_blob_equal(
+    iree_trace_capture_t* capture, const iree_trace_capture_blob_entry_t* entry,
+    iree_const_byte_span_t data, bool* out_equal) {
+  *out_equal = false;
+  if (fflush(capture->file) != 0 ||
+      iree_trace_capture_fseek64(capture->file, entry->offset, SEEK_SET) != 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to seek to blob in trace");
+  }
+  iree_status_t status = iree_ok_status();
+  bool equal = true;
+  uint8_t chunk[4096];
+  for (iree_host_size_t i = 0; equal && i < data.data_length;) {
+    iree_host_size_t length = iree_min(sizeof(chunk), data.data_length - i);
+    if (fread(chunk, 1, length, capture->file) != length) {
+      status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                                "failed to read back blob from trace");
+      break;
+    }
+    equal = memcmp(chunk, data.data + i, length) == 0;
+    i += length;
+  }
+  // Restore the write position to the end of the file.
+  if (iree_trace_capture_fseek64(capture->file, capture->offset, SEEK_SET) !=
+          0 &&
+      iree_status_is_ok(status)) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to seek to the end of the trace");
+  }
+  *out_equal = iree_status_is_ok(status) && equal;
+  return status;
+}
+
+// Finds the entry for a blob with the given |hash| and |data| or the empty
+// slot it should be inserted into. Entries with a matching hash and length are
+// compared byte-for-byte so that colliding blobs are never aliased.
+static iree_status_t iree_trace_capture_find_blob_slot(
+    iree_trace_capture_t* capture, uint64_t hash, iree_const_byte_span_t data,
+    iree_trace_capture_blob_entry_t** out_entry) {
+  iree_host_size_t mask = capture->blob_table_capacity - 1;
+  iree_host_size_t i = (iree_host_size_t)hash & mask;
+  for (;; i = (i + 1) & mask) {
+    iree_trace_capture_blob_entry_t* entry = &capture->blob_table[i];
+    if (!entry->ordinal_plus_one) {
+      *out_entry = entry;
+      return iree_ok_status();
+    }
+    if (entry->hash != hash || entry->length != data.data_length) continue;
+    bool equal = false;
+    IREE_RETURN_IF_ERROR(
+        iree_trace_capture_blob_equal(capture, entry, data, &equal));
+    if (equal) {
+      *out_entry = entry;
+      return iree_ok_status();
+    }
+  }
+}
+
+// Finds an empty slot for an entry with the given |hash| when rehashing.
+static iree_trace_capture_blob_entry_t* iree_trace_capture_find_empty_blob_slot(
+    iree_trace_capture_t* capture, uint64_t hash) {
+  iree_host_size_t mask = capture->blob_table_capacity - 1;
+  iree_host_size_t i = (iree_host_size_t)hash & mask;
+  while (capture->blob_table[i].ordinal_plus_one) i = (i + 1) & mask;
+  return &capture->blob_table[i];
+}
+
+// Grows the blob table such that at least one more entry can be inserted while
+// keeping the load factor under 50%.
+static iree_status_t iree_trace_capture_reserve_blob_table(
+    iree_trace_capture_t* capture) {
+  if ((capture->blob_table_count + 1) * 2 <= capture->blob_table_capacity) {
+    return iree_ok_status();
+  }
+  iree_host_size_t old_capacity = capture->blob_table_capacity;
+  iree_trace_capture_blob_entry_t* old_table = capture->blob_table;
+  iree_host_size_t new_capacity = iree_max(old_capacity * 2, 64);
+  iree_trace_capture_blob_entry_t* new_table = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      capture->host_allocator, new_capacity * sizeof(*new_table),
+      (void**)&new_table));
+  memset(new_table, 0, new_capacity * sizeof(*new_table));
+  capture->blob_table = new_table;
+  capture->blob_table_capacity = new_capacity;
+  for (iree_host_size_t i = 0; i < old_capacity; ++i) {
+    if (!old_table[i].ordinal_plus_one) continue;
+    *iree_trace_capture_find_empty_blob_slot(capture, old_table[i].hash) =
+        old_table[i];
+  }
+  iree_allocator_free(capture->host_allocator, old_table);
+  return iree_ok_status();
+}
+
+// Writes |data| as a blob if identical contents have not yet been written and
+// returns the ordinal of the blob containing it.
+static iree_status_t iree_trace_capture_write_blob(
+    iree_trace_capture_t* capture, iree_const_byte_span_t data,
+    uint64_t* out_ordinal) {
+  IREE_RETURN_IF_ERROR(iree_trace_capture_reserve_blob_table(capture));
+  uint64_t hash = iree_trace_capture_hash(data.data, data.data_length);
+  iree_trace_capture_blob_entry_t* entry = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_trace_capture_find_blob_slot(capture, hash, data, &entry));
+  if (entry->ordinal_plus_one) {
+    *out_ordinal = entry->ordinal_plus_one - 1;
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, data.data_length);
+
+  // Pad so that the blob contents (after the record header) are aligned.
+  // Padding records need at least a header so small gaps are rounded up.
+  const uint64_t header_size = sizeof(iree_trace_capture_record_header_t);
+  uint64_t gap = (IREE_TRACE_CAPTURE_BLOB_ALIGNMENT -
+                  ((capture->offset + header_size) %
+                   IREE_TRACE_CAPTURE_BLOB_ALIGNMENT)) %
+                 IREE_TRACE_CAPTURE_BLOB_ALIGNMENT;
+  iree_status_t status = iree_ok_status();
+  if (gap > 0) {
+    if (gap < header_size) gap += IREE_TRACE_CAPTURE_BLOB_ALIGNMENT;
+    iree_trace_capture_record_header_t padding = {
+        .type = IREE_TRACE_CAPTURE_RECORD_PADDING,
+        .reserved = 0,
+        .length = gap - header_size,
+    };
+    status = iree_trace_capture_write(capture, &padding, sizeof(padding));
+    if (iree_status_is_ok(status)) {
+      status = iree_trace_capture_write_zeros(capture, padding.length);
+    }
+  }
+  const uint64_t contents_offset = capture->offset + header_size;
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_capture_write_record(capture,
+                                             IREE_TRACE_CAPTURE_RECORD_BLOB,
+                                             data.data, data.data_length);
+  }
+  if (iree_status_is_ok(status)) {
+    entry->hash = hash;
+    entry->length = data.data_length;
+    entry->offset = contents_offset;
+    entry->ordinal_plus_one = ++capture->blob_count;
+    ++capture->blob_table_count;
+    *out_ordinal = entry->ordinal_plus_one - 1;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_trace_capture_append_module(
+    iree_trace_capture_t* capture, iree_const_byte_span_t flatbuffer_data) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_trace_capture_module_t module;
+  memset(&module, 0, sizeof(module));
+  iree_status_t status =
+      iree_trace_capture_write_blob(capture, flatbuffer_data,
+                                    &module.blob_ordinal);
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_capture_write_record(
+        capture, IREE_TRACE_CAPTURE_RECORD_MODULE, &module, sizeof(module));
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Reads |length| bytes of |buffer| contents into capture scratch memory.
+static iree_status_t iree_trace_capture_read_buffer(
+    iree_trace_capture_t* capture, iree_hal_buffer_t* buffer,
+    iree_device_size_t length, iree_const_byte_span_t* out_data) {
+  if (length > IREE_HOST_SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "buffer too large to capture");
+  }
+  if (length > capture->scratch_capacity) {
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        capture->host_allocator, (iree_host_size_t)length,
+        (void**)&capture->scratch));
+    capture->scratch_capacity = (iree_host_size_t)length;
+  }
+  iree_status_t status =
+      iree_hal_buffer_map_read(buffer, 0, capture->scratch, length);
+  if (!iree_status_is_ok(status) && capture->device) {
+    // Not host mappable; go through the device.
+    iree_status_ignore(status);
+    status = iree_hal_device_transfer_d2h(
+        capture->device, buffer, 0, capture->scratch, length,
+        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout());
+  }
+  *out_data = iree_make_const_byte_span(capture->scratch, length);
+  return status;
+}
+
+static iree_status_t iree_trace_capture_encode_list(
+    iree_trace_capture_t* capture, iree_vm_list_t* list, bool is_input);
+
+// Encodes |variant| into the pending call record.
+static iree_status_t iree_trace_capture_encode_variant(
+    iree_trace_capture_t* capture, const iree_vm_variant_t* variant,
+    bool is_input) {
+  iree_trace_capture_value_t* value = NULL;
+  IREE_RETURN_IF_ERROR(iree_trace_capture_buffer_append(
+      &capture->call_buffer, sizeof(*value), capture->host_allocator,
+      (void**)&value));
+  // NOTE: |value| is invalidated by any subsequent append.
+  iree_host_size_t value_offset =
+      (uint8_t*)value - capture->call_buffer.data;
+  if (iree_vm_variant_is_value(*variant)) {
+    value->kind = IREE_TRACE_CAPTURE_VALUE_PRIMITIVE;
+    value->type = (uint32_t)variant->type.value_type;
+    memcpy(&value->data, variant->value_storage, sizeof(value->data));
+    return iree_ok_status();
+  } else if (!iree_vm_variant_is_ref(*variant) || !variant->ref.ptr) {
+    value->kind = IREE_TRACE_CAPTURE_VALUE_NULL;
+    return iree_ok_status();
+  }
+
+  if (iree_hal_buffer_view_isa(variant->ref)) {
+    iree_hal_buffer_view_t* buffer_view =
+        iree_hal_buffer_view_deref(variant->ref);
+    iree_const_byte_span_t contents;
+    IREE_RETURN_IF_ERROR(iree_trace_capture_read_buffer(
+        capture, iree_hal_buffer_view_buffer(buffer_view),
+        iree_hal_buffer_view_byte_length(buffer_view), &contents));
+    uint64_t blob_ordinal = 0;
+    IREE_RETURN_IF_ERROR(
+        iree_trace_capture_write_blob(capture, contents, &blob_ordinal));
+    iree_host_size_t rank = iree_hal_buffer_view_shape_rank(buffer_view);
+    uint64_t* dims = NULL;
+    IREE_RETURN_IF_ERROR(iree_trace_capture_buffer_append(
+        &capture->call_buffer, rank * sizeof(*dims), capture->host_allocator,
+        (void**)&dims));
+    for (iree_host_size_t i = 0; i < rank; ++i) {
+      dims[i] = (uint64_t)iree_hal_buffer_view_shape_dim(buffer_view, i);
+    }
+    value = (iree_trace_capture_value_t*)(capture->call_buffer.data +
+                                          value_offset);
+    value->kind = IREE_TRACE_CAPTURE_VALUE_BUFFER_VIEW;
+    value->type = iree_hal_buffer_view_element_type(buffer_view);
+    value->encoding = iree_hal_buffer_view_encoding_type(buffer_view);
+    value->count = (uint32_t)rank;
+    value->data = blob_ordinal;
+    return iree_ok_status();
+  } else if (iree_hal_buffer_isa(variant->ref)) {
+    iree_hal_buffer_t* buffer = iree_hal_buffer_deref(variant->ref);
+    iree_const_byte_span_t contents;
+    IREE_RETURN_IF_ERROR(iree_trace_capture_read_buffer(
+        capture, buffer, iree_hal_buffer_byte_length(buffer), &contents));
+    uint64_t blob_ordinal = 0;
+    IREE_RETURN_IF_ERROR(
+        iree_trace_capture_write_blob(capture, contents, &blob_ordinal));
+    value = (iree_trace_capture_value_t*)(capture->call_buffer.data +
+                                          value_offset);
+    value->kind = IREE_TRACE_CAPTURE_VALUE_BUFFER;
+    value->data = blob_ordinal;
+    return iree_ok_status();
+  } else if (iree_hal_fence_isa(variant->ref)) {
+    value->kind = IREE_TRACE_CAPTURE_VALUE_FENCE;
+    if (is_input) {
+      // Coarse-fences calls pass (wait, signal) as their last inputs; we track
+      // the last one so that we can wait for the outputs to be ready.
+      iree_hal_fence_t* fence = iree_hal_fence_deref(variant->ref);
+      iree_hal_fence_retain(fence);
+      iree_hal_fence_release(capture->call_fence);
+      capture->call_fence = fence;
+    }
+    return iree_ok_status();
+  } else if (iree_vm_list_isa(variant->ref)) {
+    iree_vm_list_t* list = iree_vm_list_deref(variant->ref);
+    value->kind = IREE_TRACE_CAPTURE_VALUE_LIST;
+    value->count = (uint32_t)iree_vm_list_size(list);
+    return iree_trace_capture_encode_list(capture, list, is_input);
+  }
+  iree_string_view_t type_name = iree_vm_ref_type_name(variant->type.ref_type);
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "capturing values of type '%.*s' is not supported",
+                          (int)type_name.size, type_name.data);
+}
+
+// Encodes all elements of |list| into the pending call record.
+static iree_status_t iree_trace_capture_encode_list(
+    iree_trace_capture_t* capture, iree_vm_list_t* list, bool is_input) {
+  iree_host_size_t count = list ? iree_vm_list_size(list) : 0;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(list, i, &variant));
+    IREE_RETURN_IF_ERROR(
+        iree_trace_capture_encode_variant(capture, &variant, is_input));
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_capture_begin_call(iree_trace_capture_t* capture,
+                                            const iree_vm_function_t* function,
+                                            iree_vm_list_t* input_list) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_ASSERT_ARGUMENT(function);
+  if (capture->call_pending) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "a call is already being captured");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Fully-qualified name such that it can be resolved in the context.
+  iree_string_view_t module_name = iree_vm_module_name(function->module);
+  iree_string_view_t function_name = iree_vm_function_name(function);
+  iree_host_size_t name_length = module_name.size + 1 + function_name.size;
+
+  capture->call_buffer.size = 0;
+  iree_trace_capture_call_t* call = NULL;
+  char* name = NULL;
+  iree_status_t status = iree_trace_capture_buffer_append(
+      &capture->call_buffer, sizeof(*call), capture->host_allocator,
+      (void**)&call);
+  if (iree_status_is_ok(status)) {
+    call->function_name_length = (uint32_t)name_length;
+    call->input_count =
+        input_list ? (uint32_t)iree_vm_list_size(input_list) : 0;
+    status = iree_trace_capture_buffer_append(
+        &capture->call_buffer, iree_host_align(name_length, 8),
+        capture->host_allocator, (void**)&name);
+  }
+  if (iree_status_is_ok(status)) {
+    memcpy(name, module_name.data, module_name.size);
+    name[module_name.size] = '.';
+    memcpy(name + module_name.size + 1, function_name.data,
+           function_name.size);
+    status = iree_trace_capture_encode_list(capture, input_list,
+                                            /*is_input=*/true);
+  }
+
+  if (iree_status_is_ok(status)) {
+    capture->call_pending = true;
+  } else {
+    iree_hal_fence_release(capture->call_fence);
+    capture->call_fence = NULL;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_trace_capture_end_call(iree_trace_capture_t* capture,
+                                          iree_status_code_t call_status,
+                                          iree_vm_list_t* output_list) {
+  IREE_ASSERT_ARGUMENT(capture);
+  if (!capture->call_pending) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no call is being captured");
+  }
+  capture->call_pending = false;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  if (call_status != IREE_STATUS_OK) output_list = NULL;
+  if (output_list && capture->call_fence) {
+    // Outputs of asynchronous calls are not ready until the fence signals.
+    status =
+        iree_hal_fence_wait(capture->call_fence, iree_infinite_timeout());
+  }
+  iree_hal_fence_release(capture->call_fence);
+  capture->call_fence = NULL;
+
+  if (iree_status_is_ok(status)) {
+    status = iree_trace_capture_encode_list(capture, output_list,
+                                            /*is_input=*/false);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_trace_capture_call_t* call =
+        (iree_trace_capture_call_t*)capture->call_buffer.data;
+    call->status_code = (uint32_t)call_status;
+    call->output_count =
+        output_list ? (uint32_t)iree_vm_list_size(output_list) : 0;
+    status = iree_trace_capture_write_record(
+        capture, IREE_TRACE_CAPTURE_RECORD_CALL, capture->call_buffer.data,
+        capture->call_buffer.size);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_trace_capture_observer_module_appended(
+    void* self, iree_vm_module_t* module,
+    iree_const_byte_span_t flatbuffer_data) {
+  return iree_trace_capture_append_module((iree_trace_capture_t*)self,
+                                          flatbuffer_data);
+}
+
+static iree_status_t iree_trace_capture_observer_call_begin(
+    void* self, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list) {
+  return iree_trace_capture_begin_call((iree_trace_capture_t*)self, function,
+                                       input_list);
+}
+
+static iree_status_t iree_trace_capture_observer_call_end(
+    void* self, const iree_vm_function_t* function,
+    iree_status_code_t call_status, iree_vm_list_t* output_list) {
+  return iree_trace_capture_end_call((iree_trace_capture_t*)self, call_status,
+                                     output_list);
+}
+
+iree_runtime_session_observer_t iree_trace_capture_session_observer(
+    iree_trace_capture_t* capture) {
+  iree_runtime_session_observer_t observer = {
+      .self = capture,
+      .module_appended = iree_trace_capture_observer_module_appended,
+      .call_begin = iree_trace_capture_observer_call_begin,
+      .call_end = iree_trace_capture_observer_call_end,
+  };
+  return observer;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_trace_capture_reader_t
+//===----------------------------------------------------------------------===//
+
+struct iree_trace_capture_reader_t {
+  iree_allocator_t host_allocator;
+  // Mapped file contents.
+  iree_file_contents_t* contents;
+  // Offset of the next record in |contents|.
+  iree_host_size_t offset;
+  // All blobs read so far indexed by ordinal.
+  iree_host_size_t blob_count;
+  iree_host_size_t blob_capacity;
+  iree_const_byte_span_t* blobs;
+};
+
+bool iree_trace_capture_file_is_binary(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+  char magic[sizeof(IREE_TRACE_CAPTURE_MAGIC) - 1] = {0};
+  bool is_binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                   memcmp(magic, IREE_TRACE_CAPTURE_MAGIC, sizeof(magic)) == 0;
+  fclose(file);
+  return is_binary;
+}
+
+iree_status_t iree_trace_capture_reader_open(
+    const char* path, iree_allocator_t host_allocator,
+    iree_trace_capture_reader_t** out_reader) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_reader);
+  *out_reader = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_trace_capture_reader_t* reader = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*reader),
+                                (void**)&reader));
+  memset(reader, 0, sizeof(*reader));
+  reader->host_allocator = host_allocator;
+
+  iree_status_t status =
+      iree_file_map_contents(path, host_allocator, &reader->contents);
+  if (iree_status_is_ok(status)) {
+    iree_trace_capture_file_header_t header;
+    iree_const_byte_span_t data = reader->contents->const_buffer;
+    if (data.data_length < sizeof(header)) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "file '%s' is not a binary trace", path);
+    } else {
+      memcpy(&header, data.data, sizeof(header));
+      if (memcmp(header.magic, IREE_TRACE_CAPTURE_MAGIC,
+                 sizeof(header.magic)) != 0) {
+        status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                  "file '%s' is not a binary trace", path);
+      } else if (header.version != IREE_TRACE_CAPTURE_VERSION) {
+        status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                  "binary trace version %u not supported",
+                                  header.version);
+      }
+      reader->offset = sizeof(header);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_reader = reader;
+  } else {
+    iree_trace_capture_reader_free(reader);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_trace_capture_reader_free(iree_trace_capture_reader_t* reader) {
+  if (!reader) return;
+  iree_allocator_t host_allocator = reader->host_allocator;
+  if (reader->contents) iree_file_contents_free(reader->contents);
+  iree_allocator_free(host_allocator, reader->blobs);
+  iree_allocator_free(host_allocator, reader);
+}
+
+// Validates |count| encoded values starting at |data| and returns the number of
+// bytes they occupy in |out_length|.
+static iree_status_t iree_trace_capture_measure_values(
+    iree_trace_capture_reader_t* reader, iree_const_byte_span_t data,
+    iree_host_size_t count, iree_host_size_t* out_length) {
+  iree_host_size_t offset = 0;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_trace_capture_value_t value;
+    if (data.data_length - offset < sizeof(value)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS, "truncated value");
+    }
+    memcpy(&value, data.data + offset, sizeof(value));
+    offset += sizeof(value);
+    switch (value.kind) {
+      case IREE_TRACE_CAPTURE_VALUE_NULL:
+      case IREE_TRACE_CAPTURE_VALUE_FENCE:
+        break;
+      case IREE_TRACE_CAPTURE_VALUE_PRIMITIVE:
+        if (value.type == IREE_VM_VALUE_TYPE_NONE ||
+            value.type > IREE_VM_VALUE_TYPE_MAX) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "invalid value type %u", value.type);
+        }
+        break;
+      case IREE_TRACE_CAPTURE_VALUE_BUFFER_VIEW:
+        if ((data.data_length - offset) / sizeof(uint64_t) < value.count) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS, "truncated shape");
+        }
+        offset += value.count * sizeof(uint64_t);
+        if (value.data >= reader->blob_count) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "reference to undefined blob %" PRIu64,
+                                  value.data);
+        }
+        break;
+      case IREE_TRACE_CAPTURE_VALUE_BUFFER:
+        if (value.data >= reader->blob_count) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "reference to undefined blob %" PRIu64,
+                                  value.data);
+        }
+        break;
+      case IREE_TRACE_CAPTURE_VALUE_LIST: {
+        iree_host_size_t list_length = 0;
+        IREE_RETURN_IF_ERROR(iree_trace_capture_measure_values(
+            reader,
+            iree_make_const_byte_span(data.data + offset,
+                                      data.data_length - offset),
+            value.count, &list_length));
+        offset += list_length;
+        break;
+      }
+      default:
+        return iree_make_status(IREE_STATUS_DATA_LOSS, "invalid value kind %u",
+                                value.kind);
+    }
+  }
+  *out_length = offset;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_trace_capture_reader_parse_call(
+    iree_trace_capture_reader_t* reader, iree_const_byte_span_t payload,
+    iree_trace_capture_event_t* out_event) {
+  iree_trace_capture_call_t call;
+  if (payload.data_length < sizeof(call)) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS, "truncated call record");
+  }
+  memcpy(&call, payload.data, sizeof(call));
+  iree_host_size_t offset = sizeof(call);
+  iree_host_size_t name_length = iree_host_align(call.function_name_length, 8);
+  if (payload.data_length - offset < name_length) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS, "truncated call record");
+  }
+  out_event->type = IREE_TRACE_CAPTURE_EVENT_CALL;
+  out_event->function_name = iree_make_string_view(
+      (const char*)payload.data + offset, call.function_name_length);
+  out_event->call_status = (iree_status_code_t)call.status_code;
+  offset += name_length;
+
+  iree_const_byte_span_t values = iree_make_const_byte_span(
+      payload.data + offset, payload.data_length - offset);
+  iree_host_size_t input_length = 0;
+  IREE_RETURN_IF_ERROR(iree_trace_capture_measure_values(
+      reader, values, call.input_count, &input_length));
+  out_event->inputs.count = call.input_count;
+  out_event->inputs.data = iree_make_const_byte_span(values.data, input_length);
+
+  values = iree_make_const_byte_span(values.data + input_length,
+                                     values.data_length - input_length);
+  iree_host_size_t output_length = 0;
+  IREE_RETURN_IF_ERROR(iree_trace_capture_measure_values(
+      reader, values, call.output_count, &output_length));
+  out_event->outputs.count = call.output_count;
+  out_event->outputs.data =
+      iree_make_const_byte_span(values.data, output_length);
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_capture_reader_next(
+    iree_trace_capture_reader_t* reader, iree_trace_capture_event_t* out_event,
+    bool* out_has_event) {
+  IREE_ASSERT_ARGUMENT(reader);
+  IREE_ASSERT_ARGUMENT(out_event);
+  IREE_ASSERT_ARGUMENT(out_has_event);
+  memset(out_event, 0, sizeof(*out_event));
+  *out_has_event = false;
+  iree_const_byte_span_t data = reader->contents->const_buffer;
+  while (reader->offset < data.data_length) {
+    iree_trace_capture_record_header_t header;
+    if (data.data_length - reader->offset < sizeof(header)) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "truncated record header at %" PRIhsz,
+                              reader->offset);
+    }
+    memcpy(&header, data.data + reader->offset, sizeof(header));
+    iree_host_size_t payload_offset = reader->offset + sizeof(header);
+    if (header.length > data.data_length - payload_offset) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "truncated record at %" PRIhsz, reader->offset);
+    }
+    iree_const_byte_span_t payload = iree_make_const_byte_span(
+        data.data + payload_offset, (iree_host_size_t)header.length);
+    reader->offset = iree_min(
+        data.data_length,
+        iree_host_align(payload_offset + (iree_host_size_t)header.length, 8));
+
+    switch (header.type) {
+      case IREE_TRACE_CAPTURE_RECORD_BLOB: {
+        if (reader->blob_count == reader->blob_capacity) {
+          iree_host_size_t new_capacity =
+              iree_max(reader->blob_capacity * 2, 16);
+          IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+              reader->host_allocator, new_capacity * sizeof(*reader->blobs),
+              (void**)&reader->blobs));
+          reader->blob_capacity = new_capacity;
+        }
+        reader->blobs[reader->blob_count++] = payload;
+        break;
+      }
+      case IREE_TRACE_CAPTURE_RECORD_MODULE: {
+        iree_trace_capture_module_t module;
+        if (payload.data_length < sizeof(module)) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "truncated module record");
+        }
+        memcpy(&module, payload.data, sizeof(module));
+        if (module.blob_ordinal >= reader->blob_count) {
+          return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                  "reference to undefined blob %" PRIu64,
+                                  module.blob_ordinal);
+        }
+        out_event->type = IREE_TRACE_CAPTURE_EVENT_MODULE;
+        out_event->module_data = reader->blobs[module.blob_ordinal];
+        *out_has_event = true;
+        return iree_ok_status();
+      }
+      case IREE_TRACE_CAPTURE_RECORD_CALL: {
+        IREE_RETURN_IF_ERROR(
+            iree_trace_capture_reader_parse_call(reader, payload, out_event));
+        *out_has_event = true;
+        return iree_ok_status();
+      }
+      default:
+        // Padding and unknown records are skipped.
+        break;
+    }
+  }
+  return iree_ok_status();
+}
+
+// Creates a buffer with the contents of blob |ordinal|.
+// Tries to import the mapped file memory directly before falling back to
+// allocating a new buffer and copying the contents.
+static iree_status_t iree_trace_capture_reader_make_buffer(
+    iree_trace_capture_reader_t* reader, uint64_t ordinal,
+    iree_hal_allocator_t* device_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_const_byte_span_t blob = reader->blobs[ordinal];
+  if (blob.data_length > 0) {
+    iree_hal_buffer_params_t import_params = {
+        .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+        .usage = IREE_HAL_BUFFER_USAGE_DEFAULT,
+        .access = IREE_HAL_MEMORY_ACCESS_READ,
+    };
+    iree_hal_external_buffer_t external_buffer = {
+        .type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+        .flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE,
+        .size = blob.data_length,
+        .handle.host_allocation.ptr = (void*)blob.data,
+    };
+    iree_status_t status = iree_hal_allocator_import_buffer(
+        device_allocator, import_params, &external_buffer,
+        iree_hal_buffer_release_callback_null(), out_buffer);
+    if (iree_status_is_ok(status)) return status;
+    iree_status_ignore(status);
+  }
+  iree_hal_buffer_params_t params = {
+      .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      .usage = IREE_HAL_BUFFER_USAGE_DEFAULT,
+  };
+  return iree_hal_allocator_allocate_buffer(
+      device_allocator, params, blob.data_length, blob, out_buffer);
+}
+
+// Decodes |count| values from |cursor| and appends them to |list|.
+// Values must have been validated with iree_trace_capture_measure_values.
+static iree_status_t iree_trace_capture_reader_decode_values(
+    iree_trace_capture_reader_t* reader, const uint8_t** cursor,
+    iree_host_size_t count, iree_hal_allocator_t* device_allocator,
+    iree_allocator_t host_allocator, iree_vm_list_t* list) {
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_trace_capture_value_t value;
+    memcpy(&value, *cursor, sizeof(value));
+    *cursor += sizeof(value);
+    switch (value.kind) {
+      default:  // validated by iree_trace_capture_measure_values
+      case IREE_TRACE_CAPTURE_VALUE_NULL:
+      case IREE_TRACE_CAPTURE_VALUE_FENCE: {
+        iree_vm_ref_t null_ref = {0};
+        IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_retain(list, &null_ref));
+        break;
+      }
+      case IREE_TRACE_CAPTURE_VALUE_PRIMITIVE: {
+        iree_vm_value_t primitive;
+        memset(&primitive, 0, sizeof(primitive));
+        primitive.type = (iree_vm_value_type_t)value.type;
+        memcpy(primitive.value_storage, &value.data, sizeof(value.data));
+        IREE_RETURN_IF_ERROR(iree_vm_list_push_value(list, &primitive));
+        break;
+      }
+      case IREE_TRACE_CAPTURE_VALUE_BUFFER: {
+        iree_hal_buffer_t* buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_trace_capture_reader_make_buffer(
+            reader, value.data, device_allocator, &buffer));
+        iree_vm_ref_t buffer_ref = iree_hal_buffer_move_ref(buffer);
+        IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_move(list, &buffer_ref));
+        break;
+      }
+      case IREE_TRACE_CAPTURE_VALUE_BUFFER_VIEW: {
+        iree_hal_dim_t* shape =
+            (iree_hal_dim_t*)iree_alloca(value.count * sizeof(iree_hal_dim_t));
+        for (uint32_t j = 0; j < value.count; ++j) {
+          uint64_t dim = 0;
+          memcpy(&dim, *cursor, sizeof(dim));
+          *cursor += sizeof(dim);
+          shape[j] = (iree_hal_dim_t)dim;
+        }
+        iree_hal_buffer_t* buffer = NULL;
+        IREE_RETURN_IF_ERROR(iree_trace_capture_reader_make_buffer(
+            reader, value.data, device_allocator, &buffer));
+        iree_hal_buffer_view_t* buffer_view = NULL;
+        iree_status_t status = iree_hal_buffer_view_create(
+            buffer, value.count, shape, (iree_hal_element_type_t)value.type,
+            (iree_hal_encoding_type_t)value.encoding, host_allocator,
+            &buffer_view);
+        iree_hal_buffer_release(buffer);
+        IREE_RETURN_IF_ERROR(status);
+        iree_vm_ref_t buffer_view_ref =
+            iree_hal_buffer_view_move_ref(buffer_view);
+        IREE_RETURN_IF_ERROR(
+            iree_vm_list_push_ref_move(list, &buffer_view_ref));
+        break;
+      }
+      case IREE_TRACE_CAPTURE_VALUE_LIST: {
+        iree_vm_list_t* child_list = NULL;
+        IREE_RETURN_IF_ERROR(iree_vm_list_create(
+            /*element_type=*/NULL, value.count, host_allocator, &child_list));
+        iree_status_t status = iree_trace_capture_reader_decode_values(
+            reader, cursor, value.count, device_allocator, host_allocator,
+            child_list);
+        if (iree_status_is_ok(status)) {
+          iree_vm_ref_t child_list_ref = iree_vm_list_move_ref(child_list);
+          status = iree_vm_list_push_ref_move(list, &child_list_ref);
+        } else {
+          iree_vm_list_release(child_list);
+        }
+        IREE_RETURN_IF_ERROR(status);
+        break;
+      }
+    }
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_trace_capture_reader_make_list(
+    iree_trace_capture_reader_t* reader, iree_trace_capture_values_t values,
+    iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
+    iree_vm_list_t** out_list) {
+  IREE_ASSERT_ARGUMENT(reader);
+  IREE_ASSERT_ARGUMENT(device_allocator);
+  IREE_ASSERT_ARGUMENT(out_list);
+  *out_list = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_list_t* list = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_list_create(/*element_type=*/NULL, values.count,
+                              host_allocator, &list));
+  const uint8_t* cursor = values.data.data;
+  iree_status_t status = iree_trace_capture_reader_decode_values(
+      reader, &cursor, values.count, device_allocator, host_allocator, list);
+  if (iree_status_is_ok(status)) {
+    *out_list = list;
+  } else {
+    iree_vm_list_release(list);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,224 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TOOLING_TRACE_CAPTURE_H_
+#define IREE_TOOLING_TRACE_CAPTURE_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/runtime/session.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Binary call traces captured from live programs.
+//
+// Unlike the YAML traces consumed by iree/tooling/trace_replay.h these are
+// produced by recording real calls and are designed to be replayed without any
+// parsing: the file is memory mapped and tensor contents are imported directly
+// from the mapping when the device supports it.
+//
+// File layout (all integers little-endian):
+//   iree_trace_capture_file_header_t
+//   iree_trace_capture_record_header_t + payload (8-byte aligned)
+//   ...
+//
+// Record types:
+//   PADDING: ignored; used to align blob contents.
+//   BLOB:    raw bytes (module flatbuffers, tensor contents) starting at a
+//            64-byte aligned file offset. Blobs are implicitly numbered in file
+//            order and identical contents are only stored once.
+//   MODULE:  a bytecode module to append to the context, referencing a blob.
+//   CALL:    a function call with its encoded inputs and outputs.
+//
+// Blobs are always written before the records that reference them so that the
+// file can be consumed in a single pass.
+
+#define IREE_TRACE_CAPTURE_MAGIC "IREETRAC"
+#define IREE_TRACE_CAPTURE_VERSION 1
+
+// Alignment of blob contents in the file.
+#define IREE_TRACE_CAPTURE_BLOB_ALIGNMENT 64
+
+typedef struct iree_trace_capture_file_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+} iree_trace_capture_file_header_t;
+
+typedef enum iree_trace_capture_record_type_e {
+  IREE_TRACE_CAPTURE_RECORD_PADDING = 0,
+  IREE_TRACE_CAPTURE_RECORD_BLOB = 1,
+  IREE_TRACE_CAPTURE_RECORD_MODULE = 2,
+  IREE_TRACE_CAPTURE_RECORD_CALL = 3,
+} iree_trace_capture_record_type_t;
+
+typedef struct iree_trace_capture_record_header_t {
+  uint32_t type;  // iree_trace_capture_record_type_t
+  uint32_t reserved;
+  // Length of the payload following the header excluding alignment padding.
+  uint64_t length;
+} iree_trace_capture_record_header_t;
+
+// MODULE record payload.
+typedef struct iree_trace_capture_module_t {
+  // Ordinal of the blob containing the bytecode module flatbuffer.
+  uint64_t blob_ordinal;
+} iree_trace_capture_module_t;
+
+// CALL record payload. Followed by the function name padded to 8 bytes and
+// then |input_count| and |output_count| encoded values.
+typedef struct iree_trace_capture_call_t {
+  // Length of the fully-qualified function name (`module.function`).
+  uint32_t function_name_length;
+  // iree_status_code_t the call returned with. Outputs are empty on failure.
+  uint32_t status_code;
+  uint32_t input_count;
+  uint32_t output_count;
+} iree_trace_capture_call_t;
+
+typedef enum iree_trace_capture_value_kind_e {
+  // Null ref or empty variant.
+  IREE_TRACE_CAPTURE_VALUE_NULL = 0,
+  // Primitive value with |type| as iree_vm_value_type_t and |data| as bits.
+  IREE_TRACE_CAPTURE_VALUE_PRIMITIVE = 1,
+  // !hal.buffer with |data| as the blob ordinal of its contents.
+  IREE_TRACE_CAPTURE_VALUE_BUFFER = 2,
+  // !hal.buffer_view with |type| as the element type, |encoding| as the
+  // encoding type, |count| as the rank, and |data| as the blob ordinal of its
+  // contents. Followed by |count| uint64_t dimensions.
+  IREE_TRACE_CAPTURE_VALUE_BUFFER_VIEW = 3,
+  // !hal.fence; only the position is recorded and replays must provide their
+  // own fences (usually by waiting on none and signaling a new fence).
+  IREE_TRACE_CAPTURE_VALUE_FENCE = 4,
+  // !vm.list with |count| elements following as encoded values.
+  IREE_TRACE_CAPTURE_VALUE_LIST = 5,
+} iree_trace_capture_value_kind_t;
+
+typedef struct iree_trace_capture_value_t {
+  uint32_t kind;  // iree_trace_capture_value_kind_t
+  uint32_t type;
+  uint32_t encoding;
+  uint32_t count;
+  uint64_t data;
+} iree_trace_capture_value_t;
+
+//===----------------------------------------------------------------------===//
+// iree_trace_capture_t
+//===----------------------------------------------------------------------===//
+
+// Writes a binary trace of modules and calls to a file.
+// Input and output contents are deduplicated by a 64-bit content hash so that
+// repeatedly passing the same tensors (weights, constant inputs) only stores
+// them once.
+//
+// Thread-compatible; callers must synchronize if capturing from multiple
+// threads.
+typedef struct iree_trace_capture_t iree_trace_capture_t;
+
+// Creates a new trace capture writing to |path|, overwriting any existing file.
+// |device| is optional and used to read back buffers that are not host
+// mappable; without one such buffers fail to capture.
+iree_status_t iree_trace_capture_create(const char* path,
+                                        iree_hal_device_t* device,
+                                        iree_allocator_t host_allocator,
+                                        iree_trace_capture_t** out_capture);
+
+// Flushes any pending records, closes the file, and frees |capture|.
+void iree_trace_capture_free(iree_trace_capture_t* capture);
+
+// Records a bytecode module that should be appended to the context.
+iree_status_t iree_trace_capture_append_module(
+    iree_trace_capture_t* capture, iree_const_byte_span_t flatbuffer_data);
+
+// Begins recording a call to |function| with the given |input_list|.
+// Must be called before the function is invoked as calls may consume or modify
+// their inputs and must be followed by iree_trace_capture_end_call.
+iree_status_t iree_trace_capture_begin_call(iree_trace_capture_t* capture,
+                                            const iree_vm_function_t* function,
+                                            iree_vm_list_t* input_list);
+
+// Ends recording a call begun with iree_trace_capture_begin_call.
+// |output_list| is ignored if |call_status| is not OK. If the inputs included
+// fences the last is waited on before reading the outputs so that asynchronous
+// results are captured.
+iree_status_t iree_trace_capture_end_call(iree_trace_capture_t* capture,
+                                          iree_status_code_t call_status,
+                                          iree_vm_list_t* output_list);
+
+// Returns a session observer that records all modules and calls made through
+// the session into |capture|. See iree_runtime_session_set_observer.
+iree_runtime_session_observer_t iree_trace_capture_session_observer(
+    iree_trace_capture_t* capture);
+
+//===----------------------------------------------------------------------===//
+// iree_trace_capture_reader_t
+//===----------------------------------------------------------------------===//
+
+// Reads a binary trace written by iree_trace_capture_t.
+// The file is memory mapped and all returned data references the mapping;
+// the reader must remain live for as long as any event data or lists created
+// from it are in use.
+typedef struct iree_trace_capture_reader_t iree_trace_capture_reader_t;
+
+// Encoded values referencing the file mapping.
+typedef struct iree_trace_capture_values_t {
+  iree_host_size_t count;
+  iree_const_byte_span_t data;
+} iree_trace_capture_values_t;
+
+typedef enum iree_trace_capture_event_type_e {
+  IREE_TRACE_CAPTURE_EVENT_MODULE = 0,
+  IREE_TRACE_CAPTURE_EVENT_CALL = 1,
+} iree_trace_capture_event_type_t;
+
+typedef struct iree_trace_capture_event_t {
+  iree_trace_capture_event_type_t type;
+  // IREE_TRACE_CAPTURE_EVENT_MODULE: bytecode module flatbuffer.
+  iree_const_byte_span_t module_data;
+  // IREE_TRACE_CAPTURE_EVENT_CALL: fully-qualified function name.
+  iree_string_view_t function_name;
+  // IREE_TRACE_CAPTURE_EVENT_CALL: status code the call returned.
+  iree_status_code_t call_status;
+  // IREE_TRACE_CAPTURE_EVENT_CALL: encoded call inputs and outputs.
+  iree_trace_capture_values_t inputs;
+  iree_trace_capture_values_t outputs;
+} iree_trace_capture_event_t;
+
+// Opens the binary trace at |path| for reading.
+// Fails with IREE_STATUS_INVALID_ARGUMENT if the file is not a binary trace.
+iree_status_t iree_trace_capture_reader_open(
+    const char* path, iree_allocator_t host_allocator,
+    iree_trace_capture_reader_t** out_reader);
+
+// Closes the file mapping and frees |reader|.
+void iree_trace_capture_reader_free(iree_trace_capture_reader_t* reader);
+
+// Reads the next event from the trace into |out_event|.
+// Sets |out_has_event| to false when the end of the trace has been reached.
+iree_status_t iree_trace_capture_reader_next(
+    iree_trace_capture_reader_t* reader, iree_trace_capture_event_t* out_event,
+    bool* out_has_event);
+
+// Creates a list containing the decoded |values|.
+// Buffer contents are imported directly from the file mapping as read-only
+// when |device_allocator| supports it and are otherwise copied into new
+// device-local buffers. Fences are decoded as null refs.
+iree_status_t iree_trace_capture_reader_make_list(
+    iree_trace_capture_reader_t* reader, iree_trace_capture_values_t values,
+    iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
+    iree_vm_list_t** out_list);
+
+// Returns true if the file at |path| starts with the binary trace magic.
+bool iree_trace_capture_file_is_binary(const char* path);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_TOOLING_TRACE_CAPTURE_H_
@@ -0,0 +1,211 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/tooling/trace_capture.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/modules/hal/types.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/native_module_test.h"
+
+namespace {
+
+class TraceCaptureTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(
+        iree_vm_instance_create(iree_allocator_system(), &instance_));
+    IREE_ASSERT_OK(iree_hal_module_register_all_types(instance_));
+    IREE_ASSERT_OK(
+        module_a_create(instance_, iree_allocator_system(), &module_));
+    IREE_ASSERT_OK(iree_vm_module_lookup_function_by_name(
+        module_, IREE_VM_FUNCTION_LINKAGE_EXPORT, IREE_SV("add_1"),
+        &function_));
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("heap"), iree_allocator_system(), iree_allocator_system(),
+        &device_allocator_));
+    const char* tmpdir = getenv("TEST_TMPDIR");
+    if (!tmpdir) tmpdir = getenv("TMPDIR");
+    if (!tmpdir) tmpdir = "/tmp";
+    path_ = std::string(tmpdir) + "/iree_trace_capture_test.ireetrace";
+  }
+
+  void TearDown() override {
+    remove(path_.c_str());
+    iree_hal_allocator_release(device_allocator_);
+    iree_vm_module_release(module_);
+    iree_vm_instance_release(instance_);
+  }
+
+  // Returns a new list containing an i32 and a 2x3xi32 buffer view.
+  iree_vm_list_t* MakeInputs(int32_t scalar, int32_t fill) {
+    iree_vm_list_t* list = nullptr;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 2,
+                                      iree_allocator_system(), &list));
+    iree_vm_value_t value = iree_vm_value_make_i32(scalar);
+    IREE_CHECK_OK(iree_vm_list_push_value(list, &value));
+    std::vector<int32_t> contents(6, fill);
+    const iree_hal_dim_t shape[2] = {2, 3};
+    iree_hal_buffer_params_t params = {0};
+    params.type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
+    params.usage = IREE_HAL_BUFFER_USAGE_DEFAULT;
+    iree_hal_buffer_view_t* buffer_view = nullptr;
+    IREE_CHECK_OK(iree_hal_buffer_view_allocate_buffer(
+        device_allocator_, IREE_ARRAYSIZE(shape), shape,
+        IREE_HAL_ELEMENT_TYPE_INT_32, IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+        params,
+        iree_make_const_byte_span(contents.data(),
+                                  contents.size() * sizeof(int32_t)),
+        &buffer_view));
+    iree_vm_ref_t buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+    IREE_CHECK_OK(iree_vm_list_push_ref_move(list, &buffer_view_ref));
+    return list;
+  }
+
+  // Verifies |list| matches the contents produced by MakeInputs.
+  void ExpectInputs(iree_vm_list_t* list, int32_t scalar, int32_t fill) {
+    ASSERT_EQ(iree_vm_list_size(list), 2);
+    iree_vm_value_t value;
+    IREE_ASSERT_OK(iree_vm_list_get_value(list, 0, &value));
+    EXPECT_EQ(value.type, IREE_VM_VALUE_TYPE_I32);
+    EXPECT_EQ(value.i32, scalar);
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_ASSERT_OK(iree_vm_list_get_variant(list, 1, &variant));
+    ASSERT_TRUE(iree_hal_buffer_view_isa(variant.ref));
+    iree_hal_buffer_view_t* buffer_view =
+        iree_hal_buffer_view_deref(variant.ref);
+    ASSERT_EQ(iree_hal_buffer_view_shape_rank(buffer_view), 2);
+    EXPECT_EQ(iree_hal_buffer_view_shape_dim(buffer_view, 0), 2);
+    EXPECT_EQ(iree_hal_buffer_view_shape_dim(buffer_view, 1), 3);
+    EXPECT_EQ(iree_hal_buffer_view_element_type(buffer_view),
+              IREE_HAL_ELEMENT_TYPE_INT_32);
+    std::vector<int32_t> contents(6);
+    IREE_ASSERT_OK(iree_hal_buffer_map_read(
+        iree_hal_buffer_view_buffer(buffer_view), 0, contents.data(),
+        contents.size() * sizeof(int32_t)));
+    for (int32_t element : contents) EXPECT_EQ(element, fill);
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_module_t* module_ = nullptr;
+  iree_vm_function_t function_;
+  iree_hal_allocator_t* device_allocator_ = nullptr;
+  std::string path_;
+};
+
+TEST_F(TraceCaptureTest, RoundTrip) {
+  const uint8_t module_data[] = {1, 2, 3, 4, 5};
+
+  iree_trace_capture_t* capture = nullptr;
+  IREE_ASSERT_OK(iree_trace_capture_create(path_.c_str(), /*device=*/nullptr,
+                                           iree_allocator_system(), &capture));
+  IREE_ASSERT_OK(iree_trace_capture_append_module(
+      capture, iree_make_const_byte_span(module_data, sizeof(module_data))));
+  for (int32_t i = 0; i < 3; ++i) {
+    // The first two calls have identical tensor contents.
+    iree_vm_list_t* inputs = MakeInputs(i, i < 2 ? 7 : 8);
+    iree_vm_list_t* outputs = MakeInputs(100 + i, 9);
+    IREE_ASSERT_OK(iree_trace_capture_begin_call(capture, &function_, inputs));
+    IREE_ASSERT_OK(
+        iree_trace_capture_end_call(capture, IREE_STATUS_OK, outputs));
+    iree_vm_list_release(inputs);
+    iree_vm_list_release(outputs);
+  }
+  iree_trace_capture_free(capture);
+
+  EXPECT_TRUE(iree_trace_capture_file_is_binary(path_.c_str()));
+
+  iree_trace_capture_reader_t* reader = nullptr;
+  IREE_ASSERT_OK(iree_trace_capture_reader_open(
+      path_.c_str(), iree_allocator_system(), &reader));
+
+  iree_trace_capture_event_t event;
+  bool has_event = false;
+  IREE_ASSERT_OK(iree_trace_capture_reader_next(reader, &event, &has_event));
+  ASSERT_TRUE(has_event);
+  ASSERT_EQ(event.type, IREE_TRACE_CAPTURE_EVENT_MODULE);
+  ASSERT_EQ(event.module_data.data_length, sizeof(module_data));
+  EXPECT_EQ(memcmp(event.module_data.data, module_data, sizeof(module_data)),
+            0);
+  EXPECT_EQ((uintptr_t)event.module_data.data %
+                IREE_TRACE_CAPTURE_BLOB_ALIGNMENT,
+            0);
+
+  for (int32_t i = 0; i < 3; ++i) {
+    IREE_ASSERT_OK(iree_trace_capture_reader_next(reader, &event, &has_event));
+    ASSERT_TRUE(has_event);
+    ASSERT_EQ(event.type, IREE_TRACE_CAPTURE_EVENT_CALL);
+    EXPECT_TRUE(iree_string_view_equal(event.function_name,
+                                       IREE_SV("module_a.add_1")));
+    EXPECT_EQ(event.call_status, IREE_STATUS_OK);
+    iree_vm_list_t* inputs = nullptr;
+    IREE_ASSERT_OK(iree_trace_capture_reader_make_list(
+        reader, event.inputs, device_allocator_, iree_allocator_system(),
+        &inputs));
+    ExpectInputs(inputs, i, i < 2 ? 7 : 8);
+    iree_vm_list_release(inputs);
+    iree_vm_list_t* outputs = nullptr;
+    IREE_ASSERT_OK(iree_trace_capture_reader_make_list(
+        reader, event.outputs, device_allocator_, iree_allocator_system(),
+        &outputs));
+    ExpectInputs(outputs, 100 + i, 9);
+    iree_vm_list_release(outputs);
+  }
+
+  IREE_ASSERT_OK(iree_trace_capture_reader_next(reader, &event, &has_event));
+  EXPECT_FALSE(has_event);
+  iree_trace_capture_reader_free(reader);
+
+  // Module + 3 unique tensor contents (7s, 9s, 8s) with padding.
+  iree_file_contents_t* contents = nullptr;
+  IREE_ASSERT_OK(iree_file_read_contents(path_.c_str(),
+                                         iree_allocator_system(), &contents));
+  EXPECT_LT(contents->const_buffer.data_length, 1024);
+  iree_file_contents_free(contents);
+}
+
+TEST_F(TraceCaptureTest, FailedCallHasNoOutputs) {
+  iree_trace_capture_t* capture = nullptr;
+  IREE_ASSERT_OK(iree_trace_capture_create(path_.c_str(), /*device=*/nullptr,
+                                           iree_allocator_system(), &capture));
+  iree_vm_list_t* inputs = MakeInputs(1, 2);
+  IREE_ASSERT_OK(iree_trace_capture_begin_call(capture, &function_, inputs));
+  IREE_ASSERT_OK(iree_trace_capture_end_call(
+      capture, IREE_STATUS_RESOURCE_EXHAUSTED, inputs));
+  iree_vm_list_release(inputs);
+  iree_trace_capture_free(capture);
+
+  iree_trace_capture_reader_t* reader = nullptr;
+  IREE_ASSERT_OK(iree_trace_capture_reader_open(
+      path_.c_str(), iree_allocator_system(), &reader));
+  iree_trace_capture_event_t event;
+  bool has_event = false;
+  IREE_ASSERT_OK(iree_trace_capture_reader_next(reader, &event, &has_event));
+  ASSERT_TRUE(has_event);
+  EXPECT_EQ(event.call_status, IREE_STATUS_RESOURCE_EXHAUSTED);
+  EXPECT_EQ(event.inputs.count, 2);
+  EXPECT_EQ(event.outputs.count, 0);
+  iree_trace_capture_reader_free(reader);
+}
+
+TEST_F(TraceCaptureTest, RejectsNonTraceFiles) {
+  const char kContents[] = "type: call\n";
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path_.c_str(), iree_make_const_byte_span(kContents, sizeof(kContents))));
+  EXPECT_FALSE(iree_trace_capture_file_is_binary(path_.c_str()));
+  iree_trace_capture_reader_t* reader = nullptr;
+  iree_status_t status = iree_trace_capture_reader_open(
+      path_.c_str(), iree_allocator_system(), &reader);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+}
+
+}  // namespace
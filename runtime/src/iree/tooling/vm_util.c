@@ -26,6 +26,14 @@ static iree_status_t iree_allocate_and_copy_cstring_from_view(
   return iree_ok_status();
 }
 
+static iree_status_t iree_tooling_push_npz_ndarray(
+    void* user_data, iree_string_view_t name,
+    iree_hal_buffer_view_t* buffer_view) {
+  iree_vm_list_t* variant_list = (iree_vm_list_t*)user_data;
+  iree_vm_ref_t buffer_view_ref = iree_hal_buffer_view_retain_ref(buffer_view);
+  return iree_vm_list_push_ref_move(variant_list, &buffer_view_ref);
+}
+
 static iree_status_t iree_tooling_load_ndarrays_from_file(
     iree_string_view_t file_path, iree_hal_allocator_t* device_allocator,
     iree_vm_list_t* variant_list) {
@@ -48,11 +56,27 @@ static iree_status_t iree_tooling_load_ndarrays_from_file(
   buffer_params.access = IREE_HAL_MEMORY_ACCESS_READ;
   buffer_params.type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
 
+  // Inputs are read-only so we map the file and let the device use the
+  // contents directly when possible instead of copying them.
+  iree_numpy_npy_load_options_t options = IREE_NUMPY_NPY_LOAD_OPTION_MAP_FILE;
+
+  if (iree_string_view_ends_with(file_path, IREE_SV(".npz"))) {
+    iree_numpy_npz_entry_callback_t callback = {
+        .fn = iree_tooling_push_npz_ndarray,
+        .user_data = variant_list,
+    };
+    if (iree_status_is_ok(status)) {
+      status = iree_numpy_npz_load_ndarrays(file, options, buffer_params,
+                                            device_allocator, callback);
+    }
+    fclose(file);
+    return status;
+  }
+
   while (iree_status_is_ok(status) && !iree_file_is_at(file, file_length)) {
     iree_hal_buffer_view_t* buffer_view = NULL;
-    status = iree_numpy_npy_load_ndarray(
-        file, IREE_NUMPY_NPY_LOAD_OPTION_DEFAULT, buffer_params,
-        device_allocator, &buffer_view);
+    status = iree_numpy_npy_load_ndarray(file, options, buffer_params,
+                                         device_allocator, &buffer_view);
     if (iree_status_is_ok(status)) {
       iree_vm_ref_t buffer_view_ref =
           iree_hal_buffer_view_retain_ref(buffer_view);
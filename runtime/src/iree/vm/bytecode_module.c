@@ -11,6 +11,8 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/lz4.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module_impl.h"
@@ -236,6 +238,92 @@ static iree_status_t iree_vm_bytecode_module_resolve_types(
   return status;
 }
 
+// Returns the data of |segment| as stored in the archive (compressed or not).
+// External references must have been verified to be in range.
+static iree_const_byte_span_t iree_vm_bytecode_module_rodata_segment_data(
+    iree_const_byte_span_t archive_contents,
+    iree_host_size_t archive_rodata_offset,
+    iree_vm_RodataSegmentDef_table_t segment) {
+  if (iree_vm_RodataSegmentDef_embedded_data_is_present(segment)) {
+    // Data is embedded in the FlatBuffer.
+    flatbuffers_uint8_vec_t embedded_data =
+        iree_vm_RodataSegmentDef_embedded_data(segment);
+    return iree_make_const_byte_span(embedded_data,
+                                     flatbuffers_uint8_vec_len(embedded_data));
+  }
+  // Data is concatenated with the FlatBuffer at some relative offset.
+  return iree_make_const_byte_span(
+      archive_contents.data + archive_rodata_offset +
+          iree_vm_RodataSegmentDef_external_data_offset(segment),
+      iree_vm_RodataSegmentDef_external_data_length(segment));
+}
+
+// Returns true if |segment| is stored compressed in the archive.
+static bool iree_vm_bytecode_module_rodata_segment_is_compressed(
+    iree_vm_RodataSegmentDef_table_t segment) {
+  return iree_vm_RodataSegmentDef_compression_type_type(segment) ==
+         iree_vm_CompressionTypeDef_LZ4BlockCompressedDataDef;
+}
+
+// Verifies that the compression parameters of rodata |segment| are consistent
+// with the |data_length| bytes it occupies in the archive.
+static iree_status_t iree_vm_bytecode_module_verify_rodata_compression(
+    iree_host_size_t segment_ordinal, iree_vm_RodataSegmentDef_table_t segment,
+    uint64_t data_length) {
+  switch (iree_vm_RodataSegmentDef_compression_type_type(segment)) {
+    case iree_vm_CompressionTypeDef_NONE:
+    case iree_vm_CompressionTypeDef_UncompressedDataDef:
+      return iree_ok_status();
+    case iree_vm_CompressionTypeDef_LZ4BlockCompressedDataDef:
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "rodata[%zu] uses an unsupported compression "
+                              "type",
+                              segment_ordinal);
+  }
+
+  iree_vm_LZ4BlockCompressedDataDef_table_t lz4_def =
+      (iree_vm_LZ4BlockCompressedDataDef_table_t)
+          iree_vm_RodataSegmentDef_compression_type(segment);
+  uint64_t uncompressed_length =
+      iree_vm_LZ4BlockCompressedDataDef_uncompressed_length(lz4_def);
+  uint32_t block_length =
+      iree_vm_LZ4BlockCompressedDataDef_block_length(lz4_def);
+  flatbuffers_uint32_vec_t block_compressed_lengths =
+      iree_vm_LZ4BlockCompressedDataDef_block_compressed_lengths(lz4_def);
+  if (uncompressed_length > IREE_HOST_SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "rodata[%zu] uncompressed length exceeds the "
+                            "addressable host memory",
+                            segment_ordinal);
+  }
+  if (block_length == 0 || block_length > IREE_LZ4_MAX_BLOCK_LENGTH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "rodata[%zu] has an invalid block length of %u",
+                            segment_ordinal, block_length);
+  }
+  uint64_t block_count = uncompressed_length / block_length +
+                         (uncompressed_length % block_length ? 1 : 0);
+  if (block_count != flatbuffers_uint32_vec_len(block_compressed_lengths)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "rodata[%zu] block count mismatch",
+                            segment_ordinal);
+  }
+  uint64_t compressed_length = 0;
+  for (iree_host_size_t i = 0; i < block_count; ++i) {
+    compressed_length +=
+        flatbuffers_uint32_vec_at(block_compressed_lengths, i);
+  }
+  if (compressed_length != data_length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "rodata[%zu] compressed block lengths do not "
+                            "match the segment length",
+                            segment_ordinal);
+  }
+  return iree_ok_status();
+}
+
 // Verifies the structure of the FlatBuffer so that we can avoid doing so during
 // runtime. There are still some conditions we must be aware of (such as omitted
 // names on functions with internal linkage), however we shouldn't need to
@@ -284,19 +372,25 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
        ++i) {
     iree_vm_RodataSegmentDef_table_t segment =
         iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
-    if (iree_vm_RodataSegmentDef_embedded_data_is_present(segment)) {
-      continue;  // embedded data is verified by FlatBuffers
-    }
-    uint64_t segment_offset =
-        iree_vm_RodataSegmentDef_external_data_offset(segment);
-    uint64_t segment_length =
-        iree_vm_RodataSegmentDef_external_data_length(segment);
-    uint64_t segment_end =
-        archive_rodata_offset + segment_offset + segment_length;
-    if (segment_end > archive_contents.data_length) {
-      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                              "rodata[%zu] external reference out of range", i);
+    // Embedded data is verified by FlatBuffers.
+    if (!iree_vm_RodataSegmentDef_embedded_data_is_present(segment)) {
+      uint64_t segment_offset =
+          iree_vm_RodataSegmentDef_external_data_offset(segment);
+      uint64_t segment_length =
+          iree_vm_RodataSegmentDef_external_data_length(segment);
+      uint64_t segment_end =
+          archive_rodata_offset + segment_offset + segment_length;
+      if (segment_end > archive_contents.data_length) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "rodata[%zu] external reference out of range",
+                                i);
+      }
     }
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_verify_rodata_compression(
+        i, segment,
+        iree_vm_bytecode_module_rodata_segment_data(
+            archive_contents, archive_rodata_offset, segment)
+            .data_length));
   }
 
   iree_vm_ModuleDependencyDef_vec_t dependencies =
@@ -452,6 +546,12 @@ static void iree_vm_bytecode_module_destroy(void* self) {
   iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_allocator_free_aligned(module->allocator,
+                              module->decompressed_rodata_spans);
+  module->decompressed_rodata_spans = NULL;
+  iree_notification_deinitialize(&module->rodata_notification);
+  iree_slim_mutex_deinitialize(&module->rodata_mutex);
+
   module->def = NULL;
   iree_allocator_free(module->archive_allocator,
                       (void*)module->archive_contents.data);
@@ -936,6 +1036,298 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
   return offset;
 }
 
+//===----------------------------------------------------------------------===//
+// Rodata decompression
+//===----------------------------------------------------------------------===//
+
+// A single independently decompressible block of a compressed segment.
+typedef struct iree_vm_bytecode_rodata_block_t {
+  iree_const_byte_span_t source;
+  iree_byte_span_t target;
+} iree_vm_bytecode_rodata_block_t;
+
+// Decompression of all blocks as a grid dispatch on a loop.
+// Lives on the stack of the thread waiting for completion.
+typedef struct iree_vm_bytecode_rodata_decompression_t {
+  iree_vm_bytecode_module_t* module;
+  const iree_vm_bytecode_rodata_block_t* blocks;
+  // Set to 1 once the completion callback has stored |status|.
+  iree_atomic_int32_t completed;
+  iree_status_t status;
+} iree_vm_bytecode_rodata_decompression_t;
+
+static iree_status_t iree_vm_bytecode_rodata_decompress_block(
+    void* user_data, iree_loop_t loop, uint32_t workgroup_x,
+    uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_vm_bytecode_rodata_decompression_t* decompression =
+      (iree_vm_bytecode_rodata_decompression_t*)user_data;
+  const iree_vm_bytecode_rodata_block_t* block =
+      &decompression->blocks[workgroup_x];
+  return iree_lz4_block_decompress(block->source, block->target);
+}
+
+static iree_status_t iree_vm_bytecode_rodata_decompress_complete(
+    void* user_data, iree_loop_t loop, iree_status_t status) {
+  iree_vm_bytecode_rodata_decompression_t* decompression =
+      (iree_vm_bytecode_rodata_decompression_t*)user_data;
+  iree_vm_bytecode_module_t* module = decompression->module;
+  decompression->status = status;
+  // The waiter may return and release |decompression| as soon as this is
+  // observed; only the module (retained by the waiter) is used after.
+  iree_atomic_store_int32(&decompression->completed, 1,
+                          iree_memory_order_release);
+  iree_notification_post(&module->rodata_notification, IREE_ALL_WAITERS);
+  return iree_ok_status();
+}
+
+static bool iree_vm_bytecode_rodata_decompression_completed(void* arg) {
+  iree_vm_bytecode_rodata_decompression_t* decompression =
+      (iree_vm_bytecode_rodata_decompression_t*)arg;
+  return iree_atomic_load_int32(&decompression->completed,
+                                iree_memory_order_acquire) == 1;
+}
+
+// Decompresses |block_count| |blocks| as a grid dispatch on |loop| and waits
+// for them to complete.
+static iree_status_t iree_vm_bytecode_rodata_decompress_blocks_on_loop(
+    iree_vm_bytecode_module_t* module, iree_loop_t loop,
+    iree_host_size_t block_count,
+    const iree_vm_bytecode_rodata_block_t* blocks) {
+  if (block_count == 0) {
+    return iree_ok_status();
+  } else if (block_count > UINT32_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "too many compressed rodata blocks to dispatch");
+  }
+  iree_vm_bytecode_rodata_decompression_t decompression = {
+      .module = module,
+      .blocks = blocks,
+      .status = iree_ok_status(),
+  };
+  iree_atomic_store_int32(&decompression.completed, 0,
+                          iree_memory_order_relaxed);
+  const uint32_t workgroup_count_xyz[3] = {(uint32_t)block_count, 1, 1};
+  iree_status_t status = iree_loop_dispatch(
+      loop, workgroup_count_xyz, iree_vm_bytecode_rodata_decompress_block,
+      iree_vm_bytecode_rodata_decompress_complete, &decompression);
+  if (!iree_status_is_ok(status) &&
+      !iree_vm_bytecode_rodata_decompression_completed(&decompression)) {
+    // Failed to schedule the dispatch; the completion callback won't be
+    // issued.
+    return status;
+  }
+  iree_notification_await(&module->rodata_notification,
+                          iree_vm_bytecode_rodata_decompression_completed,
+                          &decompression, iree_infinite_timeout());
+  return iree_status_join(status, decompression.status);
+}
+
+// Returns the bytecode module implementation of |base_module| or NULL if it is
+// not a bytecode module.
+static iree_vm_bytecode_module_t* iree_vm_bytecode_module_cast(
+    iree_vm_module_t* base_module) {
+  if (base_module->destroy != iree_vm_bytecode_module_destroy) return NULL;
+  return (iree_vm_bytecode_module_t*)base_module->self;
+}
+
+// Walks the compressed rodata segments of |module| and accumulates their
+// counts and lengths into |statistics|.
+static void iree_vm_bytecode_module_count_compressed_rodata(
+    iree_vm_bytecode_module_t* module,
+    iree_vm_bytecode_module_rodata_statistics_t* statistics) {
+  iree_vm_RodataSegmentDef_vec_t rodata_segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module->def);
+  for (iree_host_size_t i = 0;
+       i < iree_vm_RodataSegmentDef_vec_len(rodata_segments); ++i) {
+    iree_vm_RodataSegmentDef_table_t segment =
+        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
+    if (!iree_vm_bytecode_module_rodata_segment_is_compressed(segment)) {
+      continue;
+    }
+    iree_vm_LZ4BlockCompressedDataDef_table_t lz4_def =
+        (iree_vm_LZ4BlockCompressedDataDef_table_t)
+            iree_vm_RodataSegmentDef_compression_type(segment);
+    ++statistics->compressed_segment_count;
+    statistics->compressed_length +=
+        iree_vm_bytecode_module_rodata_segment_data(
+            module->archive_contents, module->archive_rodata_offset, segment)
+            .data_length;
+    statistics->uncompressed_length +=
+        iree_vm_LZ4BlockCompressedDataDef_uncompressed_length(lz4_def);
+  }
+}
+
+// Decompresses all compressed rodata segments into module-owned storage.
+// Must be called with the rodata mutex held.
+static iree_status_t iree_vm_bytecode_module_decompress_rodata_locked(
+    iree_vm_bytecode_module_t* module, iree_loop_t loop) {
+  if (module->rodata_decompressed) return iree_ok_status();
+  iree_vm_RodataSegmentDef_vec_t rodata_segments =
+      iree_vm_BytecodeModuleDef_rodata_segments(module->def);
+  iree_host_size_t segment_count =
+      iree_vm_RodataSegmentDef_vec_len(rodata_segments);
+
+  // Size the storage for all segments (with the span table at the head) and
+  // count the blocks. Segment lengths were verified on load.
+  iree_host_size_t storage_size = iree_host_align(
+      segment_count * sizeof(iree_byte_span_t),
+      IREE_VM_ARCHIVE_SEGMENT_ALIGNMENT);
+  iree_host_size_t block_count = 0;
+  iree_host_size_t compressed_segment_count = 0;
+  for (iree_host_size_t i = 0; i < segment_count; ++i) {
+    iree_vm_RodataSegmentDef_table_t segment =
+        iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
+    if (!iree_vm_bytecode_module_rodata_segment_is_compressed(segment)) {
+      continue;
+    }
+    iree_vm_LZ4BlockCompressedDataDef_table_t lz4_def =
+        (iree_vm_LZ4BlockCompressedDataDef_table_t)
+            iree_vm_RodataSegmentDef_compression_type(segment);
+    iree_host_size_t uncompressed_length = (iree_host_size_t)
+        iree_vm_LZ4BlockCompressedDataDef_uncompressed_length(lz4_def);
+    iree_host_size_t aligned_length =
+        iree_host_align(uncompressed_length, IREE_VM_ARCHIVE_SEGMENT_ALIGNMENT);
+    if (aligned_length < uncompressed_length ||
+        aligned_length > IREE_HOST_SIZE_MAX - storage_size) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "decompressed rodata exceeds the addressable "
+                              "host memory");
+    }
+    storage_size += aligned_length;
+    block_count += flatbuffers_uint32_vec_len(
+        iree_vm_LZ4BlockCompressedDataDef_block_compressed_lengths(lz4_def));
+    ++compressed_segment_count;
+  }
+  if (!compressed_segment_count) {
+    module->rodata_decompressed = true;
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, storage_size);
+  iree_time_t start_time_ns = iree_time_now();
+
+  uint8_t* storage = NULL;
+  iree_vm_bytecode_rodata_block_t* blocks = NULL;
+  iree_status_t status = iree_allocator_malloc_aligned(
+      module->allocator, storage_size, IREE_VM_ARCHIVE_SEGMENT_ALIGNMENT,
+      /*offset=*/0, (void**)&storage);
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(module->allocator,
+                                   block_count * sizeof(*blocks),
+                                   (void**)&blocks);
+  }
+
+  // Assign each segment its range of the storage and split it into blocks.
+  if (iree_status_is_ok(status)) {
+    iree_byte_span_t* spans = (iree_byte_span_t*)storage;
+    uint8_t* target_ptr =
+        storage + iree_host_align(segment_count * sizeof(iree_byte_span_t),
+                                  IREE_VM_ARCHIVE_SEGMENT_ALIGNMENT);
+    iree_host_size_t block_ordinal = 0;
+    for (iree_host_size_t i = 0; i < segment_count; ++i) {
+      iree_vm_RodataSegmentDef_table_t segment =
+          iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
+      if (!iree_vm_bytecode_module_rodata_segment_is_compressed(segment)) {
+        spans[i] = iree_byte_span_empty();
+        continue;
+      }
+      iree_vm_LZ4BlockCompressedDataDef_table_t lz4_def =
+          (iree_vm_LZ4BlockCompressedDataDef_table_t)
+              iree_vm_RodataSegmentDef_compression_type(segment);
+      iree_host_size_t uncompressed_length = (iree_host_size_t)
+          iree_vm_LZ4BlockCompressedDataDef_uncompressed_length(lz4_def);
+      iree_host_size_t block_length =
+          iree_vm_LZ4BlockCompressedDataDef_block_length(lz4_def);
+      flatbuffers_uint32_vec_t block_compressed_lengths =
+          iree_vm_LZ4BlockCompressedDataDef_block_compressed_lengths(lz4_def);
+      spans[i] = iree_make_byte_span(target_ptr, uncompressed_length);
+
+      const uint8_t* source_ptr =
+          iree_vm_bytecode_module_rodata_segment_data(
+              module->archive_contents, module->archive_rodata_offset,
+              segment)
+              .data;
+      iree_host_size_t remaining_length = uncompressed_length;
+      for (iree_host_size_t j = 0;
+           j < flatbuffers_uint32_vec_len(block_compressed_lengths); ++j) {
+        uint32_t compressed_length =
+            flatbuffers_uint32_vec_at(block_compressed_lengths, j);
+        iree_host_size_t target_length = VMMIN(remaining_length, block_length);
+        iree_vm_bytecode_rodata_block_t* block = &blocks[block_ordinal++];
+        block->source =
+            iree_make_const_byte_span(source_ptr, compressed_length);
+        block->target = iree_make_byte_span(target_ptr, target_length);
+        source_ptr += compressed_length;
+        target_ptr += target_length;
+        remaining_length -= target_length;
+      }
+      target_ptr += iree_host_align(uncompressed_length,
+                                    IREE_VM_ARCHIVE_SEGMENT_ALIGNMENT) -
+                    uncompressed_length;
+    }
+  }
+
+  // Decompress all blocks of all segments.
+  if (iree_status_is_ok(status)) {
+    if (loop.ctl) {
+      status = iree_vm_bytecode_rodata_decompress_blocks_on_loop(
+          module, loop, block_count, blocks);
+    } else {
+      for (iree_host_size_t i = 0; i < block_count; ++i) {
+        status = iree_lz4_block_decompress(blocks[i].source, blocks[i].target);
+        if (!iree_status_is_ok(status)) break;
+      }
+    }
+  }
+
+  iree_allocator_free(module->allocator, blocks);
+  if (iree_status_is_ok(status)) {
+    module->decompressed_rodata_spans = (iree_byte_span_t*)storage;
+    module->rodata_decompressed = true;
+    module->rodata_decompression_duration_ns = iree_time_now() - start_time_ns;
+  } else {
+    iree_allocator_free_aligned(module->allocator, storage);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_decompress_rodata(
+    iree_vm_module_t* base_module, iree_loop_t loop) {
+  IREE_ASSERT_ARGUMENT(base_module);
+  iree_vm_bytecode_module_t* module = iree_vm_bytecode_module_cast(base_module);
+  if (!module) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "module is not a bytecode module");
+  }
+  iree_slim_mutex_lock(&module->rodata_mutex);
+  iree_status_t status =
+      iree_vm_bytecode_module_decompress_rodata_locked(module, loop);
+  iree_slim_mutex_unlock(&module->rodata_mutex);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_query_rodata_statistics(
+    iree_vm_module_t* base_module,
+    iree_vm_bytecode_module_rodata_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_module);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  iree_vm_bytecode_module_t* module = iree_vm_bytecode_module_cast(base_module);
+  if (!module) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "module is not a bytecode module");
+  }
+  iree_vm_bytecode_module_count_compressed_rodata(module, out_statistics);
+  iree_slim_mutex_lock(&module->rodata_mutex);
+  out_statistics->decompression_duration_ns =
+      module->rodata_decompression_duration_ns;
+  iree_slim_mutex_unlock(&module->rodata_mutex);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_vm_bytecode_module_alloc_state(
     void* self, iree_allocator_t allocator,
     iree_vm_module_state_t** out_module_state) {
@@ -960,27 +1352,37 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   // Perform layout to get the pointers into the storage for each nested table.
   iree_vm_bytecode_module_layout_state(module_def, state);
 
-  // Setup rodata segments to point directly at the FlatBuffer memory.
+  // Decompress any compressed rodata segments if this is the first state
+  // allocated and they were not decompressed ahead of time. State allocation
+  // has no loop to schedule work on so this is always serial; callers wanting
+  // parallel decompression must call
+  // iree_vm_bytecode_module_decompress_rodata before creating a context.
+  iree_status_t status = iree_vm_bytecode_module_decompress_rodata(
+      &module->interface, iree_loop_null());
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(allocator, state);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Setup rodata segments to point directly at the FlatBuffer memory or the
+  // decompressed contents owned by the module.
   iree_vm_RodataSegmentDef_vec_t rodata_segments =
       iree_vm_BytecodeModuleDef_rodata_segments(module_def);
   for (int i = 0; i < state->rodata_ref_count; ++i) {
     iree_vm_RodataSegmentDef_table_t segment =
         iree_vm_RodataSegmentDef_vec_at(rodata_segments, i);
     iree_byte_span_t byte_span = iree_byte_span_empty();
-    if (iree_vm_RodataSegmentDef_embedded_data_is_present(segment)) {
-      // Data is embedded in the FlatBuffer.
-      byte_span = iree_make_byte_span(
-          (uint8_t*)iree_vm_RodataSegmentDef_embedded_data(segment),
-          flatbuffers_uint8_vec_len(
-              iree_vm_RodataSegmentDef_embedded_data(segment)));
+    if (iree_vm_bytecode_module_rodata_segment_is_compressed(segment)) {
+      byte_span = module->decompressed_rodata_spans[i];
     } else {
-      // Data is concatenated with the FlatBuffer at some relative offset.
       // Note that we've already verified the referenced range is in bounds.
-      byte_span = iree_make_byte_span(
-          (uint8_t*)module->archive_contents.data +
-              module->archive_rodata_offset +
-              iree_vm_RodataSegmentDef_external_data_offset(segment),
-          iree_vm_RodataSegmentDef_external_data_length(segment));
+      iree_const_byte_span_t data_span =
+          iree_vm_bytecode_module_rodata_segment_data(
+              module->archive_contents, module->archive_rodata_offset,
+              segment);
+      byte_span =
+          iree_make_byte_span((uint8_t*)data_span.data, data_span.data_length);
     }
     iree_vm_buffer_t* ref = &state->rodata_ref_table[i];
     iree_vm_buffer_initialize(IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE, byte_span,
@@ -1188,6 +1590,12 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     return resolve_status;
   }
 
+  iree_slim_mutex_initialize(&module->rodata_mutex);
+  iree_notification_initialize(&module->rodata_notification);
+  module->rodata_decompressed = false;
+  module->rodata_decompression_duration_ns = 0;
+  module->decompressed_rodata_spans = NULL;
+
   iree_vm_module_initialize(&module->interface, module);
   module->interface.destroy = iree_vm_bytecode_module_destroy;
   module->interface.name = iree_vm_bytecode_module_name;
@@ -34,6 +34,42 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_parse_header(
     iree_const_byte_span_t* out_flatbuffer_contents,
     iree_host_size_t* out_rodata_offset);
 
+// Statistics describing the compressed rodata segments of a bytecode module.
+typedef struct iree_vm_bytecode_module_rodata_statistics_t {
+  // Number of rodata segments stored compressed in the archive.
+  iree_host_size_t compressed_segment_count;
+  // Total length of the compressed segments in the archive.
+  uint64_t compressed_length;
+  // Total length of the compressed segments once decompressed.
+  uint64_t uncompressed_length;
+  // Wall time spent decompressing or 0 if not yet decompressed.
+  iree_duration_t decompression_duration_ns;
+} iree_vm_bytecode_module_rodata_statistics_t;
+
+// Decompresses all compressed rodata segments in the bytecode |module|.
+//
+// Compressed segments are decompressed lazily: by default this happens on the
+// calling thread when the first module state is allocated (such as when the
+// module is first added to a context). Calling this beforehand allows the
+// work to be parallelized: segments are split into independent blocks that
+// are decompressed as a grid dispatch on |loop|, such as a loop from
+// iree_loop_task_scope running on a task executor, and this call blocks until
+// all blocks have completed. The |loop| must make progress independently of
+// the calling thread. Passing iree_loop_null() decompresses on the calling
+// thread. The decompressed contents are aligned to the archive segment
+// alignment and live as long as the module.
+//
+// This is a no-op if the module has no compressed segments or they have
+// already been decompressed.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_decompress_rodata(
+    iree_vm_module_t* module, iree_loop_t loop);
+
+// Queries statistics about the compressed rodata segments of the bytecode
+// |module| and their decompression (if it has happened).
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_query_rodata_statistics(
+    iree_vm_module_t* module,
+    iree_vm_bytecode_module_rodata_statistics_t* out_statistics);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -16,6 +16,7 @@
 #endif  // _MSC_VER
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/vm/api.h"
 
 // NOTE: include order matters:
@@ -83,6 +84,21 @@ typedef struct iree_vm_bytecode_module_t {
   // Loaded FlatBuffer module pointing into the archive contents.
   iree_vm_BytecodeModuleDef_table_t def;
 
+  // Guards lazy decompression of compressed rodata segments.
+  iree_slim_mutex_t rodata_mutex;
+  // Posted when decompression scheduled on a loop completes.
+  iree_notification_t rodata_notification;
+  // True once all compressed rodata segments have been decompressed.
+  bool rodata_decompressed;
+  // Wall time spent decompressing the segments.
+  iree_duration_t rodata_decompression_duration_ns;
+  // Decompressed contents of each rodata segment indexed by segment ordinal.
+  // Entries for uncompressed segments are empty. The spans and the segment
+  // contents share a single allocation aligned to the archive segment
+  // alignment that is released with the module. NULL if the module has no
+  // compressed segments or they have not yet been decompressed.
+  iree_byte_span_t* decompressed_rodata_spans;
+
   // Type table mapping module type IDs to registered VM types.
   iree_host_size_t type_count;
   iree_vm_type_def_t type_table[];
@@ -124,9 +140,8 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_vm_ref_t* global_ref_table;
 
   // TODO(benvanik): move to iree_vm_bytecode_module_t if always static.
-  // Initialized references to rodata segments.
-  // Right now these don't do much, however we can perform lazy caching and
-  // on-the-fly decompression using this information.
+  // Initialized references to rodata segments. Compressed segments reference
+  // the decompressed contents owned by the module.
   iree_host_size_t rodata_ref_count;
   iree_vm_buffer_t* rodata_ref_table;
 
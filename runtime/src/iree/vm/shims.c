@@ -17,6 +17,7 @@ IREE_VM_ABI_DEFINE_SHIM(r, r);
 IREE_VM_ABI_DEFINE_SHIM(r, rI);
 IREE_VM_ABI_DEFINE_SHIM(r, v);
 IREE_VM_ABI_DEFINE_SHIM(rCiD, i);
+IREE_VM_ABI_DEFINE_SHIM(rCrD, rr);
 IREE_VM_ABI_DEFINE_SHIM(rCrD, v);
 IREE_VM_ABI_DEFINE_SHIM(ri, i);
 IREE_VM_ABI_DEFINE_SHIM(ri, ii);
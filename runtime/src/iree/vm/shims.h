@@ -572,6 +572,7 @@ IREE_VM_ABI_DECLARE_SHIM(r, r);
 IREE_VM_ABI_DECLARE_SHIM(r, rI);
 IREE_VM_ABI_DECLARE_SHIM(r, v);
 IREE_VM_ABI_DECLARE_SHIM(rCiD, i);
+IREE_VM_ABI_DECLARE_SHIM(rCrD, rr);
 IREE_VM_ABI_DECLARE_SHIM(rCrD, v);
 IREE_VM_ABI_DECLARE_SHIM(ri, i);
 IREE_VM_ABI_DECLARE_SHIM(ri, ii);
@@ -51,11 +51,26 @@
 // how the full program will run, though, and YMMV. Always verify timings with
 // an appropriate device-specific tool before trusting the more generic and
 // higher-level numbers from this tool.
+//
+// A throughput mode is available with --throughput_clients=N for measuring
+// sustained load instead of single-function latency. N client threads each
+// create their own context sharing a single device (and executor) and invoke
+// --entry_function= repeatedly. With --throughput_qps= requests arrive
+// open-loop (Poisson) at the given aggregate rate and latency is measured from
+// when each request was scheduled to arrive so that queuing delays are not
+// hidden. Without a rate each client issues requests back-to-back. After a
+// warmup period the achieved throughput, latency percentiles, and per-thread
+// CPU utilization (on Linux) of the runtime threads are reported.
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdio>
 #include <iterator>
+#include <map>
+#include <random>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -71,6 +86,11 @@
 #include "iree/tooling/vm_util_cc.h"
 #include "iree/vm/api.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <dirent.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
 constexpr char kNanosecondsUnitString[] = "ns";
 constexpr char kMicrosecondsUnitString[] = "us";
 constexpr char kMillisecondsUnitString[] = "ms";
@@ -92,6 +112,20 @@ IREE_FLAG(string, entry_function, "",
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(int32_t, throughput_clients, 0,
+          "Enables throughput mode with the given number of client threads.\n"
+          "Each client has its own context sharing a single device and invokes "
+          "--entry_function= repeatedly. google-benchmark is not used.");
+IREE_FLAG(double, throughput_qps, 0.0,
+          "Aggregate open-loop request arrival rate in requests per second "
+          "across all clients in throughput mode. Arrivals are Poisson "
+          "distributed. If 0 each client issues requests back-to-back.");
+IREE_FLAG(int32_t, throughput_warmup_ms, 1000,
+          "Duration in milliseconds requests are issued in throughput mode "
+          "before measurement begins.");
+IREE_FLAG(int32_t, throughput_duration_ms, 10000,
+          "Duration in milliseconds of the throughput mode measurement.");
+
 // TODO(benvanik): move --function_input= flag into a util.
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
@@ -125,6 +159,8 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=@some/file.bin\n"
     "numpy npy files (from numpy.save) can be read to provide 1+ values:\n"
     "  @some.npy\n"
+    "numpy npz files (from numpy.savez) can be read to provide 1+ values:\n"
+    "  @some.npz\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
@@ -425,6 +461,393 @@ void RegisterDispatchBenchmark(const std::string& function_name,
                                   : benchmark::kMicrosecond);
 }
 
+//===----------------------------------------------------------------------===//
+// Throughput mode
+//===----------------------------------------------------------------------===//
+
+// Per-thread CPU time sample keyed by thread ID.
+struct ThreadCpuTime {
+  std::string name;
+  uint64_t ticks = 0;
+};
+
+// Samples the CPU time of all threads in the process.
+// Returns an empty map if not supported on the platform.
+static std::map<int, ThreadCpuTime> SampleThreadCpuTimes() {
+  std::map<int, ThreadCpuTime> samples;
+#if defined(IREE_PLATFORM_LINUX)
+  DIR* dir = opendir("/proc/self/task");
+  if (!dir) return samples;
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') continue;
+    std::string path = std::string("/proc/self/task/") + entry->d_name;
+    FILE* file = fopen((path + "/stat").c_str(), "r");
+    if (!file) continue;
+    char buffer[1024];
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[length] = 0;
+    // Format: tid (comm) state ppid ... utime stime ...
+    // comm may contain spaces/parens so we scan from the last ')'.
+    char* name_begin = strchr(buffer, '(');
+    char* name_end = strrchr(buffer, ')');
+    if (!name_begin || !name_end) continue;
+    unsigned long long utime = 0, stime = 0;
+    if (sscanf(name_end + 2,
+               "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime,
+               &stime) != 2) {
+      continue;
+    }
+    ThreadCpuTime sample;
+    sample.name = std::string(name_begin + 1, name_end);
+    sample.ticks = utime + stime;
+    samples[atoi(entry->d_name)] = sample;
+  }
+  closedir(dir);
+#endif  // IREE_PLATFORM_LINUX
+  return samples;
+}
+
+// Returns the number of CPU time ticks per second used by ThreadCpuTime.
+static double GetCpuTicksPerSecond() {
+#if defined(IREE_PLATFORM_LINUX)
+  return (double)sysconf(_SC_CLK_TCK);
+#else
+  return 0.0;
+#endif  // IREE_PLATFORM_LINUX
+}
+
+// Results of a single throughput mode client.
+struct ThroughputClientResults {
+  std::vector<iree_duration_t> latencies_ns;
+  int64_t failure_count = 0;
+  Status first_failure;
+};
+
+// Shared state for all throughput mode clients.
+struct ThroughputState {
+  iree_hal_device_t* device = nullptr;
+  iree_vm_function_t function;
+  bool is_async = false;
+  iree_vm_list_t* inputs = nullptr;
+  // Per-client mean time between request arrivals or 0 if closed-loop.
+  double mean_interarrival_ns = 0.0;
+  // Requests scheduled to arrive in [measure_start_ns, measure_end_ns) are
+  // recorded. Clients stop issuing requests after measure_end_ns.
+  iree_time_t measure_start_ns = 0;
+  iree_time_t measure_end_ns = 0;
+};
+
+// Invokes the function once from a client's |context|.
+static iree_status_t InvokeThroughputRequest(
+    const ThroughputState& state, iree_vm_context_t* context,
+    iree_hal_semaphore_t* semaphore, uint64_t request_ordinal,
+    iree_vm_list_t* outputs) {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  if (!state.is_async) {
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, state.function, IREE_VM_INVOCATION_FLAG_NONE,
+        /*policy=*/nullptr, state.inputs, outputs, host_allocator));
+    return iree_vm_list_resize(outputs, 0);
+  }
+
+  // Coarse-fences functions take (wait, signal) fences after the inputs. We
+  // wait on nothing and block the client until the signal fence is reached.
+  vm::ref<iree_hal_fence_t> wait_fence;
+  vm::ref<iree_hal_fence_t> signal_fence;
+  IREE_RETURN_IF_ERROR(iree_hal_fence_create_at(
+      semaphore, request_ordinal + 1, host_allocator, &signal_fence));
+  vm::ref<iree_vm_list_t> inputs;
+  if (state.inputs) {
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_clone(state.inputs, host_allocator, &inputs));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 2,
+                                             host_allocator, &inputs));
+  }
+  IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_move(inputs.get(), wait_fence));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_push_ref_retain(inputs.get(), signal_fence));
+  IREE_RETURN_IF_ERROR(iree_vm_invoke(
+      context, state.function, IREE_VM_INVOCATION_FLAG_NONE,
+      /*policy=*/nullptr, inputs.get(), outputs, host_allocator));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_fence_wait(signal_fence.get(), iree_infinite_timeout()));
+  return iree_vm_list_resize(outputs, 0);
+}
+
+// Runs a single throughput mode client issuing requests on |context| until the
+// measurement window ends.
+static void RunThroughputClient(const ThroughputState& state,
+                                iree_vm_context_t* context,
+                                uint32_t client_ordinal,
+                                ThroughputClientResults* results) {
+  IREE_TRACE_SCOPE0("ThroughputClient");
+  vm::ref<iree_hal_semaphore_t> semaphore;
+  vm::ref<iree_vm_list_t> outputs;
+  iree_status_t status = iree_vm_list_create(
+      /*element_type=*/nullptr, 16, iree_allocator_system(), &outputs);
+  if (iree_status_is_ok(status) && state.is_async) {
+    status = iree_hal_semaphore_create(state.device, 0ull, &semaphore);
+  }
+  if (!iree_status_is_ok(status)) {
+    results->first_failure = std::move(status);
+    ++results->failure_count;
+    return;
+  }
+
+  // Each client gets an independent arrival stream such that the aggregate is
+  // a Poisson process at the requested rate.
+  std::mt19937_64 rng(0x1EEull + client_ordinal);
+  std::exponential_distribution<double> interarrival(
+      state.mean_interarrival_ns > 0.0 ? 1.0 / state.mean_interarrival_ns
+                                       : 1.0);
+  iree_time_t next_arrival_ns = iree_time_now();
+  for (uint64_t request_ordinal = 0;; ++request_ordinal) {
+    iree_time_t arrival_ns = iree_time_now();
+    if (state.mean_interarrival_ns > 0.0) {
+      // Open-loop: wait until the scheduled arrival time. If we are behind
+      // the request is issued immediately and the time spent waiting counts
+      // toward its latency.
+      next_arrival_ns += (iree_duration_t)interarrival(rng);
+      if (next_arrival_ns > arrival_ns) {
+        iree_wait_until(next_arrival_ns);
+      }
+      arrival_ns = next_arrival_ns;
+    }
+    if (arrival_ns >= state.measure_end_ns) break;
+
+    status = InvokeThroughputRequest(state, context, semaphore.get(),
+                                     request_ordinal, outputs.get());
+    iree_time_t completion_ns = iree_time_now();
+    if (arrival_ns < state.measure_start_ns) {
+      // Warmup.
+      iree_status_ignore(status);
+      continue;
+    }
+    if (iree_status_is_ok(status)) {
+      results->latencies_ns.push_back(completion_ns - arrival_ns);
+    } else {
+      if (!results->failure_count++) {
+        results->first_failure = std::move(status);
+      } else {
+        iree_status_ignore(status);
+      }
+    }
+  }
+}
+
+// Returns the |percentile| (0-1) of the sorted |values| using nearest rank.
+static iree_duration_t GetPercentile(
+    const std::vector<iree_duration_t>& sorted_values, double percentile) {
+  if (sorted_values.empty()) return 0;
+  size_t rank = (size_t)std::ceil(percentile * sorted_values.size());
+  return sorted_values[std::min(std::max(rank, (size_t)1),
+                                sorted_values.size()) -
+                       1];
+}
+
+// Throughput mode runner; see --throughput_clients.
+class IREEThroughputBenchmark {
+ public:
+  ~IREEThroughputBenchmark() {
+    IREE_TRACE_SCOPE0("IREEThroughputBenchmark::dtor");
+    inputs_.reset();
+    contexts_.clear();
+    main_module_.reset();
+    instance_.reset();
+    if (device_allocator_ && FLAG_print_statistics) {
+      IREE_IGNORE_ERROR(iree_hal_allocator_statistics_fprint_all(
+          stderr, device_allocator_.get()));
+    }
+    if (FLAG_print_statistics) {
+      IREE_IGNORE_ERROR(iree_hal_profiling_statistics_fprint(stderr));
+    }
+    device_allocator_.reset();
+    device_.reset();
+  }
+
+  iree_status_t Run() {
+    IREE_TRACE_SCOPE0("IREEThroughputBenchmark::Run");
+    IREE_RETURN_IF_ERROR(Init());
+
+    ThroughputState state;
+    state.device = device_.get();
+    state.function = function_;
+    state.inputs = inputs_.get();
+    iree_string_view_t invocation_model = iree_vm_function_lookup_attr_by_name(
+        &function_, IREE_SV("iree.abi.model"));
+    state.is_async =
+        iree_string_view_equal(invocation_model, IREE_SV("coarse-fences"));
+    if (state.is_async && !device_) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "coarse-fences functions require a HAL device");
+    }
+    const int32_t client_count = FLAG_throughput_clients;
+    if (FLAG_throughput_qps > 0.0) {
+      state.mean_interarrival_ns = 1e9 * client_count / FLAG_throughput_qps;
+    }
+    iree_time_t start_ns = iree_time_now();
+    state.measure_start_ns = start_ns + FLAG_throughput_warmup_ms * 1000000ll;
+    state.measure_end_ns =
+        state.measure_start_ns + FLAG_throughput_duration_ms * 1000000ll;
+
+    fprintf(stdout,
+            "Throughput mode: %d clients, %s, warmup %d ms, duration %d ms\n",
+            client_count,
+            FLAG_throughput_qps > 0.0
+                ? (std::to_string(FLAG_throughput_qps) + " QPS open-loop")
+                      .c_str()
+                : "closed-loop",
+            FLAG_throughput_warmup_ms, FLAG_throughput_duration_ms);
+    fflush(stdout);
+
+    std::vector<ThroughputClientResults> results(client_count);
+    std::vector<std::thread> threads;
+    threads.reserve(client_count);
+    for (int32_t i = 0; i < client_count; ++i) {
+      threads.emplace_back(RunThroughputClient, std::cref(state),
+                           contexts_[i].get(), (uint32_t)i, &results[i]);
+    }
+
+    // Sample CPU times at the boundaries of the measurement window.
+    iree_wait_until(state.measure_start_ns);
+    auto cpu_begin = SampleThreadCpuTimes();
+    iree_wait_until(state.measure_end_ns);
+    auto cpu_end = SampleThreadCpuTimes();
+    for (auto& thread : threads) thread.join();
+
+    PrintResults(results, cpu_begin, cpu_end);
+    for (auto& client_results : results) {
+      if (client_results.failure_count) {
+        return iree_status_annotate_f(
+            client_results.first_failure.release(),
+            "%" PRId64 " requests failed", client_results.failure_count);
+      }
+    }
+    return iree_ok_status();
+  }
+
+ private:
+  iree_status_t Init() {
+    IREE_TRACE_SCOPE0("IREEThroughputBenchmark::Init");
+    if (FLAG_entry_function[0] == 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "--entry_function= is required in throughput "
+                              "mode");
+    }
+
+    iree_allocator_t host_allocator = iree_allocator_system();
+    IREE_RETURN_IF_ERROR(
+        iree_tooling_create_instance(host_allocator, &instance_));
+    IREE_RETURN_IF_ERROR(iree_tooling_load_module_from_flags(
+        instance_.get(), host_allocator, &main_module_));
+
+    std::vector<iree_vm_context_t*> contexts(FLAG_throughput_clients);
+    IREE_RETURN_IF_ERROR(iree_tooling_create_contexts_from_flags(
+        instance_.get(), /*user_module_count=*/1,
+        /*user_modules=*/&main_module_,
+        /*default_device_uri=*/iree_string_view_empty(), host_allocator,
+        contexts.size(), contexts.data(), &device_, &device_allocator_));
+    for (auto* context : contexts) {
+      contexts_.push_back(vm::assign_ref(context));
+    }
+
+    IREE_RETURN_IF_ERROR(iree_vm_module_lookup_function_by_name(
+        main_module_.get(), IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view(FLAG_entry_function), &function_));
+    if (!FLAG_function_inputs.empty()) {
+      IREE_RETURN_IF_ERROR(ParseToVariantList(
+          device_allocator_.get(),
+          iree::span<const std::string>{FLAG_function_inputs.data(),
+                                        FLAG_function_inputs.size()},
+          iree_vm_instance_allocator(instance_.get()), &inputs_));
+    }
+    return iree_ok_status();
+  }
+
+  void PrintResults(const std::vector<ThroughputClientResults>& results,
+                    const std::map<int, ThreadCpuTime>& cpu_begin,
+                    const std::map<int, ThreadCpuTime>& cpu_end) {
+    std::vector<iree_duration_t> latencies_ns;
+    int64_t failure_count = 0;
+    for (auto& client_results : results) {
+      latencies_ns.insert(latencies_ns.end(),
+                          client_results.latencies_ns.begin(),
+                          client_results.latencies_ns.end());
+      failure_count += client_results.failure_count;
+    }
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    double duration_s = FLAG_throughput_duration_ms / 1000.0;
+
+    const char* unit_string = kMillisecondsUnitString;
+    double unit_scale = 1e-6;
+    if (FLAG_time_unit.first) {
+      switch (FLAG_time_unit.second) {
+        case benchmark::kMicrosecond:
+          unit_string = kMicrosecondsUnitString;
+          unit_scale = 1e-3;
+          break;
+        case benchmark::kNanosecond:
+          unit_string = kNanosecondsUnitString;
+          unit_scale = 1.0;
+          break;
+        default:
+          break;
+      }
+    }
+    double mean_ns = 0.0;
+    for (auto latency_ns : latencies_ns) mean_ns += latency_ns;
+    if (!latencies_ns.empty()) mean_ns /= latencies_ns.size();
+
+    fprintf(stdout, "  requests:   %zu completed, %" PRId64 " failed\n",
+            latencies_ns.size(), failure_count);
+    fprintf(stdout, "  throughput: %.2f QPS\n",
+            latencies_ns.size() / duration_s);
+    fprintf(stdout,
+            "  latency:    mean %.3f%s p50 %.3f%s p90 %.3f%s p99 %.3f%s "
+            "p999 %.3f%s max %.3f%s\n",
+            mean_ns * unit_scale, unit_string,
+            GetPercentile(latencies_ns, 0.50) * unit_scale, unit_string,
+            GetPercentile(latencies_ns, 0.90) * unit_scale, unit_string,
+            GetPercentile(latencies_ns, 0.99) * unit_scale, unit_string,
+            GetPercentile(latencies_ns, 0.999) * unit_scale, unit_string,
+            GetPercentile(latencies_ns, 1.0) * unit_scale, unit_string);
+
+    // Report the utilization of runtime threads (workers/pollers/etc) that
+    // were alive for the whole measurement window.
+    double ticks_per_s = GetCpuTicksPerSecond();
+    if (ticks_per_s <= 0.0) {
+      fprintf(stdout, "  cpu:        per-thread utilization not available\n");
+      return;
+    }
+    fprintf(stdout, "  cpu utilization:\n");
+    for (auto& it : cpu_end) {
+      auto begin_it = cpu_begin.find(it.first);
+      if (begin_it == cpu_begin.end()) continue;
+      if (!iree_string_view_starts_with(
+              iree_make_string_view(it.second.name.data(),
+                                    it.second.name.size()),
+              IREE_SV("iree-"))) {
+        continue;
+      }
+      double utilization = (it.second.ticks - begin_it->second.ticks) /
+                           ticks_per_s / duration_s;
+      fprintf(stdout, "    %-16s %6.1f%%\n", it.second.name.c_str(),
+              utilization * 100.0);
+    }
+    fflush(stdout);
+  }
+
+  iree::vm::ref<iree_vm_instance_t> instance_;
+  std::vector<iree::vm::ref<iree_vm_context_t>> contexts_;
+  iree::vm::ref<iree_hal_device_t> device_;
+  iree::vm::ref<iree_hal_allocator_t> device_allocator_;
+  iree::vm::ref<iree_vm_module_t> main_module_;
+  iree::vm::ref<iree_vm_list_t> inputs_;
+  iree_vm_function_t function_;
+};
+
 // The lifetime of IREEBenchmark should be as long as
 // ::benchmark::RunSpecifiedBenchmarks() where the resources are used during
 // benchmarking.
@@ -443,9 +866,12 @@ class IREEBenchmark {
 
     // Tear down device last in order to get accurate statistics.
     if (device_allocator_ && FLAG_print_statistics) {
-      IREE_IGNORE_ERROR(iree_hal_allocator_statistics_fprint(
+      IREE_IGNORE_ERROR(iree_hal_allocator_statistics_fprint_all(
           stderr, device_allocator_.get()));
     }
+    if (FLAG_print_statistics) {
+      IREE_IGNORE_ERROR(iree_hal_profiling_statistics_fprint(stderr));
+    }
     device_allocator_.reset();
     device_.reset();
   };
@@ -607,6 +1033,17 @@ int main(int argc, char** argv) {
                            &argc, &argv);
   ::benchmark::Initialize(&argc, argv);
 
+  if (FLAG_throughput_clients > 0) {
+    iree::IREEThroughputBenchmark throughput_benchmark;
+    iree_status_t status = throughput_benchmark.Run();
+    if (!iree_status_is_ok(status)) {
+      int ret = static_cast<int>(iree_status_code(status));
+      printf("%s\n", iree::Status(std::move(status)).ToString().c_str());
+      return ret;
+    }
+    return 0;
+  }
+
   iree::IREEBenchmark iree_benchmark;
   iree_status_t status = iree_benchmark.Register();
   if (!iree_status_is_ok(status)) {
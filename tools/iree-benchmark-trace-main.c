@@ -16,10 +16,13 @@
 #include "iree/base/internal/path.h"
 #include "iree/hal/api.h"
 #include "iree/testing/benchmark.h"
+#include "iree/modules/hal/module.h"
 #include "iree/tooling/device_util.h"
+#include "iree/tooling/trace_capture.h"
 #include "iree/tooling/trace_replay.h"
 #include "iree/tooling/yaml_util.h"
 #include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
 
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
@@ -45,6 +48,10 @@ typedef struct iree_replay_benchmark_call_t {
   iree_vm_function_t function;
   iree_vm_list_t* input_list;
   iree_vm_list_t* output_list;
+  // Set for coarse-fences calls from binary traces: a new signal fence on this
+  // semaphore is passed as the last input of each invocation and waited on.
+  iree_hal_semaphore_t* signal_semaphore;
+  uint64_t signal_value;
 } iree_replay_benchmark_call_t;
 
 // A growable list of calls.
@@ -70,6 +77,7 @@ static void iree_replay_benchmark_call_list_deinitialize(
   for (size_t i = 0; i < list->count; ++i) {
     iree_vm_list_release(list->items[i].input_list);
     iree_vm_list_release(list->items[i].output_list);
+    iree_hal_semaphore_release(list->items[i].signal_semaphore);
   }
   free(list->items);
   memset(list, 0, sizeof(*list));
@@ -188,6 +196,138 @@ static iree_status_t iree_replay_benchmark_load_trace(
   return status;
 }
 
+// Processes a call event from a binary trace by resolving the function,
+// decoding the inputs, and appending it to the provided |call_list|.
+static iree_status_t iree_replay_benchmark_prepare_captured_call(
+    iree_trace_replay_t* replay, iree_trace_capture_reader_t* reader,
+    const iree_trace_capture_event_t* event,
+    iree_replay_benchmark_call_list_t* call_list) {
+  iree_replay_benchmark_call_t* call =
+      iree_replay_benchmark_call_list_acquire_back(call_list);
+  memset(call, 0, sizeof(*call));
+
+  IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+      replay->context, event->function_name, &call->function));
+  IREE_RETURN_IF_ERROR(iree_trace_capture_reader_make_list(
+      reader, event->inputs, iree_hal_device_allocator(replay->device),
+      replay->host_allocator, &call->input_list));
+  IREE_RETURN_IF_ERROR(
+      iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/8,
+                          replay->host_allocator, &call->output_list));
+
+  // Coarse-fences functions take (wait, signal) fences as their last inputs.
+  // Captured fences decode as null and we wait on nothing; the signal fence
+  // is recreated for each invocation.
+  iree_string_view_t invocation_model = iree_vm_function_lookup_attr_by_name(
+      &call->function, IREE_SV("iree.abi.model"));
+  if (iree_string_view_equal(invocation_model, IREE_SV("coarse-fences"))) {
+    if (iree_vm_list_size(call->input_list) < 2) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "coarse-fences call '%.*s' is missing fences",
+                              (int)event->function_name.size,
+                              event->function_name.data);
+    }
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_create(
+        replay->device, 0ull, &call->signal_semaphore));
+  }
+  return iree_ok_status();
+}
+
+// Loads the binary trace at |file_path| captured with
+// iree/tooling/trace_capture.h and configures |replay| for making calls in the
+// |call_list|. Buffers in the call inputs reference the file mapping owned by
+// |out_reader| which must outlive the calls.
+static iree_status_t iree_replay_benchmark_load_capture(
+    iree_string_view_t file_path, iree_trace_replay_t* replay,
+    iree_replay_benchmark_call_list_t* call_list,
+    iree_trace_capture_reader_t** out_reader) {
+  IREE_RETURN_IF_ERROR(iree_trace_capture_reader_open(
+      file_path.data, replay->host_allocator, out_reader));
+  iree_trace_capture_reader_t* reader = *out_reader;
+
+  // Binary traces are captured from sessions that always have a HAL module
+  // first and the device must be specified as it is not recorded.
+  if (replay->device_uri_count != 1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "exactly one --device= must be specified when "
+                            "replaying binary traces");
+  }
+  IREE_RETURN_IF_ERROR(iree_vm_context_create(
+      replay->instance, replay->context_flags, replay->host_allocator,
+      &replay->context));
+  IREE_RETURN_IF_ERROR(iree_hal_create_device(
+      replay->driver_registry, replay->device_uris[0], replay->host_allocator,
+      &replay->device));
+  iree_vm_module_t* hal_module = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_module_create(
+      replay->instance, replay->device, IREE_HAL_MODULE_FLAG_NONE,
+      replay->host_allocator, &hal_module));
+  iree_status_t status = iree_vm_context_register_modules(
+      replay->context, /*module_count=*/1, /*modules=*/&hal_module);
+  iree_vm_module_release(hal_module);
+  IREE_RETURN_IF_ERROR(status);
+
+  // Read each event in the file until EOF.
+  while (iree_status_is_ok(status)) {
+    iree_trace_capture_event_t event;
+    bool has_event = false;
+    status = iree_trace_capture_reader_next(reader, &event, &has_event);
+    if (!iree_status_is_ok(status) || !has_event) break;
+    switch (event.type) {
+      case IREE_TRACE_CAPTURE_EVENT_MODULE: {
+        // The module flatbuffer is used directly from the file mapping.
+        iree_vm_module_t* module = NULL;
+        status = iree_vm_bytecode_module_create(
+            replay->instance, event.module_data, iree_allocator_null(),
+            replay->host_allocator, &module);
+        if (iree_status_is_ok(status)) {
+          status = iree_vm_context_register_modules(
+              replay->context, /*module_count=*/1, /*modules=*/&module);
+        }
+        iree_vm_module_release(module);
+        break;
+      }
+      case IREE_TRACE_CAPTURE_EVENT_CALL:
+        status = iree_replay_benchmark_prepare_captured_call(replay, reader,
+                                                             &event, call_list);
+        break;
+    }
+  }
+  return status;
+}
+
+// Invokes |call| once and waits for it to complete.
+static iree_status_t iree_replay_benchmark_invoke_call(
+    iree_trace_replay_t* replay, iree_replay_benchmark_call_t* call) {
+  iree_hal_fence_t* signal_fence = NULL;
+  if (call->signal_semaphore) {
+    IREE_RETURN_IF_ERROR(iree_hal_fence_create_at(
+        call->signal_semaphore, ++call->signal_value, replay->host_allocator,
+        &signal_fence));
+    iree_vm_ref_t signal_fence_ref = iree_hal_fence_retain_ref(signal_fence);
+    iree_status_t status = iree_vm_list_set_ref_move(
+        call->input_list, iree_vm_list_size(call->input_list) - 1,
+        &signal_fence_ref);
+    if (!iree_status_is_ok(status)) {
+      iree_vm_ref_release(&signal_fence_ref);
+      iree_hal_fence_release(signal_fence);
+      return status;
+    }
+  }
+  iree_status_t status = iree_vm_invoke(
+      replay->context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
+      /*policy=*/NULL, call->input_list, call->output_list,
+      replay->host_allocator);
+  if (iree_status_is_ok(status) && signal_fence) {
+    status = iree_hal_fence_wait(signal_fence, iree_infinite_timeout());
+  }
+  iree_hal_fence_release(signal_fence);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_resize(call->output_list, 0);
+  }
+  return status;
+}
+
 // Benchmark function that runs a trace file.
 static iree_status_t iree_replay_benchmark_run_file(
     const iree_benchmark_def_t* benchmark_def,
@@ -211,33 +351,42 @@ static iree_status_t iree_replay_benchmark_run_file(
   iree_trace_replay_set_hal_devices_override(&replay, device_uri_count,
                                              device_uris);
 
-  // Load YAML file and setup replay state with all modules loaded and ready.
+  // Load the YAML or binary trace file and setup replay state with all modules
+  // loaded and ready.
   iree_replay_benchmark_call_list_t call_list;
   iree_replay_benchmark_call_list_initialize(&call_list);
-  IREE_RETURN_IF_ERROR(iree_replay_benchmark_load_trace(registration->file_path,
-                                                        &replay, &call_list));
+  iree_trace_capture_reader_t* capture_reader = NULL;
+  iree_status_t status = iree_ok_status();
+  if (iree_trace_capture_file_is_binary(registration->file_path.data)) {
+    status = iree_replay_benchmark_load_capture(
+        registration->file_path, &replay, &call_list, &capture_reader);
+  } else {
+    status = iree_replay_benchmark_load_trace(registration->file_path, &replay,
+                                              &call_list);
+  }
 
   // Call the functions within the trace in order.
-  while (iree_benchmark_keep_running(benchmark_state,
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state,
                                      /*batch_count=*/FLAG_call_iterations)) {
-    for (size_t i = 0; i < call_list.count; ++i) {
+    for (size_t i = 0; i < call_list.count && iree_status_is_ok(status); ++i) {
       iree_replay_benchmark_call_t* call = &call_list.items[i];
-      for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
-        IREE_RETURN_IF_ERROR(iree_vm_invoke(
-            replay.context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
-            /*policy=*/NULL, call->input_list, call->output_list,
-            replay.host_allocator));
-        IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
+      for (int32_t j = 0; j < FLAG_call_iterations && iree_status_is_ok(status);
+           ++j) {
+        status = iree_replay_benchmark_invoke_call(&replay, call);
       }
     }
   }
 
+  // Modules and call inputs loaded from a binary trace alias the file mapping
+  // owned by the reader so it must outlive the replay state.
   iree_replay_benchmark_call_list_deinitialize(&call_list);
   iree_trace_replay_deinitialize(
-      &replay, FLAG_print_statistics
+      &replay, FLAG_print_statistics && iree_status_is_ok(status)
                    ? IREE_TRACE_REPLAY_SHUTDOWN_PRINT_STATISTICS
                    : IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
-  return iree_ok_status();
+  iree_trace_capture_reader_free(capture_reader);
+  return status;
 }
 
 // Registers benchmarks for each trace file.
@@ -275,7 +424,8 @@ int main(int argc, char** argv) {
   iree_benchmark_initialize(&argc, argv);
   if (argc <= 1) {
     fprintf(stderr,
-            "no trace files provided; pass one or more yaml file paths");
+            "no trace files provided; pass one or more yaml or binary trace "
+            "file paths");
     return 1;
   }
 
@@ -70,6 +70,8 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=@some/file.bin\n"
     "numpy npy files (from numpy.save) can be read to provide 1+ values:\n"
     "  @some.npy\n"
+    "numpy npz files (from numpy.savez) can be read to provide 1+ values:\n"
+    "  @some.npz\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
@@ -184,8 +186,11 @@ iree_status_t Run(int* out_exit_code) {
   context.reset();
 
   if (device_allocator && FLAG_print_statistics) {
-    IREE_IGNORE_ERROR(
-        iree_hal_allocator_statistics_fprint(stderr, device_allocator.get()));
+    IREE_IGNORE_ERROR(iree_hal_allocator_statistics_fprint_all(
+        stderr, device_allocator.get()));
+  }
+  if (FLAG_print_statistics) {
+    IREE_IGNORE_ERROR(iree_hal_profiling_statistics_fprint(stderr));
   }
 
   device_allocator.reset();
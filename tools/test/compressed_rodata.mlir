@@ -0,0 +1,14 @@
+// RUN: (iree-compile --iree-hal-target-backends=vmvx --iree-vm-bytecode-rodata-compression=lz4 --iree-vm-bytecode-rodata-compression-block-size=256 %s | iree-run-module --device=local-task --entry_function=abs --function_input=f32=-2 --print_module_load_statistics 2>&1) | FileCheck %s
+// RUN: (iree-compile --iree-hal-target-backends=llvm-cpu --iree-vm-bytecode-rodata-compression=lz4 %s | iree-run-module --device=local-task --entry_function=abs --function_input=f32=-2 --print_module_load_statistics 2>&1) | FileCheck %s
+// RUN: (iree-compile --iree-hal-target-backends=vmvx --iree-vm-bytecode-rodata-compression=lz4 %s | iree-run-module --device=local-task --entry_function=abs --function_input=f32=-2 --print_module_load_statistics --parallel_module_decompression=false 2>&1) | FileCheck %s --check-prefix=LAZY
+
+// CHECK: [module] decompressed {{[0-9]+}} rodata segments
+// LAZY: [module] {{[0-9]+}} compressed rodata segments {{.+}} will be decompressed on first use
+// CHECK-LABEL: EXEC @abs
+// LAZY-LABEL: EXEC @abs
+func.func @abs(%input : tensor<f32>) -> (tensor<f32>) {
+  %result = math.absf %input : tensor<f32>
+  return %result : tensor<f32>
+}
+// CHECK: f32=2
+// LAZY: f32=2